@@ -0,0 +1,47 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_BORDER_ALIGN_CPU_H_
+#define CSRC_BORDER_ALIGN_CPU_H_
+
+#include <ATen/ATen.h>
+
+#include <tuple>
+
+/**
+ * @brief border_align前向的CPU实现，输出全部采样点，按框并行
+ * @param input: (B, 4C, H, W)，通道依次为上、左、下、右四条边的特征
+ * @param rois: (B, H * W, 4)，(x1, y1, x2, y2)
+ * @param output: (B, H * W, pooled_size + 1, 4C)，原地写入
+ */
+void border_align_forward_cpu(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output,
+    int64_t pooled_size);
+
+/**
+ * @brief border_align前向的CPU实现，采样点的max与argmax在采样时直接求出，不生成逐采样点的中间结果
+ * @return output: (B, C, H * W, 4)，与input同精度；argmax_idx: 同形状，int32
+ */
+std::tuple<at::Tensor, at::Tensor> border_align_max_cpu(const at::Tensor& input, const at::Tensor& rois,
+    int64_t pooled_size);
+
+/**
+ * @brief border_align反向的CPU实现，按(batch, 通道)平面并行，float累加
+ * @param grad_out, argmax_idx: (B, C, H * W, 4)
+ * @return grad_input: (B, 4C, H, W)，与grad_out同精度
+ */
+at::Tensor border_align_backward_cpu(const at::Tensor& grad_out, const at::Tensor& rois,
+    const at::Tensor& argmax_idx, int64_t pooled_size, int64_t height, int64_t width);
+
+#endif // CSRC_BORDER_ALIGN_CPU_H_
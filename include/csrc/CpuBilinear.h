@@ -0,0 +1,68 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_CPU_BILINEAR_H_
+#define CSRC_CPU_BILINEAR_H_
+
+#include <algorithm>
+#include <cstdint>
+
+// roi_align_rotated与border_align的CPU实现共用的双线性插值
+namespace cpu_bilinear {
+constexpr int TAPS = 4;
+
+// 双线性插值的4个像素下标(h * W + w)与权重
+struct BilinearTap {
+    int64_t offset[TAPS];
+    float weight[TAPS];
+};
+
+// 与mmcv一致：超出[-1, H] x [-1, W]的点取0，负坐标截到0
+inline bool Bilinear(float y, float x, int64_t height, int64_t width, BilinearTap& tap)
+{
+    if (y < -1.0f || y > static_cast<float>(height) || x < -1.0f || x > static_cast<float>(width)) {
+        return false;
+    }
+    y = std::max(y, 0.0f);
+    x = std::max(x, 0.0f);
+    int64_t y_low = static_cast<int64_t>(y);
+    int64_t x_low = static_cast<int64_t>(x);
+    int64_t y_high = y_low + 1;
+    int64_t x_high = x_low + 1;
+    if (y_low >= height - 1) {
+        y_high = y_low = height - 1;
+        y = static_cast<float>(y_low);
+    }
+    if (x_low >= width - 1) {
+        x_high = x_low = width - 1;
+        x = static_cast<float>(x_low);
+    }
+    float ly = y - static_cast<float>(y_low);
+    float lx = x - static_cast<float>(x_low);
+    float hy = 1.0f - ly;
+    float hx = 1.0f - lx;
+    tap.offset[0] = y_low * width + x_low;
+    tap.offset[1] = y_low * width + x_high;
+    tap.offset[2] = y_high * width + x_low;
+    tap.offset[3] = y_high * width + x_high;
+    tap.weight[0] = hy * hx;
+    tap.weight[1] = hy * lx;
+    tap.weight[2] = ly * hx;
+    tap.weight[3] = ly * lx;
+    return true;
+}
+} // namespace cpu_bilinear
+
+#endif // CSRC_CPU_BILINEAR_H_
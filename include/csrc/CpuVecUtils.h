@@ -0,0 +1,69 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_CPU_VEC_UTILS_H_
+#define CSRC_CPU_VEC_UTILS_H_
+
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+
+// CPU算子共用的按通道向量化行操作
+namespace cpu_vec {
+using Vec = at::vec::Vectorized<float>;
+
+// out[0:c] += alpha * in[0:c]
+inline void Axpy(float* out, const float* in, float alpha, int64_t c)
+{
+    Vec alpha_vec(alpha);
+    int64_t i = 0;
+    for (; i + Vec::size() <= c; i += Vec::size()) {
+        Vec res = Vec::loadu(out + i) + Vec::loadu(in + i) * alpha_vec;
+        res.store(out + i);
+    }
+    for (; i < c; ++i) {
+        out[i] += alpha * in[i];
+    }
+}
+
+// out[0:c] += in[0:c]
+inline void AddRow(float* out, const float* in, int64_t c)
+{
+    int64_t i = 0;
+    for (; i + Vec::size() <= c; i += Vec::size()) {
+        Vec res = Vec::loadu(out + i) + Vec::loadu(in + i);
+        res.store(out + i);
+    }
+    for (; i < c; ++i) {
+        out[i] += in[i];
+    }
+}
+
+// sum(a[0:c] * b[0:c])
+inline float Dot(const float* a, const float* b, int64_t c)
+{
+    Vec acc(0.f);
+    int64_t i = 0;
+    for (; i + Vec::size() <= c; i += Vec::size()) {
+        acc = acc + Vec::loadu(a + i) * Vec::loadu(b + i);
+    }
+    float res = at::vec::vec_reduce_all<float>([](Vec& x, Vec& y) { return x + y; }, acc);
+    for (; i < c; ++i) {
+        res += a[i] * b[i];
+    }
+    return res;
+}
+} // namespace cpu_vec
+
+#endif // CSRC_CPU_VEC_UTILS_H_
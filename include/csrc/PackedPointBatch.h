@@ -0,0 +1,56 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_PACKED_POINT_BATCH_H_
+#define CSRC_PACKED_POINT_BATCH_H_
+
+#include <ATen/ATen.h>
+
+/**
+ * @brief 按batch拼接的变长点云，样本b占据points[ptr[b], ptr[b + 1])
+ *
+ * 在padded [B, N, C]、ptr偏移[B + 1]和逐点batch下标[total]三种布局之间转换。所有样本点数相同时
+ * (uniform_count >= 0)与padded布局互为零拷贝view；已知total/max_count时转换过程不需要device到host同步。
+ */
+struct PackedPointBatch {
+    at::Tensor points;          // [total, C]
+    at::Tensor ptr;             // [B + 1]，int64，与points位于同一device
+    int64_t max_count = -1;     // 样本点数的上界，未知时为-1
+    int64_t uniform_count = -1; // 所有样本点数相同时为该点数，否则为-1
+
+    static PackedPointBatch FromPadded(
+        const at::Tensor& padded, const c10::optional<at::Tensor>& counts, int64_t total = -1);
+    static PackedPointBatch FromPtr(const at::Tensor& points, const at::Tensor& ptr, int64_t max_count = -1);
+    // batch_idx需按非降序排列，即同一样本的点在points中连续
+    static PackedPointBatch FromBatchIndex(
+        const at::Tensor& points, const at::Tensor& batch_idx, int64_t batch_size, int64_t max_count = -1);
+
+    int64_t BatchSize() const
+    {
+        return ptr.size(0) - 1;
+    }
+    int64_t Total() const
+    {
+        return points.size(0);
+    }
+    // 未知时从ptr求出，会触发一次同步
+    int64_t MaxCount() const;
+    at::Tensor Counts() const;
+    at::Tensor BatchIndex() const;
+    at::Tensor LocalIndex() const;
+    at::Tensor ToPadded(double pad_value = 0) const;
+};
+
+#endif // CSRC_PACKED_POINT_BATCH_H_
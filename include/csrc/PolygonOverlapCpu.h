@@ -0,0 +1,66 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_POLYGON_OVERLAP_CPU_H_
+#define CSRC_POLYGON_OVERLAP_CPU_H_
+
+#include <ATen/ATen.h>
+
+constexpr int64_t POLYGON_MODE_OVERLAP = 0; // 相交面积
+constexpr int64_t POLYGON_MODE_IOU = 1;     // 相交面积 / (面积a + 面积b - 相交面积)
+constexpr int64_t POLYGON_MODE_IOF = 2;     // 相交面积 / 面积a
+
+/**
+ * @brief 输入框到凸四边形的解析方式
+ *
+ * 矩形框由(x, y, w, h)或(x1, y1, x2, y2)与旋转角给出；四边形框为(x1, y1, ..., x4, y4)，顺/逆时针均可。
+ */
+struct PolygonBoxFormat {
+    bool quadri = false;        // 为true时按四边形框解析，其余字段不生效
+    bool corner_format = false; // 矩形框为(x1, y1, x2, y2)而非(x, y, w, h)
+    int64_t size_offset = 2;    // w、h或x2、y2所在列
+    int64_t angle_index = 4;
+    double angle_scale = 1.0; // 旋转角乘以该系数得到逆时针弧度
+
+    // boxes_overlap_bev的format_flag/unit_flag/clockwise
+    static PolygonBoxFormat Bev(int64_t format_flag, int64_t unit_flag, bool clockwise);
+    // (x, y, w, h, angle)或trans为true时的(x1, y1, x2, y2, angle)，逆时针旋转
+    static PolygonBoxFormat Rotated(bool trans, bool degree);
+    static PolygonBoxFormat Quadri();
+};
+
+struct PolygonOverlapOptions {
+    int64_t mode = POLYGON_MODE_OVERLAP;
+    double union_eps = 0.0; // iou分母的下限
+    double min_area = 0.0;  // 任一框面积小于该值时结果为0
+};
+
+/**
+ * @brief 两组框的多边形相交面积/iou/iof
+ *
+ * 每个框只解析一次角点，之后按SoA布局把一组框对平移到各自中点后装入SIMD lane，用定长的半平面裁剪
+ * 逐边求相交多边形的边界积分，不依赖逐对分支。
+ * @param boxes_a: 2D float tensor(N, D)
+ * @param boxes_b: 2D float tensor(M, D)
+ * @param aligned: 为false时输出(N, M)，为true时要求N == M并输出(N)
+ */
+at::Tensor polygon_overlap_cpu(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const PolygonBoxFormat& format,
+    const PolygonOverlapOptions& options, bool aligned);
+
+// 只计算(a_idx[k], b_idx[k])这些框对，输出(K)
+at::Tensor polygon_overlap_pairs_cpu(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const at::Tensor& a_idx,
+    const at::Tensor& b_idx, const PolygonBoxFormat& format, const PolygonOverlapOptions& options);
+
+#endif // CSRC_POLYGON_OVERLAP_CPU_H_
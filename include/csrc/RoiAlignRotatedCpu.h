@@ -0,0 +1,58 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CSRC_ROI_ALIGN_ROTATED_CPU_H_
+#define CSRC_ROI_ALIGN_ROTATED_CPU_H_
+
+#include <ATen/ATen.h>
+
+struct RoiAlignRotatedParams {
+    double spatial_scale = 1.0;
+    int64_t sampling_ratio = 0;
+    int64_t pooled_height = 1;
+    int64_t pooled_width = 1;
+    bool aligned = true;
+    bool clockwise = false;
+};
+
+/**
+ * @brief sampling_ratio为0时按每个roi的采样点数重排roi
+ *
+ * 开销按降序排好后，剩余最重与最轻的roi交替取出，使任意一段连续roi的开销都接近
+ * 段长乘以平均开销，与分核/分线程的块数无关。全部在rois所在设备上计算，不与host同步。
+ * @param rois: 2D tensor(n, 6)，(batch_idx, cx, cy, w, h, angle)
+ * @return 重排后的roi下标，int64，与rois同设备；指定了sampling_ratio或roi过少时返回未定义的tensor
+ */
+at::Tensor roi_align_rotated_balanced_order(const at::Tensor& rois, const RoiAlignRotatedParams& params,
+    int64_t min_rois);
+
+/**
+ * @brief RoiAlignRotatedV2前向的CPU实现，按roi并行
+ * @param input: 4D tensor(B, C, H, W)
+ * @param rois: 2D tensor(n, 6)
+ * @param output: 4D tensor(n, pooled_height, pooled_width, C)，原地写入
+ */
+void roi_align_rotated_forward_cpu(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output,
+    const RoiAlignRotatedParams& params);
+
+/**
+ * @brief RoiAlignRotatedV2反向的CPU实现，按通道分段并行，float累加
+ * @param grad_output: 4D tensor(n, pooled_height, pooled_width, C)
+ * @return grad_input: 4D tensor(B, H, W, C)，与input同精度
+ */
+at::Tensor roi_align_rotated_backward_cpu(const at::Tensor& input, const at::Tensor& rois,
+    const at::Tensor& grad_output, const RoiAlignRotatedParams& params);
+
+#endif // CSRC_ROI_ALIGN_ROTATED_CPU_H_
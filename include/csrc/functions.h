@@ -16,8 +16,8 @@
 
 #include <ATen/ATen.h>
 
-std::tuple<at::Tensor, at::Tensor> knn(
-    const at::Tensor& xyz, const at::Tensor& center_xyz, int32_t k, bool is_from_knn);
+std::tuple<at::Tensor, at::Tensor> knn(const at::Tensor& xyz, const at::Tensor& center_xyz, int32_t k,
+    bool is_from_knn, bool with_sqrt, bool use_grid);
 
 at::Tensor npu_three_interpolate(
     int b, int c, int m, int n, const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight);
@@ -25,6 +25,11 @@ at::Tensor npu_three_interpolate(
 at::Tensor npu_three_interpolate_backward(
     int b, int c, int n, int m, const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight);
 
+at::Tensor npu_three_interpolate_with_dist(const at::Tensor& points, const at::Tensor& idx, const at::Tensor& dist);
+
+at::Tensor npu_three_interpolate_with_dist_backward(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& dist, int64_t m);
+
 std::tuple<at::Tensor, at::Tensor> scatter_max_with_argmax_v2(
     const at::Tensor& updates, const at::Tensor& indices, c10::optional<at::Tensor> out);
 
@@ -45,12 +50,13 @@ std::tuple<at::Tensor, at::Tensor> npu_hypot_grad(
     const at::Tensor& x, const at::Tensor& y, const at::Tensor& out, const at::Tensor& out_grad);
 
 void assign_score_withk(const at::Tensor& points, const at::Tensor& centers, const at::Tensor& scores,
-    const at::Tensor& knn_idx, at::Tensor& output, int32_t B, int32_t N, int32_t npoint, int32_t M, int32_t K,
-    int32_t out_dim, int32_t aggregate);
+    const at::Tensor& knn_idx, at::Tensor& output, at::Tensor& argmax, int32_t B, int32_t N, int32_t npoint, int32_t M,
+    int32_t K, int32_t out_dim, int32_t aggregate);
 
 void assign_score_withk_grad(const at::Tensor& grad_out, const at::Tensor& points, const at::Tensor& centers, const at::Tensor& scores,
-    const at::Tensor& knn_idx, at::Tensor& grad_points, at::Tensor& grad_centers, at::Tensor& grad_scores,
-    int32_t B, int32_t N, int32_t npoint, int32_t M, int32_t K, int32_t out_dim, int32_t aggregate);
+    const at::Tensor& knn_idx, const at::Tensor& argmax, at::Tensor& grad_points, at::Tensor& grad_centers,
+    at::Tensor& grad_scores, int32_t B, int32_t N, int32_t npoint, int32_t M, int32_t K, int32_t out_dim,
+    int32_t aggregate);
 
 at::Tensor npu_max_pool2d(const at::Tensor& x, int kernel_size, int stride, int padding);
 
@@ -75,11 +81,16 @@ std::tuple<at::Tensor, at::Tensor> npu_scatter_mean(at::Tensor& src, at::Tensor&
 at::Tensor fused_bias_leaky_relu(const at::Tensor& x, const at::Tensor& bias, double negative_slop, double scale);
 
 at::Tensor deformable_aggregation(const at::Tensor& mc_ms_feat, const at::Tensor& spatial_shape,
-    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights);
+    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights,
+    bool use_softmax);
 std::tuple<at::Tensor, at::Tensor, at::Tensor> deformable_aggregation_backward(const at::Tensor& mc_ms_feat,
     const at::Tensor& spatial_shape, const at::Tensor& scale_start_index, const at::Tensor& sampling_location,
-    const at::Tensor& weights, const at::Tensor& grad_output, const at::Tensor& grad_mc_ms_feat,
-    const at::Tensor& grad_sampling_location, const at::Tensor& grad_weights);
+    const at::Tensor& weights, const at::Tensor& grad_output, const c10::optional<at::Tensor>& grad_mc_ms_feat,
+    const c10::optional<at::Tensor>& grad_sampling_location, const c10::optional<at::Tensor>& grad_weights,
+    bool use_softmax);
+at::Tensor deformable_aggregation_temporal(const at::Tensor& feat_cache, const at::Tensor& spatial_shape,
+    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights,
+    const at::Tensor& slot_index, bool use_softmax);
 
 std::tuple<at::Tensor, at::Tensor> deformable_conv2d(const at::Tensor& input, const at::Tensor& offset,
     const at::Tensor& weight, at::IntArrayRef kernel_size, at::IntArrayRef stride, at::IntArrayRef padding,
@@ -107,6 +118,24 @@ at::Tensor group_points(
 at::Tensor group_points_backward(const at::Tensor& grad_out, const at::Tensor& idx, int64_t b, int64_t c, int64_t n,
     int64_t npoints, int64_t nsample);
 
+std::tuple<at::Tensor, at::Tensor> packed_from_padded(
+    const at::Tensor& padded, const c10::optional<at::Tensor>& counts, int64_t total);
+
+at::Tensor packed_to_padded(const at::Tensor& points, const at::Tensor& ptr, int64_t max_count, double pad_value);
+
+at::Tensor packed_ptr_from_batch_index(const at::Tensor& batch_idx, int64_t batch_size);
+
+std::tuple<at::Tensor, at::Tensor> packed_batch_index(const at::Tensor& ptr, int64_t total);
+
+std::tuple<at::Tensor, at::Tensor> ball_query(const at::Tensor& xyz, const at::Tensor& center_xyz,
+    const c10::optional<at::Tensor>& features, double min_radius, double max_radius, int64_t sample_num);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> vec_pool(const at::Tensor& support_xyz,
+    const at::Tensor& xyz_batch_cnt, const at::Tensor& support_features, const at::Tensor& new_xyz,
+    const at::Tensor& new_xyz_batch_cnt, int64_t num_grid_x, int64_t num_grid_y, int64_t num_grid_z,
+    double max_neighbour_distance, int64_t num_c_out, bool use_xyz, int64_t nsample, int64_t neighbor_type,
+    int64_t pooling_type);
+
 at::Tensor vec_pool_backward(const at::Tensor& grad_new_features, const at::Tensor& point_cnt_of_grid,
     const at::Tensor& grouped_idxs, const int64_t n, const int64_t num_c_in);
 
@@ -144,7 +173,9 @@ void npu_dynamic_scatter_grad(at::Tensor& grad_point_feats, const at::Tensor& gr
     const at::Tensor& prefix_sum_point_per_voxel, const at::Tensor& argsort_coor, const at::Tensor& compare_mask,
     const char* reduce_type);
 
-at::Tensor npu_furthest_point_sampling(const at::Tensor& point_xyz, const at::Tensor& nearset_temp, int32_t num_points);
+at::Tensor npu_furthest_point_sampling(
+    const at::Tensor& point_xyz, const c10::optional<at::Tensor>& point_counts, int32_t num_points);
+at::Tensor npu_furthest_point_sampling_packed(const at::Tensor& points, const at::Tensor& ptr, int32_t num_points);
 
 std::tuple<at::Tensor&, at::Tensor&> voxel_pooling_train(const at::Tensor& inputFeatures, const at::Tensor& geom,
     at::Tensor& outputFeatures, at::Tensor& posMemo, int batchSize, int numPoints, int numChannels, int numVoxelX,
@@ -158,10 +189,55 @@ at::Tensor dynamic_voxelization(const at::Tensor& points, at::Tensor& coors, int
 
 at::Tensor npu_bev_pool_v3(const c10::optional<at::Tensor>& depth, const at::Tensor& feat,
     const c10::optional<at::Tensor>& ranks_depth, const c10::optional<at::Tensor>& ranks_feat,
-    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w);
+    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w, bool depth_softmax);
 std::tuple<c10::optional<at::Tensor>, at::Tensor> npu_bev_pool_v3_backward(const at::Tensor& grad_out,
     const c10::optional<at::Tensor>& depth, const at::Tensor& feat, const c10::optional<at::Tensor>& ranks_depth,
-    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev);
+    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev, bool depth_softmax);
+int64_t npu_bev_pool_precompute_key(const std::vector<at::Tensor>& calib, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size);
+std::vector<at::Tensor> npu_bev_pool_precompute(const c10::optional<at::Tensor>& coor,
+    c10::optional<int64_t> cache_key, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size);
+void npu_bev_pool_precompute_clear_cache();
+
+// CPU implementations of bev_pool and voxel_pooling_train, dispatched from the entries above for CPU tensors
+at::Tensor bev_pool_cpu(const at::Tensor& feat, const at::Tensor& geom_feat, const at::Tensor& interval_lengths,
+    const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w);
+at::Tensor bev_pool_backward_cpu(const at::Tensor& grad_out, const at::Tensor& geom_feat,
+    const at::Tensor& interval_lengths, const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w);
+at::Tensor bev_pool_v2_cpu(const at::Tensor& depth, const at::Tensor& feat, const at::Tensor& ranks_depth,
+    const at::Tensor& ranks_feat, const at::Tensor& ranks_bev, const at::Tensor& interval_lengths,
+    const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w);
+std::tuple<at::Tensor, at::Tensor> bev_pool_v2_backward_cpu(const at::Tensor& grad_out, const at::Tensor& depth,
+    const at::Tensor& feat, const at::Tensor& ranks_depth, const at::Tensor& ranks_feat, const at::Tensor& ranks_bev,
+    const at::Tensor& interval_lengths, const at::Tensor& interval_starts);
+at::Tensor bev_pool_v3_cpu(const c10::optional<at::Tensor>& depth, const at::Tensor& feat,
+    const c10::optional<at::Tensor>& ranks_depth, const c10::optional<at::Tensor>& ranks_feat,
+    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w, bool depth_softmax);
+std::tuple<c10::optional<at::Tensor>, at::Tensor> bev_pool_v3_backward_cpu(const at::Tensor& grad_out,
+    const c10::optional<at::Tensor>& depth, const at::Tensor& feat, const c10::optional<at::Tensor>& ranks_depth,
+    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev, bool depth_softmax);
+std::tuple<at::Tensor&, at::Tensor&> voxel_pooling_train_cpu(const at::Tensor& inputFeatures, const at::Tensor& geom,
+    at::Tensor& outputFeatures, at::Tensor& posMemo, int batchSize, int numPoints, int numChannels, int numVoxelX,
+    int numVoxelY, int numVoxelZ);
+at::Tensor voxel_pool_train_backward_cpu(const at::Tensor& gradOut, const at::Tensor& posMemo,
+    const int64_t batchSize, const int64_t numPoints, const int64_t numChannels, const int64_t h, const int64_t w);
+
+// CPU implementations of the PointNet++ family, dispatched from the entries above for CPU tensors
+at::Tensor group_points_cpu(const at::Tensor& points, const at::Tensor& idx);
+at::Tensor group_points_backward_cpu(const at::Tensor& grad_out, const at::Tensor& idx, int64_t n);
+at::Tensor three_interpolate_cpu(
+    const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight, bool weight_is_dist);
+at::Tensor three_interpolate_backward_cpu(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight, int64_t m, bool weight_is_dist);
+at::Tensor furthest_point_sampling_with_dist_cpu(
+    const at::Tensor& points_dist, const at::Tensor& nearest_temp, int32_t num_points);
+void assign_score_withk_cpu(const at::Tensor& points, const at::Tensor& centers, const at::Tensor& scores,
+    const at::Tensor& knn_idx, int32_t aggregate, at::Tensor& output, at::Tensor& argmax);
+void assign_score_withk_grad_cpu(const at::Tensor& grad_out, const at::Tensor& points, const at::Tensor& centers,
+    const at::Tensor& scores, const at::Tensor& knn_idx, const at::Tensor& argmax, int32_t aggregate,
+    at::Tensor& grad_points, at::Tensor& grad_centers, at::Tensor& grad_scores);
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor> npu_subm_sparse_conv3d(const at::Tensor& feature,
     const at::Tensor& indices, const at::Tensor& weight, at::IntArrayRef kernel_size, int out_channel,
     at::IntArrayRef outSpatialShape, int batch_size, const at::Tensor& temp);
@@ -211,8 +287,14 @@ at::Tensor npu_box_iou_quadri(
 at::Tensor npu_box_iou_rotated(
     const at::Tensor& boxes_a, const at::Tensor& boxes_b, const int64_t mode_flag, const bool aligned);
 
+std::tuple<at::Tensor, at::Tensor> boxes_overlap_sparse(const at::Tensor& boxes_a, const at::Tensor& boxes_b,
+    int64_t box_type, int64_t format_flag, int64_t unit_flag, bool clockwise, int64_t mode_flag, double margin);
+
 void border_align(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output, int32_t pooled_size);
 
+std::tuple<at::Tensor, at::Tensor> border_align_max(const at::Tensor& input, const at::Tensor& rois,
+    int32_t pooled_size);
+
 at::Tensor border_align_backward(const at::Tensor& grad_out, const at::Tensor& boxes, const at::Tensor& argmax_idx,
     int32_t pool_size, int32_t height, int32_t width);
 
@@ -220,6 +302,12 @@ void npu_roiaware_pool3d_forward(const at::Tensor& rois, const at::Tensor& pts,
     at::Tensor& argmax, at::Tensor& pts_idx_of_voxels, at::Tensor& pooled_features, int32_t mode);
 at::Tensor roiaware_pool3d_grad(const at::Tensor& pts_idx_of_voxels, const at::Tensor& argmax,
     const at::Tensor& grad_out, int32_t npoints, int64_t pool_method);
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor> roiaware_pool3d_csr(const at::Tensor& rois,
+    const at::Tensor& pts, const at::Tensor& pts_feature, int64_t out_x, int64_t out_y, int64_t out_z,
+    int64_t max_pts_per_voxel, int64_t mode);
+at::Tensor roiaware_pool3d_csr_grad(const at::Tensor& voxel_idx, const at::Tensor& voxel_ptr,
+    const at::Tensor& pts_idx, const at::Tensor& argmax, const at::Tensor& grad_out, int64_t npoints,
+    int64_t pool_method);
 
 std::vector<std::vector<float>> pixel_group(const at::Tensor& score, const at::Tensor& mask,
     const at::Tensor& embedding, const at::Tensor& kernel_label, const at::Tensor& kernel_contour,
@@ -229,8 +317,14 @@ at::Tensor npu_points_in_box(const at::Tensor& boxes, const at::Tensor& pts);
 
 at::Tensor npu_points_in_box_all(const at::Tensor& boxes, const at::Tensor& pts);
 
+std::tuple<at::Tensor, at::Tensor> points_in_boxes_grid(
+    const at::Tensor& boxes, const at::Tensor& pts, bool return_csr, double cell_size);
+
 std::tuple<at::Tensor, at::Tensor> npu_roipoint_pool3d_forward(const int32_t num_sampled_points,
     const at::Tensor& points, const at::Tensor& point_features, const at::Tensor& boxes3d);
+std::tuple<at::Tensor, at::Tensor> roipoint_pool3d_csr(int64_t num_sampled_points, const at::Tensor& points,
+    const at::Tensor& point_features, const at::Tensor& boxes3d, const at::Tensor& pts_ptr, const at::Tensor& box_idx,
+    int64_t sample_mode, int64_t seed);
 
 void geometric_kernel_attention_forward(const at::Tensor& value_map, const at::Tensor& spatial_shapes,
     const at::Tensor& level_start_index, const at::Tensor& sampling_locations,
@@ -250,6 +344,11 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor> npu_gauss
     float range_x, float range_y, int32_t feature_map_size_x, int32_t feature_map_size_y,
     bool norm_bbox, bool with_velocity, bool flip_angle, int32_t max_objs);
 
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> assign_target_of_multi_head(const at::Tensor& boxes,
+    const at::Tensor& labels, at::IntArrayRef head_num_classes, int64_t out_size_factor, double overlap,
+    int64_t min_radius, const std::vector<float>& voxel_size, const std::vector<float>& pc_range,
+    at::IntArrayRef feature_map_size, bool norm_bbox, bool flip_angle, int64_t max_objs);
+
 at::Tensor npu_draw_gaussian_to_heatmap(const at::Tensor& mask, const at::Tensor& cur_class_id, const at::Tensor& center_int, const at::Tensor& radius,
     int64_t feature_map_size_x, int64_t feature_map_size_y, int64_t num_classes);
 
@@ -261,6 +360,9 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> npu_assign_target_of_
 at::Tensor diff_iou_rotated_sort_vertices(const at::Tensor& vertices, const at::Tensor& mask,
     const at::Tensor& num_valid);
 
+std::tuple<at::Tensor, at::Tensor> diff_iou_rotated(
+    const at::Tensor& boxes_a, const at::Tensor& boxes_b, int64_t mode, bool with_grad);
+
 at::Tensor grid_sampler2d_v2(const at::Tensor& input, const at::Tensor& grid, int64_t interpolation_mode,
     int64_t padding_mode, bool align_corners);
 
@@ -286,10 +388,13 @@ at::Tensor npu_subm_sparse_conv3d_with_key(const at::Tensor& ouidx_offset, const
 
 at::Tensor min_area_polygons(const at::Tensor& pointsets);
 
+at::Tensor min_area_rects(const at::Tensor& pointsets);
+
 std::tuple<at::Tensor, at::Tensor> npu_subm_sparse_conv3d_v2(const at::Tensor& feature,
     const at::Tensor& indices, const at::Tensor& map1, const at::Tensor& map2, at::IntArrayRef kernel_size, int in_channels,
     at::IntArrayRef out_spatial_shape, int batch_size);
 
-std::tuple<at::Tensor, at::Tensor> radius(at::Tensor& x, at::Tensor& y, at::Tensor& ptr_x, at::Tensor& ptr_y, double r, int max_num_neighbors);
+std::tuple<at::Tensor, at::Tensor> radius(at::Tensor& x, at::Tensor& y, at::Tensor& ptr_x, at::Tensor& ptr_y, double r, int max_num_neighbors,
+    bool padded);
 
 #endif // CSRC_FUNCTIONS_H_
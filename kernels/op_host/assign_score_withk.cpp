@@ -13,6 +13,7 @@ constexpr size_t NWEIGHTS_IDX = 3;
 constexpr size_t NNEIGHBORS_IDX = 4;
 constexpr size_t NFEATURES_IDX = 5;
 constexpr size_t AGG_IDX = 6;
+constexpr uint32_t AGGREGATE_MAX = 2;
 
 namespace optiling {
 
@@ -111,6 +112,17 @@ static ge::graphStatus AssignScoreWithkInferShape(gert::InferShapeContext *conte
 
     outputShape->SetDimNum(4);
     *outputShape = {batchSize, numFeatures, npoint, numNeighbors};
+    // argmax仅在max聚合时有效，其余模式为空tensor
+    gert::Shape *argmaxShape = context->GetOutputShape(1);
+    auto aggregatePtr = attr->GetAttrPointer<uint32_t>(AGG_IDX);
+    if ((argmaxShape == nullptr) || (!aggregatePtr)) {
+        return ge::GRAPH_FAILED;
+    }
+    if (*aggregatePtr == AGGREGATE_MAX) {
+        *argmaxShape = {batchSize, numFeatures, npoint, numNeighbors};
+    } else {
+        *argmaxShape = {0};
+    }
 
     return GRAPH_SUCCESS;
 }
@@ -118,6 +130,7 @@ static ge::graphStatus AssignScoreWithkInferShape(gert::InferShapeContext *conte
 static ge::graphStatus AssignScoreWithkInferDataType(gert::InferDataTypeContext *context)
 {
     context->SetOutputDataType(0, ge::DT_FLOAT);
+    context->SetOutputDataType(1, ge::DT_INT32);
     return GRAPH_SUCCESS;
 }
 }
@@ -179,6 +192,11 @@ public:
             .DataType({ge::DT_FLOAT})
             .Format({ge::FORMAT_ND})
             .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("argmax")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
         this->SetInferShape(ge::AssignScoreWithkInferShape)
             .SetInferDataType(ge::AssignScoreWithkInferDataType);
         this->AICore().SetTiling(optiling::AssignScoreWithkTilingFunc);
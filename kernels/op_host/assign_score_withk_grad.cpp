@@ -20,6 +20,12 @@ constexpr size_t INPUT_POINTS_POSITION = 1;
 constexpr size_t INPUT_CENTERS_POSITION = 2;
 constexpr size_t INPUT_SCORES_POSITION = 3;
 constexpr size_t INPUT_KNNIDX_POSITION = 4;
+constexpr uint32_t BLOCK_SIZE = 32;
+constexpr uint32_t REPEAT_ELEMS = 64;
+// 为Sum等高阶API的内部临时空间预留的UB
+constexpr uint64_t RESERVED_UB_SIZE = 16 * 1024;
+// 每个权重行在UB中常驻的float行数: points, centers, grad, gradPoints, gradCenters
+constexpr uint32_t ROWS_PER_WEIGHT = 5;
 
 constexpr size_t OUTPUT_GRADSCORES_POSITION = 0;
 constexpr size_t OUTPUT_GRADPOINTS_POSITION = 1;
@@ -91,15 +97,21 @@ static ge::graphStatus AssignScoreWithkGradTilingFunc(gert::TilingContext *conte
     TilingData.set_numCore(numCore);
     context->SetBlockDim(numCore);
 
-    uint32_t dataAlign = 32 / sizeof(float);
-    uint32_t featureAlign = AlignUp(numFeatures, dataAlign);
-    std::vector<int64_t> shapeVector = {numWeights, featureAlign};
-    ge::Shape srcShape(shapeVector);
-    uint32_t maxValue = 0;
-    uint32_t minValue = 0;
-    AscendC::GetUnPadMaxMinTmpSize(platformInfo, srcShape, sizeof(float), maxValue, minValue);
-    const uint32_t localWorkSpaceSize = minValue;
-    AscendC::UnPadTilingFunc(srcShape, localWorkSpaceSize, sizeof(float), TilingData.unpadTilingData);
+
+    // 沿M(权重数)分块：每块weightTile行的points/centers/梯度常驻UB，不再限制M * out_dim
+    uint64_t ubSize;
+    platformInfo.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+    uint32_t featureAlign = AlignUp(numFeatures, BLOCK_SIZE / sizeof(float));
+    uint32_t featureRepeatAlign = AlignUp(numFeatures, REPEAT_ELEMS);
+    uint64_t fixedSize = RESERVED_UB_SIZE + AlignUp(numNeighbors * sizeof(int64_t), BLOCK_SIZE) +
+                         3 * featureRepeatAlign * sizeof(float) + AlignUp(featureRepeatAlign / 8, BLOCK_SIZE);
+    uint64_t rowSize = (ROWS_PER_WEIGHT * featureAlign + 2) * sizeof(float);
+    if (ubSize <= fixedSize + rowSize + 2 * BLOCK_SIZE) {
+        return ge::GRAPH_FAILED;
+    }
+    uint64_t weightTile = (ubSize - fixedSize - 2 * BLOCK_SIZE) / rowSize;
+    weightTile = weightTile < numWeights ? weightTile : numWeights;
+    TilingData.set_weightTile(static_cast<uint32_t>(weightTile));
 
     if (context->GetRawTilingData() == nullptr) {
         return ge::GRAPH_FAILED;
@@ -191,6 +203,12 @@ public:
             .Format({ge::FORMAT_ND})
             .UnknownShapeFormat({ge::FORMAT_ND})
             .AutoContiguous();
+        this->Input("argmax")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND})
+            .AutoContiguous();
 
         this->Attr("batch_size")
             .AttrType(REQUIRED)
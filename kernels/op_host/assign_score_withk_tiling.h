@@ -20,7 +20,7 @@ BEGIN_TILING_DATA_DEF(AssignScoreWithkTilingData)
     TILING_DATA_FIELD_DEF(uint32_t, numWeights);
     TILING_DATA_FIELD_DEF(uint32_t, numNeighbors);
     TILING_DATA_FIELD_DEF(uint32_t, numFeatures);
-    TILING_DATA_FIELD_DEF_STRUCT(UnPadTiling, unpadTilingData)
+    TILING_DATA_FIELD_DEF(uint32_t, weightTile);
 END_TILING_DATA_DEF;
 
 REGISTER_TILING_DATA_CLASS(AssignScoreWithk, AssignScoreWithkTilingData)
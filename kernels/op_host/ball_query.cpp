@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+
+#include "ball_query_tiling.h"
+#include "common.h"
+
+namespace {
+constexpr uint32_t INPUT_XYZ = 0;
+constexpr uint32_t INPUT_CENTER_XYZ = 1;
+constexpr uint32_t INPUT_FEATURES = 2;
+constexpr uint32_t ATTR_MIN_RADIUS = 0;
+constexpr uint32_t ATTR_MAX_RADIUS = 1;
+constexpr uint32_t ATTR_SAMPLE_NUM = 2;
+constexpr uint32_t ATTR_WITH_FEATURES = 3;
+constexpr uint32_t POINT_DIM = 3;
+constexpr uint32_t BLOCK_SIZE = 32;
+constexpr uint32_t COMPARE_ALIGN = 64; // CompareScalar requires 256B alignment
+constexpr uint32_t MAX_COMP_NUM = 4096;
+constexpr uint64_t RESERVED_UB_SIZE = 8 * 1024;
+constexpr uint64_t TILING_KEY_FLOAT = 0;
+constexpr uint64_t TILING_KEY_HALF = 1;
+} // namespace
+
+namespace optiling {
+static ge::graphStatus TilingForBallQuery(gert::TilingContext* context)
+{
+    if (context == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    const gert::StorageShape* xyzShape = context->GetInputShape(INPUT_XYZ);
+    const gert::StorageShape* centerXyzShape = context->GetInputShape(INPUT_CENTER_XYZ);
+    const gert::RuntimeAttrs* attrs = context->GetAttrs();
+    auto platformInfoPtr = context->GetPlatformInfo();
+    if ((xyzShape == nullptr) || (centerXyzShape == nullptr) || (attrs == nullptr) || (platformInfoPtr == nullptr) ||
+        (context->GetInputDesc(INPUT_XYZ) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    if ((attrs->GetAttrPointer<float>(ATTR_MIN_RADIUS) == nullptr) ||
+        (attrs->GetAttrPointer<float>(ATTR_MAX_RADIUS) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_SAMPLE_NUM) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_WITH_FEATURES) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    auto platformInfo = platform_ascendc::PlatformAscendC(platformInfoPtr);
+    uint32_t coreNum = platformInfo.GetCoreNumAiv();
+    if (coreNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+    uint64_t ubSize;
+    platformInfo.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+
+    // xyz: [B, 3, N], center_xyz: [B, M, 3], features: [B, N, C]
+    uint32_t batch = xyzShape->GetStorageShape().GetDim(0);
+    uint32_t nSource = xyzShape->GetStorageShape().GetDim(2);
+    uint32_t nPoint = centerXyzShape->GetStorageShape().GetDim(1);
+    float minRadius = *attrs->GetAttrPointer<float>(ATTR_MIN_RADIUS);
+    float maxRadius = *attrs->GetAttrPointer<float>(ATTR_MAX_RADIUS);
+    int32_t sampleNum = *attrs->GetAttrPointer<int32_t>(ATTR_SAMPLE_NUM);
+    bool withFeatures = *attrs->GetAttrPointer<bool>(ATTR_WITH_FEATURES);
+    if (sampleNum <= 0) {
+        return ge::GRAPH_FAILED;
+    }
+    bool isHalf = context->GetInputDesc(INPUT_XYZ)->GetDataType() == ge::DT_FLOAT16;
+    uint32_t dtypeSize = isHalf ? sizeof(int16_t) : sizeof(float);
+
+    uint32_t cSize = 0;
+    uint32_t cAligned = 0;
+    if (withFeatures) {
+        const gert::StorageShape* featuresShape = context->GetInputShape(INPUT_FEATURES);
+        if (featuresShape == nullptr) {
+            return ge::GRAPH_FAILED;
+        }
+        cSize = featuresShape->GetStorageShape().GetDim(2);
+        cAligned = CeilAlign(cSize, BLOCK_SIZE / dtypeSize);
+    }
+
+    // 特征聚合缓冲区按nsample * cAligned申请，剩余UB按每个源点所需空间划分单次计算的源点数
+    uint64_t sampleBytes = CeilAlign(static_cast<uint64_t>(sampleNum) * sizeof(int32_t), static_cast<uint64_t>(BLOCK_SIZE));
+    uint64_t featureBytes = static_cast<uint64_t>(sampleNum) * cAligned * dtypeSize;
+    uint64_t fixedBytes = RESERVED_UB_SIZE + sampleBytes + featureBytes;
+    if (fixedBytes >= ubSize) {
+        return ge::GRAPH_FAILED;
+    }
+    // xyz(fp32) + dist + tmp + index + 3 masks (+ half staging)，mask按32B对齐多占的空间由预留量覆盖
+    uint64_t perPointBytes = POINT_DIM * sizeof(float) + sizeof(float) * 2 + sizeof(int32_t) + 1 +
+                             (isHalf ? POINT_DIM * dtypeSize : 0);
+    uint32_t compNum = FloorAlign(std::min(static_cast<uint64_t>(MAX_COMP_NUM), (ubSize - fixedBytes) / perPointBytes),
+        static_cast<uint64_t>(COMPARE_ALIGN));
+    if (compNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+    compNum = std::min(compNum, CeilAlign(std::max(nSource, 1U), COMPARE_ALIGN));
+
+    uint32_t totalTask = batch * nPoint;
+    uint32_t coreTaskNum = DivCeil(totalTask, coreNum);
+    uint32_t useCoreNum = coreTaskNum == 0 ? 1 : DivCeil(totalTask, coreTaskNum);
+
+    BallQueryTilingData tiling;
+    tiling.set_batch(batch);
+    tiling.set_nPoint(nPoint);
+    tiling.set_nSource(nSource);
+    tiling.set_sampleNum(static_cast<uint32_t>(sampleNum));
+    tiling.set_cSize(cSize);
+    tiling.set_cAligned(cAligned);
+    tiling.set_withFeatures(withFeatures);
+    tiling.set_minRadius2(minRadius * minRadius);
+    tiling.set_maxRadius2(maxRadius * maxRadius);
+    tiling.set_compNum(compNum);
+    tiling.set_coreTaskNum(coreTaskNum);
+    tiling.set_useCoreNum(useCoreNum);
+    context->SetTilingKey(isHalf ? TILING_KEY_HALF : TILING_KEY_FLOAT);
+    context->SetBlockDim(useCoreNum);
+
+    if (context->GetRawTilingData() == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+    size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+    if (currentWorkspace == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    currentWorkspace[0] = 0;
+    return ge::GRAPH_SUCCESS;
+}
+} // namespace optiling
+
+namespace ge {
+static ge::graphStatus InferShapeForBallQuery(gert::InferShapeContext* context)
+{
+    const gert::Shape* centerXyzShape = context->GetInputShape(INPUT_CENTER_XYZ);
+    gert::Shape* idxShape = context->GetOutputShape(0);
+    gert::Shape* groupedShape = context->GetOutputShape(1);
+    const gert::RuntimeAttrs* attrs = context->GetAttrs();
+    if ((centerXyzShape == nullptr) || (idxShape == nullptr) || (groupedShape == nullptr) || (attrs == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_SAMPLE_NUM) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_WITH_FEATURES) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    int64_t batch = centerXyzShape->GetDim(0);
+    int64_t nPoint = centerXyzShape->GetDim(1);
+    int64_t sampleNum = *attrs->GetAttrPointer<int32_t>(ATTR_SAMPLE_NUM);
+    *idxShape = {batch, nPoint, sampleNum};
+    if (*attrs->GetAttrPointer<bool>(ATTR_WITH_FEATURES)) {
+        const gert::Shape* featuresShape = context->GetInputShape(INPUT_FEATURES);
+        if (featuresShape == nullptr) {
+            return ge::GRAPH_FAILED;
+        }
+        *groupedShape = {batch * nPoint * sampleNum, featuresShape->GetDim(2)};
+    } else {
+        *groupedShape = {0};
+    }
+    return GRAPH_SUCCESS;
+}
+
+static ge::graphStatus InferDataTypeForBallQuery(gert::InferDataTypeContext* context)
+{
+    context->SetOutputDataType(0, ge::DT_INT32);
+    context->SetOutputDataType(1, context->GetInputDataType(INPUT_XYZ));
+    return GRAPH_SUCCESS;
+}
+} // namespace ge
+
+namespace ops {
+class BallQuery : public OpDef {
+public:
+    explicit BallQuery(const char* name) : OpDef(name)
+    {
+        this->Input("xyz")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("center_xyz")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("features")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Attr("min_radius")
+            .AttrType(REQUIRED)
+            .Float();
+        this->Attr("max_radius")
+            .AttrType(REQUIRED)
+            .Float();
+        this->Attr("sample_num")
+            .AttrType(REQUIRED)
+            .Int();
+        this->Attr("with_features")
+            .AttrType(OPTIONAL)
+            .Bool(false);
+        this->Output("idx")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Output("grouped_features")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->SetInferShape(ge::InferShapeForBallQuery)
+            .SetInferDataType(ge::InferDataTypeForBallQuery);
+        this->AICore().SetTiling(optiling::TilingForBallQuery);
+        OpAICoreConfig aicore_config;
+        aicore_config.DynamicCompileStaticFlag(true)
+            .DynamicFormatFlag(true)
+            .DynamicRankSupportFlag(true)
+            .DynamicShapeSupportFlag(true);
+        this->AICore().AddConfig("ascend910b", aicore_config);
+        this->AICore().AddConfig("ascend910_93", aicore_config);
+    }
+};
+
+OP_ADD(BallQuery);
+} // namespace ops
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+#ifndef BALL_QUERY_TILING_H
+#define BALL_QUERY_TILING_H
+
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+#include "tiling/tiling_api.h"
+#include "register/tilingdata_base.h"
+
+namespace optiling {
+BEGIN_TILING_DATA_DEF(BallQueryTilingData)
+    TILING_DATA_FIELD_DEF(uint32_t, batch);
+    TILING_DATA_FIELD_DEF(uint32_t, nPoint);
+    TILING_DATA_FIELD_DEF(uint32_t, nSource);
+    TILING_DATA_FIELD_DEF(uint32_t, sampleNum);
+    TILING_DATA_FIELD_DEF(uint32_t, cSize);
+    TILING_DATA_FIELD_DEF(uint32_t, cAligned);
+    TILING_DATA_FIELD_DEF(bool, withFeatures);
+    TILING_DATA_FIELD_DEF(float, minRadius2);
+    TILING_DATA_FIELD_DEF(float, maxRadius2);
+    TILING_DATA_FIELD_DEF(uint32_t, compNum);
+    TILING_DATA_FIELD_DEF(uint32_t, coreTaskNum);
+    TILING_DATA_FIELD_DEF(uint32_t, useCoreNum);
+END_TILING_DATA_DEF;
+
+REGISTER_TILING_DATA_CLASS(BallQuery, BallQueryTilingData)
+}
+
+#endif // BALL_QUERY_TILING_H
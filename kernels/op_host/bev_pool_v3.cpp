@@ -22,6 +22,29 @@ constexpr int32_t ONE_BLK_SIZE = 8;
 constexpr int32_t RESERVE_UB = 10 * 1024; // 10 KB
 constexpr int32_t CHANNEL_IDX = 1;
 constexpr int32_t CHANNEL_IDX_WITH_DEPTH = 4;
+constexpr int32_t DEPTH_SOFTMAX_ATTR_IDX = 1;
+constexpr uint64_t BLOCK_BYTES = 32;
+constexpr uint64_t SIZE_OF_FP32 = 4;
+
+// the tiling key represented as below:
+// +----+----+-------+-----+
+// |bf16|fp16|softmax|depth|
+// +----+----+-------+-----+
+constexpr uint64_t TILING_WITH_DEPTH_FLAG = 1;
+constexpr uint64_t TILING_DEPTH_SOFTMAX_FLAG = 1 << 1;
+constexpr uint64_t TILING_FP16_FLAG = 1 << 2;
+constexpr uint64_t TILING_BF16_FLAG = 1 << 3;
+
+uint64_t GetDtypeFlag(ge::DataType dtype)
+{
+    if (dtype == ge::DT_FLOAT16) {
+        return TILING_FP16_FLAG;
+    }
+    if (dtype == ge::DT_BF16) {
+        return TILING_BF16_FLAG;
+    }
+    return 0;
+}
 } // namespace
 
 namespace optiling {
@@ -43,13 +66,45 @@ static ge::graphStatus TilingForBEVPoolV3(gert::TilingContext* context)
     CHECK_NULLPTR(withDepthPtr);
 
     bool withDepth = *withDepthPtr;
-    context->SetTilingKey(withDepth);
+    bool depthSoftmax = false;
+    if (!is_grad) {
+        auto depthSoftmaxPtr = attrsPtr->GetBool(DEPTH_SOFTMAX_ATTR_IDX);
+        depthSoftmax = depthSoftmaxPtr != nullptr && *depthSoftmaxPtr;
+    }
+    if (depthSoftmax && !withDepth) {
+        return ge::GRAPH_FAILED;
+    }
+    auto featDesc = context->GetInputDesc(is_grad ? INPUT_FEAT_GRAD : INPUT_FEAT);
+    CHECK_NULLPTR(featDesc);
+    auto dtype = featDesc->GetDataType();
+    uint64_t dtypeBytes = ge::GetSizeByDataType(dtype);
+    if (dtypeBytes == 0) {
+        return ge::GRAPH_FAILED;
+    }
+    // 不带depth的反向只搬运fp32的grad_out，与feat数据类型无关
+    uint64_t dtypeFlag = (is_grad && !withDepth) ? 0 : GetDtypeFlag(dtype);
+    uint64_t tilingKey = dtypeFlag;
+    if (withDepth) {
+        tilingKey |= TILING_WITH_DEPTH_FLAG;
+    }
+    if (depthSoftmax) {
+        tilingKey |= TILING_DEPTH_SOFTMAX_FLAG;
+    }
+    context->SetTilingKey(tilingKey);
 
-    auto channel = featShape->GetOriginShape().GetDim(withDepth ? CHANNEL_IDX_WITH_DEPTH : CHANNEL_IDX);
+    uint64_t channel = featShape->GetOriginShape().GetDim(withDepth ? CHANNEL_IDX_WITH_DEPTH : CHANNEL_IDX);
     uint64_t ranks = ranksBevShape->GetOriginShape().GetDim(0);
+    // 不带depth时按行批量搬运，每行在UB中按32B对齐
+    uint64_t rowBytes;
+    if (is_grad) {
+        rowBytes = 2 * AlignUp(channel * SIZE_OF_FP32, BLOCK_BYTES);
+    } else {
+        uint64_t cAligned = AlignUp(channel, BLOCK_BYTES / dtypeBytes);
+        rowBytes = 2 * cAligned * dtypeBytes + (dtypeFlag == 0 ? 0 : cAligned * SIZE_OF_FP32);
+    }
     uint64_t avgRankNum = withDepth ?
                          RANK_NUM_PER_TASK :
-                         (ubSize - RESERVE_UB) / (sizeof(float) * (channel + 1) * 2) / ONE_BLK_SIZE * ONE_BLK_SIZE;
+                         (ubSize - RESERVE_UB) / (rowBytes + 2 * sizeof(int32_t)) / ONE_BLK_SIZE * ONE_BLK_SIZE;
     avgRankNum = std::min(avgRankNum, ranks);
     if (avgRankNum == 0) {
         return ge::GRAPH_FAILED;
@@ -93,42 +148,49 @@ public:
     {
         this->Input("depth")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("feat")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_depth")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_feat")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_bev")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .AutoContiguous()
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("depth_lse")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->Attr("with_depth").Bool();
+        this->Attr("depth_softmax").AttrType(OPTIONAL).Bool(false);
 
         this->Output("out")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->AICore().SetTiling(optiling::TilingForBEVPoolV3<false>);
         this->AICore().AddConfig("ascend910b");
@@ -154,53 +216,53 @@ public:
     {
         this->Input("grad_out")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("depth")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("feat")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_depth")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_feat")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("ranks_bev")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .AutoContiguous()
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->Attr("with_depth").Bool();
 
         this->Output("grad_depth")
             .ParamType(OPTIONAL)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Output("grad_feat")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->AICore().SetTiling(optiling::TilingForBEVPoolV3<true>);
         this->AICore().AddConfig("ascend910b");
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2025. All rights reserved.
+ */
+#include "border_align_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+
+using namespace std;
+namespace optiling {
+const uint32_t TILE_NUM = 8;
+const uint32_t BOX_INFO = 4; // 每个box有四个坐标
+const uint32_t COMPARE_ALIGN = 64; // Compare按256字节的repeat处理float
+const uint32_t MASK_ALIGN = 32;
+const uint32_t BITS_PER_BYTE = 8;
+const uint32_t FEATURE_BUFFER_NUM = 8; // 4个插值点、max、argmax、当前采样点、float形式的argmax
+static ge::graphStatus TilingForBorderAlignMax(gert::TilingContext* context)
+{
+    if (context == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    BorderAlignTilingData tiling;
+
+    if (context->GetInputShape(0) == nullptr || context->GetInputShape(1) == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+
+    auto inputShape = context->GetInputShape(0)->GetStorageShape(); // [B, H, W, C]
+    auto roisShape = context->GetInputShape(1)->GetStorageShape(); // [B, H * W, 4]
+
+    uint32_t batchSize = inputShape.GetDim(0);
+    uint32_t inputH = inputShape.GetDim(1);
+    uint32_t inputW = inputShape.GetDim(2);
+    uint32_t channels = inputShape.GetDim(3);
+    // channels必须要被4整除
+    if (channels % BOX_INFO != 0) {
+        return ge::GRAPH_FAILED;
+    }
+    uint32_t sideChannels = channels / BOX_INFO;
+    uint32_t moveInLength = (sideChannels + TILE_NUM - 1) / TILE_NUM * TILE_NUM;
+    uint32_t computeLength = (sideChannels + COMPARE_ALIGN - 1) / COMPARE_ALIGN * COMPARE_ALIGN;
+
+    auto attrsPtr = context->GetAttrs();
+    if (attrsPtr == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    int32_t pooledSize = *(attrsPtr->GetAttrPointer<int32_t>(0));
+    if (pooledSize <= 0) {
+        return ge::GRAPH_FAILED;
+    }
+
+    uint32_t roisNum = roisShape.GetDim(0) * roisShape.GetDim(1);
+    if (roisNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+
+    auto platform = context->GetPlatformInfo();
+    if (platform == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    auto platform_info = platform_ascendc::PlatformAscendC(platform);
+    uint32_t BLOCK_DIM = platform_info.GetCoreNumAiv();
+    if (BLOCK_DIM == 0) {
+        return ge::GRAPH_FAILED;
+    }
+
+    // 每次取64个RoI进UB，与BorderAlign一致
+    uint32_t roisNumPerLoop = 64;
+    uint32_t roisBufferSize = roisNumPerLoop * BOX_INFO * sizeof(float);
+    uint32_t inputBufferSize = computeLength * sizeof(float);
+    uint64_t ubSize;
+    platform_info.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+    uint64_t usedUbSize = static_cast<uint64_t>(inputBufferSize) * FEATURE_BUFFER_NUM + roisBufferSize +
+                          (computeLength / BITS_PER_BYTE + MASK_ALIGN - 1) / MASK_ALIGN * MASK_ALIGN;
+    if (usedUbSize > ubSize) {
+        return ge::GRAPH_FAILED;
+    }
+
+    uint32_t roisNumAligned = (roisNum + TILE_NUM - 1) / TILE_NUM * TILE_NUM;
+    uint32_t tailNum = roisNumAligned - roisNum;
+    uint32_t roisNumPerScore = (roisNumAligned / BLOCK_DIM / TILE_NUM) * TILE_NUM;
+    uint32_t roisNumPerLcore = roisNumPerScore + TILE_NUM;
+    uint32_t scoreNum = (BLOCK_DIM * (TILE_NUM + roisNumPerScore) - roisNumAligned) / TILE_NUM;
+    uint32_t lcoreNum = BLOCK_DIM - scoreNum;
+    if (roisNumPerScore == 0) {
+        BLOCK_DIM = BLOCK_DIM - scoreNum;
+    }
+
+    tiling.set_roisNumPerLoop(roisNumPerLoop);
+    tiling.set_batchSize(batchSize);
+    tiling.set_inputH(inputH);
+    tiling.set_inputW(inputW);
+    tiling.set_channels(channels);
+    tiling.set_moveInLength(moveInLength);
+    tiling.set_moveOutLength(sideChannels * sizeof(float));
+    tiling.set_roisNumAligned(roisNumAligned);
+    tiling.set_tailNum(tailNum);
+    tiling.set_pooledSize(pooledSize);
+    tiling.set_roisNumPerLcore(roisNumPerLcore);
+    tiling.set_roisNumPerScore(roisNumPerScore);
+    tiling.set_lcoreNum(lcoreNum);
+    tiling.set_scoreNum(scoreNum);
+    tiling.set_inputBufferSize(inputBufferSize);
+    tiling.set_roisBufferSize(roisBufferSize);
+    if (context->GetRawTilingData() == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+    context->SetBlockDim(BLOCK_DIM);
+
+    return ge::GRAPH_SUCCESS;
+}
+}
+
+namespace ge {
+static ge::graphStatus InferShapeBorderAlignMax(gert::InferShapeContext* context)
+{
+    if (context == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    const gert::Shape* inputShape = context->GetInputShape(0);
+    const gert::Shape* roisShape = context->GetInputShape(1);
+    gert::Shape* outputShape = context->GetOutputShape(0);
+    gert::Shape* argmaxShape = context->GetOutputShape(1);
+    if (inputShape == nullptr || roisShape == nullptr || outputShape == nullptr || argmaxShape == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+
+    int64_t batchSize = inputShape->GetDim(0);
+    int64_t heightTimesWidth = roisShape->GetDim(1);
+    int64_t channels = inputShape->GetDim(3);
+    // 每个像素的4C个通道依次为上、左、下、右四条边的max
+    *outputShape = {batchSize, heightTimesWidth, 4, channels / 4};
+    *argmaxShape = {batchSize, heightTimesWidth, 4, channels / 4};
+
+    return GRAPH_SUCCESS;
+}
+static ge::graphStatus InferDataTypeBorderAlignMax(gert::InferDataTypeContext* context)
+{
+    const ge::DataType valueDtype = context->GetInputDataType(0);
+    context->SetOutputDataType(0, valueDtype);
+    context->SetOutputDataType(1, ge::DT_INT32);
+    return GRAPH_SUCCESS;
+}
+}
+
+namespace ops {
+class BorderAlignMax : public OpDef {
+public:
+    explicit BorderAlignMax(const char* name) : OpDef(name)
+    {
+        this->Input("input")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("rois")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("output")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("argmax_idx")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Attr("pooledSize").AttrType(REQUIRED).Int();
+        this->SetInferShape(ge::InferShapeBorderAlignMax)
+            .SetInferDataType(ge::InferDataTypeBorderAlignMax);
+        this->AICore()
+            .SetTiling(optiling::TilingForBorderAlignMax);
+        this->AICore().AddConfig("ascend910b");
+        this->AICore().AddConfig("ascend910_93");
+    }
+};
+
+OP_ADD(BorderAlignMax);
+}
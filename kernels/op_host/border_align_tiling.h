@@ -27,5 +27,6 @@ BEGIN_TILING_DATA_DEF(BorderAlignTilingData)
 END_TILING_DATA_DEF;
 
 REGISTER_TILING_DATA_CLASS(BorderAlign, BorderAlignTilingData)
+REGISTER_TILING_DATA_CLASS(BorderAlignMax, BorderAlignTilingData)
 }
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ namespace {
 constexpr uint32_t SINGLE = 1;
 constexpr uint32_t BYTE_BLOCK = 32;
 constexpr uint32_t SIZE_OF_FP32 = 4;
+constexpr uint32_t SIZE_OF_FP16 = 2;
 constexpr uint32_t BATCH_SIZE_IDX = 0;
 constexpr uint32_t FEAT_IDX = 1;
 constexpr uint32_t EMBEDS_IDX = 2;
@@ -31,6 +32,13 @@ constexpr uint32_t PTS_IDX = 4;
 constexpr uint32_t CAMS_IDX = 5;
 constexpr uint32_t SCALE_IDX = 6;
 constexpr uint32_t GROUPS_IDX = 7;
+constexpr uint32_t SOFTMAX_IDX = 8;
+constexpr uint32_t SLOTS_IDX = 9;
+constexpr uint32_t SLOT_INDEX_INPUT_IDX = 5;
+
+constexpr uint64_t TILING_KEY_FLOAT = 1;
+constexpr uint64_t TILING_KEY_HALF = 2;
+constexpr uint64_t TILING_KEY_BF16 = 3;
 
 
 } // namespace
@@ -53,7 +61,18 @@ static ge::graphStatus TilingForDeformableAggregation(gert::TilingContext* conte
         return ge::GRAPH_FAILED;
     }
 
-    auto dtype = context->GetInputDesc(0)->GetDataType();
+    auto featDesc = context->GetInputDesc(0);
+    if (featDesc == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    auto dtype = featDesc->GetDataType();
+    uint64_t tilingKey = TILING_KEY_FLOAT;
+    if (dtype == ge::DT_FLOAT16) {
+        tilingKey = TILING_KEY_HALF;
+    } else if (dtype == ge::DT_BF16) {
+        tilingKey = TILING_KEY_BF16;
+    }
+    bool isFloat = tilingKey == TILING_KEY_FLOAT;
 
     auto attrs = context->GetAttrs();
     if (attrs == nullptr) {
@@ -75,18 +94,45 @@ static ge::graphStatus TilingForDeformableAggregation(gert::TilingContext* conte
     auto numCams = getAttr(CAMS_IDX);
     auto numScales = getAttr(SCALE_IDX);
     auto numGroups = getAttr(GROUPS_IDX);
+    auto softmaxPtr = attrs->GetBool(SOFTMAX_IDX);
+    bool softmaxFlag = softmaxPtr != nullptr && *softmaxPtr;
+    auto numSlots = getAttr(SLOTS_IDX);
+    // 传入slot_index时mc_ms_feat为[numSlots, bs, numFeats, numEmbeds]的时序特征缓存
+    bool slotFlag = context->GetOptionalInputTensor(SLOT_INDEX_INPUT_IDX) != nullptr;
+    if (slotFlag && numSlots <= 0) {
+        return ge::GRAPH_FAILED;
+    }
+    if (numGroups <= 0 || numEmbeds % numGroups != 0) {
+        return ge::GRAPH_FAILED;
+    }
 
-    uint32_t alignNum = BYTE_BLOCK / SIZE_OF_FP32;
+    // 半精度特征以16个元素对齐，保证转换前后的缓冲区都满足32B对齐
+    uint32_t alignNum = isFloat ? BYTE_BLOCK / SIZE_OF_FP32 : BYTE_BLOCK / SIZE_OF_FP16;
     uint32_t cAligned = CeilAlign(static_cast<uint32_t>(numEmbeds), alignNum);
+    // group数不是8的倍数时，weight需要逐个搬运到对齐的临时空间后再广播
+    bool groupAligned = (numGroups % (BYTE_BLOCK / SIZE_OF_FP32)) == 0;
 
     uint64_t ubSize;
     ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
     // 计算除weightBuf_所占空间以外的其他ub大小，并流出预留量(16 * 1024)
     uint64_t usedUbSize = (16 * 1024 + 6 * cAligned + numPoints * numCams * 2 + numCams * numScales * 3) * SIZE_OF_FP32;
+    if (!isFloat) {
+        // 半精度输入、输出的搬运缓冲区
+        usedUbSize += 5 * cAligned * SIZE_OF_FP16;
+    }
+    if (softmaxFlag) {
+        // softmax所需的max与sum缓冲区
+        usedUbSize += 2 * CeilAlign(static_cast<uint32_t>(numGroups), BYTE_BLOCK / SIZE_OF_FP32) * SIZE_OF_FP32;
+    }
     // 判断weightBuf_是否能放下包括numPoints大小的数据，分情况在不同位置进行数据搬运
     bool memoryFlag = (ubSize - usedUbSize) > numPoints * numCams * numScales * numGroups * SIZE_OF_FP32;
+    // 融合softmax需要一个anchor的全部weight同时驻留在ub中
+    if (softmaxFlag && (!memoryFlag || !groupAligned)) {
+        return ge::GRAPH_FAILED;
+    }
 
     context->SetBlockDim(coreNum);
+    context->SetTilingKey(tilingKey);
 
     tiling.set_bs(bs);
     tiling.set_numFeats(numFeats);
@@ -98,6 +144,10 @@ static ge::graphStatus TilingForDeformableAggregation(gert::TilingContext* conte
     tiling.set_numGroups(numGroups);
     tiling.set_cAligned(cAligned);
     tiling.set_memoryFlag(memoryFlag);
+    tiling.set_groupAligned(groupAligned);
+    tiling.set_softmaxFlag(softmaxFlag);
+    tiling.set_slotFlag(slotFlag);
+    tiling.set_numSlots(slotFlag ? numSlots : 1);
     tiling.set_coreNum(coreNum);
 
     if (context->GetRawTilingData() == nullptr) {
@@ -151,34 +201,39 @@ public:
     {
         this->Input("mc_ms_feat")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("spatial_shape")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("scale_start_index")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("sampling_location")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("weights")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("slot_index")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Output("out")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16, ge::DT_BF16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->Attr("batch_size").AttrType(REQUIRED).Int();
         this->Attr("num_feat").AttrType(REQUIRED).Int();
@@ -188,6 +243,8 @@ public:
         this->Attr("num_cams").AttrType(REQUIRED).Int();
         this->Attr("num_scale").AttrType(REQUIRED).Int();
         this->Attr("num_groups").AttrType(REQUIRED).Int();
+        this->Attr("use_softmax").AttrType(OPTIONAL).Bool(false);
+        this->Attr("num_slots").AttrType(OPTIONAL).Int(1);
 
         this->SetInferShape(ge::InferShapeForDeformableAggregation)
             .SetInferDataType(ge::InferDataTypeForDeformableAggregation);
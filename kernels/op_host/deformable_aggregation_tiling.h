@@ -17,6 +17,10 @@ TILING_DATA_FIELD_DEF(uint32_t, numScales);
 TILING_DATA_FIELD_DEF(uint32_t, numGroups);
 TILING_DATA_FIELD_DEF(uint32_t, cAligned);
 TILING_DATA_FIELD_DEF(uint32_t, memoryFlag);
+TILING_DATA_FIELD_DEF(uint32_t, groupAligned);
+TILING_DATA_FIELD_DEF(uint32_t, softmaxFlag);
+TILING_DATA_FIELD_DEF(uint32_t, slotFlag);
+TILING_DATA_FIELD_DEF(uint32_t, numSlots);
 TILING_DATA_FIELD_DEF(uint32_t, coreNum);
 END_TILING_DATA_DEF;
 
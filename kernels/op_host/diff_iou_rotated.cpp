@@ -0,0 +1,146 @@
+#include "diff_iou_rotated_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+
+namespace {
+constexpr uint32_t BOXES_A_IDX = 0;
+constexpr uint32_t IOUS_IDX = 0;
+constexpr uint32_t GRAD_IDX = 1;
+constexpr uint32_t BATCH_SIZE_IDX = 0;
+constexpr uint32_t NUM_BOXES_IDX = 1;
+constexpr uint32_t ATTR_MODE_IDX = 0;
+constexpr uint32_t ATTR_WITH_GRAD_IDX = 1;
+constexpr uint32_t GRAD_DIM = 10;
+constexpr uint32_t SINGLE_LOOP_TASK = 256;
+constexpr int32_t MODE_MAX = 2;
+} // some const express
+
+namespace optiling {
+static ge::graphStatus TilingForDiffIouRotated(gert::TilingContext* context)
+{
+    if (context == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    auto platformInfoPtr = context->GetPlatformInfo();
+    if (platformInfoPtr == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    auto ascendplatformInfo = platform_ascendc::PlatformAscendC(platformInfoPtr);
+    auto aivNum = ascendplatformInfo.GetCoreNumAiv();
+    if (aivNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+
+    auto attrs = context->GetAttrs();
+    if (context->GetInputShape(BOXES_A_IDX) == nullptr || attrs == nullptr ||
+        attrs->GetAttrPointer<int32_t>(ATTR_MODE_IDX) == nullptr ||
+        attrs->GetAttrPointer<bool>(ATTR_WITH_GRAD_IDX) == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    int32_t mode = *attrs->GetAttrPointer<int32_t>(ATTR_MODE_IDX);
+    bool withGrad = *attrs->GetAttrPointer<bool>(ATTR_WITH_GRAD_IDX);
+    if (mode < 0 || mode > MODE_MAX) {
+        return ge::GRAPH_FAILED;
+    }
+
+    auto boxesShape = context->GetInputShape(BOXES_A_IDX)->GetStorageShape();
+    uint32_t totalTask = boxesShape.GetDim(BATCH_SIZE_IDX) * boxesShape.GetDim(NUM_BOXES_IDX);
+    uint32_t usedCoreNum = totalTask < aivNum ? totalTask : aivNum;
+    usedCoreNum = usedCoreNum == 0 ? 1 : usedCoreNum;
+    uint32_t coreTask = (totalTask + usedCoreNum - 1) / usedCoreNum;
+    uint32_t bigCoreCount = totalTask % usedCoreNum == 0 ? usedCoreNum : totalTask % usedCoreNum;
+    context->SetBlockDim(usedCoreNum);
+
+    DiffIouRotatedTilingData tilingData;
+    tilingData.set_coreTask(coreTask);
+    tilingData.set_bigCoreCount(bigCoreCount);
+    tilingData.set_singleLoopTaskCount(SINGLE_LOOP_TASK);
+    tilingData.set_mode(mode);
+    tilingData.set_withGrad(withGrad);
+
+    tilingData.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tilingData.GetDataSize());
+
+    size_t systemWorkspaceSize = ascendplatformInfo.GetLibApiWorkSpaceSize();
+    size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+    currentWorkspace[0] = systemWorkspaceSize;
+    return ge::GRAPH_SUCCESS;
+}
+} // namespace optiling
+
+namespace ge {
+static ge::graphStatus InferShapeForDiffIouRotated(gert::InferShapeContext* context)
+{
+    const gert::Shape* boxesA = context->GetInputShape(BOXES_A_IDX);
+    gert::Shape* ious = context->GetOutputShape(IOUS_IDX);
+    gert::Shape* grad = context->GetOutputShape(GRAD_IDX);
+    auto attrs = context->GetAttrs();
+    if (boxesA == nullptr || ious == nullptr || grad == nullptr || attrs == nullptr ||
+        attrs->GetAttrPointer<bool>(ATTR_WITH_GRAD_IDX) == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    int64_t batchSize = boxesA->GetDim(BATCH_SIZE_IDX);
+    int64_t numBoxes = boxesA->GetDim(NUM_BOXES_IDX);
+    bool withGrad = *attrs->GetAttrPointer<bool>(ATTR_WITH_GRAD_IDX);
+
+    *ious = {batchSize, numBoxes};
+    if (withGrad) {
+        *grad = {batchSize, numBoxes, GRAD_DIM};
+    } else {
+        *grad = {0};
+    }
+    return GRAPH_SUCCESS;
+}
+
+static ge::graphStatus InferDataTypeForDiffIouRotated(gert::InferDataTypeContext* context)
+{
+    const ge::DataType boxesDtype = context->GetInputDataType(BOXES_A_IDX);
+    context->SetOutputDataType(IOUS_IDX, boxesDtype);
+    context->SetOutputDataType(GRAD_IDX, boxesDtype);
+    return GRAPH_SUCCESS;
+}
+} // namespace ge
+
+namespace ops {
+class DiffIouRotated : public OpDef {
+public:
+    explicit DiffIouRotated(const char* name) : OpDef(name)
+    {
+        this->Input("boxes_a")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND})
+            .AutoContiguous();
+
+        this->Input("boxes_b")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND})
+            .AutoContiguous();
+
+        this->Output("ious")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+
+        this->Output("grad")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+
+        this->Attr("mode").AttrType(REQUIRED).Int();
+        this->Attr("with_grad").AttrType(REQUIRED).Bool();
+
+        this->SetInferShape(ge::InferShapeForDiffIouRotated).SetInferDataType(ge::InferDataTypeForDiffIouRotated);
+        this->AICore().SetTiling(optiling::TilingForDiffIouRotated);
+        this->AICore().AddConfig("ascend910b");
+        this->AICore().AddConfig("ascend910_93");
+    }
+};
+
+OP_ADD(DiffIouRotated);
+} // namespace ops
@@ -0,0 +1,16 @@
+#ifndef DIFF_IOU_ROTATED_TILING_H
+#define DIFF_IOU_ROTATED_TILING_H
+#include "register/tilingdata_base.h"
+
+namespace optiling {
+BEGIN_TILING_DATA_DEF(DiffIouRotatedTilingData)
+    TILING_DATA_FIELD_DEF(uint32_t, coreTask);
+    TILING_DATA_FIELD_DEF(uint32_t, bigCoreCount);
+    TILING_DATA_FIELD_DEF(uint32_t, singleLoopTaskCount);
+    TILING_DATA_FIELD_DEF(int32_t, mode);
+    TILING_DATA_FIELD_DEF(bool, withGrad);
+END_TILING_DATA_DEF;
+
+REGISTER_TILING_DATA_CLASS(DiffIouRotated, DiffIouRotatedTilingData)
+}
+#endif // DIFF_IOU_ROTATED_TILING_H
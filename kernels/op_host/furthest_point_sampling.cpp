@@ -30,6 +30,12 @@ using namespace AscendC;
 namespace optiling {
 /****************constexpr definition*****************/
 constexpr int64_t FP32_MODE = 0;
+constexpr int64_t RAGGED_MODE_FLAG = 1;
+constexpr int64_t PACKED_MODE_FLAG = 2;
+constexpr uint32_t ATTR_NUM_POINTS = 0;
+constexpr uint32_t ATTR_IS_RAGGED = 1;
+constexpr uint32_t ATTR_IS_PACKED = 2;
+constexpr size_t INPUT_POINT_COUNTS = 1;
 constexpr int64_t POINTSDIMSNUM = 3;
 
 /****************struct definition*****************/
@@ -63,7 +69,7 @@ public:
     ge::graphStatus Init();
     ge::graphStatus RunKernelTiling();
 private:
-    inline void SetTilingKeyMode(ge::DataType dType);
+    inline void SetTilingKeyMode(ge::DataType dType, bool isRagged, bool isPacked);
     inline uint64_t UbBlocksDataSpace(uint64_t data_num);
     inline uint64_t UbBlocksWorkSpace(uint64_t data_num);
     inline uint64_t UbBlocksSpace(uint64_t data_num);
@@ -88,6 +94,7 @@ private:
     uint32_t smallCoreBatch;
     uint32_t bigCoreNum;
     uint32_t repeats;
+    bool isPacked = false;
 
     ub_memory_tag ub_memory;
 
@@ -105,9 +112,12 @@ ge::graphStatus FurthestPointSamplingTiling::Init()
     if ((platformInfoPtr == nullptr) || (point_xyz_shape == nullptr) || (attrs == nullptr)) {
         return ge::GRAPH_FAILED;
     }
-    if (attrs->GetAttrPointer<uint32_t>(0) == nullptr) {
+    if ((attrs->GetAttrPointer<uint32_t>(ATTR_NUM_POINTS) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_IS_RAGGED) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_IS_PACKED) == nullptr)) {
         return ge::GRAPH_FAILED;
     }
+    this->isPacked = *(attrs->GetAttrPointer<bool>(ATTR_IS_PACKED));
 
     auto platformInfo = platform_ascendc::PlatformAscendC(platformInfoPtr);
 
@@ -115,8 +125,10 @@ ge::graphStatus FurthestPointSamplingTiling::Init()
         return ge::GRAPH_FAILED;
     }
 
-    // Set Tiling Key
-    SetTilingKeyMode(TilingContext->GetInputDesc(0)->GetDataType());
+    // Set Tiling Key, ragged batch reads the valid point count of each sample from point_counts,
+    // packed batch reads the offsets of each sample from point_counts
+    SetTilingKeyMode(TilingContext->GetInputDesc(0)->GetDataType(), *(attrs->GetAttrPointer<bool>(ATTR_IS_RAGGED)),
+        this->isPacked);
 
     // get core num
     this->coreNum = platformInfo.GetCoreNumAiv();
@@ -133,7 +145,18 @@ ge::graphStatus FurthestPointSamplingTiling::Init()
     }
     this->batch     = point_xyz_shape->GetStorageShape().GetDim(0);
     this->N         = point_xyz_shape->GetStorageShape().GetDim(2);
-    this->numPoints = *(attrs->GetAttrPointer<uint32_t>(0));
+    if (this->isPacked) {
+        // point_xyz is [1, 3, total], total bounds the point count of every sample
+        const gert::StorageShape *ptr_shape = TilingContext->GetOptionalInputShape(INPUT_POINT_COUNTS);
+        if ((ptr_shape == nullptr) || (ptr_shape->GetStorageShape().GetDim(0) < 1)) {
+            return ge::GRAPH_FAILED;
+        }
+        this->batch = ptr_shape->GetStorageShape().GetDim(0) - 1;
+    }
+    if ((this->batch == 0) || (this->N == 0)) {
+        return ge::GRAPH_FAILED;
+    }
+    this->numPoints = *(attrs->GetAttrPointer<uint32_t>(ATTR_NUM_POINTS));
 
     // get the capability on UB
     max_data_num = FindMaxDataBlock(); // pieces, repeats, workSize calc in this func
@@ -163,7 +186,8 @@ ge::graphStatus FurthestPointSamplingTiling::Init()
 ge::graphStatus FurthestPointSamplingTiling::RunKernelTiling()
 {
     size_t sysWorkspaceSize = 16 * 1024 * 1024; // Alloc 16M workspace
-    size_t userWorkSpaceSize = this->batch * this->N * this->point_dtype_size; // NearestDist needs a space to be moved out
+    // NearestDist of split data needs a space to be moved out, it is initialized on chip and never read from host
+    size_t userWorkSpaceSize = (this->isPacked ? 1 : this->batch) * this->N * this->point_dtype_size;
     size_t *currentWorkSpace = TilingContext->GetWorkspaceSizes(1);
     if (currentWorkSpace == nullptr) {
         return ge::GRAPH_FAILED;
@@ -240,15 +264,16 @@ inline uint64_t FurthestPointSamplingTiling::FindMaxDataBlock()
     return max_data_num;
 }
 
-inline void FurthestPointSamplingTiling::SetTilingKeyMode(ge::DataType dType)
+inline void FurthestPointSamplingTiling::SetTilingKeyMode(ge::DataType dType, bool isRagged, bool isPacked)
 {
+    int64_t raggedFlag = isPacked ? PACKED_MODE_FLAG : (isRagged ? RAGGED_MODE_FLAG : 0);
     switch (dType) {
         case ge::DT_FLOAT:
-            TilingContext->SetTilingKey(FP32_MODE);
+            TilingContext->SetTilingKey(FP32_MODE + raggedFlag);
             this->point_dtype_size = 4; // 4: float32, 4 bytes
             break;
         default:
-            TilingContext->SetTilingKey(FP32_MODE);
+            TilingContext->SetTilingKey(FP32_MODE + raggedFlag);
             this->point_dtype_size = 4; // 4: float32, 4 bytes
             break;
     }
@@ -289,7 +314,9 @@ static ge::graphStatus TilingFurthestPointSampling(gert::TilingContext* context)
         return ge::GRAPH_FAILED;
     }
 
-    tilingObject.Init();
+    if (tilingObject.Init() != ge::GRAPH_SUCCESS) {
+        return ge::GRAPH_FAILED;
+    }
     return tilingObject.RunKernelTiling();
 }
 }
@@ -311,8 +338,15 @@ static ge::graphStatus InfershapeForFurthestPointSampling(gert::InferShapeContex
         return ge::GRAPH_FAILED;
     }
     uint32_t batch      = point_xyz_shape->GetDim(0);
-    uint32_t N          = point_xyz_shape->GetDim(2);
     uint32_t num_points = *(attrs->GetAttrPointer<int32_t>(0));
+    const bool *is_packed = attrs->GetAttrPointer<bool>(optiling::ATTR_IS_PACKED);
+    if ((is_packed != nullptr) && *is_packed) {
+        const gert::Shape *ptr_shape = context->GetOptionalInputShape(optiling::INPUT_POINT_COUNTS);
+        if ((ptr_shape == nullptr) || (ptr_shape->GetDim(0) < 1)) {
+            return ge::GRAPH_FAILED;
+        }
+        batch = ptr_shape->GetDim(0) - 1;
+    }
 
     index_shape->SetDimNum(2);
     index_shape->SetDim(0, batch);
@@ -338,9 +372,9 @@ public:
             .DataType({ge::DT_FLOAT})
             .Format({ge::FORMAT_ND})
             .UnknownShapeFormat({ge::FORMAT_ND});
-        this->Input("nearest_temp")
-            .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
+        this->Input("point_counts")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_INT32})
             .Format({ge::FORMAT_ND})
             .UnknownShapeFormat({ge::FORMAT_ND});
         this->Output("index")
@@ -351,6 +385,12 @@ public:
         this->Attr("num_points")
             .AttrType(REQUIRED)
             .Int();
+        this->Attr("is_ragged")
+            .AttrType(OPTIONAL)
+            .Bool(false);
+        this->Attr("is_packed")
+            .AttrType(OPTIONAL)
+            .Bool(false);
 
         this->SetInferShape(ge::InfershapeForFurthestPointSampling)
             .SetInferDataType(ge::InferDataTypeForFurthestPointSampling);
@@ -5,6 +5,21 @@
 #include "knn_tiling.h"
 #include "common.h"
 
+namespace {
+constexpr uint32_t ATTR_IS_FROM_KNN = 0;
+constexpr uint32_t ATTR_K = 1;
+constexpr uint32_t ATTR_WITH_SQRT = 2;
+constexpr uint32_t ATTR_USE_GRID = 3;
+constexpr uint32_t ATTR_GRID_X_NUM = 4;
+constexpr uint32_t ATTR_GRID_Y_NUM = 5;
+constexpr uint32_t ATTR_GRID_LOW_X = 6;
+constexpr uint32_t ATTR_GRID_LOW_Y = 7;
+constexpr uint32_t ATTR_CELL_SIZE = 8;
+constexpr size_t INPUT_GRID_BOUNDS = 3;
+constexpr uint64_t TILING_KEY_FLOAT = 0;
+constexpr uint64_t TILING_KEY_HALF = 1;
+} // namespace
+
 namespace optiling {
 /****************class impl*****************/
 static ge::graphStatus TilingForKnn(gert::TilingContext *context)
@@ -26,15 +41,27 @@ static ge::graphStatus TilingForKnn(gert::TilingContext *context)
         (context->GetInputDesc(0) == nullptr)) {
         return ge::GRAPH_FAILED;
     }
-    if (attr->GetAttrPointer<uint32_t>(0) == nullptr) {
+    if ((attr->GetAttrPointer<bool>(ATTR_IS_FROM_KNN) == nullptr) || (attr->GetAttrPointer<int32_t>(ATTR_K) == nullptr) ||
+        (attr->GetAttrPointer<bool>(ATTR_WITH_SQRT) == nullptr) || (attr->GetAttrPointer<bool>(ATTR_USE_GRID) == nullptr) ||
+        (attr->GetAttrPointer<int32_t>(ATTR_GRID_X_NUM) == nullptr) ||
+        (attr->GetAttrPointer<int32_t>(ATTR_GRID_Y_NUM) == nullptr) ||
+        (attr->GetAttrPointer<float>(ATTR_GRID_LOW_X) == nullptr) ||
+        (attr->GetAttrPointer<float>(ATTR_GRID_LOW_Y) == nullptr) ||
+        (attr->GetAttrPointer<float>(ATTR_CELL_SIZE) == nullptr)) {
         return ge::GRAPH_FAILED;
     }
     auto platformInfo = platform_ascendc::PlatformAscendC(platformInfoPtr);
     batch = centerXyzShape->GetStorageShape().GetDim(0);
     nPoint = centerXyzShape->GetStorageShape().GetDim(1);
     nSource = xyzShape->GetStorageShape().GetDim(2);
-    isFromKnn = *attr->GetAttrPointer<bool>(0);
-    k = *attr->GetAttrPointer<int32_t>(1);
+    isFromKnn = *attr->GetAttrPointer<bool>(ATTR_IS_FROM_KNN);
+    k = *attr->GetAttrPointer<int32_t>(ATTR_K);
+    bool useGrid = *attr->GetAttrPointer<bool>(ATTR_USE_GRID);
+    if (useGrid && (context->GetInputShape(2) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    context->SetTilingKey(context->GetInputDesc(0)->GetDataType() == ge::DT_FLOAT16 ? TILING_KEY_HALF :
+                                                                                      TILING_KEY_FLOAT);
     coreNum = platformInfo.GetCoreNumAiv();
     if (coreNum == 0) {
         return ge::GRAPH_FAILED;
@@ -54,6 +81,16 @@ static ge::graphStatus TilingForKnn(gert::TilingContext *context)
     TilingData.set_isFromKnn(isFromKnn);
     TilingData.set_coreNum(coreNum);
     TilingData.set_k(k);
+    TilingData.set_withSqrt(*attr->GetAttrPointer<bool>(ATTR_WITH_SQRT));
+    // 网格模式下源点已按BEV网格排序，cell_start记录每个网格在排序后源点中的起始位置
+    TilingData.set_useGrid(useGrid);
+    TilingData.set_gridXNum(static_cast<uint32_t>(*attr->GetAttrPointer<int32_t>(ATTR_GRID_X_NUM)));
+    TilingData.set_gridYNum(static_cast<uint32_t>(*attr->GetAttrPointer<int32_t>(ATTR_GRID_Y_NUM)));
+    TilingData.set_gridLowX(*attr->GetAttrPointer<float>(ATTR_GRID_LOW_X));
+    TilingData.set_gridLowY(*attr->GetAttrPointer<float>(ATTR_GRID_LOW_Y));
+    TilingData.set_cellSize(*attr->GetAttrPointer<float>(ATTR_CELL_SIZE));
+    // 传入grid_bounds时网格下界与网格大小由kernel从device读取，host无需同步
+    TilingData.set_hasGridBounds(context->GetOptionalInputShape(INPUT_GRID_BOUNDS) != nullptr);
     context->SetBlockDim(coreNum);
     if (context->GetRawTilingData() == nullptr) {
         return ge::GRAPH_FAILED;
@@ -82,7 +119,7 @@ static ge::graphStatus InfershapeForKnn(gert::InferShapeContext *context)
     }
     batch = centerXyzShape->GetDim(0);
     nPoint = centerXyzShape->GetDim(1);
-    const int32_t k = *attr->GetAttrPointer<int32_t>(1);
+    const int32_t k = *attr->GetAttrPointer<int32_t>(ATTR_K);
 
     distShape->SetDimNum(3);
     distShape->SetDim(0, batch);
@@ -98,7 +135,7 @@ static ge::graphStatus InfershapeForKnn(gert::InferShapeContext *context)
 
 static ge::graphStatus InferDataTypeForKnn(gert::InferDataTypeContext *context)
 {
-    context->SetOutputDataType(0, ge::DT_FLOAT);
+    context->SetOutputDataType(0, context->GetInputDataType(0));
     context->SetOutputDataType(1, ge::DT_INT32);
     return GRAPH_SUCCESS;
 }
@@ -111,30 +148,61 @@ public:
     {
         this->Input("xyz")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("center_xyz")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("cell_start")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
+        this->Input("grid_bounds")
+            .ParamType(OPTIONAL)
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
         this->Attr("is_from_knn")
             .AttrType(REQUIRED)
             .Bool();
         this->Attr("k")
             .AttrType(REQUIRED)
             .Int();
+        this->Attr("with_sqrt")
+            .AttrType(OPTIONAL)
+            .Bool(false);
+        this->Attr("use_grid")
+            .AttrType(OPTIONAL)
+            .Bool(false);
+        this->Attr("grid_x_num")
+            .AttrType(OPTIONAL)
+            .Int(1);
+        this->Attr("grid_y_num")
+            .AttrType(OPTIONAL)
+            .Int(1);
+        this->Attr("grid_low_x")
+            .AttrType(OPTIONAL)
+            .Float(0.0);
+        this->Attr("grid_low_y")
+            .AttrType(OPTIONAL)
+            .Float(0.0);
+        this->Attr("cell_size")
+            .AttrType(OPTIONAL)
+            .Float(1.0);
         this->Output("dist")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
         this->Output("idx")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
+            .DataType({ge::DT_INT32, ge::DT_INT32})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND, ge::FORMAT_ND});
         this->SetInferShape(ge::InfershapeForKnn)
             .SetInferDataType(ge::InferDataTypeForKnn);
         this->AICore().SetTiling(optiling::TilingForKnn);
@@ -18,6 +18,14 @@ BEGIN_TILING_DATA_DEF(KnnTilingData)
     TILING_DATA_FIELD_DEF(uint32_t, coreNum);
     TILING_DATA_FIELD_DEF(bool, isFromKnn);
     TILING_DATA_FIELD_DEF(int32_t, k);
+    TILING_DATA_FIELD_DEF(bool, withSqrt);
+    TILING_DATA_FIELD_DEF(bool, useGrid);
+    TILING_DATA_FIELD_DEF(uint32_t, gridXNum);
+    TILING_DATA_FIELD_DEF(uint32_t, gridYNum);
+    TILING_DATA_FIELD_DEF(float, gridLowX);
+    TILING_DATA_FIELD_DEF(float, gridLowY);
+    TILING_DATA_FIELD_DEF(float, cellSize);
+    TILING_DATA_FIELD_DEF(bool, hasGridBounds);
 END_TILING_DATA_DEF;
 
 REGISTER_TILING_DATA_CLASS(Knn, KnnTilingData)
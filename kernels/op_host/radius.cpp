@@ -11,9 +11,8 @@ namespace {
     constexpr uint32_t Y_INDEX = 1;
     constexpr uint32_t PTR_X_INDEX = 2;
     constexpr uint32_t PTR_Y_INDEX = 3;
-    constexpr uint32_t OUT_TEMP_INDEX = 0;
-    constexpr uint32_t OUT_FINAL_INDEX = 1;
-    constexpr uint32_t NUM_NEIGHBORS_INDEX = 2;
+    constexpr uint32_t OUT_INDEX = 0;
+    constexpr uint32_t NUM_NEIGHBORS_INDEX = 1;
     constexpr uint32_t COORDINATE_DIM = 2; // two-dimensional coordinates
     constexpr uint32_t BLOCK_BYTES = 32; // Single Block requires 32B alignment.
     constexpr uint32_t BUFFER_SIZE_32KB = 32768;
@@ -112,34 +111,24 @@ static ge::graphStatus InfershapeForRadius(gert::InferShapeContext *context)
     const gert::Shape *yShape = context->GetInputShape(Y_INDEX); // [2, num_points_x]
     const gert::Shape *ptrXShape = context->GetInputShape(PTR_X_INDEX); // [batch_size + 1]
     
-    gert::Shape *outTempShape = context->GetOutputShape(OUT_TEMP_INDEX); // [2, num_points_y * max_num_neighbors]
-    gert::Shape *outFinalShape = context->GetOutputShape(OUT_FINAL_INDEX); // [2, num_points_y * max_num_neighbors]
+    gert::Shape *outShape = context->GetOutputShape(OUT_INDEX); // [2, num_points_y * max_num_neighbors]
     gert::Shape *numNeighborsShape = context->GetOutputShape(NUM_NEIGHBORS_INDEX); // [8]
     const gert::RuntimeAttrs *attr = context->GetAttrs();
 
     CHECK_NULLPTR(xShape);
     CHECK_NULLPTR(yShape);
     CHECK_NULLPTR(ptrXShape);
-    CHECK_NULLPTR(outTempShape);
-    CHECK_NULLPTR(outFinalShape);
+    CHECK_NULLPTR(outShape);
     CHECK_NULLPTR(numNeighborsShape);
     CHECK_NULLPTR(attr);
 
-    uint32_t numPointsX = xShape->GetDim(1);
     uint32_t numPointsY = yShape->GetDim(1);
-    uint32_t outtmpdim0 = outTempShape->GetDim(0);
-    uint32_t outfinaldim0 = outFinalShape->GetDim(0);
-    uint32_t batchSize = ptrXShape->GetDim(0) - 1;
     const int32_t maxNumNeighbors = *attr->GetAttrPointer<int32_t>(1);
 
-    outTempShape->SetDimNum(outtmpdim0);
-    outTempShape->SetDim(0, COORDINATE_DIM);
-    outTempShape->SetDim(1, numPointsY * maxNumNeighbors);
+    outShape->SetDimNum(COORDINATE_DIM);
+    outShape->SetDim(0, COORDINATE_DIM);
+    outShape->SetDim(1, numPointsY * maxNumNeighbors);
 
-    outFinalShape->SetDimNum(outfinaldim0);
-    outFinalShape->SetDim(0, COORDINATE_DIM);
-    outFinalShape->SetDim(1, numPointsY * maxNumNeighbors);
-    
     numNeighborsShape->SetDimNum(1);
     numNeighborsShape->SetDim(0, ALIGN_NUM);
     return GRAPH_SUCCESS;
@@ -147,8 +136,7 @@ static ge::graphStatus InfershapeForRadius(gert::InferShapeContext *context)
 
 static ge::graphStatus InferDataTypeForRadius(gert::InferDataTypeContext *context)
 {
-    context->SetOutputDataType(OUT_TEMP_INDEX, ge::DT_INT32);
-    context->SetOutputDataType(OUT_FINAL_INDEX, ge::DT_INT32);
+    context->SetOutputDataType(OUT_INDEX, ge::DT_INT32);
     context->SetOutputDataType(NUM_NEIGHBORS_INDEX, ge::DT_INT32);
     return GRAPH_SUCCESS;
 }
@@ -179,12 +167,7 @@ public:
             .DataType({ge::DT_INT32})
             .Format({ge::FORMAT_ND})
             .UnknownShapeFormat({ge::FORMAT_ND});
-        this->Output("out_temp")
-            .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND})
-            .UnknownShapeFormat({ge::FORMAT_ND});
-        this->Output("out_final")
+        this->Output("out")
             .ParamType(REQUIRED)
             .DataType({ge::DT_INT32})
             .Format({ge::FORMAT_ND})
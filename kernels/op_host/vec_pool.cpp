@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+
+#include "vec_pool_tiling.h"
+#include "common.h"
+
+namespace {
+constexpr uint32_t INPUT_SORTED_XYZ = 0;
+constexpr uint32_t INPUT_SUPPORT_FEATURES = 3;
+constexpr uint32_t INPUT_NEW_XYZ = 4;
+constexpr uint32_t OUTPUT_NEW_FEATURES = 0;
+constexpr uint32_t OUTPUT_NEW_LOCAL_XYZ = 1;
+constexpr uint32_t OUTPUT_POINT_CNT_OF_GRID = 2;
+constexpr uint32_t OUTPUT_GROUPED_IDXS = 3;
+constexpr uint32_t OUTPUT_SAMPLE_CNT = 4;
+constexpr uint32_t ATTR_NUM_GRID = 0;
+constexpr uint32_t ATTR_MAX_DIST = 1;
+constexpr uint32_t ATTR_NUM_C_OUT = 2;
+constexpr uint32_t ATTR_NSAMPLE = 3;
+constexpr uint32_t ATTR_NEIGHBOR_TYPE = 4;
+constexpr uint32_t ATTR_POOLING_TYPE = 5;
+constexpr uint32_t ATTR_USE_XYZ = 6;
+constexpr uint32_t ATTR_COUNT_ONLY = 7;
+constexpr uint32_t ATTR_NUM_MAX_SUM_POINTS = 8;
+constexpr uint32_t ATTR_HASH_CELLS = 9;
+constexpr uint32_t ATTR_CELL_SIZE = 10;
+constexpr uint32_t ATTR_LOWER_X = 11;
+constexpr uint32_t ATTR_LOWER_Y = 12;
+constexpr uint32_t ATTR_LOWER_Z = 13;
+constexpr uint32_t POINT_DIM = 3;
+constexpr uint32_t GROUP_DIM = 3;
+constexpr uint32_t BLOCK_SIZE = 32;
+constexpr uint32_t FLOAT_ALIGN = BLOCK_SIZE / sizeof(float);
+constexpr uint32_t COMPARE_ALIGN = 64; // CompareScalar requires 256B alignment
+constexpr uint32_t MAX_COMP_NUM = 2048;
+constexpr uint32_t ROW_NUM = 16;
+constexpr uint32_t GROUP_NUM = 256;
+constexpr uint64_t RESERVED_UB_SIZE = 8 * 1024;
+} // namespace
+
+namespace optiling {
+static ge::graphStatus TilingForVecPool(gert::TilingContext* context)
+{
+    if (context == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    const gert::StorageShape* sortedXyzShape = context->GetInputShape(INPUT_SORTED_XYZ);
+    const gert::StorageShape* featuresShape = context->GetInputShape(INPUT_SUPPORT_FEATURES);
+    const gert::StorageShape* newXyzShape = context->GetInputShape(INPUT_NEW_XYZ);
+    const gert::RuntimeAttrs* attrs = context->GetAttrs();
+    auto platformInfoPtr = context->GetPlatformInfo();
+    if ((sortedXyzShape == nullptr) || (featuresShape == nullptr) || (newXyzShape == nullptr) ||
+        (attrs == nullptr) || (platformInfoPtr == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    const auto* numGridPtr = attrs->GetListInt(ATTR_NUM_GRID);
+    const auto* hashCellsPtr = attrs->GetListInt(ATTR_HASH_CELLS);
+    if ((numGridPtr == nullptr) || (hashCellsPtr == nullptr) || (numGridPtr->GetSize() != POINT_DIM) ||
+        (hashCellsPtr->GetSize() != POINT_DIM) || (attrs->GetAttrPointer<float>(ATTR_MAX_DIST) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_NUM_C_OUT) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_NSAMPLE) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_NEIGHBOR_TYPE) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_POOLING_TYPE) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_USE_XYZ) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_COUNT_ONLY) == nullptr) ||
+        (attrs->GetAttrPointer<float>(ATTR_CELL_SIZE) == nullptr) ||
+        (attrs->GetAttrPointer<float>(ATTR_LOWER_X) == nullptr) ||
+        (attrs->GetAttrPointer<float>(ATTR_LOWER_Y) == nullptr) ||
+        (attrs->GetAttrPointer<float>(ATTR_LOWER_Z) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    auto platformInfo = platform_ascendc::PlatformAscendC(platformInfoPtr);
+    uint32_t coreNum = platformInfo.GetCoreNumAiv();
+    if (coreNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+    uint64_t ubSize;
+    platformInfo.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+
+    // sorted_xyz: [3, N], support_features: [N, C_in], new_xyz: [M, 3]
+    uint32_t nSupport = sortedXyzShape->GetStorageShape().GetDim(1);
+    uint32_t cIn = featuresShape->GetStorageShape().GetDim(1);
+    uint32_t nCenter = newXyzShape->GetStorageShape().GetDim(0);
+    const int64_t* numGrid = numGridPtr->GetData();
+    const int64_t* hashCells = hashCellsPtr->GetData();
+    uint32_t totalGrids = static_cast<uint32_t>(numGrid[0] * numGrid[1] * numGrid[2]);
+    int32_t numCOut = *attrs->GetAttrPointer<int32_t>(ATTR_NUM_C_OUT);
+    float maxDist = *attrs->GetAttrPointer<float>(ATTR_MAX_DIST);
+    if ((totalGrids == 0) || (numCOut <= 0) || (maxDist <= 0.0f)) {
+        return ge::GRAPH_FAILED;
+    }
+    uint32_t cEach = static_cast<uint32_t>(numCOut) / totalGrids;
+    if ((cEach == 0) || (cIn % cEach != 0)) {
+        return ge::GRAPH_FAILED;
+    }
+    uint32_t cInAligned = CeilAlign(cIn, FLOAT_ALIGN);
+    uint32_t cEachAligned = CeilAlign(cEach, FLOAT_ALIGN);
+
+    // 每个中心点的逐格子累加区、折叠区、特征行缓冲、局部坐标和计数常驻UB，剩余UB按每个源点所需空间划分单次计算的源点数
+    uint64_t accBytes = static_cast<uint64_t>(totalGrids) * cInAligned * sizeof(float);
+    uint64_t foldBytes = cEach == cIn ? 0 : static_cast<uint64_t>(totalGrids) * cEachAligned * sizeof(float);
+    uint64_t rowBytes = static_cast<uint64_t>(ROW_NUM) * cInAligned * sizeof(float) + ROW_NUM * sizeof(int32_t);
+    uint64_t blockSize = BLOCK_SIZE;
+    uint64_t gridBytes = CeilAlign(static_cast<uint64_t>(totalGrids) * POINT_DIM * sizeof(float), blockSize) +
+                         CeilAlign(static_cast<uint64_t>(totalGrids) * sizeof(int32_t), blockSize);
+    uint64_t groupBytes = static_cast<uint64_t>(GROUP_NUM) * GROUP_DIM * sizeof(int32_t);
+    uint64_t fixedBytes = RESERVED_UB_SIZE + accBytes + foldBytes + rowBytes + gridBytes + groupBytes;
+    if (fixedBytes >= ubSize) {
+        return ge::GRAPH_FAILED;
+    }
+    // xyz + local xyz + dist + tmp(fp32) + sorted idx + mask
+    uint64_t perPointBytes = POINT_DIM * sizeof(float) * 2 + sizeof(float) * 2 + sizeof(int32_t) + 1;
+    uint32_t compNum = FloorAlign(std::min(static_cast<uint64_t>(MAX_COMP_NUM), (ubSize - fixedBytes) / perPointBytes),
+        static_cast<uint64_t>(COMPARE_ALIGN));
+    if (compNum == 0) {
+        return ge::GRAPH_FAILED;
+    }
+
+    uint32_t coreTaskNum = DivCeil(nCenter, coreNum);
+    uint32_t useCoreNum = coreTaskNum == 0 ? 1 : DivCeil(nCenter, coreTaskNum);
+
+    VecPoolTilingData tiling;
+    tiling.set_nSupport(nSupport);
+    tiling.set_nCenter(nCenter);
+    tiling.set_cIn(cIn);
+    tiling.set_cInAligned(cInAligned);
+    tiling.set_cEach(cEach);
+    tiling.set_cEachAligned(cEachAligned);
+    tiling.set_gridX(static_cast<uint32_t>(numGrid[0]));
+    tiling.set_gridY(static_cast<uint32_t>(numGrid[1]));
+    tiling.set_gridZ(static_cast<uint32_t>(numGrid[2]));
+    tiling.set_totalGrids(totalGrids);
+    tiling.set_maxDist(maxDist);
+    tiling.set_gridSizeX(maxDist * 2 / numGrid[0]);
+    tiling.set_gridSizeY(maxDist * 2 / numGrid[1]);
+    tiling.set_gridSizeZ(maxDist * 2 / numGrid[2]);
+    tiling.set_nsample(*attrs->GetAttrPointer<int32_t>(ATTR_NSAMPLE));
+    tiling.set_neighborType(static_cast<uint32_t>(*attrs->GetAttrPointer<int32_t>(ATTR_NEIGHBOR_TYPE)));
+    tiling.set_poolingType(static_cast<uint32_t>(*attrs->GetAttrPointer<int32_t>(ATTR_POOLING_TYPE)));
+    tiling.set_useXyz(*attrs->GetAttrPointer<bool>(ATTR_USE_XYZ));
+    tiling.set_countOnly(*attrs->GetAttrPointer<bool>(ATTR_COUNT_ONLY));
+    tiling.set_cellSize(*attrs->GetAttrPointer<float>(ATTR_CELL_SIZE));
+    tiling.set_lowerX(*attrs->GetAttrPointer<float>(ATTR_LOWER_X));
+    tiling.set_lowerY(*attrs->GetAttrPointer<float>(ATTR_LOWER_Y));
+    tiling.set_lowerZ(*attrs->GetAttrPointer<float>(ATTR_LOWER_Z));
+    tiling.set_cellsX(static_cast<uint32_t>(hashCells[0]));
+    tiling.set_cellsY(static_cast<uint32_t>(hashCells[1]));
+    tiling.set_cellsZ(static_cast<uint32_t>(hashCells[2]));
+    tiling.set_compNum(compNum);
+    tiling.set_rowNum(ROW_NUM);
+    tiling.set_groupNum(GROUP_NUM);
+    tiling.set_coreTaskNum(coreTaskNum);
+    tiling.set_useCoreNum(useCoreNum);
+    context->SetBlockDim(useCoreNum);
+
+    if (context->GetRawTilingData() == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+    size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+    if (currentWorkspace == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    currentWorkspace[0] = 0;
+    return ge::GRAPH_SUCCESS;
+}
+} // namespace optiling
+
+namespace ge {
+static ge::graphStatus InferShapeForVecPool(gert::InferShapeContext* context)
+{
+    const gert::Shape* newXyzShape = context->GetInputShape(INPUT_NEW_XYZ);
+    const gert::RuntimeAttrs* attrs = context->GetAttrs();
+    gert::Shape* featuresShape = context->GetOutputShape(OUTPUT_NEW_FEATURES);
+    gert::Shape* localXyzShape = context->GetOutputShape(OUTPUT_NEW_LOCAL_XYZ);
+    gert::Shape* cntShape = context->GetOutputShape(OUTPUT_POINT_CNT_OF_GRID);
+    gert::Shape* groupedShape = context->GetOutputShape(OUTPUT_GROUPED_IDXS);
+    gert::Shape* sampleCntShape = context->GetOutputShape(OUTPUT_SAMPLE_CNT);
+    if ((newXyzShape == nullptr) || (attrs == nullptr) || (featuresShape == nullptr) || (localXyzShape == nullptr) ||
+        (cntShape == nullptr) || (groupedShape == nullptr) || (sampleCntShape == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    const auto* numGridPtr = attrs->GetListInt(ATTR_NUM_GRID);
+    if ((numGridPtr == nullptr) || (numGridPtr->GetSize() != POINT_DIM) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_NUM_C_OUT) == nullptr) ||
+        (attrs->GetAttrPointer<bool>(ATTR_COUNT_ONLY) == nullptr) ||
+        (attrs->GetAttrPointer<int32_t>(ATTR_NUM_MAX_SUM_POINTS) == nullptr)) {
+        return ge::GRAPH_FAILED;
+    }
+    const int64_t* numGrid = numGridPtr->GetData();
+    int64_t totalGrids = numGrid[0] * numGrid[1] * numGrid[2];
+    int64_t nCenter = newXyzShape->GetDim(0);
+    *sampleCntShape = {nCenter};
+    // 计数模式只输出每个中心点的采样数
+    if (*attrs->GetAttrPointer<bool>(ATTR_COUNT_ONLY)) {
+        *featuresShape = {0};
+        *localXyzShape = {0};
+        *cntShape = {0};
+        *groupedShape = {0};
+        return GRAPH_SUCCESS;
+    }
+    *featuresShape = {nCenter, *attrs->GetAttrPointer<int32_t>(ATTR_NUM_C_OUT)};
+    *localXyzShape = {nCenter, totalGrids * POINT_DIM};
+    *cntShape = {nCenter, totalGrids};
+    *groupedShape = {*attrs->GetAttrPointer<int32_t>(ATTR_NUM_MAX_SUM_POINTS), GROUP_DIM};
+    return GRAPH_SUCCESS;
+}
+
+static ge::graphStatus InferDataTypeForVecPool(gert::InferDataTypeContext* context)
+{
+    context->SetOutputDataType(OUTPUT_NEW_FEATURES, context->GetInputDataType(INPUT_SUPPORT_FEATURES));
+    context->SetOutputDataType(OUTPUT_NEW_LOCAL_XYZ, context->GetInputDataType(INPUT_NEW_XYZ));
+    context->SetOutputDataType(OUTPUT_POINT_CNT_OF_GRID, ge::DT_INT32);
+    context->SetOutputDataType(OUTPUT_GROUPED_IDXS, ge::DT_INT32);
+    context->SetOutputDataType(OUTPUT_SAMPLE_CNT, ge::DT_INT32);
+    return GRAPH_SUCCESS;
+}
+} // namespace ge
+
+namespace ops {
+class VecPool : public OpDef {
+public:
+    explicit VecPool(const char* name) : OpDef(name)
+    {
+        this->Input("sorted_xyz")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("sorted_idx")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("cell_start")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("support_features")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("new_xyz")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("center_batch")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Input("group_offset")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Attr("num_grid").ListInt();
+        this->Attr("max_neighbour_distance").AttrType(REQUIRED).Float();
+        this->Attr("num_c_out").AttrType(REQUIRED).Int();
+        this->Attr("nsample").AttrType(REQUIRED).Int();
+        this->Attr("neighbor_type").AttrType(REQUIRED).Int();
+        this->Attr("pooling_type").AttrType(REQUIRED).Int();
+        this->Attr("use_xyz").AttrType(REQUIRED).Bool();
+        this->Attr("count_only").AttrType(REQUIRED).Bool();
+        this->Attr("num_max_sum_points").AttrType(REQUIRED).Int();
+        this->Attr("hash_cells").ListInt();
+        this->Attr("cell_size").AttrType(REQUIRED).Float();
+        this->Attr("lower_x").AttrType(REQUIRED).Float();
+        this->Attr("lower_y").AttrType(REQUIRED).Float();
+        this->Attr("lower_z").AttrType(REQUIRED).Float();
+        this->Output("new_features")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("new_local_xyz")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("point_cnt_of_grid")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("grouped_idxs")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->Output("sample_cnt")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND})
+            .UnknownShapeFormat({ge::FORMAT_ND});
+        this->SetInferShape(ge::InferShapeForVecPool)
+            .SetInferDataType(ge::InferDataTypeForVecPool);
+        this->AICore().SetTiling(optiling::TilingForVecPool);
+        OpAICoreConfig aicore_config;
+        aicore_config.DynamicCompileStaticFlag(true)
+            .DynamicFormatFlag(true)
+            .DynamicRankSupportFlag(true)
+            .DynamicShapeSupportFlag(true);
+        this->AICore().AddConfig("ascend910b", aicore_config);
+        this->AICore().AddConfig("ascend910_93", aicore_config);
+    }
+};
+
+OP_ADD(VecPool);
+} // namespace ops
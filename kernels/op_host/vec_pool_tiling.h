@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+#ifndef VEC_POOL_TILING_H
+#define VEC_POOL_TILING_H
+
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+#include "tiling/tiling_api.h"
+#include "register/tilingdata_base.h"
+
+namespace optiling {
+BEGIN_TILING_DATA_DEF(VecPoolTilingData)
+    TILING_DATA_FIELD_DEF(uint32_t, nSupport);
+    TILING_DATA_FIELD_DEF(uint32_t, nCenter);
+    TILING_DATA_FIELD_DEF(uint32_t, cIn);
+    TILING_DATA_FIELD_DEF(uint32_t, cInAligned);
+    TILING_DATA_FIELD_DEF(uint32_t, cEach);
+    TILING_DATA_FIELD_DEF(uint32_t, cEachAligned);
+    TILING_DATA_FIELD_DEF(uint32_t, gridX);
+    TILING_DATA_FIELD_DEF(uint32_t, gridY);
+    TILING_DATA_FIELD_DEF(uint32_t, gridZ);
+    TILING_DATA_FIELD_DEF(uint32_t, totalGrids);
+    TILING_DATA_FIELD_DEF(float, maxDist);
+    TILING_DATA_FIELD_DEF(float, gridSizeX);
+    TILING_DATA_FIELD_DEF(float, gridSizeY);
+    TILING_DATA_FIELD_DEF(float, gridSizeZ);
+    TILING_DATA_FIELD_DEF(int32_t, nsample);
+    TILING_DATA_FIELD_DEF(uint32_t, neighborType);
+    TILING_DATA_FIELD_DEF(uint32_t, poolingType);
+    TILING_DATA_FIELD_DEF(bool, useXyz);
+    TILING_DATA_FIELD_DEF(bool, countOnly);
+    TILING_DATA_FIELD_DEF(float, cellSize);
+    TILING_DATA_FIELD_DEF(float, lowerX);
+    TILING_DATA_FIELD_DEF(float, lowerY);
+    TILING_DATA_FIELD_DEF(float, lowerZ);
+    TILING_DATA_FIELD_DEF(uint32_t, cellsX);
+    TILING_DATA_FIELD_DEF(uint32_t, cellsY);
+    TILING_DATA_FIELD_DEF(uint32_t, cellsZ);
+    TILING_DATA_FIELD_DEF(uint32_t, compNum);
+    TILING_DATA_FIELD_DEF(uint32_t, rowNum);
+    TILING_DATA_FIELD_DEF(uint32_t, groupNum);
+    TILING_DATA_FIELD_DEF(uint32_t, coreTaskNum);
+    TILING_DATA_FIELD_DEF(uint32_t, useCoreNum);
+END_TILING_DATA_DEF;
+
+REGISTER_TILING_DATA_CLASS(VecPool, VecPoolTilingData)
+}
+
+#endif // VEC_POOL_TILING_H
@@ -6,12 +6,14 @@ Copyright (c) Huawei Technologies Co., Ltd. 2023-2024. All rights reserved.
 #include "kernel_utils.h"
 using namespace AscendC;
 constexpr uint32_t BUFFER_NUM = 1;
+constexpr uint32_t AGGREGATE_AVG = 1;
+constexpr uint32_t AGGREGATE_MAX = 2;
 
 template <typename T>
 class AssignScoreWithk {
 public:
     __aicore__ inline AssignScoreWithk(GM_ADDR points, GM_ADDR centers, GM_ADDR scores, GM_ADDR knn_idx, GM_ADDR output,
-                                       GM_ADDR workspace, const AssignScoreWithkTilingData* tilingData)
+                                       GM_ADDR argmax, GM_ADDR workspace, const AssignScoreWithkTilingData* tilingData)
     {
         ASSERT(GetBlockNum() != 0 && "block num can not be zero");
 
@@ -55,6 +57,11 @@ public:
                                 numBatchInCore * npoint * numNeighbors);
         outputGm.SetGlobalBuffer((__gm__ T *)output + startDataIdx * numNeighbors,
                                 ndataInCore * numNeighbors);
+        // 仅max聚合时输出argmax，其余模式下argmax为空tensor
+        if (aggregate == AGGREGATE_MAX) {
+            argmaxGm.SetGlobalBuffer((__gm__ int32_t *)argmax + startDataIdx * numNeighbors,
+                                    ndataInCore * numNeighbors);
+        }
 
         pipe.InitBuffer(pointsQue, BUFFER_NUM, weightsAlign * sizeof(T));
         pipe.InitBuffer(centersQue, BUFFER_NUM, weightsAlign * sizeof(T));
@@ -62,6 +69,11 @@ public:
         pipe.InitBuffer(knnIdxQue, BUFFER_NUM, numNeighbors * sizeof(int64_t));
         pipe.InitBuffer(outputQue, BUFFER_NUM, numNeighbors * sizeof(T));
         pipe.InitBuffer(tempBuf, weightsAlign * sizeof(T));
+        if (aggregate == AGGREGATE_MAX) {
+            pipe.InitBuffer(argmaxQue, BUFFER_NUM, AlignUp(numNeighbors, dataAlign) * sizeof(int32_t));
+            // ReduceMax(calIndex=true)的中间结果，按两轮归约预留
+            pipe.InitBuffer(workBuf, 2 * AlignUp(weightsAlign, ONE_REPEAT_BYTE_SIZE / sizeof(T)) * sizeof(T));
+        }
     }
 
     __aicore__ inline void Process()
@@ -77,6 +89,9 @@ public:
             scoresLocal = scoresQue.AllocTensor<T>();
             outputLocal = outputQue.AllocTensor<T>();
             tempLocal = tempBuf.Get<T>();
+            if (aggregate == AGGREGATE_MAX) {
+                argmaxLocal = argmaxQue.AllocTensor<int32_t>();
+            }
 
             DataCopyPad(knnIdxLocal, knnIdxGm[batchIdx * npoint * numNeighbors + pointIdx * numNeighbors],
                         {1, static_cast<uint32_t>(numNeighbors * sizeof(int64_t)), 0, 0, 0},
@@ -106,13 +121,19 @@ public:
                 scoresLocal = scoresQue.DeQue<T>();
                 Sub(pointsLocal, pointsLocal, centersLocal, weightsAlign);
                 Mul(pointsLocal, pointsLocal, scoresLocal, weightsAlign);
-                Sum(tempLocal, pointsLocal, {1, inner, numWeights});
-                outputLocal.SetValue(k, tempLocal.GetValue(0));
+                AggregateWeights(k);
             }
             outputQue.EnQue(outputLocal);
             outputLocal = outputQue.DeQue<T>();
             DataCopyPad(outputGm[i * numNeighbors], outputLocal,
                 {1, static_cast<uint32_t>(numNeighbors * sizeof(T)), 0, 0, 0});
+            if (aggregate == AGGREGATE_MAX) {
+                argmaxQue.EnQue(argmaxLocal);
+                argmaxLocal = argmaxQue.DeQue<int32_t>();
+                DataCopyPad(argmaxGm[i * numNeighbors], argmaxLocal,
+                    {1, static_cast<uint32_t>(numNeighbors * sizeof(int32_t)), 0, 0, 0});
+                argmaxQue.FreeTensor<int32_t>(argmaxLocal);
+            }
 
             centersQue.FreeTensor<T>(centersLocal);
             knnIdxQue.FreeTensor<int64_t>(knnIdxLocal);
@@ -122,15 +143,37 @@ public:
         }
     }
 
+private:
+    // 对M个权重的score * (point - center)聚合: sum求和、avg取均值、max取最大值并记录下标
+    __aicore__ inline void AggregateWeights(uint32_t k)
+    {
+        if (aggregate == AGGREGATE_MAX) {
+            LocalTensor<T> workLocal = workBuf.Get<T>();
+            ReduceMax<T>(tempLocal, pointsLocal, workLocal, numWeights, true);
+            outputLocal.SetValue(k, tempLocal.GetValue(0));
+            LocalTensor<int32_t> indexLocal = tempLocal.template ReinterpretCast<int32_t>();
+            argmaxLocal.SetValue(k, indexLocal.GetValue(1));
+            return;
+        }
+        Sum(tempLocal, pointsLocal, {1, inner, numWeights});
+        T value = tempLocal.GetValue(0);
+        if (aggregate == AGGREGATE_AVG) {
+            value = value / static_cast<T>(numWeights);
+        }
+        outputLocal.SetValue(k, value);
+    }
+
 private:
     TPipe pipe;
     GlobalTensor<T> pointsGm, centersGm, scoresGm, outputGm;
     GlobalTensor<int64_t> knnIdxGm;
+    GlobalTensor<int32_t> argmaxGm;
     TQue<TPosition::VECIN, BUFFER_NUM> pointsQue, centersQue, scoresQue, knnIdxQue;
-    TQue<TPosition::VECOUT, BUFFER_NUM> outputQue;
-    TBuf<TPosition::VECCALC> tempBuf;
+    TQue<TPosition::VECOUT, BUFFER_NUM> outputQue, argmaxQue;
+    TBuf<TPosition::VECCALC> tempBuf, workBuf;
     LocalTensor<T> pointsLocal, centersLocal, scoresLocal, outputLocal, tempLocal;
     LocalTensor<int64_t> knnIdxLocal;
+    LocalTensor<int32_t> argmaxLocal;
 
 private:
     uint32_t aggregate;
@@ -160,6 +203,7 @@ extern "C" __global__ __aicore__ void assign_score_withk(
     GM_ADDR scores,
     GM_ADDR knnIdx,
     GM_ADDR output,
+    GM_ADDR argmax,
     GM_ADDR workspace,
     GM_ADDR tiling
 )
@@ -168,6 +212,6 @@ extern "C" __global__ __aicore__ void assign_score_withk(
     KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIV_ONLY);
 #endif
     GET_TILING_DATA(tilingData, tiling);
-    AssignScoreWithk<float> op(points, centers, scores, knnIdx, output, workspace, &tilingData);
+    AssignScoreWithk<float> op(points, centers, scores, knnIdx, output, argmax, workspace, &tilingData);
     op.Process();
 }
\ No newline at end of file
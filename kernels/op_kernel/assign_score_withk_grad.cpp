@@ -5,20 +5,22 @@ Copyright (c) Huawei Technologies Co., Ltd. 2023-2024. All rights reserved.
 #include "kernel_tiling/kernel_tiling.h"
 #include "kernel_utils.h"
 using namespace AscendC;
-constexpr uint32_t BUFFER_NUM = 1;
+constexpr uint32_t AGGREGATE_AVG = 1;
+constexpr uint32_t AGGREGATE_MAX = 2;
+constexpr uint32_t REPEAT_ELEMS = 64;
 
 template <typename T>
 class AssignScoreWithkGrad {
 public:
-    __aicore__ inline AssignScoreWithkGrad(TPipe* pipe, GM_ADDR grad_out, GM_ADDR points, GM_ADDR centers, GM_ADDR scores, GM_ADDR knn_idx, GM_ADDR gradScores, GM_ADDR gradPoints, GM_ADDR gradCenters,
+    __aicore__ inline AssignScoreWithkGrad(TPipe* pipe, GM_ADDR grad_out, GM_ADDR points, GM_ADDR centers, GM_ADDR scores, GM_ADDR knn_idx, GM_ADDR argmax, GM_ADDR gradScores, GM_ADDR gradPoints, GM_ADDR gradCenters,
                                         GM_ADDR workspace, const AssignScoreWithkTilingData* tilingData)
     {
         ASSERT(GetBlockNum() != 0 && "block num can not be zero");
         InitTask(tilingData);
-        InitGM(grad_out, points, centers, scores, knn_idx, gradScores, gradPoints, gradCenters);
+        InitGM(grad_out, points, centers, scores, knn_idx, argmax, gradScores, gradPoints, gradCenters);
         InitBuffer(pipe);
     }
-    
+
     __aicore__ inline void InitTask(const AssignScoreWithkTilingData* tilingData)
     {
         batchSize = tilingData->batchSize;
@@ -28,8 +30,11 @@ public:
         numNeighbors = tilingData->numNeighbors;
         numFeatures= tilingData->numFeatures;
         aggregate = tilingData->aggregate;
+        weightTile = tilingData->weightTile;
         dataAlign = ONE_BLK_SIZE / sizeof(T);
         featureAlign = AlignUp(numFeatures, dataAlign);
+        featureRepeatAlign = AlignUp(numFeatures, REPEAT_ELEMS);
+        weightTileAlign = AlignUp(weightTile, dataAlign);
 
         ndataPerCore = tilingData->npointPerCore;
         ndataRemained = tilingData->npointRemained;
@@ -47,7 +52,7 @@ public:
         numBatchInCore = (startDataIdx + ndataInCore + npoint - 1) / npoint - startBatchIdx;
     }
 
-    __aicore__ inline void InitGM(GM_ADDR grad_out, GM_ADDR points, GM_ADDR centers, GM_ADDR scores, GM_ADDR knn_idx, GM_ADDR gradScores, GM_ADDR gradPoints, GM_ADDR gradCenters)
+    __aicore__ inline void InitGM(GM_ADDR grad_out, GM_ADDR points, GM_ADDR centers, GM_ADDR scores, GM_ADDR knn_idx, GM_ADDR argmax, GM_ADDR gradScores, GM_ADDR gradPoints, GM_ADDR gradCenters)
     {
         pointsGm.SetGlobalBuffer((__gm__ T *)points + startBatchIdx * nsource * numWeights * numFeatures,
                                                 numBatchInCore * nsource * numWeights * numFeatures);
@@ -64,169 +69,163 @@ public:
         gradOutGm.SetGlobalBuffer((__gm__ T *)grad_out + startDataIdx * numNeighbors * numFeatures,
                                                 ndataInCore * numNeighbors * numFeatures);
 
+        // argmax与grad_out同为[B, npoint, K, out_dim]布局，仅max聚合时传入
+        if (aggregate == AGGREGATE_MAX) {
+            argmaxGm.SetGlobalBuffer((__gm__ int32_t *)argmax + startDataIdx * numNeighbors * numFeatures,
+                                                ndataInCore * numNeighbors * numFeatures);
+        }
+
         gradScoresGm.SetGlobalBuffer((__gm__ T *)gradScores + startDataIdx * numNeighbors * numWeights,
                                                 ndataInCore * numNeighbors * numWeights);
-        
+
         gradPointsGm.SetGlobalBuffer((__gm__ T *)gradPoints + startBatchIdx * nsource * numWeights * numFeatures,
                                                     numBatchInCore * nsource * numWeights * numFeatures);
-        
+
         gradCentersGm.SetGlobalBuffer((__gm__ T *)gradCenters + startBatchIdx * nsource * numWeights * numFeatures,
                                                     numBatchInCore * nsource * numWeights * numFeatures);
     }
 
     __aicore__ inline void InitBuffer(TPipe* pipe)
     {
-        pipe->InitBuffer(pointsQue, BUFFER_NUM, numWeights * featureAlign * sizeof(T));
-        pipe->InitBuffer(centersQue, BUFFER_NUM, numWeights * featureAlign * sizeof(T));
-        pipe->InitBuffer(scoresQue, BUFFER_NUM, numWeights * sizeof(T));
-        pipe->InitBuffer(knnIdxQue, BUFFER_NUM, numNeighbors * sizeof(int64_t));
-        pipe->InitBuffer(gradOutQue, BUFFER_NUM, featureAlign * sizeof(T));
+        uint32_t tileSize = weightTile * featureAlign * sizeof(T);
+        pipe->InitBuffer(knnIdxBuf, AlignUp(numNeighbors * sizeof(int64_t), ONE_BLK_SIZE));
+        pipe->InitBuffer(gradOutBuf, featureRepeatAlign * sizeof(T));
+        pipe->InitBuffer(scoresBuf, weightTileAlign * sizeof(T));
+        pipe->InitBuffer(gradScoresBuf, weightTileAlign * sizeof(T));
+        pipe->InitBuffer(pointsBuf, tileSize);
+        pipe->InitBuffer(centersBuf, tileSize);
+        pipe->InitBuffer(gradBuf, tileSize);
+        pipe->InitBuffer(gradPointsBuf, tileSize);
+        pipe->InitBuffer(gradCentersBuf, tileSize);
+        if (aggregate == AGGREGATE_MAX) {
+            pipe->InitBuffer(argmaxBuf, featureRepeatAlign * sizeof(int32_t));
+            pipe->InitBuffer(argmaxFloatBuf, featureRepeatAlign * sizeof(T));
+            pipe->InitBuffer(maskBuf, AlignUp(featureRepeatAlign / 8, ONE_BLK_SIZE));
+        }
 
-        pipe->InitBuffer(gradScoresQue, BUFFER_NUM, numWeights * sizeof(T));
-        pipe->InitBuffer(gradPointsQue, BUFFER_NUM, numWeights * numFeatures * sizeof(T));
-        pipe->InitBuffer(gradCentersQue, BUFFER_NUM, numWeights * numFeatures * sizeof(T));
-        
-        pipe->InitBuffer(tempBuf, numWeights * featureAlign * sizeof(T));
-        pipe->InitBuffer(tempBuf1, numWeights * featureAlign * sizeof(T));
-        pipe->InitBuffer(tempBuf2, numWeights * featureAlign * sizeof(T));
+        knnIdxLocal = knnIdxBuf.Get<int64_t>();
+        gradOutLocal = gradOutBuf.Get<T>();
+        scoresLocal = scoresBuf.Get<T>();
+        gradScoresLocal = gradScoresBuf.Get<T>();
+        pointsLocal = pointsBuf.Get<T>();
+        centersLocal = centersBuf.Get<T>();
+        gradLocal = gradBuf.Get<T>();
+        gradPointsLocal = gradPointsBuf.Get<T>();
+        gradCentersLocal = gradCentersBuf.Get<T>();
     }
 
-    __aicore__ inline void Process(AssignScoreWithkTilingData* tilingData)
+    __aicore__ inline void Process()
     {
         for (uint32_t taskId = 0; taskId < ndataInCore; taskId++) {
-            uint32_t batchId = (taskId + startDataIdx) / npoint - startBatchIdx;
-            knnIdxLocal = knnIdxQue.AllocTensor<int64_t>();
-            centersLocal = centersQue.AllocTensor<T>();
+            uint64_t batchOffset = ((taskId + startDataIdx) / npoint - startBatchIdx) * nsource * numWeights * numFeatures;
             DataCopyPad(knnIdxLocal, knnIdxGm[taskId * numNeighbors],
                         {1, static_cast<uint32_t>(numNeighbors * sizeof(int64_t)), 0, 0, 0},
                         {false, 0, 0, 0});
-            knnIdxQue.EnQue(knnIdxLocal);
-            knnIdxLocal = knnIdxQue.DeQue<int64_t>();
-
-            DataCopyPad(centersLocal, centersGm[batchId * nsource * numWeights * numFeatures + knnIdxLocal.GetValue(0) * numWeights * numFeatures],
-                        {static_cast<uint16_t>(numWeights), static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0},
-                        {true, 0, static_cast<uint8_t>(featureAlign - numFeatures), 0});
-            centersQue.EnQue(centersLocal);
-            centersLocal = centersQue.DeQue<T>();
-
-            for (uint32_t k = 0; k < numNeighbors; k++) {
-                CopyIn(taskId, batchId, k);
-                Compute(tilingData);
-                CopyOut(taskId, batchId, k);
+            PipeBarrier<PIPE_ALL>();
+            uint64_t centerOffset = batchOffset + knnIdxLocal.GetValue(0) * numWeights * numFeatures;
+
+            // 沿M分块，每块内centers的梯度在K个邻居上累加后一次写出
+            for (uint32_t weightStart = 0; weightStart < numWeights; weightStart += weightTile) {
+                uint32_t weightNum = weightStart + weightTile < numWeights ? weightTile : numWeights - weightStart;
+                CopyInRows(centersLocal, centersGm[centerOffset + weightStart * numFeatures], weightNum);
+                Duplicate(gradCentersLocal, static_cast<T>(0), weightNum * featureAlign);
+                for (uint32_t k = 0; k < numNeighbors; k++) {
+                    ComputeNeighbor(taskId, batchOffset, k, weightStart, weightNum);
+                }
+                SetAtomicAdd<T>();
+                CopyOutRows(gradCentersGm[centerOffset + weightStart * numFeatures], gradCentersLocal, weightNum);
+                SetAtomicNone();
+                PipeBarrier<PIPE_ALL>();
             }
-            
-            knnIdxQue.FreeTensor<int64_t>(knnIdxLocal);
-            centersQue.FreeTensor<T>(centersLocal);
         }
     }
 
-    __aicore__ inline void CopyIn(uint32_t taskId, uint32_t batchId, uint32_t k)
+private:
+    __aicore__ inline void CopyInRows(const LocalTensor<T>& dst, const GlobalTensor<T>& src, uint32_t rows)
     {
-        uint32_t idx = knnIdxLocal.GetValue(k);
-        pointsLocal = pointsQue.AllocTensor<T>();
-        gradOutLocal = gradOutQue.AllocTensor<T>();
-        scoresLocal = scoresQue.AllocTensor<T>();
-        DataCopyPad(pointsLocal, pointsGm[batchId * nsource * numWeights * numFeatures + idx * numWeights * numFeatures],
-                    {static_cast<uint16_t>(numWeights), static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0},
+        DataCopyPad(dst, src, {static_cast<uint16_t>(rows), static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0},
                     {true, 0, static_cast<uint8_t>(featureAlign - numFeatures), 0});
-        pointsQue.EnQue(pointsLocal);
-
-        DataCopyPad(gradOutLocal, gradOutGm[taskId * numNeighbors * numFeatures + k * numFeatures],
-                    {1, static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0},
-                    {true, 0, static_cast<uint8_t>(featureAlign - numFeatures), 0});
-        gradOutQue.EnQue(gradOutLocal);
-
-        DataCopyPad(scoresLocal, scoresGm[taskId * numNeighbors * numWeights + k * numWeights],
-                    {1, static_cast<uint32_t>(numWeights * sizeof(T)), 0, 0, 0},
-                    {false, 0, 0, 0});
-        scoresQue.EnQue(scoresLocal);
-    }
-
-    __aicore__ inline void Compute(AssignScoreWithkTilingData* tilingData)
-    {
-        srcShape[0][0] = 1;
-        srcShape[0][1] = featureAlign;
-        dstShape[0][0] = numWeights;
-        dstShape[0][1] = featureAlign;
-
-        srcShape[1][0] = numWeights;
-        srcShape[1][1] = 1;
-        dstShape[1][0] = numWeights;
-        dstShape[1][1] = featureAlign;
-
-        gradOutLocal = gradOutQue.DeQue<T>();
-        ComputeGradScore();
-        ComputeGradPointsAndCenters(tilingData);
-        gradOutQue.FreeTensor<T>(gradOutLocal);
     }
 
-    __aicore__ inline void ComputeGradScore()
+    __aicore__ inline void CopyOutRows(const GlobalTensor<T>& dst, const LocalTensor<T>& src, uint32_t rows)
     {
-        pointsLocal = pointsQue.DeQue<T>();
-        gradScoresLocal = gradScoresQue.AllocTensor<T>();
-        tempLocal = tempBuf.Get<T>();
-
-        Sub(pointsLocal, pointsLocal, centersLocal, numWeights * featureAlign);
-        BroadCast<T, 2, 0>(tempLocal, gradOutLocal, dstShape[0], srcShape[0]);
-        Mul(pointsLocal, pointsLocal, tempLocal, numWeights * featureAlign);
-        Sum(gradScoresLocal, pointsLocal, {numWeights, featureAlign, featureAlign});
-        gradScoresQue.EnQue(gradScoresLocal);
-        pointsQue.FreeTensor<T>(pointsLocal);
+        DataCopyPad(dst, src, {static_cast<uint16_t>(rows), static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0});
     }
 
-    __aicore__ inline void ComputeGradPointsAndCenters(AssignScoreWithkTilingData* tilingData)
+    __aicore__ inline void ComputeNeighbor(
+        uint32_t taskId, uint64_t batchOffset, uint32_t k, uint32_t weightStart, uint32_t weightNum)
     {
-        scoresLocal = scoresQue.DeQue<T>();
-        tempLocal1 = tempBuf1.Get<T>(numWeights * numFeatures);
-        tempLocal2 = tempBuf2.Get<T>(numWeights * numFeatures);
-        gradPointsLocal = gradPointsQue.AllocTensor<T>();
-        gradCentersLocal = gradCentersQue.AllocTensor<T>();
-
-        BroadCast<T, 2, 1>(tempLocal1, scoresLocal, dstShape[1], srcShape[1]);
-        BroadCast<T, 2, 0>(tempLocal2, gradOutLocal, dstShape[0], srcShape[0]);
-        Mul(tempLocal1, tempLocal1, tempLocal2, numWeights * featureAlign);
-
-        UnPadParams UnPadParams;
-        UnPadParams.rightPad = featureAlign - numFeatures;
-        UnPad(gradPointsLocal, tempLocal1, UnPadParams, tilingData->unpadTilingData);
+        uint64_t row = static_cast<uint64_t>(taskId) * numNeighbors + k;
+        uint64_t pointOffset = batchOffset + knnIdxLocal.GetValue(k) * numWeights * numFeatures +
+                               weightStart * numFeatures;
+        uint32_t tileNum = weightNum * featureAlign;
+        CopyInRows(pointsLocal, pointsGm[pointOffset], weightNum);
+        DataCopyPad(gradOutLocal, gradOutGm[row * numFeatures],
+                    {1, static_cast<uint32_t>(numFeatures * sizeof(T)), 0, 0, 0},
+                    {true, 0, static_cast<uint8_t>(featureAlign - numFeatures), 0});
+        DataCopyPad(scoresLocal, scoresGm[row * numWeights + weightStart],
+                    {1, static_cast<uint32_t>(weightNum * sizeof(T)), 0, 0, 0},
+                    {false, 0, 0, 0});
+        if (aggregate == AGGREGATE_MAX) {
+            LocalTensor<int32_t> argmaxLocal = argmaxBuf.Get<int32_t>();
+            DataCopyPad(argmaxLocal, argmaxGm[row * numFeatures],
+                        {1, static_cast<uint32_t>(numFeatures * sizeof(int32_t)), 0, 0, 0},
+                        {false, 0, 0, 0});
+        }
+        PipeBarrier<PIPE_ALL>();
+
+        BuildGradTile(weightStart, weightNum);
+        // grad_scores[m] = sum_o grad[m, o] * (points[m, o] - centers[m, o])
+        Sub(pointsLocal, pointsLocal, centersLocal, tileNum);
+        Mul(pointsLocal, pointsLocal, gradLocal, tileNum);
+        Sum(gradScoresLocal, pointsLocal, {weightNum, featureAlign, numFeatures});
+        // grad_points[m, o] = scores[m] * grad[m, o]，grad_centers取相反数
+        for (uint32_t m = 0; m < weightNum; m++) {
+            Muls(gradPointsLocal[m * featureAlign], gradLocal[m * featureAlign], scoresLocal.GetValue(m), featureAlign);
+        }
+        Sub(gradCentersLocal, gradCentersLocal, gradPointsLocal, tileNum);
+        PipeBarrier<PIPE_ALL>();
 
-        Muls(gradCentersLocal, gradPointsLocal, (T)-1.0, numWeights * numFeatures);
-        gradPointsQue.EnQue(gradPointsLocal);
-        gradCentersQue.EnQue(gradCentersLocal);
-        
-        scoresQue.FreeTensor<T>(scoresLocal);
+        DataCopyPad(gradScoresGm[row * numWeights + weightStart], gradScoresLocal,
+                    {1, static_cast<uint32_t>(weightNum * sizeof(T)), 0, 0, 0});
+        SetAtomicAdd<T>();
+        CopyOutRows(gradPointsGm[pointOffset], gradPointsLocal, weightNum);
+        SetAtomicNone();
+        PipeBarrier<PIPE_ALL>();
     }
 
-    __aicore__ inline void CopyOut(uint32_t taskId, uint32_t batchId, uint32_t k)
+    // 每个权重行对应的上游梯度: sum为grad_out，avg为grad_out / M，max仅保留argmax等于该行下标的通道
+    __aicore__ inline void BuildGradTile(uint32_t weightStart, uint32_t weightNum)
     {
-        uint32_t idx = knnIdxLocal.GetValue(k);
-        uint32_t idx0 = knnIdxLocal.GetValue(0);
-        gradScoresLocal = gradScoresQue.DeQue<T>();
-        gradPointsLocal = gradPointsQue.DeQue<T>();
-        gradCentersLocal = gradCentersQue.DeQue<T>();
-        DataCopyPad(gradScoresGm[taskId * numNeighbors * numWeights + k * numWeights], gradScoresLocal,
-                    {1, static_cast<uint32_t>(numWeights * sizeof(T)), 0, 0, 0});
-        SetAtomicAdd<T>();
-        DataCopyPad(gradPointsGm[batchId * nsource * numWeights * numFeatures + idx * numWeights * numFeatures], gradPointsLocal,
-                    {1, static_cast<uint32_t>(numWeights * numFeatures * sizeof(T)), 0, 0, 0});
-        DataCopyPad(gradCentersGm[batchId * nsource * numWeights * numFeatures + idx0 * numWeights * numFeatures], gradCentersLocal,
-                    {1, static_cast<uint32_t>(numWeights * numFeatures * sizeof(T)), 0, 0, 0});
-        SetAtomicNone();
-        gradScoresQue.FreeTensor<T>(gradScoresLocal);
-        gradPointsQue.FreeTensor<T>(gradPointsLocal);
-        gradCentersQue.FreeTensor<T>(gradCentersLocal);
+        if (aggregate == AGGREGATE_MAX) {
+            LocalTensor<int32_t> argmaxLocal = argmaxBuf.Get<int32_t>();
+            LocalTensor<T> argmaxFloatLocal = argmaxFloatBuf.Get<T>();
+            LocalTensor<uint8_t> maskLocal = maskBuf.Get<uint8_t>();
+            Cast(argmaxFloatLocal, argmaxLocal, RoundMode::CAST_NONE, featureRepeatAlign);
+            for (uint32_t m = 0; m < weightNum; m++) {
+                CompareScalar(maskLocal, argmaxFloatLocal, static_cast<T>(weightStart + m), CMPMODE::EQ,
+                              featureRepeatAlign);
+                Select(gradLocal[m * featureAlign], maskLocal, gradOutLocal, static_cast<T>(0),
+                       SELMODE::VSEL_TENSOR_SCALAR_MODE, featureAlign);
+            }
+            return;
+        }
+        T scale = aggregate == AGGREGATE_AVG ? static_cast<T>(1) / static_cast<T>(numWeights) : static_cast<T>(1);
+        for (uint32_t m = 0; m < weightNum; m++) {
+            Muls(gradLocal[m * featureAlign], gradOutLocal, scale, featureAlign);
+        }
     }
 
 private:
     GlobalTensor<T> pointsGm, centersGm, scoresGm, gradOutGm, gradScoresGm, gradPointsGm, gradCentersGm;
     GlobalTensor<int64_t> knnIdxGm;
-    LocalTensor<T> pointsLocal, centersLocal, scoresLocal, gradOutLocal, tempLocal, tempLocal1, tempLocal2;
+    GlobalTensor<int32_t> argmaxGm;
+    LocalTensor<T> pointsLocal, centersLocal, scoresLocal, gradOutLocal, gradLocal;
     LocalTensor<T> gradScoresLocal, gradPointsLocal, gradCentersLocal;
     LocalTensor<int64_t> knnIdxLocal;
 
-    TQue<TPosition::VECIN, BUFFER_NUM> pointsQue, centersQue, scoresQue, knnIdxQue, gradOutQue;
-    TQue<TPosition::VECOUT, BUFFER_NUM> gradScoresQue, gradPointsQue, gradCentersQue;
-    TBuf<TPosition::VECCALC> tempBuf, tempBuf1, tempBuf2;
+    TBuf<TPosition::VECCALC> knnIdxBuf, gradOutBuf, scoresBuf, gradScoresBuf, pointsBuf, centersBuf, gradBuf;
+    TBuf<TPosition::VECCALC> gradPointsBuf, gradCentersBuf, argmaxBuf, argmaxFloatBuf, maskBuf;
 
     uint32_t aggregate;
     uint32_t batchSize;
@@ -235,16 +234,16 @@ private:
     uint32_t numWeights;
     uint32_t numNeighbors;
     uint32_t numFeatures;
+    uint32_t weightTile;
     uint64_t ndataInCore;
     uint32_t coreId;
     uint64_t ndataPerCore, ndataRemained, startDataIdx;
     uint32_t dataAlign;
-    uint32_t weightsFeatsAlign;
     uint32_t featureAlign;
+    uint32_t featureRepeatAlign;
+    uint32_t weightTileAlign;
     uint64_t startBatchIdx;
     uint64_t numBatchInCore;
-    uint32_t dstShape[2][2];
-    uint32_t srcShape[2][2];
 };
 
 extern "C" __global__ __aicore__ void assign_score_withk_grad(
@@ -253,6 +252,7 @@ extern "C" __global__ __aicore__ void assign_score_withk_grad(
     GM_ADDR centers,
     GM_ADDR scores,
     GM_ADDR knnIdx,
+    GM_ADDR argmax,
     GM_ADDR gradScores,
     GM_ADDR gradPoints,
     GM_ADDR gradCenters,
@@ -265,6 +265,6 @@ extern "C" __global__ __aicore__ void assign_score_withk_grad(
 #endif
     GET_TILING_DATA(tilingData, tiling);
     TPipe pipe;
-    AssignScoreWithkGrad<float> op(&pipe, grad_out, points, centers, scores, knnIdx, gradScores, gradPoints, gradCenters, workspace, &tilingData);
-    op.Process(&tilingData);
+    AssignScoreWithkGrad<float> op(&pipe, grad_out, points, centers, scores, knnIdx, argmax, gradScores, gradPoints, gradCenters, workspace, &tilingData);
+    op.Process();
 }
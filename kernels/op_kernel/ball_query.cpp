@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+#include "kernel_operator.h"
+using namespace AscendC;
+
+namespace {
+constexpr uint32_t POINT_DIM = 3;
+constexpr uint32_t ALIGN_NUM_64 = 64; // CompareScalar function requires 256B alignment.
+constexpr uint32_t ALIGN_NUM_8 = 8;
+constexpr uint32_t MASK_BITS = 16;
+constexpr uint32_t BLOCK_BYTES = 32;
+} // namespace
+
+// T is the dtype of xyz, center_xyz and features(float32 or float16), distances are always computed in float32
+template<typename T>
+class KernelBallQuery {
+public:
+    __aicore__ inline KernelBallQuery() {}
+    __aicore__ inline void Init(GM_ADDR xyz, GM_ADDR centerXyz, GM_ADDR features, GM_ADDR idx,
+        GM_ADDR groupedFeatures, const BallQueryTilingData* tilingData, TPipe* tmpPipe)
+    {
+        pipe = tmpPipe;
+        batch = tilingData->batch;
+        nPoint = tilingData->nPoint;
+        nSource = tilingData->nSource;
+        sampleNum = tilingData->sampleNum;
+        cSize = tilingData->cSize;
+        cAligned = tilingData->cAligned;
+        withFeatures = tilingData->withFeatures;
+        minRadius2 = tilingData->minRadius2;
+        maxRadius2 = tilingData->maxRadius2;
+        compNum = tilingData->compNum;
+        uint32_t coreTaskNum = tilingData->coreTaskNum;
+
+        startTask = GetBlockIdx() * coreTaskNum;
+        endTask = startTask + coreTaskNum;
+        if (endTask > batch * nPoint) {
+            endTask = batch * nPoint;
+        }
+        sampleAligned = (sampleNum + ALIGN_NUM_8 - 1) / ALIGN_NUM_8 * ALIGN_NUM_8;
+        // 每个mask按位存放compNum个比较结果，起始地址需32B对齐
+        maskBytes = (compNum / ALIGN_NUM_8 + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+
+        sourceGm.SetGlobalBuffer((__gm__ T*)xyz, static_cast<uint64_t>(batch) * POINT_DIM * nSource);
+        targetGm.SetGlobalBuffer((__gm__ T*)centerXyz, static_cast<uint64_t>(batch) * nPoint * POINT_DIM);
+        idxGm.SetGlobalBuffer((__gm__ int32_t*)idx, static_cast<uint64_t>(batch) * nPoint * sampleNum);
+
+        pipe->InitBuffer(sourceBuf, compNum * POINT_DIM * sizeof(float));
+        pipe->InitBuffer(distBuf, compNum * sizeof(float));
+        pipe->InitBuffer(tempBuf, compNum * sizeof(float));
+        pipe->InitBuffer(indexBuf, compNum * sizeof(int32_t));
+        pipe->InitBuffer(maskBuf, maskBytes * POINT_DIM);
+        pipe->InitBuffer(targetBuf, BLOCK_BYTES);
+        pipe->InitBuffer(sampleBuf, sampleAligned * sizeof(int32_t));
+        if constexpr (!IS_FLOAT) {
+            pipe->InitBuffer(sourceCastBuf, compNum * POINT_DIM * sizeof(T));
+            pipe->InitBuffer(targetCastBuf, BLOCK_BYTES);
+        }
+        if (withFeatures) {
+            featuresGm.SetGlobalBuffer((__gm__ T*)features, static_cast<uint64_t>(batch) * nSource * cSize);
+            groupedGm.SetGlobalBuffer(
+                (__gm__ T*)groupedFeatures, static_cast<uint64_t>(batch) * nPoint * sampleNum * cSize);
+            pipe->InitBuffer(featureBuf, sampleNum * cAligned * sizeof(T));
+        }
+    }
+
+    __aicore__ inline void Process()
+    {
+        sourceLocal = sourceBuf.Get<float>();
+        distLocal = distBuf.Get<float>();
+        tempLocal = tempBuf.Get<float>();
+        indexLocal = indexBuf.Get<int32_t>();
+        maxMask = maskBuf.Get<uint8_t>();
+        minMask = maxMask[maskBytes];
+        zeroMask = maxMask[maskBytes * 2];
+        targetLocal = targetBuf.Get<float>();
+        sampleLocal = sampleBuf.Get<int32_t>();
+        if constexpr (!IS_FLOAT) {
+            sourceCastLocal = sourceCastBuf.Get<T>();
+            targetCastLocal = targetCastBuf.Get<T>();
+        }
+        if (withFeatures) {
+            featureLocal = featureBuf.Get<T>();
+        }
+
+        cachedBatch = -1;
+        cachedStart = -1;
+        for (uint32_t task = startTask; task < endTask; task++) {
+            int64_t batchIdx = task / nPoint;
+            CopyInTarget(task);
+            // 按下标顺序遍历源点，采满sampleNum个后提前结束
+            uint32_t count = 0;
+            for (uint32_t start = 0; start < nSource && count < sampleNum; start += compNum) {
+                uint32_t num = (nSource - start) < compNum ? (nSource - start) : compNum;
+                CopyInSource(batchIdx, start, num);
+                count = ComputeChunk(start, num, count);
+            }
+            FillSample(count);
+            CopyOut(batchIdx, task);
+        }
+    }
+
+private:
+    __aicore__ inline void CopyInTarget(uint32_t task)
+    {
+        PipeBarrier<PIPE_ALL>();
+        if constexpr (IS_FLOAT) {
+            DataCopyPad(targetLocal, targetGm[task * POINT_DIM], {1, POINT_DIM * sizeof(T), 0, 0, 0},
+                {false, 0, 0, 0});
+        } else {
+            DataCopyPad(targetCastLocal, targetGm[task * POINT_DIM], {1, POINT_DIM * sizeof(T), 0, 0, 0},
+                {false, 0, 0, 0});
+            PipeBarrier<PIPE_ALL>();
+            Cast(targetLocal, targetCastLocal, RoundMode::CAST_NONE, ALIGN_NUM_8);
+        }
+        PipeBarrier<PIPE_ALL>();
+        targetX = targetLocal.GetValue(0);
+        targetY = targetLocal.GetValue(1);
+        targetZ = targetLocal.GetValue(2);
+    }
+
+    // 源点数不超过compNum时整批源点常驻UB，同一batch的中心点不再重复搬运
+    __aicore__ inline void CopyInSource(int64_t batchIdx, uint32_t start, uint32_t num)
+    {
+        if (batchIdx == cachedBatch && static_cast<int64_t>(start) == cachedStart) {
+            return;
+        }
+        cachedBatch = batchIdx;
+        cachedStart = start;
+        uint64_t offset = static_cast<uint64_t>(batchIdx) * POINT_DIM * nSource + start;
+        DataCopyExtParams copyParams {1, static_cast<uint32_t>(num * sizeof(T)), 0, 0, 0};
+        PipeBarrier<PIPE_ALL>();
+        for (uint32_t dim = 0; dim < POINT_DIM; dim++) {
+            if constexpr (IS_FLOAT) {
+                DataCopyPad(sourceLocal[dim * compNum], sourceGm[offset + dim * nSource], copyParams,
+                    {false, 0, 0, 0});
+            } else {
+                DataCopyPad(sourceCastLocal[dim * compNum], sourceGm[offset + dim * nSource], copyParams,
+                    {false, 0, 0, 0});
+            }
+        }
+        PipeBarrier<PIPE_ALL>();
+        if constexpr (!IS_FLOAT) {
+            Cast(sourceLocal, sourceCastLocal, RoundMode::CAST_NONE, compNum * POINT_DIM);
+            PipeBarrier<PIPE_V>();
+        }
+    }
+
+    // 与mmcv一致：d2 == 0 或 min_radius^2 <= d2 < max_radius^2 的源点计入
+    __aicore__ inline uint32_t ComputeChunk(uint32_t start, uint32_t num, uint32_t count)
+    {
+        uint32_t numAligned = (num + ALIGN_NUM_64 - 1) / ALIGN_NUM_64 * ALIGN_NUM_64;
+        Adds(distLocal, sourceLocal, -targetX, numAligned);
+        Adds(tempLocal, sourceLocal[compNum], -targetY, numAligned);
+        PipeBarrier<PIPE_V>();
+        Mul(distLocal, distLocal, distLocal, numAligned);
+        Mul(tempLocal, tempLocal, tempLocal, numAligned);
+        PipeBarrier<PIPE_V>();
+        Add(distLocal, distLocal, tempLocal, numAligned);
+        Adds(tempLocal, sourceLocal[compNum * 2], -targetZ, numAligned);
+        PipeBarrier<PIPE_V>();
+        Mul(tempLocal, tempLocal, tempLocal, numAligned);
+        PipeBarrier<PIPE_V>();
+        Add(distLocal, distLocal, tempLocal, numAligned);
+        PipeBarrier<PIPE_V>();
+
+        CompareScalar(maxMask, distLocal, maxRadius2, CMPMODE::LT, numAligned);
+        CompareScalar(zeroMask, distLocal, 0.0f, CMPMODE::EQ, numAligned);
+        PipeBarrier<PIPE_V>();
+        LocalTensor<uint16_t> maxMask16 = maxMask.ReinterpretCast<uint16_t>();
+        if (minRadius2 > 0.0f) {
+            CompareScalar(minMask, distLocal, minRadius2, CMPMODE::GE, numAligned);
+            PipeBarrier<PIPE_V>();
+            And(maxMask16, maxMask16, minMask.ReinterpretCast<uint16_t>(), numAligned / MASK_BITS);
+            PipeBarrier<PIPE_V>();
+        }
+        Or(maxMask16, maxMask16, zeroMask.ReinterpretCast<uint16_t>(), numAligned / MASK_BITS);
+        CreateVecIndex(indexLocal, static_cast<int32_t>(start), numAligned);
+        PipeBarrier<PIPE_V>();
+        uint64_t selectCnt = 0;
+        GatherMask(indexLocal, indexLocal, maxMask.ReinterpretCast<uint32_t>(), true, num, {1, 1, 0, 0}, selectCnt);
+        PipeBarrier<PIPE_ALL>();
+
+        uint32_t take = sampleNum - count;
+        if (selectCnt < take) {
+            take = static_cast<uint32_t>(selectCnt);
+        }
+        for (uint32_t i = 0; i < take; i++) {
+            sampleLocal.SetValue(count + i, indexLocal.GetValue(i));
+        }
+        return count + take;
+    }
+
+    // 不足sampleNum个时用第一个命中的源点补齐，无命中时下标全为0
+    __aicore__ inline void FillSample(uint32_t count)
+    {
+        int32_t first = count == 0 ? 0 : sampleLocal.GetValue(0);
+        for (uint32_t i = count; i < sampleNum; i++) {
+            sampleLocal.SetValue(i, first);
+        }
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void CopyOut(int64_t batchIdx, uint32_t task)
+    {
+        DataCopyPad(idxGm[static_cast<uint64_t>(task) * sampleNum], sampleLocal,
+            {1, static_cast<uint32_t>(sampleNum * sizeof(int32_t)), 0, 0, 0});
+        if (!withFeatures) {
+            return;
+        }
+        // 直接按采样下标聚合特征，避免group_points重新读取idx
+        DataCopyExtParams rowParams {1, static_cast<uint32_t>(cSize * sizeof(T)), 0, 0, 0};
+        uint64_t featureOffset = static_cast<uint64_t>(batchIdx) * nSource * cSize;
+        for (uint32_t i = 0; i < sampleNum; i++) {
+            uint64_t srcIdx = featureOffset + static_cast<uint64_t>(sampleLocal.GetValue(i)) * cSize;
+            DataCopyPad(featureLocal[i * cAligned], featuresGm[srcIdx], rowParams, {false, 0, 0, 0});
+        }
+        PipeBarrier<PIPE_ALL>();
+        DataCopyExtParams outParams {
+            static_cast<uint16_t>(sampleNum), static_cast<uint32_t>(cSize * sizeof(T)), 0, 0, 0};
+        DataCopyPad(groupedGm[static_cast<uint64_t>(task) * sampleNum * cSize], featureLocal, outParams);
+    }
+
+private:
+    static constexpr bool IS_FLOAT = sizeof(T) == sizeof(float);
+
+    TPipe* pipe;
+    TBuf<TPosition::VECCALC> sourceBuf, sourceCastBuf, distBuf, tempBuf, indexBuf, maskBuf;
+    TBuf<TPosition::VECCALC> targetBuf, targetCastBuf, sampleBuf, featureBuf;
+    GlobalTensor<T> sourceGm, targetGm, featuresGm, groupedGm;
+    GlobalTensor<int32_t> idxGm;
+    LocalTensor<float> sourceLocal, distLocal, tempLocal, targetLocal;
+    LocalTensor<T> sourceCastLocal, targetCastLocal, featureLocal;
+    LocalTensor<int32_t> indexLocal, sampleLocal;
+    LocalTensor<uint8_t> maxMask, minMask, zeroMask;
+
+    uint32_t batch, nPoint, nSource, sampleNum, sampleAligned, cSize, cAligned, compNum, maskBytes;
+    uint32_t startTask, endTask;
+    bool withFeatures;
+    float minRadius2, maxRadius2;
+    float targetX, targetY, targetZ;
+    int64_t cachedBatch, cachedStart;
+};
+
+extern "C" __global__ __aicore__ void ball_query(GM_ADDR xyz, GM_ADDR center_xyz, GM_ADDR features, GM_ADDR idx,
+    GM_ADDR grouped_features, GM_ADDR workspace, GM_ADDR tiling)
+{
+    TPipe pipe;
+    GET_TILING_DATA(tilingData, tiling);
+    if (TILING_KEY_IS(0)) {
+        KernelBallQuery<float> op;
+        op.Init(xyz, center_xyz, features, idx, grouped_features, &tilingData, &pipe);
+        op.Process();
+    } else if (TILING_KEY_IS(1)) {
+        KernelBallQuery<half> op;
+        op.Init(xyz, center_xyz, features, idx, grouped_features, &tilingData, &pipe);
+        op.Process();
+    }
+}
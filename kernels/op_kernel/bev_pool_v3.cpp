@@ -1,7 +1,7 @@
 #include "kernel_operator.h"
 using namespace AscendC;
 
-template<bool with_depth>
+template<typename T, bool with_depth, bool depth_softmax>
 class BEVPoolV3Kernel {
 public:
     __aicore__ inline BEVPoolV3Kernel() = delete;
@@ -9,12 +9,12 @@ public:
     __aicore__ inline ~BEVPoolV3Kernel() = default;
 
     __aicore__ inline BEVPoolV3Kernel(TPipe* pipe, GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat,
-        GM_ADDR ranksBev, GM_ADDR out, const BEVPoolV3TilingData& tiling)
+        GM_ADDR ranksBev, GM_ADDR depthLse, GM_ADDR out, const BEVPoolV3TilingData& tiling)
         : pipe_(pipe), blkIdx_(GetBlockIdx()), channel_(tiling.channel)
     {
         InitTask(tiling);
         InitOffset();
-        InitGM(depth, feat, ranksDepth, ranksFeat, ranksBev, out);
+        InitGM(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out);
         InitBuffer();
         InitEvent();
     }
@@ -46,17 +46,26 @@ private:
             rankFeatOffset_ = rankBevOffset_ + rankSize_;
             rankDepthOffset_ = rankFeatOffset_ + rankSize_;
         }
+        // UB中每行特征按32B对齐，channel非对齐时尾部填充
+        cAligned_ = AlignUp(channel_, BLK_NUM_T);
+        // in buffer: depth(32B) [+ depth_lse(32B)] + feat(cAligned)
+        featOffset_ = depth_softmax ? 2 * BLK_NUM_T : BLK_NUM_T;
+        featCopyParams_.blockLen = channel_ * sizeof(T);
+        outCopyParams_.blockLen = channel_ * sizeof(float);
     }
 
-    __aicore__ inline void InitGM(
-        GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat, GM_ADDR ranksBev, GM_ADDR out)
+    __aicore__ inline void InitGM(GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat,
+        GM_ADDR ranksBev, GM_ADDR depthLse, GM_ADDR out)
     {
+        if (depth_softmax) {
+            depthLseGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(depthLse));
+        }
         if (with_depth) {
-            depthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(depth));
+            depthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ T*>(depth));
             ranksDepthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksDepth));
             ranksFeatGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksFeat));
         }
-        featGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(feat));
+        featGm_.SetGlobalBuffer(reinterpret_cast<__gm__ T*>(feat));
         ranksBevGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksBev));
         outGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(out));
     }
@@ -65,11 +74,20 @@ private:
     {
         if (with_depth) {
             pipe_->InitBuffer(ranksQue_, 1, 3 * rankSize_ * sizeof(int32_t));
-            pipe_->InitBuffer(inQue_, 2, (B32_DATA_NUM_PER_BLOCK + channel_) * sizeof(int32_t));
-            pipe_->InitBuffer(outQue_, 2, channel_ * sizeof(float));
+            pipe_->InitBuffer(inQue_, 2, (featOffset_ + cAligned_) * sizeof(T));
+            pipe_->InitBuffer(outQue_, 2, cAligned_ * sizeof(float));
+            if (!IS_FLOAT) {
+                pipe_->InitBuffer(castBuf_, (B32_DATA_NUM_PER_BLOCK + cAligned_) * sizeof(float));
+            }
         } else {
             pipe_->InitBuffer(ranksQue_, 2, rankSize_ * sizeof(int32_t));
-            pipe_->InitBuffer(inQue_, 2, rankSize_ * channel_ * sizeof(int32_t));
+            pipe_->InitBuffer(inQue_, 2, rankSize_ * cAligned_ * sizeof(T));
+            if (!IS_FLOAT) {
+                pipe_->InitBuffer(castBuf_, rankSize_ * cAligned_ * sizeof(float));
+            }
+        }
+        if (!IS_FLOAT) {
+            castLocal_ = castBuf_.Get<float>();
         }
     }
 
@@ -77,9 +95,11 @@ private:
     {
         cpInEvtID_ = pipe_->FetchEventID(HardEvent::MTE2_MTE3);
         cpOutEvtID_ = pipe_->FetchEventID(HardEvent::MTE3_MTE2);
+        vsEvtID_ = pipe_->FetchEventID(HardEvent::V_S);
+        vMte3EvtID_ = pipe_->FetchEventID(HardEvent::V_MTE3);
     }
 
-    __aicore__ inline void CopyIn(uint64_t rd, uint64_t rf);
+    __aicore__ inline void CopyIn(uint64_t rd, uint64_t rf, uint64_t rp);
 
     __aicore__ inline void Compute();
 
@@ -88,53 +108,90 @@ private:
     __aicore__ inline void ProcessSingle(uint64_t taskIdx, uint32_t rankNum);
 
 private:
+    static constexpr bool IS_FLOAT = sizeof(T) == sizeof(float);
+    static constexpr int32_t BLK_NUM_T = ONE_BLK_SIZE / sizeof(T);
+
     TPipe* pipe_;
     int32_t blkIdx_;
-    GlobalTensor<float> depthGm_, featGm_, outGm_;
+    GlobalTensor<T> depthGm_, featGm_;
+    GlobalTensor<float> depthLseGm_, outGm_;
     GlobalTensor<int32_t> ranksDepthGm_, ranksFeatGm_, ranksBevGm_;
     TQue<TPosition::VECIN, 1> ranksQue_;
     TQue<TPosition::VECIN, 2> inQue_;
     TQue<TPosition::VECOUT, 2> outQue_;
+    TBuf<TPosition::VECCALC> castBuf_;
+    LocalTensor<float> castLocal_;
 
     uint32_t taskStartIdx_, taskEndIdx_, totalTaskNum_;
-    int32_t channel_;
+    int32_t channel_, cAligned_;
     uint32_t rankSize_, avgRankNum_, tailRankNum_;
     uint64_t rankDepthOffset_, rankFeatOffset_, rankBevOffset_;
+    uint32_t featOffset_;
 
-    TEventID cpInEvtID_, cpOutEvtID_;
+    DataCopyExtParams featCopyParams_ {1, 0, 0, 0, 0};
+    DataCopyExtParams outCopyParams_ {1, 0, 0, 0, 0};
+    DataCopyPadExtParams<T> padParams_ {false, 0, 0, 0};
+
+    TEventID cpInEvtID_, cpOutEvtID_, vsEvtID_, vMte3EvtID_;
 };
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3Kernel<with_depth>::CopyIn(uint64_t rd, uint64_t rf)
+template<typename T, bool with_depth, bool depth_softmax>
+__aicore__ inline void BEVPoolV3Kernel<T, with_depth, depth_softmax>::CopyIn(uint64_t rd, uint64_t rf, uint64_t rp)
 {
-    LocalTensor<float> in = inQue_.AllocTensor<float>();
-    DataCopy(in, depthGm_[rd], B32_DATA_NUM_PER_BLOCK);
-    DataCopy(in[8], featGm_[rf], channel_);
+    LocalTensor<T> in = inQue_.AllocTensor<T>();
+    DataCopy(in, depthGm_[rd], BLK_NUM_T);
+    if (depth_softmax) {
+        LocalTensor<float> lse = in[BLK_NUM_T].template ReinterpretCast<float>();
+        DataCopy(lse, depthLseGm_[rp], B32_DATA_NUM_PER_BLOCK);
+    }
+    DataCopyPad(in[featOffset_], featGm_[rf], featCopyParams_, padParams_);
     inQue_.EnQue(in);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3Kernel<with_depth>::Compute()
+template<typename T, bool with_depth, bool depth_softmax>
+__aicore__ inline void BEVPoolV3Kernel<T, with_depth, depth_softmax>::Compute()
 {
-    LocalTensor<float> in = inQue_.DeQue<float>();
+    LocalTensor<T> in = inQue_.DeQue<T>();
     LocalTensor<float> out = outQue_.AllocTensor<float>();
-    Muls(out, in[8], in.GetValue(0), channel_);
+    LocalTensor<float> depth, feat;
+    if constexpr (IS_FLOAT) {
+        depth = in;
+        feat = in[featOffset_];
+    } else {
+        // fp16/bf16输入转换为fp32计算，结果以fp32原子累加
+        depth = castLocal_;
+        feat = castLocal_[B32_DATA_NUM_PER_BLOCK];
+        Cast(depth, in, RoundMode::CAST_NONE, B32_DATA_NUM_PER_BLOCK);
+        Cast(feat, in[featOffset_], RoundMode::CAST_NONE, channel_);
+    }
+    if (depth_softmax) {
+        // depth中为logits，depth_lse为每个像素沿D方向的logsumexp，概率为exp(logit - lse)
+        LocalTensor<float> lse = in[BLK_NUM_T].template ReinterpretCast<float>();
+        Sub(depth, depth, lse, B32_DATA_NUM_PER_BLOCK);
+        Exp(depth, depth, B32_DATA_NUM_PER_BLOCK);
+    }
+    if (depth_softmax || !IS_FLOAT) {
+        SetFlag<HardEvent::V_S>(vsEvtID_);
+        WaitFlag<HardEvent::V_S>(vsEvtID_);
+    }
+    Muls(out, feat, depth.GetValue(0), channel_);
     inQue_.FreeTensor(in);
     outQue_.EnQue(out);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3Kernel<with_depth>::CopyOut(uint64_t rb)
+template<typename T, bool with_depth, bool depth_softmax>
+__aicore__ inline void BEVPoolV3Kernel<T, with_depth, depth_softmax>::CopyOut(uint64_t rb)
 {
     LocalTensor<float> out = outQue_.DeQue<float>();
     SetAtomicAdd<float>();
-    DataCopy(outGm_[rb], out, channel_);
+    DataCopyPad(outGm_[rb], out, outCopyParams_);
     SetAtomicNone();
     outQue_.FreeTensor(out);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3Kernel<with_depth>::ProcessSingle(uint64_t taskIdx, uint32_t actualRankNum)
+template<typename T, bool with_depth, bool depth_softmax>
+__aicore__ inline void BEVPoolV3Kernel<T, with_depth, depth_softmax>::ProcessSingle(
+    uint64_t taskIdx, uint32_t actualRankNum)
 {
     int32_t rankNum = AlignUp(actualRankNum, B32_DATA_NUM_PER_BLOCK);
 
@@ -154,7 +211,9 @@ __aicore__ inline void BEVPoolV3Kernel<with_depth>::ProcessSingle(uint64_t taskI
             uint64_t rd = rankDepth.GetValue(i);
             uint64_t rf = rankFeat.GetValue(i);
             uint64_t rb = rankBev.GetValue(i);
-            CopyIn(rd, rf);
+            // ranks_feat即depth所在像素的索引
+            uint64_t rp = depth_softmax ? rf / channel_ : 0;
+            CopyIn(rd, rf, rp);
             Compute();
             CopyOut(rb);
         }
@@ -162,13 +221,26 @@ __aicore__ inline void BEVPoolV3Kernel<with_depth>::ProcessSingle(uint64_t taskI
         ranksQue_.EnQue(ranks);
         ranksQue_.DeQue<int32_t>();
         Muls(rankBev, rankBev, channel_, rankNum);
-        LocalTensor<float> in = inQue_.AllocTensor<float>();
-        DataCopy(in, featGm_[taskIdx * avgRankNum_ * channel_], actualRankNum * channel_);
-        SetFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
-        WaitFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
+        LocalTensor<T> in = inQue_.AllocTensor<T>();
+        DataCopyExtParams rowsCopyParams {
+            static_cast<uint16_t>(actualRankNum), static_cast<uint32_t>(channel_ * sizeof(T)), 0, 0, 0};
+        DataCopyPad(in, featGm_[taskIdx * avgRankNum_ * channel_], rowsCopyParams, padParams_);
+        LocalTensor<float> rows;
+        if constexpr (IS_FLOAT) {
+            rows = in;
+            SetFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
+            WaitFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
+        } else {
+            inQue_.EnQue(in);
+            in = inQue_.DeQue<T>();
+            rows = castLocal_;
+            Cast(rows, in, RoundMode::CAST_NONE, actualRankNum * cAligned_);
+            SetFlag<HardEvent::V_MTE3>(vMte3EvtID_);
+            WaitFlag<HardEvent::V_MTE3>(vMte3EvtID_);
+        }
         for (int32_t i = 0; i < actualRankNum; ++i) {
             SetAtomicAdd<float>();
-            DataCopy(outGm_[rankBev.GetValue(i)], in[i * channel_], channel_);
+            DataCopyPad(outGm_[rankBev.GetValue(i)], rows[i * cAligned_], outCopyParams_);
             SetAtomicNone();
         }
         SetFlag<HardEvent::MTE3_MTE2>(cpOutEvtID_);
@@ -178,8 +250,8 @@ __aicore__ inline void BEVPoolV3Kernel<with_depth>::ProcessSingle(uint64_t taskI
     ranksQue_.FreeTensor(ranks);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3Kernel<with_depth>::Process()
+template<typename T, bool with_depth, bool depth_softmax>
+__aicore__ inline void BEVPoolV3Kernel<T, with_depth, depth_softmax>::Process()
 {
     for (uint32_t i = taskStartIdx_; i < taskEndIdx_; ++i) {
         uint32_t actualRankNum = avgRankNum_;
@@ -190,16 +262,51 @@ __aicore__ inline void BEVPoolV3Kernel<with_depth>::Process()
     }
 }
 
+template<typename T>
+__aicore__ inline void RunBEVPoolV3(GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat,
+    GM_ADDR ranksBev, GM_ADDR depthLse, GM_ADDR out, const BEVPoolV3TilingData& tiling, int32_t mode)
+{
+    TPipe pipe;
+    if (mode == 0) {
+        BEVPoolV3Kernel<T, false, false> kernel(
+            &pipe, depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, tiling);
+        kernel.Process();
+    } else if (mode == 1) {
+        BEVPoolV3Kernel<T, true, false> kernel(
+            &pipe, depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, tiling);
+        kernel.Process();
+    } else {
+        BEVPoolV3Kernel<T, true, true> kernel(
+            &pipe, depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, tiling);
+        kernel.Process();
+    }
+}
+
 extern "C" __global__ __aicore__ void bev_pool_v3(GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat,
-    GM_ADDR ranksBev, GM_ADDR out, GM_ADDR workspace, GM_ADDR tiling)
+    GM_ADDR ranksBev, GM_ADDR depthLse, GM_ADDR out, GM_ADDR workspace, GM_ADDR tiling)
 {
     GET_TILING_DATA(bevPoolTiling, tiling);
-    TPipe pipe;
+// the tiling key represented as below:
+// +----+----+-------+-----+
+// |bf16|fp16|softmax|depth|
+// +----+----+-------+-----+
     if (TILING_KEY_IS(0)) {
-        BEVPoolV3Kernel<false> kernel(&pipe, depth, feat, ranksDepth, ranksFeat, ranksBev, out, bevPoolTiling);
-        kernel.Process();
+        RunBEVPoolV3<float>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 0);
     } else if (TILING_KEY_IS(1)) {
-        BEVPoolV3Kernel<true> kernel(&pipe, depth, feat, ranksDepth, ranksFeat, ranksBev, out, bevPoolTiling);
-        kernel.Process();
+        RunBEVPoolV3<float>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 1);
+    } else if (TILING_KEY_IS(3)) {
+        RunBEVPoolV3<float>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 2);
+    } else if (TILING_KEY_IS(4)) {
+        RunBEVPoolV3<half>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 0);
+    } else if (TILING_KEY_IS(5)) {
+        RunBEVPoolV3<half>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 1);
+    } else if (TILING_KEY_IS(7)) {
+        RunBEVPoolV3<half>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 2);
+    } else if (TILING_KEY_IS(8)) {
+        RunBEVPoolV3<bfloat16_t>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 0);
+    } else if (TILING_KEY_IS(9)) {
+        RunBEVPoolV3<bfloat16_t>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 1);
+    } else if (TILING_KEY_IS(11)) {
+        RunBEVPoolV3<bfloat16_t>(depth, feat, ranksDepth, ranksFeat, ranksBev, depthLse, out, bevPoolTiling, 2);
     }
 }
@@ -1,7 +1,7 @@
 #include "kernel_operator.h"
 using namespace AscendC;
 
-template<bool with_depth>
+template<typename T, bool with_depth>
 class BEVPoolV3GradKernel {
 public:
     __aicore__ inline BEVPoolV3GradKernel() = delete;
@@ -45,22 +45,26 @@ private:
         if (with_depth) {
             rankFeatOffset_ = rankBevOffset_ + rankSize_;
             rankDepthOffset_ = rankFeatOffset_ + rankSize_;
-            rankFeatOffset_ = rankBevOffset_ + rankSize_;
-            rankDepthOffset_ = rankFeatOffset_ + rankSize_;
-            inFeatOffset_ = B32_DATA_NUM_PER_BLOCK;
-            inBevOffset_ = inFeatOffset_ + channel_;
         }
+        // UB中每行按32B对齐，channel非对齐时尾部填充
+        cAligned_ = AlignUp(channel_, BLK_NUM_T);
+        gradAligned_ = AlignUp(channel_, B32_DATA_NUM_PER_BLOCK);
+        // in buffer: depth(32B) + feat(cAligned, T) + grad_out(gradAligned, float)
+        inFeatOffset_ = BLK_NUM_T;
+        inBevOffset_ = inFeatOffset_ + cAligned_;
+        featCopyParams_.blockLen = channel_ * sizeof(T);
+        gradCopyParams_.blockLen = channel_ * sizeof(float);
     }
 
     __aicore__ inline void InitGM(GM_ADDR gradOut, GM_ADDR depth, GM_ADDR feat, GM_ADDR ranksDepth, GM_ADDR ranksFeat,
         GM_ADDR ranksBev, GM_ADDR gradDepth, GM_ADDR gradFeat)
     {
         gradOutGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(gradOut));
-        featGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(feat));
+        featGm_.SetGlobalBuffer(reinterpret_cast<__gm__ T*>(feat));
         ranksBevGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksBev));
         gradFeatGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(gradFeat));
         if (with_depth) {
-            depthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(depth));
+            depthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ T*>(depth));
             ranksDepthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksDepth));
             ranksFeatGm_.SetGlobalBuffer(reinterpret_cast<__gm__ int32_t*>(ranksFeat));
             gradDepthGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(gradDepth));
@@ -71,11 +75,15 @@ private:
     {
         if (with_depth) {
             pipe_->InitBuffer(ranksQue_, 1, 3 * rankSize_ * sizeof(int32_t));
-            pipe_->InitBuffer(inQue_, 2, (B32_DATA_NUM_PER_BLOCK + channel_ * 2) * sizeof(int32_t));
-            pipe_->InitBuffer(outQue_, 2, channel_ * 3 * sizeof(float));
+            pipe_->InitBuffer(inQue_, 2, (BLK_NUM_T + cAligned_) * sizeof(T) + gradAligned_ * sizeof(float));
+            pipe_->InitBuffer(outQue_, 2, gradAligned_ * 3 * sizeof(float));
+            if (!IS_FLOAT) {
+                pipe_->InitBuffer(castBuf_, (B32_DATA_NUM_PER_BLOCK + cAligned_) * sizeof(float));
+                castLocal_ = castBuf_.Get<float>();
+            }
         } else {
             pipe_->InitBuffer(ranksQue_, 2, rankSize_ * sizeof(int32_t));
-            pipe_->InitBuffer(inQue_, 2, rankSize_ * channel_ * sizeof(int32_t));
+            pipe_->InitBuffer(inQue_, 2, rankSize_ * gradAligned_ * sizeof(float));
         }
     }
 
@@ -83,6 +91,7 @@ private:
     {
         cpInEvtID_ = pipe_->FetchEventID(HardEvent::MTE2_MTE3);
         cpOutEvtID_ = pipe_->FetchEventID(HardEvent::MTE3_MTE2);
+        vsEvtID_ = pipe_->FetchEventID(HardEvent::V_S);
     }
 
     __aicore__ inline void CopyIn(uint64_t rd, uint64_t rf, uint64_t rb);
@@ -94,59 +103,84 @@ private:
     __aicore__ inline void ProcessSingle(uint64_t taskIdx, uint32_t actualRankNum);
 
 private:
+    static constexpr bool IS_FLOAT = sizeof(T) == sizeof(float);
+    static constexpr int32_t BLK_NUM_T = ONE_BLK_SIZE / sizeof(T);
+
     TPipe* pipe_;
     int32_t blkIdx_;
-    GlobalTensor<float> gradOutGm_, depthGm_, featGm_, gradDepthGm_, gradFeatGm_;
+    GlobalTensor<T> depthGm_, featGm_;
+    GlobalTensor<float> gradOutGm_, gradDepthGm_, gradFeatGm_;
     GlobalTensor<int32_t> ranksDepthGm_, ranksFeatGm_, ranksBevGm_;
     TQue<TPosition::VECIN, 1> ranksQue_;
     TQue<TPosition::VECIN, 2> inQue_;
     TQue<TPosition::VECOUT, 2> outQue_;
+    TBuf<TPosition::VECCALC> castBuf_;
+    LocalTensor<float> castLocal_;
 
     uint64_t taskStartIdx_, taskEndIdx_, totalTaskNum_;
-    int32_t channel_;
+    int32_t channel_, cAligned_, gradAligned_;
     uint32_t avgRankNum_, tailRankNum_, rankSize_;
     uint64_t rankDepthOffset_, rankFeatOffset_, rankBevOffset_, inFeatOffset_, inBevOffset_;
 
     DataCopyParams cpSingleParams_ {1, B32_BYTE_SIZE, 0, 0};
+    DataCopyExtParams featCopyParams_ {1, 0, 0, 0, 0};
+    DataCopyExtParams gradCopyParams_ {1, 0, 0, 0, 0};
+    DataCopyPadExtParams<T> featPadParams_ {false, 0, 0, 0};
+    DataCopyPadExtParams<float> gradPadParams_ {false, 0, 0, 0};
 
-    TEventID cpInEvtID_, cpOutEvtID_;
+    TEventID cpInEvtID_, cpOutEvtID_, vsEvtID_;
 };
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3GradKernel<with_depth>::CopyIn(uint64_t rd, uint64_t rf, uint64_t rb)
+template<typename T, bool with_depth>
+__aicore__ inline void BEVPoolV3GradKernel<T, with_depth>::CopyIn(uint64_t rd, uint64_t rf, uint64_t rb)
 {
-    LocalTensor<float> in = inQue_.AllocTensor<float>();
-    DataCopy(in, depthGm_[rd], B32_DATA_NUM_PER_BLOCK);
-    DataCopy(in[inFeatOffset_], featGm_[rf], channel_);
-    DataCopy(in[inBevOffset_], gradOutGm_[rb], channel_);
+    LocalTensor<T> in = inQue_.AllocTensor<T>();
+    DataCopy(in, depthGm_[rd], BLK_NUM_T);
+    DataCopyPad(in[inFeatOffset_], featGm_[rf], featCopyParams_, featPadParams_);
+    LocalTensor<float> gradOut = in[inBevOffset_].template ReinterpretCast<float>();
+    DataCopyPad(gradOut, gradOutGm_[rb], gradCopyParams_, gradPadParams_);
     inQue_.EnQue(in);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3GradKernel<with_depth>::Compute()
+template<typename T, bool with_depth>
+__aicore__ inline void BEVPoolV3GradKernel<T, with_depth>::Compute()
 {
-    LocalTensor<float> in = inQue_.DeQue<float>();
+    LocalTensor<T> in = inQue_.DeQue<T>();
     LocalTensor<float> out = outQue_.AllocTensor<float>();
-    Muls(out, in[inBevOffset_], in.GetValue(0), channel_);             // gradFeat = gradOut * depth
-    Mul(out[channel_], in[inBevOffset_], in[inFeatOffset_], channel_); // gradDepth = \sum(gradOut * feat)
-    ReduceSum(out[channel_], out[channel_], out[2 * channel_], channel_);
+    LocalTensor<float> gradOut = in[inBevOffset_].template ReinterpretCast<float>();
+    LocalTensor<float> depth, feat;
+    if constexpr (IS_FLOAT) {
+        depth = in;
+        feat = in[inFeatOffset_];
+    } else {
+        // fp16/bf16输入转换为fp32计算
+        depth = castLocal_;
+        feat = castLocal_[B32_DATA_NUM_PER_BLOCK];
+        Cast(depth, in, RoundMode::CAST_NONE, B32_DATA_NUM_PER_BLOCK);
+        Cast(feat, in[inFeatOffset_], RoundMode::CAST_NONE, channel_);
+        SetFlag<HardEvent::V_S>(vsEvtID_);
+        WaitFlag<HardEvent::V_S>(vsEvtID_);
+    }
+    Muls(out, gradOut, depth.GetValue(0), channel_);              // gradFeat = gradOut * depth
+    Mul(out[gradAligned_], gradOut, feat, channel_);               // gradDepth = \sum(gradOut * feat)
+    ReduceSum(out[gradAligned_], out[gradAligned_], out[2 * gradAligned_], channel_);
     inQue_.FreeTensor(in);
     outQue_.EnQue(out);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3GradKernel<with_depth>::CopyOut(uint64_t rd, uint64_t rf)
+template<typename T, bool with_depth>
+__aicore__ inline void BEVPoolV3GradKernel<T, with_depth>::CopyOut(uint64_t rd, uint64_t rf)
 {
     LocalTensor<float> out = outQue_.DeQue<float>();
     SetAtomicAdd<float>();
-    DataCopy(gradFeatGm_[rf], out, channel_);
-    DataCopyPad(gradDepthGm_[rd], out[channel_], cpSingleParams_);
+    DataCopyPad(gradFeatGm_[rf], out, gradCopyParams_);
+    DataCopyPad(gradDepthGm_[rd], out[gradAligned_], cpSingleParams_);
     SetAtomicNone();
     outQue_.FreeTensor(out);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3GradKernel<with_depth>::ProcessSingle(uint64_t taskIdx, uint32_t actualRankNum)
+template<typename T, bool with_depth>
+__aicore__ inline void BEVPoolV3GradKernel<T, with_depth>::ProcessSingle(uint64_t taskIdx, uint32_t actualRankNum)
 {
     int32_t rankNum = AlignUp(actualRankNum, B32_DATA_NUM_PER_BLOCK);
     LocalTensor<int32_t> ranks = ranksQue_.AllocTensor<int32_t>();
@@ -178,11 +212,13 @@ __aicore__ inline void BEVPoolV3GradKernel<with_depth>::ProcessSingle(uint64_t t
         LocalTensor<float> in = inQue_.AllocTensor<float>();
 
         for (int32_t i = 0; i < actualRankNum; ++i) {
-            DataCopy(in[i * channel_], gradOutGm_[rankBev.GetValue(i)], channel_);
+            DataCopyPad(in[i * gradAligned_], gradOutGm_[rankBev.GetValue(i)], gradCopyParams_, gradPadParams_);
         }
         SetFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
         WaitFlag<HardEvent::MTE2_MTE3>(cpInEvtID_);
-        DataCopy(gradFeatGm_[taskIdx * avgRankNum_ * channel_], in, actualRankNum * channel_);
+        DataCopyExtParams rowsCopyParams {
+            static_cast<uint16_t>(actualRankNum), static_cast<uint32_t>(channel_ * sizeof(float)), 0, 0, 0};
+        DataCopyPad(gradFeatGm_[taskIdx * avgRankNum_ * channel_], in, rowsCopyParams);
         SetFlag<HardEvent::MTE3_MTE2>(cpOutEvtID_);
         WaitFlag<HardEvent::MTE3_MTE2>(cpOutEvtID_);
         inQue_.FreeTensor(in);
@@ -190,8 +226,8 @@ __aicore__ inline void BEVPoolV3GradKernel<with_depth>::ProcessSingle(uint64_t t
     ranksQue_.FreeTensor(ranks);
 }
 
-template<bool with_depth>
-__aicore__ inline void BEVPoolV3GradKernel<with_depth>::Process()
+template<typename T, bool with_depth>
+__aicore__ inline void BEVPoolV3GradKernel<T, with_depth>::Process()
 {
     for (uint32_t i = taskStartIdx_; i < taskEndIdx_; ++i) {
         uint32_t actualRankNum = avgRankNum_;
@@ -207,12 +243,25 @@ extern "C" __global__ __aicore__ void bev_pool_v3_grad(GM_ADDR gradOut, GM_ADDR
 {
     GET_TILING_DATA(bevPoolTiling, tiling);
     TPipe pipe;
+// the tiling key represented as below, grad_out and grads are always fp32:
+// +----+----+-+-----+
+// |bf16|fp16|-|depth|
+// +----+----+-+-----+
     if (TILING_KEY_IS(0)) {
-        BEVPoolV3GradKernel<false> kernel(
+        // 不带depth时反向只搬运grad_out，与feat数据类型无关
+        BEVPoolV3GradKernel<float, false> kernel(
             &pipe, gradOut, depth, feat, ranksDepth, ranksFeat, ranksBev, gradDepth, gradFeat, bevPoolTiling);
         kernel.Process();
     } else if (TILING_KEY_IS(1)) {
-        BEVPoolV3GradKernel<true> kernel(
+        BEVPoolV3GradKernel<float, true> kernel(
+            &pipe, gradOut, depth, feat, ranksDepth, ranksFeat, ranksBev, gradDepth, gradFeat, bevPoolTiling);
+        kernel.Process();
+    } else if (TILING_KEY_IS(5)) {
+        BEVPoolV3GradKernel<half, true> kernel(
+            &pipe, gradOut, depth, feat, ranksDepth, ranksFeat, ranksBev, gradDepth, gradFeat, bevPoolTiling);
+        kernel.Process();
+    } else if (TILING_KEY_IS(9)) {
+        BEVPoolV3GradKernel<bfloat16_t, true> kernel(
             &pipe, gradOut, depth, feat, ranksDepth, ranksFeat, ranksBev, gradDepth, gradFeat, bevPoolTiling);
         kernel.Process();
     }
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2025. All rights reserved.
+ */
+#include "kernel_operator.h"
+#include "kernel_tiling/kernel_tiling.h"
+#include "kernel_utils.h"
+using namespace AscendC;
+
+constexpr int32_t BUFFER_NUM = 1;
+constexpr int32_t BOX_INFO_NUM = 4;
+constexpr int32_t MASK_ALIGN = 32;
+constexpr int32_t BITS_PER_BYTE = 8;
+
+// 与BorderAlign的分核、插值方式一致，但每条边在UB上维护采样点的running max与argmax，
+// 只写出(B, H * W, 4, C / 4)的max与int32的argmax，不写出(pooled_size + 1)倍的中间结果
+class BorderAlignMax {
+public:
+    __aicore__ inline BorderAlignMax() {}
+    __aicore__ inline void Init(GM_ADDR featureMap, GM_ADDR rois, GM_ADDR featureOut, GM_ADDR argmaxIdx,
+        const BorderAlignTilingData *tiling_data)
+    {
+        batchSize = tiling_data->batchSize; // 输入特征的batch大小
+        channels = tiling_data->channels; // 输入特征的通道长度
+        inputH = tiling_data->inputH; // 输入特征的高度
+        inputW = tiling_data->inputW; // 输入特征的宽度
+        pooledSize = tiling_data->pooledSize; // 在每条边计算采样点个数
+        roisNumAligned = tiling_data->roisNumAligned; // 对齐之后的RoI总数
+        tailNum = tiling_data->tailNum; // tailNum = roisNumAligned - roisNum
+        roisNumPerLcore = tiling_data->roisNumPerLcore; // 每个大核分配的RoI数
+        roisNumPerScore = tiling_data->roisNumPerScore; // 每个小核分配的RoI数
+        lcoreNum = tiling_data->lcoreNum; // 大核数量
+        inputBufferSize = tiling_data->inputBufferSize; // 每条边一个通道段的Buffer大小，按Compare要求对齐
+        roisBufferSize = tiling_data->roisBufferSize; // 搬运RoI的Tque Buffer大小
+        roisNumPerLoop = tiling_data->roisNumPerLoop; // 每次搬运到UB的RoI数量
+        moveInLength = tiling_data->moveInLength; // 每次搬入的Feature长度
+        moveOutLength = tiling_data->moveOutLength; // 每次搬出的字节数，float与int32相同
+        computeLength = inputBufferSize / sizeof(float); // 比较与选择的长度
+        roisNum = roisNumAligned - tailNum;
+        uint64_t totalInputLength = static_cast<uint64_t>(batchSize) * inputH * inputW * channels;
+
+        if (GetBlockIdx() < lcoreNum) {
+            roisNumPerCore = roisNumPerLcore;
+            roisStartAddr = GetBlockIdx() * roisNumPerLcore * BOX_INFO_NUM;
+        } else {
+            roisNumPerCore = roisNumPerScore;
+            roisStartAddr = (lcoreNum * roisNumPerLcore + (GetBlockIdx() - lcoreNum) * roisNumPerScore) * BOX_INFO_NUM;
+        }
+        totalLoop = (roisNumPerCore + roisNumPerLoop - 1) / roisNumPerLoop;
+
+        featureGm.SetGlobalBuffer((__gm__ DTYPE_INPUT *)featureMap, totalInputLength);
+        roisGm.SetGlobalBuffer((__gm__ DTYPE_ROIS *)rois, static_cast<uint64_t>(roisNumAligned) * BOX_INFO_NUM);
+        outputGm.SetGlobalBuffer((__gm__ DTYPE_OUTPUT *)featureOut, totalInputLength);
+        argmaxGm.SetGlobalBuffer((__gm__ int32_t *)argmaxIdx, totalInputLength);
+
+        pipe.InitBuffer(inQueueBox, BUFFER_NUM, roisBufferSize);
+        pipe.InitBuffer(inQueueFeatureFloorFloor, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(inQueueFeatureFloorCeil, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(inQueueFeatureCeilFloor, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(inQueueFeatureCeilCeil, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(outQueueMax, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(outQueueArgmax, BUFFER_NUM, inputBufferSize);
+        pipe.InitBuffer(valueBuf, inputBufferSize);
+        pipe.InitBuffer(indexBuf, inputBufferSize);
+        pipe.InitBuffer(maskBuf, (computeLength / BITS_PER_BYTE + MASK_ALIGN - 1) / MASK_ALIGN * MASK_ALIGN);
+    }
+    __aicore__ inline void Process()
+    {
+        featureFloorFloor = inQueueFeatureFloorFloor.AllocTensor<float>();
+        featureFloorCeil = inQueueFeatureFloorCeil.AllocTensor<float>();
+        featureCeilFloor = inQueueFeatureCeilFloor.AllocTensor<float>();
+        featureCeilCeil = inQueueFeatureCeilCeil.AllocTensor<float>();
+        maxFeature = outQueueMax.AllocTensor<float>(); // 当前边的running max
+        argmaxLocal = outQueueArgmax.AllocTensor<int32_t>(); // argmax转为int32后搬出
+        boxLocal = inQueueBox.AllocTensor<float>();
+        value = valueBuf.Get<float>(); // 当前采样点的插值结果
+        index = indexBuf.Get<float>(); // 以float保存的argmax，便于Select
+        mask = maskBuf.Get<uint8_t>();
+        for (int32_t loopIdx = 0; loopIdx < totalLoop; loopIdx++) {
+            CopyInBoxes(loopIdx);
+            Compute(loopIdx);
+        }
+        inQueueFeatureFloorFloor.FreeTensor(featureFloorFloor);
+        inQueueFeatureFloorCeil.FreeTensor(featureFloorCeil);
+        inQueueFeatureCeilFloor.FreeTensor(featureCeilFloor);
+        inQueueFeatureCeilCeil.FreeTensor(featureCeilCeil);
+        outQueueMax.FreeTensor(maxFeature);
+        outQueueArgmax.FreeTensor(argmaxLocal);
+        inQueueBox.FreeTensor(boxLocal);
+    }
+
+private:
+    __aicore__ inline void CopyInBoxes(int32_t loopIdx)
+    {
+        DataCopy(boxLocal, roisGm[loopIdx * roisNumPerLoop * BOX_INFO_NUM + roisStartAddr],
+            roisNumPerLoop * BOX_INFO_NUM);
+        inQueueBox.EnQue(boxLocal);
+        boxLocal = inQueueBox.DeQue<float>();
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void Compute(int32_t loopIdx)
+    {
+        for (int32_t boxIdx = 0; boxIdx < roisNumPerLoop; boxIdx++) {
+            ComputeOneBox(loopIdx, boxIdx);
+        }
+    }
+
+    __aicore__ inline void ComputeOneBox(int32_t loopIdx, int32_t boxIdx)
+    {
+        uint32_t localIdx = loopIdx * roisNumPerLoop + boxIdx;
+        uint32_t boxIdx_ = localIdx + roisStartAddr / BOX_INFO_NUM;
+        // 超过本核需要计算的RoI数或RoI总数时跳过
+        if (localIdx >= roisNumPerCore || boxIdx_ >= roisNum) {
+            return;
+        }
+
+        float x1 = boxLocal.GetValue(BOX_INFO_NUM * boxIdx), y1 = boxLocal.GetValue(BOX_INFO_NUM * boxIdx + 1);
+        float x2 = boxLocal.GetValue(BOX_INFO_NUM * boxIdx + 2), y2 = boxLocal.GetValue(BOX_INFO_NUM * boxIdx + 3);
+        float dx = (x2 - x1) / static_cast<float>(pooledSize);
+        float dy = (y2 - y1) / static_cast<float>(pooledSize);
+        uint32_t batchIdx = boxIdx_ / (inputH * inputW);
+        uint64_t baseAddrCopyIn = static_cast<uint64_t>(batchIdx) * channels * inputH * inputW;
+        // 输出与输入的NHWC布局相同，第boxIdx_个像素的4C个通道依次为上、左、下、右四条边
+        uint64_t baseAddrCopyOut = static_cast<uint64_t>(boxIdx_) * channels;
+        // 上、左边从(x1, y1)出发，下、右边从(x2, y2)出发
+        ComputeOneSide(x1, y1, dx, 0, baseAddrCopyIn, baseAddrCopyOut, 0);
+        ComputeOneSide(x1, y1, 0, dy, baseAddrCopyIn, baseAddrCopyOut, 1);
+        ComputeOneSide(x2, y2, -dx, 0, baseAddrCopyIn, baseAddrCopyOut, 2);
+        ComputeOneSide(x2, y2, 0, -dy, baseAddrCopyIn, baseAddrCopyOut, 3);
+    }
+
+    __aicore__ inline void ComputeOneSide(float xLoc, float yLoc, float stepX, float stepY, uint64_t baseAddrCopyIn,
+        uint64_t baseAddrCopyOut, int32_t channelIdx)
+    {
+        BilinearInterpolate(xLoc, yLoc, baseAddrCopyIn, channelIdx);
+        Adds(maxFeature, value, 0.0f, computeLength);
+        Duplicate(index, 0.0f, computeLength);
+        for (int32_t poolIdx = 1; poolIdx < pooledSize + 1; poolIdx++) {
+            xLoc = xLoc + stepX;
+            yLoc = yLoc + stepY;
+            BilinearInterpolate(xLoc, yLoc, baseAddrCopyIn, channelIdx);
+            // 相等时保留靠前的采样点：value <= max的位置保留原下标，其余取poolIdx
+            Compare(mask, value, maxFeature, CMPMODE::LE, computeLength);
+            Select(index, mask, index, static_cast<float>(poolIdx), SELMODE::VSEL_TENSOR_SCALAR_MODE, computeLength);
+            Max(maxFeature, maxFeature, value, computeLength);
+        }
+        Cast(argmaxLocal, index, RoundMode::CAST_RINT, computeLength);
+        CopyOut(baseAddrCopyOut + channelIdx * channels / BOX_INFO_NUM);
+    }
+
+    __aicore__ inline void BilinearInterpolate(float xLoc, float yLoc, uint64_t baseAddrCopyIn, int32_t channelIdx)
+    {
+        if (yLoc < -1 || yLoc > inputH || xLoc < -1 || xLoc > inputW) {
+            Duplicate(value, 0.0f, computeLength);
+            return;
+        }
+        xLoc = xLoc < 0 ? 0 : xLoc;
+        yLoc = yLoc < 0 ? 0 : yLoc;
+        int32_t xFloor = static_cast<int32_t>(xLoc);
+        int32_t yFloor = static_cast<int32_t>(yLoc);
+        int32_t xCeil = xFloor + 1;
+        int32_t yCeil = yFloor + 1;
+        if (xFloor >= static_cast<int32_t>(inputW - 1)) {
+            xCeil = inputW - 1;
+            xFloor = xCeil;
+            xLoc = static_cast<float>(xCeil);
+        }
+        if (yFloor >= static_cast<int32_t>(inputH - 1)) {
+            yCeil = inputH - 1;
+            yFloor = yCeil;
+            yLoc = static_cast<float>(yCeil);
+        }
+
+        float lx = xLoc - static_cast<float>(xFloor);
+        float ly = yLoc - static_cast<float>(yFloor);
+        float hx = 1.0f - lx;
+        float hy = 1.0f - ly;
+        uint64_t baseAddrCopyIn_ = baseAddrCopyIn + channelIdx * channels / BOX_INFO_NUM;
+        uint64_t rowFloor = baseAddrCopyIn_ + static_cast<uint64_t>(yFloor) * inputW * channels;
+        uint64_t rowCeil = baseAddrCopyIn_ + static_cast<uint64_t>(yCeil) * inputW * channels;
+
+        set_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
+        wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
+        DataCopy(featureFloorFloor, featureGm[rowFloor + xFloor * channels], moveInLength);
+        inQueueFeatureFloorFloor.EnQue(featureFloorFloor);
+        featureFloorFloor = inQueueFeatureFloorFloor.DeQue<float>();
+        DataCopy(featureFloorCeil, featureGm[rowFloor + xCeil * channels], moveInLength);
+        inQueueFeatureFloorCeil.EnQue(featureFloorCeil);
+        featureFloorCeil = inQueueFeatureFloorCeil.DeQue<float>();
+        DataCopy(featureCeilFloor, featureGm[rowCeil + xFloor * channels], moveInLength);
+        inQueueFeatureCeilFloor.EnQue(featureCeilFloor);
+        featureCeilFloor = inQueueFeatureCeilFloor.DeQue<float>();
+        DataCopy(featureCeilCeil, featureGm[rowCeil + xCeil * channels], moveInLength);
+        inQueueFeatureCeilCeil.EnQue(featureCeilCeil);
+        featureCeilCeil = inQueueFeatureCeilCeil.DeQue<float>();
+        set_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+        wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+        Muls(value, featureFloorFloor, hy * hx, computeLength);
+        Axpy(value, featureFloorCeil, hy * lx, computeLength);
+        Axpy(value, featureCeilFloor, ly * hx, computeLength);
+        Axpy(value, featureCeilCeil, ly * lx, computeLength);
+    }
+
+    __aicore__ inline void CopyOut(uint64_t outAddr)
+    {
+        outQueueMax.EnQue(maxFeature);
+        maxFeature = outQueueMax.DeQue<float>();
+        outQueueArgmax.EnQue(argmaxLocal);
+        argmaxLocal = outQueueArgmax.DeQue<int32_t>();
+        set_flag(PIPE_V, PIPE_MTE3, EVENT_ID5);
+        wait_flag(PIPE_V, PIPE_MTE3, EVENT_ID5);
+        DataCopyExtParams copyParams{1, moveOutLength, 0, 0, 0};
+        DataCopyPad(outputGm[outAddr], maxFeature, copyParams);
+        DataCopyPad(argmaxGm[outAddr], argmaxLocal, copyParams);
+        set_flag(PIPE_MTE3, PIPE_V, EVENT_ID6);
+        wait_flag(PIPE_MTE3, PIPE_V, EVENT_ID6);
+    }
+
+private:
+    TPipe pipe;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueFeatureFloorFloor, inQueueFeatureFloorCeil, inQueueBox;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueFeatureCeilFloor, inQueueFeatureCeilCeil;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueMax, outQueueArgmax;
+    TBuf<TPosition::VECCALC> valueBuf, indexBuf, maskBuf;
+    GlobalTensor<float> featureGm, roisGm, outputGm;
+    GlobalTensor<int32_t> argmaxGm;
+    LocalTensor<float> featureFloorFloor, featureFloorCeil, featureCeilFloor, featureCeilCeil;
+    LocalTensor<float> maxFeature, value, index, boxLocal;
+    LocalTensor<int32_t> argmaxLocal;
+    LocalTensor<uint8_t> mask;
+
+    uint32_t batchSize, inputH, inputW, channels, roisNumAligned, tailNum, roisNum;
+    uint32_t roisNumPerCore, roisNumPerLoop, roisStartAddr, moveInLength, totalLoop, computeLength;
+    uint32_t roisNumPerLcore, roisNumPerScore, lcoreNum, inputBufferSize, roisBufferSize, moveOutLength;
+    int32_t pooledSize;
+};
+
+extern "C" __global__ __aicore__ void border_align_max(GM_ADDR featureMap, GM_ADDR rois, GM_ADDR output,
+    GM_ADDR argmaxIdx, GM_ADDR workspace, GM_ADDR tiling)
+{
+    GET_TILING_DATA(tiling_data, tiling);
+    KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIV_ONLY);
+    BorderAlignMax op;
+    op.Init(featureMap, rois, output, argmaxIdx, &tiling_data);
+    op.Process();
+}
@@ -6,12 +6,13 @@
 #include "kernel_tiling/kernel_tiling.h"
 using namespace AscendC;
 
-template<typename DTYPE_F, typename DTYPE_I>
+template<typename DTYPE_T, typename DTYPE_F, typename DTYPE_I>
 class KernelDeformableAggregation {
 public:
     __aicore__ inline KernelDeformableAggregation() {}
     __aicore__ inline void Init(GM_ADDR mc_ms_feat, GM_ADDR spatial_shape, GM_ADDR scale_start_index,
-        GM_ADDR sampling_location, GM_ADDR weights, GM_ADDR out, const DeformableAggregationTilingData* tiling_data, TPipe *tmpPipe)
+        GM_ADDR sampling_location, GM_ADDR weights, GM_ADDR slot_index, GM_ADDR out,
+        const DeformableAggregationTilingData* tiling_data, TPipe *tmpPipe)
     {
         pipe_ = tmpPipe;
         bs_ = tiling_data->bs;
@@ -24,6 +25,10 @@ public:
         numGroups_ = tiling_data->numGroups;
         cAligned_ = tiling_data->cAligned;
         memoryFlag_ = tiling_data->memoryFlag;
+        groupAligned_ = tiling_data->groupAligned;
+        softmaxFlag_ = tiling_data->softmaxFlag;
+        slotFlag_ = tiling_data->slotFlag;
+        numSlots_ = tiling_data->numSlots;
         coreNum_ = tiling_data->coreNum;
         numChannels_ = numEmbeds_ / numGroups_;
 
@@ -32,8 +37,10 @@ public:
         locBufSize_ = AlignUp(numPoints_ * numCams_ * 2, blockAlign_);
         scaleStartBufSize_ = AlignUp(numCams_ * numScales_, blockAlign_);
         spatialShapeBufSize_ = AlignUp(numCams_ * numScales_ * 2, blockAlign_);
+        groupAlignedNum_ = AlignUp(numGroups_, blockAlign_);
 
-        copyOutParams_ = {1, static_cast<uint32_t>(numEmbeds_ * sizeof(DTYPE_F)), 0, 0, 0};
+        copyInParams_ = {1, static_cast<uint32_t>(numEmbeds_ * sizeof(DTYPE_T)), 0, 0, 0};
+        copyOutParams_ = {1, static_cast<uint32_t>(numEmbeds_ * sizeof(DTYPE_T)), 0, 0, 0};
         srcShape_[0] = numGroups_;
         srcShape_[1] = 1;
         dstShape_[0] = numGroups_;
@@ -41,19 +48,22 @@ public:
 
         ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
 
-        uint64_t mcMsFeatGmLength = bs_ * numFeats_ * numEmbeds_;
+        uint64_t mcMsFeatGmLength = static_cast<uint64_t>(numSlots_) * bs_ * numFeats_ * numEmbeds_;
         uint64_t scaleStartIndexLength = numCams_ * numScales_;
         uint64_t spatialShapeGmLength = scaleStartIndexLength * 2;
         uint64_t samplingLocationGmLength = bs_ * numAnchors_ * numPoints_ * numCams_ * 2;
         uint64_t weightsGmLength = bs_ * numAnchors_ * numPoints_ * numCams_ * numScales_ * numGroups_;
         uint64_t outGmLength = bs_ * numAnchors_ * numEmbeds_;
 
-        mcMsFeatGm_.SetGlobalBuffer((__gm__ DTYPE_F*)mc_ms_feat, mcMsFeatGmLength);
+        mcMsFeatGm_.SetGlobalBuffer((__gm__ DTYPE_T*)mc_ms_feat, mcMsFeatGmLength);
         samplingLocationGm_.SetGlobalBuffer((__gm__ DTYPE_F*)sampling_location, samplingLocationGmLength);
         weightsGm_.SetGlobalBuffer((__gm__ DTYPE_F*)weights, weightsGmLength);
-        outGm_.SetGlobalBuffer((__gm__ DTYPE_F*)out, outGmLength);
+        outGm_.SetGlobalBuffer((__gm__ DTYPE_T*)out, outGmLength);
         spatialShapesGm_.SetGlobalBuffer((__gm__ DTYPE_I*)spatial_shape, spatialShapeGmLength);
         scaleStartIndexGm_.SetGlobalBuffer((__gm__ DTYPE_I*)scale_start_index, scaleStartIndexLength);
+        if (slotFlag_) {
+            slotIndexGm_.SetGlobalBuffer((__gm__ DTYPE_I*)slot_index, bs_ * numAnchors_);
+        }
     }
 
     __aicore__ inline void GetLocalTensor()
@@ -65,6 +75,20 @@ public:
         pipe_->InitBuffer(vBuf_, 4 * cAligned_ * sizeof(DTYPE_F));
         pipe_->InitBuffer(weightMulBuf_, cAligned_ * sizeof(DTYPE_F));
         pipe_->InitBuffer(resBuf_, cAligned_ * sizeof(DTYPE_F));
+        if (!groupAligned_) {
+            pipe_->InitBuffer(groupWeightBuf_, groupAlignedNum_ * sizeof(DTYPE_F));
+            groupWeightLocal_ = groupWeightBuf_.Get<DTYPE_F>();
+        }
+        if (softmaxFlag_) {
+            pipe_->InitBuffer(softmaxBuf_, 2 * groupAlignedNum_ * sizeof(DTYPE_F));
+            softmaxLocal_ = softmaxBuf_.Get<DTYPE_F>();
+        }
+        if constexpr (!IS_FLOAT) {
+            pipe_->InitBuffer(vCastBuf_, 4 * cAligned_ * sizeof(DTYPE_T));
+            pipe_->InitBuffer(resCastBuf_, cAligned_ * sizeof(DTYPE_T));
+            vCastLocal_ = vCastBuf_.Get<DTYPE_T>();
+            resCastLocal_ = resCastBuf_.Get<DTYPE_T>();
+        }
 
         weightLocal_ = weightBuf_.Get<DTYPE_F>();
         locationLocal_ = locationBuf_.Get<DTYPE_F>();
@@ -98,6 +122,15 @@ public:
         uint32_t batchIdx = taskIdx / numAnchors_;
         uint32_t anchorIdx = taskIdx % numAnchors_;
         uint64_t refOffsetGm = (batchIdx * numAnchors_ + anchorIdx) * numEmbeds_;
+        // 时序特征缓存按[slot, batch]展开，当前anchor从slot_index指定的帧采样
+        uint64_t featBatchIdx = batchIdx;
+        // slot_index越界的anchor不采样，输出全0，避免越界读取特征缓存
+        bool validSlot = true;
+        if (slotFlag_) {
+            int32_t slotIdx = static_cast<int32_t>(slotIndexGm_.GetValue(taskIdx));
+            validSlot = slotIdx >= 0 && static_cast<uint32_t>(slotIdx) < numSlots_;
+            featBatchIdx = static_cast<uint64_t>(validSlot ? slotIdx : 0) * bs_ + batchIdx;
+        }
         uint64_t locationOffsetGm = (batchIdx * numAnchors_ +
                                      anchorIdx) * numPoints_ * numCams_ * 2;
         if (memoryFlag_) {
@@ -106,10 +139,15 @@ public:
             SetFlag<HardEvent::V_MTE2>(0);
             WaitFlag<HardEvent::V_MTE2>(0);
             DataCopy(weightLocal_, weightsGm_[weightOffsetGm], weightBufSize_);
+            if (softmaxFlag_) {
+                SetFlag<HardEvent::MTE2_V>(0);
+                WaitFlag<HardEvent::MTE2_V>(0);
+                SoftmaxWeights();
+            }
         }
         DataCopy(locationLocal_, samplingLocationGm_[locationOffsetGm], locBufSize_);
         Duplicate(resLocal_, 0.0f, cAligned_);
-        for (uint32_t pointIdx = 0; pointIdx < numPoints_; ++pointIdx) {
+        for (uint32_t pointIdx = 0; validSlot && pointIdx < numPoints_; ++pointIdx) {
             if (!memoryFlag_) {
                 uint64_t weightOffsetGm = (batchIdx * numAnchors_ * numPoints_ +
                                            anchorIdx * numPoints_ + pointIdx) * numCams_ * numScales_ * numGroups_;
@@ -133,7 +171,7 @@ public:
                     uint32_t scaleStartOffset = camIdx * numScales_ + scaleIdx;
                     uint32_t spatialShapeOffset = scaleStartOffset * 2;
                     uint32_t scaleStartIdx = scaleStartLocal_.GetValue(scaleStartOffset);
-                    uint32_t valueOffset = (batchIdx * numFeats_ + scaleStartIdx) * numEmbeds_;
+                    uint64_t valueOffset = (featBatchIdx * numFeats_ + scaleStartIdx) * numEmbeds_;
 
                     DTYPE_I h = spatialShapeLocal_.GetValue(spatialShapeOffset);
                     DTYPE_I w = spatialShapeLocal_.GetValue(spatialShapeOffset + 1);
@@ -164,6 +202,7 @@ public:
                     DTYPE_F w4 = lh * lw;
 
                     Duplicate(vLocal_, 0.0f, 4 * cAligned_);
+                    loadedMask_ = 0;
 
                     SetFlag<HardEvent::V_MTE2>(0);
                     WaitFlag<HardEvent::V_MTE2>(0);
@@ -172,11 +211,11 @@ public:
                         basePtr_ = valueOffset + hLowPtrOffset;
                         if (wLow >= 0) {
                             realPtr_ = basePtr_ + wLowPtrOffset;
-                            DataCopy(vLocal_[v1Offset_ * cAligned_], mcMsFeatGm_[realPtr_], cAligned_);
+                            CopyInFeature(v1Offset_, realPtr_);
                         }
                         if (wHigh <= w - 1) {
                             realPtr_ = basePtr_ + wHighPtrOffset;
-                            DataCopy(vLocal_[v2Offset_ * cAligned_], mcMsFeatGm_[realPtr_], cAligned_);
+                            CopyInFeature(v2Offset_, realPtr_);
                         }
                     }
 
@@ -184,67 +223,151 @@ public:
                         basePtr_ = valueOffset + hHighPtrOffset;
                         if (wLow >= 0) {
                             realPtr_ = basePtr_ + wLowPtrOffset;
-                            DataCopy(vLocal_[v3Offset_ * cAligned_], mcMsFeatGm_[realPtr_], cAligned_);
+                            CopyInFeature(v3Offset_, realPtr_);
                         }
                         if (wHigh <= w - 1) {
                             realPtr_ = basePtr_ + wHighPtrOffset;
-                            DataCopy(vLocal_[v4Offset_ * cAligned_], mcMsFeatGm_[realPtr_], cAligned_);
+                            CopyInFeature(v4Offset_, realPtr_);
                         }
                     }
 
                     SetFlag<HardEvent::MTE2_V>(0);
                     WaitFlag<HardEvent::MTE2_V>(0);
+                    if constexpr (!IS_FLOAT) {
+                        for (uint32_t vIdx = 0; vIdx < 4; ++vIdx) {
+                            if (loadedMask_ & (1U << vIdx)) {
+                                Cast(vLocal_[vIdx * cAligned_], vCastLocal_[vIdx * cAligned_], RoundMode::CAST_NONE,
+                                    cAligned_);
+                            }
+                        }
+                    }
                     Muls(vLocal_[v1Offset_ * cAligned_], vLocal_[v1Offset_ * cAligned_], w1, cAligned_);
                     Axpy(vLocal_[v1Offset_ * cAligned_], vLocal_[v2Offset_ * cAligned_], w2, cAligned_);
                     Axpy(vLocal_[v1Offset_ * cAligned_], vLocal_[v3Offset_ * cAligned_], w3, cAligned_);
                     Axpy(vLocal_[v1Offset_ * cAligned_], vLocal_[v4Offset_ * cAligned_], w4, cAligned_);
                     
-                    BroadCast<DTYPE_F, 2, 1>(weightMulLocal_, weightLocal_[weightOffsetLocal], dstShape_, srcShape_);
+                    if (groupAligned_) {
+                        BroadCast<DTYPE_F, 2, 1>(weightMulLocal_, weightLocal_[weightOffsetLocal], dstShape_, srcShape_);
+                    } else {
+                        // weight的起始地址不满足32B对齐，逐个搬运到对齐的临时空间后再广播
+                        for (uint32_t groupIdx = 0; groupIdx < numGroups_; ++groupIdx) {
+                            groupWeightLocal_.SetValue(groupIdx, weightLocal_.GetValue(weightOffsetLocal + groupIdx));
+                        }
+                        SetFlag<HardEvent::S_V>(0);
+                        WaitFlag<HardEvent::S_V>(0);
+                        BroadCast<DTYPE_F, 2, 1>(weightMulLocal_, groupWeightLocal_, dstShape_, srcShape_);
+                    }
                     MulAddDst(resLocal_, vLocal_[v1Offset_ * cAligned_], weightMulLocal_, cAligned_);
                 }
             }
         }
         SetFlag<HardEvent::V_MTE3>(0);
         WaitFlag<HardEvent::V_MTE3>(0);
-        DataCopyPad(outGm_[refOffsetGm], resLocal_, copyOutParams_);
+        if constexpr (IS_FLOAT) {
+            DataCopyPad(outGm_[refOffsetGm], resLocal_, copyOutParams_);
+        } else {
+            SetFlag<HardEvent::MTE3_V>(0);
+            WaitFlag<HardEvent::MTE3_V>(0);
+            Cast(resCastLocal_, resLocal_, RoundMode::CAST_RINT, cAligned_);
+            SetFlag<HardEvent::V_MTE3>(0);
+            WaitFlag<HardEvent::V_MTE3>(0);
+            DataCopyPad(outGm_[refOffsetGm], resCastLocal_, copyOutParams_);
+        }
         SetFlag<HardEvent::MTE3_V>(0);
         WaitFlag<HardEvent::MTE3_V>(0);
     }
 
 private:
+    __aicore__ inline void CopyInFeature(uint32_t vOffset, uint64_t featOffset)
+    {
+        if constexpr (IS_FLOAT) {
+            DataCopy(vLocal_[vOffset * cAligned_], mcMsFeatGm_[featOffset], cAligned_);
+        } else {
+            DataCopyPad(vCastLocal_[vOffset * cAligned_], mcMsFeatGm_[featOffset], copyInParams_, padParams_);
+            loadedMask_ |= 1U << vOffset;
+        }
+    }
+
+    // weight按[numPoints * numCams * numScales, numGroups]排布，对每个group沿第一维做softmax
+    __aicore__ inline void SoftmaxWeights()
+    {
+        uint32_t rows = numPoints_ * numCams_ * numScales_;
+        LocalTensor<DTYPE_F> maxLocal = softmaxLocal_;
+        LocalTensor<DTYPE_F> sumLocal = softmaxLocal_[groupAlignedNum_];
+        Adds(maxLocal, weightLocal_, 0.0f, numGroups_);
+        for (uint32_t row = 1; row < rows; ++row) {
+            Max(maxLocal, maxLocal, weightLocal_[row * numGroups_], numGroups_);
+        }
+        for (uint32_t row = 0; row < rows; ++row) {
+            Sub(weightLocal_[row * numGroups_], weightLocal_[row * numGroups_], maxLocal, numGroups_);
+        }
+        Exp(weightLocal_, weightLocal_, rows * numGroups_);
+        Adds(sumLocal, weightLocal_, 0.0f, numGroups_);
+        for (uint32_t row = 1; row < rows; ++row) {
+            Add(sumLocal, sumLocal, weightLocal_[row * numGroups_], numGroups_);
+        }
+        for (uint32_t row = 0; row < rows; ++row) {
+            Div(weightLocal_[row * numGroups_], weightLocal_[row * numGroups_], sumLocal, numGroups_);
+        }
+        PipeBarrier<PIPE_V>();
+    }
+
+    static constexpr bool IS_FLOAT = sizeof(DTYPE_T) == sizeof(DTYPE_F);
+
     TPipe *pipe_;
 
     TBuf<TPosition::VECCALC> weightBuf_, locationBuf_, scaleStartBuf_, spatialShapeBuf_;
     TBuf<TPosition::VECCALC> vBuf_, weightMulBuf_, resBuf_;
+    TBuf<TPosition::VECCALC> groupWeightBuf_, softmaxBuf_, vCastBuf_, resCastBuf_;
 
-    GlobalTensor<DTYPE_F> mcMsFeatGm_, samplingLocationGm_, weightsGm_, outGm_;
-    GlobalTensor<DTYPE_I> spatialShapesGm_, scaleStartIndexGm_;
+    GlobalTensor<DTYPE_T> mcMsFeatGm_, outGm_;
+    GlobalTensor<DTYPE_F> samplingLocationGm_, weightsGm_;
+    GlobalTensor<DTYPE_I> spatialShapesGm_, scaleStartIndexGm_, slotIndexGm_;
 
     LocalTensor<DTYPE_F> locationLocal_, weightLocal_;
     LocalTensor<DTYPE_I> spatialShapeLocal_, scaleStartLocal_;
     LocalTensor<DTYPE_F> vLocal_, weightMulLocal_, resLocal_;
+    LocalTensor<DTYPE_F> groupWeightLocal_, softmaxLocal_;
+    LocalTensor<DTYPE_T> vCastLocal_, resCastLocal_;
 
-    bool memoryFlag_;
-    uint32_t basePtr_, realPtr_;
+    bool memoryFlag_, groupAligned_, softmaxFlag_, slotFlag_;
+    uint64_t basePtr_, realPtr_;
+    uint32_t loadedMask_;
     uint32_t coreNum_, curBlockIdx_;
     uint32_t taskNum_, taskNumPerCore_, startOffset_, endOffset_;
-    uint32_t weightBufSize_, locBufSize_, scaleStartBufSize_, spatialShapeBufSize_;
-    uint32_t bs_, numFeats_, numEmbeds_, numAnchors_, numPoints_, numCams_, numScales_, numGroups_, numChannels_, cAligned_;
+    uint32_t weightBufSize_, locBufSize_, scaleStartBufSize_, spatialShapeBufSize_, groupAlignedNum_;
+    uint32_t numSlots_, bs_, numFeats_, numEmbeds_, numAnchors_, numPoints_, numCams_, numScales_, numGroups_, numChannels_, cAligned_;
     uint32_t blockAlign_ = 8;
     uint32_t v1Offset_ = 0, v2Offset_ = 1, v3Offset_ = 2, v4Offset_ = 3;
     
     uint32_t srcShape_[2], dstShape_[2];
-    DataCopyExtParams copyOutParams_;
+    DataCopyExtParams copyInParams_, copyOutParams_;
+    DataCopyPadExtParams<DTYPE_T> padParams_ {false, 0, 0, 0};
 };
 
 extern "C" __global__ __aicore__ void deformable_aggregation(GM_ADDR mc_ms_feat, GM_ADDR spatial_shape,
-    GM_ADDR scale_start_index, GM_ADDR sampling_location, GM_ADDR weights, GM_ADDR out, GM_ADDR workspace,
-    GM_ADDR tiling)
+    GM_ADDR scale_start_index, GM_ADDR sampling_location, GM_ADDR weights, GM_ADDR slot_index, GM_ADDR out,
+    GM_ADDR workspace, GM_ADDR tiling)
 {
     TPipe pipe;
     GET_TILING_DATA(tiling_data, tiling);
-    KernelDeformableAggregation<float, int32_t> op;
-    op.Init(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights, out, &tiling_data, &pipe);
-    op.GetLocalTensor();
-    op.Process();
+    if (TILING_KEY_IS(1)) { // TILING_KEY_FLOAT
+        KernelDeformableAggregation<float, float, int32_t> op;
+        op.Init(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights, slot_index, out,
+            &tiling_data, &pipe);
+        op.GetLocalTensor();
+        op.Process();
+    } else if (TILING_KEY_IS(2)) { // TILING_KEY_HALF
+        KernelDeformableAggregation<half, float, int32_t> op;
+        op.Init(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights, slot_index, out,
+            &tiling_data, &pipe);
+        op.GetLocalTensor();
+        op.Process();
+    } else if (TILING_KEY_IS(3)) { // TILING_KEY_BF16
+        KernelDeformableAggregation<bfloat16_t, float, int32_t> op;
+        op.Init(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights, slot_index, out,
+            &tiling_data, &pipe);
+        op.GetLocalTensor();
+        op.Process();
+    }
 }
@@ -56,6 +56,7 @@ private:
         numFeat = tiling.numFeat;
         numAnchors = tiling.numAnchors;
         totalGroups = numEmbeds / group_;
+        groupAligned_ = (group_ % B32_DATA_NUM_PER_BLOCK) == 0;
     }
 
     __aicore__ inline void InitGM(GM_ADDR mc_ms_feat, GM_ADDR spatial_shape, GM_ADDR scale_start_index,
@@ -91,6 +92,7 @@ private:
         pipe_->InitBuffer(pointGradWeightQue_, 8 * numEmbeds * sizeof(float));
         pipe_->InitBuffer(gradSamplingQue_, 4 * samplingOffset * sizeof(float));
         pipe_->InitBuffer(sumTmp_, 8 * sizeof(float));
+        pipe_->InitBuffer(groupWeightQue_, AlignUp(group_, B32_DATA_NUM_PER_BLOCK) * sizeof(float));
     }
 
     __aicore__ inline void InitEvent()
@@ -100,6 +102,7 @@ private:
         vToOutEvtID_ = pipe_->FetchEventID(HardEvent::V_MTE3);
         vToMTE2EvtID_ = pipe_->FetchEventID(HardEvent::V_MTE2);
         mte3ToVEvtID_ = pipe_->FetchEventID(HardEvent::MTE3_V);
+        sToVEvtID_ = pipe_->FetchEventID(HardEvent::S_V);
     }
 
     __aicore__ inline void ProcessSingle(uint64_t taskIdx, uint32_t actualWeightNum)
@@ -125,6 +128,8 @@ private:
         LocalTensor<float> pointGradWeightLocal = pointGradWeightQue_.Get<float>();
         LocalTensor<float> gradSamplingLocation = gradSamplingQue_.Get<float>();
         LocalTensor<float> tmpLocation = sumTmp_.Get<float>();
+        LocalTensor<float> groupWeight = groupWeightQue_.Get<float>();
+        DataCopyExtParams gradWeightCopyParams {1, (uint32_t)(group_ * sizeof(float)), 0, 0, 0};
 
         SetFlag<HardEvent::V_MTE2>(vToMTE2EvtID_);
         WaitFlag<HardEvent::V_MTE2>(vToMTE2EvtID_);
@@ -198,7 +203,17 @@ private:
                         SetFlag<HardEvent::MTE3_V>(mte3ToVEvtID_);
                         WaitFlag<HardEvent::MTE3_V>(mte3ToVEvtID_);
 
-                        BroadCast<float, 2, 1>(topGradMcMsFeatLocal, weight[weightOffset], dstShape_, srcShape_);
+                        if (groupAligned_) {
+                            BroadCast<float, 2, 1>(topGradMcMsFeatLocal, weight[weightOffset], dstShape_, srcShape_);
+                        } else {
+                            // weight的起始地址不满足32B对齐，逐个搬运到对齐的临时空间后再广播
+                            for (uint32_t groupId = 0; groupId < group_; groupId++) {
+                                groupWeight.SetValue(groupId, weight.GetValue(weightOffset + groupId));
+                            }
+                            SetFlag<HardEvent::S_V>(sToVEvtID_);
+                            WaitFlag<HardEvent::S_V>(sToVEvtID_);
+                            BroadCast<float, 2, 1>(topGradMcMsFeatLocal, groupWeight, dstShape_, srcShape_);
+                        }
                         Mul(topGradMcMsFeatLocal, topGradMcMsFeatLocal, gradOutput[gradOuputBaseOffset], numEmbeds);
                         Muls(topGradMcMsFeatLocal[numEmbeds], topGradMcMsFeatLocal, w1, numEmbeds);
                         Muls(topGradMcMsFeatLocal[numEmbeds * 2], topGradMcMsFeatLocal, w2, numEmbeds);
@@ -248,7 +263,11 @@ private:
                         WaitFlag<HardEvent::V_MTE3>(vToOutEvtID_);
 
                         SetAtomicAdd<float>();
-                        DataCopy(gradWeightsGm[weightGmOffset + weightOffset], featureLocal_, group_);
+                        if (groupAligned_) {
+                            DataCopy(gradWeightsGm[weightGmOffset + weightOffset], featureLocal_, group_);
+                        } else {
+                            DataCopyPad(gradWeightsGm[weightGmOffset + weightOffset], featureLocal_, gradWeightCopyParams);
+                        }
                         SetAtomicNone();
 
                         Muls(pointGradWeightLocal, vLocal, hw, numEmbeds);
@@ -288,11 +307,13 @@ private:
     GlobalTensor<int32_t> spatialShapeGm, scaleStartLocationGm;
     TBuf<TPosition::VECCALC> weightQue_, gradOutputQue_, samplingLocationQue_, scaleStartLocationQue_, spatialShapeQue_;
     TBuf<TPosition::VECCALC> topGradMcMsFeatQue_, vQue_, featureQue_, featureQue__, pointGradWeightQue_, gradSamplingQue_, sumTmp_;
+    TBuf<TPosition::VECCALC> groupWeightQue_;
     uint32_t usedCoreNum_, avgWeightNum_, tailWeightNum_, coreId;
     uint32_t totalTaskNum_, singleProcessTaskLen_, taskRepeatTimes;
     uint32_t pts_, cam_, scale_, group_, numEmbeds, numFeat, numAnchors, totalGroups;
     int64_t taskOffset;
-    TEventID cpInEvtID_, cpOutEvtID_, vToOutEvtID_, vToMTE2EvtID_, mte3ToVEvtID_;
+    bool groupAligned_;
+    TEventID cpInEvtID_, cpOutEvtID_, vToOutEvtID_, vToMTE2EvtID_, mte3ToVEvtID_, sToVEvtID_;
 };
 
 __aicore__ inline void KernelDeformableAggregationGrad::Process()
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2025. All rights reserved.
+ *
+ * 融合的可微旋转框IoU：角点、Sutherland-Hodgman裁剪、鞋带公式面积以及解析梯度全部在标量寄存器中完成，
+ * 每对框只读10个参数，写出IoU/GIoU/DIoU及其对两个框10个参数的梯度
+ */
+#include "kernel_operator.h"
+
+using namespace AscendC;
+
+namespace {
+constexpr uint32_t BOX_DIM = 5;
+constexpr uint32_t GRAD_DIM = 10;
+constexpr uint32_t BOX_CORNERS = 4;
+constexpr uint32_t LINE_NUM = 8; // 0~3为框A的边，4~7为框B的边，第l条边从角点l指向同框下一个角点
+constexpr uint32_t MAX_POLY = 16; // 凸四边形被4个半平面裁剪至多8个顶点，留出余量
+constexpr uint32_t FLOAT_ALIGN = 8;
+constexpr uint32_t SIN_COS_ALIGN = 64;
+constexpr int32_t MODE_GIOU = 1;
+constexpr int32_t MODE_DIOU = 2;
+constexpr float EPS_DEN = 1e-12;
+constexpr float HALF = 0.5f;
+} // namespace
+
+class KernelDiffIouRotated {
+public:
+    __aicore__ inline KernelDiffIouRotated() {}
+    __aicore__ inline void Init(TPipe* pipe, GM_ADDR boxesA, GM_ADDR boxesB, GM_ADDR ious, GM_ADDR grad,
+        const DiffIouRotatedTilingData* tiling)
+    {
+        pipe_ = pipe;
+        uint32_t blkIdx = GetBlockIdx();
+        coreTask_ = tiling->coreTask;
+        if (blkIdx < tiling->bigCoreCount) {
+            taskOffset_ = blkIdx * coreTask_;
+        } else {
+            taskOffset_ = tiling->bigCoreCount * coreTask_ + (blkIdx - tiling->bigCoreCount) * (coreTask_ - 1);
+            coreTask_ = coreTask_ - 1;
+        }
+        singleLoopTaskCount_ = tiling->singleLoopTaskCount;
+        mode_ = tiling->mode;
+        withGrad_ = tiling->withGrad;
+
+        boxesAGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(boxesA));
+        boxesBGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(boxesB));
+        iousGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(ious));
+        gradGm_.SetGlobalBuffer(reinterpret_cast<__gm__ float*>(grad));
+
+        uint32_t boxesLen = AlignUp(singleLoopTaskCount_ * BOX_DIM, FLOAT_ALIGN);
+        // 两组框的角度拼在一起做一次Sin/Cos
+        angleLen_ = AlignUp(singleLoopTaskCount_ * 2, SIN_COS_ALIGN);
+        pipe_->InitBuffer(boxesABuf_, boxesLen * sizeof(float));
+        pipe_->InitBuffer(boxesBBuf_, boxesLen * sizeof(float));
+        pipe_->InitBuffer(angleBuf_, angleLen_ * sizeof(float));
+        pipe_->InitBuffer(sinBuf_, angleLen_ * sizeof(float));
+        pipe_->InitBuffer(cosBuf_, angleLen_ * sizeof(float));
+        pipe_->InitBuffer(iousBuf_, AlignUp(singleLoopTaskCount_, FLOAT_ALIGN) * sizeof(float));
+        pipe_->InitBuffer(gradBuf_, AlignUp(singleLoopTaskCount_ * GRAD_DIM, FLOAT_ALIGN) * sizeof(float));
+    }
+
+    __aicore__ inline void Process()
+    {
+        boxesALocal_ = boxesABuf_.Get<float>();
+        boxesBLocal_ = boxesBBuf_.Get<float>();
+        angleLocal_ = angleBuf_.Get<float>();
+        sinLocal_ = sinBuf_.Get<float>();
+        cosLocal_ = cosBuf_.Get<float>();
+        iousLocal_ = iousBuf_.Get<float>();
+        gradLocal_ = gradBuf_.Get<float>();
+
+        uint32_t endTaskOffset = taskOffset_ + coreTask_;
+        for (uint32_t offset = taskOffset_; offset < endTaskOffset; offset += singleLoopTaskCount_) {
+            uint32_t taskCount = endTaskOffset - offset < singleLoopTaskCount_ ? endTaskOffset - offset :
+                                                                                 singleLoopTaskCount_;
+            CopyIn(offset, taskCount);
+            ComputeSinCos(taskCount);
+            for (uint32_t i = 0; i < taskCount; i++) {
+                ComputePair(i, taskCount);
+            }
+            CopyOut(offset, taskCount);
+        }
+    }
+
+private:
+    __aicore__ inline uint32_t AlignUp(uint32_t value, uint32_t align)
+    {
+        return (value + align - 1) / align * align;
+    }
+
+    __aicore__ inline void CopyIn(uint32_t offset, uint32_t taskCount)
+    {
+        DataCopyExtParams copyParams {1, static_cast<uint32_t>(taskCount * BOX_DIM * sizeof(float)), 0, 0, 0};
+        DataCopyPadExtParams<float> padParams {false, 0, 0, 0};
+        PipeBarrier<PIPE_ALL>();
+        DataCopyPad(boxesALocal_, boxesAGm_[static_cast<uint64_t>(offset) * BOX_DIM], copyParams, padParams);
+        DataCopyPad(boxesBLocal_, boxesBGm_[static_cast<uint64_t>(offset) * BOX_DIM], copyParams, padParams);
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void ComputeSinCos(uint32_t taskCount)
+    {
+        for (uint32_t i = 0; i < taskCount; i++) {
+            angleLocal_.SetValue(i, boxesALocal_.GetValue(i * BOX_DIM + 4));
+            angleLocal_.SetValue(taskCount + i, boxesBLocal_.GetValue(i * BOX_DIM + 4));
+        }
+        PipeBarrier<PIPE_ALL>();
+        Sin(sinLocal_, angleLocal_, angleLen_);
+        Cos(cosLocal_, angleLocal_, angleLen_);
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void CopyOut(uint32_t offset, uint32_t taskCount)
+    {
+        PipeBarrier<PIPE_ALL>();
+        DataCopyExtParams iouParams {1, static_cast<uint32_t>(taskCount * sizeof(float)), 0, 0, 0};
+        DataCopyPad(iousGm_[offset], iousLocal_, iouParams);
+        if (withGrad_) {
+            DataCopyExtParams gradParams {1, static_cast<uint32_t>(taskCount * GRAD_DIM * sizeof(float)), 0, 0, 0};
+            DataCopyPad(gradGm_[static_cast<uint64_t>(offset) * GRAD_DIM], gradLocal_, gradParams);
+        }
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline float Cross(float ax, float ay, float bx, float by)
+    {
+        return ax * by - ay * bx;
+    }
+
+    // 局部坐标系下角点相对中心的系数，角点按逆时针排列：(+,+), (-,+), (-,-), (+,-)
+    __aicore__ inline float CornerU(uint32_t k)
+    {
+        return (k == 0 || k == 3) ? HALF : -HALF;
+    }
+
+    __aicore__ inline float CornerV(uint32_t k)
+    {
+        return k < 2 ? HALF : -HALF;
+    }
+
+    __aicore__ inline uint32_t LineEnd(uint32_t line)
+    {
+        return (line & ~(BOX_CORNERS - 1)) | ((line + 1) & (BOX_CORNERS - 1));
+    }
+
+    // 两条边所在直线交点对8个角点的反向传播，(gx, gy)为面积对交点的梯度
+    __aicore__ inline void BackwardIntersection(uint32_t l1, uint32_t l2, float gx, float gy)
+    {
+        uint32_t e1 = LineEnd(l1);
+        uint32_t e2 = LineEnd(l2);
+        if ((l1 >> 2) == (l2 >> 2)) {
+            // 同一个框的相邻两条边，交点即为公共角点
+            uint32_t shared = e1 == l2 ? l2 : l1;
+            gpx_[shared] += gx;
+            gpy_[shared] += gy;
+            return;
+        }
+        float d1x = px_[e1] - px_[l1];
+        float d1y = py_[e1] - py_[l1];
+        float d2x = px_[e2] - px_[l2];
+        float d2y = py_[e2] - py_[l2];
+        float qx = px_[l2] - px_[l1];
+        float qy = py_[l2] - py_[l1];
+        float den = Cross(d1x, d1y, d2x, d2y);
+        if (den < EPS_DEN && den > -EPS_DEN) {
+            return;
+        }
+        float t = Cross(qx, qy, d2x, d2y) / den;
+        float s = (gx * d1x + gy * d1y) / den;
+        // P = p1 + t * d1，t = cross(p3 - p1, d2) / cross(d1, d2)
+        float gqx = s * d2y;
+        float gqy = -s * d2x;
+        float gd1x = -t * gqx;
+        float gd1y = -t * gqy;
+        float gd2x = s * (-qy + t * d1y);
+        float gd2y = s * (qx - t * d1x);
+        gpx_[l1] += gx * (1 - t) - gqx - gd1x;
+        gpy_[l1] += gy * (1 - t) - gqy - gd1y;
+        gpx_[e1] += gx * t + gd1x;
+        gpy_[e1] += gy * t + gd1y;
+        gpx_[l2] += gqx - gd2x;
+        gpy_[l2] += gqy - gd2y;
+        gpx_[e2] += gd2x;
+        gpy_[e2] += gd2y;
+    }
+
+    // 用框B的4条边依次裁剪框A，顶点记录其所在的两条边，返回交多边形顶点数
+    __aicore__ inline uint32_t ClipPolygon()
+    {
+        uint32_t n = BOX_CORNERS;
+        for (uint32_t k = 0; k < BOX_CORNERS; k++) {
+            vx_[k] = px_[k];
+            vy_[k] = py_[k];
+            vIn_[k] = (k + BOX_CORNERS - 1) & (BOX_CORNERS - 1);
+            vOut_[k] = k;
+        }
+        for (uint32_t c = BOX_CORNERS; c < LINE_NUM && n > 0; c++) {
+            uint32_t ce = LineEnd(c);
+            float cdx = px_[ce] - px_[c];
+            float cdy = py_[ce] - py_[c];
+            for (uint32_t i = 0; i < n; i++) {
+                side_[i] = Cross(cdx, cdy, vx_[i] - px_[c], vy_[i] - py_[c]);
+            }
+            uint32_t m = 0;
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t j = i + 1 == n ? 0 : i + 1;
+                bool inI = side_[i] >= 0;
+                bool inJ = side_[j] >= 0;
+                if (inI) {
+                    wx_[m] = vx_[i];
+                    wy_[m] = vy_[i];
+                    wIn_[m] = vIn_[i];
+                    wOut_[m] = vOut_[i];
+                    m++;
+                }
+                if (inI != inJ) {
+                    float t = side_[i] / (side_[i] - side_[j]);
+                    wx_[m] = vx_[i] + t * (vx_[j] - vx_[i]);
+                    wy_[m] = vy_[i] + t * (vy_[j] - vy_[i]);
+                    wIn_[m] = inI ? vOut_[i] : c;
+                    wOut_[m] = inI ? c : vOut_[i];
+                    m++;
+                }
+            }
+            n = m;
+            for (uint32_t i = 0; i < n; i++) {
+                vx_[i] = wx_[i];
+                vy_[i] = wy_[i];
+                vIn_[i] = wIn_[i];
+                vOut_[i] = wOut_[i];
+            }
+        }
+        return n;
+    }
+
+    __aicore__ inline void ComputePair(uint32_t idx, uint32_t taskCount)
+    {
+        float box[GRAD_DIM];
+        float sinA[2];
+        float cosA[2];
+        for (uint32_t k = 0; k < BOX_DIM; k++) {
+            box[k] = boxesALocal_.GetValue(idx * BOX_DIM + k);
+            box[BOX_DIM + k] = boxesBLocal_.GetValue(idx * BOX_DIM + k);
+        }
+        sinA[0] = sinLocal_.GetValue(idx);
+        cosA[0] = cosLocal_.GetValue(idx);
+        sinA[1] = sinLocal_.GetValue(taskCount + idx);
+        cosA[1] = cosLocal_.GetValue(taskCount + idx);
+        for (uint32_t b = 0; b < 2; b++) {
+            const float* param = box + b * BOX_DIM;
+            for (uint32_t k = 0; k < BOX_CORNERS; k++) {
+                float u = CornerU(k) * param[2];
+                float v = CornerV(k) * param[3];
+                px_[b * BOX_CORNERS + k] = param[0] + cosA[b] * u - sinA[b] * v;
+                py_[b * BOX_CORNERS + k] = param[1] + sinA[b] * u + cosA[b] * v;
+            }
+        }
+        for (uint32_t k = 0; k < LINE_NUM; k++) {
+            gpx_[k] = 0;
+            gpy_[k] = 0;
+        }
+
+        uint32_t n = ClipPolygon();
+        float inter = 0;
+        if (n >= 3) {
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t j = i + 1 == n ? 0 : i + 1;
+                inter += Cross(vx_[i], vy_[i], vx_[j], vy_[j]);
+            }
+            inter = inter * HALF;
+        }
+        float area1 = box[2] * box[3];
+        float area2 = box[BOX_DIM + 2] * box[BOX_DIM + 3];
+        float uni = area1 + area2 - inter;
+        float iou = uni > 0 ? inter / uni : 0;
+        float gInter = uni > 0 ? (area1 + area2) / (uni * uni) : 0;
+        float gArea = uni > 0 ? -inter / (uni * uni) : 0;
+        float gArea1 = gArea;
+        float gArea2 = gArea;
+        float res = iou;
+
+        // 外接框取8个角点的轴对齐包围盒
+        uint32_t xMinIdx = 0;
+        uint32_t xMaxIdx = 0;
+        uint32_t yMinIdx = 0;
+        uint32_t yMaxIdx = 0;
+        float gCx = 0;
+        float gCy = 0;
+        float gCenter = 0;
+        if (mode_ == MODE_GIOU || mode_ == MODE_DIOU) {
+            for (uint32_t k = 1; k < LINE_NUM; k++) {
+                xMinIdx = px_[k] < px_[xMinIdx] ? k : xMinIdx;
+                xMaxIdx = px_[k] > px_[xMaxIdx] ? k : xMaxIdx;
+                yMinIdx = py_[k] < py_[yMinIdx] ? k : yMinIdx;
+                yMaxIdx = py_[k] > py_[yMaxIdx] ? k : yMaxIdx;
+            }
+            float encW = px_[xMaxIdx] - px_[xMinIdx];
+            float encH = py_[yMaxIdx] - py_[yMinIdx];
+            if (mode_ == MODE_GIOU) {
+                // giou = iou - 1 + union / enclose
+                float enclose = encW * encH;
+                if (enclose > 0) {
+                    res = iou - 1 + uni / enclose;
+                    float gUni = 1 / enclose;
+                    float gEnclose = -uni / (enclose * enclose);
+                    gInter -= gUni;
+                    gArea1 += gUni;
+                    gArea2 += gUni;
+                    gCx = gEnclose * encH;
+                    gCy = gEnclose * encW;
+                }
+            } else {
+                // diou = iou - center_dist^2 / diag^2
+                float diag = encW * encW + encH * encH;
+                float dx = box[0] - box[BOX_DIM];
+                float dy = box[1] - box[BOX_DIM + 1];
+                if (diag > 0) {
+                    float dist = dx * dx + dy * dy;
+                    res = iou - dist / diag;
+                    float gDiag = dist / (diag * diag);
+                    gCenter = -2 / diag;
+                    gCx = gDiag * 2 * encW;
+                    gCy = gDiag * 2 * encH;
+                }
+            }
+        }
+        iousLocal_.SetValue(idx, res);
+        if (!withGrad_) {
+            return;
+        }
+
+        // 鞋带公式对顶点的梯度，再经交点回传到角点
+        if (n >= 3) {
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t j = i + 1 == n ? 0 : i + 1;
+                uint32_t h = i == 0 ? n - 1 : i - 1;
+                float gx = HALF * (vy_[j] - vy_[h]) * gInter;
+                float gy = HALF * (vx_[h] - vx_[j]) * gInter;
+                BackwardIntersection(vIn_[i], vOut_[i], gx, gy);
+            }
+        }
+        gpx_[xMaxIdx] += gCx;
+        gpx_[xMinIdx] -= gCx;
+        gpy_[yMaxIdx] += gCy;
+        gpy_[yMinIdx] -= gCy;
+
+        float gCenterX = gCenter * (box[0] - box[BOX_DIM]);
+        float gCenterY = gCenter * (box[1] - box[BOX_DIM + 1]);
+        float gAreas[2] = {gArea1, gArea2};
+        for (uint32_t b = 0; b < 2; b++) {
+            const float* param = box + b * BOX_DIM;
+            float sign = b == 0 ? 1.0f : -1.0f;
+            float gx = sign * gCenterX;
+            float gy = sign * gCenterY;
+            float gw = gAreas[b] * param[3];
+            float gh = gAreas[b] * param[2];
+            float ga = 0;
+            for (uint32_t k = 0; k < BOX_CORNERS; k++) {
+                uint32_t p = b * BOX_CORNERS + k;
+                gx += gpx_[p];
+                gy += gpy_[p];
+                gw += CornerU(k) * (cosA[b] * gpx_[p] + sinA[b] * gpy_[p]);
+                gh += CornerV(k) * (cosA[b] * gpy_[p] - sinA[b] * gpx_[p]);
+                ga += (px_[p] - param[0]) * gpy_[p] - (py_[p] - param[1]) * gpx_[p];
+            }
+            uint32_t base = idx * GRAD_DIM + b * BOX_DIM;
+            gradLocal_.SetValue(base, gx);
+            gradLocal_.SetValue(base + 1, gy);
+            gradLocal_.SetValue(base + 2, gw);
+            gradLocal_.SetValue(base + 3, gh);
+            gradLocal_.SetValue(base + 4, ga);
+        }
+    }
+
+private:
+    TPipe* pipe_;
+    GlobalTensor<float> boxesAGm_, boxesBGm_, iousGm_, gradGm_;
+    TBuf<TPosition::VECCALC> boxesABuf_, boxesBBuf_, angleBuf_, sinBuf_, cosBuf_, iousBuf_, gradBuf_;
+    LocalTensor<float> boxesALocal_, boxesBLocal_, angleLocal_, sinLocal_, cosLocal_, iousLocal_, gradLocal_;
+
+    uint32_t coreTask_;
+    uint32_t taskOffset_;
+    uint32_t singleLoopTaskCount_;
+    uint32_t angleLen_;
+    int32_t mode_;
+    bool withGrad_;
+
+    // 单对框的标量工作区
+    float px_[LINE_NUM];
+    float py_[LINE_NUM];
+    float gpx_[LINE_NUM];
+    float gpy_[LINE_NUM];
+    float vx_[MAX_POLY];
+    float vy_[MAX_POLY];
+    uint32_t vIn_[MAX_POLY];
+    uint32_t vOut_[MAX_POLY];
+    float wx_[MAX_POLY];
+    float wy_[MAX_POLY];
+    uint32_t wIn_[MAX_POLY];
+    uint32_t wOut_[MAX_POLY];
+    float side_[MAX_POLY];
+};
+
+extern "C" __global__ __aicore__ void diff_iou_rotated(GM_ADDR boxes_a, GM_ADDR boxes_b, GM_ADDR ious, GM_ADDR grad,
+    GM_ADDR workspace, GM_ADDR tiling_data)
+{
+    GET_TILING_DATA(tiling, tiling_data);
+    SetSysWorkspace(workspace);
+    TPipe pipe;
+    KernelDiffIouRotated op;
+    op.Init(&pipe, boxes_a, boxes_b, ious, grad, &tiling);
+    op.Process();
+}
@@ -10,7 +10,7 @@ using namespace AscendC;
 // Entrance of kernel
 extern "C" __global__ __aicore__ void furthest_point_sampling(
     GM_ADDR point_xyz,
-    GM_ADDR temp,
+    GM_ADDR point_counts,
     GM_ADDR index,
     GM_ADDR workspace,
     GM_ADDR tiling) {
@@ -32,17 +32,25 @@ extern "C" __global__ __aicore__ void furthest_point_sampling(
     TA.repeats        = tiling_data.repeats;
 
     if (TILING_KEY_IS(0)) {
-        furthestPointSamplingKernel<float, int32_t> op(point_xyz, temp, index, workspace, &TA);
+        furthestPointSamplingKernel<float, int32_t> op(point_xyz, nullptr, index, workspace, &TA);
+        op.Process();
+    } else if (TILING_KEY_IS(1)) {
+        furthestPointSamplingKernel<float, int32_t> op(point_xyz, point_counts, index, workspace, &TA);
+        op.Process();
+    } else if (TILING_KEY_IS(2)) {
+        furthestPointSamplingKernel<float, int32_t> op(point_xyz, point_counts, index, workspace, &TA, true);
         op.Process();
     }
 }
 
 template<typename dataType, typename idxType>
 __aicore__ inline furthestPointSamplingKernel<dataType, idxType>::furthestPointSamplingKernel(GM_ADDR point_xyz,
-    GM_ADDR temp, GM_ADDR index, GM_ADDR workspace, tilingArgs *tiling)
+    GM_ADDR point_counts, GM_ADDR index, GM_ADDR workspace, tilingArgs *tiling, bool isPacked)
 {
     // Init tiling args.
     this->TA = tiling;
+    this->isPacked = isPacked;
+    this->isRagged = (point_counts != nullptr) && !isPacked;
     // host tiling have ensured formerNum is aligned with 32bytes and bigger than tailNum.
     this->sizeofFormer = this->TA->formerNum * sizeof(dataType);
     this->sizeofTail = this->TA->tailNum * sizeof(dataType);
@@ -51,7 +59,7 @@ __aicore__ inline furthestPointSamplingKernel<dataType, idxType>::furthestPointS
     this->dataNumIn256Bytes = 256 / sizeof(dataType);
     this->dataNumIn1024Bytes = 1024 / sizeof(dataType);
     // Init GM.
-    InitGm(point_xyz, temp, index, workspace);
+    InitGm(point_xyz, point_counts, index, workspace);
 
     // Must be aligned with 32bytes.
     this->pipe.InitBuffer(this->pointXQue, BUFFER_NUM, this->sizeofFormer);
@@ -68,6 +76,7 @@ __aicore__ inline furthestPointSamplingKernel<dataType, idxType>::furthestPointS
 
     this->pipe.InitBuffer(this->idxTempUb, BUFFER_NUM, this->TA->idxTempSize);
     this->pipe.InitBuffer(this->pointSampled, BUFFER_NUM, 32 * 3);
+    this->pipe.InitBuffer(this->countQue, BUFFER_NUM, 32);
     // Malloc.
     this->ubBlocks.pointXLocal = pointXQue.AllocTensor<dataType>();
     this->ubBlocks.pointYLocal = pointYQue.AllocTensor<dataType>();
@@ -83,6 +92,7 @@ __aicore__ inline furthestPointSamplingKernel<dataType, idxType>::furthestPointS
 
     this->ubBlocks.idxTempLocal = idxTempUb.AllocTensor<dataType>();
     this->ubBlocks.pointSampledLocal = pointSampled.AllocTensor<dataType>();
+    this->ubBlocks.countLocal = countQue.AllocTensor<int32_t>();
 }
 
 template<typename dataType, typename idxType>
@@ -91,14 +101,21 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::Process()
     uint32_t batch_num = (GetBlockIdx() < this->TA->bigCoreNum) ? (this->TA->bigCoreBatch) : (this->TA->smallCoreBatch);
 
     for (this->core_batch = 0; this->core_batch < batch_num; this->core_batch++) {
-        this->batchOffsetPoint = this->core_batch * this->TA->N * 3;
-        this->batchOffsetNearest = this->core_batch * this->TA->N;
+        if (this->isPacked) {
+            // packed batch reads each sample in place from its offset, the axis stride is the total point count
+            SetValidRange(CopyInPointRange());
+        } else {
+            this->batchOffsetPoint = this->core_batch * this->TA->N * 3;
+            this->batchOffsetNearest = this->core_batch * this->TA->N;
+            // ragged batch only reads and reduces the first point_counts[b] points of each sample
+            SetValidRange(this->isRagged ? CopyInPointCount() : this->TA->N);
+        }
         // Set：idxGm[0] = 0
         CopyInIdx(0);
         if (this->TA->numPoints == 1) {
             CopyOut(0); // special case: only one points sampled.
         }
-        if (this->TA->pieces == 1) {
+        if (this->curPieces == 1) {
             Process_complete_data();
         } else {
             Process_split_data();
@@ -138,6 +155,81 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInIdx
     this->maxDistIdx = 0;
 }
 
+template<typename dataType, typename idxType>
+__aicore__ inline uint32_t furthestPointSamplingKernel<dataType, idxType>::CopyInPointCount()
+{
+    DataCopyExtParams data_copy_param = {1, sizeof(int32_t), 0, 0, 0};
+    DataCopyPadExtParams<int32_t> pad_param = {false, 0, 0, 0};
+
+    set_flag(PIPE_S, PIPE_MTE2, EVENT_ID3);
+    wait_flag(PIPE_S, PIPE_MTE2, EVENT_ID3);
+
+#ifndef __GET_CODE_CHANNEL__
+    DataCopyPad(this->ubBlocks.countLocal, pointCountsGm[this->core_batch], data_copy_param, pad_param);
+#endif
+
+    set_flag(PIPE_MTE2, PIPE_S, EVENT_ID3);
+    wait_flag(PIPE_MTE2, PIPE_S, EVENT_ID3);
+
+    int32_t count = this->ubBlocks.countLocal.GetValue(0);
+    // out of range counts are clamped to [1, N], an empty sample returns index 0 only
+    if (count < 1) {
+        return 1;
+    }
+    return (static_cast<uint32_t>(count) > this->TA->N) ? this->TA->N : static_cast<uint32_t>(count);
+}
+
+template<typename dataType, typename idxType>
+__aicore__ inline uint32_t furthestPointSamplingKernel<dataType, idxType>::CopyInPointRange()
+{
+    DataCopyExtParams data_copy_param = {1, 2 * sizeof(int32_t), 0, 0, 0};
+    DataCopyPadExtParams<int32_t> pad_param = {false, 0, 0, 0};
+
+    set_flag(PIPE_S, PIPE_MTE2, EVENT_ID3);
+    wait_flag(PIPE_S, PIPE_MTE2, EVENT_ID3);
+
+#ifndef __GET_CODE_CHANNEL__
+    DataCopyPad(this->ubBlocks.countLocal, pointCountsGm[this->core_batch], data_copy_param, pad_param);
+#endif
+
+    set_flag(PIPE_MTE2, PIPE_S, EVENT_ID3);
+    wait_flag(PIPE_MTE2, PIPE_S, EVENT_ID3);
+
+    int32_t start = this->ubBlocks.countLocal.GetValue(0);
+    int32_t end = this->ubBlocks.countLocal.GetValue(1);
+    // an empty sample still reads one point inside the buffer, its row is discarded by the caller
+    if (start < 0) {
+        start = 0;
+    }
+    if (static_cast<uint32_t>(start) >= this->TA->N) {
+        start = this->TA->N - 1;
+    }
+    uint32_t count = (end > start) ? static_cast<uint32_t>(end - start) : 1;
+    if (start + count > this->TA->N) {
+        count = this->TA->N - start;
+    }
+    this->batchOffsetPoint = start;
+    this->batchOffsetNearest = start;
+    return count;
+}
+
+template<typename dataType, typename idxType>
+__aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::SetValidRange(uint32_t validNum)
+{
+    // formerNum is the same for every batch, so only the number of pieces and the tail shrink.
+    this->curPieces = (validNum + this->TA->formerNum - 1) / this->TA->formerNum;
+    this->curTailNum = validNum - this->TA->formerNum * (this->curPieces - 1);
+    this->sizeofCurTail = this->curTailNum * sizeof(dataType);
+}
+
+template<typename dataType, typename idxType>
+__aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::InitNearestDist()
+{
+    // nearest distance starts from a large value on chip, no host side initialized tensor is needed.
+    Duplicate<dataType>(this->ubBlocks.nearestDistLocal, static_cast<dataType>(NEAREST_DIST_INIT),
+        this->TA->formerNum);
+}
+
 template<typename dataType, typename idxType>
 __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::Process_complete_data()
 {
@@ -173,11 +265,11 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::Process_s
     uint32_t loopNum, loopSplit;
 
     for (loopNum = 1; loopNum < this->TA->numPoints; loopNum++) {
-        for (loopSplit = 0; loopSplit < this->TA->pieces; loopSplit++) {
+        for (loopSplit = 0; loopSplit < this->curPieces; loopSplit++) {
             if (loopNum == 1) {
                 Process_first_sampling(loopSplit);
             } else {
-                uint32_t comBlock = (loopSplit + this->TA->pieces - 1) % this->TA->pieces;
+                uint32_t comBlock = (loopSplit + this->curPieces - 1) % this->curPieces;
 
                 // Cal point_x -> Mov point_x, Cal point_y -> Mov point_y, Cal point_z -> Mov point_z
                 ComputePointDeltaSquare(this->ubBlocks.pointXLocal, this->ubBlocks.pointTempXLocal, this->pointXSampled);
@@ -257,10 +349,9 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::Process_f
 
     ComputeDist();
 
-    CopyInNearestDist(loopSplit);
+    InitNearestDist();
 
-    set_flag(PIPE_MTE2, PIPE_V, EVENT_ID3);
-    wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID3);
+    pipe_barrier(PIPE_V);
 
     ComputeSamplePoints(loopSplit, loopSplit);
 }
@@ -273,8 +364,8 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInPoi
     DataCopyParams data_copy_param = {1, 0, 0, 0};
     DataCopyPadParams pad_param = {false, 0, 0, 0};
 
-    if (loopSplit == (this->TA->pieces - 1)) {
-        data_copy_param.blockLen = this->sizeofTail;
+    if (loopSplit == (this->curPieces - 1)) {
+        data_copy_param.blockLen = this->sizeofCurTail;
     } else {
         data_copy_param.blockLen = this->sizeofFormer;
     }
@@ -316,27 +407,6 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInPoi
     }
 }
 
-template<typename dataType, typename idxType>
-__aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInNearestDist(uint32_t loopSplit)
-{
-    uint64_t offset = this->batchOffsetNearest + this->TA->formerNum * loopSplit;
-    DataCopyParams data_copy_param = {1, 0, 0, 0};
-    DataCopyPadParams pad_param = {false, 0, 0, 0};
-
-    if (loopSplit == (this->TA->pieces - 1)) {
-        data_copy_param.blockLen = this->sizeofTail;
-    } else {
-        data_copy_param.blockLen = this->sizeofFormer;
-    }
-
-    set_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
-    wait_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
-
-#ifndef __GET_CODE_CHANNEL__
-    DataCopyPad(this->ubBlocks.nearestDistLocal, nearestDistGm[offset], data_copy_param, pad_param);
-#endif
-}
-
 template<typename dataType, typename idxType>
 __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInNearestDistTemp(uint32_t loopSplit)
 {
@@ -344,8 +414,8 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyInNea
     DataCopyParams data_copy_param = {1, 0, 0, 0};
     DataCopyPadParams pad_param = {false, 0, 0, 0};
 
-    if (loopSplit == (this->TA->pieces - 1)) {
-        data_copy_param.blockLen = this->sizeofTail;
+    if (loopSplit == (this->curPieces - 1)) {
+        data_copy_param.blockLen = this->sizeofCurTail;
     } else {
         data_copy_param.blockLen = this->sizeofFormer;
     }
@@ -445,8 +515,7 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::ComputeSa
 {
     uint32_t total_num, dupTime, offset, comp_num, reduceCnt, reduceOffset;
 
-    reduceCnt = ((this->TA->formerNum != this->TA->tailNum) && (comBlock == (this->TA->pieces - 1))) ?
-        this->TA->tailNum : this->TA->formerNum;
+    reduceCnt = (comBlock == (this->curPieces - 1)) ? this->curTailNum : this->TA->formerNum;
     reduceOffset = comBlock * 2;
 
     for (offset = 0, total_num = this->TA->formerNum; total_num > 0;
@@ -461,7 +530,7 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::ComputeSa
             this->ubBlocks.distLocal[offset], this->dataNumIn256Bytes, dupTime, {1, 1, 1, 8, 8, 8});
     }
 
-    if (this->TA->pieces > 1) {
+    if (this->curPieces > 1) {
         // set_flag: After Updated nearestDistLocal, Mov nearestDistLocal to GM.
         set_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
         wait_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
@@ -480,8 +549,8 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::updateDis
 {
     dataType tempValue;
 
-    // this->TA->pieces >= 1
-    for (uint32_t i = 1; i < (2 * this->TA->pieces); i = (i + 2)) {
+    // this->curPieces >= 1
+    for (uint32_t i = 1; i < (2 * this->curPieces); i = (i + 2)) {
         tempValue = this->ubBlocks.idxTempLocal.GetValue(i);
         if (this->maxDist < this->ubBlocks.idxTempLocal.GetValue(i-1)) {
             this->maxDist = this->ubBlocks.idxTempLocal.GetValue(i-1);
@@ -525,8 +594,8 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyOutNe
     uint64_t offset = this->batchOffsetNearest + this->TA->formerNum * loopSplit;
     DataCopyExtParams data_copy_param = {1, 0, 0, 0, 0};
 
-    if (loopSplit == (this->TA->pieces - 1)) {
-        data_copy_param.blockLen = this->sizeofTail;
+    if (loopSplit == (this->curPieces - 1)) {
+        data_copy_param.blockLen = this->sizeofCurTail;
     } else {
         data_copy_param.blockLen = this->sizeofFormer;
     }
@@ -540,30 +609,37 @@ __aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::CopyOutNe
 }
 
 template<typename dataType, typename idxType>
-__aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::InitGm(GM_ADDR point_xyz, GM_ADDR temp,
-    GM_ADDR index, GM_ADDR workspace)
+__aicore__ inline void furthestPointSamplingKernel<dataType, idxType>::InitGm(GM_ADDR point_xyz,
+    GM_ADDR point_counts, GM_ADDR index, GM_ADDR workspace)
 {
     GM_ADDR usrWorkspace = AscendC::GetUserWorkspace(workspace);
     uint32_t coreId = GetBlockIdx();
-    uint64_t skipData, numData, skipIdx, numIdx;
-    uint64_t numDataBigCore = this->TA->bigCoreBatch * this->TA->N;
-    uint64_t numIdxBigCore = this->TA->bigCoreBatch * this->TA->numPoints;
+    uint64_t skipBatch, numBatch;
 
     if (coreId < this->TA->bigCoreNum) {
-        numData = numDataBigCore;
-        numIdx = numIdxBigCore;
-        skipData = numData * coreId;
-        skipIdx = numIdx * coreId;
+        numBatch = this->TA->bigCoreBatch;
+        skipBatch = numBatch * coreId;
     } else {
-        numData = this->TA->smallCoreBatch * this->TA->N;
-        numIdx = this->TA->smallCoreBatch * this->TA->numPoints;
-        skipData = this->TA->bigCoreNum * numDataBigCore + (coreId - this->TA->bigCoreNum) * numData;
-        skipIdx = this->TA->bigCoreNum * numIdxBigCore + (coreId - this->TA->bigCoreNum) * numIdx;
+        numBatch = this->TA->smallCoreBatch;
+        skipBatch = this->TA->bigCoreNum * this->TA->bigCoreBatch + (coreId - this->TA->bigCoreNum) * numBatch;
     }
+    uint64_t numIdx = numBatch * this->TA->numPoints;
+    uint64_t skipIdx = skipBatch * this->TA->numPoints;
+    this->idxGm.SetGlobalBuffer((__gm__ idxType*)index + skipIdx, numIdx);
 
+    if (this->isPacked) {
+        // every core sees the whole packed buffer and the offsets of its own samples
+        this->pointGm.SetGlobalBuffer((__gm__ dataType*)point_xyz, this->TA->N * 3);
+        this->pointCountsGm.SetGlobalBuffer((__gm__ int32_t*)point_counts + skipBatch, numBatch + 1);
+        this->nearestDistTempGm.SetGlobalBuffer((__gm__ dataType*)usrWorkspace, this->TA->N);
+        return;
+    }
+    uint64_t numData = numBatch * this->TA->N;
+    uint64_t skipData = skipBatch * this->TA->N;
     this->pointGm.SetGlobalBuffer((__gm__ dataType*)point_xyz + skipData * 3, numData * 3);
-    this->nearestDistGm.SetGlobalBuffer((__gm__ dataType*)temp + skipData, numData);
-    this->idxGm.SetGlobalBuffer((__gm__ idxType*)index + skipIdx, numIdx);
+    if (this->isRagged) {
+        this->pointCountsGm.SetGlobalBuffer((__gm__ int32_t*)point_counts + skipBatch, numBatch);
+    }
     this->nearestDistTempGm.SetGlobalBuffer((__gm__ dataType*)usrWorkspace + skipData, numData);
 }
 
@@ -584,4 +660,5 @@ __aicore__ inline furthestPointSamplingKernel<dataType, idxType>::~furthestPoint
 
     this->idxTempUb.FreeTensor(this->ubBlocks.idxTempLocal);
     this->pointSampled.FreeTensor(this->ubBlocks.pointSampledLocal);
+    this->countQue.FreeTensor(this->ubBlocks.countLocal);
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ namespace AscendC {
 constexpr uint32_t BUFFER_NUM = 1u;
 constexpr uint32_t OP_MAX_REPEAT_NUM = 255u;
 constexpr uint32_t ALLIGNED_BYTES = 256u;
+constexpr float NEAREST_DIST_INIT = 1e10f;
 
 enum PointAxis {
     pointAxis_x,
@@ -36,6 +37,7 @@ struct UbBlocks_tag {
     LocalTensor<dataType> idxTempLocal;
     LocalTensor<dataType> pointSampledLocal;
     LocalTensor<dataType> workLocal;
+    LocalTensor<int32_t>  countLocal;
 };
 template<typename dataType, typename idxType>
 using UbBlocks = UbBlocks_tag<dataType, idxType>;
@@ -61,8 +63,8 @@ public:
 template<typename dataType, typename idxType>
 class furthestPointSamplingKernel {
 public:
-    __aicore__ inline furthestPointSamplingKernel(GM_ADDR point_xyz, GM_ADDR temp, GM_ADDR index, GM_ADDR workspace,
-        tilingArgs *tiling);
+    __aicore__ inline furthestPointSamplingKernel(GM_ADDR point_xyz, GM_ADDR point_counts, GM_ADDR index,
+        GM_ADDR workspace, tilingArgs *tiling, bool isPacked = false);
     __aicore__ inline ~furthestPointSamplingKernel();
     __aicore__ inline void Process();
 
@@ -73,13 +75,16 @@ private:
 
 private:
     __aicore__ inline void CopyInPointAxis(PointAxis pointAxis, uint32_t loopSplit = 0);
-    __aicore__ inline void CopyInNearestDist(uint32_t loopSplit = 0);
+    __aicore__ inline uint32_t CopyInPointCount();
+    __aicore__ inline uint32_t CopyInPointRange();
     __aicore__ inline void CopyInNearestDistTemp(uint32_t loopSplit = 0);
     __aicore__ inline void CopyInIdx(uint32_t loopNum);
     __aicore__ inline void CopyOut(uint32_t loopNum);
     __aicore__ inline void CopyOutNearestDistTemp(uint32_t loopSplit = 0);
 
 private:
+    __aicore__ inline void SetValidRange(uint32_t validNum);
+    __aicore__ inline void InitNearestDist();
     __aicore__ inline void ComputePointsSquare();
     __aicore__ inline void ComputePointDeltaSquare(LocalTensor<dataType> &pointLocal,
         LocalTensor<dataType> &pointTempLocal, dataType pointSampled);
@@ -88,7 +93,7 @@ private:
     __aicore__ inline void updateDist();
 
 private:
-    __aicore__ inline void InitGm(GM_ADDR point_xyz, GM_ADDR temp, GM_ADDR index, GM_ADDR workspace);
+    __aicore__ inline void InitGm(GM_ADDR point_xyz, GM_ADDR point_counts, GM_ADDR index, GM_ADDR workspace);
 
 private:
     TPipe pipe;
@@ -106,10 +111,11 @@ private:
 
     TQue<QuePosition::VECOUT, BUFFER_NUM> idxTempUb;
     TQue<QuePosition::VECOUT, BUFFER_NUM> pointSampled;
+    TQue<QuePosition::VECIN, BUFFER_NUM> countQue;
 
 private:
     GlobalTensor<dataType> pointGm;
-    GlobalTensor<dataType> nearestDistGm;
+    GlobalTensor<int32_t> pointCountsGm;
     GlobalTensor<idxType> idxGm;
     GlobalTensor<dataType> nearestDistTempGm;
     UbBlocks<dataType, idxType> ubBlocks;
@@ -121,6 +127,9 @@ private:
     dataType maxDist {0};
     idxType maxDistIdx {0};
     uint32_t core_batch;
+    bool isRagged;
+    // packed batch: point_xyz is [1, 3, total] and point_counts holds the [B + 1] offsets of the samples
+    bool isPacked;
 
 private:
     // tiling value
@@ -135,6 +144,10 @@ private:
     uint32_t dataNumIn1024Bytes;
     uint32_t batchOffsetPoint;
     uint32_t batchOffsetNearest;
+    // valid range of current batch, equals to pieces/tailNum of tiling unless ragged
+    uint32_t curPieces;
+    uint32_t curTailNum;
+    uint32_t sizeofCurTail;
 };
 }
 
@@ -7,6 +7,8 @@ using namespace AscendC;
 extern "C" __global__ __aicore__ void knn(
     GM_ADDR xyz,
     GM_ADDR center_xyz,
+    GM_ADDR cell_start,
+    GM_ADDR grid_bounds,
     GM_ADDR dist,
     GM_ADDR idx,
     GM_ADDR workspace,
@@ -14,6 +16,11 @@ extern "C" __global__ __aicore__ void knn(
     TPipe tmpPipe;
     GET_TILING_DATA(tiling_data, tiling);
 
-    KnnKernel<float, int32_t> op(xyz, center_xyz, dist, idx, &tiling_data, &tmpPipe);
-    op.Process();
-}
\ No newline at end of file
+    if (TILING_KEY_IS(0)) {
+        KnnKernel<float, int32_t> op(xyz, center_xyz, cell_start, grid_bounds, dist, idx, &tiling_data, &tmpPipe);
+        op.Process();
+    } else if (TILING_KEY_IS(1)) {
+        KnnKernel<half, int32_t> op(xyz, center_xyz, cell_start, grid_bounds, dist, idx, &tiling_data, &tmpPipe);
+        op.Process();
+    }
+}
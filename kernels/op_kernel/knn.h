@@ -9,10 +9,12 @@
 
 namespace AscendC {
 // T is the dtype of input and output dist2(float32 or float16) while U is for the output idx(only int32_t)
+// distances are always computed and sorted in float32
 template<typename T, typename U>
 class KnnKernel {
 public:
-    __aicore__ inline KnnKernel(GM_ADDR xyz, GM_ADDR center_xyz, GM_ADDR dist, GM_ADDR idx, const KnnTilingData* tiling_data, TPipe *tmpPipe)
+    __aicore__ inline KnnKernel(GM_ADDR xyz, GM_ADDR center_xyz, GM_ADDR cell_start, GM_ADDR grid_bounds,
+        GM_ADDR dist, GM_ADDR idx, const KnnTilingData* tiling_data, TPipe *tmpPipe)
     {
         ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
         batch = tiling_data->batch;
@@ -21,14 +23,23 @@ public:
         coreNum = tiling_data->coreNum;
         isFromKnn = tiling_data->isFromKnn;
         k = tiling_data->k;
+        withSqrt = tiling_data->withSqrt;
+        useGrid = tiling_data->useGrid;
+        gridXNum = static_cast<int32_t>(tiling_data->gridXNum);
+        gridYNum = static_cast<int32_t>(tiling_data->gridYNum);
+        gridLowX = tiling_data->gridLowX;
+        gridLowY = tiling_data->gridLowY;
+        cellSize = tiling_data->cellSize;
+        hasGridBounds = tiling_data->hasGridBounds;
 
         formerTaskNum = Ceil(batch * nPoint, coreNum);
 
         coreId = GetBlockIdx();
-        InitGm(xyz, center_xyz, dist, idx, tmpPipe);
+        InitGm(xyz, center_xyz, cell_start, grid_bounds, dist, idx, tmpPipe);
         InitBuffer();
     }
-    __aicore__ inline void InitGm(GM_ADDR xyz, GM_ADDR center_xyz, GM_ADDR dist, GM_ADDR idx, TPipe *tmpPipe)
+    __aicore__ inline void InitGm(GM_ADDR xyz, GM_ADDR center_xyz, GM_ADDR cell_start, GM_ADDR grid_bounds,
+        GM_ADDR dist, GM_ADDR idx, TPipe *tmpPipe)
     {
         pipe = tmpPipe;
         startTask = coreId * formerTaskNum;
@@ -41,45 +52,79 @@ public:
         targetGm.SetGlobalBuffer((__gm__ T *)center_xyz, static_cast<uint64_t>(batch) * nPoint * 3);
         distGm.SetGlobalBuffer((__gm__ T *)dist, static_cast<uint64_t>(batch) * nPoint * k);
         idxGm.SetGlobalBuffer((__gm__ int32_t*)idx, static_cast<uint64_t>(batch) * nPoint * k);
+        if (useGrid) {
+            cellStartGm.SetGlobalBuffer((__gm__ int32_t*)cell_start,
+                static_cast<uint64_t>(batch) * (gridXNum * gridYNum + 1));
+        }
+        if (useGrid && hasGridBounds) {
+            gridBoundsGm.SetGlobalBuffer((__gm__ float*)grid_bounds, GRID_BOUNDS_NUM);
+        }
+    }
+
+    // device上计算的网格下界(x, y)与网格大小，只在开始时读取一次
+    __aicore__ inline void LoadGridBounds()
+    {
+        LocalTensor<float> boundsLocal = cellStartUb.Get<float>();
+        DataCopyPad(boundsLocal, gridBoundsGm, {1, static_cast<uint32_t>(GRID_BOUNDS_NUM * sizeof(float)), 0, 0, 0},
+            {false, 0, 0, 0});
+        set_flag(PIPE_MTE2, PIPE_S, EVENT_ID2);
+        wait_flag(PIPE_MTE2, PIPE_S, EVENT_ID2);
+        gridLowX = boundsLocal.GetValue(0);
+        gridLowY = boundsLocal.GetValue(1);
+        cellSize = boundsLocal.GetValue(2);
+        set_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
+        wait_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
     }
 
     __aicore__ inline void InitBuffer()
     {
         pipe->InitBuffer(targetUb, 32);
-        pipe->InitBuffer(sourceBackupUb, compNum * sizeof(T) * 3);
-        pipe->InitBuffer(sourceUb, compNum * sizeof(T) * 3);
-        pipe->InitBuffer(distUb, compNum * sizeof(T));
+        pipe->InitBuffer(sourceBackupUb, compNum * sizeof(float) * 3);
+        pipe->InitBuffer(sourceUb, compNum * sizeof(float) * 3);
+        pipe->InitBuffer(distUb, compNum * sizeof(float));
         pipe->InitBuffer(idxUb, compNum * sizeof(int32_t));
         pipe->InitBuffer(constIdxUb, compNum * sizeof(int32_t));
 
-        pipe->InitBuffer(bestDistUb, compNum * sizeof(T));
+        pipe->InitBuffer(bestDistUb, compNum * sizeof(float));
         pipe->InitBuffer(bestIdxUb, compNum * sizeof(int32_t));
 
-        pipe->InitBuffer(sortSrcUb, compNum * sizeof(T) * 2);
-        pipe->InitBuffer(sortTmp1Ub, mergeLength * sizeof(T) * 4);
-        pipe->InitBuffer(sortTmp2Ub, mergeLength * sizeof(T) * 4);
+        pipe->InitBuffer(sortSrcUb, compNum * sizeof(float) * 2);
+        pipe->InitBuffer(sortTmp1Ub, mergeLength * sizeof(float) * 4);
+        pipe->InitBuffer(sortTmp2Ub, mergeLength * sizeof(float) * 4);
+        pipe->InitBuffer(cellStartUb, 64);
+        if constexpr (!IS_FLOAT) {
+            pipe->InitBuffer(sourceCastUb, compNum * sizeof(T) * 3);
+            pipe->InitBuffer(targetCastUb, 32);
+            pipe->InitBuffer(bestDistCastUb, compNum * sizeof(T));
+        }
     }
     __aicore__ inline void Process()
     {
-        // 计算loop time
-        uint32_t loopTimes = nSource / compNum;
-        uint32_t tailNum = nSource % compNum;
-        sourceBackupLocal = sourceBackupUb.Get<T>();
-        sourceLocal = sourceUb.Get<T>();
-        targetLocal = targetUb.Get<T>();
-        distLocal = distUb.Get<T>();
+        sourceBackupLocal = sourceBackupUb.Get<float>();
+        sourceLocal = sourceUb.Get<float>();
+        targetLocal = targetUb.Get<float>();
+        distLocal = distUb.Get<float>();
         idxLocal = idxUb.Get<int32_t>();
-        bestDistLocal = bestDistUb.Get<T>();
+        bestDistLocal = bestDistUb.Get<float>();
         bestIdxLocal = bestIdxUb.Get<int32_t>();
+        cellStartLocal = cellStartUb.Get<int32_t>();
+        if (useGrid && hasGridBounds) {
+            LoadGridBounds();
+        }
+        if constexpr (!IS_FLOAT) {
+            sourceCastLocal = sourceCastUb.Get<T>();
+            targetCastLocal = targetCastUb.Get<T>();
+            bestDistCastLocal = bestDistCastUb.Get<T>();
+        }
 
         constIdxLocal = constIdxUb.Get<int32_t>();
         for (int32_t index = 0; index < compNum; index++) {
             constIdxLocal.SetValue((uint32_t)index, index);
         }
 
-        sortSrcLocal = sortSrcUb.Get<T>();
-        sortTmp1Local = sortTmp1Ub.Get<T>();
-        sortTmp2Local = sortTmp2Ub.Get<T>();
+        sortSrcLocal = sortSrcUb.Get<float>();
+        sortTmp1Local = sortTmp1Ub.Get<float>();
+        sortTmp2Local = sortTmp2Ub.Get<float>();
 
         for (uint32_t currentTask = startTask; currentTask < endTask; currentTask++) {
             uint64_t currentBatch = currentTask / nPoint;
@@ -87,25 +132,20 @@ public:
             uint64_t targetOffset = currentTask * 3; // B M 3
             uint64_t copyOutOffset = currentTask * k; // B M N
 
-            set_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
-            wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
-            DataCopy(targetLocal, targetGm[targetOffset], 8);
-
-            set_flag(PIPE_MTE2, PIPE_V, EVENT_ID0);
-            wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID0);
-            Duplicate<T>(sourceBackupLocal, targetLocal.GetValue(0), (int32_t)compNum);
-            Duplicate<T>(sourceBackupLocal[compNum], targetLocal.GetValue(1), (int32_t)compNum);
-            Duplicate<T>(sourceBackupLocal[compNum * 2], targetLocal.GetValue(2), (int32_t)compNum);
+            CopyInTarget(targetOffset);
+            Duplicate<float>(sourceBackupLocal, targetX, (int32_t)compNum);
+            Duplicate<float>(sourceBackupLocal[compNum], targetY, (int32_t)compNum);
+            Duplicate<float>(sourceBackupLocal[compNum * 2], targetZ, (int32_t)compNum);
 
             Duplicate(sortTmp1Local, minFloatValue, mergeLength * 4);
             Duplicate(sortTmp2Local, minFloatValue, mergeLength * 4);
+            mergeCount = 0;
 
             set_flag(PIPE_V, PIPE_MTE2, EVENT_ID1);
-            for (uint32_t currentLoop = 0; currentLoop < loopTimes; currentLoop++) {
-                Compute(currentLoop, compNum, sourceOffset);
-            }
-            if (tailNum > 0) {
-                Compute(loopTimes, tailNum, sourceOffset);
+            if (useGrid) {
+                SearchGrid(currentBatch, sourceOffset);
+            } else {
+                ComputeRange(0, nSource, sourceOffset);
             }
             wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID1);
 
@@ -113,37 +153,173 @@ public:
         }
     }
 
-    __aicore__ inline void Compute(uint32_t currentLoop, uint32_t copySize, uint64_t sourceOffset)
+    __aicore__ inline void CopyInTarget(uint64_t targetOffset)
     {
-        uint32_t copyInLength = static_cast<uint32_t>(copySize * sizeof(T));
-        uint32_t loopOffset = currentLoop * compNum;
+        set_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
+        wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID0);
+        if constexpr (IS_FLOAT) {
+            DataCopy(targetLocal, targetGm[targetOffset], 8);
+        } else {
+            DataCopyPad(targetCastLocal, targetGm[targetOffset], {1, static_cast<uint32_t>(3 * sizeof(T)), 0, 0, 0},
+                {false, 0, 0, 0});
+            set_flag(PIPE_MTE2, PIPE_V, EVENT_ID0);
+            wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID0);
+            Cast(targetLocal, targetCastLocal, RoundMode::CAST_NONE, 8);
+        }
+        set_flag(PIPE_MTE2, PIPE_S, EVENT_ID0);
+        wait_flag(PIPE_MTE2, PIPE_S, EVENT_ID0);
+        set_flag(PIPE_V, PIPE_S, EVENT_ID0);
+        wait_flag(PIPE_V, PIPE_S, EVENT_ID0);
+        targetX = targetLocal.GetValue(0);
+        targetY = targetLocal.GetValue(1);
+        targetZ = targetLocal.GetValue(2);
+        set_flag(PIPE_S, PIPE_V, EVENT_ID0);
+        wait_flag(PIPE_S, PIPE_V, EVENT_ID0);
+    }
 
-        wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID1);
-        DataCopyPad(sourceLocal, sourceGm[sourceOffset + loopOffset],
-                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
-        DataCopyPad(sourceLocal[compNum], sourceGm[sourceOffset + loopOffset + nSource],
-                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
-        DataCopyPad(sourceLocal[compNum * 2], sourceGm[sourceOffset + loopOffset + nSource * 2],
-                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
+    __aicore__ inline void ComputeRange(uint32_t start, uint32_t end, uint64_t sourceOffset)
+    {
+        for (uint32_t current = start; current < end; current += compNum) {
+            Compute(current, (end - current) < compNum ? (end - current) : compNum, sourceOffset);
+        }
+    }
 
-        set_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
-        wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
-        Sub<T>(sourceLocal, sourceLocal, sourceBackupLocal, compNum * 3);
-        Mul<T>(sourceLocal, sourceLocal, sourceLocal, compNum * 3);
+    // 网格模式：按环由内向外访问目标点所在网格的邻域，已找到的第k近距离不超过未访问区域的下界时停止
+    __aicore__ inline void SearchGrid(uint64_t currentBatch, uint64_t sourceOffset)
+    {
+        int32_t cx = ClampCell((targetX - gridLowX) / cellSize, gridXNum);
+        int32_t cy = ClampCell((targetY - gridLowY) / cellSize, gridYNum);
+        uint64_t cellBase = currentBatch * (gridXNum * gridYNum + 1);
+        for (int32_t r = 0;; r++) {
+            int32_t x0 = cx - r;
+            int32_t x1 = cx + r;
+            int32_t y0 = cy - r;
+            int32_t y1 = cy + r;
+            int32_t xBegin = x0 > 0 ? x0 : 0;
+            int32_t xEnd = x1 < gridXNum - 1 ? x1 : gridXNum - 1;
+            int32_t yBegin = y0 > 0 ? y0 : 0;
+            int32_t yEnd = y1 < gridYNum - 1 ? y1 : gridYNum - 1;
+            for (int32_t x = xBegin; x <= xEnd; x++) {
+                uint64_t rowBase = cellBase + static_cast<uint64_t>(x) * gridYNum;
+                if (x == x0 || x == x1) {
+                    // 按x优先排序，同一x下连续的网格对应连续的源点
+                    ComputeCells(rowBase + yBegin, rowBase + yEnd, sourceOffset);
+                    continue;
+                }
+                if (y0 >= 0) {
+                    ComputeCells(rowBase + y0, rowBase + y0, sourceOffset);
+                }
+                if (y1 < gridYNum) {
+                    ComputeCells(rowBase + y1, rowBase + y1, sourceOffset);
+                }
+            }
+            if (x0 <= 0 && x1 >= gridXNum - 1 && y0 <= 0 && y1 >= gridYNum - 1) {
+                break;
+            }
+            float bound = maxFloatValue;
+            if (x0 > 0) {
+                bound = Min(bound, targetX - (gridLowX + x0 * cellSize));
+            }
+            if (x1 < gridXNum - 1) {
+                bound = Min(bound, gridLowX + (x1 + 1) * cellSize - targetX);
+            }
+            if (y0 > 0) {
+                bound = Min(bound, targetY - (gridLowY + y0 * cellSize));
+            }
+            if (y1 < gridYNum - 1) {
+                bound = Min(bound, gridLowY + (y1 + 1) * cellSize - targetY);
+            }
+            bound -= cellSize * boundEps;
+            if (mergeCount > 0 && bound > 0 && KthDist() <= bound * bound) {
+                break;
+            }
+        }
+    }
+
+    __aicore__ inline int32_t ClampCell(float pos, int32_t cellNum)
+    {
+        if (pos < 0) {
+            return 0;
+        }
+        int32_t cell = static_cast<int32_t>(pos);
+        return cell < cellNum ? cell : cellNum - 1;
+    }
+
+    __aicore__ inline float Min(float a, float b)
+    {
+        return a < b ? a : b;
+    }
+
+    __aicore__ inline void ComputeCells(uint64_t firstCell, uint64_t lastCell, uint64_t sourceOffset)
+    {
+        DataCopyPad(cellStartLocal, cellStartGm[firstCell], {1, static_cast<uint32_t>(sizeof(int32_t)), 0, 0, 0},
+            {false, 0, 0, 0});
+        DataCopyPad(cellStartLocal[8], cellStartGm[lastCell + 1], {1, static_cast<uint32_t>(sizeof(int32_t)), 0, 0, 0},
+            {false, 0, 0, 0});
+        set_flag(PIPE_MTE2, PIPE_S, EVENT_ID2);
+        wait_flag(PIPE_MTE2, PIPE_S, EVENT_ID2);
+        uint32_t start = static_cast<uint32_t>(cellStartLocal.GetValue(0));
+        uint32_t end = static_cast<uint32_t>(cellStartLocal.GetValue(8));
+        set_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
+        wait_flag(PIPE_S, PIPE_MTE2, EVENT_ID2);
+        ComputeRange(start, end, sourceOffset);
+    }
+
+    // 当前第k近的距离平方，候选不足k个时为float最大值
+    __aicore__ inline float KthDist()
+    {
+        set_flag(PIPE_V, PIPE_S, EVENT_ID2);
+        wait_flag(PIPE_V, PIPE_S, EVENT_ID2);
+        LocalTensor<float> bestLocal = ((mergeCount - 1) % 2 == 0) ? sortTmp2Local : sortTmp1Local;
+        float kth = -bestLocal.GetValue((k - 1) * 2);
+        set_flag(PIPE_S, PIPE_V, EVENT_ID2);
+        wait_flag(PIPE_S, PIPE_V, EVENT_ID2);
+        return kth;
+    }
+
+    __aicore__ inline void Compute(uint32_t sourceStart, uint32_t copySize, uint64_t sourceOffset)
+    {
+        wait_flag(PIPE_V, PIPE_MTE2, EVENT_ID1);
+        if constexpr (IS_FLOAT) {
+            CopyInSource(sourceLocal, sourceStart, copySize, sourceOffset);
+            set_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+            wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+        } else {
+            CopyInSource(sourceCastLocal, sourceStart, copySize, sourceOffset);
+            set_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+            wait_flag(PIPE_MTE2, PIPE_V, EVENT_ID1);
+            Cast(sourceLocal, sourceCastLocal, RoundMode::CAST_NONE, compNum * 3);
+        }
+        Sub<float>(sourceLocal, sourceLocal, sourceBackupLocal, compNum * 3);
+        Mul<float>(sourceLocal, sourceLocal, sourceLocal, compNum * 3);
 
         Duplicate(distLocal, maxFloatValue, compNum);
-        Add<T>(distLocal, sourceLocal, sourceLocal[compNum], copySize);
-        Add<T>(distLocal, distLocal, sourceLocal[compNum * 2], copySize);
+        Add<float>(distLocal, sourceLocal, sourceLocal[compNum], copySize);
+        Add<float>(distLocal, distLocal, sourceLocal[compNum * 2], copySize);
         set_flag(PIPE_V, PIPE_MTE2, EVENT_ID1);
 
         if (isFromKnn) {
-            Mins<T>(distLocal, distLocal, static_cast<T>(1e10f), compNum);
+            Mins<float>(distLocal, distLocal, 1e10f, compNum);
         }
 
-        Adds(idxLocal, constIdxLocal, static_cast<int32_t>(loopOffset), compNum);
+        Adds(idxLocal, constIdxLocal, static_cast<int32_t>(sourceStart), compNum);
         Muls(distLocal, distLocal, -1.0f, compNum);
 
-        SortDist(currentLoop);
+        SortDist(mergeCount);
+        mergeCount++;
+    }
+
+    template<typename S>
+    __aicore__ inline void CopyInSource(LocalTensor<S> &dstLocal, uint32_t sourceStart, uint32_t copySize,
+        uint64_t sourceOffset)
+    {
+        uint32_t copyInLength = static_cast<uint32_t>(copySize * sizeof(T));
+        DataCopyPad(dstLocal, sourceGm[sourceOffset + sourceStart],
+                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
+        DataCopyPad(dstLocal[compNum], sourceGm[sourceOffset + sourceStart + nSource],
+                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
+        DataCopyPad(dstLocal[compNum * 2], sourceGm[sourceOffset + sourceStart + nSource * 2],
+                    {1, copyInLength, 0, 0, 0}, {false, 0, 0, 0});
     }
 
     __aicore__ inline void SortDist(uint32_t currentLoop)
@@ -154,13 +330,13 @@ public:
         Sort32(sortSrcLocal, distLocal, interpreIdxInTensor, sort32RepeatTimes);
         AscendC::MrgSortSrcList sortList = AscendC::MrgSortSrcList(sortSrcLocal, sortSrcLocal[sort32Offset], sortSrcLocal[sort32Offset * 2], sortSrcLocal[sort32Offset * 3]);
         if ((currentLoop % 2) == 0) {
-            MrgSort<T>(sortTmp1Local[mergeLength], sortList, {sortCountList, false, 0b1111, sort32MergeRepeatTimes});
+            MrgSort<float>(sortTmp1Local[mergeLength], sortList, {sortCountList, false, 0b1111, sort32MergeRepeatTimes});
             AscendC::MrgSortSrcList mergeList = AscendC::MrgSortSrcList(sortTmp1Local, sortTmp1Local[mergeLength], sortTmp1Local[mergeLength * 2], sortTmp1Local[mergeLength * 3]);
-            MrgSort<T>(sortTmp2Local, mergeList, {mergeCountList, false, 0b1111, 1});
+            MrgSort<float>(sortTmp2Local, mergeList, {mergeCountList, false, 0b1111, 1});
         } else {
-            MrgSort<T>(sortTmp2Local[mergeLength], sortList, {sortCountList, false, 0b1111, sort32MergeRepeatTimes});
+            MrgSort<float>(sortTmp2Local[mergeLength], sortList, {sortCountList, false, 0b1111, sort32MergeRepeatTimes});
             AscendC::MrgSortSrcList mergeList = AscendC::MrgSortSrcList(sortTmp2Local, sortTmp2Local[mergeLength], sortTmp2Local[mergeLength * 2], sortTmp2Local[mergeLength * 3]);
-            MrgSort<T>(sortTmp1Local, mergeList, {mergeCountList, false, 0b1111, 1});
+            MrgSort<float>(sortTmp1Local, mergeList, {mergeCountList, false, 0b1111, 1});
         }
     }
 
@@ -169,31 +345,50 @@ public:
         set_flag(PIPE_MTE3, PIPE_V, EVENT_ID0);
         wait_flag(PIPE_MTE3, PIPE_V, EVENT_ID0);
         AscendC::LocalTensor<uint32_t> interpreIdxOutTensor = bestIdxLocal.ReinterpretCast<uint32_t>();
-        if (((nSource + compNum - 1) / compNum) % 2 == 1) {
+        if (mergeCount % 2 == 1) {
             Extract(bestDistLocal, interpreIdxOutTensor, sortTmp2Local, sort32RepeatTimes);
         } else {
             Extract(bestDistLocal, interpreIdxOutTensor, sortTmp1Local, sort32RepeatTimes);
         }
         Muls(bestDistLocal, bestDistLocal, -1.0f, k);
+        if (withSqrt) {
+            // three_nn直接输出距离，避免额外的sqrt
+            Sqrt(bestDistLocal, bestDistLocal, k);
+        }
 
-        set_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
-        wait_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
-        DataCopyPad(distGm[offset], bestDistLocal,
-            {1, static_cast<uint32_t>(k * sizeof(T)), 0, 0, 0});
+        if constexpr (IS_FLOAT) {
+            set_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
+            wait_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
+            DataCopyPad(distGm[offset], bestDistLocal,
+                {1, static_cast<uint32_t>(k * sizeof(T)), 0, 0, 0});
+        } else {
+            Cast(bestDistCastLocal, bestDistLocal, RoundMode::CAST_NONE, k);
+            set_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
+            wait_flag(PIPE_V, PIPE_MTE3, EVENT_ID0);
+            DataCopyPad(distGm[offset], bestDistCastLocal,
+                {1, static_cast<uint32_t>(k * sizeof(T)), 0, 0, 0});
+        }
         DataCopyPad(idxGm[offset], bestIdxLocal,
             {1, static_cast<uint32_t>(k * sizeof(int32_t)), 0, 0, 0});
     }
 
 public:
+    static constexpr bool IS_FLOAT = sizeof(T) == sizeof(float);
+    static constexpr uint32_t GRID_BOUNDS_NUM = 3;
     TPipe *pipe;
     GlobalTensor<T> sourceGm, targetGm, distGm;
-    GlobalTensor<int32_t> idxGm;
+    GlobalTensor<int32_t> idxGm, cellStartGm;
+    GlobalTensor<float> gridBoundsGm;
     TBuf<TPosition::VECCALC> sourceUb, sourceBackupUb, targetUb, distUb, idxUb, bestDistUb, bestIdxUb, constIdxUb, sortTmp1Ub, sortTmp2Ub, sortSrcUb;
-    LocalTensor<T> sourceLocal, sourceBackupLocal, targetLocal, distLocal, bestDistLocal, sortTmp1Local, sortTmp2Local, sortSrcLocal;
-    LocalTensor<int32_t> bestIdxLocal, idxLocal, constIdxLocal;
+    TBuf<TPosition::VECCALC> cellStartUb, sourceCastUb, targetCastUb, bestDistCastUb;
+    LocalTensor<float> sourceLocal, sourceBackupLocal, targetLocal, distLocal, bestDistLocal, sortTmp1Local, sortTmp2Local, sortSrcLocal;
+    LocalTensor<T> sourceCastLocal, targetCastLocal, bestDistCastLocal;
+    LocalTensor<int32_t> bestIdxLocal, idxLocal, constIdxLocal, cellStartLocal;
     uint32_t coreId;
     uint32_t startTask, endTask;
     uint32_t formerTaskNum;
+    uint32_t mergeCount;
+    float targetX, targetY, targetZ;
 
     uint32_t compNum = 384;
     uint32_t mergeLength = 256;
@@ -204,6 +399,8 @@ public:
 
     float minFloatValue = -3.40282347E+38;
     float maxFloatValue = 3.40282347E+38;
+    // 网格边界的相对余量，避免host与kernel对边界点的网格划分存在舍入差异
+    float boundEps = 1e-4f;
 public:
     // tiling
     uint32_t batch;
@@ -212,7 +409,15 @@ public:
     uint32_t coreNum;
     bool isFromKnn;
     int32_t k;
+    bool withSqrt;
+    bool useGrid;
+    int32_t gridXNum;
+    int32_t gridYNum;
+    float gridLowX;
+    float gridLowY;
+    float cellSize;
+    bool hasGridBounds;
 };
 } // namespace AscendC
 
-#endif  // _KNN_H_
\ No newline at end of file
+#endif  // _KNN_H_
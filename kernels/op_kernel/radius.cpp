@@ -13,13 +13,12 @@ namespace {
     constexpr uint32_t BLOCK_BYTES = 32;
     constexpr uint32_t ALIGN_NUM_8 = 8;
     constexpr uint32_t ALIGN_NUM_64 = 64; // CompareScalar function requires 256B alignment.
-    constexpr float MAX_FLOAT = 3.40282347E+38;
 }
 
 class KernelRadius {
 public:
     __aicore__ inline KernelRadius() {}
-    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, GM_ADDR ptrX, GM_ADDR ptrY, GM_ADDR outTemp, GM_ADDR outFinal, GM_ADDR numNeighbors, GM_ADDR usrWorkspace, RadiusTilingData * tiling_data)
+    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, GM_ADDR ptrX, GM_ADDR ptrY, GM_ADDR out, GM_ADDR numNeighbors, GM_ADDR usrWorkspace, RadiusTilingData * tiling_data)
     {
         batchSize = tiling_data->batchSize;
         numPointsX = tiling_data->numPointsX;
@@ -36,7 +35,7 @@ public:
         r = tiling_data->r;
         blockIdx = GetBlockIdx();
         numOutputPoints = 0;
-        maxNumPointsPerIter = numLocalPoints;
+        outDim = static_cast<uint64_t>(numPointsY) * maxNumNeighbors;
 
         if (blockIdx < headCoreNum) {
             batchThisCore = batchPerCore;
@@ -50,8 +49,7 @@ public:
         yGm.SetGlobalBuffer((__gm__ float *)y, COORDINATE_DIM * numPointsY); // [2, num_points_y]
         ptrXGm.SetGlobalBuffer((__gm__ int32_t *)ptrX, batchSize + 1); // [batch_size + 1]
         ptrYGm.SetGlobalBuffer((__gm__ int32_t *)ptrY, batchSize + 1); // [batch_size + 1]
-        outTempGm.SetGlobalBuffer((__gm__ int32_t *)outTemp, COORDINATE_DIM * numPointsY * maxNumNeighbors); // [2, num_points_y * max_num_neighbors]
-        outFinalGm.SetGlobalBuffer((__gm__ int32_t *)outFinal, COORDINATE_DIM * numPointsY * maxNumNeighbors); // [2, num_points_y * max_num_neighbors]
+        outGm.SetGlobalBuffer((__gm__ int32_t *)out, COORDINATE_DIM * outDim); // [2, num_points_y * max_num_neighbors]
         numNeighborsGm.SetGlobalBuffer((__gm__ int32_t *)numNeighbors, ALIGN_NUM_8); // [8]
         numNeighborsCoreGm.SetGlobalBuffer((__gm__ int32_t *)usrWorkspace, (usedCoreNum + 1) * ALIGN_NUM_8); // [usedCoreNum + 1, 8]
 
@@ -78,15 +76,25 @@ public:
     {
         // Input batch address pointer
         CopyInPtr();
+        // The first pass only counts the neighbors of this core, so the output offset of each core is known before
+        // any index is written and the results go to their final position without an intermediate buffer.
         for (int32_t i = 0; i < batchThisCore; i++) {
-            // According to the batch address pointer, points within a single batch are moved in
-            CopyInPoints(i);
-            Compute(i);
+            ComputeBatch(i, false);
         }
-        CopyOut();
+        CopyOutCount();
         SyncAll();
-        // Rearrange non-contiguous data to ensure continuous distribution in memory
-        DataMoveFinal();
+        LoadOutputOffset();
+        for (int32_t i = 0; i < batchThisCore; i++) {
+            ComputeBatch(i, true);
+        }
+        if (blockIdx == usedCoreNum - 1) {
+            PipeBarrier<PIPE_ALL>();
+            Duplicate(numNeighborsTensor, static_cast<int32_t>(numOutputPoints), ALIGN_NUM_8);
+            PipeBarrier<PIPE_ALL>();
+            DataCopyExtParams copyParams {1, static_cast<uint32_t>(ALIGN_NUM_8 * sizeof(int32_t)), 0, 0, 0};
+            DataCopyPad(numNeighborsGm, numNeighborsTensor, copyParams);
+            PipeBarrier<PIPE_ALL>();
+        }
     }
 
 private:
@@ -94,137 +102,120 @@ private:
     {
         ptrXLocal = ptrXBuf.Get<int32_t>();
         ptrYLocal = ptrYBuf.Get<int32_t>();
-        DataCopyParams copyParams {1, static_cast<uint16_t>(numLocalPtr * sizeof(int32_t)), 0, 0};
-        DataCopyPadParams padParams{true, 0, 0, 0};
+        pointsXLocal = xBuf.Get<float>();
+        pointsYLocal = yBuf.Get<float>();
+        distLocal = distBuf.Get<float>();
+        tempLocal = tempBuf.Get<float>();
+        maskUint8 = maskBuf.Get<uint8_t>();
+        indexXTensor = indexXBuf.Get<int32_t>();
+        indexYTensor = indexYBuf.Get<int32_t>();
+        numNeighborsTensor = numNeighborsBuf.Get<int32_t>();
+        DataCopyExtParams copyParams {1, static_cast<uint32_t>(numLocalPtr * sizeof(int32_t)), 0, 0, 0};
+        DataCopyPadExtParams<int32_t> padParams{true, 0, 0, 0};
         DataCopyPad(ptrXLocal, ptrXGm[ptrAddrOffset], copyParams, padParams);
         DataCopyPad(ptrYLocal, ptrYGm[ptrAddrOffset], copyParams, padParams);
         PipeBarrier<PIPE_ALL>();
     }
 
-    __aicore__ inline void CopyInPoints(uint32_t batchIdx)
+    // Points of a batch are processed in tiles of numLocalPoints, so the number of points per batch is not limited
+    // by the UB size. A batch that fits in one tile keeps its x points resident for all of its y points.
+    __aicore__ inline void ComputeBatch(uint32_t batchIdx, bool writeOut)
     {
-        ptrXLeft = ptrXLocal.GetValue(batchIdx);
-        ptrYLeft = ptrYLocal.GetValue(batchIdx);
-        ptrXRight = ptrXLocal.GetValue(batchIdx + 1);
-        ptrYRight = ptrYLocal.GetValue(batchIdx + 1);
-        if (batchIdx == 0) {
-            outputGmOffsetY = ptrYLeft * maxNumNeighbors;
-            outputGmOffsetX = outputGmOffsetY + numPointsY * maxNumNeighbors;
+        int32_t ptrXLeft = ptrXLocal.GetValue(batchIdx);
+        int32_t ptrYLeft = ptrYLocal.GetValue(batchIdx);
+        int32_t numBatchPointsX = ptrXLocal.GetValue(batchIdx + 1) - ptrXLeft;
+        int32_t numBatchPointsY = ptrYLocal.GetValue(batchIdx + 1) - ptrYLeft;
+        cachedXStart = -1;
+        for (int32_t yStart = 0; yStart < numBatchPointsY; yStart += numLocalPoints) {
+            int32_t numTileY = (numBatchPointsY - yStart) < numLocalPoints ? (numBatchPointsY - yStart) : numLocalPoints;
+            CopyInPoints(pointsYLocal, yGm, numPointsY, ptrYLeft + yStart, numTileY);
+            for (int32_t pointIdx = 0; pointIdx < numTileY; pointIdx++) {
+                y1 = -1 * pointsYLocal.GetValue(pointIdx);
+                y2 = -1 * pointsYLocal.GetValue(numLocalPoints + pointIdx);
+                int32_t pointIdxAbs = ptrYLeft + yStart + pointIdx;
+                uint32_t remain = maxNumNeighbors;
+                for (int32_t xStart = 0; xStart < numBatchPointsX && remain > 0; xStart += numLocalPoints) {
+                    int32_t numTileX = (numBatchPointsX - xStart) < numLocalPoints ? (numBatchPointsX - xStart) : numLocalPoints;
+                    if (cachedXStart != ptrXLeft + xStart) {
+                        CopyInPoints(pointsXLocal, xGm, numPointsX, ptrXLeft + xStart, numTileX);
+                        cachedXStart = ptrXLeft + xStart;
+                    }
+                    uint64_t selectCnt = SelectNeighbors(ptrXLeft + xStart, numTileX);
+                    if (selectCnt > remain) {
+                        selectCnt = remain;
+                    }
+                    if (writeOut && selectCnt > 0) {
+                        CopyOutIndex(pointIdxAbs, selectCnt);
+                    }
+                    numOutputPoints = numOutputPoints + selectCnt;
+                    remain = remain - selectCnt;
+                }
+            }
         }
-        numBatchPointsX = ptrXRight - ptrXLeft;
-        numBatchPointsY = ptrYRight - ptrYLeft;
-        numBatchPointsAlignedX = (numBatchPointsX + ALIGN_NUM_64) / ALIGN_NUM_64 * ALIGN_NUM_64;
-        numBatchPointsAlignedY = (numBatchPointsY + ALIGN_NUM_64) / ALIGN_NUM_64 * ALIGN_NUM_64;
-        pointsXLocal = xBuf.Get<float>();
-        pointsYLocal = yBuf.Get<float>();
+    }
+
+    __aicore__ inline void CopyInPoints(LocalTensor<float>& pointsLocal, GlobalTensor<float>& pointsGm, int32_t numPoints,
+        int32_t start, int32_t num)
+    {
         PipeBarrier<PIPE_ALL>();
-        DataCopyParams copyParamsX {1, static_cast<uint16_t>(numBatchPointsX * sizeof(float)), 0, 0};
-        DataCopyParams copyParamsY {1, static_cast<uint16_t>(numBatchPointsY * sizeof(float)), 0, 0};
-        DataCopyPadParams padParams{true, 0, 0, 0};
-        DataCopyPad(pointsXLocal, xGm[ptrXLeft], copyParamsX, padParams);
-        DataCopyPad(pointsYLocal, yGm[ptrYLeft], copyParamsY, padParams);
-        DataCopyPad(pointsXLocal[numLocalPoints], xGm[numPointsX + ptrXLeft], copyParamsX, padParams);
-        DataCopyPad(pointsYLocal[numLocalPoints], yGm[numPointsY + ptrYLeft], copyParamsY, padParams);
+        DataCopyExtParams copyParams {1, static_cast<uint32_t>(num * sizeof(float)), 0, 0, 0};
+        DataCopyPadExtParams<float> padParams{true, 0, 0, 0};
+        DataCopyPad(pointsLocal, pointsGm[start], copyParams, padParams);
+        DataCopyPad(pointsLocal[numLocalPoints], pointsGm[numPoints + start], copyParams, padParams);
         PipeBarrier<PIPE_ALL>();
     }
 
-    __aicore__ inline void Compute(uint32_t batchIdx)
+    __aicore__ inline uint64_t SelectNeighbors(int32_t xStartAbs, int32_t numTileX)
     {
-        distLocal = distBuf.Get<float>();
-        tempLocal = tempBuf.Get<float>();
-        maskUint8 = maskBuf.Get<uint8_t>();
-        indexXTensor = indexXBuf.Get<int32_t>();
-        indexYTensor = indexYBuf.Get<int32_t>();
-
-        int32_t pointIdxAbs = 0;
+        uint32_t numAligned = (numTileX + ALIGN_NUM_64 - 1) / ALIGN_NUM_64 * ALIGN_NUM_64;
+        Adds(distLocal, pointsXLocal, y1, numAligned);
+        Adds(tempLocal, pointsXLocal[numLocalPoints], y2, numAligned);
+        PipeBarrier<PIPE_V>();
+        Mul(distLocal, distLocal, distLocal, numAligned);
+        Mul(tempLocal, tempLocal, tempLocal, numAligned);
+        PipeBarrier<PIPE_V>();
+        Add(distLocal, distLocal, tempLocal, numAligned);
+        PipeBarrier<PIPE_V>();
+        CompareScalar(maskUint8, distLocal, r, CMPMODE::LT, numAligned);
+        maskUint32 = maskUint8.ReinterpretCast<uint32_t>();
+        CreateVecIndex(indexXTensor, xStartAbs, numAligned);
+        PipeBarrier<PIPE_V>();
         uint64_t selectCnt = 0;
-        for (int32_t pointIdx = 0; pointIdx < numBatchPointsY; pointIdx++) {
-            y1 = -1 * pointsYLocal.GetValue(pointIdx);
-            y2 = -1 * pointsYLocal.GetValue(numLocalPoints + pointIdx);
-            Adds(distLocal, pointsXLocal, y1, numBatchPointsAlignedX);
-            Adds(tempLocal, pointsXLocal[numLocalPoints], y2, numBatchPointsAlignedX);
-            PipeBarrier<PIPE_V>();
-            Mul(distLocal, distLocal, distLocal, numBatchPointsAlignedX);
-            Mul(tempLocal, tempLocal, tempLocal, numBatchPointsAlignedX);
-            PipeBarrier<PIPE_V>();
-            Add(distLocal, distLocal, tempLocal, numBatchPointsAlignedX);
-            PipeBarrier<PIPE_V>();
-            CompareScalar(maskUint8, distLocal, r, CMPMODE::LT, numBatchPointsAlignedX);
-            maskUint32 = maskUint8.ReinterpretCast<uint32_t>();
-            pointIdxAbs = pointIdx + ptrYLeft;
-            Duplicate(indexYTensor, pointIdxAbs, numBatchPointsAlignedX);
-            CreateVecIndex(indexXTensor, ptrXLeft, numBatchPointsAlignedX);
-            GatherMask(indexXTensor, indexXTensor, maskUint32, true, numBatchPointsX, {1, 1, 0, 0}, selectCnt);
+        GatherMask(indexXTensor, indexXTensor, maskUint32, true, numTileX, {1, 1, 0, 0}, selectCnt);
+        PipeBarrier<PIPE_ALL>();
+        return selectCnt;
+    }
 
-            PipeBarrier<PIPE_ALL>();
-            if (selectCnt > maxNumNeighbors) {
-                selectCnt = maxNumNeighbors;
-            }
-            PipeBarrier<PIPE_ALL>();
-            DataCopyExtParams outCopyParams {1, static_cast<uint32_t>(selectCnt * sizeof(float)), 0, 0, 0};
-            DataCopyPad(outTempGm[outputGmOffsetX + numOutputPoints], indexXTensor, outCopyParams);
-            DataCopyPad(outTempGm[outputGmOffsetY + numOutputPoints], indexYTensor, outCopyParams);
-            numOutputPoints = numOutputPoints + selectCnt;
-            PipeBarrier<PIPE_ALL>();
-        }
+    __aicore__ inline void CopyOutIndex(int32_t pointIdxAbs, uint64_t selectCnt)
+    {
+        Duplicate(indexYTensor, pointIdxAbs, static_cast<int32_t>(selectCnt));
+        PipeBarrier<PIPE_ALL>();
+        DataCopyExtParams outCopyParams {1, static_cast<uint32_t>(selectCnt * sizeof(int32_t)), 0, 0, 0};
+        DataCopyPad(outGm[outDim + numOutputPoints], indexXTensor, outCopyParams);
+        DataCopyPad(outGm[numOutputPoints], indexYTensor, outCopyParams);
+        PipeBarrier<PIPE_ALL>();
     }
-    __aicore__ inline void CopyOut()
+
+    __aicore__ inline void CopyOutCount()
     {
         numNeighborsCoreTensor = numNeighborsCoreBuf.Get<int32_t>();
-        Duplicate(numNeighborsCoreTensor, numOutputPoints, usedCoreNum * ALIGN_NUM_8);
+        Duplicate(numNeighborsCoreTensor, static_cast<int32_t>(numOutputPoints), usedCoreNum * ALIGN_NUM_8);
         PipeBarrier<PIPE_ALL>();
         SetAtomicAdd<int32_t>();
-        DataCopyParams outCopyParams {1, static_cast<uint16_t>((usedCoreNum - blockIdx) * ALIGN_NUM_8 * sizeof(int32_t)), 0, 0};
+        DataCopyExtParams outCopyParams {1, static_cast<uint32_t>((usedCoreNum - blockIdx) * ALIGN_NUM_8 * sizeof(int32_t)), 0, 0, 0};
         DataCopyPad(numNeighborsCoreGm, numNeighborsCoreTensor, outCopyParams);
         SetAtomicNone();
         PipeBarrier<PIPE_ALL>();
     }
-    __aicore__ inline void DataMoveFinal()
+
+    // The slot (usedCoreNum - blockIdx) accumulates the counts of all previous cores.
+    __aicore__ inline void LoadOutputOffset()
     {
-        numNeighborsTensor = numNeighborsBuf.Get<int32_t>();
-        DataCopyParams copyParamsNumNeighbors {1, static_cast<uint16_t>(ALIGN_NUM_8 * sizeof(int32_t)), 0, 0};
-        DataCopyPadParams padParams{true, 0, 0, 0};
-        DataCopyPad(numNeighborsTensor, numNeighborsCoreGm[(usedCoreNum - blockIdx) * ALIGN_NUM_8], copyParamsNumNeighbors, padParams);
+        DataCopyExtParams copyParams {1, static_cast<uint32_t>(ALIGN_NUM_8 * sizeof(int32_t)), 0, 0, 0};
+        DataCopyPadExtParams<int32_t> padParams{true, 0, 0, 0};
+        DataCopyPad(numNeighborsTensor, numNeighborsCoreGm[(usedCoreNum - blockIdx) * ALIGN_NUM_8], copyParams, padParams);
         PipeBarrier<PIPE_ALL>();
-        uint32_t addrsPtrY = numNeighborsTensor.GetValue(0);
-        uint32_t addrsPtrX = addrsPtrY + numPointsY * maxNumNeighbors;
-        uint32_t numIters = numOutputPoints / maxNumPointsPerIter + 1;
-        uint32_t numPointsTail = numOutputPoints % maxNumPointsPerIter;
-        numOutputPoints = numOutputPoints + addrsPtrY;
-        DataCopyParams copyParams {1, static_cast<uint16_t>(maxNumPointsPerIter * sizeof(int32_t)), 0, 0};
-        DataCopyParams outCopyParams {1, static_cast<uint16_t>(maxNumPointsPerIter * sizeof(int32_t)), 0, 0};
-        DataCopyParams copyParamsTail {1, static_cast<uint16_t>(numPointsTail * sizeof(int32_t)), 0, 0};
-        DataCopyParams outCopyParamsTail {1, static_cast<uint16_t>(numPointsTail * sizeof(int32_t)), 0, 0};
-
-        for (int32_t i = 0; i < numIters; i++) {
-            PipeBarrier<PIPE_ALL>();
-            if (i < numIters - 1) {
-                DataCopyPad(indexXTensor, outTempGm[outputGmOffsetX], copyParams, padParams);
-                DataCopyPad(indexYTensor, outTempGm[outputGmOffsetY], copyParams, padParams);
-            } else {
-                DataCopyPad(indexXTensor, outTempGm[outputGmOffsetX], copyParamsTail, padParams);
-                DataCopyPad(indexYTensor, outTempGm[outputGmOffsetY], copyParamsTail, padParams);
-            }
-            PipeBarrier<PIPE_ALL>();
-            if (i < numIters - 1) {
-                DataCopyPad(outFinalGm[addrsPtrX], indexXTensor, outCopyParams);
-                DataCopyPad(outFinalGm[addrsPtrY], indexYTensor, outCopyParams);
-            } else {
-                DataCopyPad(outFinalGm[addrsPtrX], indexXTensor, outCopyParamsTail);
-                DataCopyPad(outFinalGm[addrsPtrY], indexYTensor, outCopyParamsTail);
-            }
-            outputGmOffsetX = outputGmOffsetX + maxNumPointsPerIter;
-            outputGmOffsetY = outputGmOffsetY + maxNumPointsPerIter;
-            addrsPtrX = addrsPtrX + maxNumPointsPerIter;
-            addrsPtrY = addrsPtrY + maxNumPointsPerIter;
-            PipeBarrier<PIPE_ALL>();
-        }
-        if (blockIdx == usedCoreNum - 1) {
-            PipeBarrier<PIPE_ALL>();
-            Duplicate(numNeighborsTensor, numOutputPoints, ALIGN_NUM_8);
-            DataCopyPad(numNeighborsGm, numNeighborsTensor, copyParamsNumNeighbors);
-            PipeBarrier<PIPE_ALL>();
-        }
+        numOutputPoints = numNeighborsTensor.GetValue(0);
     }
 
 private:
@@ -242,24 +233,21 @@ private:
     GlobalTensor<float> yGm;
     GlobalTensor<int32_t> ptrXGm;
     GlobalTensor<int32_t> ptrYGm;
-    GlobalTensor<int32_t> outTempGm;
-    GlobalTensor<int32_t> outFinalGm;
+    GlobalTensor<int32_t> outGm;
     GlobalTensor<int32_t> numNeighborsGm;
     GlobalTensor<int32_t> numNeighborsCoreGm;
     uint32_t blockIdx, headCoreNum, batchPerCore, batchPerCoreTail, batchThisCore;
     uint32_t ptrAddrOffset, bufferSizePtr, bufferSizePoints;
-    uint32_t batchSize, maxNumNeighbors, usedCoreNum, maxNumPointsPerIter;
-    uint32_t numBatchPointsX, numBatchPointsY, numBatchPointsAlignedX, numBatchPointsAlignedY;
-    uint32_t outputGmOffsetX,  outputGmOffsetY;
-    int32_t ptrXLeft, ptrXRight, ptrYLeft, ptrYRight;
-    int32_t numPointsX, numPointsY, numLocalPoints, numLocalPtr, numOutputPoints;
+    uint32_t batchSize, maxNumNeighbors, usedCoreNum;
+    uint64_t outDim, numOutputPoints;
+    int32_t numPointsX, numPointsY, numLocalPoints, numLocalPtr, cachedXStart;
     float r, y1, y2;
 };
 
-extern "C" __global__ __aicore__ void radius(GM_ADDR x, GM_ADDR y, GM_ADDR ptrX, GM_ADDR ptrY, GM_ADDR outTemp, GM_ADDR outFinal, GM_ADDR numTotalNeighbors, GM_ADDR workspace, GM_ADDR tiling) {
+extern "C" __global__ __aicore__ void radius(GM_ADDR x, GM_ADDR y, GM_ADDR ptrX, GM_ADDR ptrY, GM_ADDR out, GM_ADDR numTotalNeighbors, GM_ADDR workspace, GM_ADDR tiling) {
     GET_TILING_DATA(tiling_data, tiling);
     GM_ADDR usrWorkspace = GetUserWorkspace(workspace);
     KernelRadius op;
-    op.Init(x, y, ptrX, ptrY, outTemp, outFinal, numTotalNeighbors, usrWorkspace, &tiling_data);
+    op.Init(x, y, ptrX, ptrY, out, numTotalNeighbors, usrWorkspace, &tiling_data);
     op.Process();
 }
@@ -0,0 +1,426 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024. All rights reserved.
+ */
+#include "kernel_operator.h"
+using namespace AscendC;
+
+namespace {
+constexpr uint32_t POINT_DIM = 3;
+constexpr uint32_t GROUP_DIM = 3;
+constexpr uint32_t ALIGN_NUM_64 = 64; // CompareScalar function requires 256B alignment.
+constexpr uint32_t ALIGN_NUM_8 = 8;
+constexpr uint32_t POOLING_AVG = 0;
+constexpr uint32_t NEIGHBOR_BALL = 1;
+constexpr int32_t NO_SAMPLE_LIMIT = 0x7fffffff;
+constexpr float HASH_MARGIN = 1.001f; // 查询范围略大于max_neighbour_distance，避免格子边界上的舍入误差漏点
+} // namespace
+
+// 空间哈希近邻查询：源点已在host侧按(batch, cell)稳定排序，每个中心点只扫描与其立方邻域相交的格子，
+// 同一(x, y)列上z方向相邻的格子在排序后连续，合并为一段搬运
+class KernelVecPool {
+public:
+    __aicore__ inline KernelVecPool() {}
+    __aicore__ inline void Init(GM_ADDR sortedXyz, GM_ADDR sortedIdx, GM_ADDR cellStart, GM_ADDR supportFeatures,
+        GM_ADDR newXyz, GM_ADDR centerBatch, GM_ADDR groupOffset, GM_ADDR newFeatures, GM_ADDR newLocalXyz,
+        GM_ADDR pointCntOfGrid, GM_ADDR groupedIdxs, GM_ADDR sampleCnt, const VecPoolTilingData* tilingData,
+        TPipe* tmpPipe)
+    {
+        pipe = tmpPipe;
+        nSupport = tilingData->nSupport;
+        nCenter = tilingData->nCenter;
+        cIn = tilingData->cIn;
+        cInAligned = tilingData->cInAligned;
+        cEach = tilingData->cEach;
+        cEachAligned = tilingData->cEachAligned;
+        gridY = tilingData->gridY;
+        gridZ = tilingData->gridZ;
+        totalGrids = tilingData->totalGrids;
+        maxDist = tilingData->maxDist;
+        gridSizeX = tilingData->gridSizeX;
+        gridSizeY = tilingData->gridSizeY;
+        gridSizeZ = tilingData->gridSizeZ;
+        neighborType = tilingData->neighborType;
+        poolingType = tilingData->poolingType;
+        useXyz = tilingData->useXyz;
+        countOnly = tilingData->countOnly;
+        cellSize = tilingData->cellSize;
+        lowerX = tilingData->lowerX;
+        lowerY = tilingData->lowerY;
+        lowerZ = tilingData->lowerZ;
+        cellsX = tilingData->cellsX;
+        cellsY = tilingData->cellsY;
+        cellsZ = tilingData->cellsZ;
+        compNum = tilingData->compNum;
+        rowNum = tilingData->rowNum;
+        groupNum = tilingData->groupNum;
+        uint32_t coreTaskNum = tilingData->coreTaskNum;
+
+        startTask = GetBlockIdx() * coreTaskNum;
+        endTask = startTask + coreTaskNum;
+        if (endTask > nCenter) {
+            endTask = nCenter;
+        }
+        sampleLimit = tilingData->nsample > 0 ? tilingData->nsample : NO_SAMPLE_LIMIT;
+        if (poolingType != POOLING_AVG && sampleLimit > static_cast<int32_t>(totalGrids)) {
+            sampleLimit = static_cast<int32_t>(totalGrids);
+        }
+        uint32_t gridXyzAligned = (totalGrids * POINT_DIM + ALIGN_NUM_8 - 1) / ALIGN_NUM_8 * ALIGN_NUM_8;
+        uint32_t gridAligned = (totalGrids + ALIGN_NUM_8 - 1) / ALIGN_NUM_8 * ALIGN_NUM_8;
+        uint64_t numCells = static_cast<uint64_t>(cellsX) * cellsY * cellsZ;
+
+        sortedXyzGm.SetGlobalBuffer((__gm__ float*)sortedXyz, static_cast<uint64_t>(POINT_DIM) * nSupport);
+        sortedIdxGm.SetGlobalBuffer((__gm__ int32_t*)sortedIdx, nSupport);
+        cellStartGm.SetGlobalBuffer((__gm__ int32_t*)cellStart);
+        newXyzGm.SetGlobalBuffer((__gm__ float*)newXyz, static_cast<uint64_t>(nCenter) * POINT_DIM);
+        centerBatchGm.SetGlobalBuffer((__gm__ int32_t*)centerBatch, nCenter);
+        sampleCntGm.SetGlobalBuffer((__gm__ int32_t*)sampleCnt, nCenter);
+        if (!countOnly) {
+            featuresGm.SetGlobalBuffer((__gm__ float*)supportFeatures, static_cast<uint64_t>(nSupport) * cIn);
+            groupOffsetGm.SetGlobalBuffer((__gm__ int32_t*)groupOffset, nCenter);
+            newFeaturesGm.SetGlobalBuffer(
+                (__gm__ float*)newFeatures, static_cast<uint64_t>(nCenter) * totalGrids * cEach);
+            newLocalXyzGm.SetGlobalBuffer(
+                (__gm__ float*)newLocalXyz, static_cast<uint64_t>(nCenter) * totalGrids * POINT_DIM);
+            pointCntGm.SetGlobalBuffer((__gm__ int32_t*)pointCntOfGrid, static_cast<uint64_t>(nCenter) * totalGrids);
+            groupedIdxsGm.SetGlobalBuffer((__gm__ int32_t*)groupedIdxs);
+        }
+
+        pipe->InitBuffer(xyzBuf, compNum * POINT_DIM * sizeof(float));
+        pipe->InitBuffer(localBuf, compNum * POINT_DIM * sizeof(float));
+        pipe->InitBuffer(idxBuf, compNum * sizeof(int32_t));
+        pipe->InitBuffer(distBuf, compNum * sizeof(float));
+        pipe->InitBuffer(tempBuf, compNum * sizeof(float));
+        pipe->InitBuffer(maskBuf, compNum / ALIGN_NUM_8);
+        pipe->InitBuffer(cntBuf, gridAligned * sizeof(int32_t));
+        pipe->InitBuffer(sampleBuf, ALIGN_NUM_8 * sizeof(int32_t));
+        pipe->InitBuffer(accBuf, totalGrids * cInAligned * sizeof(float));
+        pipe->InitBuffer(localSumBuf, gridXyzAligned * sizeof(float));
+        pipe->InitBuffer(rowBuf, rowNum * cInAligned * sizeof(float));
+        pipe->InitBuffer(rowGridBuf, rowNum * sizeof(int32_t));
+        pipe->InitBuffer(groupBuf, groupNum * GROUP_DIM * sizeof(int32_t));
+        if (cEach != cIn) {
+            pipe->InitBuffer(foldBuf, totalGrids * cEachAligned * sizeof(float));
+        }
+        gridXyzNum = gridXyzAligned;
+        gridNum = gridAligned;
+        cellsPerBatch = numCells;
+    }
+
+    __aicore__ inline void Process()
+    {
+        xyzLocal = xyzBuf.Get<float>();
+        localLocal = localBuf.Get<float>();
+        idxLocal = idxBuf.Get<int32_t>();
+        distLocal = distBuf.Get<float>();
+        tempLocal = tempBuf.Get<float>();
+        maskLocal = maskBuf.Get<uint8_t>();
+        cntLocal = cntBuf.Get<int32_t>();
+        sampleLocal = sampleBuf.Get<int32_t>();
+        accLocal = accBuf.Get<float>();
+        localSumLocal = localSumBuf.Get<float>();
+        rowLocal = rowBuf.Get<float>();
+        rowGridLocal = rowGridBuf.Get<int32_t>();
+        groupLocal = groupBuf.Get<int32_t>();
+        if (cEach != cIn) {
+            foldLocal = foldBuf.Get<float>();
+        }
+        for (uint32_t task = startTask; task < endTask; task++) {
+            ProcessCenter(task);
+        }
+    }
+
+private:
+    __aicore__ inline uint32_t CellCoord(float v, float lower, uint32_t cells)
+    {
+        float t = (v - lower) / cellSize;
+        if (!(t > 0.0f)) {
+            return 0;
+        }
+        if (t >= static_cast<float>(cells)) {
+            return cells - 1;
+        }
+        return static_cast<uint32_t>(t);
+    }
+
+    __aicore__ inline void ProcessCenter(uint32_t task)
+    {
+        centerX = newXyzGm.GetValue(task * POINT_DIM);
+        centerY = newXyzGm.GetValue(task * POINT_DIM + 1);
+        centerZ = newXyzGm.GetValue(task * POINT_DIM + 2);
+        uint64_t cellBase = static_cast<uint64_t>(centerBatchGm.GetValue(task)) * cellsPerBatch;
+        taskIdx = task;
+        sampleNum = 0;
+        rowFill = 0;
+        groupFill = 0;
+        groupWritten = 0;
+        if (!countOnly) {
+            groupBase = static_cast<uint64_t>(groupOffsetGm.GetValue(task));
+        }
+        ResetGrids();
+
+        float margin = maxDist * HASH_MARGIN;
+        uint32_t xLo = CellCoord(centerX - margin, lowerX, cellsX);
+        uint32_t xHi = CellCoord(centerX + margin, lowerX, cellsX);
+        uint32_t yLo = CellCoord(centerY - margin, lowerY, cellsY);
+        uint32_t yHi = CellCoord(centerY + margin, lowerY, cellsY);
+        uint32_t zLo = CellCoord(centerZ - margin, lowerZ, cellsZ);
+        uint32_t zHi = CellCoord(centerZ + margin, lowerZ, cellsZ);
+        bool done = false;
+        for (uint32_t cx = xLo; cx <= xHi && !done; cx++) {
+            for (uint32_t cy = yLo; cy <= yHi && !done; cy++) {
+                uint64_t column = cellBase + (static_cast<uint64_t>(cx) * cellsY + cy) * cellsZ;
+                uint32_t segStart = static_cast<uint32_t>(cellStartGm.GetValue(column + zLo));
+                uint32_t segEnd = static_cast<uint32_t>(cellStartGm.GetValue(column + zHi + 1));
+                for (uint32_t start = segStart; start < segEnd && !done; start += compNum) {
+                    uint32_t num = (segEnd - start) < compNum ? (segEnd - start) : compNum;
+                    CopyInSupport(start, num);
+                    uint32_t hitNum = SelectHits(num);
+                    done = AccumulateHits(hitNum);
+                }
+            }
+        }
+        CopyOut();
+    }
+
+    __aicore__ inline void ResetGrids()
+    {
+        PipeBarrier<PIPE_ALL>();
+        Duplicate(cntLocal, 0, gridNum);
+        if (!countOnly) {
+            Duplicate(accLocal, 0.0f, totalGrids * cInAligned);
+            Duplicate(localSumLocal, 0.0f, gridXyzNum);
+        }
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void CopyInSupport(uint32_t start, uint32_t num)
+    {
+        DataCopyExtParams xyzParams {1, static_cast<uint32_t>(num * sizeof(float)), 0, 0, 0};
+        DataCopyExtParams idxParams {1, static_cast<uint32_t>(num * sizeof(int32_t)), 0, 0, 0};
+        PipeBarrier<PIPE_ALL>();
+        for (uint32_t dim = 0; dim < POINT_DIM; dim++) {
+            DataCopyPad(xyzLocal[dim * compNum], sortedXyzGm[static_cast<uint64_t>(dim) * nSupport + start],
+                xyzParams, {false, 0, 0, 0});
+        }
+        DataCopyPad(idxLocal, sortedIdxGm[start], idxParams, {false, 0, 0, 0});
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    // 计算局部坐标并筛选邻域内的源点，命中点的局部坐标和原始下标按排序顺序压缩到缓冲区头部
+    __aicore__ inline uint32_t SelectHits(uint32_t num)
+    {
+        uint32_t numAligned = (num + ALIGN_NUM_64 - 1) / ALIGN_NUM_64 * ALIGN_NUM_64;
+        LocalTensor<float> localX = localLocal;
+        LocalTensor<float> localY = localLocal[compNum];
+        LocalTensor<float> localZ = localLocal[compNum * 2];
+        Adds(localX, xyzLocal, -centerX, numAligned);
+        Adds(localY, xyzLocal[compNum], -centerY, numAligned);
+        Adds(localZ, xyzLocal[compNum * 2], -centerZ, numAligned);
+        PipeBarrier<PIPE_V>();
+        if (neighborType == NEIGHBOR_BALL) {
+            Mul(distLocal, localX, localX, numAligned);
+            Mul(tempLocal, localY, localY, numAligned);
+            PipeBarrier<PIPE_V>();
+            Add(distLocal, distLocal, tempLocal, numAligned);
+            Mul(tempLocal, localZ, localZ, numAligned);
+            PipeBarrier<PIPE_V>();
+            Add(distLocal, distLocal, tempLocal, numAligned);
+            PipeBarrier<PIPE_V>();
+            CompareScalar(maskLocal, distLocal, maxDist * maxDist, CMPMODE::LE, numAligned);
+        } else {
+            Abs(distLocal, localX, numAligned);
+            Abs(tempLocal, localY, numAligned);
+            PipeBarrier<PIPE_V>();
+            Max(distLocal, distLocal, tempLocal, numAligned);
+            Abs(tempLocal, localZ, numAligned);
+            PipeBarrier<PIPE_V>();
+            Max(distLocal, distLocal, tempLocal, numAligned);
+            PipeBarrier<PIPE_V>();
+            CompareScalar(maskLocal, distLocal, maxDist, CMPMODE::LE, numAligned);
+        }
+        PipeBarrier<PIPE_V>();
+        LocalTensor<uint32_t> mask32 = maskLocal.ReinterpretCast<uint32_t>();
+        uint64_t hitNum = 0;
+        GatherMask(localX, localX, mask32, true, num, {1, 1, 0, 0}, hitNum);
+        GatherMask(localY, localY, mask32, true, num, {1, 1, 0, 0}, hitNum);
+        GatherMask(localZ, localZ, mask32, true, num, {1, 1, 0, 0}, hitNum);
+        GatherMask(idxLocal, idxLocal, mask32, true, num, {1, 1, 0, 0}, hitNum);
+        PipeBarrier<PIPE_ALL>();
+        return static_cast<uint32_t>(hitNum);
+    }
+
+    // 与OpenPCDet一致：格子下标按(gx, gy, gz)展平后截断到[0, totalGrids)，
+    // random pooling只保留每个格子的第一个命中点；达到采样上限时返回true
+    __aicore__ inline bool AccumulateHits(uint32_t hitNum)
+    {
+        for (uint32_t h = 0; h < hitNum; h++) {
+            float lx = localLocal.GetValue(h);
+            float ly = localLocal.GetValue(compNum + h);
+            float lz = localLocal.GetValue(compNum * 2 + h);
+            int32_t gx = static_cast<int32_t>((lx + maxDist) / gridSizeX);
+            int32_t gy = static_cast<int32_t>((ly + maxDist) / gridSizeY);
+            int32_t gz = static_cast<int32_t>((lz + maxDist) / gridSizeZ);
+            int32_t grid = gx * static_cast<int32_t>(gridY * gridZ) + gy * static_cast<int32_t>(gridZ) + gz;
+            int32_t gridMax = static_cast<int32_t>(totalGrids) - 1;
+            grid = grid < 0 ? 0 : (grid > gridMax ? gridMax : grid);
+            int32_t cnt = cntLocal.GetValue(grid);
+            if (poolingType != POOLING_AVG && cnt > 0) {
+                continue;
+            }
+            cntLocal.SetValue(grid, cnt + 1);
+            if (!countOnly) {
+                int32_t supportIdx = idxLocal.GetValue(h);
+                if (useXyz) {
+                    localSumLocal.SetValue(grid * POINT_DIM, localSumLocal.GetValue(grid * POINT_DIM) + lx);
+                    localSumLocal.SetValue(grid * POINT_DIM + 1, localSumLocal.GetValue(grid * POINT_DIM + 1) + ly);
+                    localSumLocal.SetValue(grid * POINT_DIM + 2, localSumLocal.GetValue(grid * POINT_DIM + 2) + lz);
+                }
+                AppendRow(supportIdx, grid);
+                AppendGroup(supportIdx, grid);
+            }
+            sampleNum++;
+            if (sampleNum >= sampleLimit) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __aicore__ inline void AppendRow(int32_t supportIdx, int32_t grid)
+    {
+        rowGridLocal.SetValue(rowFill, grid);
+        DataCopyPad(rowLocal[rowFill * cInAligned], featuresGm[static_cast<uint64_t>(supportIdx) * cIn],
+            {1, static_cast<uint32_t>(cIn * sizeof(float)), 0, 0, 0}, {false, 0, 0, 0});
+        rowFill++;
+        if (rowFill == rowNum) {
+            FlushRows();
+        }
+    }
+
+    // 一批特征行搬入后再逐行累加到对应格子，同一格子的多行之间靠PIPE_V屏障保序
+    __aicore__ inline void FlushRows()
+    {
+        if (rowFill == 0) {
+            return;
+        }
+        PipeBarrier<PIPE_ALL>();
+        for (uint32_t r = 0; r < rowFill; r++) {
+            LocalTensor<float> acc = accLocal[rowGridLocal.GetValue(r) * cInAligned];
+            Add(acc, acc, rowLocal[r * cInAligned], cIn);
+            PipeBarrier<PIPE_V>();
+        }
+        PipeBarrier<PIPE_ALL>();
+        rowFill = 0;
+    }
+
+    __aicore__ inline void AppendGroup(int32_t supportIdx, int32_t grid)
+    {
+        groupLocal.SetValue(groupFill * GROUP_DIM, supportIdx);
+        groupLocal.SetValue(groupFill * GROUP_DIM + 1, static_cast<int32_t>(taskIdx));
+        groupLocal.SetValue(groupFill * GROUP_DIM + 2, grid);
+        groupFill++;
+        if (groupFill == groupNum) {
+            FlushGroups();
+        }
+    }
+
+    __aicore__ inline void FlushGroups()
+    {
+        if (groupFill == 0) {
+            return;
+        }
+        PipeBarrier<PIPE_ALL>();
+        DataCopyPad(groupedIdxsGm[(groupBase + groupWritten) * GROUP_DIM], groupLocal,
+            {1, static_cast<uint32_t>(groupFill * GROUP_DIM * sizeof(int32_t)), 0, 0, 0});
+        PipeBarrier<PIPE_ALL>();
+        groupWritten += groupFill;
+        groupFill = 0;
+    }
+
+    // 按格子点数求均值后折叠通道：new_features[grid, i % cEach] += features[i]
+    __aicore__ inline void Normalize()
+    {
+        for (uint32_t g = 0; g < totalGrids; g++) {
+            int32_t cnt = cntLocal.GetValue(g);
+            if (cnt <= 1) {
+                continue;
+            }
+            float scale = 1.0f / static_cast<float>(cnt);
+            Muls(accLocal[g * cInAligned], accLocal[g * cInAligned], scale, cIn);
+            if (useXyz) {
+                for (uint32_t dim = 0; dim < POINT_DIM; dim++) {
+                    localSumLocal.SetValue(g * POINT_DIM + dim, localSumLocal.GetValue(g * POINT_DIM + dim) * scale);
+                }
+            }
+        }
+        PipeBarrier<PIPE_ALL>();
+        if (cEach == cIn) {
+            return;
+        }
+        uint32_t foldNum = cIn / cEach;
+        for (uint32_t g = 0; g < totalGrids; g++) {
+            for (uint32_t j = 0; j < cEach; j++) {
+                float sum = 0.0f;
+                for (uint32_t k = 0; k < foldNum; k++) {
+                    sum += accLocal.GetValue(g * cInAligned + k * cEach + j);
+                }
+                foldLocal.SetValue(g * cEachAligned + j, sum);
+            }
+        }
+        PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void CopyOut()
+    {
+        sampleLocal.SetValue(0, sampleNum);
+        PipeBarrier<PIPE_ALL>();
+        DataCopyPad(sampleCntGm[taskIdx], sampleLocal, {1, static_cast<uint32_t>(sizeof(int32_t)), 0, 0, 0});
+        if (countOnly) {
+            return;
+        }
+        FlushRows();
+        FlushGroups();
+        Normalize();
+        LocalTensor<float> outLocal = cEach == cIn ? accLocal : foldLocal;
+        DataCopyPad(newFeaturesGm[static_cast<uint64_t>(taskIdx) * totalGrids * cEach], outLocal,
+            {static_cast<uint16_t>(totalGrids), static_cast<uint32_t>(cEach * sizeof(float)), 0, 0, 0});
+        DataCopyPad(newLocalXyzGm[static_cast<uint64_t>(taskIdx) * totalGrids * POINT_DIM], localSumLocal,
+            {1, static_cast<uint32_t>(totalGrids * POINT_DIM * sizeof(float)), 0, 0, 0});
+        DataCopyPad(pointCntGm[static_cast<uint64_t>(taskIdx) * totalGrids], cntLocal,
+            {1, static_cast<uint32_t>(totalGrids * sizeof(int32_t)), 0, 0, 0});
+        PipeBarrier<PIPE_ALL>();
+    }
+
+private:
+    TPipe* pipe;
+    TBuf<TPosition::VECCALC> xyzBuf, localBuf, idxBuf, distBuf, tempBuf, maskBuf, cntBuf, sampleBuf;
+    TBuf<TPosition::VECCALC> accBuf, foldBuf, localSumBuf, rowBuf, rowGridBuf, groupBuf;
+    GlobalTensor<float> sortedXyzGm, featuresGm, newXyzGm, newFeaturesGm, newLocalXyzGm;
+    GlobalTensor<int32_t> sortedIdxGm, cellStartGm, centerBatchGm, groupOffsetGm, pointCntGm, groupedIdxsGm;
+    GlobalTensor<int32_t> sampleCntGm;
+    LocalTensor<float> xyzLocal, localLocal, distLocal, tempLocal, accLocal, foldLocal, localSumLocal, rowLocal;
+    LocalTensor<int32_t> idxLocal, cntLocal, sampleLocal, rowGridLocal, groupLocal;
+    LocalTensor<uint8_t> maskLocal;
+
+    uint32_t nSupport, nCenter, cIn, cInAligned, cEach, cEachAligned, gridY, gridZ, totalGrids;
+    uint32_t neighborType, poolingType, cellsX, cellsY, cellsZ, compNum, rowNum, groupNum;
+    uint32_t startTask, endTask, taskIdx, gridXyzNum, gridNum, rowFill, groupFill;
+    uint64_t cellsPerBatch, groupBase, groupWritten;
+    int32_t sampleLimit, sampleNum;
+    bool useXyz, countOnly;
+    float maxDist, gridSizeX, gridSizeY, gridSizeZ, cellSize, lowerX, lowerY, lowerZ;
+    float centerX, centerY, centerZ;
+};
+
+extern "C" __global__ __aicore__ void vec_pool(GM_ADDR sorted_xyz, GM_ADDR sorted_idx, GM_ADDR cell_start,
+    GM_ADDR support_features, GM_ADDR new_xyz, GM_ADDR center_batch, GM_ADDR group_offset, GM_ADDR new_features,
+    GM_ADDR new_local_xyz, GM_ADDR point_cnt_of_grid, GM_ADDR grouped_idxs, GM_ADDR sample_cnt, GM_ADDR workspace,
+    GM_ADDR tiling)
+{
+    TPipe pipe;
+    GET_TILING_DATA(tilingData, tiling);
+    KernelVecPool op;
+    op.Init(sorted_xyz, sorted_idx, cell_start, support_features, new_xyz, center_batch, group_offset, new_features,
+        new_local_xyz, point_cnt_of_grid, grouped_idxs, sample_cnt, &tilingData, &pipe);
+    op.Process();
+}
@@ -4,7 +4,7 @@ import torch
 
 def _init_op_api_so_path(so_path: str) -> None: ...
 def knn(
-    xyz: torch.Tensor, center_xyz: torch.Tensor, k: int, is_from_knn: bool
+    xyz: torch.Tensor, center_xyz: torch.Tensor, k: int, is_from_knn: bool, with_sqrt: bool, use_grid: bool
 ) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def npu_three_interpolate(
     b: int, c: int, m: int, n: int, points: torch.Tensor, idx: torch.Tensor, weight: torch.Tensor
@@ -12,6 +12,10 @@ def npu_three_interpolate(
 def npu_three_interpolate_backward(
     b: int, c: int, n: int, m: int, grad_out: torch.Tensor, idx: torch.Tensor, weight: torch.Tensor
 ) -> torch.Tensor: ...
+def npu_three_interpolate_with_dist(points: torch.Tensor, idx: torch.Tensor, dist: torch.Tensor) -> torch.Tensor: ...
+def npu_three_interpolate_with_dist_backward(
+    grad_out: torch.Tensor, idx: torch.Tensor, dist: torch.Tensor, m: int
+) -> torch.Tensor: ...
 def scatter_max_with_argmax_v2(
     updates: torch.Tensor, indices: torch.Tensor, out: Optional[torch.Tensor] = None
 ) -> Tuple[torch.Tensor, torch.Tensor]: ...
@@ -42,6 +46,7 @@ def assign_score_withk(
     scores: torch.Tensor,
     knn_idx: torch.Tensor,
     output: torch.Tensor,
+    argmax: torch.Tensor,
     B: int,
     N: int,
     npoint: int,
@@ -56,6 +61,7 @@ def assign_score_withk_grad(
     centers: torch.Tensor,
     scores: torch.Tensor,
     knn_idx: torch.Tensor,
+    argmax: torch.Tensor,
     grad_points: torch.Tensor,
     grad_centers: torch.Tensor,
     grad_scores: torch.Tensor,
@@ -92,6 +98,7 @@ def deformable_aggregation(
     scale_start_index: torch.Tensor,
     sampling_location: torch.Tensor,
     weights: torch.Tensor,
+    use_softmax: bool,
 ) -> torch.Tensor: ...
 def deformable_aggregation_backward(
     mc_ms_feat: torch.Tensor,
@@ -100,10 +107,20 @@ def deformable_aggregation_backward(
     sampling_location: torch.Tensor,
     weights: torch.Tensor,
     grad_output: torch.Tensor,
-    grad_mc_ms_feat: torch.Tensor,
-    grad_sampling_location: torch.Tensor,
-    grad_weights: torch.Tensor,
+    grad_mc_ms_feat: Optional[torch.Tensor],
+    grad_sampling_location: Optional[torch.Tensor],
+    grad_weights: Optional[torch.Tensor],
+    use_softmax: bool,
 ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]: ...
+def deformable_aggregation_temporal(
+    feat_cache: torch.Tensor,
+    spatial_shape: torch.Tensor,
+    scale_start_index: torch.Tensor,
+    sampling_location: torch.Tensor,
+    weights: torch.Tensor,
+    slot_index: torch.Tensor,
+    use_softmax: bool,
+) -> torch.Tensor: ...
 def deformable_conv2d(
     input: torch.Tensor,
     offset: torch.Tensor,
@@ -235,9 +252,22 @@ def npu_box_iou_quadri(boxes_a: torch.Tensor, boxes_b: torch.Tensor, mode_flag:
 def npu_box_iou_rotated(
     boxes_a: torch.Tensor, boxes_b: torch.Tensor, mode_flag: int, aligned: bool
 ) -> torch.Tensor: ...
+def boxes_overlap_sparse(
+    boxes_a: torch.Tensor,
+    boxes_b: torch.Tensor,
+    box_type: int,
+    format_flag: int,
+    unit_flag: int,
+    clockwise: bool,
+    mode_flag: int,
+    margin: float,
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def border_align(
     input: torch.Tensor, rois: torch.Tensor, output: torch.Tensor, pooled_size: int
 ) -> None: ...
+def border_align_max(
+    input: torch.Tensor, rois: torch.Tensor, pooled_size: int
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def border_align_backward(
     grad_out: torch.Tensor, boxes: torch.Tensor, argmax_idx: torch.Tensor, pool_size: int, height: int, width: int
 ) -> torch.Tensor: ...
@@ -253,17 +283,79 @@ def npu_roiaware_pool3d_forward(
 def roiaware_pool3d_grad(
     pts_idx_of_voxels: torch.Tensor, argmax: torch.Tensor, grad_out: torch.Tensor, npoints: int, pool_method: int
 ) -> torch.Tensor: ...
+def roiaware_pool3d_csr(
+    rois: torch.Tensor,
+    pts: torch.Tensor,
+    pts_feature: torch.Tensor,
+    out_x: int,
+    out_y: int,
+    out_z: int,
+    max_pts_per_voxel: int,
+    mode: int,
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]: ...
+def roiaware_pool3d_csr_grad(
+    voxel_idx: torch.Tensor,
+    voxel_ptr: torch.Tensor,
+    pts_idx: torch.Tensor,
+    argmax: torch.Tensor,
+    grad_out: torch.Tensor,
+    npoints: int,
+    pool_method: int,
+) -> torch.Tensor: ...
 def npu_points_in_box(boxes: torch.Tensor, pts: torch.Tensor) -> torch.Tensor: ...
 def npu_points_in_box_all(boxes: torch.Tensor, pts: torch.Tensor) -> torch.Tensor: ...
+def points_in_boxes_grid(
+    boxes: torch.Tensor, pts: torch.Tensor, return_csr: bool, cell_size: float
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def npu_roipoint_pool3d_forward(
     num_sampled_points: int, points: torch.Tensor, point_features: torch.Tensor, boxes3d: torch.Tensor
 ) -> Tuple[torch.Tensor, torch.Tensor]: ...
+def roipoint_pool3d_csr(
+    num_sampled_points: int,
+    points: torch.Tensor,
+    point_features: torch.Tensor,
+    boxes3d: torch.Tensor,
+    pts_ptr: torch.Tensor,
+    box_idx: torch.Tensor,
+    sample_mode: int,
+    seed: int,
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def group_points(
     points: torch.Tensor, idx: torch.Tensor, b: int, c: int, n: int, npoints: int, nsample: int
 ) -> torch.Tensor: ...
 def group_points_backward(
     grad_out: torch.Tensor, idx: torch.Tensor, b: int, c: int, n: int, npoints: int, nsample: int
 ) -> torch.Tensor: ...
+def packed_from_padded(
+    padded: torch.Tensor, counts: Optional[torch.Tensor], total: int
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
+def packed_to_padded(points: torch.Tensor, ptr: torch.Tensor, max_count: int, pad_value: float) -> torch.Tensor: ...
+def packed_ptr_from_batch_index(batch_idx: torch.Tensor, batch_size: int) -> torch.Tensor: ...
+def packed_batch_index(ptr: torch.Tensor, total: int) -> Tuple[torch.Tensor, torch.Tensor]: ...
+def ball_query(
+    xyz: torch.Tensor,
+    center_xyz: torch.Tensor,
+    features: Optional[torch.Tensor],
+    min_radius: float,
+    max_radius: float,
+    sample_num: int,
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
+def vec_pool(
+    support_xyz: torch.Tensor,
+    xyz_batch_cnt: torch.Tensor,
+    support_features: torch.Tensor,
+    new_xyz: torch.Tensor,
+    new_xyz_batch_cnt: torch.Tensor,
+    num_grid_x: int,
+    num_grid_y: int,
+    num_grid_z: int,
+    max_neighbour_distance: float,
+    num_c_out: int,
+    use_xyz: bool,
+    nsample: int,
+    neighbor_type: int,
+    pooling_type: int,
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]: ...
 def vec_pool_backward(
     grad_new_features: torch.Tensor, point_cnt_of_grid: torch.Tensor, grouped_idxs: torch.Tensor, n: int, num_c_in: int
 ) -> torch.Tensor: ...
@@ -344,8 +436,9 @@ def npu_dynamic_scatter_grad(
     reduce_type: str,
 ) -> None: ...
 def npu_furthest_point_sampling(
-    point_xyz: torch.Tensor, nearset_temp: torch.Tensor, num_points: int
+    point_xyz: torch.Tensor, point_counts: Optional[torch.Tensor], num_points: int
 ) -> torch.Tensor: ...
+def npu_furthest_point_sampling_packed(points: torch.Tensor, ptr: torch.Tensor, num_points: int) -> torch.Tensor: ...
 def voxel_pooling_train(
     inputFeatures: torch.Tensor,
     geom: torch.Tensor,
@@ -384,6 +477,7 @@ def npu_bev_pool_v3(
     D: int,
     H: int,
     W: int,
+    depth_softmax: bool,
 ) -> torch.Tensor: ...
 def npu_bev_pool_v3_backward(
     grad_out: torch.Tensor,
@@ -392,19 +486,32 @@ def npu_bev_pool_v3_backward(
     ranks_depth: Optional[torch.Tensor],
     ranks_feat: Optional[torch.Tensor],
     ranks_bev: torch.Tensor,
-    B: int,
-    D: int,
-    H: int,
-    W: int,
+    depth_softmax: bool,
 ) -> Tuple[Optional[torch.Tensor], torch.Tensor]: ...
+def npu_bev_pool_precompute_key(
+    calib: List[torch.Tensor],
+    grid_lower_bound: List[float],
+    grid_interval: List[float],
+    grid_size: List[int],
+) -> int: ...
+def npu_bev_pool_precompute(
+    coor: Optional[torch.Tensor],
+    cache_key: Optional[int],
+    grid_lower_bound: List[float],
+    grid_interval: List[float],
+    grid_size: List[int],
+) -> List[torch.Tensor]: ...
+def npu_bev_pool_precompute_clear_cache() -> None: ...
 def cal_anchors_heading(
     anchors: torch.Tensor,
     origin_pos: Optional[torch.Tensor],
 ) -> torch.Tensor: ...
-def diff_iou_rotated_2d(
-    box1: torch.Tensor,
-    box2: torch.Tensor
+def diff_iou_rotated_sort_vertices(
+    vertices: torch.Tensor, mask: torch.Tensor, num_valid: torch.Tensor
 ) -> torch.Tensor: ...
+def diff_iou_rotated(
+    boxes_a: torch.Tensor, boxes_b: torch.Tensor, mode: int, with_grad: bool
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 def grid_sampler2d_v2(
     input: torch.Tensor,
     grid: torch.Tensor,
@@ -435,14 +542,33 @@ def cartesian_to_frenet(
 def min_area_polygons(
     pointsets: torch.Tensor
 ) -> torch.Tensor: ...
+def min_area_rects(
+    pointsets: torch.Tensor
+) -> torch.Tensor: ...
+def assign_target_of_multi_head(
+    boxes: torch.Tensor,
+    labels: torch.Tensor,
+    head_num_classes: List[int],
+    out_size_factor: int,
+    overlap: float,
+    min_radius: int,
+    voxel_size: List[float],
+    pc_range: List[float],
+    feature_map_size: List[int],
+    norm_bbox: bool,
+    flip_angle: bool,
+    max_objs: int,
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]: ...
 def radius(
     x: torch.Tensor, y: torch.Tensor, ptr_x: torch.Tensor, 
-    ptr_y: torch.Tensor, r: int, max_num_neighbors: int
-) -> torch.Tensor: ...
+    ptr_y: torch.Tensor, r: float, max_num_neighbors: int, padded: bool
+) -> Tuple[torch.Tensor, torch.Tensor]: ...
 __all__ = [
     "knn",
     "npu_three_interpolate",
     "npu_three_interpolate_backward",
+    "npu_three_interpolate_with_dist",
+    "npu_three_interpolate_with_dist_backward",
     "npu_batch_matmul",
     "scatter_max_with_argmax_v2",
     "npu_scatter_max_backward",
@@ -462,6 +588,7 @@ __all__ = [
     "fused_bias_leaky_relu",
     "deformable_aggregation",
     "deformable_aggregation_backward",
+    "deformable_aggregation_temporal",
     "deformable_conv2d",
     "modulated_deformable_conv2d",
     "deformable_conv2d_backward",
@@ -472,11 +599,22 @@ __all__ = [
     "npu_rotated_overlaps",
     "npu_rotated_iou",
     "npu_boxes_overlap_bev",
+    "boxes_overlap_sparse",
     "npu_points_in_box",
     "npu_points_in_box_all",
+    "points_in_boxes_grid",
+    "roiaware_pool3d_csr",
+    "roiaware_pool3d_csr_grad",
     "npu_roipoint_pool3d_forward",
+    "roipoint_pool3d_csr",
     "group_points",
     "group_points_backward",
+    "packed_from_padded",
+    "packed_to_padded",
+    "packed_ptr_from_batch_index",
+    "packed_batch_index",
+    "ball_query",
+    "vec_pool",
     "vec_pool_backward",
     "point_to_voxel",
     "voxel_pooling_train",
@@ -486,12 +624,19 @@ __all__ = [
     "npu_dynamic_scatter",
     "npu_dynamic_scatter_grad",
     "npu_furthest_point_sampling",
+    "npu_furthest_point_sampling_packed",
     "npu_bev_pool_v3",
     "npu_bev_pool_v3_backward",
+    "npu_bev_pool_precompute_key",
+    "npu_bev_pool_precompute",
+    "npu_bev_pool_precompute_clear_cache",
     "cal_anchors_heading",
-    "diff_iou_rotated_2d",
+    "diff_iou_rotated_sort_vertices",
+    "diff_iou_rotated",
     "boxes_iou_bev",
     "cartesian_to_frenet",
     "min_area_polygons",
+    "min_area_rects",
+    "assign_target_of_multi_head",
     "radius",
 ]
@@ -1,4 +1,5 @@
 __all__ = [
+    "PackedPointBatch",
     "RoIPointPool3d",
     "SparseConv3d",
     "SubMConv3d",
@@ -7,19 +8,29 @@ __all__ = [
     "SparseSequential",
     "Voxelization",
     "assign_score_withk",
+    "ball_query",
+    "ball_query_group",
     "bev_pool",
     "bev_pool_v2",
     "bev_pool_v3",
+    "bev_pool_precompute",
+    "clear_bev_pool_precompute_cache",
     "border_align",
     "box_iou_quadri",
     "box_iou_rotated",
+    "box_iou_quadri_sparse",
+    "box_iou_rotated_sparse",
     "boxes_overlap_bev",
+    "boxes_overlap_bev_sparse",
+    "boxes_iou_bev_sparse",
     "npu_boxes_overlap_bev",
     "boxes_iou_bev",
     "deform_conv2d",
     "dynamic_scatter",
     "furthest_point_sample_with_dist",
     "furthest_point_sample_with_dist",
+    "furthest_point_sampling_packed",
+    "furthest_point_sampling_approx",
     "npu_fused_bias_leaky_relu",
     "geometric_kernel_attention",
     "grid_sampler2d_v2",
@@ -34,6 +45,8 @@ __all__ = [
     "npu_deformable_aggregation",
     "npu_batch_matmul",
     "deformable_aggregation",
+    "deformable_aggregation_temporal",
+    "DeformableAggregationFeatureCache",
     "npu_dynamic_scatter",
     "npu_max_pool2d",
     "npu_nms3d",
@@ -42,25 +55,33 @@ __all__ = [
     "npu_points_in_box_all",
     "points_in_box",
     "points_in_boxes_all",
+    "points_in_boxes_first",
+    "points_in_boxes_csr",
     "pixel_group",
     "roi_align_rotated",
     "roiaware_pool3d",
+    "roipoint_pool3d_csr",
     "npu_rotated_iou",
     "npu_rotated_overlaps",
     "scatter_max",
     "scatter_mean",
     "three_interpolate",
+    "three_interpolate_with_dist",
     "three_nn",
+    "vec_pool",
     "npu_voxel_pooling_train",
     "voxelization",
     "cal_anchors_heading",
     "npu_gaussian",
     "npu_draw_gaussian_to_heatmap",
     "npu_assign_target_of_single_head",
+    "assign_target_of_multi_head",
     "diff_iou_rotated_2d",
+    "diff_iou_rotated_loss",
     "nms3d_on_sight",
     "cartesian_to_frenet",
     "min_area_polygons",
+    "min_area_rects",
     "radius",
 ]
 
@@ -73,14 +94,26 @@ from .modules.sparse_conv import SparseConv3d, SubMConv3d
 from .modules.sparse_modules import SparseConvTensor, SparseModule, SparseSequential
 from .modules.voxelization import Voxelization
 from .ops.assign_score_withk import assign_score_withk
+from .ops.ball_query import ball_query, ball_query_group
 from .ops.bev_pool import bev_pool
 from .ops.bev_pool_v2 import bev_pool_v2
 from .ops.bev_pool_v3 import bev_pool_v3
+from .ops.bev_pool_precompute import bev_pool_precompute, clear_bev_pool_precompute_cache
 from .ops.border_align import border_align
-from .ops.box_iou import box_iou_quadri, box_iou_rotated
-from .ops.boxes_overlap_bev import boxes_overlap_bev, npu_boxes_overlap_bev, boxes_iou_bev
+from .ops.box_iou import box_iou_quadri, box_iou_rotated, box_iou_quadri_sparse, box_iou_rotated_sparse
+from .ops.boxes_overlap_bev import (
+    boxes_overlap_bev,
+    npu_boxes_overlap_bev,
+    boxes_iou_bev,
+    boxes_overlap_bev_sparse,
+    boxes_iou_bev_sparse,
+)
 from .ops.deform_conv2d import DeformConv2dFunction, deform_conv2d
-from .ops.furthest_point_sampling import furthest_point_sampling
+from .ops.furthest_point_sampling import (
+    furthest_point_sampling,
+    furthest_point_sampling_approx,
+    furthest_point_sampling_packed,
+)
 from .ops.furthest_point_sampling_with_dist import furthest_point_sample_with_dist
 from .ops.fused_bias_leaky_relu import npu_fused_bias_leaky_relu
 from .ops.group_points import group_points
@@ -95,24 +128,31 @@ from .ops.multi_scale_deformable_attn import (
     npu_multi_scale_deformable_attn_function,
 )
 from .ops.nms3d_normal import nms3d_normal
+from .ops.packed_point_batch import PackedPointBatch
 from .ops.npu_add_relu import npu_add_relu
-from .ops.npu_deformable_aggregation import npu_deformable_aggregation, deformable_aggregation
+from .ops.npu_deformable_aggregation import (
+    npu_deformable_aggregation,
+    deformable_aggregation,
+    deformable_aggregation_temporal,
+    DeformableAggregationFeatureCache,
+)
 from .ops.npu_dynamic_scatter import npu_dynamic_scatter, dynamic_scatter
 from .ops.npu_max_pool2d import npu_max_pool2d
 from .ops.nms3d import nms3d
-from .ops.npu_points_in_box import npu_points_in_box, points_in_box
+from .ops.npu_points_in_box import npu_points_in_box, points_in_box, points_in_boxes_first, points_in_boxes_csr
 from .ops.npu_points_in_box_all import npu_points_in_box_all, points_in_boxes_all
 from .ops.pixel_group import pixel_group
 from .ops.roi_align_rotated import roi_align_rotated
 from .ops.roiaware_pool3d import roiaware_pool3d
-from .ops.roipoint_pool3d import roipoint_pool3d
+from .ops.roipoint_pool3d import roipoint_pool3d, roipoint_pool3d_csr
 from .ops.rotated_iou import npu_rotated_iou
 from .ops.rotated_overlaps import npu_rotated_overlaps
 from .ops.scatter_max import scatter_max
 from .ops.scatter_mean import scatter_mean
 from .ops.scatter_add import scatter_add
-from .ops.three_interpolate import three_interpolate
+from .ops.three_interpolate import three_interpolate, three_interpolate_with_dist
 from .ops.three_nn import three_nn
+from .ops.vec_pool import vec_pool
 from .ops.voxel_pooling_train import npu_voxel_pooling_train
 from .ops.voxelization import voxelization
 from .ops.unique_voxel import unique_voxel
@@ -120,13 +160,14 @@ from .ops.cal_anchors_heading import cal_anchors_heading
 from .ops.npu_gaussian import npu_gaussian
 from .ops.npu_draw_gaussian_to_heatmap import npu_draw_gaussian_to_heatmap
 from .ops.npu_assign_target_of_single_head import npu_assign_target_of_single_head
-from .ops.diff_iou_rotated import diff_iou_rotated_2d
+from .ops.assign_target_of_multi_head import assign_target_of_multi_head
+from .ops.diff_iou_rotated import diff_iou_rotated_2d, diff_iou_rotated_loss
 from .ops.npu_batch_matmul import npu_batch_matmul
 from .ops.nms3d_on_sight import nms3d_on_sight
 from .ops.cartesian_to_frenet import cartesian_to_frenet
 from .patcher import default_patcher_builder, patch_mmcv_version
 from .ops.radius import radius
-from .ops.min_area_polygons import min_area_polygons
+from .ops.min_area_polygons import min_area_polygons, min_area_rects
 
 
 def _set_env():
@@ -0,0 +1,351 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int64_t MIN_BOX_DIM = 7;
+constexpr int64_t ANGLE_IDX = 6;
+constexpr int64_t TASK_GRAIN = 1;
+// 高斯核半径上限，设备实现按(2 * MAX_RADIUS + 1)^2的固定窗口展开
+constexpr int64_t MAX_RADIUS = 64;
+// 设备实现每块高斯核窗口(目标数, 窗口高, 窗口宽)的元素数上限
+constexpr int64_t HEATMAP_CHUNK_ELEMS = 16 * 1024 * 1024;
+constexpr size_t MAX_CLASS_HEAD_TABLES = 16;
+
+struct AssignParams {
+    float out_size_factor;
+    float overlap;
+    int64_t min_radius;
+    float voxel_x;
+    float voxel_y;
+    float range_x;
+    float range_y;
+    int64_t width;
+    int64_t height;
+    bool norm_bbox;
+    bool flip_angle;
+    int64_t max_objs;
+};
+
+// 与mmdet3d的gaussian_radius一致，按float计算，截断后的半径与单head算子相同
+float GaussianRadius(float height, float width, float overlap)
+{
+    float b1 = height + width;
+    float c1 = width * height * (1 - overlap) / (1 + overlap);
+    float r1 = (b1 + std::sqrt(b1 * b1 - 4 * c1)) / 2;
+    float b2 = 2 * (height + width);
+    float c2 = (1 - overlap) * width * height;
+    float r2 = (b2 + std::sqrt(b2 * b2 - 16 * c2)) / 2;
+    float b3 = -2 * overlap * (height + width);
+    float c3 = (overlap - 1) * width * height;
+    float r3 = (b3 + std::sqrt(b3 * b3 - 16 * overlap * c3)) / 2;
+    return std::min(std::min(r1, r2), r3);
+}
+
+// GaussianRadius的逐元素张量版本
+at::Tensor GaussianRadius(const at::Tensor& height, const at::Tensor& width, float overlap)
+{
+    at::Tensor b1 = height + width;
+    at::Tensor c1 = width * height * (1 - overlap) / (1 + overlap);
+    at::Tensor r1 = (b1 + (b1 * b1 - 4 * c1).sqrt()) / 2;
+    at::Tensor b2 = 2 * (height + width);
+    at::Tensor c2 = (1 - overlap) * width * height;
+    at::Tensor r2 = (b2 + (b2 * b2 - 16 * c2).sqrt()) / 2;
+    at::Tensor b3 = -2 * overlap * (height + width);
+    at::Tensor c3 = (overlap - 1) * width * height;
+    at::Tensor r3 = (b3 + (b3 * b3 - 16 * overlap * c3).sqrt()) / 2;
+    return at::minimum(at::minimum(r1, r2), r3);
+}
+
+// heatmap为单个类别的(H, W)，高斯核按double计算后取max写入
+void DrawGaussian(float* heatmap, int64_t x, int64_t y, int64_t radius, int64_t width, int64_t height)
+{
+    double sigma = static_cast<double>(2 * radius + 1) / 6;
+    double denom = 2 * sigma * sigma;
+    int64_t left = std::min(x, radius);
+    int64_t right = std::min(width - x, radius + 1);
+    int64_t top = std::min(y, radius);
+    int64_t bottom = std::min(height - y, radius + 1);
+    for (int64_t dy = -top; dy < bottom; dy++) {
+        float* row = heatmap + (y + dy) * width + x;
+        for (int64_t dx = -left; dx < right; dx++) {
+            float g = static_cast<float>(std::exp(-static_cast<double>(dx * dx + dy * dy) / denom));
+            row[dx] = std::max(row[dx], g);
+        }
+    }
+}
+
+void FillAnnoRow(const float* box, int64_t box_dim, float cx, float cy, int64_t ix, int64_t iy, bool norm_bbox,
+    bool flip_angle, float* row)
+{
+    row[0] = cx - static_cast<float>(ix);
+    row[1] = cy - static_cast<float>(iy);
+    row[2] = box[2];
+    for (int64_t j = 3; j < ANGLE_IDX; j++) {
+        row[j] = norm_bbox ? std::log(box[j]) : box[j];
+    }
+    float sin_a = std::sin(box[ANGLE_IDX]);
+    float cos_a = std::cos(box[ANGLE_IDX]);
+    row[ANGLE_IDX] = flip_angle ? cos_a : sin_a;
+    row[ANGLE_IDX + 1] = flip_angle ? sin_a : cos_a;
+    for (int64_t j = ANGLE_IDX + 1; j < box_dim; j++) {
+        row[j + 1] = box[j];
+    }
+}
+
+/**
+ * 单个(样本, head)：按原顺序取出属于该head的目标，第k个目标占用第k个槽位，
+ * 尺寸非正的目标占用槽位但不写入，与逐head调用单head算子的结果一致。
+ */
+void AssignTaskCpu(const float* boxes, const int64_t* labels, int64_t num_boxes, int64_t box_dim, int64_t cls_begin,
+    int64_t cls_end, const AssignParams& p, float* heatmap, float* anno, int64_t* ind, uint8_t* mask)
+{
+    int64_t slot = 0;
+    for (int64_t i = 0; i < num_boxes && slot < p.max_objs; i++) {
+        int64_t label = labels[i];
+        if (label < cls_begin || label >= cls_end) {
+            continue;
+        }
+        int64_t k = slot++;
+        const float* box = boxes + i * box_dim;
+        float dx = box[3] / p.voxel_x / p.out_size_factor;
+        float dy = box[4] / p.voxel_y / p.out_size_factor;
+        if (dx <= 0 || dy <= 0) {
+            continue;
+        }
+        float cx = std::min(std::max((box[0] - p.range_x) / p.voxel_x / p.out_size_factor, 0.0f), p.width - 0.5f);
+        float cy = std::min(std::max((box[1] - p.range_y) / p.voxel_y / p.out_size_factor, 0.0f), p.height - 0.5f);
+        int64_t ix = static_cast<int64_t>(cx);
+        int64_t iy = static_cast<int64_t>(cy);
+        int64_t radius =
+            std::min(std::max(static_cast<int64_t>(GaussianRadius(dx, dy, p.overlap)), p.min_radius), MAX_RADIUS);
+        DrawGaussian(heatmap + label * p.height * p.width, ix, iy, radius, p.width, p.height);
+        ind[k] = iy * p.width + ix;
+        mask[k] = 1;
+        FillAnnoRow(box, box_dim, cx, cy, ix, iy, p.norm_bbox, p.flip_angle, anno + k * (box_dim + 1));
+    }
+}
+
+void AssignCpu(const at::Tensor& boxes, const at::Tensor& labels, const std::vector<int64_t>& cls_offsets,
+    const AssignParams& p, at::Tensor& heatmap, at::Tensor& anno_box, at::Tensor& ind, at::Tensor& mask)
+{
+    int64_t batch = boxes.size(0);
+    int64_t num_boxes = boxes.size(1);
+    int64_t box_dim = boxes.size(2);
+    int64_t num_heads = static_cast<int64_t>(cls_offsets.size()) - 1;
+    int64_t num_classes = cls_offsets.back();
+    const float* box_ptr = boxes.data_ptr<float>();
+    const int64_t* label_ptr = labels.data_ptr<int64_t>();
+    float* heatmap_ptr = heatmap.data_ptr<float>();
+    float* anno_ptr = anno_box.data_ptr<float>();
+    int64_t* ind_ptr = ind.data_ptr<int64_t>();
+    uint8_t* mask_ptr = mask.data_ptr<uint8_t>();
+    // 不同(样本, head)写入的heatmap通道与槽位互不重叠
+    at::parallel_for(0, batch * num_heads, TASK_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; task++) {
+            int64_t b = task / num_heads;
+            int64_t head = task % num_heads;
+            int64_t slots = (head * batch + b) * p.max_objs;
+            AssignTaskCpu(box_ptr + b * num_boxes * box_dim, label_ptr + b * num_boxes, num_boxes, box_dim,
+                cls_offsets[head], cls_offsets[head + 1], p, heatmap_ptr + b * num_classes * p.height * p.width,
+                anno_ptr + slots * (box_dim + 1), ind_ptr + slots, mask_ptr + slots);
+        }
+    });
+}
+
+struct ClassHeadCache {
+    std::mutex mutex;
+    std::map<std::pair<std::string, std::vector<int64_t>>, at::Tensor> tables;
+};
+
+// 缓存中持有device上的tensor，不在进程退出时析构，避免晚于device释放
+ClassHeadCache& GetClassHeadCache()
+{
+    static auto* cache = new ClassHeadCache();
+    return *cache;
+}
+
+// 全局类别到head编号的映射表，按(设备, 各head的类别范围)缓存，只在首次调用时从host拷贝
+at::Tensor ClassHeadTable(const std::vector<int64_t>& cls_offsets, const at::Device& device)
+{
+    auto& cache = GetClassHeadCache();
+    auto key = std::make_pair(device.str(), cls_offsets);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.tables.find(key);
+    if (it != cache.tables.end()) {
+        return it->second;
+    }
+    if (cache.tables.size() >= MAX_CLASS_HEAD_TABLES) {
+        cache.tables.clear();
+    }
+    std::vector<int64_t> class_head(cls_offsets.back());
+    for (size_t head = 0; head + 1 < cls_offsets.size(); head++) {
+        std::fill(class_head.begin() + cls_offsets[head], class_head.begin() + cls_offsets[head + 1], head);
+    }
+    at::Tensor table = at::tensor(class_head, at::kLong).to(device);
+    cache.tables.emplace(key, table);
+    return table;
+}
+
+/**
+ * 全部目标一起计算，不写入的目标落到末尾多出的一个槽位，不需要nonzero筛选；
+ * 高斯核按以中心为原点的固定大小窗口展开，不需要把最大半径同步到host，计算量与目标数成正比而与特征图大小无关。
+ * 除首次构建类别映射表外没有host与device间的同步。
+ */
+void AssignDevice(const at::Tensor& boxes, const at::Tensor& labels, const std::vector<int64_t>& cls_offsets,
+    const AssignParams& p, at::Tensor& heatmap, at::Tensor& anno_box, at::Tensor& ind, at::Tensor& mask)
+{
+    int64_t batch = boxes.size(0);
+    int64_t num_boxes = boxes.size(1);
+    int64_t box_dim = boxes.size(2);
+    int64_t num_heads = static_cast<int64_t>(cls_offsets.size()) - 1;
+    int64_t num_classes = cls_offsets.back();
+    int64_t num_slots = num_heads * batch * p.max_objs;
+    auto index_options = labels.options();
+
+    at::Tensor valid = (labels >= 0) & (labels < num_classes);
+    at::Tensor label = labels.clamp(0, num_classes - 1);
+    at::Tensor head = ClassHeadTable(cls_offsets, labels.device()).index_select(0, label.view(-1));
+    head = head.view({batch, num_boxes});
+    // 每个目标在所属(样本, head)内的序号即为槽位
+    at::Tensor onehot = (head.unsqueeze(2) == at::arange(num_heads, index_options)) & valid.unsqueeze(2);
+    at::Tensor slot = (onehot.to(at::kLong).cumsum(1) - 1).gather(2, head.unsqueeze(2)).squeeze(2);
+    at::Tensor dx = boxes.select(2, 3) / p.voxel_x / p.out_size_factor;
+    at::Tensor dy = boxes.select(2, 4) / p.voxel_y / p.out_size_factor;
+    at::Tensor draw = valid & (slot < p.max_objs) & (dx > 0) & (dy > 0);
+    at::Tensor b_idx = at::arange(batch, index_options).unsqueeze(1);
+    at::Tensor dest = at::where(draw, (head * batch + b_idx) * p.max_objs + slot, num_slots).view(-1);
+
+    at::Tensor box = boxes.reshape({-1, box_dim});
+    at::Tensor cx = ((box.select(1, 0) - p.range_x) / p.voxel_x / p.out_size_factor).clamp(0, p.width - 0.5);
+    at::Tensor cy = ((box.select(1, 1) - p.range_y) / p.voxel_y / p.out_size_factor).clamp(0, p.height - 0.5);
+    at::Tensor ix = cx.to(at::kLong);
+    at::Tensor iy = cy.to(at::kLong);
+
+    at::Tensor dims = box.narrow(1, 3, 3);
+    at::Tensor angle = box.select(1, ANGLE_IDX);
+    at::Tensor sin_a = angle.sin().unsqueeze(1);
+    at::Tensor cos_a = angle.cos().unsqueeze(1);
+    at::Tensor rows = at::cat({(cx - ix.to(at::kFloat)).unsqueeze(1), (cy - iy.to(at::kFloat)).unsqueeze(1),
+                                  box.narrow(1, 2, 1), p.norm_bbox ? dims.log() : dims, p.flip_angle ? cos_a : sin_a,
+                                  p.flip_angle ? sin_a : cos_a, box.narrow(1, ANGLE_IDX + 1, box_dim - ANGLE_IDX - 1)},
+        1);
+    at::Tensor anno_buf = at::zeros({num_slots + 1, box_dim + 1}, anno_box.options());
+    at::Tensor ind_buf = at::zeros({num_slots + 1}, ind.options());
+    at::Tensor mask_buf = at::zeros({num_slots + 1}, mask.options());
+    anno_buf.index_copy_(0, dest, rows);
+    ind_buf.index_copy_(0, dest, iy * p.width + ix);
+    mask_buf.index_fill_(0, dest, 1);
+    anno_box.view({-1, box_dim + 1}).copy_(anno_buf.narrow(0, 0, num_slots));
+    ind.view(-1).copy_(ind_buf.narrow(0, 0, num_slots));
+    mask.view(-1).copy_(mask_buf.narrow(0, 0, num_slots));
+
+    // 高斯核可分离为列、行两个一维核的乘积，在以中心为原点的窗口内展开；不写入的目标在展开前权重置0，
+    // 超出半径或特征图的位置权重同样为0并截到边界，heatmap初始为0，按amax写入时不产生影响
+    at::Tensor drawn = draw.view({-1, 1});
+    at::Tensor radius = GaussianRadius(dx, dy, p.overlap).to(at::kLong).clamp_min(p.min_radius).view({-1, 1});
+    radius = at::where(drawn, radius.clamp_max(MAX_RADIUS), 0);
+    at::Tensor sigma = (2 * radius + 1).to(at::kFloat) / 6;
+    at::Tensor denom = 2 * sigma * sigma;
+    // 窗口超出特征图的部分不会写入，特征图较小时按特征图大小截短窗口
+    int64_t window_radius = std::min(MAX_RADIUS, std::max(p.width, p.height) - 1);
+    at::Tensor offset = at::arange(-window_radius, window_radius + 1, index_options).unsqueeze(0);
+    auto kernel_1d = [&](const at::Tensor& center, int64_t size, at::Tensor& pos) {
+        at::Tensor raw = center.unsqueeze(1) + offset;
+        at::Tensor inside = (offset.abs() <= radius) & (raw >= 0) & (raw < size) & drawn;
+        pos = raw.clamp(0, size - 1);
+        return at::where(inside, at::exp(-(offset * offset).to(at::kFloat) / denom), 0.0f);
+    };
+    at::Tensor px;
+    at::Tensor py;
+    at::Tensor gx = kernel_1d(ix, p.width, px);
+    at::Tensor gy = kernel_1d(iy, p.height, py);
+    at::Tensor channel = (b_idx * num_classes + label).view({-1, 1, 1});
+    at::Tensor heatmap_flat = heatmap.view(-1);
+    int64_t total = batch * num_boxes;
+    int64_t window = (2 * window_radius + 1) * (2 * window_radius + 1);
+    int64_t chunk = std::max<int64_t>(1, HEATMAP_CHUNK_ELEMS / window);
+    for (int64_t begin = 0; begin < total; begin += chunk) {
+        int64_t len = std::min(chunk, total - begin);
+        at::Tensor gaussian = gy.narrow(0, begin, len).unsqueeze(2) * gx.narrow(0, begin, len).unsqueeze(1);
+        at::Tensor row = channel.narrow(0, begin, len) * p.height + py.narrow(0, begin, len).unsqueeze(2);
+        at::Tensor target = row * p.width + px.narrow(0, begin, len).unsqueeze(1);
+        heatmap_flat.scatter_reduce_(0, target.reshape(-1), gaussian.reshape(-1), "amax");
+    }
+}
+} // namespace
+
+/**
+ * @brief CenterPoint全部task head、全部样本的目标分配，一次完成
+ * @param boxes: (B, M, D)，D >= 7，按(x, y, z, dx, dy, dz, yaw, ...)排列，不足M个目标的样本需填充
+ * @param labels: (B, M)，从0开始的全局类别编号，各head的类别依次连续排列；小于0的为填充
+ * @param head_num_classes: 各head的类别数
+ * @param 其余参数含义同npu_assign_target_of_single_head
+ * @return heatmap: (B, sum(head_num_classes), H, W)，float32，第c个通道为全局类别c
+ *         anno_box: (num_heads, B, max_objs, D + 1)，float32
+ *         ind: (num_heads, B, max_objs)，int64
+ *         mask: (num_heads, B, max_objs)，uint8
+ */
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> assign_target_of_multi_head(const at::Tensor& boxes,
+    const at::Tensor& labels, at::IntArrayRef head_num_classes, int64_t out_size_factor, double overlap,
+    int64_t min_radius, const std::vector<float>& voxel_size, const std::vector<float>& pc_range,
+    at::IntArrayRef feature_map_size, bool norm_bbox, bool flip_angle, int64_t max_objs)
+{
+    TORCH_CHECK(boxes.dim() == 3 && boxes.size(2) >= MIN_BOX_DIM, "boxes must be 3D tensor (B, M, D) with D >= 7");
+    TORCH_CHECK(labels.dim() == 2 && labels.size(0) == boxes.size(0) && labels.size(1) == boxes.size(1),
+        "labels must be 2D tensor (B, M)");
+    TORCH_CHECK(!head_num_classes.empty(), "head_num_classes must not be empty");
+    TORCH_CHECK(voxel_size.size() >= 2 && pc_range.size() >= 2 && feature_map_size.size() == 2,
+        "voxel_size and pc_range need x, y and feature_map_size must be (x, y)");
+    TORCH_CHECK(max_objs > 0 && out_size_factor > 0, "max_objs and out_size_factor must be positive");
+    std::vector<int64_t> cls_offsets(head_num_classes.size() + 1, 0);
+    for (size_t head = 0; head < head_num_classes.size(); head++) {
+        TORCH_CHECK(head_num_classes[head] > 0, "head_num_classes must be positive");
+        cls_offsets[head + 1] = cls_offsets[head] + head_num_classes[head];
+    }
+
+    AssignParams params {static_cast<float>(out_size_factor), static_cast<float>(overlap), min_radius, voxel_size[0],
+        voxel_size[1], pc_range[0], pc_range[1], feature_map_size[0], feature_map_size[1], norm_bbox, flip_angle,
+        max_objs};
+    int64_t batch = boxes.size(0);
+    int64_t box_dim = boxes.size(2);
+    int64_t num_heads = static_cast<int64_t>(head_num_classes.size());
+    at::Tensor boxes_fp32 = boxes.to(at::kFloat).contiguous();
+    at::Tensor labels_long = labels.to(at::kLong).contiguous();
+    auto options = boxes_fp32.options();
+    at::Tensor heatmap = at::zeros({batch, cls_offsets.back(), params.height, params.width}, options);
+    at::Tensor anno_box = at::zeros({num_heads, batch, max_objs, box_dim + 1}, options);
+    at::Tensor ind = at::zeros({num_heads, batch, max_objs}, options.dtype(at::kLong));
+    at::Tensor mask = at::zeros({num_heads, batch, max_objs}, options.dtype(at::kByte));
+    if (boxes.device().is_cpu()) {
+        AssignCpu(boxes_fp32, labels_long, cls_offsets, params, heatmap, anno_box, ind, mask);
+    } else {
+        TORCH_CHECK_NPU(boxes);
+        AssignDevice(boxes_fp32, labels_long, cls_offsets, params, heatmap, anno_box, ind, mask);
+    }
+    return std::make_tuple(heatmap, anno_box, ind, mask);
+}
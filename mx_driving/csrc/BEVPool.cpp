@@ -49,6 +49,9 @@ at::Tensor npu_bev_pool(const at::Tensor& feat, const at::Tensor& geom_feat, con
 {
     TORCH_CHECK(feat.dim() == 2, "feat must be 2D tensor(n, c)");
     TORCH_CHECK(geom_feat.dim() == 2, "coords must be 2D tensor(n, 4)");
+    if (feat.device().is_cpu()) {
+        return bev_pool_cpu(feat, geom_feat, interval_lengths, interval_starts, b, d, h, w);
+    }
     check_npu(feat, geom_feat, interval_lengths, interval_starts);
 
     auto n = geom_feat.size(N_IDX);
@@ -49,6 +49,9 @@ at::Tensor npu_bev_pool_backward(const at::Tensor& grad_out, const at::Tensor& g
 {
     TORCH_CHECK(grad_out.dim() == 5, "grad_out must be 5D tensor(b, d, h, w, c)");
     TORCH_CHECK(geom_feat.dim() == 2, "coords must be 2D tensor(n, 4)");
+    if (grad_out.device().is_cpu()) {
+        return bev_pool_backward_cpu(grad_out, geom_feat, interval_lengths, interval_starts, b, d, h, w);
+    }
     check_npu(grad_out, geom_feat, interval_lengths, interval_starts);
     auto n = geom_feat.size(N_IDX);
     auto c = grad_out.size(C_IDX);
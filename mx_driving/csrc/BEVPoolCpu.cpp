@@ -0,0 +1,397 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/CpuVecUtils.h"
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr int64_t INTERVAL_GRAIN = 16;
+constexpr int64_t POINT_GRAIN = 256;
+constexpr int64_t GEOM_W_IDX = 1;
+constexpr int64_t GEOM_H_IDX = 0;
+constexpr int64_t GEOM_D_IDX = 2;
+constexpr int64_t GEOM_B_IDX = 3;
+constexpr int64_t GEOM_DIM = 4;
+constexpr int64_t DEPTH_DIM = 2;
+constexpr int64_t VOXEL_INDICES_NUM = 3;
+
+using cpu_vec::Axpy;
+using cpu_vec::AddRow;
+using cpu_vec::Dot;
+
+at::Tensor ToFloat(const at::Tensor& t)
+{
+    return t.to(at::kFloat).contiguous();
+}
+
+at::Tensor ToInt(const at::Tensor& t)
+{
+    return t.to(at::kInt).contiguous();
+}
+
+// 将keys稳定排序并切分为值相同的连续段，每段由单个线程独占处理，无需原子操作
+// keys < 0 的元素被丢弃
+void BuildRuns(const at::Tensor& keys, std::vector<int64_t>& order, std::vector<int64_t>& run_starts)
+{
+    auto sorted = at::sort(keys.to(at::kLong), true, 0, false);
+    auto values = std::get<0>(sorted).contiguous();
+    auto indices = std::get<1>(sorted).contiguous();
+    const int64_t* value_ptr = values.data_ptr<int64_t>();
+    const int64_t* index_ptr = indices.data_ptr<int64_t>();
+    int64_t n = values.numel();
+    int64_t first = 0;
+    while (first < n && value_ptr[first] < 0) {
+        ++first;
+    }
+    order.assign(index_ptr + first, index_ptr + n);
+    run_starts.clear();
+    for (int64_t i = first; i < n; ++i) {
+        if (i == first || value_ptr[i] != value_ptr[i - 1]) {
+            run_starts.push_back(i - first);
+        }
+    }
+    run_starts.push_back(n - first);
+}
+} // namespace
+
+at::Tensor bev_pool_cpu(const at::Tensor& feat, const at::Tensor& geom_feat, const at::Tensor& interval_lengths,
+    const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w)
+{
+    auto c = feat.size(1);
+    auto feat_f = ToFloat(feat);
+    auto geom = ToInt(geom_feat);
+    auto lengths = ToInt(interval_lengths);
+    auto starts = ToInt(interval_starts);
+    auto out = at::zeros({b, d, h, w, c}, feat_f.options());
+
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    const int32_t* geom_ptr = geom.data_ptr<int32_t>();
+    const int32_t* length_ptr = lengths.data_ptr<int32_t>();
+    const int32_t* start_ptr = starts.data_ptr<int32_t>();
+    float* out_ptr = out.data_ptr<float>();
+    at::parallel_for(0, lengths.numel(), INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            int64_t start = start_ptr[idx];
+            const int32_t* g = geom_ptr + start * GEOM_DIM;
+            int64_t bev = ((static_cast<int64_t>(g[GEOM_B_IDX]) * d + g[GEOM_D_IDX]) * h + g[GEOM_H_IDX]) * w +
+                          g[GEOM_W_IDX];
+            float* out_row = out_ptr + bev * c;
+            for (int64_t i = start; i < start + length_ptr[idx]; ++i) {
+                AddRow(out_row, feat_ptr + i * c, c);
+            }
+        }
+    });
+    return out.to(feat.scalar_type());
+}
+
+at::Tensor bev_pool_backward_cpu(const at::Tensor& grad_out, const at::Tensor& geom_feat,
+    const at::Tensor& interval_lengths, const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w)
+{
+    auto n = geom_feat.size(0);
+    auto c = grad_out.size(4);
+    auto grad_f = ToFloat(grad_out);
+    auto geom = ToInt(geom_feat);
+    auto lengths = ToInt(interval_lengths);
+    auto starts = ToInt(interval_starts);
+    auto grad_feat = at::zeros({n, c}, grad_f.options());
+
+    const float* grad_ptr = grad_f.data_ptr<float>();
+    const int32_t* geom_ptr = geom.data_ptr<int32_t>();
+    const int32_t* length_ptr = lengths.data_ptr<int32_t>();
+    const int32_t* start_ptr = starts.data_ptr<int32_t>();
+    float* grad_feat_ptr = grad_feat.data_ptr<float>();
+    at::parallel_for(0, lengths.numel(), INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            int64_t start = start_ptr[idx];
+            const int32_t* g = geom_ptr + start * GEOM_DIM;
+            int64_t bev = ((static_cast<int64_t>(g[GEOM_B_IDX]) * d + g[GEOM_D_IDX]) * h + g[GEOM_H_IDX]) * w +
+                          g[GEOM_W_IDX];
+            for (int64_t i = start; i < start + length_ptr[idx]; ++i) {
+                AddRow(grad_feat_ptr + i * c, grad_ptr + bev * c, c);
+            }
+        }
+    });
+    return grad_feat.to(grad_out.scalar_type());
+}
+
+at::Tensor bev_pool_v2_cpu(const at::Tensor& depth, const at::Tensor& feat, const at::Tensor& ranks_depth,
+    const at::Tensor& ranks_feat, const at::Tensor& ranks_bev, const at::Tensor& interval_lengths,
+    const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w)
+{
+    auto c = feat.size(4);
+    auto depth_f = ToFloat(depth);
+    auto feat_f = ToFloat(feat);
+    auto rd = ToInt(ranks_depth);
+    auto rf = ToInt(ranks_feat);
+    auto rb = ToInt(ranks_bev);
+    auto lengths = ToInt(interval_lengths);
+    auto starts = ToInt(interval_starts);
+    auto out = at::zeros({b, d, h, w, c}, feat_f.options());
+
+    const float* depth_ptr = depth_f.data_ptr<float>();
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    const int32_t* rd_ptr = rd.data_ptr<int32_t>();
+    const int32_t* rf_ptr = rf.data_ptr<int32_t>();
+    const int32_t* rb_ptr = rb.data_ptr<int32_t>();
+    const int32_t* length_ptr = lengths.data_ptr<int32_t>();
+    const int32_t* start_ptr = starts.data_ptr<int32_t>();
+    float* out_ptr = out.data_ptr<float>();
+    at::parallel_for(0, lengths.numel(), INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            int64_t start = start_ptr[idx];
+            float* out_row = out_ptr + static_cast<int64_t>(rb_ptr[start]) * c;
+            for (int64_t i = start; i < start + length_ptr[idx]; ++i) {
+                Axpy(out_row, feat_ptr + static_cast<int64_t>(rf_ptr[i]) * c, depth_ptr[rd_ptr[i]], c);
+            }
+        }
+    });
+    return out.to(feat.scalar_type());
+}
+
+std::tuple<at::Tensor, at::Tensor> bev_pool_v2_backward_cpu(const at::Tensor& grad_out, const at::Tensor& depth,
+    const at::Tensor& feat, const at::Tensor& ranks_depth, const at::Tensor& ranks_feat, const at::Tensor& ranks_bev,
+    const at::Tensor& interval_lengths, const at::Tensor& interval_starts)
+{
+    auto c = feat.size(4);
+    auto grad_f = ToFloat(grad_out);
+    auto depth_f = ToFloat(depth);
+    auto feat_f = ToFloat(feat);
+    auto rd = ToInt(ranks_depth);
+    auto rf = ToInt(ranks_feat);
+    auto rb = ToInt(ranks_bev);
+    auto lengths = ToInt(interval_lengths);
+    auto starts = ToInt(interval_starts);
+    auto grad_depth = at::zeros(depth.sizes(), depth_f.options());
+    auto grad_feat = at::zeros(feat.sizes(), feat_f.options());
+
+    const float* grad_ptr = grad_f.data_ptr<float>();
+    const float* depth_ptr = depth_f.data_ptr<float>();
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    const int32_t* rd_ptr = rd.data_ptr<int32_t>();
+    const int32_t* rf_ptr = rf.data_ptr<int32_t>();
+    const int32_t* rb_ptr = rb.data_ptr<int32_t>();
+    const int32_t* length_ptr = lengths.data_ptr<int32_t>();
+    const int32_t* start_ptr = starts.data_ptr<int32_t>();
+    float* grad_depth_ptr = grad_depth.data_ptr<float>();
+    float* grad_feat_ptr = grad_feat.data_ptr<float>();
+    // 反向的区间按ranks_feat划分，每个区间独占一行grad_feat
+    at::parallel_for(0, lengths.numel(), INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            int64_t start = start_ptr[idx];
+            int64_t feat_offset = static_cast<int64_t>(rf_ptr[start]) * c;
+            for (int64_t i = start; i < start + length_ptr[idx]; ++i) {
+                const float* grad_row = grad_ptr + static_cast<int64_t>(rb_ptr[i]) * c;
+                grad_depth_ptr[rd_ptr[i]] = Dot(grad_row, feat_ptr + feat_offset, c);
+                Axpy(grad_feat_ptr + feat_offset, grad_row, depth_ptr[rd_ptr[i]], c);
+            }
+        }
+    });
+    return std::make_tuple(grad_depth.to(depth.scalar_type()), grad_feat.to(feat.scalar_type()));
+}
+
+at::Tensor bev_pool_v3_cpu(const c10::optional<at::Tensor>& depth, const at::Tensor& feat,
+    const c10::optional<at::Tensor>& ranks_depth, const c10::optional<at::Tensor>& ranks_feat,
+    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w, bool depth_softmax)
+{
+    bool with_depth = depth.has_value();
+    auto c = feat.size(-1);
+    auto feat_f = ToFloat(feat);
+    auto rb = ToInt(ranks_bev);
+    auto out = at::zeros({b, d, h, w, c}, feat_f.options());
+    // v3的ranks_bev无序，先按ranks_bev稳定排序得到每个bev格子的连续段
+    std::vector<int64_t> order;
+    std::vector<int64_t> run_starts;
+    BuildRuns(rb, order, run_starts);
+
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    const int32_t* rb_ptr = rb.data_ptr<int32_t>();
+    float* out_ptr = out.data_ptr<float>();
+    int64_t num_runs = static_cast<int64_t>(run_starts.size()) - 1;
+    if (!with_depth) {
+        at::parallel_for(0, num_runs, INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+            for (int64_t run = begin; run < end; ++run) {
+                float* out_row = out_ptr + static_cast<int64_t>(rb_ptr[order[run_starts[run]]]) * c;
+                for (int64_t i = run_starts[run]; i < run_starts[run + 1]; ++i) {
+                    AddRow(out_row, feat_ptr + order[i] * c, c);
+                }
+            }
+        });
+        return out.to(feat.scalar_type());
+    }
+
+    auto depth_f = ToFloat(depth.value());
+    at::Tensor lse;
+    if (depth_softmax) {
+        lse = at::logsumexp(depth_f, {DEPTH_DIM}).contiguous();
+    }
+    auto rd = ToInt(ranks_depth.value());
+    auto rf = ToInt(ranks_feat.value());
+    const float* depth_ptr = depth_f.data_ptr<float>();
+    const float* lse_ptr = depth_softmax ? lse.data_ptr<float>() : nullptr;
+    const int32_t* rd_ptr = rd.data_ptr<int32_t>();
+    const int32_t* rf_ptr = rf.data_ptr<int32_t>();
+    at::parallel_for(0, num_runs, INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t run = begin; run < end; ++run) {
+            float* out_row = out_ptr + static_cast<int64_t>(rb_ptr[order[run_starts[run]]]) * c;
+            for (int64_t i = run_starts[run]; i < run_starts[run + 1]; ++i) {
+                int64_t k = order[i];
+                float alpha = depth_ptr[rd_ptr[k]];
+                if (depth_softmax) {
+                    alpha = std::exp(alpha - lse_ptr[rf_ptr[k]]);
+                }
+                Axpy(out_row, feat_ptr + static_cast<int64_t>(rf_ptr[k]) * c, alpha, c);
+            }
+        }
+    });
+    return out.to(feat.scalar_type());
+}
+
+std::tuple<c10::optional<at::Tensor>, at::Tensor> bev_pool_v3_backward_cpu(const at::Tensor& grad_out,
+    const c10::optional<at::Tensor>& depth, const at::Tensor& feat, const c10::optional<at::Tensor>& ranks_depth,
+    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev, bool depth_softmax)
+{
+    bool with_depth = depth.has_value();
+    auto c = feat.size(-1);
+    auto grad_f = ToFloat(grad_out);
+    auto rb = ToInt(ranks_bev);
+    auto grad_feat = at::zeros(feat.sizes(), grad_f.options());
+    const float* grad_ptr = grad_f.data_ptr<float>();
+    const int32_t* rb_ptr = rb.data_ptr<int32_t>();
+    float* grad_feat_ptr = grad_feat.data_ptr<float>();
+    if (!with_depth) {
+        at::parallel_for(0, rb.numel(), POINT_GRAIN, [&](int64_t begin, int64_t end) {
+            for (int64_t k = begin; k < end; ++k) {
+                AddRow(grad_feat_ptr + k * c, grad_ptr + static_cast<int64_t>(rb_ptr[k]) * c, c);
+            }
+        });
+        return std::make_tuple(c10::optional<at::Tensor>(), grad_feat.to(feat.scalar_type()));
+    }
+
+    auto feat_f = ToFloat(feat);
+    auto depth_f = ToFloat(depth.value());
+    auto prob = depth_softmax ? at::softmax(depth_f, DEPTH_DIM).contiguous() : depth_f;
+    auto rd = ToInt(ranks_depth.value());
+    auto rf = ToInt(ranks_feat.value());
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    const float* prob_ptr = prob.data_ptr<float>();
+    const int32_t* rd_ptr = rd.data_ptr<int32_t>();
+    const int32_t* rf_ptr = rf.data_ptr<int32_t>();
+
+    // grad_depth: 每个rank独立计算点积后按ranks_depth归约
+    auto rank_grad = at::empty({rb.numel()}, grad_f.options());
+    float* rank_grad_ptr = rank_grad.data_ptr<float>();
+    at::parallel_for(0, rb.numel(), POINT_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; ++k) {
+            rank_grad_ptr[k] = Dot(grad_ptr + static_cast<int64_t>(rb_ptr[k]) * c,
+                feat_ptr + static_cast<int64_t>(rf_ptr[k]) * c, c);
+        }
+    });
+    auto grad_depth = at::zeros({depth_f.numel()}, grad_f.options()).index_add_(0, rd.to(at::kLong), rank_grad);
+    grad_depth = grad_depth.view(depth_f.sizes());
+
+    // grad_feat: 按ranks_feat划分连续段，每段独占一行
+    std::vector<int64_t> order;
+    std::vector<int64_t> run_starts;
+    BuildRuns(rf, order, run_starts);
+    int64_t num_runs = static_cast<int64_t>(run_starts.size()) - 1;
+    at::parallel_for(0, num_runs, INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t run = begin; run < end; ++run) {
+            float* grad_feat_row = grad_feat_ptr + static_cast<int64_t>(rf_ptr[order[run_starts[run]]]) * c;
+            for (int64_t i = run_starts[run]; i < run_starts[run + 1]; ++i) {
+                int64_t k = order[i];
+                Axpy(grad_feat_row, grad_ptr + static_cast<int64_t>(rb_ptr[k]) * c, prob_ptr[rd_ptr[k]], c);
+            }
+        }
+    });
+    if (depth_softmax) {
+        grad_depth = at::_softmax_backward_data(grad_depth, prob, DEPTH_DIM, at::kFloat);
+    }
+    return std::make_tuple(c10::optional<at::Tensor>(grad_depth.to(depth.value().scalar_type())),
+        grad_feat.to(feat.scalar_type()));
+}
+
+std::tuple<at::Tensor&, at::Tensor&> voxel_pooling_train_cpu(const at::Tensor& inputFeatures, const at::Tensor& geom,
+    at::Tensor& outputFeatures, at::Tensor& posMemo, int batchSize, int numPoints, int numChannels, int numVoxelX,
+    int numVoxelY, int numVoxelZ)
+{
+    auto feat_f = ToFloat(inputFeatures);
+    auto geom_i = ToInt(geom);
+    auto keys = at::empty({static_cast<int64_t>(batchSize) * numPoints}, geom_i.options().dtype(at::kLong));
+    auto pos = at::full({batchSize, numPoints, VOXEL_INDICES_NUM}, -1, geom_i.options());
+    const int32_t* geom_ptr = geom_i.data_ptr<int32_t>();
+    int64_t* key_ptr = keys.data_ptr<int64_t>();
+    int32_t* pos_ptr = pos.data_ptr<int32_t>();
+    at::parallel_for(0, keys.numel(), POINT_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            const int32_t* g = geom_ptr + idx * VOXEL_INDICES_NUM;
+            key_ptr[idx] = -1;
+            if (g[0] < 0 || g[0] >= numVoxelX || g[1] < 0 || g[1] >= numVoxelY || g[2] < 0 || g[2] >= numVoxelZ) {
+                continue;
+            }
+            int32_t batch_idx = static_cast<int32_t>(idx / numPoints);
+            key_ptr[idx] = (static_cast<int64_t>(batch_idx) * numVoxelY + g[1]) * numVoxelX + g[0];
+            pos_ptr[idx * VOXEL_INDICES_NUM] = batch_idx;
+            pos_ptr[idx * VOXEL_INDICES_NUM + 1] = g[1];
+            pos_ptr[idx * VOXEL_INDICES_NUM + 2] = g[0];
+        }
+    });
+
+    std::vector<int64_t> order;
+    std::vector<int64_t> run_starts;
+    BuildRuns(keys, order, run_starts);
+    auto out = at::zeros({batchSize, numVoxelY, numVoxelX, numChannels}, feat_f.options());
+    const float* feat_ptr = feat_f.data_ptr<float>();
+    float* out_ptr = out.data_ptr<float>();
+    int64_t num_runs = static_cast<int64_t>(run_starts.size()) - 1;
+    at::parallel_for(0, num_runs, INTERVAL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t run = begin; run < end; ++run) {
+            float* out_row = out_ptr + key_ptr[order[run_starts[run]]] * numChannels;
+            for (int64_t i = run_starts[run]; i < run_starts[run + 1]; ++i) {
+                AddRow(out_row, feat_ptr + order[i] * numChannels, numChannels);
+            }
+        }
+    });
+    outputFeatures.copy_(out);
+    posMemo.copy_(pos);
+    return {posMemo, outputFeatures};
+}
+
+at::Tensor voxel_pool_train_backward_cpu(const at::Tensor& gradOut, const at::Tensor& posMemo,
+    const int64_t batchSize, const int64_t numPoints, const int64_t numChannels, const int64_t h, const int64_t w)
+{
+    auto grad_f = ToFloat(gradOut.permute({0, 2, 3, 1}));
+    auto pos = ToInt(posMemo);
+    auto grad_in = at::zeros({batchSize, numPoints, numChannels}, grad_f.options());
+    const float* grad_ptr = grad_f.data_ptr<float>();
+    const int32_t* pos_ptr = pos.data_ptr<int32_t>();
+    float* grad_in_ptr = grad_in.data_ptr<float>();
+    at::parallel_for(0, batchSize * numPoints, POINT_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+            const int32_t* p = pos_ptr + idx * VOXEL_INDICES_NUM;
+            if (p[0] < 0) {
+                continue;
+            }
+            int64_t offset = ((static_cast<int64_t>(p[0]) * h + p[1]) * w + p[2]) * numChannels;
+            AddRow(grad_in_ptr + idx * numChannels, grad_ptr + offset, numChannels);
+        }
+    });
+    return grad_in.to(gradOut.scalar_type());
+}
@@ -0,0 +1,236 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+constexpr int64_t COOR_DIM = 6;
+constexpr int64_t GRID_DIM = 3;
+constexpr size_t MAX_CACHE_ENTRIES = 16;
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+constexpr int64_t LOW_WORD_MASK = 0xFFFFFFFFLL;
+// 2^31 - 1，32位字与小于该值的系数相乘不会溢出int64，取模后的逐元素求和在2^32个元素内也不会溢出
+constexpr int64_t CHECKSUM_MOD = 2147483647LL;
+constexpr int64_t CHECKSUM_MUL_A = 48271;
+constexpr int64_t CHECKSUM_MUL_B = 69621;
+
+struct RanksCache {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::vector<at::Tensor>> tables;
+    std::deque<uint64_t> order;
+};
+
+// 缓存中持有device上的tensor，不在进程退出时析构，避免晚于device释放
+RanksCache& GetRanksCache()
+{
+    static auto* cache = new RanksCache();
+    return *cache;
+}
+
+void HashBytes(uint64_t& hash, const void* data, size_t len)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+template<typename T>
+void HashValue(uint64_t& hash, const T& value)
+{
+    HashBytes(hash, &value, sizeof(T));
+}
+
+/**
+ * 标定参数的数值在其所在device上计算两个按位校验和，只拷回两个标量：
+ * 每个数值转为float后取其32位字，第i个字乘以与位置相关的系数后对质数取模再求和
+ */
+void HashCalibValues(uint64_t& hash, const std::vector<at::Tensor>& calib)
+{
+    if (calib.empty()) {
+        return;
+    }
+    std::vector<at::Tensor> flat;
+    flat.reserve(calib.size());
+    for (const auto& t : calib) {
+        flat.push_back(t.detach().reshape({-1}).to(calib[0].device(), at::kFloat));
+    }
+    at::Tensor words = at::cat(flat).view(at::kInt).to(at::kLong).bitwise_and(LOW_WORD_MASK);
+    at::Tensor pos = at::arange(1, words.numel() + 1, words.options());
+    at::Tensor sum_a = (words * (pos * CHECKSUM_MUL_A).remainder(CHECKSUM_MOD)).remainder(CHECKSUM_MOD).sum();
+    at::Tensor sum_b = (words * (pos * CHECKSUM_MUL_B).remainder(CHECKSUM_MOD)).remainder(CHECKSUM_MOD).sum();
+    at::Tensor sums = at::stack({sum_a, sum_b}).cpu();
+    const int64_t* sums_ptr = sums.data_ptr<int64_t>();
+    HashValue(hash, sums_ptr[0]);
+    HashValue(hash, sums_ptr[1]);
+}
+
+// 以标定参数(内外参、数据增强矩阵等)的数值及体素网格参数作为key，标定不变时ranks表不变
+uint64_t CalibKey(const std::vector<at::Tensor>& calib, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const auto& t : calib) {
+        HashValue(hash, static_cast<int32_t>(t.scalar_type()));
+        HashValue(hash, static_cast<int32_t>(t.device().type()));
+        HashValue(hash, static_cast<int32_t>(t.device().index()));
+        for (auto s : t.sizes()) {
+            HashValue(hash, s);
+        }
+    }
+    HashCalibValues(hash, calib);
+    for (auto v : grid_lower_bound) {
+        HashValue(hash, v);
+    }
+    for (auto v : grid_interval) {
+        HashValue(hash, v);
+    }
+    for (auto v : grid_size) {
+        HashValue(hash, v);
+    }
+    return hash;
+}
+
+// 与BEVDet中voxel_pooling_prepare_v2一致：过滤网格外的点，按ranks_bev排序并计算区间
+std::vector<at::Tensor> BuildRanks(const at::Tensor& coor, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size)
+{
+    auto coor_size = coor.sizes();
+    int64_t b = coor_size[0];
+    int64_t n = coor_size[1];
+    int64_t d = coor_size[2];
+    int64_t h = coor_size[3];
+    int64_t w = coor_size[4];
+    int64_t num_points = b * n * d * h * w;
+    auto int_options = coor.options().dtype(at::kInt);
+    auto long_options = coor.options().dtype(at::kLong);
+
+    auto ranks_depth = at::arange(num_points, int_options);
+    auto ranks_feat = at::arange(b * n * h * w, int_options).reshape({b, n, 1, h, w}).expand({b, n, d, h, w}).reshape(
+        {-1});
+
+    auto lower = at::tensor(grid_lower_bound, coor.options().dtype(at::kFloat));
+    auto interval = at::tensor(grid_interval, coor.options().dtype(at::kFloat));
+    auto grid = ((coor.reshape({num_points, GRID_DIM}).to(at::kFloat) - lower) / interval).to(at::kLong);
+    auto batch_idx = at::arange(b, long_options).reshape({b, 1}).expand({b, num_points / b}).reshape({-1});
+
+    auto x = grid.select(1, 0);
+    auto y = grid.select(1, 1);
+    auto z = grid.select(1, 2);
+    auto kept = (x >= 0) & (x < grid_size[0]) & (y >= 0) & (y < grid_size[1]) & (z >= 0) & (z < grid_size[2]);
+
+    auto ranks_bev = batch_idx * (grid_size[2] * grid_size[1] * grid_size[0]) + z * (grid_size[1] * grid_size[0]) +
+                     y * grid_size[0] + x;
+    ranks_bev = ranks_bev.masked_select(kept);
+    ranks_depth = ranks_depth.masked_select(kept);
+    ranks_feat = ranks_feat.masked_select(kept);
+    TORCH_CHECK(ranks_bev.numel() > 0, "No frustum point falls inside the BEV grid.");
+
+    auto order = ranks_bev.argsort();
+    ranks_bev = ranks_bev.index_select(0, order).to(at::kInt);
+    ranks_depth = ranks_depth.index_select(0, order);
+    ranks_feat = ranks_feat.index_select(0, order);
+
+    int64_t num_ranks = ranks_bev.numel();
+    auto is_start = at::ones({num_ranks}, coor.options().dtype(at::kBool));
+    is_start.narrow(0, 1, num_ranks - 1).copy_(ranks_bev.narrow(0, 1, num_ranks - 1) !=
+                                               ranks_bev.narrow(0, 0, num_ranks - 1));
+    auto interval_starts = at::nonzero(is_start).reshape({-1}).to(at::kInt);
+    auto interval_ends = at::cat({interval_starts.narrow(0, 1, interval_starts.numel() - 1),
+        at::full({1}, num_ranks, int_options)});
+    auto interval_lengths = interval_ends - interval_starts;
+
+    return {ranks_bev.contiguous(), ranks_depth.contiguous(), ranks_feat.contiguous(), interval_starts.contiguous(),
+        interval_lengths.contiguous()};
+}
+} // namespace
+
+/**
+ * @brief 计算标定参数与体素网格参数对应的缓存key，标定参数在device上时会同步一次
+ * @param calib: 标定参数列表
+ * @param grid_lower_bound: 体素网格下界(x, y, z)
+ * @param grid_interval: 体素大小(x, y, z)
+ * @param grid_size: 体素网格大小(x, y, z)
+ * @return 缓存key
+ */
+int64_t npu_bev_pool_precompute_key(const std::vector<at::Tensor>& calib, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size)
+{
+    TORCH_CHECK(grid_lower_bound.size() == GRID_DIM && grid_interval.size() == GRID_DIM &&
+                    grid_size.size() == GRID_DIM,
+        "grid_lower_bound, grid_interval and grid_size must have 3 elements.");
+    return static_cast<int64_t>(CalibKey(calib, grid_lower_bound, grid_interval, grid_size));
+}
+
+/**
+ * @brief 预计算bev_pool_v2/bev_pool_v3所需的ranks表并按缓存key缓存
+ * @param coor: 视锥点在自车坐标系下的坐标，6D tensor(b, n, d, h, w, 3)，命中缓存时可为空
+ * @param cache_key: npu_bev_pool_precompute_key返回的缓存key，为空时不查询也不写入缓存
+ * @param grid_lower_bound: 体素网格下界(x, y, z)
+ * @param grid_interval: 体素大小(x, y, z)
+ * @param grid_size: 体素网格大小(x, y, z)
+ * @return ranks_bev, ranks_depth, ranks_feat, interval_starts, interval_lengths; 未命中且coor为空时返回空列表
+ */
+std::vector<at::Tensor> npu_bev_pool_precompute(const c10::optional<at::Tensor>& coor,
+    c10::optional<int64_t> cache_key, const std::vector<double>& grid_lower_bound,
+    const std::vector<double>& grid_interval, const std::vector<int64_t>& grid_size)
+{
+    TORCH_CHECK(grid_lower_bound.size() == GRID_DIM && grid_interval.size() == GRID_DIM &&
+                    grid_size.size() == GRID_DIM,
+        "grid_lower_bound, grid_interval and grid_size must have 3 elements.");
+    auto& cache = GetRanksCache();
+    uint64_t key = cache_key.has_value() ? static_cast<uint64_t>(cache_key.value()) : 0;
+    if (cache_key.has_value()) {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.tables.find(key);
+        if (it != cache.tables.end()) {
+            return it->second;
+        }
+    }
+    if (!coor.has_value()) {
+        return {};
+    }
+    const auto& coor_value = coor.value();
+    TORCH_CHECK(coor_value.dim() == COOR_DIM && coor_value.size(COOR_DIM - 1) == GRID_DIM,
+        "coor must be a 6D tensor with shape [B, N, D, H, W, 3].");
+    auto tables = BuildRanks(coor_value, grid_lower_bound, grid_interval, grid_size);
+    if (cache_key.has_value()) {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (cache.tables.emplace(key, tables).second) {
+            cache.order.push_back(key);
+        }
+        while (cache.order.size() > MAX_CACHE_ENTRIES) {
+            cache.tables.erase(cache.order.front());
+            cache.order.pop_front();
+        }
+    }
+    return tables;
+}
+
+void npu_bev_pool_precompute_clear_cache()
+{
+    auto& cache = GetRanksCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.tables.clear();
+    cache.order.clear();
+}
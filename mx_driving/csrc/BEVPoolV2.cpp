@@ -54,6 +54,10 @@ at::Tensor npu_bev_pool_v2(const at::Tensor& depth, const at::Tensor& feat, cons
     const at::Tensor& ranks_feat, const at::Tensor& ranks_bev, const at::Tensor& interval_lengths,
     const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w)
 {
+    if (feat.device().is_cpu()) {
+        return bev_pool_v2_cpu(
+            depth, feat, ranks_depth, ranks_feat, ranks_bev, interval_lengths, interval_starts, b, d, h, w);
+    }
     check_npu(depth, feat, ranks_depth, ranks_feat, ranks_bev, interval_lengths, interval_starts);
     auto c = feat.size(C_IDX);
     auto out = at::zeros({b, d, h, w, c}, feat.options());
@@ -54,6 +54,10 @@ std::tuple<at::Tensor, at::Tensor> npu_bev_pool_v2_backward(const at::Tensor& gr
     const at::Tensor& feat, const at::Tensor& ranks_depth, const at::Tensor& ranks_feat, const at::Tensor& ranks_bev,
     const at::Tensor& interval_lengths, const at::Tensor& interval_starts, int64_t b, int64_t d, int64_t h, int64_t w)
 {
+    if (feat.device().is_cpu()) {
+        return bev_pool_v2_backward_cpu(
+            grad_out, depth, feat, ranks_depth, ranks_feat, ranks_bev, interval_lengths, interval_starts);
+    }
     check_npu(depth, feat, ranks_depth, ranks_feat, ranks_bev, interval_lengths, interval_starts);
     auto depth_sizes = depth.sizes();
     auto feat_sizes = feat.sizes();
@@ -20,18 +20,36 @@
 namespace {
 constexpr int64_t C_IDX = 1;
 constexpr int64_t C_IDX_WITH_DEPTH = 4;
+constexpr int64_t DEPTH_DIM = 2;
+// kernel按32B对齐搬运depth_lse，尾部预留一个block避免越界读取
+constexpr int64_t LSE_PAD = 8;
 } // namespace
 
 at::Tensor npu_bev_pool_v3(const c10::optional<at::Tensor>& depth, const at::Tensor& feat,
     const c10::optional<at::Tensor>& ranks_depth, const c10::optional<at::Tensor>& ranks_feat,
-    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w)
+    const at::Tensor& ranks_bev, int64_t b, int64_t d, int64_t h, int64_t w, bool depth_softmax)
 {
+    if (feat.device().is_cpu()) {
+        return bev_pool_v3_cpu(depth, feat, ranks_depth, ranks_feat, ranks_bev, b, d, h, w, depth_softmax);
+    }
     TORCH_CHECK_NPU(feat);
     TORCH_CHECK_NPU(ranks_bev);
     bool with_depth = depth.has_value();
+    TORCH_CHECK(!depth_softmax || with_depth, "depth_softmax requires depth.");
     auto c = feat.size(with_depth ? C_IDX_WITH_DEPTH : C_IDX);
-    TORCH_CHECK(c % 8 == 0, "The channel of feature must be multiple of 8.");
-    auto out = at::zeros({b, d, h, w, c}, feat.options());
-    EXEC_NPU_CMD(aclnnBEVPoolV3, depth, feat, ranks_depth, ranks_feat, ranks_bev, with_depth, out);
-    return out;
+    auto dtype = feat.scalar_type();
+    TORCH_CHECK(dtype == at::kFloat || dtype == at::kHalf || dtype == at::kBFloat16,
+        "feat must be float32, float16 or bfloat16.");
+    TORCH_CHECK(!with_depth || depth.value().scalar_type() == dtype, "depth and feat must have the same dtype.");
+    // depth为logits时只计算每个像素沿D方向的logsumexp([B, N, H, W])，kernel内完成softmax，不生成概率张量
+    c10::optional<at::Tensor> depth_lse;
+    if (depth_softmax) {
+        auto lse = at::logsumexp(depth.value().to(at::kFloat), {DEPTH_DIM}).reshape({-1});
+        depth_lse = at::cat({lse, at::zeros({LSE_PAD}, lse.options())});
+    }
+    // 半精度输入同样以fp32原子累加，最后转换回输入数据类型
+    auto out = at::zeros({b, d, h, w, c}, feat.options().dtype(at::kFloat));
+    EXEC_NPU_CMD(aclnnBEVPoolV3, depth, feat, ranks_depth, ranks_feat, ranks_bev, depth_lse, with_depth, depth_softmax,
+        out);
+    return out.to(dtype);
 }
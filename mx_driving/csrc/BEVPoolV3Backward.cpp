@@ -18,19 +18,43 @@
 #include "csrc/functions.h"
 
 
+namespace {
+constexpr int64_t DEPTH_DIM = 2;
+} // namespace
+
 std::tuple<c10::optional<at::Tensor>, at::Tensor> npu_bev_pool_v3_backward(const at::Tensor& grad_out,
     const c10::optional<at::Tensor>& depth, const at::Tensor& feat, const c10::optional<at::Tensor>& ranks_depth,
-    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev)
+    const c10::optional<at::Tensor>& ranks_feat, const at::Tensor& ranks_bev, bool depth_softmax)
 {
+    if (feat.device().is_cpu()) {
+        return bev_pool_v3_backward_cpu(grad_out, depth, feat, ranks_depth, ranks_feat, ranks_bev, depth_softmax);
+    }
     TORCH_CHECK_NPU(feat);
     TORCH_CHECK_NPU(ranks_bev);
     c10::optional<at::Tensor> grad_depth;
+    c10::optional<at::Tensor> depth_prob = depth;
     bool with_depth = depth.has_value();
+    TORCH_CHECK(!depth_softmax || with_depth, "depth_softmax requires depth.");
+    auto dtype = feat.scalar_type();
+    at::Tensor prob_float;
+    if (depth_softmax) {
+        prob_float = at::softmax(depth.value(), DEPTH_DIM, at::kFloat);
+        depth_prob = prob_float.to(dtype);
+    }
+    // grad_out与各梯度均以fp32计算，最后转换回输入数据类型
+    auto float_options = feat.options().dtype(at::kFloat);
+    if (with_depth) {
+        grad_depth = at::zeros(depth.value().sizes(), float_options);
+    }
+    auto grad_feat = at::zeros(feat.sizes(), float_options);
+    auto grad_out_float = grad_out.to(at::kFloat).contiguous();
+    EXEC_NPU_CMD(aclnnBEVPoolV3Grad, grad_out_float, depth_prob, feat, ranks_depth, ranks_feat, ranks_bev, with_depth,
+        grad_depth, grad_feat);
+    if (depth_softmax) {
+        grad_depth = at::_softmax_backward_data(grad_depth.value(), prob_float, DEPTH_DIM, at::kFloat);
+    }
     if (with_depth) {
-        grad_depth = at::zeros_like(depth.value());
+        grad_depth = grad_depth.value().to(depth.value().scalar_type());
     }
-    auto grad_feat = at::zeros_like(feat);
-    EXEC_NPU_CMD(aclnnBEVPoolV3Grad, grad_out, depth, feat, ranks_depth, ranks_feat, ranks_bev, with_depth, grad_depth,
-        grad_feat);
-    return std::make_tuple(grad_depth, grad_feat);
+    return std::make_tuple(grad_depth, grad_feat.to(dtype));
 }
@@ -0,0 +1,129 @@
+// Copyright (c) OpenMMLab. All rights reserved.
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+namespace {
+constexpr int64_t POINT_DIM = 3;
+
+// 与mmcv及NPU kernel一致：按源点下标顺序选取d2 == 0或min_radius^2 <= d2 < max_radius^2的点，
+// 不足sample_num个时用第一个命中点补齐，无命中时下标全为0
+void BallQueryCpu(const at::Tensor& xyz, const at::Tensor& center_xyz, float min_radius2, float max_radius2,
+    int64_t sample_num, at::Tensor& idx)
+{
+    int64_t b = center_xyz.size(0);
+    int64_t m = center_xyz.size(1);
+    int64_t n = xyz.size(1);
+    const float* source_ptr = xyz.data_ptr<float>();
+    const float* target_ptr = center_xyz.data_ptr<float>();
+    int32_t* idx_ptr = idx.data_ptr<int32_t>();
+
+    at::parallel_for(0, b * m, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+            const float* source = source_ptr + task / m * n * POINT_DIM;
+            const float* target = target_ptr + task * POINT_DIM;
+            int32_t* out = idx_ptr + task * sample_num;
+            int64_t count = 0;
+            for (int64_t j = 0; j < n && count < sample_num; ++j) {
+                float dx = source[j * POINT_DIM] - target[0];
+                float dy = source[j * POINT_DIM + 1] - target[1];
+                float dz = source[j * POINT_DIM + 2] - target[2];
+                float d2 = dx * dx + dy * dy + dz * dz;
+                if (d2 == 0 || (d2 >= min_radius2 && d2 < max_radius2)) {
+                    out[count++] = static_cast<int32_t>(j);
+                }
+            }
+            int32_t first = count == 0 ? 0 : out[0];
+            for (int64_t i = count; i < sample_num; ++i) {
+                out[i] = first;
+            }
+        }
+    });
+}
+} // namespace
+
+/**
+ * @brief 球查询，可同时按查询结果聚合特征
+ * @param xyz: 源点，3D tensor(b, n, 3)
+ * @param center_xyz: 中心点，3D tensor(b, m, 3)
+ * @param features: 待聚合的特征，3D tensor(b, c, n)，为空时只输出下标
+ * @param min_radius: 最小半径
+ * @param max_radius: 最大半径
+ * @param sample_num: 每个中心点的采样数量
+ * @return idx: (b, m, sample_num)，int32；grouped_features: (b, c, m, sample_num)，features为空时为空tensor
+ */
+std::tuple<at::Tensor, at::Tensor> ball_query(const at::Tensor& xyz, const at::Tensor& center_xyz,
+    const c10::optional<at::Tensor>& features, double min_radius, double max_radius, int64_t sample_num)
+{
+    TORCH_CHECK(xyz.dim() == 3 && xyz.size(2) == POINT_DIM, "xyz must be a 3D tensor with shape [B, N, 3].");
+    TORCH_CHECK(center_xyz.dim() == 3 && center_xyz.size(2) == POINT_DIM,
+        "center_xyz must be a 3D tensor with shape [B, M, 3].");
+    TORCH_CHECK(xyz.size(0) == center_xyz.size(0), "xyz and center_xyz must have the same batch size.");
+    TORCH_CHECK(xyz.scalar_type() == center_xyz.scalar_type(), "xyz and center_xyz must have the same dtype.");
+    TORCH_CHECK(xyz.scalar_type() == at::kHalf || xyz.scalar_type() == at::kFloat,
+        "ball_query only support float16 or float32 tensor.");
+    TORCH_CHECK(sample_num > 0, "sample_num must be positive, but got: ", sample_num);
+    TORCH_CHECK(min_radius >= 0 && max_radius >= min_radius, "ball_query requires 0 <= min_radius <= max_radius.");
+    int64_t b = center_xyz.size(0);
+    int64_t m = center_xyz.size(1);
+    int64_t n = xyz.size(1);
+    bool with_features = features.has_value();
+    if (with_features) {
+        const auto& features_value = features.value();
+        TORCH_CHECK(features_value.dim() == 3 && features_value.size(0) == b && features_value.size(2) == n,
+            "features must be a 3D tensor with shape [B, C, N].");
+        TORCH_CHECK(features_value.scalar_type() == xyz.scalar_type(), "features and xyz must have the same dtype.");
+    }
+
+    at::Tensor idx;
+    at::Tensor grouped_features;
+    if (xyz.device().is_cpu()) {
+        idx = at::empty({b, m, sample_num}, xyz.options().dtype(at::kInt));
+        BallQueryCpu(xyz.to(at::kFloat).contiguous(), center_xyz.to(at::kFloat).contiguous(),
+            static_cast<float>(min_radius * min_radius), static_cast<float>(max_radius * max_radius), sample_num, idx);
+        if (with_features) {
+            const auto& features_value = features.value();
+            int64_t c = features_value.size(1);
+            auto gather_idx = idx.view({b, 1, m * sample_num}).expand({b, c, m * sample_num}).to(at::kLong);
+            grouped_features = features_value.gather(2, gather_idx).view({b, c, m, sample_num});
+        } else {
+            grouped_features = at::empty({0}, xyz.options());
+        }
+        return std::tie(idx, grouped_features);
+    }
+
+    TORCH_CHECK_NPU(xyz);
+    TORCH_CHECK_NPU(center_xyz);
+    at::Tensor trans_xyz = xyz.transpose(1, 2).contiguous();
+    at::Tensor center = center_xyz.contiguous();
+    c10::optional<at::Tensor> trans_features;
+    int64_t c = 0;
+    if (with_features) {
+        TORCH_CHECK_NPU(features.value());
+        c = features.value().size(1);
+        trans_features = features.value().transpose(1, 2).contiguous();
+    }
+    idx = at::empty({b, m, sample_num}, xyz.options().dtype(at::kInt));
+    at::Tensor out = with_features ? at::empty({b * m * sample_num, c}, xyz.options()) : at::empty({0}, xyz.options());
+    int32_t sample_num_attr = static_cast<int32_t>(sample_num);
+    EXEC_NPU_CMD(aclnnBallQuery, trans_xyz, center, trans_features, min_radius, max_radius, sample_num_attr,
+        with_features, idx, out);
+    grouped_features = with_features ? out.view({b, m, sample_num, c}).permute({0, 3, 1, 2}) : out;
+    return std::tie(idx, grouped_features);
+}
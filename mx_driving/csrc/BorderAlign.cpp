@@ -14,13 +14,72 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "csrc/BorderAlignCpu.h"
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+namespace {
+constexpr int64_t SIDES = 4;
+
+void CheckBorderAlignInput(const at::Tensor& input, const at::Tensor& rois, int64_t pooled_size)
+{
+    TORCH_CHECK(input.dim() == 4, "input must be 4D tensor (B, 4C, H, W)");
+    TORCH_CHECK(input.size(1) % SIDES == 0, "The number of channels must be divisible by 4.");
+    TORCH_CHECK(rois.dim() == 3 && rois.size(0) == input.size(0) && rois.size(1) == input.size(2) * input.size(3) &&
+                    rois.size(2) == 4,
+        "rois must be 3D tensor (B, H * W, 4)");
+    TORCH_CHECK(pooled_size > 0, "pooled_size must be positive");
+}
+} // namespace
+
+/**
+ * @brief border_align前向，输出每条边全部pooled_size + 1个采样点的特征
+ * @param input: (B, 4C, H, W)，float32/float16/bfloat16，kernel以float32计算
+ * @param rois: (B, H * W, 4)
+ * @param output: (B, H * W, pooled_size + 1, 4C)，float32
+ */
 void border_align(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output, int32_t pooled_size)
 {
-    TORCH_CHECK(input.size(1) % 4 == 0, "The number of channels must be divisible by 4.");
-    at::Tensor feature_map = input.permute({0, 2, 3, 1}).contiguous();
-    at::Tensor rois_map = rois.contiguous();
-    EXEC_NPU_CMD(aclnnBorderAlign, feature_map, rois_map, pooled_size, output);
+    CheckBorderAlignInput(input, rois, pooled_size);
+    if (input.device().is_cpu()) {
+        border_align_forward_cpu(input, rois, output, pooled_size);
+        return;
+    }
+    TORCH_CHECK_NPU(input);
+    at::Tensor feature_map = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor rois_map = rois.to(at::kFloat).contiguous();
+    if (output.scalar_type() == at::kFloat) {
+        EXEC_NPU_CMD(aclnnBorderAlign, feature_map, rois_map, pooled_size, output);
+        return;
+    }
+    at::Tensor result = at::zeros(output.sizes(), output.options().dtype(at::kFloat));
+    EXEC_NPU_CMD(aclnnBorderAlign, feature_map, rois_map, pooled_size, result);
+    output.copy_(result);
+}
+
+/**
+ * @brief border_align前向，直接输出每条边采样点上的max与argmax
+ * @param input: (B, 4C, H, W)，float32/float16/bfloat16，C不要求对齐；NPU上kernel在UB上维护max与argmax
+ * @param rois: (B, H * W, 4)
+ * @return output: (B, C, H * W, 4)，与input同精度；argmax_idx: 同形状，int32，为border_align_backward的输入
+ */
+std::tuple<at::Tensor, at::Tensor> border_align_max(const at::Tensor& input, const at::Tensor& rois,
+    int32_t pooled_size)
+{
+    CheckBorderAlignInput(input, rois, pooled_size);
+    if (input.device().is_cpu()) {
+        return border_align_max_cpu(input, rois, pooled_size);
+    }
+    TORCH_CHECK_NPU(input);
+    int64_t batch = input.size(0);
+    int64_t channels = input.size(1) / SIDES;
+    int64_t num_pixels = input.size(2) * input.size(3);
+    at::Tensor feature_map = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor rois_map = rois.to(at::kFloat).contiguous();
+    at::Tensor output = at::empty({batch, num_pixels, SIDES, channels}, feature_map.options());
+    at::Tensor argmax_idx = at::empty({batch, num_pixels, SIDES, channels}, feature_map.options().dtype(at::kInt));
+    EXEC_NPU_CMD(aclnnBorderAlignMax, feature_map, rois_map, pooled_size, output, argmax_idx);
+    // kernel按像素写出四条边的max，转为(B, C, H * W, 4)
+    return std::make_tuple(output.permute({0, 3, 1, 2}).contiguous().to(input.scalar_type()),
+        argmax_idx.permute({0, 3, 1, 2}).contiguous());
 }
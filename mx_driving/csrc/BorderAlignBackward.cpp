@@ -14,27 +14,41 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "csrc/BorderAlignCpu.h"
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+/**
+ * @brief border_align反向，按argmax把梯度回传到对应采样点的双线性插值像素
+ * @param grad_out: (B, C, H * W, 4)，float32/float16/bfloat16，kernel以float32计算
+ * @param boxes: (B, H * W, 4)
+ * @param argmax_idx: (B, C, H * W, 4)，int32
+ * @return grad_input: (B, 4C, H, W)，与grad_out同精度
+ */
 at::Tensor border_align_backward(const at::Tensor& grad_out, const at::Tensor& boxes, const at::Tensor& argmax_idx,
     int32_t pool_size, int32_t height, int32_t width)
 {
-    TORCH_CHECK_NPU(grad_out);
-    TORCH_CHECK_NPU(boxes);
-    TORCH_CHECK_NPU(argmax_idx);
     TORCH_CHECK(grad_out.dim() == 4, "grad_out.dim() must be 4, but got: ", grad_out.dim());
     TORCH_CHECK(boxes.dim() == 3, "idx.dim() must be 3, but got: ", boxes.dim());
     TORCH_CHECK(argmax_idx.dim() == 4, "argmax_idx.dim() must be 4, but got: ", argmax_idx.dim());
+    if (grad_out.device().is_cpu()) {
+        return border_align_backward_cpu(grad_out, boxes, argmax_idx, pool_size, height, width);
+    }
+    TORCH_CHECK_NPU(grad_out);
+    TORCH_CHECK_NPU(boxes);
+    TORCH_CHECK_NPU(argmax_idx);
 
     int32_t batch_size = grad_out.size(0);
     int32_t feat_channels = grad_out.size(1) * 4;
     int32_t channels = grad_out.size(1);
     int32_t box_size = boxes.size(1);
+    auto ori_dtype = grad_out.scalar_type();
+    at::Tensor grad_fp32 = grad_out.to(at::kFloat).contiguous();
+    at::Tensor boxes_fp32 = boxes.to(at::kFloat).contiguous();
 
-    at::Tensor grad_input = at::zeros({batch_size, feat_channels, height, width}, grad_out.options());
+    at::Tensor grad_input = at::zeros({batch_size, feat_channels, height, width}, grad_fp32.options());
 
-    EXEC_NPU_CMD(aclnnBorderAlignGrad, grad_out, boxes, argmax_idx, channels, box_size, height, width, pool_size,
+    EXEC_NPU_CMD(aclnnBorderAlignGrad, grad_fp32, boxes_fp32, argmax_idx, channels, box_size, height, width, pool_size,
         batch_size, grad_input);
-    return grad_input;
+    return grad_input.to(ori_dtype);
 }
@@ -0,0 +1,191 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/BorderAlignCpu.h"
+#include "csrc/CpuBilinear.h"
+#include "csrc/CpuVecUtils.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr int64_t SIDES = 4;
+constexpr int64_t BOX_DIM = 4;
+constexpr int64_t BOX_GRAIN = 16;
+constexpr int64_t PLANE_GRAIN = 1;
+
+using cpu_bilinear::Bilinear;
+using cpu_bilinear::BilinearTap;
+using cpu_bilinear::TAPS;
+using cpu_vec::Axpy;
+
+// 第side条边上第j个采样点：上、左边从(x1, y1)出发，下、右边从(x2, y2)出发，
+// 与kernel一样逐步累加步长，使前向与反向得到完全相同的坐标
+void SamplePoint(const float* box, int64_t side, int64_t j, int64_t pooled_size, float& x, float& y)
+{
+    float dx = (box[2] - box[0]) / static_cast<float>(pooled_size);
+    float dy = (box[3] - box[1]) / static_cast<float>(pooled_size);
+    bool from_end = side >= 2;
+    x = from_end ? box[2] : box[0];
+    y = from_end ? box[3] : box[1];
+    float step_x = side == 0 ? dx : (side == 2 ? -dx : 0.0f);
+    float step_y = side == 1 ? dy : (side == 3 ? -dy : 0.0f);
+    for (int64_t k = 0; k < j; k++) {
+        x += step_x;
+        y += step_y;
+    }
+}
+
+// feat_b为单个batch的NHWC特征，每个像素的4C个通道按(side, C)排列
+void SampleRow(const float* feat_b, const float* box, int64_t side, int64_t j, int64_t pooled_size, int64_t height,
+    int64_t width, int64_t channels, float* val)
+{
+    std::fill(val, val + channels, 0.0f);
+    float x = 0;
+    float y = 0;
+    SamplePoint(box, side, j, pooled_size, x, y);
+    BilinearTap tap;
+    if (!Bilinear(y, x, height, width, tap)) {
+        return;
+    }
+    for (int t = 0; t < TAPS; t++) {
+        Axpy(val, feat_b + (tap.offset[t] * SIDES + side) * channels, tap.weight[t], channels);
+    }
+}
+} // namespace
+
+void border_align_forward_cpu(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output,
+    int64_t pooled_size)
+{
+    int64_t height = input.size(2);
+    int64_t width = input.size(3);
+    int64_t channels = input.size(1) / SIDES;
+    int64_t num_pixels = height * width;
+    int64_t num_boxes = input.size(0) * num_pixels;
+    at::Tensor feature = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor boxes = rois.to(at::kFloat).contiguous();
+    at::Tensor result = at::empty({num_boxes, pooled_size + 1, SIDES, channels}, feature.options());
+
+    const float* feat = feature.data_ptr<float>();
+    const float* box_ptr = boxes.data_ptr<float>();
+    float* out = result.data_ptr<float>();
+    at::parallel_for(0, num_boxes, BOX_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t n = begin; n < end; n++) {
+            const float* feat_b = feat + n / num_pixels * num_pixels * SIDES * channels;
+            for (int64_t j = 0; j <= pooled_size; j++) {
+                for (int64_t side = 0; side < SIDES; side++) {
+                    float* val = out + ((n * (pooled_size + 1) + j) * SIDES + side) * channels;
+                    SampleRow(feat_b, box_ptr + n * BOX_DIM, side, j, pooled_size, height, width, channels, val);
+                }
+            }
+        }
+    });
+    output.copy_(result.view(output.sizes()));
+}
+
+std::tuple<at::Tensor, at::Tensor> border_align_max_cpu(const at::Tensor& input, const at::Tensor& rois,
+    int64_t pooled_size)
+{
+    int64_t batch = input.size(0);
+    int64_t height = input.size(2);
+    int64_t width = input.size(3);
+    int64_t channels = input.size(1) / SIDES;
+    int64_t num_pixels = height * width;
+    at::Tensor feature = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor boxes = rois.to(at::kFloat).contiguous();
+    at::Tensor result = at::empty({batch, channels, num_pixels, SIDES}, feature.options());
+    at::Tensor argmax_idx = at::empty({batch, channels, num_pixels, SIDES}, feature.options().dtype(at::kInt));
+
+    const float* feat = feature.data_ptr<float>();
+    const float* box_ptr = boxes.data_ptr<float>();
+    float* out = result.data_ptr<float>();
+    int32_t* arg = argmax_idx.data_ptr<int32_t>();
+    at::parallel_for(0, batch * num_pixels, BOX_GRAIN, [&](int64_t begin, int64_t end) {
+        std::vector<float> best(channels);
+        std::vector<float> val(channels);
+        std::vector<int32_t> best_idx(channels);
+        for (int64_t n = begin; n < end; n++) {
+            int64_t b = n / num_pixels;
+            int64_t p = n % num_pixels;
+            const float* feat_b = feat + b * num_pixels * SIDES * channels;
+            for (int64_t side = 0; side < SIDES; side++) {
+                SampleRow(feat_b, box_ptr + n * BOX_DIM, side, 0, pooled_size, height, width, channels, best.data());
+                std::fill(best_idx.begin(), best_idx.end(), 0);
+                for (int64_t j = 1; j <= pooled_size; j++) {
+                    SampleRow(feat_b, box_ptr + n * BOX_DIM, side, j, pooled_size, height, width, channels, val.data());
+                    for (int64_t c = 0; c < channels; c++) {
+                        // 相等时保留靠前的采样点
+                        if (val[c] > best[c]) {
+                            best[c] = val[c];
+                            best_idx[c] = static_cast<int32_t>(j);
+                        }
+                    }
+                }
+                for (int64_t c = 0; c < channels; c++) {
+                    int64_t idx = ((b * channels + c) * num_pixels + p) * SIDES + side;
+                    out[idx] = best[c];
+                    arg[idx] = best_idx[c];
+                }
+            }
+        }
+    });
+    return std::make_tuple(result.to(input.scalar_type()), argmax_idx);
+}
+
+at::Tensor border_align_backward_cpu(const at::Tensor& grad_out, const at::Tensor& rois,
+    const at::Tensor& argmax_idx, int64_t pooled_size, int64_t height, int64_t width)
+{
+    int64_t batch = grad_out.size(0);
+    int64_t channels = grad_out.size(1);
+    int64_t num_pixels = grad_out.size(2);
+    at::Tensor grad = grad_out.to(at::kFloat).contiguous();
+    at::Tensor index = argmax_idx.to(at::kInt).contiguous();
+    at::Tensor boxes = rois.to(at::kFloat).contiguous();
+    at::Tensor grad_input = at::zeros({batch, SIDES * channels, height, width}, grad.options());
+
+    const float* grad_ptr = grad.data_ptr<float>();
+    const int32_t* arg = index.data_ptr<int32_t>();
+    const float* box_ptr = boxes.data_ptr<float>();
+    float* grad_in = grad_input.data_ptr<float>();
+    // 按(batch, 边, 通道)平面并行，各线程写入的平面互不重叠
+    at::parallel_for(0, batch * SIDES * channels, PLANE_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; plane++) {
+            int64_t b = plane / (SIDES * channels);
+            int64_t side = plane % (SIDES * channels) / channels;
+            int64_t c = plane % channels;
+            float* dst = grad_in + plane * height * width;
+            for (int64_t p = 0; p < num_pixels; p++) {
+                int64_t idx = ((b * channels + c) * num_pixels + p) * SIDES + side;
+                float g = grad_ptr[idx];
+                if (g == 0.0f) {
+                    continue;
+                }
+                float x = 0;
+                float y = 0;
+                SamplePoint(box_ptr + (b * num_pixels + p) * BOX_DIM, side, arg[idx], pooled_size, x, y);
+                BilinearTap tap;
+                if (!Bilinear(y, x, height, width, tap)) {
+                    continue;
+                }
+                for (int t = 0; t < TAPS; t++) {
+                    dst[tap.offset[t]] += g * tap.weight[t];
+                }
+            }
+        }
+    });
+    return grad_input.to(grad_out.scalar_type());
+}
@@ -15,16 +15,29 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/PolygonOverlapCpu.h"
 #include "csrc/functions.h"
 
 namespace {
 constexpr int64_t N_IDX = 0;
+constexpr int64_t MODE_FLAG_IOU = 0;
+constexpr double EPS_AREA = 1e-14;
 
 void check_npu(const at::Tensor& boxes_a, const at::Tensor& boxes_b)
 {
     TORCH_CHECK_NPU(boxes_a);
     TORCH_CHECK_NPU(boxes_b);
 }
+
+// 与box_iou kernel一致：任一框面积小于1e-14时结果为0
+at::Tensor box_iou_cpu(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const PolygonBoxFormat& format,
+    int64_t mode_flag, bool aligned)
+{
+    PolygonOverlapOptions options;
+    options.mode = mode_flag == MODE_FLAG_IOU ? POLYGON_MODE_IOU : POLYGON_MODE_IOF;
+    options.min_area = EPS_AREA;
+    return polygon_overlap_cpu(boxes_a, boxes_b, format, options, aligned);
+}
 } // namespace
 
 /**
@@ -40,6 +53,9 @@ at::Tensor npu_box_iou_quadri(
 {
     TORCH_CHECK(boxes_a.size(1) == 8, "boxes_a must be 2D tensor (N, 8)");
     TORCH_CHECK(boxes_b.size(1) == 8, "boxes_b must be 2D tensor (N, 8)");
+    if (boxes_a.device().is_cpu()) {
+        return box_iou_cpu(boxes_a, boxes_b, PolygonBoxFormat::Quadri(), mode_flag, aligned);
+    }
     check_npu(boxes_a, boxes_b);
 
     auto boxes_a_num = boxes_a.size(N_IDX);
@@ -66,6 +82,9 @@ at::Tensor npu_box_iou_rotated(
 {
     TORCH_CHECK(boxes_a.size(1) == 5, "boxes_a must be 2D tensor (N, 5)");
     TORCH_CHECK(boxes_b.size(1) == 5, "boxes_b must be 2D tensor (N, 5)");
+    if (boxes_a.device().is_cpu()) {
+        return box_iou_cpu(boxes_a, boxes_b, PolygonBoxFormat::Rotated(false, false), mode_flag, aligned);
+    }
     check_npu(boxes_a, boxes_b);
 
     auto boxes_a_num = boxes_a.size(N_IDX);
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/PolygonOverlapCpu.h"
 #include "csrc/functions.h"
 
 namespace {
@@ -28,6 +29,7 @@ constexpr int32_t UNIT_FLAG_DEGREE = 1;
 constexpr int32_t MODE_FLAG_OVERLAP = 0;
 constexpr int32_t MODE_FLAG_IOU = 1;
 constexpr float PI = 3.14159265358979323846;
+constexpr double EPS = 1e-8;
 
 void check_npu(const at::Tensor& boxes_a, const at::Tensor& boxes_b)
 {
@@ -46,8 +48,6 @@ at::Tensor npu_boxes_overlap_bev(const at::Tensor& boxes_a, const at::Tensor& bo
                                  int32_t format_flag, int32_t unit_flag, bool clockwise,
                                  int32_t mode_flag, bool aligned, double margin)
 {
-    check_npu(boxes_a, boxes_b);
-
     if (format_flag == FORMAT_FLAG_XYXYR || format_flag == FORMAT_FLAG_XYWHR) {
         TORCH_CHECK(boxes_a.size(1) == 5, "boxes_a must be 2D tensor (N, 5)");
         TORCH_CHECK(boxes_b.size(1) == 5, "boxes_b must be 2D tensor (N, 5)");
@@ -56,6 +56,16 @@ at::Tensor npu_boxes_overlap_bev(const at::Tensor& boxes_a, const at::Tensor& bo
         TORCH_CHECK(boxes_b.size(1) == 7, "boxes_b must be 2D tensor (N, 7)");
     }
 
+    if (boxes_a.device().is_cpu()) {
+        // CPU上求精确相交面积，margin仅用于kernel中角点包含判断的容差，不生效
+        PolygonOverlapOptions options;
+        options.mode = mode_flag;
+        options.union_eps = EPS;
+        return polygon_overlap_cpu(
+            boxes_a, boxes_b, PolygonBoxFormat::Bev(format_flag, unit_flag, clockwise), options, aligned);
+    }
+    check_npu(boxes_a, boxes_b);
+
     auto boxes_a_num = boxes_a.size(BOXES_NUM_DIM);
     auto boxes_b_num = boxes_b.size(BOXES_NUM_DIM);
     c10::SmallVector<int64_t, SIZE> output_size = {boxes_a_num};
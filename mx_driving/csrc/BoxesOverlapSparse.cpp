@@ -0,0 +1,212 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/PolygonOverlapCpu.h"
+#include "csrc/functions.h"
+
+#include <cmath>
+
+namespace {
+constexpr int64_t BOX_TYPE_BEV = 0;
+constexpr int64_t BOX_TYPE_ROTATED = 1;
+constexpr int64_t BOX_TYPE_QUADRI = 2;
+constexpr int64_t FORMAT_FLAG_XYXYR = 0;
+constexpr int64_t FORMAT_FLAG_XYZXYZR = 2;
+constexpr int64_t FORMAT_FLAG_XYZWHDR = 3;
+constexpr int64_t UNIT_FLAG_DEGREE = 1;
+constexpr int64_t IOU_MODE_IOU = 0;
+constexpr int64_t QUADRI_DIM = 8;
+constexpr int QUADRI_CORNERS = 4;
+constexpr float BEV_EPS = 1e-8f;
+constexpr float EPS_AREA = 1e-14f;
+constexpr double PI = 3.14159265358979323846;
+
+// 粗筛用的外接圆：圆心与半径，半径已包含margin
+struct BoxCircles {
+    at::Tensor cx;
+    at::Tensor cy;
+    at::Tensor radius;
+};
+
+int64_t BoxDim(int64_t box_type, int64_t format_flag)
+{
+    if (box_type == BOX_TYPE_QUADRI) {
+        return QUADRI_DIM;
+    }
+    if (box_type == BOX_TYPE_BEV && (format_flag == FORMAT_FLAG_XYZXYZR || format_flag == FORMAT_FLAG_XYZWHDR)) {
+        return 7;
+    }
+    return 5;
+}
+
+// bev格式中x1/dx所在列，(x, y)的下一维即为对应的y
+int64_t BevSizeOffset(int64_t format_flag)
+{
+    return (format_flag == FORMAT_FLAG_XYZXYZR || format_flag == FORMAT_FLAG_XYZWHDR) ? 3 : 2;
+}
+
+BoxCircles ComputeCircles(const at::Tensor& boxes, int64_t box_type, int64_t format_flag, double margin)
+{
+    BoxCircles circles;
+    if (box_type == BOX_TYPE_QUADRI) {
+        at::Tensor pts = boxes.view({-1, QUADRI_CORNERS, 2});
+        at::Tensor center = pts.mean(1);
+        circles.cx = center.select(1, 0);
+        circles.cy = center.select(1, 1);
+        circles.radius = (pts - center.unsqueeze(1)).norm(2, -1).amax(1);
+        return circles;
+    }
+    int64_t offset = box_type == BOX_TYPE_BEV ? BevSizeOffset(format_flag) : 2;
+    at::Tensor dx;
+    at::Tensor dy;
+    if (box_type == BOX_TYPE_BEV && (format_flag == FORMAT_FLAG_XYXYR || format_flag == FORMAT_FLAG_XYZXYZR)) {
+        at::Tensor x1 = boxes.select(1, 0);
+        at::Tensor y1 = boxes.select(1, 1);
+        at::Tensor x2 = boxes.select(1, offset);
+        at::Tensor y2 = boxes.select(1, offset + 1);
+        circles.cx = (x1 + x2) * 0.5;
+        circles.cy = (y1 + y2) * 0.5;
+        dx = x2 - x1;
+        dy = y2 - y1;
+    } else {
+        circles.cx = boxes.select(1, 0);
+        circles.cy = boxes.select(1, 1);
+        dx = boxes.select(1, offset);
+        dy = boxes.select(1, offset + 1);
+    }
+    // 绕中心旋转后的框总在外接圆内，与角度及其单位无关
+    circles.radius = at::sqrt(dx * dx + dy * dy) * 0.5 + margin;
+    return circles;
+}
+
+/**
+ * 沿x轴的sort-and-sweep：boxes_b按圆的左端点排序后，boxes_a的每个框只需扫描左端点落在
+ * [a_lo - max(2 * r_b), a_hi]内的一段连续窗口，再用外接圆相交做精筛。
+ * 需要两次host同步：读取候选总数，以及外接圆精筛的nonzero。返回候选对(a_idx, b_idx)。
+ */
+std::tuple<at::Tensor, at::Tensor> SweepCandidates(const BoxCircles& a, const BoxCircles& b)
+{
+    auto index_options = a.cx.options().dtype(at::kLong);
+    at::Tensor b_lo = b.cx - b.radius;
+    at::Tensor b_lo_sorted;
+    at::Tensor b_order;
+    std::tie(b_lo_sorted, b_order) = b_lo.sort();
+    at::Tensor max_extent = (b.radius * 2).max();
+    at::Tensor a_lo = a.cx - a.radius;
+    at::Tensor a_hi = a.cx + a.radius;
+    at::Tensor start = at::searchsorted(b_lo_sorted, a_lo - max_extent);
+    at::Tensor end = at::searchsorted(b_lo_sorted, a_hi, false, true);
+    at::Tensor count = (end - start).clamp_min(0);
+    int64_t total = count.sum().item<int64_t>();
+    if (total == 0) {
+        return std::make_tuple(at::empty({0}, index_options), at::empty({0}, index_options));
+    }
+    at::Tensor a_idx = at::repeat_interleave(count, total);
+    at::Tensor group_start = count.cumsum(0) - count;
+    at::Tensor sorted_pos = start.index_select(0, a_idx) + at::arange(total, index_options) -
+                            group_start.index_select(0, a_idx);
+    at::Tensor b_idx = b_order.index_select(0, sorted_pos);
+
+    at::Tensor dx = a.cx.index_select(0, a_idx) - b.cx.index_select(0, b_idx);
+    at::Tensor dy = a.cy.index_select(0, a_idx) - b.cy.index_select(0, b_idx);
+    at::Tensor r = a.radius.index_select(0, a_idx) + b.radius.index_select(0, b_idx);
+    at::Tensor keep = (dx * dx + dy * dy <= r * r).nonzero().squeeze(1);
+    return std::make_tuple(a_idx.index_select(0, keep), b_idx.index_select(0, keep));
+}
+
+} // namespace
+
+/**
+ * @brief 稀疏的BEV overlap/iou/iof：外接圆粗筛 + 沿x轴sort-and-sweep，只对可能相交的框对做多边形裁剪。
+ *        输出大小取决于数据，device输入共有三次host同步：候选总数、外接圆精筛和结果大于0的筛选
+ * @param boxes_a: 2D tensor(N, D)
+ * @param boxes_b: 2D tensor(M, D)
+ * @param box_type: 0为boxes_overlap_bev的格式，1为box_iou_rotated的(x, y, w, h, angle)，2为box_iou_quadri的4个角点
+ * @param format_flag, unit_flag, clockwise, margin: 仅box_type为0时生效，含义同npu_boxes_overlap_bev
+ * @param mode_flag: 与对应稠密算子一致，box_type为0时0/1/2为overlap/iou/iof，否则0/1为iou/iof
+ * @return indices: (2, K)，int64，按(i, j)升序的相交框对；values: (K)，对应的overlap/iou/iof，均大于0
+ */
+std::tuple<at::Tensor, at::Tensor> boxes_overlap_sparse(const at::Tensor& boxes_a, const at::Tensor& boxes_b,
+    int64_t box_type, int64_t format_flag, int64_t unit_flag, bool clockwise, int64_t mode_flag, double margin)
+{
+    TORCH_CHECK(box_type == BOX_TYPE_BEV || box_type == BOX_TYPE_ROTATED || box_type == BOX_TYPE_QUADRI,
+        "box_type must be 0 (bev), 1 (rotated) or 2 (quadri).");
+    int64_t dim = BoxDim(box_type, format_flag);
+    TORCH_CHECK(boxes_a.dim() == 2 && boxes_a.size(1) == dim, "boxes_a must be 2D tensor (N, ", dim, ")");
+    TORCH_CHECK(boxes_b.dim() == 2 && boxes_b.size(1) == dim, "boxes_b must be 2D tensor (M, ", dim, ")");
+    TORCH_CHECK(boxes_a.scalar_type() == at::kFloat && boxes_b.scalar_type() == at::kFloat,
+        "boxes_overlap_sparse only support float32 tensor.");
+
+    at::Tensor a = boxes_a.contiguous();
+    at::Tensor b = boxes_b.contiguous();
+    auto index_options = a.options().dtype(at::kLong);
+    if (a.size(0) == 0 || b.size(0) == 0) {
+        return std::make_tuple(at::empty({2, 0}, index_options), at::empty({0}, a.options()));
+    }
+    if (box_type == BOX_TYPE_BEV && unit_flag == UNIT_FLAG_DEGREE) {
+        a = a.clone();
+        b = b.clone();
+        a.select(1, dim - 1).mul_(PI / 180);
+        b.select(1, dim - 1).mul_(PI / 180);
+    }
+
+    BoxCircles circles_a = ComputeCircles(a, box_type, format_flag, margin);
+    BoxCircles circles_b = ComputeCircles(b, box_type, format_flag, margin);
+    at::Tensor a_idx;
+    at::Tensor b_idx;
+    std::tie(a_idx, b_idx) = SweepCandidates(circles_a, circles_b);
+    if (a_idx.numel() == 0) {
+        return std::make_tuple(at::empty({2, 0}, index_options), at::empty({0}, a.options()));
+    }
+    // 按(i, j)排序，使输出顺序与设备无关
+    at::Tensor key = a_idx * b.size(0) + b_idx;
+    at::Tensor order = std::get<1>(key.sort());
+    a_idx = a_idx.index_select(0, order);
+    b_idx = b_idx.index_select(0, order);
+
+    at::Tensor values;
+    if (a.device().is_cpu()) {
+        PolygonOverlapOptions options;
+        PolygonBoxFormat format;
+        if (box_type == BOX_TYPE_BEV) {
+            // 角度已统一为弧度
+            format = PolygonBoxFormat::Bev(format_flag, 0, clockwise);
+            options.mode = mode_flag;
+            options.union_eps = BEV_EPS;
+        } else {
+            format =
+                box_type == BOX_TYPE_ROTATED ? PolygonBoxFormat::Rotated(false, false) : PolygonBoxFormat::Quadri();
+            options.mode = mode_flag == IOU_MODE_IOU ? POLYGON_MODE_IOU : POLYGON_MODE_IOF;
+            options.min_area = EPS_AREA;
+        }
+        values = polygon_overlap_pairs_cpu(a, b, a_idx, b_idx, format, options);
+    } else {
+        // 候选对逐对排列后复用稠密算子的aligned模式
+        at::Tensor pair_a = a.index_select(0, a_idx);
+        at::Tensor pair_b = b.index_select(0, b_idx);
+        if (box_type == BOX_TYPE_BEV) {
+            values = npu_boxes_overlap_bev(pair_a, pair_b, static_cast<int32_t>(format_flag), 0, clockwise,
+                static_cast<int32_t>(mode_flag), true, margin);
+        } else if (box_type == BOX_TYPE_ROTATED) {
+            values = npu_box_iou_rotated(pair_a, pair_b, mode_flag, true);
+        } else {
+            values = npu_box_iou_quadri(pair_a, pair_b, mode_flag, true);
+        }
+    }
+    at::Tensor keep = (values > 0).nonzero().squeeze(1);
+    at::Tensor indices = at::stack({a_idx.index_select(0, keep), b_idx.index_select(0, keep)}, 0);
+    return std::make_tuple(indices, values.index_select(0, keep));
+}
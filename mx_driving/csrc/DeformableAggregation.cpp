@@ -17,14 +17,176 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+#include <ATen/Parallel.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr int64_t GROUP_ALIGN = 8;
+constexpr int64_t BYTE_BLOCK = 32;
+constexpr int64_t SIZE_OF_FP32 = 4;
+constexpr int64_t SIZE_OF_FP16 = 2;
+// Atlas A2训练系列产品的ub大小
+constexpr int64_t UB_SIZE = 192 * 1024;
+
+int64_t AlignUp(int64_t value, int64_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+/**
+ * 融合softmax需要一个anchor的全部weight同时驻留在ub中，这里按kernels/op_host/deformable_aggregation.cpp中
+ * memoryFlag相同的ub预算判断，放不下时在调用kernel前完成softmax，避免tiling失败
+ */
+bool CanFuseSoftmax(const at::Tensor& feat, const at::Tensor& weights)
+{
+    auto weights_size = weights.sizes();
+    int64_t num_embeds = feat.size(-1);
+    int64_t num_pts = weights_size[2];
+    int64_t num_cams = weights_size[3];
+    int64_t num_scale = weights_size[4];
+    int64_t num_groups = weights_size[5];
+    if (num_groups % GROUP_ALIGN != 0 || (num_embeds / num_groups) % GROUP_ALIGN != 0) {
+        return false;
+    }
+    bool is_float = feat.scalar_type() == at::kFloat;
+    int64_t c_aligned = AlignUp(num_embeds, BYTE_BLOCK / (is_float ? SIZE_OF_FP32 : SIZE_OF_FP16));
+    int64_t used_ub_size =
+        (16 * 1024 + 6 * c_aligned + num_pts * num_cams * 2 + num_cams * num_scale * 3) * SIZE_OF_FP32;
+    if (!is_float) {
+        used_ub_size += 5 * c_aligned * SIZE_OF_FP16;
+    }
+    used_ub_size += 2 * AlignUp(num_groups, BYTE_BLOCK / SIZE_OF_FP32) * SIZE_OF_FP32;
+    return UB_SIZE - used_ub_size > num_pts * num_cams * num_scale * num_groups * SIZE_OF_FP32;
+}
+
+// softmax在每个group内对num_pts * num_cams * num_scale个weight进行归一化
+at::Tensor SoftmaxWeights(const at::Tensor& weights)
+{
+    auto weights_size = weights.sizes();
+    return at::softmax(weights.reshape({weights_size[0], weights_size[1], -1, weights_size[5]}), 2)
+        .reshape(weights_size)
+        .contiguous();
+}
+
+// 时序版本的CPU参考实现，feat_cache为[num_slots, bs, num_feat, c]，每个anchor从slot_index指定的帧采样
+template<typename scalar_t>
+void DeformableAggregationTemporalCpuKernel(const at::Tensor& feat_cache, const at::Tensor& spatial_shape,
+    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights,
+    const at::Tensor& slot_index, at::Tensor& out)
+{
+    auto num_slots = feat_cache.size(0);
+    auto batch_size = feat_cache.size(1);
+    auto num_feat = feat_cache.size(2);
+    auto num_embeds = feat_cache.size(3);
+    auto num_anchors = weights.size(1);
+    auto num_pts = weights.size(2);
+    auto num_cams = weights.size(3);
+    auto num_scale = weights.size(4);
+    auto num_groups = weights.size(5);
+    auto num_channels = num_embeds / num_groups;
+
+    const scalar_t* feat_ptr = feat_cache.data_ptr<scalar_t>();
+    const int32_t* shape_ptr = spatial_shape.data_ptr<int32_t>();
+    const int32_t* start_ptr = scale_start_index.data_ptr<int32_t>();
+    const float* loc_ptr = sampling_location.data_ptr<float>();
+    const float* weight_ptr = weights.data_ptr<float>();
+    const int32_t* slot_ptr = slot_index.data_ptr<int32_t>();
+    scalar_t* out_ptr = out.data_ptr<scalar_t>();
+
+    at::parallel_for(0, batch_size * num_anchors, 0, [&](int64_t begin, int64_t end) {
+        std::vector<float> acc(num_embeds);
+        for (int64_t task = begin; task < end; ++task) {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            int64_t batch_idx = task / num_anchors;
+            // 与kernel一致，slot_index越界的anchor输出全0
+            int64_t slot = slot_ptr[task];
+            bool valid_slot = slot >= 0 && slot < num_slots;
+            const scalar_t* value =
+                feat_ptr + ((valid_slot ? slot : 0) * batch_size + batch_idx) * num_feat * num_embeds;
+            for (int64_t pts_idx = 0; valid_slot && pts_idx < num_pts; ++pts_idx) {
+                for (int64_t cam_idx = 0; cam_idx < num_cams; ++cam_idx) {
+                    const float* loc = loc_ptr + ((task * num_pts + pts_idx) * num_cams + cam_idx) * 2;
+                    float loc_w = loc[0];
+                    float loc_h = loc[1];
+                    if (loc_w <= 0 || loc_w >= 1 || loc_h <= 0 || loc_h >= 1) {
+                        continue;
+                    }
+                    for (int64_t scale_idx = 0; scale_idx < num_scale; ++scale_idx) {
+                        int64_t level = cam_idx * num_scale + scale_idx;
+                        int64_t h = shape_ptr[level * 2];
+                        int64_t w = shape_ptr[level * 2 + 1];
+                        const scalar_t* level_value = value + start_ptr[level] * num_embeds;
+                        const float* weight =
+                            weight_ptr + (((task * num_pts + pts_idx) * num_cams + cam_idx) * num_scale + scale_idx) *
+                                             num_groups;
+
+                        float h_im = loc_h * h - 0.5f;
+                        float w_im = loc_w * w - 0.5f;
+                        int64_t h_low = static_cast<int64_t>(std::floor(h_im));
+                        int64_t w_low = static_cast<int64_t>(std::floor(w_im));
+                        float lh = h_im - h_low;
+                        float lw = w_im - w_low;
+                        float hh = 1 - lh;
+                        float hw = 1 - lw;
+                        const int64_t corner_h[4] = {h_low, h_low, h_low + 1, h_low + 1};
+                        const int64_t corner_w[4] = {w_low, w_low + 1, w_low, w_low + 1};
+                        const float corner_weight[4] = {hh * hw, hh * lw, lh * hw, lh * lw};
+                        for (int32_t corner = 0; corner < 4; ++corner) {
+                            if (corner_h[corner] < 0 || corner_h[corner] > h - 1 || corner_w[corner] < 0 ||
+                                corner_w[corner] > w - 1) {
+                                continue;
+                            }
+                            const scalar_t* v = level_value + (corner_h[corner] * w + corner_w[corner]) * num_embeds;
+                            for (int64_t group_idx = 0; group_idx < num_groups; ++group_idx) {
+                                float scale = corner_weight[corner] * weight[group_idx];
+                                int64_t channel_start = group_idx * num_channels;
+                                for (int64_t c = channel_start; c < channel_start + num_channels; ++c) {
+                                    acc[c] += scale * static_cast<float>(v[c]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            for (int64_t c = 0; c < num_embeds; ++c) {
+                out_ptr[task * num_embeds + c] = static_cast<scalar_t>(acc[c]);
+            }
+        }
+    });
+}
+
+void CheckInputs(const at::Tensor& mc_ms_feat, const at::Tensor& spatial_shape, const at::Tensor& scale_start_index,
+    const at::Tensor& sampling_location, const at::Tensor& weights)
+{
+    TORCH_CHECK(spatial_shape.dim() == 3, "spatial_shape.dim() must be 3, but got: ", spatial_shape.dim());
+    TORCH_CHECK(scale_start_index.dim() == 2, "scale_start_index.dim() must be 2, but got: ", scale_start_index.dim());
+    TORCH_CHECK(sampling_location.dim() == 5, "sampling_location.dim() must be 5, but got: ", sampling_location.dim());
+    TORCH_CHECK(weights.dim() == 6, "weights.dim() must be 6, but got: ", weights.dim());
+    auto feat_dtype = mc_ms_feat.scalar_type();
+    TORCH_CHECK(feat_dtype == at::kFloat || feat_dtype == at::kHalf || feat_dtype == at::kBFloat16,
+        "mc_ms_feat must be float32, float16 or bfloat16, but got: ", feat_dtype);
+    TORCH_CHECK(sampling_location.scalar_type() == at::kFloat, "sampling_location must be float32.");
+    TORCH_CHECK(weights.scalar_type() == at::kFloat, "weights must be float32.");
+    auto num_embeds = mc_ms_feat.size(-1);
+    auto num_groups = weights.size(5);
+    TORCH_CHECK(num_groups > 0 && num_embeds % num_groups == 0,
+        "mc_ms_feat.sizes()[2] must be multiple of weights.sizes()[5], but got: ", num_embeds, " and ", num_groups);
+}
+} // namespace
+
 at::Tensor deformable_aggregation(const at::Tensor& mc_ms_feat, const at::Tensor& spatial_shape,
-    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights)
+    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights,
+    bool use_softmax)
 {
     TORCH_CHECK_NPU(mc_ms_feat);
     TORCH_CHECK_NPU(spatial_shape);
     TORCH_CHECK_NPU(scale_start_index);
     TORCH_CHECK_NPU(sampling_location);
     TORCH_CHECK_NPU(weights);
+    TORCH_CHECK(mc_ms_feat.dim() == 3, "mc_ms_feat.dim() must be 3, but got: ", mc_ms_feat.dim());
+    CheckInputs(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights);
 
     auto feat_size = mc_ms_feat.sizes();
     auto weights_size = weights.sizes();
@@ -37,24 +199,24 @@ at::Tensor deformable_aggregation(const at::Tensor& mc_ms_feat, const at::Tensor
     auto num_scale = weights_size[4];
     auto num_groups = weights_size[5];
 
-    TORCH_CHECK(mc_ms_feat.dim() == 3, "mc_ms_feat.dim() must be 3, but got: ", mc_ms_feat.dim());
-    TORCH_CHECK(spatial_shape.dim() == 3, "spatial_shape.dim() must be 3, but got: ", spatial_shape.dim());
-    TORCH_CHECK(scale_start_index.dim() == 2, "scale_start_index.dim() must be 2, but got: ", scale_start_index.dim());
-    TORCH_CHECK(sampling_location.dim() == 5, "sampling_location.dim() must be 5, but got: ", sampling_location.dim());
-    TORCH_CHECK(weights.dim() == 6, "weights.dim() must be 6, but got: ", weights.dim());
-    TORCH_CHECK(num_groups % 8 == 0, "weights.sizes()[5] must be multiple of 8, but got: ", num_groups);
+    bool fused_softmax = use_softmax && CanFuseSoftmax(mc_ms_feat, weights);
+    const at::Tensor& kernel_weights = (use_softmax && !fused_softmax) ? SoftmaxWeights(weights) : weights;
 
     at::Tensor out = at::empty({batch_size, num_anchors, num_embeds}, mc_ms_feat.options());
+    at::Tensor slot_index;
+    int64_t num_slots = 1;
 
-    EXEC_NPU_CMD(aclnnDeformableAggregation, mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights,
-        batch_size, num_feat, num_embeds, num_anchors, num_pts, num_cams, num_scale, num_groups, out);
+    EXEC_NPU_CMD(aclnnDeformableAggregation, mc_ms_feat, spatial_shape, scale_start_index, sampling_location,
+        kernel_weights, slot_index, batch_size, num_feat, num_embeds, num_anchors, num_pts, num_cams, num_scale,
+        num_groups, fused_softmax, num_slots, out);
     return out;
 }
 
 std::tuple<at::Tensor, at::Tensor, at::Tensor> deformable_aggregation_backward(const at::Tensor& mc_ms_feat,
     const at::Tensor& spatial_shape, const at::Tensor& scale_start_index, const at::Tensor& sampling_location,
-    const at::Tensor& weights, const at::Tensor& grad_output, const at::Tensor& grad_mc_ms_feat,
-    const at::Tensor& grad_sampling_location, const at::Tensor& grad_weights)
+    const at::Tensor& weights, const at::Tensor& grad_output, const c10::optional<at::Tensor>& grad_mc_ms_feat,
+    const c10::optional<at::Tensor>& grad_sampling_location, const c10::optional<at::Tensor>& grad_weights,
+    bool use_softmax)
 {
     TORCH_CHECK_NPU(mc_ms_feat);
     TORCH_CHECK_NPU(spatial_shape);
@@ -62,14 +224,111 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> deformable_aggregation_backward(c
     TORCH_CHECK_NPU(sampling_location);
     TORCH_CHECK_NPU(weights);
     TORCH_CHECK_NPU(grad_output);
-
     TORCH_CHECK(mc_ms_feat.dim() == 3, "mc_ms_feat.dim() must be 3, but got: ", mc_ms_feat.dim());
-    TORCH_CHECK(spatial_shape.dim() == 3, "spatial_shape.dim() must be 3, but got: ", spatial_shape.dim());
-    TORCH_CHECK(scale_start_index.dim() == 2, "scale_start_index.dim() must be 2, but got: ", scale_start_index.dim());
-    TORCH_CHECK(sampling_location.dim() == 5, "sampling_location.dim() must be 5, but got: ", sampling_location.dim());
-    TORCH_CHECK(weights.dim() == 6, "weights.dim() must be 6, but got: ", weights.dim());
+    CheckInputs(mc_ms_feat, spatial_shape, scale_start_index, sampling_location, weights);
+
+    bool alloc_grads = !grad_mc_ms_feat.has_value() && !grad_sampling_location.has_value() &&
+                       !grad_weights.has_value();
+    TORCH_CHECK(alloc_grads ||
+                    (grad_mc_ms_feat.has_value() && grad_sampling_location.has_value() && grad_weights.has_value()),
+        "grad_mc_ms_feat, grad_sampling_location and grad_weights must be all given or all None.");
+
+    // 反向统一使用float32计算与累加，半精度特征在这里转换，梯度在返回前转回原类型
+    at::Tensor feat = mc_ms_feat.scalar_type() == at::kFloat ? mc_ms_feat : mc_ms_feat.to(at::kFloat);
+    at::Tensor grad_out = grad_output.to(at::kFloat).contiguous();
+    at::Tensor kernel_weights = use_softmax ? SoftmaxWeights(weights) : weights;
+
+    at::Tensor grad_feat;
+    at::Tensor grad_loc;
+    at::Tensor grad_w;
+    if (alloc_grads) {
+        auto loc_size = sampling_location.sizes();
+        grad_feat = at::zeros(feat.sizes(), feat.options());
+        // kernel按每个采样点8个float的间隔写出grad_sampling_location，其中前两个为有效值
+        grad_loc = at::zeros({loc_size[0], loc_size[1], loc_size[2], loc_size[3], GROUP_ALIGN}, feat.options());
+        grad_w = at::zeros(weights.sizes(), feat.options());
+    } else {
+        // 调用方给出的非float32梯度先在float32临时结果上累加，最后写回
+        auto to_float = [](const at::Tensor& t) { return t.scalar_type() == at::kFloat ? t : t.to(at::kFloat); };
+        grad_feat = to_float(grad_mc_ms_feat.value());
+        grad_loc = to_float(grad_sampling_location.value());
+        grad_w = to_float(grad_weights.value());
+    }
+
+    EXEC_NPU_CMD(aclnnDeformableAggregationGrad, feat, spatial_shape, scale_start_index, sampling_location,
+        kernel_weights, grad_out, grad_feat, grad_loc, grad_w);
+
+    if (use_softmax) {
+        auto weights_size = weights.sizes();
+        std::vector<int64_t> flat_size = {weights_size[0], weights_size[1], -1, weights_size[5]};
+        auto grad_logits = at::_softmax_backward_data(grad_w.reshape(flat_size), kernel_weights.reshape(flat_size), 2,
+            at::kFloat);
+        grad_w.copy_(grad_logits.reshape(weights_size));
+    }
+    if (!alloc_grads) {
+        std::vector<at::Tensor> results = {grad_feat, grad_loc, grad_w};
+        std::vector<at::Tensor> outputs = {
+            grad_mc_ms_feat.value(), grad_sampling_location.value(), grad_weights.value()};
+        for (size_t i = 0; i < outputs.size(); i++) {
+            if (!results[i].is_same(outputs[i])) {
+                outputs[i].copy_(results[i]);
+            }
+        }
+        return std::make_tuple(outputs[0], outputs[1], outputs[2]);
+    }
+    return std::make_tuple(grad_feat.to(mc_ms_feat.scalar_type()),
+        grad_loc.narrow(-1, 0, 2).to(sampling_location.scalar_type()).contiguous(),
+        grad_w.to(weights.scalar_type()));
+}
+
+at::Tensor deformable_aggregation_temporal(const at::Tensor& feat_cache, const at::Tensor& spatial_shape,
+    const at::Tensor& scale_start_index, const at::Tensor& sampling_location, const at::Tensor& weights,
+    const at::Tensor& slot_index, bool use_softmax)
+{
+    TORCH_CHECK(feat_cache.dim() == 4, "feat_cache.dim() must be 4, but got: ", feat_cache.dim());
+    TORCH_CHECK(slot_index.dim() == 2, "slot_index.dim() must be 2, but got: ", slot_index.dim());
+    TORCH_CHECK(slot_index.scalar_type() == at::kInt, "slot_index must be int32.");
+    CheckInputs(feat_cache, spatial_shape, scale_start_index, sampling_location, weights);
 
-    EXEC_NPU_CMD(aclnnDeformableAggregationGrad, mc_ms_feat, spatial_shape, scale_start_index, sampling_location,
-        weights, grad_output, grad_mc_ms_feat, grad_sampling_location, grad_weights);
-    return std::make_tuple(grad_mc_ms_feat, grad_sampling_location, grad_weights);
+    auto cache_size = feat_cache.sizes();
+    auto weights_size = weights.sizes();
+    auto num_slots = cache_size[0];
+    auto batch_size = cache_size[1];
+    auto num_feat = cache_size[2];
+    auto num_embeds = cache_size[3];
+    auto num_anchors = weights_size[1];
+    auto num_pts = weights_size[2];
+    auto num_cams = weights_size[3];
+    auto num_scale = weights_size[4];
+    auto num_groups = weights_size[5];
+    TORCH_CHECK(weights_size[0] == batch_size, "weights.sizes()[0] must be equal to feat_cache.sizes()[1].");
+    TORCH_CHECK(slot_index.size(0) == batch_size && slot_index.size(1) == num_anchors,
+        "slot_index must be of shape [bs, num_anchors].");
+
+    at::Tensor out = at::empty({batch_size, num_anchors, num_embeds}, feat_cache.options());
+    if (feat_cache.device().is_cpu()) {
+        at::Tensor cpu_weights = use_softmax ? SoftmaxWeights(weights) : weights.contiguous();
+        AT_DISPATCH_FLOATING_TYPES_AND2(at::kHalf, at::kBFloat16, feat_cache.scalar_type(),
+            "deformable_aggregation_temporal_cpu", [&] {
+                DeformableAggregationTemporalCpuKernel<scalar_t>(feat_cache.contiguous(), spatial_shape.contiguous(),
+                    scale_start_index.contiguous(), sampling_location.contiguous(), cpu_weights,
+                    slot_index.contiguous(), out);
+            });
+        return out;
+    }
+
+    TORCH_CHECK_NPU(feat_cache);
+    TORCH_CHECK_NPU(spatial_shape);
+    TORCH_CHECK_NPU(scale_start_index);
+    TORCH_CHECK_NPU(sampling_location);
+    TORCH_CHECK_NPU(weights);
+    TORCH_CHECK_NPU(slot_index);
+
+    bool fused_softmax = use_softmax && CanFuseSoftmax(feat_cache, weights);
+    const at::Tensor& kernel_weights = (use_softmax && !fused_softmax) ? SoftmaxWeights(weights) : weights;
+
+    EXEC_NPU_CMD(aclnnDeformableAggregation, feat_cache, spatial_shape, scale_start_index, sampling_location,
+        kernel_weights, slot_index, batch_size, num_feat, num_embeds, num_anchors, num_pts, num_cams, num_scale,
+        num_groups, fused_softmax, num_slots, out);
+    return out;
 }
@@ -0,0 +1,331 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <cmath>
+
+namespace {
+constexpr int64_t BOX_DIM = 5;
+constexpr int64_t GRAD_DIM = 10;
+constexpr int BOX_CORNERS = 4;
+constexpr int LINE_NUM = 8;
+constexpr int MAX_POLY = 16;
+constexpr int64_t MODE_IOU = 0;
+constexpr int64_t MODE_GIOU = 1;
+constexpr int64_t MODE_DIOU = 2;
+constexpr float EPS_DEN = 1e-12f;
+constexpr float HALF = 0.5f;
+constexpr float CORNER_U[BOX_CORNERS] = {HALF, -HALF, -HALF, HALF};
+constexpr float CORNER_V[BOX_CORNERS] = {HALF, HALF, -HALF, -HALF};
+
+inline float Cross(float ax, float ay, float bx, float by)
+{
+    return ax * by - ay * bx;
+}
+
+inline int LineEnd(int line)
+{
+    return (line & ~(BOX_CORNERS - 1)) | ((line + 1) & (BOX_CORNERS - 1));
+}
+
+// 与kernel逐步一致的单对框实现：角点 -> 框B裁剪框A -> 鞋带公式 -> 解析梯度
+class RotatedIouPair {
+public:
+    RotatedIouPair(const float* boxA, const float* boxB, int64_t mode) : mode_(mode)
+    {
+        for (int k = 0; k < BOX_DIM; k++) {
+            box_[k] = boxA[k];
+            box_[BOX_DIM + k] = boxB[k];
+        }
+        for (int b = 0; b < 2; b++) {
+            const float* param = box_ + b * BOX_DIM;
+            sin_[b] = std::sin(param[4]);
+            cos_[b] = std::cos(param[4]);
+            for (int k = 0; k < BOX_CORNERS; k++) {
+                float u = CORNER_U[k] * param[2];
+                float v = CORNER_V[k] * param[3];
+                px_[b * BOX_CORNERS + k] = param[0] + cos_[b] * u - sin_[b] * v;
+                py_[b * BOX_CORNERS + k] = param[1] + sin_[b] * u + cos_[b] * v;
+            }
+        }
+    }
+
+    // 返回iou/giou/diou，grad非空时写出对(box_a, box_b)共10个参数的梯度
+    float Compute(float* grad)
+    {
+        int n = ClipPolygon();
+        float inter = 0;
+        if (n >= 3) {
+            for (int i = 0; i < n; i++) {
+                int j = i + 1 == n ? 0 : i + 1;
+                inter += Cross(vx_[i], vy_[i], vx_[j], vy_[j]);
+            }
+            inter *= HALF;
+        }
+        float area1 = box_[2] * box_[3];
+        float area2 = box_[BOX_DIM + 2] * box_[BOX_DIM + 3];
+        float uni = area1 + area2 - inter;
+        float iou = uni > 0 ? inter / uni : 0;
+        float gInter = uni > 0 ? (area1 + area2) / (uni * uni) : 0;
+        float gArea[2] = {uni > 0 ? -inter / (uni * uni) : 0, uni > 0 ? -inter / (uni * uni) : 0};
+        float res = iou;
+
+        int xMinIdx = 0;
+        int xMaxIdx = 0;
+        int yMinIdx = 0;
+        int yMaxIdx = 0;
+        float gCx = 0;
+        float gCy = 0;
+        float gCenter = 0;
+        if (mode_ == MODE_GIOU || mode_ == MODE_DIOU) {
+            for (int k = 1; k < LINE_NUM; k++) {
+                xMinIdx = px_[k] < px_[xMinIdx] ? k : xMinIdx;
+                xMaxIdx = px_[k] > px_[xMaxIdx] ? k : xMaxIdx;
+                yMinIdx = py_[k] < py_[yMinIdx] ? k : yMinIdx;
+                yMaxIdx = py_[k] > py_[yMaxIdx] ? k : yMaxIdx;
+            }
+            float encW = px_[xMaxIdx] - px_[xMinIdx];
+            float encH = py_[yMaxIdx] - py_[yMinIdx];
+            if (mode_ == MODE_GIOU) {
+                float enclose = encW * encH;
+                if (enclose > 0) {
+                    res = iou - 1 + uni / enclose;
+                    float gUni = 1 / enclose;
+                    float gEnclose = -uni / (enclose * enclose);
+                    gInter -= gUni;
+                    gArea[0] += gUni;
+                    gArea[1] += gUni;
+                    gCx = gEnclose * encH;
+                    gCy = gEnclose * encW;
+                }
+            } else {
+                float diag = encW * encW + encH * encH;
+                float dx = box_[0] - box_[BOX_DIM];
+                float dy = box_[1] - box_[BOX_DIM + 1];
+                if (diag > 0) {
+                    float dist = dx * dx + dy * dy;
+                    res = iou - dist / diag;
+                    float gDiag = dist / (diag * diag);
+                    gCenter = -2 / diag;
+                    gCx = gDiag * 2 * encW;
+                    gCy = gDiag * 2 * encH;
+                }
+            }
+        }
+        if (grad == nullptr) {
+            return res;
+        }
+
+        for (int k = 0; k < LINE_NUM; k++) {
+            gpx_[k] = 0;
+            gpy_[k] = 0;
+        }
+        if (n >= 3) {
+            for (int i = 0; i < n; i++) {
+                int j = i + 1 == n ? 0 : i + 1;
+                int h = i == 0 ? n - 1 : i - 1;
+                BackwardIntersection(vIn_[i], vOut_[i], HALF * (vy_[j] - vy_[h]) * gInter,
+                    HALF * (vx_[h] - vx_[j]) * gInter);
+            }
+        }
+        gpx_[xMaxIdx] += gCx;
+        gpx_[xMinIdx] -= gCx;
+        gpy_[yMaxIdx] += gCy;
+        gpy_[yMinIdx] -= gCy;
+
+        float gCenterX = gCenter * (box_[0] - box_[BOX_DIM]);
+        float gCenterY = gCenter * (box_[1] - box_[BOX_DIM + 1]);
+        for (int b = 0; b < 2; b++) {
+            const float* param = box_ + b * BOX_DIM;
+            float sign = b == 0 ? 1.0f : -1.0f;
+            float gx = sign * gCenterX;
+            float gy = sign * gCenterY;
+            float gw = gArea[b] * param[3];
+            float gh = gArea[b] * param[2];
+            float ga = 0;
+            for (int k = 0; k < BOX_CORNERS; k++) {
+                int p = b * BOX_CORNERS + k;
+                gx += gpx_[p];
+                gy += gpy_[p];
+                gw += CORNER_U[k] * (cos_[b] * gpx_[p] + sin_[b] * gpy_[p]);
+                gh += CORNER_V[k] * (cos_[b] * gpy_[p] - sin_[b] * gpx_[p]);
+                ga += (px_[p] - param[0]) * gpy_[p] - (py_[p] - param[1]) * gpx_[p];
+            }
+            float* out = grad + b * BOX_DIM;
+            out[0] = gx;
+            out[1] = gy;
+            out[2] = gw;
+            out[3] = gh;
+            out[4] = ga;
+        }
+        return res;
+    }
+
+private:
+    int ClipPolygon()
+    {
+        int n = BOX_CORNERS;
+        for (int k = 0; k < BOX_CORNERS; k++) {
+            vx_[k] = px_[k];
+            vy_[k] = py_[k];
+            vIn_[k] = (k + BOX_CORNERS - 1) & (BOX_CORNERS - 1);
+            vOut_[k] = k;
+        }
+        float wx[MAX_POLY];
+        float wy[MAX_POLY];
+        int wIn[MAX_POLY];
+        int wOut[MAX_POLY];
+        float side[MAX_POLY];
+        for (int c = BOX_CORNERS; c < LINE_NUM && n > 0; c++) {
+            int ce = LineEnd(c);
+            float cdx = px_[ce] - px_[c];
+            float cdy = py_[ce] - py_[c];
+            for (int i = 0; i < n; i++) {
+                side[i] = Cross(cdx, cdy, vx_[i] - px_[c], vy_[i] - py_[c]);
+            }
+            int m = 0;
+            for (int i = 0; i < n; i++) {
+                int j = i + 1 == n ? 0 : i + 1;
+                bool inI = side[i] >= 0;
+                bool inJ = side[j] >= 0;
+                if (inI) {
+                    wx[m] = vx_[i];
+                    wy[m] = vy_[i];
+                    wIn[m] = vIn_[i];
+                    wOut[m] = vOut_[i];
+                    m++;
+                }
+                if (inI != inJ) {
+                    float t = side[i] / (side[i] - side[j]);
+                    wx[m] = vx_[i] + t * (vx_[j] - vx_[i]);
+                    wy[m] = vy_[i] + t * (vy_[j] - vy_[i]);
+                    wIn[m] = inI ? vOut_[i] : c;
+                    wOut[m] = inI ? c : vOut_[i];
+                    m++;
+                }
+            }
+            n = m;
+            for (int i = 0; i < n; i++) {
+                vx_[i] = wx[i];
+                vy_[i] = wy[i];
+                vIn_[i] = wIn[i];
+                vOut_[i] = wOut[i];
+            }
+        }
+        return n;
+    }
+
+    void BackwardIntersection(int l1, int l2, float gx, float gy)
+    {
+        int e1 = LineEnd(l1);
+        int e2 = LineEnd(l2);
+        if ((l1 >> 2) == (l2 >> 2)) {
+            int shared = e1 == l2 ? l2 : l1;
+            gpx_[shared] += gx;
+            gpy_[shared] += gy;
+            return;
+        }
+        float d1x = px_[e1] - px_[l1];
+        float d1y = py_[e1] - py_[l1];
+        float d2x = px_[e2] - px_[l2];
+        float d2y = py_[e2] - py_[l2];
+        float qx = px_[l2] - px_[l1];
+        float qy = py_[l2] - py_[l1];
+        float den = Cross(d1x, d1y, d2x, d2y);
+        if (std::abs(den) < EPS_DEN) {
+            return;
+        }
+        float t = Cross(qx, qy, d2x, d2y) / den;
+        float s = (gx * d1x + gy * d1y) / den;
+        float gqx = s * d2y;
+        float gqy = -s * d2x;
+        float gd1x = -t * gqx;
+        float gd1y = -t * gqy;
+        float gd2x = s * (-qy + t * d1y);
+        float gd2y = s * (qx - t * d1x);
+        gpx_[l1] += gx * (1 - t) - gqx - gd1x;
+        gpy_[l1] += gy * (1 - t) - gqy - gd1y;
+        gpx_[e1] += gx * t + gd1x;
+        gpy_[e1] += gy * t + gd1y;
+        gpx_[l2] += gqx - gd2x;
+        gpy_[l2] += gqy - gd2y;
+        gpx_[e2] += gd2x;
+        gpy_[e2] += gd2y;
+    }
+
+    int64_t mode_;
+    float box_[GRAD_DIM];
+    float sin_[2];
+    float cos_[2];
+    float px_[LINE_NUM];
+    float py_[LINE_NUM];
+    float gpx_[LINE_NUM];
+    float gpy_[LINE_NUM];
+    float vx_[MAX_POLY];
+    float vy_[MAX_POLY];
+    int vIn_[MAX_POLY];
+    int vOut_[MAX_POLY];
+};
+} // namespace
+
+/**
+ * @brief 融合的可微旋转框IoU，一次计算同时给出IoU/GIoU/DIoU及其对输入框的解析梯度
+ * @param boxes_a: 3D tensor(B, N, 5)，(x_center, y_center, w, h, angle)
+ * @param boxes_b: 3D tensor(B, N, 5)
+ * @param mode: 0为iou，1为giou，2为diou，外接框取两个框8个角点的轴对齐包围盒
+ * @param with_grad: 是否输出梯度
+ * @return ious: (B, N)；grad: (B, N, 10)，依次为对boxes_a和boxes_b的5个参数的梯度，with_grad为false时为空tensor
+ */
+std::tuple<at::Tensor, at::Tensor> diff_iou_rotated(
+    const at::Tensor& boxes_a, const at::Tensor& boxes_b, int64_t mode, bool with_grad)
+{
+    TORCH_CHECK(boxes_a.dim() == 3 && boxes_a.size(2) == BOX_DIM, "boxes_a must be a 3D tensor with shape [B, N, 5].");
+    TORCH_CHECK(boxes_a.sizes() == boxes_b.sizes(), "boxes_a and boxes_b must have the same shape.");
+    TORCH_CHECK(boxes_a.scalar_type() == at::kFloat && boxes_b.scalar_type() == at::kFloat,
+        "diff_iou_rotated only support float32 tensor.");
+    TORCH_CHECK(mode == MODE_IOU || mode == MODE_GIOU || mode == MODE_DIOU,
+        "mode must be 0 (iou), 1 (giou) or 2 (diou).");
+
+    int64_t batch_size = boxes_a.size(0);
+    int64_t num_boxes = boxes_a.size(1);
+    at::Tensor ious = at::empty({batch_size, num_boxes}, boxes_a.options());
+    at::Tensor grad = with_grad ? at::empty({batch_size, num_boxes, GRAD_DIM}, boxes_a.options()) :
+                                  at::empty({0}, boxes_a.options());
+    if (boxes_a.device().is_cpu()) {
+        at::Tensor a = boxes_a.contiguous();
+        at::Tensor b = boxes_b.contiguous();
+        const float* a_ptr = a.data_ptr<float>();
+        const float* b_ptr = b.data_ptr<float>();
+        float* iou_ptr = ious.data_ptr<float>();
+        float* grad_ptr = with_grad ? grad.data_ptr<float>() : nullptr;
+        at::parallel_for(0, batch_size * num_boxes, 0, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; i++) {
+                RotatedIouPair pair(a_ptr + i * BOX_DIM, b_ptr + i * BOX_DIM, mode);
+                iou_ptr[i] = pair.Compute(with_grad ? grad_ptr + i * GRAD_DIM : nullptr);
+            }
+        });
+        return std::make_tuple(ious, grad);
+    }
+
+    TORCH_CHECK_NPU(boxes_a);
+    TORCH_CHECK_NPU(boxes_b);
+    int32_t mode_attr = static_cast<int32_t>(mode);
+    EXEC_NPU_CMD(aclnnDiffIouRotated, boxes_a, boxes_b, mode_attr, with_grad, ious, grad);
+    return std::make_tuple(ious, grad);
+}
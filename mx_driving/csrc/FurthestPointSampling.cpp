@@ -17,10 +17,145 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
-at::Tensor npu_furthest_point_sampling(const at::Tensor& point_xyz, const at::Tensor& nearset_temp, int32_t num_points)
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr int64_t POINT_DIM = 3;
+constexpr float NEAREST_DIST_INIT = 1e10f;
+
+// 与NPU kernel一致：距离按(x - x_s)^2 + (y - y_s)^2 + (z - z_s)^2累加，距离相同时取下标最小的点
+void SampleOne(const float* x, const float* y, const float* z, int64_t valid, int32_t num_points, int32_t* idx,
+    std::vector<float>& nearest_dist)
+{
+    std::fill(nearest_dist.begin(), nearest_dist.begin() + valid, NEAREST_DIST_INIT);
+    idx[0] = 0;
+    int64_t sampled = 0;
+    for (int32_t i = 1; i < num_points; ++i) {
+        float xs = x[sampled];
+        float ys = y[sampled];
+        float zs = z[sampled];
+        float max_dist = 0.0f;
+        int64_t max_idx = 0;
+        for (int64_t k = 0; k < valid; ++k) {
+            float dx = x[k] - xs;
+            float dy = y[k] - ys;
+            float dz = z[k] - zs;
+            float dist = std::min(nearest_dist[k], dx * dx + dy * dy + dz * dz);
+            nearest_dist[k] = dist;
+            if (dist > max_dist) {
+                max_dist = dist;
+                max_idx = k;
+            }
+        }
+        sampled = max_idx;
+        idx[i] = static_cast<int32_t>(max_idx);
+    }
+}
+
+at::Tensor furthest_point_sampling_cpu(
+    const at::Tensor& point_xyz, const c10::optional<at::Tensor>& point_counts, int32_t num_points)
+{
+    auto points = point_xyz.to(at::kFloat).contiguous();
+    int64_t b = points.size(0);
+    int64_t n = points.size(2);
+    at::Tensor output = at::zeros({b, static_cast<int64_t>(num_points)}, points.options().dtype(at::kInt));
+    at::Tensor counts;
+    if (point_counts.has_value()) {
+        counts = point_counts.value().to(at::kLong).contiguous();
+    }
+    const float* points_ptr = points.data_ptr<float>();
+    const int64_t* counts_ptr = counts.defined() ? counts.data_ptr<int64_t>() : nullptr;
+    int32_t* output_ptr = output.data_ptr<int32_t>();
+
+    at::parallel_for(0, b, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> nearest_dist(n);
+        for (int64_t batch = begin; batch < end; ++batch) {
+            int64_t valid = counts_ptr == nullptr ? n : std::min(std::max(counts_ptr[batch], int64_t(1)), n);
+            const float* x = points_ptr + batch * POINT_DIM * n;
+            SampleOne(x, x + n, x + 2 * n, valid, num_points, output_ptr + batch * num_points, nearest_dist);
+        }
+    });
+    return output;
+}
+
+// 与NPU kernel一致：各样本在[3, total]布局中原地采样，空样本读取一个点，其结果由调用方丢弃
+at::Tensor furthest_point_sampling_packed_cpu(const at::Tensor& points, const at::Tensor& ptr, int32_t num_points)
+{
+    auto xyz = points.to(at::kFloat).t().contiguous();
+    auto offsets = ptr.to(at::kLong).contiguous();
+    int64_t b = offsets.numel() - 1;
+    int64_t total = xyz.size(1);
+    at::Tensor output = at::zeros({b, static_cast<int64_t>(num_points)}, xyz.options().dtype(at::kInt));
+    const float* x = xyz.data_ptr<float>();
+    const int64_t* offsets_ptr = offsets.data_ptr<int64_t>();
+    int32_t* output_ptr = output.data_ptr<int32_t>();
+
+    at::parallel_for(0, b, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> nearest_dist;
+        for (int64_t batch = begin; batch < end; ++batch) {
+            int64_t start = std::min(std::max(offsets_ptr[batch], int64_t(0)), total - 1);
+            int64_t valid = std::min(std::max(offsets_ptr[batch + 1] - start, int64_t(1)), total - start);
+            nearest_dist.resize(std::max(static_cast<int64_t>(nearest_dist.size()), valid));
+            SampleOne(x + start, x + total + start, x + 2 * total + start, valid, num_points,
+                output_ptr + batch * num_points, nearest_dist);
+        }
+    });
+    return output;
+}
+} // namespace
+
+/**
+ * @brief 最远点采样，距离暂存空间在kernel内初始化，无需调用方构造
+ * @param point_xyz: 点云坐标，3D tensor(b, 3, n)
+ * @param point_counts: 可选，每个样本的有效点数(b)，ragged batch仅在前point_counts[i]个点中采样
+ * @param num_points: 每个样本的采样点数
+ * @return 采样点下标(b, num_points)
+ */
+at::Tensor npu_furthest_point_sampling(
+    const at::Tensor& point_xyz, const c10::optional<at::Tensor>& point_counts, int32_t num_points)
 {
+    TORCH_CHECK(point_xyz.dim() == POINT_DIM && point_xyz.size(1) == POINT_DIM,
+        "point_xyz must be a 3D tensor with shape [B, 3, N].");
+    TORCH_CHECK(!point_counts.has_value() || point_counts.value().numel() == point_xyz.size(0),
+        "point_counts must have B elements.");
+    if (point_xyz.device().is_cpu()) {
+        return furthest_point_sampling_cpu(point_xyz, point_counts, num_points);
+    }
+    TORCH_CHECK_NPU(point_xyz);
+    bool is_ragged = point_counts.has_value();
     at::Tensor output = at::empty({static_cast<int64_t>(point_xyz.sizes()[0]), static_cast<int64_t>(num_points)},
-        nearset_temp.options().dtype(at::kInt));
-    EXEC_NPU_CMD(aclnnFurthestPointSampling, point_xyz, nearset_temp, num_points, output);
+        point_xyz.options().dtype(at::kInt));
+    bool is_packed = false;
+    EXEC_NPU_CMD(aclnnFurthestPointSampling, point_xyz, point_counts, num_points, is_ragged, is_packed, output);
+    return output;
+}
+
+/**
+ * @brief 按样本拼接的变长点云的最远点采样，kernel按ptr偏移原地读取各样本，不构造填充布局
+ * @param points: 按样本拼接的点云坐标，2D tensor(total, 3)
+ * @param ptr: 各样本的起始偏移(b + 1)，样本i为points[ptr[i], ptr[i + 1])
+ * @param num_points: 每个样本的采样点数
+ * @return 各样本内的局部采样点下标(b, num_points)，空样本的结果无意义
+ */
+at::Tensor npu_furthest_point_sampling_packed(const at::Tensor& points, const at::Tensor& ptr, int32_t num_points)
+{
+    TORCH_CHECK(points.dim() == 2 && points.size(1) == POINT_DIM, "points must be a 2D tensor with shape [total, 3].");
+    TORCH_CHECK(points.size(0) > 0, "points can not be empty.");
+    TORCH_CHECK(ptr.dim() == 1 && ptr.numel() > 1, "ptr must be a 1D tensor with B + 1 elements.");
+    if (points.device().is_cpu()) {
+        return furthest_point_sampling_packed_cpu(points, ptr, num_points);
+    }
+    TORCH_CHECK_NPU(points);
+    // kernel按轴读取，[total, 3]转为[1, 3, total]只需一次转置，不随样本点数差异填充
+    at::Tensor point_xyz = points.to(at::kFloat).t().contiguous().unsqueeze(0);
+    at::Tensor point_ptr = ptr.to(points.device(), at::kInt).contiguous();
+    at::Tensor output = at::empty({ptr.size(0) - 1, static_cast<int64_t>(num_points)},
+        points.options().dtype(at::kInt));
+    bool is_ragged = false;
+    bool is_packed = true;
+    EXEC_NPU_CMD(aclnnFurthestPointSampling, point_xyz, point_ptr, num_points, is_ragged, is_packed, output);
     return output;
 }
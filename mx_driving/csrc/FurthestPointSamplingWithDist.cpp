@@ -20,6 +20,9 @@
 at::Tensor furthest_point_sampling_with_dist(
     const at::Tensor& points_dist, const at::Tensor& nearest_temp, int32_t num_points)
 {
+    if (points_dist.device().is_cpu()) {
+        return furthest_point_sampling_with_dist_cpu(points_dist, nearest_temp, num_points);
+    }
     auto points_dist_size = points_dist.sizes();
     int64_t b = points_dist_size[0];
     int64_t num_points_real = num_points;
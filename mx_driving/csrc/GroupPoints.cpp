@@ -20,13 +20,16 @@
 at::Tensor group_points(
     const at::Tensor& points, const at::Tensor& idx, int64_t b, int64_t c, int64_t n, int64_t npoints, int64_t nsample)
 {
-    TORCH_CHECK_NPU(points);
-    TORCH_CHECK_NPU(idx);
     TORCH_CHECK(points.scalar_type() == at::kHalf || points.scalar_type() == at::kFloat,
         "group_points only support float16 or float32 tensor.")
     TORCH_CHECK(points.dim() == 3, "points.dim() must be 3, but got: ", points.dim());
     TORCH_CHECK(idx.dim() == 3, "idx.dim() must be 3, but got: ", idx.dim());
     TORCH_CHECK(points.size(0) == idx.size(0), "the input first dimension must be the same.")
+    if (points.device().is_cpu()) {
+        return group_points_cpu(points, idx);
+    }
+    TORCH_CHECK_NPU(points);
+    TORCH_CHECK_NPU(idx);
 
     at::Tensor trans_features = points.transpose(1, 2);
     at::Tensor features = trans_features.contiguous();
@@ -42,10 +45,13 @@ at::Tensor group_points(
 at::Tensor group_points_backward(const at::Tensor& grad_out, const at::Tensor& idx, int64_t b, int64_t c, int64_t n,
     int64_t npoints, int64_t nsample)
 {
-    TORCH_CHECK_NPU(grad_out);
-    TORCH_CHECK_NPU(idx);
     TORCH_CHECK(grad_out.dim() == 4, "grad_out.dim() must be 4, but got: ", grad_out.dim());
     TORCH_CHECK(idx.dim() == 3, "idx.dim() must be 3, but got: ", idx.dim());
+    if (grad_out.device().is_cpu()) {
+        return group_points_backward_cpu(grad_out, idx, n);
+    }
+    TORCH_CHECK_NPU(grad_out);
+    TORCH_CHECK_NPU(idx);
 
     at::Tensor trans_idx = idx.view({b * npoints * nsample});
     at::Tensor trans_grad_out = grad_out.permute({0, 2, 3, 1});
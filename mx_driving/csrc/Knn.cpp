@@ -17,15 +17,247 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
-std::tuple<at::Tensor, at::Tensor> knn(const at::Tensor& xyz, const at::Tensor& center_xyz, int32_t k, bool is_from_knn)
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int64_t POINT_DIM = 3;
+// 网格大小按每个网格平均约POINTS_PER_CELL个源点选取
+constexpr double POINTS_PER_CELL = 32.0;
+constexpr double MAX_GRID_DIM = 4096.0;
+constexpr float MIN_EXTENT = 1e-6f;
+constexpr float DIST_CLIP = 1e10f;
+constexpr float BOUND_EPS = 1e-4f;
+
+// 源点按BEV均匀网格(x优先)排序后的结果，cell_start[b][c]为第c个网格在排序后源点中的起始位置
+struct KnnGrid {
+    at::Tensor sorted_xyz;
+    at::Tensor cell_start;
+    at::Tensor order;
+    // device上的源点使用固定分辨率的网格，(low_x, low_y, cell_size)留在device上由kernel读取
+    at::Tensor bounds;
+    int64_t grid_x_num = 1;
+    int64_t grid_y_num = 1;
+    float low_x = 0.0f;
+    float low_y = 0.0f;
+    float cell_size = 1.0f;
+};
+
+KnnGrid BuildKnnGrid(const at::Tensor& xyz)
 {
-    TORCH_CHECK_NPU(xyz);
-    TORCH_CHECK_NPU(center_xyz);
-    TORCH_CHECK(center_xyz.dim() == 3, "center_xyz.dim() must be 3, but got: ", center_xyz.dim());
+    int64_t b = xyz.size(0);
+    int64_t n = xyz.size(2);
+    auto bev = xyz.narrow(1, 0, 2).to(at::kFloat);
+    auto low = bev.amin({0, 2});
+    auto high = bev.amax({0, 2});
+
+    KnnGrid grid;
+    at::Tensor cell_x;
+    at::Tensor cell_y;
+    if (xyz.device().is_cpu()) {
+        // CPU上读取边界不需要同步，网格按实际范围划分
+        auto bounds = at::cat({low, high});
+        const float* bounds_ptr = bounds.data_ptr<float>();
+        grid.low_x = bounds_ptr[0];
+        grid.low_y = bounds_ptr[1];
+        float extent_x = std::max(bounds_ptr[2] - grid.low_x, MIN_EXTENT);
+        float extent_y = std::max(bounds_ptr[3] - grid.low_y, MIN_EXTENT);
+        double cell_size =
+            std::sqrt(static_cast<double>(extent_x) * extent_y * POINTS_PER_CELL / std::max(n, int64_t(1)));
+        cell_size = std::max(cell_size, std::max(extent_x, extent_y) / MAX_GRID_DIM);
+        grid.cell_size = static_cast<float>(cell_size);
+        grid.grid_x_num = static_cast<int64_t>(extent_x / grid.cell_size) + 1;
+        grid.grid_y_num = static_cast<int64_t>(extent_y / grid.cell_size) + 1;
+        cell_x = ((bev.select(1, 0) - grid.low_x) / grid.cell_size).floor();
+        cell_y = ((bev.select(1, 1) - grid.low_y) / grid.cell_size).floor();
+    } else {
+        // device上网格分辨率只由点数决定，正方形网格覆盖x、y中较大的范围，边界与网格大小不拷回host
+        double grid_dim = std::ceil(std::sqrt(static_cast<double>(std::max(n, int64_t(1))) / POINTS_PER_CELL));
+        grid.grid_x_num = static_cast<int64_t>(std::min(std::max(grid_dim, 1.0), MAX_GRID_DIM));
+        grid.grid_y_num = grid.grid_x_num;
+        auto cell_size = ((high - low).amax().clamp_min(MIN_EXTENT) / grid.grid_x_num).reshape({1});
+        grid.bounds = at::cat({low, cell_size}).contiguous();
+        cell_x = ((bev.select(1, 0) - low.narrow(0, 0, 1)) / cell_size).floor();
+        cell_y = ((bev.select(1, 1) - low.narrow(0, 1, 1)) / cell_size).floor();
+    }
+    cell_x = cell_x.clamp(0, grid.grid_x_num - 1).to(at::kLong);
+    cell_y = cell_y.clamp(0, grid.grid_y_num - 1).to(at::kLong);
+    auto key = cell_x * grid.grid_y_num + cell_y;
+    auto sorted = key.sort(true, 1);
+    grid.order = std::get<1>(sorted);
+    grid.sorted_xyz = xyz.gather(2, grid.order.unsqueeze(1).expand({b, POINT_DIM, n})).contiguous();
+    grid.cell_start = at::zeros({b, grid.grid_x_num * grid.grid_y_num + 1}, key.options())
+                          .scatter_add_(1, key + 1, at::ones_like(key))
+                          .cumsum(1)
+                          .to(at::kInt)
+                          .contiguous();
+    return grid;
+}
 
-    at::Tensor dist = at::zeros({center_xyz.sizes()[0], center_xyz.sizes()[1], k}, center_xyz.options());
-    at::Tensor idx = at::zeros({center_xyz.sizes()[0], center_xyz.sizes()[1], k}, center_xyz.options().dtype(at::kInt));
-    EXEC_NPU_CMD_SYNC(aclnnKnn, xyz, center_xyz, is_from_knn, k, dist, idx);
+// 与NPU kernel一致的CPU实现：按环访问邻域网格，距离相同时取排序后下标较小的点
+void KnnSearchCpu(const at::Tensor& xyz, const at::Tensor& center_xyz, const at::Tensor& cell_start,
+    const KnnGrid& grid, int32_t k, bool is_from_knn, at::Tensor& dist, at::Tensor& idx)
+{
+    int64_t b = center_xyz.size(0);
+    int64_t m = center_xyz.size(1);
+    int64_t n = xyz.size(2);
+    int64_t gx = grid.grid_x_num;
+    int64_t gy = grid.grid_y_num;
+    const float* source_ptr = xyz.data_ptr<float>();
+    const float* target_ptr = center_xyz.data_ptr<float>();
+    const int32_t* cell_ptr = cell_start.data_ptr<int32_t>();
+    float* dist_ptr = dist.data_ptr<float>();
+    int32_t* idx_ptr = idx.data_ptr<int32_t>();
+
+    at::parallel_for(0, b * m, 1, [&](int64_t begin, int64_t end) {
+        std::vector<std::pair<float, int32_t>> heap;
+        heap.reserve(k + 1);
+        for (int64_t task = begin; task < end; ++task) {
+            int64_t batch = task / m;
+            const float* sx = source_ptr + batch * POINT_DIM * n;
+            const float* sy = sx + n;
+            const float* sz = sy + n;
+            const int32_t* cells = cell_ptr + batch * (gx * gy + 1);
+            float tx = target_ptr[task * POINT_DIM];
+            float ty = target_ptr[task * POINT_DIM + 1];
+            float tz = target_ptr[task * POINT_DIM + 2];
+            heap.clear();
+            auto visit = [&](int64_t first_cell, int64_t last_cell) {
+                for (int32_t j = cells[first_cell]; j < cells[last_cell + 1]; ++j) {
+                    float dx = sx[j] - tx;
+                    float dy = sy[j] - ty;
+                    float dz = sz[j] - tz;
+                    float d = dx * dx + dy * dy + dz * dz;
+                    d = is_from_knn ? std::min(d, DIST_CLIP) : d;
+                    std::pair<float, int32_t> cand(d, j);
+                    if (static_cast<int32_t>(heap.size()) < k) {
+                        heap.push_back(cand);
+                        std::push_heap(heap.begin(), heap.end());
+                    } else if (cand < heap.front()) {
+                        std::pop_heap(heap.begin(), heap.end());
+                        heap.back() = cand;
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+            };
+            int64_t cx = std::min(std::max(static_cast<int64_t>(std::floor((tx - grid.low_x) / grid.cell_size)),
+                int64_t(0)), gx - 1);
+            int64_t cy = std::min(std::max(static_cast<int64_t>(std::floor((ty - grid.low_y) / grid.cell_size)),
+                int64_t(0)), gy - 1);
+            for (int64_t r = 0;; ++r) {
+                int64_t x0 = cx - r;
+                int64_t x1 = cx + r;
+                int64_t y0 = cy - r;
+                int64_t y1 = cy + r;
+                for (int64_t x = std::max(x0, int64_t(0)); x <= std::min(x1, gx - 1); ++x) {
+                    if (x == x0 || x == x1) {
+                        visit(x * gy + std::max(y0, int64_t(0)), x * gy + std::min(y1, gy - 1));
+                        continue;
+                    }
+                    if (y0 >= 0) {
+                        visit(x * gy + y0, x * gy + y0);
+                    }
+                    if (y1 < gy) {
+                        visit(x * gy + y1, x * gy + y1);
+                    }
+                }
+                if (x0 <= 0 && x1 >= gx - 1 && y0 <= 0 && y1 >= gy - 1) {
+                    break;
+                }
+                float bound = FLT_MAX;
+                if (x0 > 0) {
+                    bound = std::min(bound, tx - (grid.low_x + x0 * grid.cell_size));
+                }
+                if (x1 < gx - 1) {
+                    bound = std::min(bound, grid.low_x + (x1 + 1) * grid.cell_size - tx);
+                }
+                if (y0 > 0) {
+                    bound = std::min(bound, ty - (grid.low_y + y0 * grid.cell_size));
+                }
+                if (y1 < gy - 1) {
+                    bound = std::min(bound, grid.low_y + (y1 + 1) * grid.cell_size - ty);
+                }
+                bound -= grid.cell_size * BOUND_EPS;
+                if (static_cast<int32_t>(heap.size()) == k && bound > 0 && heap.front().first <= bound * bound) {
+                    break;
+                }
+            }
+            std::sort_heap(heap.begin(), heap.end());
+            for (int32_t i = 0; i < k; ++i) {
+                bool found = i < static_cast<int32_t>(heap.size());
+                dist_ptr[task * k + i] = found ? heap[i].first : FLT_MAX;
+                idx_ptr[task * k + i] = found ? heap[i].second : 0;
+            }
+        }
+    });
+}
+} // namespace
+
+/**
+ * @brief k近邻搜索
+ * @param xyz: 源点，3D tensor(b, 3, n)
+ * @param center_xyz: 目标点，3D tensor(b, m, 3)
+ * @param k: 近邻数量
+ * @param is_from_knn: 为true时距离平方截断到1e10
+ * @param with_sqrt: 为true时输出距离而非距离平方
+ * @param use_grid: 为true时源点按BEV均匀网格排序，每个目标点只访问邻近的网格
+ * @return dist: (b, m, k)，数据类型与输入一致；idx: (b, m, k)
+ */
+std::tuple<at::Tensor, at::Tensor> knn(const at::Tensor& xyz, const at::Tensor& center_xyz, int32_t k,
+    bool is_from_knn, bool with_sqrt, bool use_grid)
+{
+    TORCH_CHECK(center_xyz.dim() == 3, "center_xyz.dim() must be 3, but got: ", center_xyz.dim());
+    TORCH_CHECK(xyz.dim() == 3 && xyz.size(1) == POINT_DIM, "xyz must be a 3D tensor with shape [B, 3, N].");
+    TORCH_CHECK(xyz.scalar_type() == center_xyz.scalar_type(), "xyz and center_xyz must have the same dtype.");
+    int64_t b = center_xyz.size(0);
+    int64_t m = center_xyz.size(1);
+    int64_t n = xyz.size(2);
+    KnnGrid grid;
+    if (use_grid) {
+        grid = BuildKnnGrid(xyz);
+    } else {
+        grid.sorted_xyz = xyz;
+        grid.cell_start = at::tensor({int32_t(0), static_cast<int32_t>(n)}, xyz.options().dtype(at::kInt))
+                              .repeat({b, 1});
+    }
 
+    at::Tensor dist;
+    at::Tensor idx;
+    if (xyz.device().is_cpu()) {
+        dist = at::empty({b, m, k}, center_xyz.options().dtype(at::kFloat));
+        idx = at::empty({b, m, k}, center_xyz.options().dtype(at::kInt));
+        KnnSearchCpu(grid.sorted_xyz.to(at::kFloat).contiguous(), center_xyz.to(at::kFloat).contiguous(),
+            grid.cell_start.contiguous(), grid, k, is_from_knn, dist, idx);
+        dist = with_sqrt ? dist.sqrt_() : dist;
+        dist = dist.to(center_xyz.scalar_type());
+    } else {
+        TORCH_CHECK_NPU(xyz);
+        TORCH_CHECK_NPU(center_xyz);
+        dist = at::zeros({b, m, k}, center_xyz.options());
+        idx = at::zeros({b, m, k}, center_xyz.options().dtype(at::kInt));
+        c10::optional<at::Tensor> cell_start;
+        c10::optional<at::Tensor> grid_bounds;
+        if (use_grid) {
+            cell_start = grid.cell_start;
+            grid_bounds = grid.bounds;
+        }
+        int64_t grid_x_num = grid.grid_x_num;
+        int64_t grid_y_num = grid.grid_y_num;
+        double low_x = grid.low_x;
+        double low_y = grid.low_y;
+        double cell_size = grid.cell_size;
+        EXEC_NPU_CMD_SYNC(aclnnKnn, grid.sorted_xyz, center_xyz, cell_start, grid_bounds, is_from_knn, k, with_sqrt,
+            use_grid, grid_x_num, grid_y_num, low_x, low_y, cell_size, dist, idx);
+    }
+    if (use_grid) {
+        // 排序后的下标映射回原始源点下标
+        auto sorted_idx = idx.reshape({b, m * k}).to(at::kLong).clamp(0, std::max(n - 1, int64_t(0)));
+        idx = grid.order.gather(1, sorted_idx).reshape({b, m, k}).to(at::kInt);
+    }
     return std::tie(dist, idx);
 }
@@ -17,11 +17,295 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+constexpr int64_t KERNEL_POINTS = 9;
+constexpr int64_t KERNEL_MAX_SETS = 2048;
+constexpr int64_t CORNERS_DIM = 8;
+constexpr int64_t RBOX_DIM = 5;
+constexpr int64_t SET_GRAIN = 64;
+// 设备实现每块中间结果(块大小, 点对数 + 1, K)的元素数上限，单个float32中间结果不超过256MB
+constexpr int64_t DEVICE_CHUNK_ELEMS = 64 * 1024 * 1024;
+constexpr double HALF_PI = 1.57079632679489661923;
+
+struct Point {
+    double x;
+    double y;
+};
+
+// 旋转角angle下的外接矩形，xmin等为点在旋转后坐标系(cos * x + sin * y, -sin * x + cos * y)中的范围
+struct MinRect {
+    double angle;
+    double xmin;
+    double ymin;
+    double xmax;
+    double ymax;
+};
+
+// 矩形旋转90度的整数倍后不变，角度统一到[0, pi / 2)，与kernel一致
+double FoldAngle(double angle)
+{
+    double folded = std::fmod(angle, HALF_PI);
+    return folded < 0 ? folded + HALF_PI : folded;
+}
+
+double Cross(const Point& o, const Point& a, const Point& b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Andrew单调链，输出去掉共线点的逆时针凸包
+void ConvexHull(std::vector<Point>& pts, std::vector<Point>& hull)
+{
+    auto less = [](const Point& a, const Point& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+    auto equal = [](const Point& a, const Point& b) { return a.x == b.x && a.y == b.y; };
+    std::sort(pts.begin(), pts.end(), less);
+    pts.erase(std::unique(pts.begin(), pts.end(), equal), pts.end());
+    int64_t n = static_cast<int64_t>(pts.size());
+    hull.clear();
+    if (n < 3) {
+        hull.assign(pts.begin(), pts.end());
+        return;
+    }
+    hull.resize(2 * n);
+    int64_t k = 0;
+    for (int64_t i = 0; i < n; i++) {
+        while (k >= 2 && Cross(hull[k - 2], hull[k - 1], pts[i]) <= 0) {
+            k--;
+        }
+        hull[k++] = pts[i];
+    }
+    for (int64_t i = n - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && Cross(hull[k - 2], hull[k - 1], pts[i]) <= 0) {
+            k--;
+        }
+        hull[k++] = pts[i];
+    }
+    hull.resize(k - 1);
+}
+
+MinRect BoundsAt(const std::vector<Point>& hull, double angle)
+{
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    MinRect rect {angle, std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    for (const Point& p : hull) {
+        double xr = c * p.x + s * p.y;
+        double yr = -s * p.x + c * p.y;
+        rect.xmin = std::min(rect.xmin, xr);
+        rect.xmax = std::max(rect.xmax, xr);
+        rect.ymin = std::min(rect.ymin, yr);
+        rect.ymax = std::max(rect.ymax, yr);
+    }
+    return rect;
+}
+
+/**
+ * 旋转卡壳：最小面积外接矩形必有一条边与凸包的某条边共线。逆时针逐边推进沿边方向u最远、
+ * 沿内法向v最远、沿u最近三个支撑点，每个支撑点只前进一圈，单个凸包为O(m)。
+ */
+MinRect RotatingCalipers(const std::vector<Point>& hull)
+{
+    int64_t m = static_cast<int64_t>(hull.size());
+    if (m == 0) {
+        return MinRect {0, 0, 0, 0, 0};
+    }
+    if (m < 3) {
+        double angle = m == 1 ? 0.0 : std::atan2(hull[1].y - hull[0].y, hull[1].x - hull[0].x);
+        return BoundsAt(hull, FoldAngle(angle));
+    }
+    auto dot = [&](int64_t idx, double ux, double uy) { return hull[idx % m].x * ux + hull[idx % m].y * uy; };
+    int64_t far_u = 1;
+    int64_t far_v = 1;
+    int64_t near_u = 1;
+    double best_area = std::numeric_limits<double>::max();
+    double best_angle = 0;
+    for (int64_t i = 0; i < m; i++) {
+        const Point& a = hull[i];
+        const Point& b = hull[(i + 1) % m];
+        double len = std::hypot(b.x - a.x, b.y - a.y);
+        double ux = (b.x - a.x) / len;
+        double uy = (b.y - a.y) / len;
+        double vx = -uy;
+        double vy = ux;
+        // 逆时针方向上支撑点依次为u、v、-u方向，后一个从前一个的位置开始推进
+        far_u = std::max(far_u, i + 1);
+        while (dot(far_u + 1, ux, uy) > dot(far_u, ux, uy)) {
+            far_u++;
+        }
+        far_v = std::max(far_v, far_u);
+        while (dot(far_v + 1, vx, vy) > dot(far_v, vx, vy)) {
+            far_v++;
+        }
+        near_u = std::max(near_u, far_v);
+        while (dot(near_u + 1, ux, uy) < dot(near_u, ux, uy)) {
+            near_u++;
+        }
+        double width = dot(far_u, ux, uy) - dot(near_u, ux, uy);
+        double height = dot(far_v, vx, vy) - (a.x * vx + a.y * vy);
+        double area = width * height;
+        if (area < best_area) {
+            best_area = area;
+            best_angle = std::atan2(uy, ux);
+        }
+    }
+    return BoundsAt(hull, FoldAngle(best_angle));
+}
+
+// rbox为(cx, cy, w, h, angle)，w沿angle方向；否则为4个角点，顺序与kernel一致
+template<typename T>
+void RectToOutput(T angle, T xmin, T ymin, T xmax, T ymax, T c, T s, bool rbox, std::vector<T>& out)
+{
+    if (rbox) {
+        T xc = (xmin + xmax) / 2;
+        T yc = (ymin + ymax) / 2;
+        out = {c * xc - s * yc, s * xc + c * yc, xmax - xmin, ymax - ymin, angle};
+        return;
+    }
+    out = {c * xmax - s * ymin, s * xmax + c * ymin, c * xmin - s * ymin, s * xmin + c * ymin, c * xmin - s * ymax,
+        s * xmin + c * ymax, c * xmax - s * ymax, s * xmax + c * ymax};
+}
+
+at::Tensor MinAreaRectCpu(const at::Tensor& pointsets, bool rbox)
+{
+    int64_t num_sets = pointsets.size(0);
+    int64_t num_points = pointsets.size(1) / 2;
+    int64_t out_dim = rbox ? RBOX_DIM : CORNERS_DIM;
+    at::Tensor pts = pointsets.to(at::kFloat).contiguous();
+    at::Tensor output = at::empty({num_sets, out_dim}, pts.options());
+    const float* pts_ptr = pts.data_ptr<float>();
+    float* out_ptr = output.data_ptr<float>();
+    at::parallel_for(0, num_sets, SET_GRAIN, [&](int64_t begin, int64_t end) {
+        std::vector<Point> buf;
+        std::vector<Point> hull;
+        std::vector<double> out;
+        buf.reserve(num_points);
+        for (int64_t n = begin; n < end; n++) {
+            const float* set = pts_ptr + n * num_points * 2;
+            buf.clear();
+            for (int64_t k = 0; k < num_points; k++) {
+                // 跳过inf/nan的点
+                if (std::isfinite(set[2 * k]) && std::isfinite(set[2 * k + 1])) {
+                    buf.push_back(Point {set[2 * k], set[2 * k + 1]});
+                }
+            }
+            ConvexHull(buf, hull);
+            MinRect rect = RotatingCalipers(hull);
+            RectToOutput<double>(rect.angle, rect.xmin, rect.ymin, rect.xmax, rect.ymax, std::cos(rect.angle),
+                std::sin(rect.angle), rbox, out);
+            std::copy(out.begin(), out.end(), out_ptr + n * out_dim);
+        }
+    });
+    return output.to(pointsets.scalar_type());
+}
+
+/**
+ * 候选方向取点集内全部点对的连线方向：其中包含凸包的每条边，多出的方向只会得到更大的外接矩形，
+ * 因此不需要在设备上求凸包，整批点集一次完成。与CPU实现一致，inf/nan的点不参与计算。
+ */
+at::Tensor MinAreaRectDeviceChunk(const at::Tensor& pts, const at::Tensor& pairs, bool rbox)
+{
+    int64_t num_sets = pts.size(0);
+    at::Tensor x = pts.select(2, 0);
+    at::Tensor y = pts.select(2, 1);
+    at::Tensor valid = x.isfinite() & y.isfinite();
+    at::Tensor pair_valid = valid.index_select(1, pairs[0]) & valid.index_select(1, pairs[1]);
+    at::Tensor dx = x.index_select(1, pairs[1]) - x.index_select(1, pairs[0]);
+    at::Tensor dy = y.index_select(1, pairs[1]) - y.index_select(1, pairs[0]);
+    // 含无效点的点对退化为已有的0度候选方向
+    at::Tensor pair_angle = at::atan2(dy, dx).masked_fill(pair_valid.logical_not(), 0);
+    at::Tensor angle = at::cat({at::zeros({num_sets, 1}, pts.options()), pair_angle}, 1);
+    angle = at::remainder(angle, HALF_PI);
+    at::Tensor c = angle.cos().unsqueeze(2);
+    at::Tensor s = angle.sin().unsqueeze(2);
+    at::Tensor xr = c * x.unsqueeze(1) + s * y.unsqueeze(1);
+    at::Tensor yr = c * y.unsqueeze(1) - s * x.unsqueeze(1);
+    at::Tensor invalid = valid.logical_not().unsqueeze(1);
+    double inf = std::numeric_limits<double>::infinity();
+    at::Tensor xmin = xr.masked_fill(invalid, inf).amin(2);
+    at::Tensor xmax = xr.masked_fill(invalid, -inf).amax(2);
+    at::Tensor ymin = yr.masked_fill(invalid, inf).amin(2);
+    at::Tensor ymax = yr.masked_fill(invalid, -inf).amax(2);
+    at::Tensor best = ((xmax - xmin) * (ymax - ymin)).argmin(1, true);
+    auto pick = [&](const at::Tensor& t) { return t.gather(1, best).squeeze(1); };
+    at::Tensor best_angle = pick(angle);
+    std::vector<at::Tensor> out;
+    RectToOutput<at::Tensor>(best_angle, pick(xmin), pick(ymin), pick(xmax), pick(ymax), best_angle.cos(),
+        best_angle.sin(), rbox, out);
+    // 没有有效点的点集输出全0，与CPU实现一致
+    return at::stack(out, 1).masked_fill(valid.any(1, true).logical_not(), 0);
+}
+
+at::Tensor MinAreaRectDevice(const at::Tensor& pointsets, bool rbox)
+{
+    int64_t num_points = pointsets.size(1) / 2;
+    at::Tensor pts = pointsets.to(at::kFloat).view({pointsets.size(0), num_points, 2});
+    at::Tensor pairs = at::triu_indices(num_points, num_points, 1, pts.options().dtype(at::kLong));
+    // 中间结果为(点集数, 点对数 + 1, 点数)，随K三次方增长，块大小按元素数上限确定
+    int64_t elems_per_set = (pairs.size(1) + 1) * num_points;
+    int64_t chunk_size = std::max<int64_t>(1, DEVICE_CHUNK_ELEMS / elems_per_set);
+    std::vector<at::Tensor> outputs;
+    for (const at::Tensor& chunk : pts.split(chunk_size)) {
+        outputs.push_back(MinAreaRectDeviceChunk(chunk, pairs, rbox));
+    }
+    return at::cat(outputs).to(pointsets.scalar_type());
+}
+
+void CheckPointsets(const at::Tensor& pointsets)
+{
+    TORCH_CHECK(pointsets.dim() == 2 && pointsets.size(1) >= 2 && pointsets.size(1) % 2 == 0,
+        "pointsets must be 2D tensor (N, 2K)");
+}
+} // namespace
+
+/**
+ * @brief 点集的最小面积外接矩形，输出4个角点
+ * @param pointsets: (N, 2K)，每行为K个点的(x, y)
+ * @return polygons: (N, 8)
+ *
+ * NPU上K为9、N不超过2048的float32输入使用kernel，其余情况及CPU上使用通用实现。
+ */
 at::Tensor min_area_polygons(const at::Tensor& pointsets)
 {
+    CheckPointsets(pointsets);
     int64_t N = pointsets.size(0);
+    if (N == 0) {
+        return at::zeros({0, CORNERS_DIM}, pointsets.options());
+    }
+    if (pointsets.device().is_cpu()) {
+        return MinAreaRectCpu(pointsets, false);
+    }
+    TORCH_CHECK_NPU(pointsets);
+    if (pointsets.size(1) != 2 * KERNEL_POINTS || N > KERNEL_MAX_SETS || pointsets.scalar_type() != at::kFloat) {
+        return MinAreaRectDevice(pointsets, false);
+    }
     c10::SmallVector<int64_t, 8> polygons_size = {N, 8};
     at::Tensor polygons = at::zeros(polygons_size, pointsets.options());
     EXEC_NPU_CMD(aclnnMinAreaPolygons, pointsets, polygons);
     return polygons;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 点集的最小面积外接矩形，直接输出旋转框
+ * @param pointsets: (N, 2K)，每行为K个点的(x, y)
+ * @return rboxes: (N, 5)，(cx, cy, w, h, angle)，w沿angle方向，angle为[0, pi / 2)内的逆时针弧度
+ */
+at::Tensor min_area_rects(const at::Tensor& pointsets)
+{
+    CheckPointsets(pointsets);
+    if (pointsets.size(0) == 0) {
+        return at::zeros({0, RBOX_DIM}, pointsets.options());
+    }
+    if (pointsets.device().is_cpu()) {
+        return MinAreaRectCpu(pointsets, true);
+    }
+    TORCH_CHECK_NPU(pointsets);
+    return MinAreaRectDevice(pointsets, true);
+}
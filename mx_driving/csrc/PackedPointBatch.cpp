@@ -0,0 +1,176 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/PackedPointBatch.h"
+#include "csrc/functions.h"
+
+namespace {
+at::Tensor PtrFromCounts(const at::Tensor& counts)
+{
+    return at::cat({at::zeros({1}, counts.options()), counts.cumsum(0)});
+}
+
+// index_add_代替bincount，输出大小固定为batch_size，不需要同步
+at::Tensor PtrFromBatchIndex(const at::Tensor& batch_idx, int64_t batch_size)
+{
+    at::Tensor counts = at::zeros({batch_size}, batch_idx.options()).index_add_(0, batch_idx, at::ones_like(batch_idx));
+    return PtrFromCounts(counts);
+}
+} // namespace
+
+PackedPointBatch PackedPointBatch::FromPadded(
+    const at::Tensor& padded, const c10::optional<at::Tensor>& counts, int64_t total)
+{
+    TORCH_CHECK(padded.dim() == 3, "padded must be a 3D tensor with shape [B, N, C].");
+    int64_t b = padded.size(0);
+    int64_t n = padded.size(1);
+    auto long_options = padded.options().dtype(at::kLong);
+    PackedPointBatch batch;
+    batch.max_count = n;
+    at::Tensor flat = padded.reshape({b * n, padded.size(2)});
+    if (!counts.has_value()) {
+        batch.points = flat;
+        batch.ptr = at::arange(0, b * n + 1, n, long_options);
+        batch.uniform_count = n;
+        return batch;
+    }
+    TORCH_CHECK(counts.value().dim() == 1 && counts.value().size(0) == b, "counts must be a 1D tensor with shape [B].");
+    batch.ptr = PtrFromCounts(counts.value().to(padded.device(), at::kLong));
+    if (total < 0) {
+        total = batch.ptr[b].item<int64_t>();
+    }
+    // 只搬运有效点：第i个有效点来自padded[batch_idx[i], i - ptr[batch_idx[i]]]
+    at::Tensor batch_idx = at::repeat_interleave(batch.ptr.diff(), total);
+    at::Tensor local_idx = at::arange(total, long_options) - batch.ptr.index_select(0, batch_idx);
+    batch.points = flat.index_select(0, batch_idx * n + local_idx);
+    return batch;
+}
+
+PackedPointBatch PackedPointBatch::FromPtr(const at::Tensor& points, const at::Tensor& ptr, int64_t max_count)
+{
+    TORCH_CHECK(points.dim() == 2, "points must be a 2D tensor with shape [total, C].");
+    TORCH_CHECK(ptr.dim() == 1 && ptr.size(0) >= 1, "ptr must be a 1D tensor with shape [B + 1].");
+    PackedPointBatch batch;
+    batch.points = points;
+    batch.ptr = ptr.to(points.device(), at::kLong);
+    batch.max_count = max_count;
+    return batch;
+}
+
+PackedPointBatch PackedPointBatch::FromBatchIndex(
+    const at::Tensor& points, const at::Tensor& batch_idx, int64_t batch_size, int64_t max_count)
+{
+    TORCH_CHECK(points.dim() == 2, "points must be a 2D tensor with shape [total, C].");
+    TORCH_CHECK(batch_idx.dim() == 1 && batch_idx.size(0) == points.size(0),
+        "batch_idx must be a 1D tensor with shape [total].");
+    PackedPointBatch batch;
+    batch.points = points;
+    batch.ptr = PtrFromBatchIndex(batch_idx.to(points.device(), at::kLong), batch_size);
+    batch.max_count = max_count;
+    return batch;
+}
+
+int64_t PackedPointBatch::MaxCount() const
+{
+    if (max_count >= 0) {
+        return max_count;
+    }
+    return BatchSize() == 0 ? 0 : Counts().max().item<int64_t>();
+}
+
+at::Tensor PackedPointBatch::Counts() const
+{
+    return ptr.diff();
+}
+
+at::Tensor PackedPointBatch::BatchIndex() const
+{
+    if (uniform_count > 0) {
+        return at::arange(Total(), ptr.options()).div(uniform_count, "floor");
+    }
+    return at::repeat_interleave(Counts(), Total());
+}
+
+at::Tensor PackedPointBatch::LocalIndex() const
+{
+    if (uniform_count > 0) {
+        return at::arange(Total(), ptr.options()).remainder(uniform_count);
+    }
+    return at::arange(Total(), ptr.options()) - ptr.index_select(0, BatchIndex());
+}
+
+at::Tensor PackedPointBatch::ToPadded(double pad_value) const
+{
+    int64_t b = BatchSize();
+    int64_t c = points.size(1);
+    if (uniform_count >= 0) {
+        return points.view({b, uniform_count, c});
+    }
+    int64_t n = MaxCount();
+    at::Tensor padded = at::full({b * n, c}, pad_value, points.options());
+    padded.index_copy_(0, BatchIndex() * n + LocalIndex(), points);
+    return padded.view({b, n, c});
+}
+
+/**
+ * @brief padded布局转为ptr布局
+ * @param padded: 3D tensor(B, N, C)
+ * @param counts: 每个样本的有效点数，1D tensor(B)，为空时所有样本均为N个点，输出为padded的零拷贝view
+ * @param total: 有效点总数，未知时为-1，会触发一次同步
+ * @return points: (total, C)；ptr: (B + 1)，int64
+ */
+std::tuple<at::Tensor, at::Tensor> packed_from_padded(
+    const at::Tensor& padded, const c10::optional<at::Tensor>& counts, int64_t total)
+{
+    PackedPointBatch batch = PackedPointBatch::FromPadded(padded, counts, total);
+    return std::make_tuple(batch.points, batch.ptr);
+}
+
+/**
+ * @brief ptr布局转为padded布局
+ * @param points: 2D tensor(total, C)
+ * @param ptr: 1D tensor(B + 1)
+ * @param max_count: 输出的N，需不小于最大样本点数，未知时为-1，会触发一次同步
+ * @param pad_value: 填充值
+ * @return padded: (B, max_count, C)
+ */
+at::Tensor packed_to_padded(const at::Tensor& points, const at::Tensor& ptr, int64_t max_count, double pad_value)
+{
+    return PackedPointBatch::FromPtr(points, ptr, max_count).ToPadded(pad_value);
+}
+
+/**
+ * @brief 由非降序的逐点batch下标求ptr，不需要同步
+ * @return ptr: (batch_size + 1)，int64
+ */
+at::Tensor packed_ptr_from_batch_index(const at::Tensor& batch_idx, int64_t batch_size)
+{
+    TORCH_CHECK(batch_idx.dim() == 1, "batch_idx must be a 1D tensor.");
+    return PtrFromBatchIndex(batch_idx.to(at::kLong), batch_size);
+}
+
+/**
+ * @brief 由ptr求每个点的batch下标和样本内下标
+ * @param total: 点总数，即ptr[B]
+ * @return batch_idx: (total)，int64；local_idx: (total)，int64
+ */
+std::tuple<at::Tensor, at::Tensor> packed_batch_index(const at::Tensor& ptr, int64_t total)
+{
+    TORCH_CHECK(ptr.dim() == 1 && ptr.size(0) >= 1, "ptr must be a 1D tensor with shape [B + 1].");
+    at::Tensor ptr_long = ptr.to(at::kLong);
+    at::Tensor batch_idx = at::repeat_interleave(ptr_long.diff(), total);
+    at::Tensor local_idx = at::arange(total, ptr_long.options()) - ptr_long.index_select(0, batch_idx);
+    return std::make_tuple(batch_idx, local_idx);
+}
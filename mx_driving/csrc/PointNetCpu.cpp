@@ -0,0 +1,365 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/CpuVecUtils.h"
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr int64_t ROW_GRAIN = 64;
+constexpr int64_t REDUCE_GRAIN = 4096;
+constexpr int64_t THREE_NN = 3;
+constexpr float INV_DIST_EPS = 1e-8f;
+constexpr int32_t AGGREGATE_AVG = 1;
+constexpr int32_t AGGREGATE_MAX = 2;
+// 反向scatter的线程私有缓冲区总量上限(float个数)，超过时减少参与累加的线程数
+constexpr int64_t MAX_PARTIAL_ELEMS = 64 * 1024 * 1024;
+
+using cpu_vec::Axpy;
+using cpu_vec::AddRow;
+using cpu_vec::Dot;
+
+// 由three_nn输出的距离计算反距离权重: w_j = (1 / (d_j + eps)) / sum_k (1 / (d_k + eps))
+inline const float* ThreeNNWeights(const float* weight, bool weight_is_dist, float* buffer)
+{
+    if (!weight_is_dist) {
+        return weight;
+    }
+    float norm = 0.f;
+    for (int64_t j = 0; j < THREE_NN; ++j) {
+        buffer[j] = 1.f / (weight[j] + INV_DIST_EPS);
+        norm += buffer[j];
+    }
+    for (int64_t j = 0; j < THREE_NN; ++j) {
+        buffer[j] /= norm;
+    }
+    return buffer;
+}
+
+// 通道维放到最后，使gather/scatter的每一行在内存中连续
+at::Tensor ChannelLast(const at::Tensor& t)
+{
+    return t.to(at::kFloat).transpose(1, t.dim() - 1).contiguous();
+}
+
+// 任务按线程均分，每个线程scatter到私有缓冲区(线程0直接写out)，最后按行归约，无需原子操作
+template<typename F>
+void ParallelScatterAdd(float* out, int64_t out_size, int64_t num_tasks, const F& scatter)
+{
+    int64_t num_threads = std::min<int64_t>(at::get_num_threads(), std::max<int64_t>(num_tasks / ROW_GRAIN, 1));
+    num_threads = std::min<int64_t>(num_threads, 1 + MAX_PARTIAL_ELEMS / std::max<int64_t>(out_size, 1));
+    if (num_threads <= 1) {
+        scatter(out, 0, num_tasks);
+        return;
+    }
+    std::vector<float> partial((num_threads - 1) * out_size, 0.f);
+    at::parallel_for(0, num_threads, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            float* dst = t == 0 ? out : partial.data() + (t - 1) * out_size;
+            scatter(dst, num_tasks * t / num_threads, num_tasks * (t + 1) / num_threads);
+        }
+    });
+    at::parallel_for(0, out_size, REDUCE_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t t = 1; t < num_threads; ++t) {
+            AddRow(out + begin, partial.data() + (t - 1) * out_size + begin, end - begin);
+        }
+    });
+}
+} // namespace
+
+at::Tensor group_points_cpu(const at::Tensor& points, const at::Tensor& idx)
+{
+    int64_t b = points.size(0);
+    int64_t c = points.size(1);
+    int64_t n = points.size(2);
+    int64_t npoints = idx.size(1);
+    int64_t nsample = idx.size(2);
+    auto feat = ChannelLast(points); // [b, n, c]
+    auto index = idx.to(at::kInt).contiguous();
+    auto out = at::empty({b, npoints, nsample, c}, feat.options());
+    const float* feat_ptr = feat.data_ptr<float>();
+    const int32_t* idx_ptr = index.data_ptr<int32_t>();
+    float* out_ptr = out.data_ptr<float>();
+    int64_t rows = npoints * nsample;
+    at::parallel_for(0, b * rows, ROW_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            const float* src = feat_ptr + (i / rows * n + idx_ptr[i]) * c;
+            std::memcpy(out_ptr + i * c, src, c * sizeof(float));
+        }
+    });
+    return out.permute({0, 3, 1, 2}).contiguous().to(points.scalar_type());
+}
+
+at::Tensor group_points_backward_cpu(const at::Tensor& grad_out, const at::Tensor& idx, int64_t n)
+{
+    int64_t b = grad_out.size(0);
+    int64_t c = grad_out.size(1);
+    int64_t rows = grad_out.size(2) * grad_out.size(3);
+    auto grad = ChannelLast(grad_out.reshape({b, c, rows})); // [b, rows, c]
+    auto index = idx.to(at::kInt).contiguous();
+    auto out = at::zeros({b, n, c}, grad.options());
+    const float* grad_ptr = grad.data_ptr<float>();
+    const int32_t* idx_ptr = index.data_ptr<int32_t>();
+    ParallelScatterAdd(out.data_ptr<float>(), out.numel(), b * rows, [&](float* dst, int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            AddRow(dst + (i / rows * n + idx_ptr[i]) * c, grad_ptr + i * c, c);
+        }
+    });
+    return out.transpose(1, 2).to(grad_out.scalar_type());
+}
+
+at::Tensor three_interpolate_cpu(
+    const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight, bool weight_is_dist)
+{
+    int64_t b = points.size(0);
+    int64_t c = points.size(1);
+    int64_t m = points.size(2);
+    int64_t n = idx.size(1);
+    auto feat = ChannelLast(points); // [b, m, c]
+    auto index = idx.to(at::kInt).contiguous();
+    auto w = weight.to(at::kFloat).contiguous();
+    auto out = at::zeros({b, n, c}, feat.options());
+    const float* feat_ptr = feat.data_ptr<float>();
+    const int32_t* idx_ptr = index.data_ptr<int32_t>();
+    const float* w_ptr = w.data_ptr<float>();
+    float* out_ptr = out.data_ptr<float>();
+    at::parallel_for(0, b * n, ROW_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            const float* batch_feat = feat_ptr + i / n * m * c;
+            float buffer[THREE_NN];
+            const float* wi = ThreeNNWeights(w_ptr + i * THREE_NN, weight_is_dist, buffer);
+            for (int64_t j = 0; j < THREE_NN; ++j) {
+                Axpy(out_ptr + i * c, batch_feat + idx_ptr[i * THREE_NN + j] * c, wi[j], c);
+            }
+        }
+    });
+    return out.transpose(1, 2).contiguous().to(points.scalar_type());
+}
+
+at::Tensor three_interpolate_backward_cpu(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight, int64_t m, bool weight_is_dist)
+{
+    int64_t b = grad_out.size(0);
+    int64_t c = grad_out.size(1);
+    int64_t n = grad_out.size(2);
+    auto grad = ChannelLast(grad_out); // [b, n, c]
+    auto index = idx.to(at::kInt).contiguous();
+    auto w = weight.to(at::kFloat).contiguous();
+    auto out = at::zeros({b, m, c}, grad.options());
+    const float* grad_ptr = grad.data_ptr<float>();
+    const int32_t* idx_ptr = index.data_ptr<int32_t>();
+    const float* w_ptr = w.data_ptr<float>();
+    ParallelScatterAdd(out.data_ptr<float>(), out.numel(), b * n, [&](float* dst, int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            float* batch_out = dst + i / n * m * c;
+            float buffer[THREE_NN];
+            const float* wi = ThreeNNWeights(w_ptr + i * THREE_NN, weight_is_dist, buffer);
+            for (int64_t j = 0; j < THREE_NN; ++j) {
+                Axpy(batch_out + idx_ptr[i * THREE_NN + j] * c, grad_ptr + i * c, wi[j], c);
+            }
+        }
+    });
+    return out.transpose(1, 2).contiguous().to(grad_out.scalar_type());
+}
+
+// 与mmcv一致：从第0个点开始，每次选取到已选点集最小距离最大的点，距离相同时取下标最小的点
+at::Tensor furthest_point_sampling_with_dist_cpu(
+    const at::Tensor& points_dist, const at::Tensor& nearest_temp, int32_t num_points)
+{
+    auto dist = points_dist.to(at::kFloat).contiguous();
+    int64_t b = dist.size(0);
+    int64_t n = dist.size(1);
+    auto temp = nearest_temp.to(at::kFloat).reshape({b, n}).clone();
+    auto output = at::zeros({b, static_cast<int64_t>(num_points)}, dist.options().dtype(at::kInt));
+    const float* dist_ptr = dist.data_ptr<float>();
+    float* temp_ptr = temp.data_ptr<float>();
+    int32_t* output_ptr = output.data_ptr<int32_t>();
+    at::parallel_for(0, b, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t batch = begin; batch < end; ++batch) {
+            float* nearest = temp_ptr + batch * n;
+            int32_t* idx = output_ptr + batch * num_points;
+            int64_t sampled = 0;
+            for (int32_t i = 1; i < num_points; ++i) {
+                const float* row = dist_ptr + (batch * n + sampled) * n;
+                float max_dist = -1.0f;
+                int64_t max_idx = 0;
+                for (int64_t k = 0; k < n; ++k) {
+                    float d = std::min(nearest[k], row[k]);
+                    nearest[k] = d;
+                    if (d > max_dist) {
+                        max_dist = d;
+                        max_idx = k;
+                    }
+                }
+                sampled = max_idx;
+                idx[i] = static_cast<int32_t>(max_idx);
+            }
+        }
+    });
+    return output;
+}
+
+// value[m, o] = scores[b, p, k, m] * (points[b, knn_idx[b, p, k], m, o] - centers[b, knn_idx[b, p, 0], m, o])
+// output[b, o, p, k]按aggregate对m取sum/avg/max，max时记录argmax供反向使用
+void assign_score_withk_cpu(const at::Tensor& points, const at::Tensor& centers, const at::Tensor& scores,
+    const at::Tensor& knn_idx, int32_t aggregate, at::Tensor& output, at::Tensor& argmax)
+{
+    int64_t b = points.size(0);
+    int64_t n = points.size(1);
+    int64_t m = points.size(2);
+    int64_t o = points.size(3);
+    int64_t npoint = scores.size(1);
+    int64_t k = scores.size(2);
+    auto points_f = points.to(at::kFloat).contiguous();
+    auto centers_f = centers.to(at::kFloat).contiguous();
+    auto scores_f = scores.to(at::kFloat).contiguous();
+    auto index = knn_idx.to(at::kLong).contiguous();
+    bool is_max = aggregate == AGGREGATE_MAX;
+    auto out = at::zeros({b, npoint, k, o}, points_f.options());
+    auto out_argmax = at::zeros({is_max ? b * npoint * k * o : 0}, points_f.options().dtype(at::kInt));
+    const float* points_ptr = points_f.data_ptr<float>();
+    const float* centers_ptr = centers_f.data_ptr<float>();
+    const float* scores_ptr = scores_f.data_ptr<float>();
+    const int64_t* idx_ptr = index.data_ptr<int64_t>();
+    float* out_ptr = out.data_ptr<float>();
+    int32_t* argmax_ptr = out_argmax.data_ptr<int32_t>();
+    float scale = aggregate == AGGREGATE_AVG ? 1.f / static_cast<float>(m) : 1.f;
+    at::parallel_for(0, b * npoint, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            int64_t batch = i / npoint;
+            const float* center = centers_ptr + (batch * n + idx_ptr[i * k]) * m * o;
+            for (int64_t j = 0; j < k; ++j) {
+                const float* point = points_ptr + (batch * n + idx_ptr[i * k + j]) * m * o;
+                const float* score = scores_ptr + (i * k + j) * m;
+                float* dst = out_ptr + (i * k + j) * o;
+                if (is_max) {
+                    int32_t* dst_argmax = argmax_ptr + (i * k + j) * o;
+                    for (int64_t c = 0; c < o; ++c) {
+                        float best = score[0] * (point[c] - center[c]);
+                        int32_t best_idx = 0;
+                        for (int64_t l = 1; l < m; ++l) {
+                            float value = score[l] * (point[l * o + c] - center[l * o + c]);
+                            if (value > best) {
+                                best = value;
+                                best_idx = static_cast<int32_t>(l);
+                            }
+                        }
+                        dst[c] = best;
+                        dst_argmax[c] = best_idx;
+                    }
+                    continue;
+                }
+                for (int64_t l = 0; l < m; ++l) {
+                    Axpy(dst, point + l * o, score[l] * scale, o);
+                    Axpy(dst, center + l * o, -score[l] * scale, o);
+                }
+            }
+        }
+    });
+    output.copy_(out.permute({0, 3, 1, 2}));
+    if (is_max) {
+        argmax.copy_(out_argmax.view({b, npoint, k, o}).permute({0, 3, 1, 2}));
+    }
+}
+
+void assign_score_withk_grad_cpu(const at::Tensor& grad_out, const at::Tensor& points, const at::Tensor& centers,
+    const at::Tensor& scores, const at::Tensor& knn_idx, const at::Tensor& argmax, int32_t aggregate,
+    at::Tensor& grad_points, at::Tensor& grad_centers, at::Tensor& grad_scores)
+{
+    int64_t b = points.size(0);
+    int64_t n = points.size(1);
+    int64_t m = points.size(2);
+    int64_t o = points.size(3);
+    int64_t npoint = scores.size(1);
+    int64_t k = scores.size(2);
+    bool is_max = aggregate == AGGREGATE_MAX;
+    auto grad = grad_out.to(at::kFloat).permute({0, 2, 3, 1}).contiguous(); // [b, npoint, k, o]
+    if (aggregate == AGGREGATE_AVG) {
+        grad.mul_(1.f / static_cast<float>(m));
+    }
+    auto grad_argmax = is_max ? argmax.to(at::kInt).permute({0, 2, 3, 1}).contiguous() : argmax.to(at::kInt);
+    auto points_f = points.to(at::kFloat).contiguous();
+    auto centers_f = centers.to(at::kFloat).contiguous();
+    auto scores_f = scores.to(at::kFloat).contiguous();
+    auto index = knn_idx.to(at::kLong).contiguous();
+    auto grad_scores_f = at::zeros({b, npoint, k, m}, points_f.options());
+    // points和centers的梯度共用一块缓冲区，前半部分为points
+    int64_t feature_size = b * n * m * o;
+    auto grad_features = at::zeros({2, b, n, m, o}, points_f.options());
+    const float* grad_ptr = grad.data_ptr<float>();
+    const int32_t* argmax_ptr = grad_argmax.data_ptr<int32_t>();
+    const float* points_ptr = points_f.data_ptr<float>();
+    const float* centers_ptr = centers_f.data_ptr<float>();
+    const float* scores_ptr = scores_f.data_ptr<float>();
+    const int64_t* idx_ptr = index.data_ptr<int64_t>();
+    float* grad_scores_ptr = grad_scores_f.data_ptr<float>();
+
+    at::parallel_for(0, b * npoint, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            int64_t batch = i / npoint;
+            const float* center = centers_ptr + (batch * n + idx_ptr[i * k]) * m * o;
+            for (int64_t j = 0; j < k; ++j) {
+                const float* point = points_ptr + (batch * n + idx_ptr[i * k + j]) * m * o;
+                const float* g = grad_ptr + (i * k + j) * o;
+                float* dst = grad_scores_ptr + (i * k + j) * m;
+                if (is_max) {
+                    // max聚合时每个通道只有argmax对应的权重行有梯度
+                    const int32_t* arg = argmax_ptr + (i * k + j) * o;
+                    for (int64_t c = 0; c < o; ++c) {
+                        dst[arg[c]] += g[c] * (point[arg[c] * o + c] - center[arg[c] * o + c]);
+                    }
+                    continue;
+                }
+                for (int64_t l = 0; l < m; ++l) {
+                    dst[l] = Dot(g, point + l * o, o) - Dot(g, center + l * o, o);
+                }
+            }
+        }
+    });
+    ParallelScatterAdd(grad_features.data_ptr<float>(), grad_features.numel(), b * npoint,
+        [&](float* dst, int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                int64_t batch = i / npoint;
+                float* center = dst + feature_size + (batch * n + idx_ptr[i * k]) * m * o;
+                for (int64_t j = 0; j < k; ++j) {
+                    float* point = dst + (batch * n + idx_ptr[i * k + j]) * m * o;
+                    const float* g = grad_ptr + (i * k + j) * o;
+                    const float* score = scores_ptr + (i * k + j) * m;
+                    if (is_max) {
+                        const int32_t* arg = argmax_ptr + (i * k + j) * o;
+                        for (int64_t c = 0; c < o; ++c) {
+                            float value = score[arg[c]] * g[c];
+                            point[arg[c] * o + c] += value;
+                            center[arg[c] * o + c] -= value;
+                        }
+                        continue;
+                    }
+                    for (int64_t l = 0; l < m; ++l) {
+                        Axpy(point + l * o, g, score[l], o);
+                        Axpy(center + l * o, g, -score[l], o);
+                    }
+                }
+            }
+        });
+    grad_scores.copy_(grad_scores_f);
+    grad_points.copy_(grad_features[0]);
+    grad_centers.copy_(grad_features[1]);
+}
@@ -17,10 +17,16 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+namespace {
+constexpr int64_t MAX_KERNEL_BOX_NUM = 200;
+} // namespace
+
 at::Tensor npu_points_in_box(const at::Tensor& boxes, const at::Tensor& pts)
 {
-    TORCH_CHECK(pts.size(0) == 1 && boxes.size(0) == 1, "points_in_box npu only support batch size = 1");
-    TORCH_CHECK(boxes.size(1) <= 200, "boxes is larger than 200");
+    // kernel只支持batch size为1且不超过200个框，其余情况及CPU tensor走BEV格子分桶的实现
+    if (pts.device().is_cpu() || pts.size(0) != 1 || boxes.size(0) != 1 || boxes.size(1) > MAX_KERNEL_BOX_NUM) {
+        return std::get<0>(points_in_boxes_grid(boxes, pts, false, 0));
+    }
     c10::SmallVector<int64_t, 8> output_size = {pts.size(0), pts.size(1)};
     at::Tensor out = at::empty(output_size, pts.options().dtype(at::kInt));
     auto boxes_trans = boxes.transpose(1, 2).contiguous();
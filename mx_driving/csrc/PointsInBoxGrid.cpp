@@ -0,0 +1,388 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr int64_t BOX_DIM = 7;
+constexpr int64_t POINT_DIM = 3;
+constexpr int64_t MAX_GRID_DIM = 1024;
+// 外接矩形的外扩量，避免舍入误差使框边界上的点落到格子外
+constexpr float EXTENT_PAD = 1e-4f;
+constexpr int64_t POINT_GRAIN = 1024;
+constexpr int64_t BOX_X = 0;
+constexpr int64_t BOX_Y = 1;
+constexpr int64_t BOX_Z = 2;
+constexpr int64_t BOX_DX = 3;
+constexpr int64_t BOX_DY = 4;
+constexpr int64_t BOX_DZ = 5;
+constexpr int64_t BOX_RZ = 6;
+
+// ---------------- CPU：逐batch的BEV格子 + 逐点扫描 ----------------
+struct BoxLocal {
+    float cx;
+    float cy;
+    float cz;
+    float hx;
+    float hy;
+    float hz;
+    float cosa;
+    float sina;
+};
+
+// 与points_in_box kernel一致：转到框的局部坐标后比较半边长，边界上的点算作框内
+inline bool PointInBox(const BoxLocal& box, const float* pt)
+{
+    if (std::abs(pt[2] - box.cz) > box.hz) {
+        return false;
+    }
+    float sx = pt[0] - box.cx;
+    float sy = pt[1] - box.cy;
+    float lx = sx * box.cosa + sy * box.sina;
+    float ly = -sx * box.sina + sy * box.cosa;
+    return std::abs(lx) <= box.hx && std::abs(ly) <= box.hy;
+}
+
+// 按格子计数排序的框下标，同一格子内的框保持升序，第一个命中即为下标最小的框
+struct BoxGrid {
+    float lo_x = 0;
+    float lo_y = 0;
+    float inv_cell = 0;
+    int64_t gx = 0;
+    int64_t gy = 0;
+    std::vector<int64_t> cell_start;
+    std::vector<int32_t> cell_boxes;
+
+    void Build(const std::vector<BoxLocal>& boxes, double cell_size)
+    {
+        int64_t num = static_cast<int64_t>(boxes.size());
+        if (num == 0) {
+            return;
+        }
+        std::vector<float> ext_x(num);
+        std::vector<float> ext_y(num);
+        float hi_x = -INFINITY;
+        float hi_y = -INFINITY;
+        lo_x = INFINITY;
+        lo_y = INFINITY;
+        double mean_extent = 0;
+        for (int64_t m = 0; m < num; m++) {
+            const BoxLocal& box = boxes[m];
+            ext_x[m] = std::abs(box.hx * box.cosa) + std::abs(box.hy * box.sina) + EXTENT_PAD;
+            ext_y[m] = std::abs(box.hx * box.sina) + std::abs(box.hy * box.cosa) + EXTENT_PAD;
+            lo_x = std::min(lo_x, box.cx - ext_x[m]);
+            lo_y = std::min(lo_y, box.cy - ext_y[m]);
+            hi_x = std::max(hi_x, box.cx + ext_x[m]);
+            hi_y = std::max(hi_y, box.cy + ext_y[m]);
+            mean_extent += 2 * std::max(ext_x[m], ext_y[m]);
+        }
+        double cell = cell_size > 0 ? cell_size : mean_extent / num;
+        // 保证(hi - lo) / cell < MAX_GRID_DIM - 1，整个外接范围都落在格子内
+        cell = std::max({cell, static_cast<double>(hi_x - lo_x) / (MAX_GRID_DIM - 1),
+            static_cast<double>(hi_y - lo_y) / (MAX_GRID_DIM - 1), 1e-6});
+        inv_cell = static_cast<float>(1.0 / cell);
+        gx = std::min<int64_t>(static_cast<int64_t>((hi_x - lo_x) * inv_cell) + 1, MAX_GRID_DIM);
+        gy = std::min<int64_t>(static_cast<int64_t>((hi_y - lo_y) * inv_cell) + 1, MAX_GRID_DIM);
+
+        std::vector<int64_t> range(num * 4);
+        cell_start.assign(gx * gy + 1, 0);
+        for (int64_t m = 0; m < num; m++) {
+            int64_t* r = range.data() + m * 4;
+            r[0] = CellX(boxes[m].cx - ext_x[m]);
+            r[1] = CellX(boxes[m].cx + ext_x[m]);
+            r[2] = CellY(boxes[m].cy - ext_y[m]);
+            r[3] = CellY(boxes[m].cy + ext_y[m]);
+            for (int64_t iy = r[2]; iy <= r[3]; iy++) {
+                for (int64_t ix = r[0]; ix <= r[1]; ix++) {
+                    cell_start[iy * gx + ix + 1]++;
+                }
+            }
+        }
+        for (int64_t c = 0; c < gx * gy; c++) {
+            cell_start[c + 1] += cell_start[c];
+        }
+        cell_boxes.resize(cell_start[gx * gy]);
+        std::vector<int64_t> fill(cell_start.begin(), cell_start.end() - 1);
+        for (int64_t m = 0; m < num; m++) {
+            const int64_t* r = range.data() + m * 4;
+            for (int64_t iy = r[2]; iy <= r[3]; iy++) {
+                for (int64_t ix = r[0]; ix <= r[1]; ix++) {
+                    cell_boxes[fill[iy * gx + ix]++] = static_cast<int32_t>(m);
+                }
+            }
+        }
+    }
+
+    int64_t CellX(float x) const
+    {
+        return std::min(std::max(static_cast<int64_t>(std::floor((x - lo_x) * inv_cell)), int64_t(0)), gx - 1);
+    }
+
+    int64_t CellY(float y) const
+    {
+        return std::min(std::max(static_cast<int64_t>(std::floor((y - lo_y) * inv_cell)), int64_t(0)), gy - 1);
+    }
+
+    // 点所在格子的候选框区间，落在所有框外接范围之外时为空
+    std::pair<int64_t, int64_t> Candidates(const float* pt) const
+    {
+        if (gx == 0) {
+            return {0, 0};
+        }
+        float fx = (pt[0] - lo_x) * inv_cell;
+        float fy = (pt[1] - lo_y) * inv_cell;
+        if (!(fx >= 0 && fy >= 0 && fx < gx && fy < gy)) {
+            return {0, 0};
+        }
+        int64_t cell = static_cast<int64_t>(fy) * gx + static_cast<int64_t>(fx);
+        return {cell_start[cell], cell_start[cell + 1]};
+    }
+};
+
+std::vector<BoxLocal> LoadBoxes(const float* boxes, int64_t num)
+{
+    std::vector<BoxLocal> out(num);
+    for (int64_t m = 0; m < num; m++) {
+        const float* box = boxes + m * BOX_DIM;
+        out[m] = {box[BOX_X], box[BOX_Y], box[BOX_Z], box[BOX_DX] / 2, box[BOX_DY] / 2, box[BOX_DZ] / 2,
+            std::cos(box[BOX_RZ]), std::sin(box[BOX_RZ])};
+    }
+    return out;
+}
+
+std::tuple<at::Tensor, at::Tensor> PointsInBoxesGridCpu(
+    const at::Tensor& boxes, const at::Tensor& pts, bool return_csr, double cell_size)
+{
+    int64_t batch = boxes.size(0);
+    int64_t num_boxes = boxes.size(1);
+    int64_t num_points = pts.size(1);
+    const float* boxes_ptr = boxes.data_ptr<float>();
+    const float* pts_ptr = pts.data_ptr<float>();
+    auto index_options = pts.options().dtype(at::kLong);
+
+    std::vector<std::vector<BoxLocal>> locals(batch);
+    std::vector<BoxGrid> grids(batch);
+    at::parallel_for(0, batch, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t b = begin; b < end; b++) {
+            locals[b] = LoadBoxes(boxes_ptr + b * num_boxes * BOX_DIM, num_boxes);
+            grids[b].Build(locals[b], cell_size);
+        }
+    });
+
+    int64_t total_points = batch * num_points;
+    // 对每个点扫描其格子内的候选框；on_hit返回false时停止扫描
+    auto scan = [&](int64_t p, auto&& on_hit) {
+        int64_t b = p / num_points;
+        const float* pt = pts_ptr + p * POINT_DIM;
+        const BoxGrid& grid = grids[b];
+        auto range = grid.Candidates(pt);
+        for (int64_t k = range.first; k < range.second; k++) {
+            int32_t m = grid.cell_boxes[k];
+            if (PointInBox(locals[b][m], pt) && !on_hit(m)) {
+                return;
+            }
+        }
+    };
+
+    if (!return_csr) {
+        at::Tensor first = at::empty({batch, num_points}, pts.options().dtype(at::kInt));
+        int32_t* first_ptr = first.data_ptr<int32_t>();
+        at::parallel_for(0, total_points, POINT_GRAIN, [&](int64_t begin, int64_t end) {
+            for (int64_t p = begin; p < end; p++) {
+                first_ptr[p] = -1;
+                scan(p, [&](int32_t m) {
+                    first_ptr[p] = m;
+                    return false;
+                });
+            }
+        });
+        return std::make_tuple(first, at::empty({0}, index_options));
+    }
+
+    // CSR：先逐点计数，前缀和后再填充；候选框来自同一格子，已按下标升序
+    at::Tensor ptr = at::zeros({total_points + 1}, index_options);
+    int64_t* ptr_data = ptr.data_ptr<int64_t>();
+    at::parallel_for(0, total_points, POINT_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t p = begin; p < end; p++) {
+            scan(p, [&](int32_t) {
+                ptr_data[p + 1]++;
+                return true;
+            });
+        }
+    });
+    for (int64_t p = 0; p < total_points; p++) {
+        ptr_data[p + 1] += ptr_data[p];
+    }
+    at::Tensor box_idx = at::empty({ptr_data[total_points]}, index_options);
+    int64_t* box_idx_data = box_idx.data_ptr<int64_t>();
+    at::parallel_for(0, total_points, POINT_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t p = begin; p < end; p++) {
+            int64_t offset = ptr_data[p];
+            scan(p, [&](int32_t m) {
+                box_idx_data[offset++] = m;
+                return true;
+            });
+        }
+    });
+    return std::make_tuple(ptr, box_idx);
+}
+
+// ---------------- device：全部batch共用一个BEV格子，候选对展开后向量化精筛 ----------------
+std::tuple<at::Tensor, at::Tensor> PointsInBoxesGridDevice(
+    const at::Tensor& boxes, const at::Tensor& pts, bool return_csr, double cell_size)
+{
+    int64_t batch = boxes.size(0);
+    int64_t num_boxes = boxes.size(1);
+    int64_t num_points = pts.size(1);
+    int64_t total_points = batch * num_points;
+    auto index_options = pts.options().dtype(at::kLong);
+    auto empty_result = [&]() {
+        if (return_csr) {
+            return std::make_tuple(at::zeros({total_points + 1}, index_options), at::empty({0}, index_options));
+        }
+        return std::make_tuple(
+            at::full({batch, num_points}, -1, pts.options().dtype(at::kInt)), at::empty({0}, index_options));
+    };
+    if (num_boxes == 0 || total_points == 0) {
+        return empty_result();
+    }
+
+    at::Tensor flat_boxes = boxes.reshape({-1, BOX_DIM});
+    at::Tensor flat_pts = pts.reshape({-1, POINT_DIM});
+    at::Tensor cx = flat_boxes.select(1, BOX_X);
+    at::Tensor cy = flat_boxes.select(1, BOX_Y);
+    at::Tensor cosa = flat_boxes.select(1, BOX_RZ).cos();
+    at::Tensor sina = flat_boxes.select(1, BOX_RZ).sin();
+    at::Tensor hx = flat_boxes.select(1, BOX_DX) * 0.5;
+    at::Tensor hy = flat_boxes.select(1, BOX_DY) * 0.5;
+    at::Tensor ext_x = (hx * cosa).abs() + (hy * sina).abs() + EXTENT_PAD;
+    at::Tensor ext_y = (hx * sina).abs() + (hy * cosa).abs() + EXTENT_PAD;
+
+    // 格子范围与边长留在device上，格子数与框覆盖的格子总数一次同步取回
+    at::Tensor lo_x = (cx - ext_x).min();
+    at::Tensor lo_y = (cy - ext_y).min();
+    at::Tensor span_x = (cx + ext_x).max() - lo_x;
+    at::Tensor span_y = (cy + ext_y).max() - lo_y;
+    at::Tensor cell =
+        cell_size > 0 ? at::full({}, cell_size, lo_x.options()) : (at::maximum(ext_x, ext_y) * 2).mean();
+    cell = at::stack({cell, span_x / (MAX_GRID_DIM - 1), span_y / (MAX_GRID_DIM - 1)}).amax().clamp_min(1e-6);
+    at::Tensor grid_x = at::floor(span_x / cell).clamp_max(MAX_GRID_DIM - 1) + 1;
+    at::Tensor grid_y = at::floor(span_y / cell).clamp_max(MAX_GRID_DIM - 1) + 1;
+
+    // 框覆盖的格子展开为(格子key, 框)对，key中带batch，按key * 框总数 + 框下标排序
+    auto cell_of = [&](const at::Tensor& v, const at::Tensor& lo, const at::Tensor& g) {
+        return at::minimum(at::floor((v - lo) / cell).clamp_min(0), g - 1).to(at::kLong);
+    };
+    at::Tensor ix0 = cell_of(cx - ext_x, lo_x, grid_x);
+    at::Tensor ix1 = cell_of(cx + ext_x, lo_x, grid_x);
+    at::Tensor iy0 = cell_of(cy - ext_y, lo_y, grid_y);
+    at::Tensor iy1 = cell_of(cy + ext_y, lo_y, grid_y);
+    at::Tensor width = ix1 - ix0 + 1;
+    at::Tensor cover = width * (iy1 - iy0 + 1);
+    at::Tensor sizes = at::stack({grid_x.to(at::kDouble), grid_y.to(at::kDouble), cover.sum().to(at::kDouble)}).cpu();
+    const double* s = sizes.data_ptr<double>();
+    int64_t gx = static_cast<int64_t>(s[0]);
+    int64_t gy = static_cast<int64_t>(s[1]);
+    int64_t total_cover = static_cast<int64_t>(s[2]);
+    at::Tensor box_id = at::repeat_interleave(cover, total_cover);
+    at::Tensor local = at::arange(total_cover, index_options) - (cover.cumsum(0) - cover).index_select(0, box_id);
+    at::Tensor w = width.index_select(0, box_id);
+    at::Tensor key = (box_id.div(num_boxes, "floor") * gy + iy0.index_select(0, box_id) + local.div(w, "floor")) * gx +
+                     ix0.index_select(0, box_id) + local.remainder(w);
+    int64_t total_boxes = batch * num_boxes;
+    at::Tensor sorted_key = std::get<0>((key * total_boxes + box_id).sort());
+    at::Tensor cell_key = sorted_key.div(total_boxes, "floor");
+    at::Tensor cell_boxes = sorted_key.remainder(total_boxes);
+
+    // 每个点所在格子的候选区间
+    at::Tensor px = flat_pts.select(1, 0);
+    at::Tensor py = flat_pts.select(1, 1);
+    at::Tensor fx = at::floor((px - lo_x) / cell);
+    at::Tensor fy = at::floor((py - lo_y) / cell);
+    at::Tensor in_grid = (fx >= 0) & (fx < gx) & (fy >= 0) & (fy < gy);
+    at::Tensor point_batch = at::arange(total_points, index_options).div(num_points, "floor");
+    at::Tensor point_key =
+        (point_batch * gy + fy.clamp(0, gy - 1).to(at::kLong)) * gx + fx.clamp(0, gx - 1).to(at::kLong);
+    at::Tensor start = at::searchsorted(cell_key, point_key);
+    at::Tensor end = at::searchsorted(cell_key, point_key, false, true);
+    at::Tensor count = (end - start) * in_grid.to(at::kLong);
+    int64_t total_pairs = count.sum().item<int64_t>();
+    if (total_pairs == 0) {
+        return empty_result();
+    }
+    at::Tensor pair_point = at::repeat_interleave(count, total_pairs);
+    at::Tensor pair_pos = start.index_select(0, pair_point) + at::arange(total_pairs, index_options) -
+                          (count.cumsum(0) - count).index_select(0, pair_point);
+    at::Tensor pair_box = cell_boxes.index_select(0, pair_pos);
+
+    // 精筛，与PointInBox一致
+    at::Tensor bp = flat_boxes.index_select(0, pair_box);
+    at::Tensor pp = flat_pts.index_select(0, pair_point);
+    at::Tensor pc = cosa.index_select(0, pair_box);
+    at::Tensor ps = sina.index_select(0, pair_box);
+    at::Tensor sx = pp.select(1, 0) - bp.select(1, BOX_X);
+    at::Tensor sy = pp.select(1, 1) - bp.select(1, BOX_Y);
+    at::Tensor inside = ((sx * pc + sy * ps).abs() <= bp.select(1, BOX_DX) * 0.5) &
+                        ((sy * pc - sx * ps).abs() <= bp.select(1, BOX_DY) * 0.5) &
+                        ((pp.select(1, 2) - bp.select(1, BOX_Z)).abs() <= bp.select(1, BOX_DZ) * 0.5);
+    at::Tensor keep = inside.nonzero().squeeze(1);
+    at::Tensor hit_point = pair_point.index_select(0, keep);
+    at::Tensor hit_box = pair_box.index_select(0, keep).remainder(num_boxes);
+
+    if (!return_csr) {
+        at::Tensor first = at::full({total_points}, num_boxes, index_options);
+        first.scatter_reduce_(0, hit_point, hit_box, "amin");
+        first.masked_fill_(first == num_boxes, -1);
+        return std::make_tuple(first.to(at::kInt).view({batch, num_points}), at::empty({0}, index_options));
+    }
+    // 候选对按点升序展开，同一点的候选来自同一格子且已按框下标升序
+    at::Tensor ptr = at::zeros({total_points + 1}, index_options);
+    ptr.narrow(0, 1, total_points).copy_(at::bincount(hit_point, {}, total_points).cumsum(0));
+    return std::make_tuple(ptr, hit_box);
+}
+} // namespace
+
+/**
+ * @brief 批量、框数不限的points in boxes：框按BEV格子分桶，每个点只检测所在格子内的框
+ * @param boxes: (B, M, 7)，(x, y, z, x_size, y_size, z_size, rz)，z为框中心
+ * @param pts: (B, N, 3)
+ * @param return_csr: false时返回每个点命中的下标最小的框(B, N)，int32，未命中为-1；
+ *                    true时返回CSR：ptr(B * N + 1)与box_idx(K)，均为int64，点b * N + n命中的框为
+ *                    box_idx[ptr[b * N + n]:ptr[b * N + n + 1]]，升序
+ * @param cell_size: 格子边长，小于等于0时取框BEV外接矩形边长的均值
+ * device输入时输出大小依赖数据，调用与host同步三次：格子数与展开数、候选对数、精筛结果
+ */
+std::tuple<at::Tensor, at::Tensor> points_in_boxes_grid(
+    const at::Tensor& boxes, const at::Tensor& pts, bool return_csr, double cell_size)
+{
+    TORCH_CHECK(boxes.dim() == 3 && boxes.size(2) == BOX_DIM, "boxes must be 3D tensor (B, M, 7)");
+    TORCH_CHECK(pts.dim() == 3 && pts.size(2) == POINT_DIM, "pts must be 3D tensor (B, N, 3)");
+    TORCH_CHECK(pts.size(0) == boxes.size(0), "points and boxes should have the same batch size");
+    at::Tensor boxes_fp32 = boxes.to(at::kFloat).contiguous();
+    at::Tensor pts_fp32 = pts.to(at::kFloat).contiguous();
+    if (pts.device().is_cpu()) {
+        return PointsInBoxesGridCpu(boxes_fp32, pts_fp32, return_csr, cell_size);
+    }
+    TORCH_CHECK_NPU(boxes);
+    TORCH_CHECK_NPU(pts);
+    return PointsInBoxesGridDevice(boxes_fp32, pts_fp32, return_csr, cell_size);
+}
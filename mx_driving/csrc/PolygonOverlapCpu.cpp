@@ -0,0 +1,369 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/PolygonOverlapCpu.h"
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr int CORNERS = 4;
+constexpr int64_t QUADRI_DIM = 8;
+constexpr int64_t BOX_GRAIN = 256;
+constexpr int64_t BLOCK_GRAIN = 64;
+constexpr int64_t FORMAT_FLAG_XYXYR = 0;
+constexpr int64_t FORMAT_FLAG_XYZXYZR = 2;
+constexpr int64_t FORMAT_FLAG_XYZWHDR = 3;
+constexpr int64_t UNIT_FLAG_DEGREE = 1;
+// 平行(夹角正弦)与共线(线间距/边长)判定的容差，对应float输入的精度；共线容差需覆盖平行容差下
+// 两条边范围内可能出现的线间距
+constexpr double PARALLEL_EPS = 1e-6;
+constexpr double COLLINEAR_EPS = 4e-6;
+constexpr double PI = 3.14159265358979323846;
+
+// 裁剪在double下进行：两框的公共交点分别从两侧的边求出，精度不足时边界积分无法闭合
+using Vec = at::vec::Vectorized<double>;
+constexpr int64_t LANES = Vec::size();
+
+// 中心与相对中心的逆时针角点，相对坐标保证大坐标下的精度
+struct BoxPolygon {
+    float cx;
+    float cy;
+    float x[CORNERS];
+    float y[CORNERS];
+    float area;
+};
+
+inline void EnsureCounterClockwise(BoxPolygon& poly, double signed_area)
+{
+    if (signed_area < 0) {
+        std::swap(poly.x[1], poly.x[3]);
+        std::swap(poly.y[1], poly.y[3]);
+    }
+}
+
+struct RectPolicy {
+    static BoxPolygon Build(const float* box, const PolygonBoxFormat& format)
+    {
+        BoxPolygon poly;
+        float hw;
+        float hh;
+        if (format.corner_format) {
+            float x1 = box[0];
+            float y1 = box[1];
+            float x2 = box[format.size_offset];
+            float y2 = box[format.size_offset + 1];
+            poly.cx = (x1 + x2) / 2;
+            poly.cy = (y1 + y2) / 2;
+            hw = (x2 - x1) / 2;
+            hh = (y2 - y1) / 2;
+        } else {
+            poly.cx = box[0];
+            poly.cy = box[1];
+            hw = box[format.size_offset] / 2;
+            hh = box[format.size_offset + 1] / 2;
+        }
+        double angle = static_cast<double>(box[format.angle_index]) * format.angle_scale;
+        float c = static_cast<float>(std::cos(angle));
+        float s = static_cast<float>(std::sin(angle));
+        const float u[CORNERS] = {-hw, hw, hw, -hw};
+        const float v[CORNERS] = {-hh, -hh, hh, hh};
+        for (int k = 0; k < CORNERS; k++) {
+            poly.x[k] = u[k] * c - v[k] * s;
+            poly.y[k] = u[k] * s + v[k] * c;
+        }
+        poly.area = std::abs(4 * hw * hh);
+        EnsureCounterClockwise(poly, hw * hh);
+        return poly;
+    }
+};
+
+struct QuadriPolicy {
+    static BoxPolygon Build(const float* box, const PolygonBoxFormat& format)
+    {
+        BoxPolygon poly;
+        poly.cx = (box[0] + box[2] + box[4] + box[6]) / CORNERS;
+        poly.cy = (box[1] + box[3] + box[5] + box[7]) / CORNERS;
+        for (int k = 0; k < CORNERS; k++) {
+            poly.x[k] = box[2 * k] - poly.cx;
+            poly.y[k] = box[2 * k + 1] - poly.cy;
+        }
+        double area = 0;
+        for (int k = 0; k < CORNERS; k++) {
+            int n = (k + 1) % CORNERS;
+            area += static_cast<double>(poly.x[k]) * poly.y[n] - static_cast<double>(poly.y[k]) * poly.x[n];
+        }
+        poly.area = static_cast<float>(std::abs(area) / 2);
+        EnsureCounterClockwise(poly, area);
+        return poly;
+    }
+};
+
+template <typename Policy>
+std::vector<BoxPolygon> BuildPolygons(const at::Tensor& boxes, const PolygonBoxFormat& format)
+{
+    int64_t num = boxes.size(0);
+    int64_t dim = boxes.size(1);
+    const float* ptr = boxes.data_ptr<float>();
+    std::vector<BoxPolygon> polys(num);
+    at::parallel_for(0, num, BOX_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+            polys[i] = Policy::Build(ptr + i * dim, format);
+        }
+    });
+    return polys;
+}
+
+/**
+ * p的各条边落在q内部的部分对1/2∮(x dy - y dx)的贡献，p、q均为逆时针，逐lane计算。
+ * 每条边P0 + t * d按q的4个半平面做Cyrus-Beck裁剪得到[t0, t1]，贡献为(t1 - t0) * cross(P0, d) / 2。
+ * 与q的某条边共线时：KeepShared为true则同向计入、反向舍弃，为false则一律舍弃，公共边只计一次。
+ */
+template <bool KeepShared>
+Vec BoundaryInside(const Vec (&px)[CORNERS], const Vec (&py)[CORNERS], const Vec (&qx)[CORNERS],
+    const Vec (&qy)[CORNERS])
+{
+    const Vec zero(0.0);
+    const Vec one(1.0);
+    const Vec eps2(PARALLEL_EPS * PARALLEL_EPS);
+    const Vec line_eps2(COLLINEAR_EPS * COLLINEAR_EPS);
+    Vec qex[CORNERS];
+    Vec qey[CORNERS];
+    Vec qe2[CORNERS];
+    for (int c = 0; c < CORNERS; c++) {
+        int cn = (c + 1) % CORNERS;
+        qex[c] = qx[cn] - qx[c];
+        qey[c] = qy[cn] - qy[c];
+        qe2[c] = qex[c] * qex[c] + qey[c] * qey[c];
+    }
+    Vec sum = zero;
+    for (int e = 0; e < CORNERS; e++) {
+        int en = (e + 1) % CORNERS;
+        Vec dx = px[en] - px[e];
+        Vec dy = py[en] - py[e];
+        Vec d2 = dx * dx + dy * dy;
+        Vec t0 = zero;
+        Vec t1 = one;
+        for (int c = 0; c < CORNERS; c++) {
+            // s(t) = s0 + t * s1 >= 0 时位于q的第c条边左侧
+            Vec rx = px[e] - qx[c];
+            Vec ry = py[e] - qy[c];
+            Vec s0 = qex[c] * ry - qey[c] * rx;
+            Vec s1 = qex[c] * dy - qey[c] * dx;
+            Vec parallel = s1 * s1 <= eps2 * d2 * qe2[c];
+            // 共线判定对两条边对称：交换p、q后结论不变，两侧对公共边的取舍才能一致
+            Vec s0_rev = dx * ry - dy * rx;
+            Vec len2 = line_eps2 * (d2 + qe2[c]);
+            Vec on_line = (s0 * s0 <= len2 * qe2[c]) & (s0_rev * s0_rev <= len2 * d2);
+            Vec same_dir = KeepShared ? (dx * qex[c] + dy * qey[c] > zero) : zero;
+            Vec inside = Vec::blendv(s0 > zero, same_dir, on_line);
+
+            Vec r = (zero - s0) / Vec::blendv(s1, one, parallel);
+            Vec enter = Vec::blendv(s1 > zero, zero, parallel);
+            Vec leave = Vec::blendv(s1 < zero, zero, parallel);
+            t0 = Vec::blendv(t0, at::vec::maximum(t0, r), enter);
+            t1 = Vec::blendv(t1, at::vec::minimum(t1, r), leave);
+            // 平行且位于外侧的边整条舍弃
+            t1 = Vec::blendv(t1, Vec::blendv(zero - one, t1, inside), parallel);
+        }
+        Vec len = at::vec::maximum(t1 - t0, zero);
+        sum = sum + len * (px[e] * dy - py[e] * dx);
+    }
+    return sum * Vec(0.5);
+}
+
+inline float Normalize(double inter, double area_a, double area_b, const PolygonOverlapOptions& options)
+{
+    if (area_a < options.min_area || area_b < options.min_area) {
+        return 0;
+    }
+    inter = std::max(inter, 0.0);
+    if (options.mode == POLYGON_MODE_IOU) {
+        double denom = std::max(area_a + area_b - inter, options.union_eps);
+        return denom > 0 ? static_cast<float>(inter / denom) : 0.0f;
+    }
+    if (options.mode == POLYGON_MODE_IOF) {
+        return area_a > 0 ? static_cast<float>(inter / area_a) : 0.0f;
+    }
+    return static_cast<float>(inter);
+}
+
+struct DensePairs {
+    int64_t num_b;
+    void operator()(int64_t k, int64_t& i, int64_t& j) const
+    {
+        i = k / num_b;
+        j = k - i * num_b;
+    }
+};
+
+struct AlignedPairs {
+    void operator()(int64_t k, int64_t& i, int64_t& j) const
+    {
+        i = k;
+        j = k;
+    }
+};
+
+struct IndexedPairs {
+    const int64_t* a_idx;
+    const int64_t* b_idx;
+    void operator()(int64_t k, int64_t& i, int64_t& j) const
+    {
+        i = a_idx[k];
+        j = b_idx[k];
+    }
+};
+
+// 每LANES个框对为一组：按SoA装入角点(平移到两框中心的中点)，整组一次裁剪，不足一组时重复最后一对
+template <typename PairIndex>
+void OverlapPairs(const std::vector<BoxPolygon>& polys_a, const std::vector<BoxPolygon>& polys_b, int64_t num_pairs,
+    const PairIndex& pair_index, const PolygonOverlapOptions& options, float* out)
+{
+    int64_t num_blocks = (num_pairs + LANES - 1) / LANES;
+    at::parallel_for(0, num_blocks, BLOCK_GRAIN, [&](int64_t begin, int64_t end) {
+        double ax[CORNERS][LANES];
+        double ay[CORNERS][LANES];
+        double bx[CORNERS][LANES];
+        double by[CORNERS][LANES];
+        double area_a[LANES];
+        double area_b[LANES];
+        double inter[LANES];
+        for (int64_t blk = begin; blk < end; blk++) {
+            int64_t base = blk * LANES;
+            int64_t valid = std::min(LANES, num_pairs - base);
+            for (int64_t l = 0; l < LANES; l++) {
+                int64_t i;
+                int64_t j;
+                pair_index(base + std::min(l, valid - 1), i, j);
+                const BoxPolygon& pa = polys_a[i];
+                const BoxPolygon& pb = polys_b[j];
+                double half_x = (static_cast<double>(pa.cx) - pb.cx) / 2;
+                double half_y = (static_cast<double>(pa.cy) - pb.cy) / 2;
+                for (int c = 0; c < CORNERS; c++) {
+                    ax[c][l] = half_x + pa.x[c];
+                    ay[c][l] = half_y + pa.y[c];
+                    bx[c][l] = pb.x[c] - half_x;
+                    by[c][l] = pb.y[c] - half_y;
+                }
+                area_a[l] = pa.area;
+                area_b[l] = pb.area;
+            }
+            Vec vax[CORNERS];
+            Vec vay[CORNERS];
+            Vec vbx[CORNERS];
+            Vec vby[CORNERS];
+            for (int c = 0; c < CORNERS; c++) {
+                vax[c] = Vec::loadu(ax[c]);
+                vay[c] = Vec::loadu(ay[c]);
+                vbx[c] = Vec::loadu(bx[c]);
+                vby[c] = Vec::loadu(by[c]);
+            }
+            Vec area = BoundaryInside<true>(vax, vay, vbx, vby) + BoundaryInside<false>(vbx, vby, vax, vay);
+            area.store(inter);
+            for (int64_t l = 0; l < valid; l++) {
+                out[base + l] = Normalize(inter[l], area_a[l], area_b[l], options);
+            }
+        }
+    });
+}
+
+template <typename PairIndex>
+void DispatchOverlap(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const PolygonBoxFormat& format,
+    const PolygonOverlapOptions& options, int64_t num_pairs, const PairIndex& pair_index, float* out)
+{
+    if (format.quadri) {
+        OverlapPairs(BuildPolygons<QuadriPolicy>(boxes_a, format), BuildPolygons<QuadriPolicy>(boxes_b, format),
+            num_pairs, pair_index, options, out);
+    } else {
+        OverlapPairs(BuildPolygons<RectPolicy>(boxes_a, format), BuildPolygons<RectPolicy>(boxes_b, format),
+            num_pairs, pair_index, options, out);
+    }
+}
+
+void CheckBoxes(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const PolygonBoxFormat& format)
+{
+    TORCH_CHECK(boxes_a.dim() == 2 && boxes_b.dim() == 2, "boxes must be 2D tensor.");
+    TORCH_CHECK(boxes_a.scalar_type() == at::kFloat && boxes_b.scalar_type() == at::kFloat,
+        "polygon overlap on CPU only support float32 tensor.");
+    int64_t min_dim = format.quadri ? QUADRI_DIM : std::max(format.size_offset + 2, format.angle_index + 1);
+    TORCH_CHECK(boxes_a.size(1) >= min_dim && boxes_b.size(1) >= min_dim, "boxes must have at least ", min_dim,
+        " columns.");
+}
+} // namespace
+
+PolygonBoxFormat PolygonBoxFormat::Bev(int64_t format_flag, int64_t unit_flag, bool clockwise)
+{
+    PolygonBoxFormat format;
+    bool with_z = format_flag == FORMAT_FLAG_XYZXYZR || format_flag == FORMAT_FLAG_XYZWHDR;
+    format.corner_format = format_flag == FORMAT_FLAG_XYXYR || format_flag == FORMAT_FLAG_XYZXYZR;
+    format.size_offset = with_z ? 3 : 2;
+    format.angle_index = with_z ? 6 : 4;
+    format.angle_scale = (unit_flag == UNIT_FLAG_DEGREE ? PI / 180 : 1.0) * (clockwise ? 1.0 : -1.0);
+    return format;
+}
+
+PolygonBoxFormat PolygonBoxFormat::Rotated(bool trans, bool degree)
+{
+    PolygonBoxFormat format;
+    format.corner_format = trans;
+    format.angle_scale = degree ? PI / 180 : 1.0;
+    return format;
+}
+
+PolygonBoxFormat PolygonBoxFormat::Quadri()
+{
+    PolygonBoxFormat format;
+    format.quadri = true;
+    return format;
+}
+
+at::Tensor polygon_overlap_cpu(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const PolygonBoxFormat& format,
+    const PolygonOverlapOptions& options, bool aligned)
+{
+    CheckBoxes(boxes_a, boxes_b, format);
+    at::Tensor a = boxes_a.contiguous();
+    at::Tensor b = boxes_b.contiguous();
+    int64_t num_a = a.size(0);
+    int64_t num_b = b.size(0);
+    if (aligned) {
+        TORCH_CHECK(num_a == num_b, "boxes_a and boxes_b must have the same number of boxes when aligned.");
+        at::Tensor out = at::empty({num_a}, a.options());
+        DispatchOverlap(a, b, format, options, num_a, AlignedPairs(), out.data_ptr<float>());
+        return out;
+    }
+    at::Tensor out = at::empty({num_a, num_b}, a.options());
+    if (num_b > 0) {
+        DispatchOverlap(a, b, format, options, num_a * num_b, DensePairs {num_b}, out.data_ptr<float>());
+    }
+    return out;
+}
+
+at::Tensor polygon_overlap_pairs_cpu(const at::Tensor& boxes_a, const at::Tensor& boxes_b, const at::Tensor& a_idx,
+    const at::Tensor& b_idx, const PolygonBoxFormat& format, const PolygonOverlapOptions& options)
+{
+    CheckBoxes(boxes_a, boxes_b, format);
+    TORCH_CHECK(a_idx.numel() == b_idx.numel(), "a_idx and b_idx must have the same length.");
+    at::Tensor ai = a_idx.to(at::kLong).contiguous();
+    at::Tensor bi = b_idx.to(at::kLong).contiguous();
+    at::Tensor out = at::empty({ai.numel()}, boxes_a.options());
+    DispatchOverlap(boxes_a.contiguous(), boxes_b.contiguous(), format, options, ai.numel(),
+        IndexedPairs {ai.data_ptr<int64_t>(), bi.data_ptr<int64_t>()}, out.data_ptr<float>());
+    return out;
+}
@@ -22,24 +22,27 @@ using namespace std;
 constexpr uint32_t ALIGN_NUM = 8;
 constexpr uint32_t NUM_COORDINATES = 2; // Two-dimensional coordinates
 
+/**
+ * @brief 二维点按batch求半径邻域
+ * @param padded: 为true时输出预先填充为-1，有效邻居位于前actual_num_neighbors[0]列
+ * @return out: (2, num_points_y * max_num_neighbors)；actual_num_neighbors: (8)，第0个元素为邻居总数
+ */
 std::tuple<at::Tensor, at::Tensor> radius(at::Tensor& x, at::Tensor& y, at::Tensor& ptr_x, at::Tensor& ptr_y,
-                                          double r, int max_num_neighbors)
+                                          double r, int max_num_neighbors, bool padded)
 {
     TORCH_CHECK_NPU(x);
     TORCH_CHECK_NPU(y);
     TORCH_CHECK_NPU(ptr_x);
     TORCH_CHECK_NPU(ptr_y);
-    auto x_shape = x.sizes(); // [num_points_x, 2]
     auto y_shape = y.sizes(); // [num_points_y, 2]
-    auto ptr_x_shape = ptr_x.sizes(); // [batch_size + 1]
     auto x_trans = x.transpose(0, 1).contiguous(); // [2, num_points_x]
     auto y_trans = y.transpose(0, 1).contiguous(); // [2, num_points_y]
-    int out_dim = y_shape[0] * max_num_neighbors;
-    int batch_size = ptr_x_shape[0] - 1;
-    auto out_temp = at::zeros({NUM_COORDINATES, out_dim}, ptr_x.options().dtype(at::kInt)); // [2, num_points_y * max_num_neighbors], used to hold intermediate results for non-continuous distributions.
-    auto out_final = at::zeros({NUM_COORDINATES, out_dim}, ptr_x.options().dtype(at::kInt)); // [2, num_points_y * max_num_neighbors], used to store the final results of continuous distributions.
+    int64_t out_dim = y_shape[0] * max_num_neighbors;
+    // The kernel counts the neighbors of every core first and writes each pair to its final position directly.
+    auto out = padded ? at::full({NUM_COORDINATES, out_dim}, -1, ptr_x.options().dtype(at::kInt)) :
+                        at::empty({NUM_COORDINATES, out_dim}, ptr_x.options().dtype(at::kInt));
     auto actual_num_neighbors = at::zeros({ALIGN_NUM}, ptr_x.options().dtype(at::kInt));
-    EXEC_NPU_CMD(aclnnRadius, x_trans, y_trans, ptr_x, ptr_y, r,  max_num_neighbors, out_temp, out_final, actual_num_neighbors);
+    EXEC_NPU_CMD(aclnnRadius, x_trans, y_trans, ptr_x, ptr_y, r, max_num_neighbors, out, actual_num_neighbors);
 
-    return std::tie(out_final, actual_num_neighbors);
+    return std::tie(out, actual_num_neighbors);
 }
@@ -0,0 +1,230 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/RoiAlignRotatedCpu.h"
+#include "csrc/CpuBilinear.h"
+#include "csrc/CpuVecUtils.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int64_t ROI_DIM = 6;
+constexpr int64_t ROI_GRAIN = 1;
+constexpr int64_t CHANNEL_GRAIN = 16;
+
+using cpu_bilinear::Bilinear;
+using cpu_bilinear::BilinearTap;
+using cpu_bilinear::TAPS;
+using cpu_vec::Axpy;
+
+// 单个roi缩放、旋转后的采样网格，计算方式与kernel一致
+struct RoiGrid {
+    int64_t batch;
+    float center_w;
+    float center_h;
+    float start_w;
+    float start_h;
+    float bin_w;
+    float bin_h;
+    float cos_t;
+    float sin_t;
+    int64_t grid_w;
+    int64_t grid_h;
+    float inv_count;
+};
+
+void RoiSize(float roi_w, float roi_h, const RoiAlignRotatedParams& params, float& width, float& height)
+{
+    float scale = static_cast<float>(params.spatial_scale);
+    width = roi_w * scale;
+    height = roi_h * scale;
+    if (!params.aligned) {
+        width = std::max(width, 1.0f);
+        height = std::max(height, 1.0f);
+    }
+}
+
+int64_t GridSize(float size, int64_t pooled, int64_t sampling_ratio)
+{
+    return sampling_ratio > 0 ? sampling_ratio : static_cast<int64_t>(std::ceil(size / static_cast<float>(pooled)));
+}
+
+RoiGrid MakeRoiGrid(const float* roi, const RoiAlignRotatedParams& params)
+{
+    float scale = static_cast<float>(params.spatial_scale);
+    float offset = params.aligned ? 0.5f : 0.0f;
+    float theta = params.clockwise ? -roi[5] : roi[5];
+    float width = 0;
+    float height = 0;
+    RoiSize(roi[3], roi[4], params, width, height);
+
+    RoiGrid grid;
+    grid.batch = static_cast<int64_t>(roi[0]);
+    grid.center_w = roi[1] * scale - offset;
+    grid.center_h = roi[2] * scale - offset;
+    grid.start_w = -width / 2;
+    grid.start_h = -height / 2;
+    grid.bin_w = width / static_cast<float>(params.pooled_width);
+    grid.bin_h = height / static_cast<float>(params.pooled_height);
+    grid.cos_t = std::cos(theta);
+    grid.sin_t = std::sin(theta);
+    grid.grid_w = GridSize(width, params.pooled_width, params.sampling_ratio);
+    grid.grid_h = GridSize(height, params.pooled_height, params.sampling_ratio);
+    grid.inv_count = 1.0f / static_cast<float>(std::max<int64_t>(grid.grid_h * grid.grid_w, 1));
+    return grid;
+}
+
+// 对(ph, pw)这个bin内每个落在特征图范围内的采样点调用fn
+template<typename F>
+void ForEachSample(const RoiGrid& grid, int64_t ph, int64_t pw, int64_t height, int64_t width, F&& fn)
+{
+    for (int64_t iy = 0; iy < grid.grid_h; iy++) {
+        float yy = grid.start_h + ph * grid.bin_h +
+                   (static_cast<float>(iy) + 0.5f) * grid.bin_h / static_cast<float>(grid.grid_h);
+        for (int64_t ix = 0; ix < grid.grid_w; ix++) {
+            float xx = grid.start_w + pw * grid.bin_w +
+                       (static_cast<float>(ix) + 0.5f) * grid.bin_w / static_cast<float>(grid.grid_w);
+            float y = yy * grid.cos_t - xx * grid.sin_t + grid.center_h;
+            float x = yy * grid.sin_t + xx * grid.cos_t + grid.center_w;
+            BilinearTap tap;
+            if (Bilinear(y, x, height, width, tap)) {
+                fn(tap);
+            }
+        }
+    }
+}
+} // namespace
+
+at::Tensor roi_align_rotated_balanced_order(const at::Tensor& rois, const RoiAlignRotatedParams& params,
+    int64_t min_rois)
+{
+    int64_t num_rois = rois.size(0);
+    if (params.sampling_ratio > 0 || num_rois < std::max<int64_t>(min_rois, 2)) {
+        return at::Tensor();
+    }
+    // 开销与排序都在rois所在设备上计算，不回传host
+    float scale = static_cast<float>(params.spatial_scale);
+    at::Tensor width = rois.select(1, 3).to(at::kFloat) * scale;
+    at::Tensor height = rois.select(1, 4).to(at::kFloat) * scale;
+    if (!params.aligned) {
+        width = width.clamp_min(1.0f);
+        height = height.clamp_min(1.0f);
+    }
+    at::Tensor grid_w = at::ceil(width / static_cast<float>(params.pooled_width)).to(at::kLong);
+    at::Tensor grid_h = at::ceil(height / static_cast<float>(params.pooled_height)).to(at::kLong);
+    at::Tensor cost = (grid_w * grid_h).clamp_min(1);
+    at::Tensor sorted = std::get<1>(cost.sort(true, 0, true));
+
+    // 最重与最轻交替排列，相邻两个roi的开销之和接近两倍平均开销
+    at::Tensor k = at::arange(num_rois, sorted.options());
+    at::Tensor half = k.div(2, "floor");
+    at::Tensor pick = at::where(k.remainder(2) == 0, half, num_rois - 1 - half);
+    return sorted.index_select(0, pick);
+}
+
+void roi_align_rotated_forward_cpu(const at::Tensor& input, const at::Tensor& rois, at::Tensor& output,
+    const RoiAlignRotatedParams& params)
+{
+    int64_t batch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t height = input.size(2);
+    int64_t width = input.size(3);
+    int64_t num_rois = rois.size(0);
+    if (num_rois == 0 || channels == 0) {
+        return;
+    }
+    int64_t pooled_h = params.pooled_height;
+    int64_t pooled_w = params.pooled_width;
+    int64_t roi_stride = pooled_h * pooled_w * channels;
+    // NHWC下每个像素的通道连续，双线性插值按整行累加
+    at::Tensor feature = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor roi_data = rois.to(at::kFloat).contiguous();
+    at::Tensor order = roi_align_rotated_balanced_order(roi_data, params, 0);
+    at::Tensor result = at::zeros({num_rois, pooled_h, pooled_w, channels}, feature.options());
+
+    const float* feat = feature.data_ptr<float>();
+    const float* roi_ptr = roi_data.data_ptr<float>();
+    const int64_t* order_ptr = order.defined() ? order.data_ptr<int64_t>() : nullptr;
+    float* out = result.data_ptr<float>();
+    at::parallel_for(0, num_rois, ROI_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+            int64_t n = order_ptr != nullptr ? order_ptr[k] : k;
+            RoiGrid grid = MakeRoiGrid(roi_ptr + n * ROI_DIM, params);
+            if (grid.batch < 0 || grid.batch >= batch) {
+                continue;
+            }
+            const float* feat_b = feat + grid.batch * height * width * channels;
+            for (int64_t ph = 0; ph < pooled_h; ph++) {
+                for (int64_t pw = 0; pw < pooled_w; pw++) {
+                    float* out_bin = out + n * roi_stride + (ph * pooled_w + pw) * channels;
+                    ForEachSample(grid, ph, pw, height, width, [&](const BilinearTap& tap) {
+                        for (int t = 0; t < TAPS; t++) {
+                            Axpy(out_bin, feat_b + tap.offset[t] * channels, tap.weight[t] * grid.inv_count,
+                                channels);
+                        }
+                    });
+                }
+            }
+        }
+    });
+    output.copy_(result);
+}
+
+at::Tensor roi_align_rotated_backward_cpu(const at::Tensor& input, const at::Tensor& rois,
+    const at::Tensor& grad_output, const RoiAlignRotatedParams& params)
+{
+    int64_t batch = input.size(0);
+    int64_t channels = input.size(1);
+    int64_t height = input.size(2);
+    int64_t width = input.size(3);
+    int64_t num_rois = rois.size(0);
+    at::Tensor grad_input = at::zeros({batch, height, width, channels}, input.options().dtype(at::kFloat));
+    if (num_rois == 0 || channels == 0) {
+        return grad_input.to(input.scalar_type());
+    }
+    int64_t pooled_h = params.pooled_height;
+    int64_t pooled_w = params.pooled_width;
+    at::Tensor grad = grad_output.to(at::kFloat).contiguous();
+    at::Tensor roi_data = rois.to(at::kFloat).contiguous();
+
+    const float* grad_ptr = grad.data_ptr<float>();
+    const float* roi_ptr = roi_data.data_ptr<float>();
+    float* grad_in = grad_input.data_ptr<float>();
+    // 按通道区间并行：每个线程遍历全部roi但只写自己的通道区间，roi网格在各区间内重复计算
+    at::parallel_for(0, channels, CHANNEL_GRAIN, [&](int64_t begin, int64_t end) {
+        int64_t len = end - begin;
+        for (int64_t n = 0; n < num_rois; n++) {
+            RoiGrid grid = MakeRoiGrid(roi_ptr + n * ROI_DIM, params);
+            if (grid.batch < 0 || grid.batch >= batch) {
+                continue;
+            }
+            float* grad_b = grad_in + grid.batch * height * width * channels + begin;
+            for (int64_t ph = 0; ph < pooled_h; ph++) {
+                for (int64_t pw = 0; pw < pooled_w; pw++) {
+                    const float* grad_bin = grad_ptr + ((n * pooled_h + ph) * pooled_w + pw) * channels + begin;
+                    ForEachSample(grid, ph, pw, height, width, [&](const BilinearTap& tap) {
+                        for (int t = 0; t < TAPS; t++) {
+                            Axpy(grad_b + tap.offset[t] * channels, grad_bin, tap.weight[t] * grid.inv_count, len);
+                        }
+                    });
+                }
+            }
+        }
+    });
+    return grad_input.to(input.scalar_type());
+}
@@ -15,20 +15,53 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/RoiAlignRotatedCpu.h"
 #include "csrc/functions.h"
 
+namespace {
+constexpr int64_t BALANCE_MIN_ROIS = 16;
+} // namespace
+
+/**
+ * @brief 旋转框RoI Align反向
+ * @param input: (B, C, H, W)，只使用形状与精度
+ * @param rois: (6, n)
+ * @param grad_output: (n, pooled_height, pooled_width, C)
+ * @return grad_input: (B, H, W, C)，与input同精度
+ *
+ * 与前向相同，半精度在kernel前后转换，sampling_ratio为0时rois与grad_output按同一顺序重排；
+ * 梯度按下标累加到特征图，重排不影响结果的位置。
+ */
 at::Tensor npu_roi_align_rotated_grad_v2(const at::Tensor& input, const at::Tensor& rois, const at::Tensor& grad_output,
     int32_t pooled_height, int32_t pooled_width, double spatial_scale, int32_t sampling_ratio, bool aligned,
     bool clockwise)
 {
     auto ori_dtype = input.scalar_type();
+    RoiAlignRotatedParams params {spatial_scale, sampling_ratio, pooled_height, pooled_width, aligned, clockwise};
+    if (input.device().is_cpu()) {
+        return roi_align_rotated_backward_cpu(input, rois.permute({1, 0}), grad_output, params);
+    }
+    TORCH_CHECK_NPU(input);
+
+    at::Tensor rois_fp32 = rois.to(at::kFloat);
+    at::Tensor grad_fp32 = grad_output.to(at::kFloat);
+    at::Tensor order = roi_align_rotated_balanced_order(rois_fp32.permute({1, 0}), params, BALANCE_MIN_ROIS);
+    if (order.defined()) {
+        rois_fp32 = rois_fp32.index_select(1, order);
+        grad_fp32 = grad_fp32.index_select(0, order);
+    }
+    rois_fp32 = rois_fp32.contiguous();
+    grad_fp32 = grad_fp32.contiguous();
+    // kernel不读取input的数据，半精度时只需要一个同形状的float占位
+    at::Tensor input_fp32 =
+        ori_dtype == at::kFloat ? input : at::empty(input.sizes(), input.options().dtype(at::kFloat));
 
     c10::SmallVector<int64_t, SIZE> grad_input_size = {input.size(0), input.size(2), input.size(3), input.size(1)};
 
-    at::Tensor grad_input = at::zeros(grad_input_size, input.options());
+    at::Tensor grad_input = at::zeros(grad_input_size, input_fp32.options());
 
-    EXEC_NPU_CMD(aclnnRoiAlignRotatedGradV2, input, rois, grad_output, pooled_height, pooled_width, spatial_scale,
-        sampling_ratio, aligned, clockwise, grad_input);
+    EXEC_NPU_CMD(aclnnRoiAlignRotatedGradV2, input_fp32, rois_fp32, grad_fp32, pooled_height, pooled_width,
+        spatial_scale, sampling_ratio, aligned, clockwise, grad_input);
 
     return grad_input.to(ori_dtype);
 }
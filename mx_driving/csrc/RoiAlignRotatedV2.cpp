@@ -15,14 +15,52 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/RoiAlignRotatedCpu.h"
 #include "csrc/functions.h"
 
+namespace {
+// kernel按8个roi的整数倍分核，roi太少时重排没有收益
+constexpr int64_t BALANCE_MIN_ROIS = 16;
+} // namespace
+
+/**
+ * @brief 旋转框RoI Align前向
+ * @param input: (B, C, H, W)，float32/float16/bfloat16
+ * @param rois_map: (n, 6)
+ * @param output: (n, pooled_height, pooled_width, C)，与input同精度，需预先置零
+ *
+ * kernel只支持float32，半精度在kernel前后转换；sampling_ratio为0时按采样点数重排roi，
+ * 使kernel静态切分到各核的连续roi开销均衡，输出再按原顺序写回。
+ */
 void roi_align_rotated_v2_forward_npu(const at::Tensor& input, const at::Tensor& rois_map, at::Tensor& output,
     double spatial_scale, int32_t sampling_ratio, int32_t pooled_height, int32_t pooled_width, bool aligned,
     bool clockwise)
 {
-    at::Tensor feature_map = input.permute({0, 2, 3, 1}).contiguous();
-    at::Tensor rois = rois_map.permute({1, 0}).contiguous();
+    RoiAlignRotatedParams params {spatial_scale, sampling_ratio, pooled_height, pooled_width, aligned, clockwise};
+    if (input.device().is_cpu()) {
+        roi_align_rotated_forward_cpu(input, rois_map, output, params);
+        return;
+    }
+    TORCH_CHECK_NPU(input);
+    at::Tensor feature_map = input.permute({0, 2, 3, 1}).to(at::kFloat).contiguous();
+    at::Tensor rois_fp32 = rois_map.to(at::kFloat);
+    at::Tensor order = roi_align_rotated_balanced_order(rois_fp32, params, BALANCE_MIN_ROIS);
+    if (order.defined()) {
+        rois_fp32 = rois_fp32.index_select(0, order);
+    }
+    at::Tensor rois = rois_fp32.permute({1, 0}).contiguous();
+    if (!order.defined() && output.scalar_type() == at::kFloat) {
+        EXEC_NPU_CMD(aclnnRoiAlignRotatedV2, feature_map, rois, spatial_scale, sampling_ratio, pooled_height,
+            pooled_width, aligned, clockwise, output);
+        return;
+    }
+    // kernel在通道非对齐时原子累加，临时输出同样需要置零
+    at::Tensor result = at::zeros(output.sizes(), output.options().dtype(at::kFloat));
     EXEC_NPU_CMD(aclnnRoiAlignRotatedV2, feature_map, rois, spatial_scale, sampling_ratio, pooled_height, pooled_width,
-        aligned, clockwise, output);
+        aligned, clockwise, result);
+    if (order.defined()) {
+        output.index_copy_(0, order, result.to(output.scalar_type()));
+    } else {
+        output.copy_(result);
+    }
 }
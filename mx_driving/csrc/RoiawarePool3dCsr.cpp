@@ -0,0 +1,252 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <vector>
+
+namespace {
+constexpr int64_t ROI_DIM = 7;
+constexpr int64_t POINT_DIM = 3;
+constexpr int64_t POOL_MAX = 0;
+constexpr int64_t POOL_AVG = 1;
+// 查询候选点时roi三个方向的外扩量，精筛仍按roiaware_pool3d原有的判定
+constexpr double CANDIDATE_PAD = 1e-3;
+constexpr float MAX_INIT = -1e10f;
+constexpr int64_t VOXEL_GRAIN = 64;
+
+/**
+ * (roi, voxel) -> 点的CSR，只包含非空voxel
+ * voxel_idx: (Kv)，roi * out_x * out_y * out_z + voxel，升序
+ * voxel_ptr: (Kv + 1)，第k个voxel的点为pts_idx[voxel_ptr[k]:voxel_ptr[k + 1]]，按点下标升序
+ */
+struct VoxelCsr {
+    at::Tensor voxel_idx;
+    at::Tensor voxel_ptr;
+    at::Tensor pts_idx;
+};
+
+VoxelCsr EmptyCsr(const at::TensorOptions& index_options)
+{
+    return {at::empty({0}, index_options), at::zeros({1}, index_options), at::empty({0}, index_options)};
+}
+
+/**
+ * 一次性构建CSR：roi底面中心换成框中心后用points_in_boxes_grid取候选(点, roi)对，
+ * 按原判定精筛并算出voxel，再按(voxel, 点)排序。与稠密的pts_idx_of_voxels一致，
+ * 每个voxel只保留下标最小的max_pts_per_voxel - 1个点。
+ */
+VoxelCsr BuildVoxelCsr(const at::Tensor& rois, const at::Tensor& pts, int64_t out_x, int64_t out_y, int64_t out_z,
+    int64_t max_pts_per_voxel)
+{
+    int64_t num_rois = rois.size(0);
+    int64_t num_pts = pts.size(0);
+    int64_t cap = max_pts_per_voxel - 1;
+    auto index_options = pts.options().dtype(at::kLong);
+    if (num_rois == 0 || num_pts == 0 || cap <= 0) {
+        return EmptyCsr(index_options);
+    }
+
+    at::Tensor query = rois.clone();
+    query.select(1, 2).add_(rois.select(1, 5) * 0.5);
+    query.narrow(1, 3, 3).add_(2 * CANDIDATE_PAD);
+    at::Tensor pts_ptr;
+    at::Tensor pair_roi;
+    std::tie(pts_ptr, pair_roi) = points_in_boxes_grid(query.unsqueeze(0), pts.unsqueeze(0), true, 0);
+    int64_t total_pairs = pair_roi.numel();
+    if (total_pairs == 0) {
+        return EmptyCsr(index_options);
+    }
+    at::Tensor pair_pt =
+        at::repeat_interleave(pts_ptr.narrow(0, 1, num_pts) - pts_ptr.narrow(0, 0, num_pts), total_pairs);
+
+    at::Tensor r = rois.index_select(0, pair_roi);
+    at::Tensor p = pts.index_select(0, pair_pt);
+    at::Tensor x_size = r.select(1, 3);
+    at::Tensor y_size = r.select(1, 4);
+    at::Tensor z_size = r.select(1, 5);
+    at::Tensor rz = r.select(1, 6);
+    at::Tensor cosa = at::cos(-rz);
+    at::Tensor sina = at::sin(-rz);
+    at::Tensor sx = p.select(1, 0) - r.select(1, 0);
+    at::Tensor sy = p.select(1, 1) - r.select(1, 1);
+    at::Tensor local_x = sx * cosa - sy * sina;
+    at::Tensor local_y = sx * sina + sy * cosa;
+    at::Tensor local_z = p.select(1, 2) - r.select(1, 2);
+    at::Tensor half_x = x_size * 0.5;
+    at::Tensor half_y = y_size * 0.5;
+    at::Tensor cz = r.select(1, 2) + z_size * 0.5;
+    at::Tensor inside = ((p.select(1, 2) - cz).abs() <= z_size * 0.5) & (local_x > -half_x) &
+                        (local_x < half_x) & (local_y > -half_y) & (local_y < half_y);
+
+    at::Tensor x_idx = ((local_x + half_x) / (x_size / out_x)).to(at::kLong).clamp(0, out_x - 1);
+    at::Tensor y_idx = ((local_y + half_y) / (y_size / out_y)).to(at::kLong).clamp(0, out_y - 1);
+    at::Tensor z_idx = (local_z / (z_size / out_z)).to(at::kLong).clamp(0, out_z - 1);
+    at::Tensor voxel = ((pair_roi * out_x + x_idx) * out_y + y_idx) * out_z + z_idx;
+    at::Tensor keep = inside.nonzero().squeeze(1);
+    if (keep.numel() == 0) {
+        return EmptyCsr(index_options);
+    }
+
+    at::Tensor key = std::get<0>((voxel.index_select(0, keep) * num_pts + pair_pt.index_select(0, keep)).sort());
+    at::Tensor voxel_sorted = key.div(num_pts, "floor");
+    at::Tensor uniq;
+    at::Tensor inverse;
+    at::Tensor counts;
+    std::tie(uniq, inverse, counts) = at::unique_consecutive(voxel_sorted, true, true);
+    at::Tensor rank =
+        at::arange(key.numel(), index_options) - (counts.cumsum(0) - counts).index_select(0, inverse);
+    at::Tensor kept = (rank < cap).nonzero().squeeze(1);
+
+    VoxelCsr csr;
+    csr.voxel_idx = uniq;
+    csr.voxel_ptr = at::cat({at::zeros({1}, index_options), counts.clamp_max(cap).cumsum(0)});
+    csr.pts_idx = key.index_select(0, kept).remainder(num_pts);
+    return csr;
+}
+
+// 逐voxel池化，特征按原精度读取，累加用float
+template<typename scalar_t>
+void RoiawarePoolCpuKernel(const at::Tensor& pts_feature, const VoxelCsr& csr, int64_t mode, at::Tensor& values,
+    at::Tensor& argmax)
+{
+    int64_t num_voxels = csr.voxel_idx.numel();
+    int64_t channels = pts_feature.size(1);
+    const scalar_t* feat = pts_feature.data_ptr<scalar_t>();
+    const int64_t* ptr = csr.voxel_ptr.data_ptr<int64_t>();
+    const int64_t* pts_idx = csr.pts_idx.data_ptr<int64_t>();
+    scalar_t* out = values.data_ptr<scalar_t>();
+    int32_t* arg = mode == POOL_MAX ? argmax.data_ptr<int32_t>() : nullptr;
+
+    at::parallel_for(0, num_voxels, VOXEL_GRAIN, [&](int64_t begin, int64_t end) {
+        std::vector<float> acc(channels);
+        std::vector<int32_t> acc_idx(channels);
+        for (int64_t k = begin; k < end; k++) {
+            std::fill(acc.begin(), acc.end(), mode == POOL_MAX ? MAX_INIT : 0.0f);
+            std::fill(acc_idx.begin(), acc_idx.end(), -1);
+            for (int64_t j = ptr[k]; j < ptr[k + 1]; j++) {
+                const scalar_t* row = feat + pts_idx[j] * channels;
+                if (mode == POOL_MAX) {
+                    for (int64_t c = 0; c < channels; c++) {
+                        float v = static_cast<float>(row[c]);
+                        if (v > acc[c]) {
+                            acc[c] = v;
+                            acc_idx[c] = static_cast<int32_t>(pts_idx[j]);
+                        }
+                    }
+                } else {
+                    for (int64_t c = 0; c < channels; c++) {
+                        acc[c] += static_cast<float>(row[c]);
+                    }
+                }
+            }
+            scalar_t* out_row = out + k * channels;
+            if (mode == POOL_MAX) {
+                for (int64_t c = 0; c < channels; c++) {
+                    out_row[c] = static_cast<scalar_t>(acc_idx[c] >= 0 ? acc[c] : 0.0f);
+                    arg[k * channels + c] = acc_idx[c];
+                }
+            } else {
+                float inv = 1.0f / static_cast<float>(ptr[k + 1] - ptr[k]);
+                for (int64_t c = 0; c < channels; c++) {
+                    out_row[c] = static_cast<scalar_t>(acc[c] * inv);
+                }
+            }
+        }
+    });
+}
+
+// device上由ATen算子组合：展开(voxel, 点)后scatter_reduce
+void RoiawarePoolDevice(const at::Tensor& pts_feature, const VoxelCsr& csr, int64_t mode, at::Tensor& values,
+    at::Tensor& argmax)
+{
+    int64_t num_voxels = csr.voxel_idx.numel();
+    int64_t num_pts = pts_feature.size(0);
+    int64_t channels = pts_feature.size(1);
+    int64_t total = csr.pts_idx.numel();
+    at::Tensor counts = csr.voxel_ptr.narrow(0, 1, num_voxels) - csr.voxel_ptr.narrow(0, 0, num_voxels);
+    at::Tensor seg = at::repeat_interleave(counts, total);
+    at::Tensor feats = pts_feature.index_select(0, csr.pts_idx);
+    if (mode == POOL_AVG) {
+        at::Tensor sums = at::zeros({num_voxels, channels}, feats.options().dtype(at::kFloat));
+        sums.index_add_(0, seg, feats.to(at::kFloat));
+        values.copy_(sums / counts.unsqueeze(1).to(at::kFloat));
+        return;
+    }
+    at::Tensor seg_c = seg.unsqueeze(1).expand({total, channels});
+    values.scatter_reduce_(0, seg_c, feats, "amax", false);
+    // 与逐点严格大于的更新一致：并列最大时取下标最小的点
+    at::Tensor cand = at::where(feats == values.index_select(0, seg),
+        csr.pts_idx.unsqueeze(1).expand({total, channels}), at::full({1}, num_pts, seg.options()));
+    at::Tensor first = at::full({num_voxels, channels}, num_pts, seg.options());
+    first.scatter_reduce_(0, seg_c, cand, "amin");
+    argmax.copy_(first);
+}
+} // namespace
+
+/**
+ * @brief roiaware_pool3d的CSR模式：一次构建(roi, voxel) -> 点的紧凑列表并直接在其上池化，
+ *        不再申请(N, out_x, out_y, out_z, max_pts_per_voxel)的pts_idx_of_voxels
+ * @param rois: (N, 7)，(x, y, z, x_size, y_size, z_size, rz)，z为底面中心
+ * @param pts: (npoints, 3)
+ * @param pts_feature: (npoints, C)，float32/float16/bfloat16，按原精度池化
+ * @param mode: 0为maxpool，1为avgpool
+ * @return pooled_features: (N, out_x, out_y, out_z, C)；
+ *         argmax: maxpool时为(Kv, C)，int32，与voxel_idx逐行对应，avgpool时为空；
+ *         voxel_idx, voxel_ptr, pts_idx: int64的CSR，供roiaware_pool3d_csr_grad使用
+ */
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor> roiaware_pool3d_csr(const at::Tensor& rois,
+    const at::Tensor& pts, const at::Tensor& pts_feature, int64_t out_x, int64_t out_y, int64_t out_z,
+    int64_t max_pts_per_voxel, int64_t mode)
+{
+    TORCH_CHECK(rois.dim() == 2 && rois.size(1) == ROI_DIM, "rois must be 2D tensor (N, 7)");
+    TORCH_CHECK(pts.dim() == 2 && pts.size(1) == POINT_DIM, "pts must be 2D tensor (npoints, 3)");
+    TORCH_CHECK(pts_feature.dim() == 2 && pts_feature.size(0) == pts.size(0),
+        "pts_feature must be 2D tensor (npoints, C)");
+    TORCH_CHECK(out_x > 0 && out_y > 0 && out_z > 0, "out_size must be positive");
+    TORCH_CHECK(max_pts_per_voxel > 0, "max_pts_per_voxel must be positive");
+    TORCH_CHECK(mode == POOL_MAX || mode == POOL_AVG, "mode must be 0 (max) or 1 (avg)");
+
+    if (!pts_feature.device().is_cpu()) {
+        TORCH_CHECK_NPU(rois);
+        TORCH_CHECK_NPU(pts);
+        TORCH_CHECK_NPU(pts_feature);
+    }
+
+    int64_t num_rois = rois.size(0);
+    int64_t channels = pts_feature.size(1);
+    // 几何判定统一用float，特征保持原精度
+    VoxelCsr csr = BuildVoxelCsr(rois.to(at::kFloat).contiguous(), pts.to(at::kFloat).contiguous(), out_x, out_y,
+        out_z, max_pts_per_voxel);
+    at::Tensor feature = pts_feature.contiguous();
+    int64_t num_voxels = csr.voxel_idx.numel();
+    at::Tensor values = at::empty({num_voxels, channels}, feature.options());
+    at::Tensor argmax = at::empty({mode == POOL_MAX ? num_voxels : 0, channels}, feature.options().dtype(at::kInt));
+    if (num_voxels > 0) {
+        if (feature.device().is_cpu()) {
+            AT_DISPATCH_FLOATING_TYPES_AND2(at::kHalf, at::kBFloat16, feature.scalar_type(), "roiaware_pool3d_csr_cpu",
+                [&] { RoiawarePoolCpuKernel<scalar_t>(feature, csr, mode, values, argmax); });
+        } else {
+            RoiawarePoolDevice(feature, csr, mode, values, argmax);
+        }
+    }
+    at::Tensor pooled_features = at::zeros({num_rois * out_x * out_y * out_z, channels}, feature.options());
+    pooled_features.index_copy_(0, csr.voxel_idx, values);
+    return std::make_tuple(pooled_features.view({num_rois, out_x, out_y, out_z, channels}), argmax, csr.voxel_idx,
+        csr.voxel_ptr, csr.pts_idx);
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+namespace {
+constexpr int64_t POOL_MAX = 0;
+constexpr int64_t POOL_AVG = 1;
+constexpr int64_t CHANNEL_GRAIN = 16;
+
+// 按通道分段并行，同一通道只由一个线程写入，不需要原子累加
+template<typename scalar_t>
+void RoiawarePoolGradCpuKernel(const at::Tensor& argmax, const at::Tensor& voxel_ptr, const at::Tensor& pts_idx,
+    const at::Tensor& grad_rows, int64_t mode, at::Tensor& grad_in)
+{
+    int64_t num_voxels = grad_rows.size(0);
+    int64_t channels = grad_rows.size(1);
+    const scalar_t* grad = grad_rows.data_ptr<scalar_t>();
+    const int64_t* ptr = voxel_ptr.data_ptr<int64_t>();
+    const int64_t* pts = pts_idx.data_ptr<int64_t>();
+    const int32_t* arg = mode == POOL_MAX ? argmax.data_ptr<int32_t>() : nullptr;
+    float* out = grad_in.data_ptr<float>();
+
+    at::parallel_for(0, channels, CHANNEL_GRAIN, [&](int64_t begin, int64_t end) {
+        for (int64_t k = 0; k < num_voxels; k++) {
+            const scalar_t* grad_row = grad + k * channels;
+            if (mode == POOL_MAX) {
+                const int32_t* arg_row = arg + k * channels;
+                for (int64_t c = begin; c < end; c++) {
+                    if (arg_row[c] >= 0) {
+                        out[arg_row[c] * channels + c] += static_cast<float>(grad_row[c]);
+                    }
+                }
+                continue;
+            }
+            float inv = 1.0f / static_cast<float>(ptr[k + 1] - ptr[k]);
+            for (int64_t j = ptr[k]; j < ptr[k + 1]; j++) {
+                float* out_row = out + pts[j] * channels;
+                for (int64_t c = begin; c < end; c++) {
+                    out_row[c] += static_cast<float>(grad_row[c]) * inv;
+                }
+            }
+        }
+    });
+}
+
+void RoiawarePoolGradDevice(const at::Tensor& argmax, const at::Tensor& voxel_ptr, const at::Tensor& pts_idx,
+    const at::Tensor& grad_rows, int64_t mode, at::Tensor& grad_in)
+{
+    int64_t num_voxels = grad_rows.size(0);
+    int64_t channels = grad_rows.size(1);
+    at::Tensor grad = grad_rows.to(at::kFloat);
+    if (mode == POOL_MAX) {
+        at::Tensor valid = argmax >= 0;
+        at::Tensor target = argmax.to(at::kLong) * channels + at::arange(channels, voxel_ptr.options());
+        grad_in.view(-1).index_add_(0, target.masked_select(valid), grad.masked_select(valid));
+        return;
+    }
+    at::Tensor counts = voxel_ptr.narrow(0, 1, num_voxels) - voxel_ptr.narrow(0, 0, num_voxels);
+    at::Tensor seg = at::repeat_interleave(counts, pts_idx.numel());
+    at::Tensor avg = grad / counts.unsqueeze(1).to(at::kFloat);
+    grad_in.index_add_(0, pts_idx, avg.index_select(0, seg));
+}
+} // namespace
+
+/**
+ * @brief roiaware_pool3d CSR模式的反向，直接使用前向输出的紧凑CSR与argmax
+ * @param voxel_idx, voxel_ptr, pts_idx: roiaware_pool3d_csr输出的CSR
+ * @param argmax: maxpool时为(Kv, C)，int32；avgpool时不使用
+ * @param grad_out: (N, out_x, out_y, out_z, C)
+ * @param npoints: 点数
+ * @param pool_method: 0为maxpool，1为avgpool
+ * @return grad_in: (npoints, C)，与grad_out同精度，累加用float
+ */
+at::Tensor roiaware_pool3d_csr_grad(const at::Tensor& voxel_idx, const at::Tensor& voxel_ptr,
+    const at::Tensor& pts_idx, const at::Tensor& argmax, const at::Tensor& grad_out, int64_t npoints,
+    int64_t pool_method)
+{
+    TORCH_CHECK(grad_out.dim() == 5, "grad_out has to be a 5D Tensor, but got: ", grad_out.dim());
+    TORCH_CHECK(pool_method == POOL_MAX || pool_method == POOL_AVG, "pool_method must be 0 (max) or 1 (avg)");
+    TORCH_CHECK(voxel_ptr.numel() == voxel_idx.numel() + 1, "voxel_ptr must have voxel_idx.numel() + 1 elements");
+    int64_t channels = grad_out.size(4);
+    if (pool_method == POOL_MAX) {
+        TORCH_CHECK(argmax.dim() == 2 && argmax.size(0) == voxel_idx.numel() && argmax.size(1) == channels,
+            "argmax must be 2D tensor (Kv, C)");
+    }
+
+    at::Tensor grad_in = at::zeros({npoints, channels}, grad_out.options().dtype(at::kFloat));
+    if (voxel_idx.numel() == 0) {
+        return grad_in.to(grad_out.scalar_type());
+    }
+    at::Tensor grad_rows = grad_out.reshape({-1, channels}).index_select(0, voxel_idx).contiguous();
+    if (grad_out.device().is_cpu()) {
+        AT_DISPATCH_FLOATING_TYPES_AND2(at::kHalf, at::kBFloat16, grad_rows.scalar_type(),
+            "roiaware_pool3d_csr_grad_cpu", [&] {
+                RoiawarePoolGradCpuKernel<scalar_t>(argmax.contiguous(), voxel_ptr.contiguous(),
+                    pts_idx.contiguous(), grad_rows, pool_method, grad_in);
+            });
+    } else {
+        TORCH_CHECK_NPU(grad_out);
+        RoiawarePoolGradDevice(argmax, voxel_ptr, pts_idx, grad_rows, pool_method, grad_in);
+    }
+    return grad_in.to(grad_out.scalar_type());
+}
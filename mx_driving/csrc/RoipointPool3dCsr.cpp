@@ -0,0 +1,261 @@
+// Copyright (c) 2025 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int64_t BOX_DIM = 7;
+constexpr int64_t POINT_DIM = 3;
+constexpr int64_t SAMPLE_FIRST = 0;
+constexpr int64_t SAMPLE_RANDOM = 1;
+constexpr int64_t BOX_GRAIN = 16;
+constexpr int64_t HASH_MASK = 0xFFFFFFFFLL;
+constexpr int64_t HASH_MUL = 0x45d9f3bLL;
+constexpr int64_t HASH_SHIFT = 16;
+constexpr int64_t HASH_KEY_SHIFT = 1LL << 32;
+
+/**
+ * 随机采样用的32位整数哈希，输入输出均在[0, 2^32)内，乘积不超过2^59，
+ * 因此可以用int64的ATen算子在device上得到与CPU逐位相同的结果。
+ */
+inline int64_t Mix32(int64_t x)
+{
+    x &= HASH_MASK;
+    x ^= x >> HASH_SHIFT;
+    x = (x * HASH_MUL) & HASH_MASK;
+    x ^= x >> HASH_SHIFT;
+    x = (x * HASH_MUL) & HASH_MASK;
+    x ^= x >> HASH_SHIFT;
+    return x;
+}
+
+// 框内点value的随机键；value >= N时用于补齐不足num_sampled_points的采样位
+inline int64_t RandomKey(int64_t seed_key, int64_t box, int64_t value)
+{
+    return Mix32(Mix32(seed_key ^ box) ^ value);
+}
+
+at::Tensor Mix32(const at::Tensor& input)
+{
+    at::Tensor x = input.bitwise_and(HASH_MASK);
+    x = x.bitwise_xor(x.div(1LL << HASH_SHIFT, "floor"));
+    x = (x * HASH_MUL).bitwise_and(HASH_MASK);
+    x = x.bitwise_xor(x.div(1LL << HASH_SHIFT, "floor"));
+    x = (x * HASH_MUL).bitwise_and(HASH_MASK);
+    return x.bitwise_xor(x.div(1LL << HASH_SHIFT, "floor"));
+}
+
+at::Tensor RandomKey(int64_t seed_key, const at::Tensor& box, const at::Tensor& value)
+{
+    return Mix32(Mix32(box.bitwise_xor(seed_key)).bitwise_xor(value));
+}
+
+/**
+ * 逐框采样：框内点按下标升序（first）或按随机键排序（random）后取前num个，
+ * 不足时first循环重复，random用随机键在框内点中有放回地补齐。
+ */
+template<typename scalar_t>
+void RoipointPool3dCsrCpuKernel(int64_t num_sampled_points, const at::Tensor& points, const at::Tensor& point_features,
+    int64_t num_boxes, const at::Tensor& pts_ptr, const at::Tensor& box_idx, int64_t sample_mode, int64_t seed_key,
+    at::Tensor& pooled_features, at::Tensor& pooled_empty_flag)
+{
+    int64_t batch = points.size(0);
+    int64_t num_points = points.size(1);
+    int64_t channels = point_features.size(2);
+    int64_t total_boxes = batch * num_boxes;
+    int64_t out_dim = POINT_DIM + channels;
+    const float* pts = points.data_ptr<float>();
+    const scalar_t* feat = point_features.data_ptr<scalar_t>();
+    const int64_t* ptr = pts_ptr.data_ptr<int64_t>();
+    const int64_t* box = box_idx.data_ptr<int64_t>();
+    scalar_t* out = pooled_features.data_ptr<scalar_t>();
+    int32_t* flag = pooled_empty_flag.data_ptr<int32_t>();
+
+    // 点 -> 框的CSR转为框 -> 点：计数、前缀和后按点顺序填充，框内点下标升序
+    std::vector<int64_t> box_start(total_boxes + 1, 0);
+    for (int64_t p = 0; p < batch * num_points; p++) {
+        int64_t b = p / num_points;
+        for (int64_t j = ptr[p]; j < ptr[p + 1]; j++) {
+            TORCH_CHECK(box[j] >= 0 && box[j] < num_boxes, "box_idx must be in [0, ", num_boxes, ")");
+            box_start[b * num_boxes + box[j] + 1]++;
+        }
+    }
+    for (int64_t g = 0; g < total_boxes; g++) {
+        box_start[g + 1] += box_start[g];
+    }
+    std::vector<int64_t> members(box_start[total_boxes]);
+    std::vector<int64_t> fill(box_start.begin(), box_start.end() - 1);
+    for (int64_t p = 0; p < batch * num_points; p++) {
+        int64_t b = p / num_points;
+        for (int64_t j = ptr[p]; j < ptr[p + 1]; j++) {
+            members[fill[b * num_boxes + box[j]]++] = p % num_points;
+        }
+    }
+
+    at::parallel_for(0, total_boxes, BOX_GRAIN, [&](int64_t begin, int64_t end) {
+        std::vector<std::pair<int64_t, int64_t>> keyed;
+        for (int64_t g = begin; g < end; g++) {
+            int64_t b = g / num_boxes;
+            int64_t cnt = box_start[g + 1] - box_start[g];
+            scalar_t* out_box = out + g * num_sampled_points * out_dim;
+            flag[g] = cnt == 0 ? 1 : 0;
+            if (cnt == 0) {
+                std::fill(out_box, out_box + num_sampled_points * out_dim, static_cast<scalar_t>(0));
+                continue;
+            }
+            const int64_t* order = members.data() + box_start[g];
+            if (sample_mode == SAMPLE_RANDOM) {
+                keyed.clear();
+                for (int64_t j = 0; j < cnt; j++) {
+                    keyed.emplace_back(RandomKey(seed_key, g, order[j]), order[j]);
+                }
+                std::sort(keyed.begin(), keyed.end());
+            }
+            for (int64_t j = 0; j < num_sampled_points; j++) {
+                int64_t idx = j;
+                if (j >= cnt) {
+                    idx = sample_mode == SAMPLE_RANDOM ? RandomKey(seed_key, g, num_points + j) % cnt : j % cnt;
+                }
+                int64_t n = sample_mode == SAMPLE_RANDOM ? keyed[idx].second : order[idx];
+                const float* pt = pts + (b * num_points + n) * POINT_DIM;
+                const scalar_t* row = feat + (b * num_points + n) * channels;
+                scalar_t* out_row = out_box + j * out_dim;
+                for (int64_t d = 0; d < POINT_DIM; d++) {
+                    out_row[d] = static_cast<scalar_t>(pt[d]);
+                }
+                std::copy(row, row + channels, out_row + POINT_DIM);
+            }
+        }
+    });
+}
+
+// device上由ATen算子组合，与CPU的采样结果逐位一致
+std::tuple<at::Tensor, at::Tensor> RoipointPool3dCsrDevice(int64_t num_sampled_points, const at::Tensor& points,
+    const at::Tensor& point_features, int64_t num_boxes, const at::Tensor& pts_ptr, const at::Tensor& box_idx,
+    int64_t sample_mode, int64_t seed_key)
+{
+    int64_t batch = points.size(0);
+    int64_t num_points = points.size(1);
+    int64_t channels = point_features.size(2);
+    int64_t total_boxes = batch * num_boxes;
+    int64_t total = box_idx.numel();
+    auto index_options = box_idx.options();
+    at::Tensor pooled_features =
+        at::zeros({batch, num_boxes, num_sampled_points, POINT_DIM + channels}, point_features.options());
+    if (total == 0) {
+        return std::make_tuple(pooled_features, at::ones({batch, num_boxes}, index_options.dtype(at::kInt)));
+    }
+
+    int64_t total_points = batch * num_points;
+    at::Tensor point_of =
+        at::repeat_interleave(pts_ptr.narrow(0, 1, total_points) - pts_ptr.narrow(0, 0, total_points), total);
+    at::Tensor box_of = point_of.div(num_points, "floor") * num_boxes + box_idx;
+    at::Tensor key = std::get<0>((box_of * num_points + point_of.remainder(num_points)).sort());
+    at::Tensor sorted_box = key.div(num_points, "floor");
+    at::Tensor sorted_pt = key.remainder(num_points);
+    if (sample_mode == SAMPLE_RANDOM) {
+        // 稳定排序：随机键相同时保持点下标升序，与CPU按(键, 点)排序一致
+        at::Tensor random_key = sorted_box * HASH_KEY_SHIFT + RandomKey(seed_key, sorted_box, sorted_pt);
+        sorted_pt = sorted_pt.index_select(0, std::get<1>(random_key.sort(c10::optional<bool>(true), 0)));
+    }
+
+    at::Tensor counts = at::bincount(sorted_box, {}, total_boxes);
+    at::Tensor starts = counts.cumsum(0) - counts;
+    at::Tensor cnt = counts.clamp_min(1).unsqueeze(1);
+    at::Tensor slot =
+        at::arange(num_sampled_points, index_options).unsqueeze(0).expand({total_boxes, num_sampled_points});
+    at::Tensor refill;
+    if (sample_mode == SAMPLE_RANDOM) {
+        refill = RandomKey(seed_key, at::arange(total_boxes, index_options).unsqueeze(1), slot + num_points)
+                     .remainder(cnt);
+    } else {
+        refill = slot.remainder(cnt);
+    }
+    at::Tensor pos = (starts.unsqueeze(1) + at::where(slot < cnt, slot, refill)).clamp_max(total - 1);
+    at::Tensor box_batch = at::arange(total_boxes, index_options).div(num_boxes, "floor").unsqueeze(1);
+    at::Tensor src = (sorted_pt.index_select(0, pos.reshape(-1)).view({total_boxes, num_sampled_points}) +
+                      box_batch * num_points)
+                         .reshape(-1);
+
+    at::Tensor xyz = points.reshape({-1, POINT_DIM}).index_select(0, src).to(point_features.scalar_type());
+    at::Tensor feat = point_features.reshape({-1, channels}).index_select(0, src);
+    at::Tensor empty = (counts == 0).view({batch, num_boxes});
+    pooled_features = at::cat({xyz, feat}, 1)
+                          .view({batch, num_boxes, num_sampled_points, POINT_DIM + channels})
+                          .masked_fill(empty.view({batch, num_boxes, 1, 1}), 0);
+    return std::make_tuple(pooled_features, empty.to(at::kInt));
+}
+} // namespace
+
+/**
+ * @brief 复用点 -> 框CSR的roipoint_pool3d，不再逐点逐框重复判断
+ * @param points: (B, N, 3)
+ * @param point_features: (B, N, C)，float32/float16/bfloat16，输出与其同精度
+ * @param boxes3d: (B, M, 7)，只用于确定M
+ * @param pts_ptr, box_idx: points_in_boxes_csr格式的CSR，点b * N + n所在的框为
+ *                         box_idx[pts_ptr[b * N + n]:pts_ptr[b * N + n + 1]]
+ * @param sample_mode: 0为按点下标取前num_sampled_points个、不足时循环重复，与roipoint_pool3d一致；
+ *                     1为按seed确定的随机顺序无放回采样、不足时有放回地随机补齐，
+ *                     CPU与NPU结果一致
+ * @return pooled_features: (B, M, num_sampled_points, 3 + C)；pooled_empty_flag: (B, M)，int32，框内无点时为1
+ */
+std::tuple<at::Tensor, at::Tensor> roipoint_pool3d_csr(int64_t num_sampled_points, const at::Tensor& points,
+    const at::Tensor& point_features, const at::Tensor& boxes3d, const at::Tensor& pts_ptr, const at::Tensor& box_idx,
+    int64_t sample_mode, int64_t seed)
+{
+    TORCH_CHECK(num_sampled_points > 0, "num_sampled_points must be positive");
+    TORCH_CHECK(points.dim() == 3 && points.size(2) == POINT_DIM, "points must be 3D tensor (B, N, 3)");
+    TORCH_CHECK(point_features.dim() == 3 && point_features.size(0) == points.size(0) &&
+                    point_features.size(1) == points.size(1),
+        "point_features must be 3D tensor (B, N, C)");
+    TORCH_CHECK(boxes3d.dim() == 3 && boxes3d.size(0) == points.size(0) && boxes3d.size(2) == BOX_DIM,
+        "boxes3d must be 3D tensor (B, M, 7)");
+    TORCH_CHECK(pts_ptr.dim() == 1 && pts_ptr.numel() == points.size(0) * points.size(1) + 1,
+        "pts_ptr must be 1D tensor (B * N + 1)");
+    TORCH_CHECK(pts_ptr.scalar_type() == at::kLong && box_idx.scalar_type() == at::kLong,
+        "pts_ptr and box_idx must be int64 tensor");
+    TORCH_CHECK(sample_mode == SAMPLE_FIRST || sample_mode == SAMPLE_RANDOM,
+        "sample_mode must be 0 (first) or 1 (random)");
+
+    int64_t num_boxes = boxes3d.size(1);
+    int64_t seed_key = Mix32(seed);
+    at::Tensor points_fp32 = points.to(at::kFloat).contiguous();
+    at::Tensor features = point_features.contiguous();
+    if (points.device().is_cpu()) {
+        at::Tensor pooled_features = at::empty(
+            {points.size(0), num_boxes, num_sampled_points, POINT_DIM + features.size(2)}, features.options());
+        at::Tensor pooled_empty_flag = at::empty({points.size(0), num_boxes}, points.options().dtype(at::kInt));
+        AT_DISPATCH_FLOATING_TYPES_AND2(at::kHalf, at::kBFloat16, features.scalar_type(), "roipoint_pool3d_csr_cpu",
+            [&] {
+                RoipointPool3dCsrCpuKernel<scalar_t>(num_sampled_points, points_fp32, features, num_boxes,
+                    pts_ptr.contiguous(), box_idx.contiguous(), sample_mode, seed_key, pooled_features,
+                    pooled_empty_flag);
+            });
+        return std::make_tuple(pooled_features, pooled_empty_flag);
+    }
+    TORCH_CHECK_NPU(points);
+    TORCH_CHECK_NPU(point_features);
+    TORCH_CHECK_NPU(pts_ptr);
+    TORCH_CHECK_NPU(box_idx);
+    return RoipointPool3dCsrDevice(
+        num_sampled_points, points_fp32, features, num_boxes, pts_ptr, box_idx, sample_mode, seed_key);
+}
@@ -15,9 +15,12 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/PolygonOverlapCpu.h"
 #include "csrc/functions.h"
 
 namespace {
+constexpr int64_t MODE_IOU = 0;
+
 at::Tensor& rotated_iou_npu_nocheck(at::Tensor& iou, const at::Tensor& boxes, const at::Tensor& query_boxes, bool trans,
     int64_t mode, bool is_cross, double v_threshold, double e_threshold)
 {
@@ -36,6 +39,24 @@ at::Tensor& rotated_iou_npu_nocheck(at::Tensor& iou, const at::Tensor& boxes, co
         .Run();
     return iou;
 }
+
+// 逐batch计算，角度为角度制、逆时针旋转；求精确相交多边形，v_threshold/e_threshold不生效
+at::Tensor rotated_iou_cpu(const at::Tensor& boxes, const at::Tensor& query_boxes, bool trans, int64_t mode,
+    bool is_cross)
+{
+    int64_t B = boxes.size(0);
+    TORCH_CHECK(is_cross || boxes.size(1) == query_boxes.size(1),
+        "boxes and query_boxes must have the same number of boxes when is_cross is False.");
+    at::Tensor iou = is_cross ? at::empty({B, boxes.size(1), query_boxes.size(1)}, boxes.options()) :
+                                at::empty({B, boxes.size(1)}, boxes.options());
+    PolygonOverlapOptions options;
+    options.mode = mode == MODE_IOU ? POLYGON_MODE_IOU : POLYGON_MODE_IOF;
+    for (int64_t b = 0; b < B; b++) {
+        iou.select(0, b).copy_(polygon_overlap_cpu(boxes.select(0, b), query_boxes.select(0, b),
+            PolygonBoxFormat::Rotated(trans, true), options, !is_cross));
+    }
+    return iou;
+}
 } // namespace
 
 at::Tensor npu_rotated_iou(const at::Tensor& boxes, const at::Tensor& query_boxes, bool trans, int64_t mode,
@@ -44,6 +65,10 @@ at::Tensor npu_rotated_iou(const at::Tensor& boxes, const at::Tensor& query_boxe
     TORCH_CHECK(boxes.ndimension() == 3 && query_boxes.ndimension() == 3);
 
     auto origin_dtype = boxes.scalar_type();
+    if (boxes.device().is_cpu()) {
+        return rotated_iou_cpu(boxes.to(at::kFloat), query_boxes.to(at::kFloat), trans, mode, is_cross)
+            .to(origin_dtype);
+    }
 
     at::Tensor boxes_cp = boxes.permute({0, 2, 1});
     if (origin_dtype == at::kHalf) {
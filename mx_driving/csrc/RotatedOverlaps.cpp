@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include "csrc/OpApiCommon.h"
+#include "csrc/PolygonOverlapCpu.h"
 #include "csrc/functions.h"
 
 namespace {
@@ -25,6 +26,19 @@ at::Tensor& rotated_overlaps_npu_nocheck(
     cmd.Name("RotatedOverlaps").Input(self).Input(query_boxes).Output(overlaps).Attr("trans", trans).Run();
     return overlaps;
 }
+
+// 逐batch计算相交面积，角度为角度制、逆时针旋转
+at::Tensor rotated_overlaps_cpu(const at::Tensor& boxes, const at::Tensor& query_boxes, bool trans)
+{
+    int64_t B = boxes.size(0);
+    at::Tensor overlaps = at::empty({B, boxes.size(1), query_boxes.size(1)}, boxes.options());
+    PolygonOverlapOptions options;
+    for (int64_t b = 0; b < B; b++) {
+        overlaps.select(0, b).copy_(polygon_overlap_cpu(boxes.select(0, b), query_boxes.select(0, b),
+            PolygonBoxFormat::Rotated(trans, true), options, false));
+    }
+    return overlaps;
+}
 } // namespace
 
 at::Tensor npu_rotated_overlaps(const at::Tensor& self, const at::Tensor& query_boxes, bool trans)
@@ -32,6 +46,9 @@ at::Tensor npu_rotated_overlaps(const at::Tensor& self, const at::Tensor& query_
     TORCH_CHECK(self.ndimension() == 3 && query_boxes.ndimension() == 3,
         "boxes' dim should be equal to query_boxes' ndimension() ", "and equal to 3!");
     auto origin_dtype = self.scalar_type();
+    if (self.device().is_cpu()) {
+        return rotated_overlaps_cpu(self.to(at::kFloat), query_boxes.to(at::kFloat), trans).to(origin_dtype);
+    }
     // the Op only support fp32 currently!
     at::Tensor self_cp = self.to(at::kFloat).permute({0, 2, 1});
     at::Tensor query_boxes_cp = query_boxes.to(at::kFloat).permute({0, 2, 1});
@@ -17,13 +17,139 @@
 #include "csrc/OpApiCommon.h"
 #include "csrc/functions.h"
 
+#include <algorithm>
+
+namespace {
+// ThreeInterpolate/ThreeInterpolateBackward kernel单次调用支持的维度上限
+constexpr int64_t KERNEL_DIM_LIMIT = 10001;
+// 分块执行时n(目标点)和c(通道)方向的块大小，均小于KERNEL_DIM_LIMIT
+constexpr int64_t TILE_N = 8192;
+constexpr int64_t TILE_C = 8192;
+constexpr int64_t THREE_NN = 3;
+constexpr double INV_DIST_EPS = 1e-8;
+
+// 取[n0, n1)范围的权重；weight_is_dist时weight为three_nn的距离，按块计算反距离权重，不物化完整的[b, n, 3]权重
+at::Tensor TileWeight(const at::Tensor& weight, int64_t n0, int64_t n1, bool weight_is_dist)
+{
+    auto w = weight.slice(1, n0, n1).to(at::kFloat);
+    if (!weight_is_dist) {
+        return w.contiguous();
+    }
+    auto recip = at::reciprocal(w + INV_DIST_EPS);
+    return (recip / recip.sum(2, true)).contiguous();
+}
+
+// points: [b, c, m], idx/weight: [b, n, 3], 均为float/int32，返回[b, c, n]
+at::Tensor ThreeInterpolateTile(const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight)
+{
+    int64_t b = points.size(0);
+    int64_t c = points.size(1);
+    int64_t m = points.size(2);
+    int64_t n = idx.size(1);
+    if (b < KERNEL_DIM_LIMIT && m < KERNEL_DIM_LIMIT) {
+        auto point_c_trans = points.transpose(1, 2).contiguous();
+        at::Tensor out = at::zeros({b, c, n}, points.options());
+        at_npu::native::OpCommand cmd;
+        cmd.Name("ThreeInterpolate").Input(point_c_trans).Input(idx).Input(weight).Output(out).Run();
+        return out.view({b, n, c}).transpose(1, 2);
+    }
+    // 源点数超出kernel上限时退化为gather，索引使用int64
+    auto index = idx.to(at::kLong);
+    at::Tensor out = at::zeros({b, c, n}, points.options());
+    for (int64_t j = 0; j < THREE_NN; ++j) {
+        auto neighbor = points.gather(2, index.select(2, j).unsqueeze(1).expand({b, c, n}));
+        out.addcmul_(neighbor, weight.select(2, j).unsqueeze(1));
+    }
+    return out;
+}
+
+// grad_out: [b, c, n], idx/weight: [b, n, 3], 均为float/int32，返回[b, c, m]
+at::Tensor ThreeInterpolateBackwardTile(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight, int64_t m)
+{
+    int64_t b = grad_out.size(0);
+    int64_t c = grad_out.size(1);
+    int64_t n = grad_out.size(2);
+    at::Tensor grad_points = at::zeros({b, c, m}, grad_out.options());
+    if (b < KERNEL_DIM_LIMIT && m < KERNEL_DIM_LIMIT) {
+        int m_attr = static_cast<int>(m);
+        auto grad_x = at::unsqueeze(grad_out.contiguous(), 3);
+        auto grad_y = at::unsqueeze(grad_points, 3);
+        EXEC_NPU_CMD(aclnnThreeInterpolateBackward, grad_x, idx, weight, m_attr, grad_y);
+        return grad_points;
+    }
+    auto index = idx.to(at::kLong);
+    for (int64_t j = 0; j < THREE_NN; ++j) {
+        grad_points.scatter_add_(2, index.select(2, j).unsqueeze(1).expand({b, c, n}),
+            grad_out * weight.select(2, j).unsqueeze(1));
+    }
+    return grad_points;
+}
+
+// 沿n和c分块调用kernel，块内偏移由框架以int64计算，因此不再限制输入规模
+at::Tensor ThreeInterpolateTiled(
+    const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight, bool weight_is_dist)
+{
+    int64_t b = points.size(0);
+    int64_t c = points.size(1);
+    int64_t n = idx.size(1);
+    auto feat = points.to(at::kFloat);
+    at::Tensor out = at::empty({b, c, n}, feat.options());
+    for (int64_t n0 = 0; n0 < n; n0 += TILE_N) {
+        int64_t n1 = std::min(n0 + TILE_N, n);
+        auto idx_tile = idx.slice(1, n0, n1).contiguous();
+        auto weight_tile = TileWeight(weight, n0, n1, weight_is_dist);
+        for (int64_t c0 = 0; c0 < c; c0 += TILE_C) {
+            int64_t c1 = std::min(c0 + TILE_C, c);
+            out.slice(1, c0, c1).slice(2, n0, n1).copy_(
+                ThreeInterpolateTile(feat.slice(1, c0, c1), idx_tile, weight_tile));
+        }
+    }
+    return out.to(points.scalar_type());
+}
+
+at::Tensor ThreeInterpolateBackwardTiled(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight, int64_t m, bool weight_is_dist)
+{
+    int64_t b = grad_out.size(0);
+    int64_t c = grad_out.size(1);
+    int64_t n = grad_out.size(2);
+    auto grad = grad_out.to(at::kFloat);
+    at::Tensor grad_points = at::zeros({b, c, m}, grad.options());
+    for (int64_t n0 = 0; n0 < n; n0 += TILE_N) {
+        int64_t n1 = std::min(n0 + TILE_N, n);
+        auto idx_tile = idx.slice(1, n0, n1).contiguous();
+        auto weight_tile = TileWeight(weight, n0, n1, weight_is_dist);
+        for (int64_t c0 = 0; c0 < c; c0 += TILE_C) {
+            int64_t c1 = std::min(c0 + TILE_C, c);
+            grad_points.slice(1, c0, c1).add_(
+                ThreeInterpolateBackwardTile(grad.slice(1, c0, c1).slice(2, n0, n1), idx_tile, weight_tile, m));
+        }
+    }
+    return grad_points.to(grad_out.scalar_type());
+}
+
+void CheckWithDistInputs(const at::Tensor& feat, const at::Tensor& idx, const at::Tensor& dist, int64_t n_dim)
+{
+    auto feat_dtype = feat.scalar_type();
+    TORCH_CHECK((feat_dtype == at::kFloat || feat_dtype == at::kHalf),
+        "three_interpolate_with_dist ascend only support fp32 and fp16.");
+    TORCH_CHECK((dist.scalar_type() == feat_dtype), "input dtype is inconsistent.");
+    TORCH_CHECK((idx.scalar_type() == at::kInt), "indices: int32 tensor expected but got a tensor with dtype: ",
+        idx.scalar_type());
+    TORCH_CHECK((feat.dim() == 3 && idx.dim() == 3 && dist.dim() == 3), "input dimension should be 3.");
+    TORCH_CHECK((feat.size(0) == idx.size(0) && feat.size(0) == dist.size(0)),
+        "the first dimension of input should be the same.");
+    TORCH_CHECK((idx.size(1) == dist.size(1) && (n_dim < 0 || feat.size(n_dim) == idx.size(1))),
+        "the second dimension of indices and dist should be the same.");
+    TORCH_CHECK((idx.size(2) == THREE_NN && dist.size(2) == THREE_NN),
+        "the third dimension of indices and dist should be 3.");
+}
+} // namespace
+
 at::Tensor npu_three_interpolate(
     int b, int c, int m, int n, const at::Tensor& points, const at::Tensor& idx, const at::Tensor& weight)
 {
-    TORCH_CHECK_NPU(points);
-    TORCH_CHECK_NPU(idx);
-    TORCH_CHECK_NPU(weight);
-
     auto point_dtype = points.scalar_type();
     auto idx_dtype = idx.scalar_type();
     auto weight_dtype = weight.scalar_type();
@@ -45,36 +171,19 @@ at::Tensor npu_three_interpolate(
         "the first dimension of input should be the same.");
     TORCH_CHECK((idx_size[1] == weight_size[1]), "the second dimension of indices and weight should be the same.");
     TORCH_CHECK((idx_size[2] == 3 && weight_size[2] == 3), "the third dimension of indices and weight should be 3.");
-
-    TORCH_CHECK((b < 10001 && c < 10001 && m < 10001 && n < 10001), "input dimension is too heavy.");
-
-    auto point_c_trans = points.transpose(1, 2).to(at::kFloat);
-    auto weight_cast = weight.to(at::kFloat);
-
-    c10::SmallVector<int64_t, 8> output_size = {b, c, n};
-    at::Tensor out_cast = at::zeros(output_size, points.options()).to(at::kFloat);
-
-    at_npu::native::OpCommand cmd;
-    cmd.Name("ThreeInterpolate").Input(point_c_trans).Input(idx).Input(weight_cast).Output(out_cast).Run();
-
-    auto out = out_cast;
-    if (point_dtype == at::kHalf) {
-        out = out_cast.to(at::kHalf);
+    if (points.device().is_cpu()) {
+        return three_interpolate_cpu(points, idx, weight, false);
     }
-    auto output = out_cast.view({b, n, c}).transpose(1, 2);
-    auto res = output.contiguous();
-    out.copy_(res);
+    TORCH_CHECK_NPU(points);
+    TORCH_CHECK_NPU(idx);
+    TORCH_CHECK_NPU(weight);
 
-    return out;
+    return ThreeInterpolateTiled(points, idx, weight, false);
 }
 
 at::Tensor npu_three_interpolate_backward(
     int b, int c, int n, int m, const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& weight)
 {
-    TORCH_CHECK_NPU(grad_out);
-    TORCH_CHECK_NPU(idx);
-    TORCH_CHECK_NPU(weight);
-
     auto grad_dtype = grad_out.scalar_type();
     auto idx_dtype = idx.scalar_type();
     auto weight_dtype = weight.scalar_type();
@@ -97,18 +206,39 @@ at::Tensor npu_three_interpolate_backward(
     TORCH_CHECK((grad_size[2] == idx_size[1] && grad_size[2] == weight_size[1] && idx_size[1] == weight_size[1]),
         "the second dimension of indices and weight should be the same.");
     TORCH_CHECK((idx_size[2] == 3 && weight_size[2] == 3), "the third dimension of indices and weight should be 3.");
+    if (grad_out.device().is_cpu()) {
+        return three_interpolate_backward_cpu(grad_out, idx, weight, m, false);
+    }
+    TORCH_CHECK_NPU(grad_out);
+    TORCH_CHECK_NPU(idx);
+    TORCH_CHECK_NPU(weight);
 
-    TORCH_CHECK((b < 10001 && c < 10001 && m < 10001 && n < 10001), "input dimension is too heavy.");
+    return ThreeInterpolateBackwardTiled(grad_out, idx, weight, m, false);
+}
 
-    at::Tensor grad_points = at::zeros({b, c, m}, grad_out.options());
-    auto grad_x = at::unsqueeze(grad_out, 3);
-    auto grad_y = at::unsqueeze(grad_points, 3);
+at::Tensor npu_three_interpolate_with_dist(const at::Tensor& points, const at::Tensor& idx, const at::Tensor& dist)
+{
+    CheckWithDistInputs(points, idx, dist, -1);
+    if (points.device().is_cpu()) {
+        return three_interpolate_cpu(points, idx, dist, true);
+    }
+    TORCH_CHECK_NPU(points);
+    TORCH_CHECK_NPU(idx);
+    TORCH_CHECK_NPU(dist);
 
-    EXEC_NPU_CMD(aclnnThreeInterpolateBackward, grad_x, idx, weight, m, grad_y);
+    return ThreeInterpolateTiled(points, idx, dist, true);
+}
 
-    auto output = at::squeeze(grad_y, 3);
-    auto res = output.contiguous();
-    grad_points.copy_(res);
+at::Tensor npu_three_interpolate_with_dist_backward(
+    const at::Tensor& grad_out, const at::Tensor& idx, const at::Tensor& dist, int64_t m)
+{
+    CheckWithDistInputs(grad_out, idx, dist, 2);
+    if (grad_out.device().is_cpu()) {
+        return three_interpolate_backward_cpu(grad_out, idx, dist, m, true);
+    }
+    TORCH_CHECK_NPU(grad_out);
+    TORCH_CHECK_NPU(idx);
+    TORCH_CHECK_NPU(dist);
 
-    return grad_points;
+    return ThreeInterpolateBackwardTiled(grad_out, idx, dist, m, true);
 }
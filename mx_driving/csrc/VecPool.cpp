@@ -0,0 +1,365 @@
+// Copyright (c) 2024 Huawei Technologies Co., Ltd
+// All rights reserved.
+//
+// Licensed under the BSD 3-Clause License  (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "csrc/OpApiCommon.h"
+#include "csrc/functions.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+constexpr int64_t POINT_DIM = 3;
+constexpr int64_t GROUP_DIM = 3;
+constexpr int64_t POOLING_AVG = 0;
+constexpr int64_t POOLING_RANDOM = 1;
+constexpr int64_t NEIGHBOR_BALL = 1;
+constexpr int64_t MAX_HASH_CELLS = 1 << 18; // 每个batch的哈希格子数上限，控制cell_start表大小
+constexpr int32_t NO_SAMPLE_LIMIT = std::numeric_limits<int32_t>::max();
+constexpr float HASH_MARGIN = 1.001f; // 与kernel一致，查询范围略大于max_neighbour_distance
+
+// 源点按(batch, cell)稳定排序后的空间哈希，格子边长不小于2 * max_neighbour_distance，
+// 因此每个中心点的立方邻域在每个轴上最多跨2个格子
+struct VecPoolHash {
+    at::Tensor sorted_xyz;   // [3, N]
+    at::Tensor sorted_idx;   // [N]，int32，排序后位置对应的原始下标
+    at::Tensor cell_start;   // [B * numCells + 1]，int32
+    at::Tensor center_batch; // [M]，int32
+    std::array<float, POINT_DIM> lower;
+    std::array<int64_t, POINT_DIM> cells;
+    float cell_size;
+};
+
+struct VecPoolParams {
+    std::array<int64_t, POINT_DIM> num_grid;
+    std::array<float, POINT_DIM> grid_size;
+    int64_t total_grids;
+    int64_t c_each;
+    float max_dist;
+    int64_t neighbor_type;
+    int64_t pooling_type;
+    bool use_xyz;
+    int32_t sample_limit;
+};
+
+VecPoolHash BuildHash(const at::Tensor& support_xyz, const at::Tensor& xyz_batch_cnt, const at::Tensor& new_xyz,
+    const at::Tensor& new_xyz_batch_cnt, float max_dist)
+{
+    VecPoolHash hash;
+    int64_t b = xyz_batch_cnt.size(0);
+    int64_t n = support_xyz.size(0);
+    std::array<float, POINT_DIM> upper {0.0f, 0.0f, 0.0f};
+    hash.lower = {0.0f, 0.0f, 0.0f};
+    if (n > 0) {
+        at::Tensor bounds = at::stack({support_xyz.amin(0), support_xyz.amax(0)}).cpu();
+        const float* bounds_ptr = bounds.data_ptr<float>();
+        for (int64_t i = 0; i < POINT_DIM; i++) {
+            hash.lower[i] = bounds_ptr[i];
+            upper[i] = bounds_ptr[POINT_DIM + i];
+        }
+    }
+    float max_extent = 0.0f;
+    for (int64_t i = 0; i < POINT_DIM; i++) {
+        max_extent = std::max(max_extent, upper[i] - hash.lower[i]);
+    }
+    hash.cell_size = std::max(2.0f * max_dist, max_extent / std::cbrt(static_cast<float>(MAX_HASH_CELLS)));
+    for (int64_t i = 0; i < POINT_DIM; i++) {
+        hash.cells[i] = static_cast<int64_t>(std::floor((upper[i] - hash.lower[i]) / hash.cell_size)) + 1;
+    }
+    int64_t num_cells = hash.cells[0] * hash.cells[1] * hash.cells[2];
+
+    auto long_options = support_xyz.options().dtype(at::kLong);
+    at::Tensor lower = at::tensor({hash.lower[0], hash.lower[1], hash.lower[2]}, support_xyz.options().device(at::kCPU))
+                           .to(support_xyz.device());
+    at::Tensor cell_max = at::tensor({hash.cells[0] - 1, hash.cells[1] - 1, hash.cells[2] - 1}, at::kLong)
+                              .to(support_xyz.device());
+    at::Tensor coords = at::minimum(((support_xyz - lower) / hash.cell_size).floor().clamp_min(0).to(at::kLong),
+        cell_max);
+    at::Tensor point_batch = at::repeat_interleave(xyz_batch_cnt.to(support_xyz.device(), at::kLong));
+    at::Tensor key = ((point_batch * hash.cells[0] + coords.select(1, 0)) * hash.cells[1] + coords.select(1, 1)) *
+                         hash.cells[2] + coords.select(1, 2);
+    at::Tensor order = std::get<1>(key.sort(true, 0));
+    at::Tensor sorted_key = key.index_select(0, order);
+    hash.cell_start = at::searchsorted(sorted_key, at::arange(b * num_cells + 1, long_options)).to(at::kInt);
+    hash.sorted_xyz = support_xyz.index_select(0, order).t().contiguous();
+    hash.sorted_idx = order.to(at::kInt);
+    hash.center_batch = at::repeat_interleave(new_xyz_batch_cnt.to(new_xyz.device(), at::kLong)).to(at::kInt);
+    TORCH_CHECK(hash.center_batch.size(0) == new_xyz.size(0), "sum(new_xyz_batch_cnt) must equal new_xyz.shape[0].");
+    return hash;
+}
+
+int64_t CellCoord(float v, float lower, float cell_size, int64_t cells)
+{
+    float t = (v - lower) / cell_size;
+    if (!(t > 0.0f)) {
+        return 0;
+    }
+    if (t >= static_cast<float>(cells)) {
+        return cells - 1;
+    }
+    return static_cast<int64_t>(t);
+}
+
+// 与NPU kernel相同的格子遍历顺序和累加顺序：按(x, y)列扫描z方向连续的格子段，逐点累加后乘以1 / cnt再折叠通道
+void VecPoolCpu(const VecPoolHash& hash, const at::Tensor& support_features, const at::Tensor& new_xyz,
+    const VecPoolParams& params, at::Tensor& new_features, at::Tensor& new_local_xyz, at::Tensor& point_cnt_of_grid,
+    at::Tensor& grouped_idxs)
+{
+    int64_t n = support_features.size(0);
+    int64_t c_in = support_features.size(1);
+    int64_t m = new_xyz.size(0);
+    int64_t grids = params.total_grids;
+    int64_t c_each = params.c_each;
+    int64_t num_cells = hash.cells[0] * hash.cells[1] * hash.cells[2];
+    const float* xyz_ptr = hash.sorted_xyz.data_ptr<float>();
+    const int32_t* sorted_idx_ptr = hash.sorted_idx.data_ptr<int32_t>();
+    const int32_t* cell_start_ptr = hash.cell_start.data_ptr<int32_t>();
+    const int32_t* center_batch_ptr = hash.center_batch.data_ptr<int32_t>();
+    const float* feature_ptr = support_features.data_ptr<float>();
+    const float* center_ptr = new_xyz.data_ptr<float>();
+    float* out_ptr = new_features.data_ptr<float>();
+    float* local_ptr = new_local_xyz.data_ptr<float>();
+    int32_t* cnt_ptr = point_cnt_of_grid.data_ptr<int32_t>();
+    std::vector<std::vector<int32_t>> groups(m);
+
+    at::parallel_for(0, m, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> acc(grids * c_in);
+        for (int64_t task = begin; task < end; ++task) {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            float* local = local_ptr + task * grids * POINT_DIM;
+            int32_t* cnt = cnt_ptr + task * grids;
+            std::fill(local, local + grids * POINT_DIM, 0.0f);
+            std::fill(cnt, cnt + grids, 0);
+            const float* center = center_ptr + task * POINT_DIM;
+            int64_t cell_base = static_cast<int64_t>(center_batch_ptr[task]) * num_cells;
+            float margin = params.max_dist * HASH_MARGIN;
+            std::array<int64_t, POINT_DIM> lo;
+            std::array<int64_t, POINT_DIM> hi;
+            for (int64_t i = 0; i < POINT_DIM; i++) {
+                lo[i] = CellCoord(center[i] - margin, hash.lower[i], hash.cell_size, hash.cells[i]);
+                hi[i] = CellCoord(center[i] + margin, hash.lower[i], hash.cell_size, hash.cells[i]);
+            }
+            int32_t sample_num = 0;
+            bool done = false;
+            for (int64_t cx = lo[0]; cx <= hi[0] && !done; cx++) {
+                for (int64_t cy = lo[1]; cy <= hi[1] && !done; cy++) {
+                    int64_t column = cell_base + (cx * hash.cells[1] + cy) * hash.cells[2];
+                    int64_t seg_end = cell_start_ptr[column + hi[2] + 1];
+                    for (int64_t pos = cell_start_ptr[column + lo[2]]; pos < seg_end && !done; pos++) {
+                        float lx = xyz_ptr[pos] - center[0];
+                        float ly = xyz_ptr[n + pos] - center[1];
+                        float lz = xyz_ptr[2 * n + pos] - center[2];
+                        if (params.neighbor_type == NEIGHBOR_BALL) {
+                            if (lx * lx + ly * ly + lz * lz > params.max_dist * params.max_dist) {
+                                continue;
+                            }
+                        } else if (std::max(std::max(std::fabs(lx), std::fabs(ly)), std::fabs(lz)) > params.max_dist) {
+                            continue;
+                        }
+                        int64_t gx = static_cast<int64_t>((lx + params.max_dist) / params.grid_size[0]);
+                        int64_t gy = static_cast<int64_t>((ly + params.max_dist) / params.grid_size[1]);
+                        int64_t gz = static_cast<int64_t>((lz + params.max_dist) / params.grid_size[2]);
+                        int64_t grid = gx * params.num_grid[1] * params.num_grid[2] + gy * params.num_grid[2] + gz;
+                        grid = std::min(std::max(grid, int64_t(0)), grids - 1);
+                        if (params.pooling_type != POOLING_AVG && cnt[grid] > 0) {
+                            continue;
+                        }
+                        cnt[grid]++;
+                        int32_t support_idx = sorted_idx_ptr[pos];
+                        if (params.use_xyz) {
+                            local[grid * POINT_DIM] += lx;
+                            local[grid * POINT_DIM + 1] += ly;
+                            local[grid * POINT_DIM + 2] += lz;
+                        }
+                        const float* row = feature_ptr + static_cast<int64_t>(support_idx) * c_in;
+                        float* acc_row = acc.data() + grid * c_in;
+                        for (int64_t c = 0; c < c_in; c++) {
+                            acc_row[c] += row[c];
+                        }
+                        groups[task].insert(groups[task].end(),
+                            {support_idx, static_cast<int32_t>(task), static_cast<int32_t>(grid)});
+                        sample_num++;
+                        done = sample_num >= params.sample_limit;
+                    }
+                }
+            }
+            float* out = out_ptr + task * grids * c_each;
+            for (int64_t g = 0; g < grids; g++) {
+                float scale = cnt[g] > 1 ? 1.0f / static_cast<float>(cnt[g]) : 1.0f;
+                float* acc_row = acc.data() + g * c_in;
+                for (int64_t c = 0; c < c_in; c++) {
+                    acc_row[c] *= scale;
+                }
+                for (int64_t i = 0; i < POINT_DIM; i++) {
+                    local[g * POINT_DIM + i] *= scale;
+                }
+                for (int64_t j = 0; j < c_each; j++) {
+                    float sum = 0.0f;
+                    for (int64_t k = j; k < c_in; k += c_each) {
+                        sum += acc_row[k];
+                    }
+                    out[g * c_each + j] = sum;
+                }
+            }
+        }
+    });
+
+    int64_t total = 0;
+    for (const auto& group : groups) {
+        total += static_cast<int64_t>(group.size()) / GROUP_DIM;
+    }
+    grouped_idxs = at::empty({total, GROUP_DIM}, new_xyz.options().dtype(at::kInt));
+    int32_t* grouped_ptr = grouped_idxs.data_ptr<int32_t>();
+    for (const auto& group : groups) {
+        grouped_ptr = std::copy(group.begin(), group.end(), grouped_ptr);
+    }
+}
+} // namespace
+
+/**
+ * @brief PV-RCNN++的VectorPoolAggregation前向：空间哈希近邻查询 + 局部格子均值池化
+ * @param support_xyz: 源点，2D tensor(N, 3)，按batch堆叠
+ * @param xyz_batch_cnt: 每个batch的源点数，1D tensor(B)
+ * @param support_features: 源点特征，2D tensor(N, C_in)
+ * @param new_xyz: 中心点，2D tensor(M, 3)，按batch堆叠
+ * @param new_xyz_batch_cnt: 每个batch的中心点数，1D tensor(B)
+ * @param num_grid_x, num_grid_y, num_grid_z: 每个中心点邻域划分的局部格子数
+ * @param max_neighbour_distance: 邻域半径
+ * @param num_c_out: 输出通道数，等于格子总数 * 每个格子的通道数，C_in需为每个格子通道数的整数倍
+ * @param use_xyz: 是否输出格子内的平均局部坐标
+ * @param nsample: 每个中心点的最大采样数，<= 0时不限制
+ * @param neighbor_type: 1为球邻域，其他为立方邻域
+ * @param pooling_type: 0为均值池化，1为每个格子取第一个命中点
+ * @return new_features: (M, num_c_out)；new_local_xyz: (M, 3 * 格子总数)；point_cnt_of_grid: (M, 格子总数)，int32；
+ *         grouped_idxs: (T, 3)，int32，每行为(源点下标, 中心点下标, 格子下标)，与vec_pool_backward的输入一致
+ */
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> vec_pool(const at::Tensor& support_xyz,
+    const at::Tensor& xyz_batch_cnt, const at::Tensor& support_features, const at::Tensor& new_xyz,
+    const at::Tensor& new_xyz_batch_cnt, int64_t num_grid_x, int64_t num_grid_y, int64_t num_grid_z,
+    double max_neighbour_distance, int64_t num_c_out, bool use_xyz, int64_t nsample, int64_t neighbor_type,
+    int64_t pooling_type)
+{
+    TORCH_CHECK(support_xyz.dim() == 2 && support_xyz.size(1) == POINT_DIM,
+        "support_xyz must be a 2D tensor with shape [N, 3].");
+    TORCH_CHECK(new_xyz.dim() == 2 && new_xyz.size(1) == POINT_DIM, "new_xyz must be a 2D tensor with shape [M, 3].");
+    TORCH_CHECK(support_features.dim() == 2 && support_features.size(0) == support_xyz.size(0),
+        "support_features must be a 2D tensor with shape [N, C_in].");
+    TORCH_CHECK(xyz_batch_cnt.dim() == 1 && new_xyz_batch_cnt.dim() == 1 &&
+                    xyz_batch_cnt.size(0) == new_xyz_batch_cnt.size(0),
+        "xyz_batch_cnt and new_xyz_batch_cnt must be 1D tensors with the same batch size.");
+    TORCH_CHECK(support_xyz.scalar_type() == at::kFloat && new_xyz.scalar_type() == at::kFloat &&
+                    support_features.scalar_type() == at::kFloat,
+        "vec_pool only support float32 tensor.");
+    TORCH_CHECK(num_grid_x > 0 && num_grid_y > 0 && num_grid_z > 0, "num_grid must be positive.");
+    TORCH_CHECK(max_neighbour_distance > 0, "max_neighbour_distance must be positive.");
+    TORCH_CHECK(pooling_type == POOLING_AVG || pooling_type == POOLING_RANDOM, "pooling_type must be 0 or 1.");
+    int64_t total_grids = num_grid_x * num_grid_y * num_grid_z;
+    TORCH_CHECK(num_c_out > 0 && num_c_out % total_grids == 0,
+        "num_c_out must be a positive multiple of num_grid_x * num_grid_y * num_grid_z.");
+    int64_t c_in = support_features.size(1);
+    int64_t c_each = num_c_out / total_grids;
+    TORCH_CHECK(c_in % c_each == 0, "support_features.shape[1] must be a multiple of num_c_out / total_grids.");
+
+    VecPoolParams params;
+    params.num_grid = {num_grid_x, num_grid_y, num_grid_z};
+    params.max_dist = static_cast<float>(max_neighbour_distance);
+    for (int64_t i = 0; i < POINT_DIM; i++) {
+        params.grid_size[i] = params.max_dist * 2 / params.num_grid[i];
+    }
+    params.total_grids = total_grids;
+    params.c_each = c_each;
+    params.neighbor_type = neighbor_type;
+    params.pooling_type = pooling_type;
+    params.use_xyz = use_xyz;
+    // random pooling每个格子至多一个点，采样数天然以格子总数为上限
+    int64_t limit = nsample > 0 ? nsample : NO_SAMPLE_LIMIT;
+    if (pooling_type == POOLING_RANDOM) {
+        limit = std::min(limit, total_grids);
+    }
+    params.sample_limit = static_cast<int32_t>(std::min(limit, static_cast<int64_t>(NO_SAMPLE_LIMIT)));
+
+    int64_t m = new_xyz.size(0);
+    at::Tensor points = support_xyz.contiguous();
+    at::Tensor centers = new_xyz.contiguous();
+    at::Tensor features = support_features.contiguous();
+    VecPoolHash hash = BuildHash(points, xyz_batch_cnt, centers, new_xyz_batch_cnt, params.max_dist);
+    at::Tensor new_features = at::empty({m, num_c_out}, features.options());
+    at::Tensor new_local_xyz = at::empty({m, total_grids * POINT_DIM}, centers.options());
+    at::Tensor point_cnt_of_grid = at::empty({m, total_grids}, centers.options().dtype(at::kInt));
+    at::Tensor grouped_idxs;
+    if (points.device().is_cpu()) {
+        VecPoolCpu(hash, features, centers, params, new_features, new_local_xyz, point_cnt_of_grid, grouped_idxs);
+        return std::make_tuple(new_features, new_local_xyz, point_cnt_of_grid, grouped_idxs);
+    }
+
+    TORCH_CHECK_NPU(support_xyz);
+    TORCH_CHECK_NPU(support_features);
+    TORCH_CHECK_NPU(new_xyz);
+    auto int_options = centers.options().dtype(at::kInt);
+    at::IntArrayRef num_grid(params.num_grid.data(), POINT_DIM);
+    at::IntArrayRef hash_cells(hash.cells.data(), POINT_DIM);
+    double cell_size = hash.cell_size;
+    double lower_x = hash.lower[0];
+    double lower_y = hash.lower[1];
+    double lower_z = hash.lower[2];
+    int32_t num_c_out_attr = static_cast<int32_t>(num_c_out);
+    int32_t nsample_attr = static_cast<int32_t>(std::max<int64_t>(nsample, 0));
+    int32_t neighbor_type_attr = static_cast<int32_t>(neighbor_type);
+    int32_t pooling_type_attr = static_cast<int32_t>(pooling_type);
+    at::Tensor sample_cnt = at::empty({m}, int_options);
+    at::Tensor group_offset;
+    int64_t capacity = 0;
+    bool bounded = params.sample_limit != NO_SAMPLE_LIMIT;
+    if (bounded) {
+        // 采样数有上限时按上限预留grouped_idxs，一次launch后再压缩，避免计数pass和host同步
+        capacity = m * params.sample_limit;
+        group_offset = at::arange(0, capacity, params.sample_limit, int_options);
+    } else {
+        // 无上限时先跑计数模式得到每个中心点的精确采样数，取代CUDA实现中按num_max_sum_points反复重试的做法
+        at::Tensor empty_float = at::empty({0}, features.options());
+        at::Tensor empty_int = at::empty({0}, int_options);
+        group_offset = at::zeros({m}, int_options);
+        bool count_only = true;
+        int32_t capacity_attr = 0;
+        EXEC_NPU_CMD(aclnnVecPool, hash.sorted_xyz, hash.sorted_idx, hash.cell_start, features, centers,
+            hash.center_batch, group_offset, num_grid, max_neighbour_distance, num_c_out_attr, nsample_attr,
+            neighbor_type_attr, pooling_type_attr, use_xyz, count_only, capacity_attr, hash_cells, cell_size, lower_x,
+            lower_y, lower_z, empty_float, empty_float, empty_int, empty_int, sample_cnt);
+        at::Tensor cum_cnt = sample_cnt.cumsum(0, at::kInt);
+        capacity = m > 0 ? cum_cnt[m - 1].item<int64_t>() : 0;
+        group_offset = cum_cnt - sample_cnt;
+    }
+    TORCH_CHECK(capacity <= std::numeric_limits<int32_t>::max(), "vec_pool: too many sampled points.");
+    at::Tensor grouped_buffer = at::empty({capacity, GROUP_DIM}, int_options);
+    bool count_only = false;
+    int32_t capacity_attr = static_cast<int32_t>(capacity);
+    EXEC_NPU_CMD(aclnnVecPool, hash.sorted_xyz, hash.sorted_idx, hash.cell_start, features, centers,
+        hash.center_batch, group_offset, num_grid, max_neighbour_distance, num_c_out_attr, nsample_attr,
+        neighbor_type_attr, pooling_type_attr, use_xyz, count_only, capacity_attr, hash_cells, cell_size, lower_x,
+        lower_y, lower_z, new_features, new_local_xyz, point_cnt_of_grid, grouped_buffer, sample_cnt);
+    if (bounded) {
+        at::Tensor valid = at::arange(params.sample_limit, int_options).unsqueeze(0) < sample_cnt.unsqueeze(1);
+        grouped_idxs = grouped_buffer.view({m, params.sample_limit, GROUP_DIM})
+                           .masked_select(valid.unsqueeze(2))
+                           .view({-1, GROUP_DIM});
+    } else {
+        grouped_idxs = grouped_buffer;
+    }
+    return std::make_tuple(new_features, new_local_xyz, point_cnt_of_grid, grouped_idxs);
+}
@@ -27,6 +27,19 @@ at::Tensor vec_pool_backward(const at::Tensor& grad_new_features, const at::Tens
     TORCH_CHECK(grouped_idxs.size(1) == 3, "grouped_idxs.shape[1] must be 3, but got: ", grouped_idxs.size(1));
     auto output_size = {n, num_c_in};
     at::Tensor out = at::zeros(output_size, grad_new_features.options());
+    if (grad_new_features.device().is_cpu()) {
+        // grad_support[idx, j] += grad_new[pt, grid * c_each + j % c_each] / max(cnt, 1)
+        int64_t num_total_grids = point_cnt_of_grid.size(1);
+        int64_t c_each = grad_new_features.size(1) / num_total_grids;
+        at::Tensor idxs = grouped_idxs.to(at::kLong);
+        at::Tensor support_idx = idxs.select(1, 0);
+        at::Tensor pt_idx = idxs.select(1, 1);
+        at::Tensor grid_idx = idxs.select(1, 2);
+        at::Tensor cnt = point_cnt_of_grid.index({pt_idx, grid_idx}).clamp_min(1).to(grad_new_features.scalar_type());
+        at::Tensor grad = grad_new_features.view({-1, num_total_grids, c_each}).index({pt_idx, grid_idx});
+        grad = (grad / cnt.unsqueeze(1)).repeat({1, num_c_in / c_each});
+        return out.index_add_(0, support_idx, grad);
+    }
     EXEC_NPU_CMD(aclnnVecPoolGrad, grad_new_features, point_cnt_of_grid, grouped_idxs, n, num_c_in, out);
     return out;
 }
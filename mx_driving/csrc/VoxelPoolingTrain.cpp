@@ -21,10 +21,14 @@ std::tuple<at::Tensor&, at::Tensor&> voxel_pooling_train(const at::Tensor& input
     at::Tensor& outputFeatures, at::Tensor& posMemo, int batchSize, int numPoints, int numChannels, int numVoxelX,
     int numVoxelY, int numVoxelZ)
 {
-    TORCH_CHECK_NPU(inputFeatures);
-    TORCH_CHECK_NPU(geom);
     TORCH_CHECK(inputFeatures.dim() == 3, "inputFeatures.dim() must be 3, but got: ", inputFeatures.dim());
     TORCH_CHECK(geom.dim() == 3, "geom.dim() must be 3, but got: ", geom.dim());
+    if (inputFeatures.device().is_cpu()) {
+        return voxel_pooling_train_cpu(inputFeatures, geom, outputFeatures, posMemo, batchSize, numPoints,
+            numChannels, numVoxelX, numVoxelY, numVoxelZ);
+    }
+    TORCH_CHECK_NPU(inputFeatures);
+    TORCH_CHECK_NPU(geom);
 
     auto origin_dtype = inputFeatures.dtype();
 
@@ -47,10 +51,13 @@ std::tuple<at::Tensor&, at::Tensor&> voxel_pooling_train(const at::Tensor& input
 at::Tensor voxel_pool_train_backward(const at::Tensor& gradOut, const at::Tensor& posMemo, const int64_t batchSize,
     const int64_t numPoints, const int64_t numChannels, const int64_t h, const int64_t w)
 {
-    TORCH_CHECK_NPU(gradOut);
-    TORCH_CHECK_NPU(posMemo);
     TORCH_CHECK(gradOut.dim() == 4, "gradOut.dim() must be 4, but got: ", gradOut.dim());
     TORCH_CHECK(posMemo.dim() == 3, "posMemo.dim() must be 3, but got: ", posMemo.dim());
+    if (gradOut.device().is_cpu()) {
+        return voxel_pool_train_backward_cpu(gradOut, posMemo, batchSize, numPoints, numChannels, h, w);
+    }
+    TORCH_CHECK_NPU(gradOut);
+    TORCH_CHECK_NPU(posMemo);
 
     auto origin_dtype = gradOut.dtype();
 
@@ -39,6 +39,8 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // three_interpolate
     m.def("npu_three_interpolate", &npu_three_interpolate);
     m.def("npu_three_interpolate_backward", &npu_three_interpolate_backward);
+    m.def("npu_three_interpolate_with_dist", &npu_three_interpolate_with_dist);
+    m.def("npu_three_interpolate_with_dist_backward", &npu_three_interpolate_with_dist_backward);
 
     // scatter_mean
     m.def("npu_scatter_mean", &npu_scatter_mean, "npu_scatter_mean NPU version");
@@ -87,9 +89,15 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // npu_box_iou_rotated
     m.def("npu_box_iou_rotated", &npu_box_iou_rotated, "box_iou_rotated NPU version");
 
+    // boxes_overlap_sparse
+    m.def("boxes_overlap_sparse", &boxes_overlap_sparse);
+
     // border_align_forward_npu
     m.def("border_align", &border_align);
 
+    // border_align_max
+    m.def("border_align_max", &border_align_max);
+
     // border_align_backward_npu
     m.def("border_align_backward", &border_align_backward);
 
@@ -99,6 +107,12 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // roiaware_pool3d_grad
     m.def("roiaware_pool3d_grad", &roiaware_pool3d_grad, "roiaware_pool3d_grad NPU version");
 
+    // roiaware_pool3d_csr
+    m.def("roiaware_pool3d_csr", &roiaware_pool3d_csr);
+
+    // roiaware_pool3d_csr_grad
+    m.def("roiaware_pool3d_csr_grad", &roiaware_pool3d_csr_grad);
+
     // pixel_group
     m.def("pixel_group", &pixel_group);
 
@@ -118,6 +132,7 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // npu_deformable_aggregation
     m.def("npu_deformable_aggregation", &deformable_aggregation);
     m.def("npu_deformable_aggregation_backward", &deformable_aggregation_backward);
+    m.def("deformable_aggregation_temporal", &deformable_aggregation_temporal);
 
     // deformable_conv2d
     m.def("deformable_conv2d", &deformable_conv2d);
@@ -133,7 +148,17 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     m.def("group_points", &group_points);
     m.def("group_points_backward", &group_points_backward);
 
+    // packed_point_batch
+    m.def("packed_from_padded", &packed_from_padded);
+    m.def("packed_to_padded", &packed_to_padded);
+    m.def("packed_ptr_from_batch_index", &packed_ptr_from_batch_index);
+    m.def("packed_batch_index", &packed_batch_index);
+
+    // ball_query
+    m.def("ball_query", &ball_query);
+
     // vec_pool
+    m.def("vec_pool", &vec_pool);
     m.def("vec_pool_backward", &vec_pool_backward);
 
     m.def("point_to_voxel", &point_to_voxel);
@@ -151,6 +176,9 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     m.def("npu_bev_pool_v2_backward", &npu_bev_pool_v2_backward, "npu_bev_pool_v2_backward NPU version");
     m.def("npu_bev_pool_v3", &npu_bev_pool_v3, "npu_bev_pool_v3 NPU version");
     m.def("npu_bev_pool_v3_backward", &npu_bev_pool_v3_backward, "npu_bev_pool_v3_backward NPU version");
+    m.def("npu_bev_pool_precompute_key", &npu_bev_pool_precompute_key);
+    m.def("npu_bev_pool_precompute", &npu_bev_pool_precompute, "precompute and cache ranks of bev_pool");
+    m.def("npu_bev_pool_precompute_clear_cache", &npu_bev_pool_precompute_clear_cache);
 
     // furthest_points_sampling_with_dist
     m.def("furthest_point_sampling_with_dist", &furthest_point_sampling_with_dist);
@@ -164,6 +192,7 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
 
     // npu_furthest_point_sampling
     m.def("npu_furthest_point_sampling", &npu_furthest_point_sampling);
+    m.def("npu_furthest_point_sampling_packed", &npu_furthest_point_sampling_packed);
 
     // voxel_pooling
     m.def("voxel_pooling_train", &voxel_pooling_train);
@@ -175,9 +204,15 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // npu_points_in_box_all
     m.def("npu_points_in_box_all", &npu_points_in_box_all);
 
+    // points_in_boxes_grid
+    m.def("points_in_boxes_grid", &points_in_boxes_grid);
+
     // npu_roipoint_pool3d_forward
     m.def("npu_roipoint_pool3d_forward", &npu_roipoint_pool3d_forward);
 
+    // roipoint_pool3d_csr
+    m.def("roipoint_pool3d_csr", &roipoint_pool3d_csr);
+
     // npu_subm_sparse_conv3d
     m.def("npu_subm_sparse_conv3d", &npu_subm_sparse_conv3d);
 
@@ -210,9 +245,15 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // npu_assign_target_of_single_head
     m.def("npu_assign_target_of_single_head", &npu_assign_target_of_single_head);
 
+    // assign_target_of_multi_head
+    m.def("assign_target_of_multi_head", &assign_target_of_multi_head);
+
     // diff_iou_rotated_sort_vertices
     m.def("diff_iou_rotated_sort_vertices", &diff_iou_rotated_sort_vertices);
 
+    // diff_iou_rotated
+    m.def("diff_iou_rotated", &diff_iou_rotated);
+
     // grid_sampler2d_v2
     m.def("grid_sampler2d_v2", &grid_sampler2d_v2);
 
@@ -243,6 +284,9 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m)
     // min_area_polygons
     m.def("min_area_polygons", &min_area_polygons);
 
+    // min_area_rects
+    m.def("min_area_rects", &min_area_rects);
+
     // npu_subm_sparse_conv3d_v2
     m.def("npu_subm_sparse_conv3d_v2", &npu_subm_sparse_conv3d_v2);
 
@@ -27,12 +27,16 @@ class AssignScoreWithkFunction(Function):
             raise Exception("Error! Input shape can not contain zero! \n")
         agg_idx = 0 if aggregate not in agg.keys() else agg[aggregate]
         output = point_features.new_zeros((B, out_dim, npoint, K))
+        # argmax over M is only recorded for the max aggregation, and is consumed by backward
+        argmax_shape = (B, out_dim, npoint, K) if agg_idx == agg["max"] else (0,)
+        argmax = point_features.new_zeros(argmax_shape, dtype=torch.int32)
         mx_driving._C.assign_score_withk(
             point_features.contiguous(),
             center_features.contiguous(),
             scores.contiguous(),
             knn_idx.contiguous(),
             output,
+            argmax,
             B,
             N,
             npoint,
@@ -41,13 +45,13 @@ class AssignScoreWithkFunction(Function):
             out_dim,
             agg_idx)
 
-        ctx.save_for_backward(output, point_features, center_features, scores, knn_idx)
+        ctx.save_for_backward(output, point_features, center_features, scores, knn_idx, argmax)
         ctx.agg = agg_idx
         return output
         
     @staticmethod
     def backward(ctx, grad_out):
-        _, point_features, center_features, scores, knn_idx = ctx.saved_tensors
+        _, point_features, center_features, scores, knn_idx, argmax = ctx.saved_tensors
         agg = ctx.agg
         B, N, M, out_dim = point_features.size()
         _, npoint, K, _ = scores.size()
@@ -64,6 +68,7 @@ class AssignScoreWithkFunction(Function):
             center_features.contiguous(),
             scores.contiguous(),
             knn_idx.contiguous(),
+            argmax,
             grad_point_features,
             grad_center_features,
             grad_scores,
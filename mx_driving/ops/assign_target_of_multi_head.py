@@ -0,0 +1,85 @@
+"""
+Copyright (c) Huawei Technologies Co., Ltd. 2025. All rights reserved.
+"""
+import torch
+import torch_npu
+from torch.autograd import Function
+
+import mx_driving._C
+
+
+class AssignTargetOfMultiHead(Function):
+    @staticmethod
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    def forward(
+        ctx,
+        boxes,
+        labels,
+        head_num_classes,
+        out_size_factor,
+        gaussian_overlap,
+        min_radius,
+        voxel_size,
+        pc_range,
+        feature_map_size,
+        norm_bbox=True,
+        flip_angle=False,
+        max_objs=500,
+    ):
+        if boxes.dim() != 3 or boxes.shape[-1] < 7:
+            raise ValueError("Input boxes shape should be (B, M, D) with D >= 7")
+        if labels.shape != boxes.shape[:2]:
+            raise ValueError("Input labels shape should be (B, M)")
+        output = mx_driving._C.assign_target_of_multi_head(
+            boxes,
+            labels,
+            list(head_num_classes),
+            out_size_factor,
+            gaussian_overlap,
+            min_radius,
+            list(voxel_size),
+            list(pc_range),
+            list(feature_map_size),
+            norm_bbox,
+            flip_angle,
+            max_objs,
+        )
+        return output
+
+
+# pylint: disable=too-many-arguments,huawei-too-many-arguments
+def assign_target_of_multi_head(
+    boxes,
+    labels,
+    head_num_classes,
+    out_size_factor,
+    gaussian_overlap,
+    min_radius,
+    voxel_size,
+    pc_range,
+    feature_map_size,
+    norm_bbox=True,
+    flip_angle=False,
+    max_objs=500,
+):
+    """Assign CenterPoint targets of all task heads for a whole batch at once.
+
+    Returns per-head lists laid out like ``CenterHead.get_targets``: heatmaps of shape
+    (B, num_classes_of_head, H, W) and anno_boxes, inds, masks of shape (B, max_objs, ...).
+    """
+    heatmap, anno_box, ind, mask = AssignTargetOfMultiHead.apply(
+        boxes,
+        labels,
+        head_num_classes,
+        out_size_factor,
+        gaussian_overlap,
+        min_radius,
+        voxel_size,
+        pc_range,
+        feature_map_size,
+        norm_bbox,
+        flip_angle,
+        max_objs,
+    )
+    heatmaps = list(heatmap.split(list(head_num_classes), dim=1))
+    return heatmaps, list(anno_box.unbind(0)), list(ind.unbind(0)), list(mask.unbind(0))
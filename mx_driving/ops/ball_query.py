@@ -0,0 +1,95 @@
+# Copyright (c) OpenMMLab. All rights reserved.
+# Copyright (c) 2024 Huawei Technologies Co., Ltd
+# All rights reserved.
+#
+# Licensed under the BSD 3-Clause License  (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from typing import Tuple
+
+import torch
+from torch.autograd import Function
+
+import mx_driving._C
+
+
+class BallQueryGroup(Function):
+    """Ball query with the grouped features gathered in the same pass."""
+
+    @staticmethod
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    def forward(
+        ctx,
+        min_radius: float,
+        max_radius: float,
+        sample_num: int,
+        xyz: torch.Tensor,
+        center_xyz: torch.Tensor,
+        features: torch.Tensor,
+    ) -> Tuple[torch.Tensor, torch.Tensor]:
+        """
+        Args:
+            min_radius (float): minimum radius of the balls.
+            max_radius (float): maximum radius of the balls.
+            sample_num (int): maximum number of features in the balls.
+            xyz (Tensor): (B, N, 3) xyz coordinates of the points.
+            center_xyz (Tensor): (B, M, 3) centers of the ball query.
+            features (Tensor): (B, C, N) features to group.
+
+        Returns:
+            Tensor: (B, C, M, sample_num) grouped features.
+            Tensor: (B, M, sample_num) int32 indices of the grouped points.
+        """
+        features = features.contiguous()
+        idx, grouped_features = mx_driving._C.ball_query(
+            xyz.contiguous(), center_xyz.contiguous(), features, min_radius, max_radius, sample_num
+        )
+        ctx.for_backwards = (idx, features.size(2))
+        ctx.mark_non_differentiable(idx)
+        return grouped_features, idx
+
+    @staticmethod
+    # pylint: disable=huawei-too-many-arguments
+    def backward(ctx, grad_out: torch.Tensor, grad_idx=None):
+        idx, N = ctx.for_backwards
+        B, C, npoints, nsample = grad_out.size()
+        grad_features = mx_driving._C.group_points_backward(grad_out.contiguous(), idx, B, C, N, npoints, nsample)
+        return None, None, None, None, None, grad_features
+
+
+def ball_query(
+    min_radius: float, max_radius: float, sample_num: int, xyz: torch.Tensor, center_xyz: torch.Tensor
+) -> torch.Tensor:
+    """
+    Find the points within [min_radius, max_radius) of each center, in index order.
+    Returns:
+        Tensor: (B, M, sample_num) int32 indices. Missing slots repeat the first found point.
+    """
+    idx, _ = mx_driving._C.ball_query(xyz.contiguous(), center_xyz.contiguous(), None, min_radius, max_radius, sample_num)
+    return idx
+
+
+# pylint: disable=too-many-arguments,huawei-too-many-arguments
+def ball_query_group(
+    min_radius: float,
+    max_radius: float,
+    sample_num: int,
+    xyz: torch.Tensor,
+    center_xyz: torch.Tensor,
+    features: torch.Tensor,
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    """
+    Fused ball_query + group_points. The gradient flows to `features` only.
+    Returns:
+        Tensor: (B, C, M, sample_num) grouped features.
+        Tensor: (B, M, sample_num) int32 indices.
+    """
+    return BallQueryGroup.apply(min_radius, max_radius, sample_num, xyz, center_xyz, features)
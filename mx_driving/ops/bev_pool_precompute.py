@@ -0,0 +1,65 @@
+# Copyright (c) 2024 Huawei Technologies Co., Ltd. All rights reserved.
+#
+# Licensed under the BSD 3-Clause License  (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from typing import Callable, List, Sequence, Tuple, Union
+
+import torch
+
+import mx_driving._C
+
+
+# pylint: disable=too-many-arguments,huawei-too-many-arguments
+def bev_pool_precompute(
+    coor: Union[torch.Tensor, Callable[[], torch.Tensor]],
+    calib: Sequence[torch.Tensor],
+    grid_lower_bound: Sequence[float],
+    grid_interval: Sequence[float],
+    grid_size: Sequence[int],
+    use_cache: bool = True,
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]:
+    """
+    Build the sorted rank and interval tables of bev_pool_v2 / bev_pool_v3 once per calibration.
+    Args:
+        coor: The frustum points in ego coordinates, with shape [B, N, D, H, W, 3], or a callable returning it.
+            A callable is only evaluated on a cache miss.
+        calib: The calibration tensors (e.g. sensor2ego, intrinsics, post_rots, post_trans, bda) the tables are
+            keyed on.
+        grid_lower_bound: The lower bound of the voxel grid, (x, y, z).
+        grid_interval: The voxel size, (x, y, z).
+        grid_size: The number of voxels, (x, y, z).
+        use_cache: Whether to look up and store the tables in the cache.
+    Returns:
+        ranks_bev, ranks_depth, ranks_feat, interval_starts, interval_lengths, all int32.
+    """
+    calib = list(calib)
+    grid_lower_bound = [float(v) for v in grid_lower_bound]
+    grid_interval = [float(v) for v in grid_interval]
+    grid_size = [int(v) for v in grid_size]
+    # the key checksums the calibration on its device, so it is computed once and reused for lookup and insert
+    key = mx_driving._C.npu_bev_pool_precompute_key(
+        calib, grid_lower_bound, grid_interval, grid_size
+    ) if use_cache else None
+    tables = mx_driving._C.npu_bev_pool_precompute(
+        None, key, grid_lower_bound, grid_interval, grid_size
+    ) if use_cache else []
+    if not tables:
+        if callable(coor):
+            coor = coor()
+        tables = mx_driving._C.npu_bev_pool_precompute(
+            coor, key, grid_lower_bound, grid_interval, grid_size
+        )
+    return tuple(tables)
+
+
+def clear_bev_pool_precompute_cache() -> None:
+    mx_driving._C.npu_bev_pool_precompute_clear_cache()
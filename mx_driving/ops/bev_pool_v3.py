@@ -34,6 +34,7 @@ class BEVPoolV3(torch.autograd.Function):
         ranks_feat: Union[torch.Tensor, None],
         ranks_bev: torch.Tensor,
         bev_feat_shape: List[int],
+        depth_softmax: bool = False,
     ) -> torch.Tensor:
         (B, D, H, W, C) = bev_feat_shape
         feat = feat.contiguous()
@@ -41,7 +42,8 @@ class BEVPoolV3(torch.autograd.Function):
             if ranks_bev.dim() != 2:
                 raise ValueError("ranks_bev must be 2D when running without depth")
             ranks_bev = ranks_bev[:, 3] * D * H * W + ranks_bev[:, 2] * H * W + ranks_bev[:, 0] * W + ranks_bev[:, 1]
-        out = mx_driving._C.npu_bev_pool_v3(depth, feat, ranks_depth, ranks_feat, ranks_bev, B, D, H, W)
+        out = mx_driving._C.npu_bev_pool_v3(depth, feat, ranks_depth, ranks_feat, ranks_bev, B, D, H, W, depth_softmax)
+        ctx.depth_softmax = depth_softmax
         ctx.save_for_backward(depth, feat, ranks_feat, ranks_depth, ranks_bev)
         return out
 
@@ -57,8 +59,9 @@ class BEVPoolV3(torch.autograd.Function):
             ranks_depth,
             ranks_feat,
             ranks_bev,
+            ctx.depth_softmax,
         )
-        return grad_depth, grad_feat, None, None, None, None
+        return grad_depth, grad_feat, None, None, None, None, None
 
 
 # pylint: disable=too-many-arguments,huawei-too-many-arguments
@@ -69,7 +72,12 @@ def bev_pool_v3(
     ranks_feat: Union[torch.Tensor, None],
     ranks_bev: torch.Tensor,
     bev_feat_shape: List[int],
+    depth_softmax: bool = False,
 ) -> torch.Tensor:
+    """
+    When depth_softmax is True, depth holds the depth logits and the softmax over D is applied inside the kernel,
+    so the [B, N, D, H, W] depth probability tensor is never materialized in the forward pass.
+    """
     x = BEVPoolV3.apply(
         depth,
         feat,
@@ -77,6 +85,7 @@ def bev_pool_v3(
         ranks_feat,
         ranks_bev,
         bev_feat_shape,
+        depth_softmax,
     )
     x = x.permute(0, 4, 1, 2, 3).contiguous()
     return x
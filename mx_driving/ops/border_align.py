@@ -19,28 +19,10 @@ class BorderAlignFunction(Function):
             raise Exception("Error! Input Tensor can not be a empty Tensor! \n")
         ctx.pooled_size = pooled_size
         ctx.feature_size = feature_map.size()
-        batch_size, num_channels, data_height, data_width = feature_map.size()
-        output = torch.zeros(batch_size, data_height * data_width, ctx.pooled_size + 1, num_channels).to(
-            feature_map.device
-        )
-
-        mx_driving._C.border_align(feature_map, rois, output, ctx.pooled_size)
-
-        npu_outputs, index = output.max(dim=-2)
-        npu_outputs = (
-            npu_outputs.reshape([batch_size, data_height * data_width, 4, num_channels // 4])
-            .permute([0, 3, 1, 2])
-            .contiguous()
-        )
-        index = (
-            index.int()
-            .reshape([batch_size, data_height * data_width, 4, num_channels // 4])
-            .permute([0, 3, 1, 2])
-            .contiguous()
-        )
+        # the max over the border points is taken inside the kernel, no (pooled_size + 1)-times intermediate is built
+        outputs, index = mx_driving._C.border_align_max(feature_map, rois, ctx.pooled_size)
         ctx.save_for_backward(rois, index)
-
-        return npu_outputs
+        return outputs
 
     @staticmethod
     def backward(ctx, grad_output):
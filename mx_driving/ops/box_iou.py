@@ -2,6 +2,8 @@ import torch
 
 import mx_driving._C
 
+SPARSE_IOU_MODES = {"iou": 0, "iof": 1}
+
 
 class BoxIouQuadri(torch.autograd.Function):
     @staticmethod
@@ -45,3 +47,28 @@ def box_iou_quadri(boxes_a, boxes_b, mode='iou', aligned=False):
 
 def box_iou_rotated(boxes_a, boxes_b, mode='iou', aligned=False, clockwise=True):
     return BoxIouRotated.apply(boxes_a, boxes_b, mode, aligned, clockwise)
+
+
+def box_iou_quadri_sparse(boxes_a, boxes_b, mode='iou'):
+    """
+    Sparse version of box_iou_quadri, returning (indices [2, K], values [K]) for the overlapping pairs only.
+    """
+    if mode not in SPARSE_IOU_MODES:
+        raise ValueError(f"mode must be one of {list(SPARSE_IOU_MODES)}, but got {mode}")
+    mode_flag = SPARSE_IOU_MODES[mode]
+    return mx_driving._C.boxes_overlap_sparse(boxes_a, boxes_b, 2, 0, 0, True, mode_flag, 0.0)
+
+
+def box_iou_rotated_sparse(boxes_a, boxes_b, mode='iou', clockwise=True):
+    """
+    Sparse version of box_iou_rotated, returning (indices [2, K], values [K]) for the overlapping pairs only.
+    """
+    if mode not in SPARSE_IOU_MODES:
+        raise ValueError(f"mode must be one of {list(SPARSE_IOU_MODES)}, but got {mode}")
+    mode_flag = SPARSE_IOU_MODES[mode]
+    if not clockwise:
+        flip_mat = boxes_a.new_ones(boxes_a.shape[-1])
+        flip_mat[-1] = -1
+        boxes_a = boxes_a * flip_mat
+        boxes_b = boxes_b * flip_mat
+    return mx_driving._C.boxes_overlap_sparse(boxes_a, boxes_b, 1, 0, 0, True, mode_flag, 0.0)
@@ -87,4 +87,29 @@ def boxes_iou_bev(boxes_a, boxes_b):
     mode = "iou"
     aligned = False
     margin = 1e-5
-    return BoxesOverlapBev.apply(boxes_a, boxes_b, inp_format, r_unit, clockwise, mode, aligned, margin)
\ No newline at end of file
+    return BoxesOverlapBev.apply(boxes_a, boxes_b, inp_format, r_unit, clockwise, mode, aligned, margin)
+
+
+def boxes_overlap_bev_sparse(boxes_a, boxes_b, mode="overlap"):
+    """
+    Sparse version of boxes_overlap_bev for large box sets. Only pairs whose circumscribed circles intersect
+    (found by a sort-and-sweep along x) are clipped, and only pairs with a positive overlap are returned.
+    Returns:
+        indices: [2, K] int64 (row in boxes_a, row in boxes_b), sorted by (i, j).
+        values: [K] overlap / iou / iof of these pairs.
+    """
+    mode_dict = {"overlap": 0, "iou": 1, "iof": 2}
+    if mode not in mode_dict:
+        raise ValueError(f"mode must be one of {list(mode_dict)}, but got {mode}")
+    if boxes_a.shape[-1] == 5:
+        format_flag, clockwise = 0, False
+    else:
+        format_flag, clockwise = 3, True
+    return mx_driving._C.boxes_overlap_sparse(
+        boxes_a, boxes_b, 0, format_flag, 0, clockwise, mode_dict[mode], 1e-5
+    )
+
+
+def boxes_iou_bev_sparse(boxes_a, boxes_b):
+    # sparse OpenPCDet version of boxes_iou_bev
+    return mx_driving._C.boxes_overlap_sparse(boxes_a, boxes_b, 0, 3, 0, True, 1, 1e-5)
@@ -8,34 +8,100 @@ Modification 1. Add support for Ascend NPU
 """
 import warnings
 
-import numpy as np
 import torch
 import torch_npu
 from torch.autograd import Function
 
 import mx_driving._C
+from .packed_point_batch import PackedPointBatch
 
 
 class AdsFurthestPointSampling(Function):
     @staticmethod
-    def forward(ctx, point_xyz, num_points):
+    def forward(ctx, point_xyz, num_points, point_counts=None):
         if (torch.numel(point_xyz) == 0):
             raise Exception("Error! Input Tensor can not be a empty Tensor.\n")
         
         if (num_points == 0):
             raise Exception("Error! num_points can not zero.\n")
         
-        B, N = point_xyz.size()[:2]
         point_xyz = point_xyz.permute(0, 2, 1).contiguous()
+        if point_counts is not None:
+            point_counts = point_counts.to(device=point_xyz.device, dtype=torch.int32).contiguous()
 
-        nearest_dist = torch.tensor(np.ones((B, N)) * 1e10, dtype=torch.float32, device="npu").contiguous()
-        output = mx_driving._C.npu_furthest_point_sampling(point_xyz, nearest_dist, num_points)
+        output = mx_driving._C.npu_furthest_point_sampling(point_xyz, point_counts, num_points)
 
         return output
 
 
-def furthest_point_sampling(point_xyz, num_points):
-    return AdsFurthestPointSampling.apply(point_xyz, num_points)
+def furthest_point_sampling(point_xyz, num_points, point_counts=None):
+    return AdsFurthestPointSampling.apply(point_xyz, num_points, point_counts)
+
+
+def furthest_point_sampling_packed(points, ptr, num_points, max_num_points=None):
+    """Furthest point sampling over a ragged batch packed as ``[total, 3]``.
+
+    Sample ``b`` owns ``points[ptr[b]:ptr[b + 1]]``. ``points`` may also be a ``PackedPointBatch``, in which case
+    ``ptr`` is ignored. The returned ``[B, num_points]`` indices point into the packed ``points``. The kernel reads
+    each sample in place from its offset, so no padded buffer is built and ``ptr`` never leaves the device.
+    ``max_num_points`` is kept for backward compatibility and is ignored. A sample without points has no valid
+    index, so its row is filled with -1.
+    """
+    if isinstance(points, PackedPointBatch):
+        ptr = points.ptr
+        points = points.points
+    if (torch.numel(points) == 0):
+        raise Exception("Error! Input Tensor can not be a empty Tensor.\n")
+    if (num_points == 0):
+        raise Exception("Error! num_points can not zero.\n")
+    if not isinstance(ptr, torch.Tensor):
+        ptr = torch.tensor(ptr, dtype=torch.int64)
+    ptr = ptr.to(device=points.device, dtype=torch.int64)
+    output = mx_driving._C.npu_furthest_point_sampling_packed(points, ptr, num_points)
+    output = output + ptr[:-1, None].to(output.dtype)
+    return output.masked_fill((ptr[1:] - ptr[:-1])[:, None] == 0, -1)
+
+
+def furthest_point_sampling_approx(point_xyz, num_points, voxel_size, point_counts=None):
+    """Approximate furthest point sampling over voxel-grid bucket representatives.
+
+    Each occupied voxel of a sample is represented by its lowest-index point and exact FPS runs on the
+    representatives only, so the cost drops from O(N * M) to O(R * M) with R occupied voxels. ``voxel_size`` is the
+    quality knob: coverage radius grows by at most one voxel diagonal, and a voxel smaller than the point spacing
+    reproduces the exact result. Returns ``[B, num_points]`` indices into ``point_xyz`` like ``furthest_point_sampling``,
+    except that a sample without valid points gets a row of -1.
+    """
+    if (torch.numel(point_xyz) == 0):
+        raise Exception("Error! Input Tensor can not be a empty Tensor.\n")
+    B, N = point_xyz.size()[:2]
+    device = point_xyz.device
+    voxel_size = torch.as_tensor(voxel_size, dtype=torch.float32, device=device).expand(3)
+    points = point_xyz.float()
+    valid = torch.ones((B, N), dtype=torch.bool, device=device)
+    if point_counts is not None:
+        point_counts = point_counts.to(device=device, dtype=torch.int64)
+        valid = torch.arange(N, device=device)[None, :] < point_counts[:, None]
+
+    # voxelize each sample from its own lower corner, an empty sample keeps a finite corner
+    lower = points.masked_fill(~valid[..., None], float("inf")).amin(dim=1, keepdim=True)
+    lower = lower.masked_fill(~torch.isfinite(lower), 0)
+    coors = ((points - lower) / voxel_size).floor().clamp_(min=0).long()
+    # (batch, x, y, z) rows are deduplicated directly, a flattened key could overflow int64 for tiny voxels
+    keys = torch.cat([torch.arange(B, device=device)[:, None, None].expand(B, N, 1), coors], dim=2)
+    flat_idx = torch.arange(B * N, device=device).view(B, N)[valid]
+    _, inverse, counts = torch.unique(keys[valid], sorted=True, return_inverse=True, return_counts=True, dim=0)
+    order = torch.sort(inverse, stable=True)[1]
+    # the lowest-index point represents its voxel, sorting by index keeps point 0 as the first sample
+    rep = flat_idx[order[counts.cumsum(0) - counts]].sort()[0]
+
+    if rep.numel() == 0:
+        return torch.full((B, num_points), -1, dtype=torch.int32, device=device)
+    rep_counts = torch.bincount(rep // N, minlength=B)
+    ptr = torch.cat([rep_counts.new_zeros(1), rep_counts.cumsum(0)])
+    rep_points = points.view(B * N, 3)[rep]
+    output = furthest_point_sampling_packed(rep_points, ptr, num_points)
+    result = rep[output.long().clamp(min=0)] - torch.arange(B, device=device)[:, None] * N
+    return result.masked_fill(output < 0, -1).to(torch.int32)
 
 
 def npu_furthest_point_sampling(point_xyz, num_points):
@@ -7,19 +7,25 @@ Modification Description:
 Modification 1. Add support for Ascend NPU
 """
 
-from typing import Optional
+from typing import Optional, Union
 
 import torch
 import torch_npu
 from torch.autograd import Function
 
 import mx_driving._C
+from .packed_point_batch import PackedPointBatch
 
 
 class Knn(Function):
     @staticmethod
     def forward(
-        ctx, k: int, xyz: torch.Tensor, center_xyz: Optional[torch.Tensor] = None, transposed: bool = False
+        ctx,
+        k: int,
+        xyz: torch.Tensor,
+        center_xyz: Optional[torch.Tensor] = None,
+        transposed: bool = False,
+        use_grid: bool = False,
     ) -> torch.Tensor:
         if k <= 0 and k >= 100:
             print("k should be in range (0, 100).")
@@ -42,12 +48,55 @@ class Knn(Function):
             print("center_xyz and xyz should be on the same device.")
             return None
 
-        dist2, idx = mx_driving._C.knn(xyz, center_xyz, k, True)
-        zeros_idx = torch.zeros(xyz.shape[0], center_xyz.shape[1], k, dtype=torch.int32).npu()
-        idx.where(dist2 >= 1e10, zeros_idx)
+        # use_grid: sources are bucketed on a BEV grid and each target only visits neighboring cells
+        dist2, idx = mx_driving._C.knn(xyz, center_xyz, k, True, False, use_grid)
+        # slots without a neighbour within the distance clip point at the first source point
+        idx = idx.masked_fill(dist2 >= 1e10, 0)
         idx = idx.transpose(2, 1).contiguous()  # [B, k, npoint]
 
         return idx.int()
 
 
-knn = Knn.apply
+def _packed_pad_point(xyz: PackedPointBatch, center_xyz: PackedPointBatch) -> torch.Tensor:
+    """A source point farther from every center than any real source point.
+
+    Only z is moved above the joint bounding box by its diagonal, so the value stays finite in the input dtype and
+    the BEV bounds used by ``use_grid`` are unchanged.
+    """
+    points = torch.cat([xyz.points, center_xyz.points]).float()
+    low, high = points.amin(0), points.amax(0)
+    pad = low.clone()
+    pad[2] = high[2] + (high - low).norm() + 1
+    return pad.to(xyz.points.dtype)
+
+
+def knn_packed(k: int, xyz: PackedPointBatch, center_xyz: PackedPointBatch, use_grid: bool = False) -> torch.Tensor:
+    """
+    knn over ragged batches. Returns ``[total_centers, k]`` int32 indices into the packed ``xyz.points``; slots
+    beyond the number of source points of a sample are -1.
+    """
+    if xyz.batch_size != center_xyz.batch_size:
+        raise ValueError("xyz and center_xyz must have the same batch size.")
+    if xyz.points.size(0) == 0:
+        return torch.full((center_xyz.points.size(0), k), -1, dtype=torch.int32, device=center_xyz.points.device)
+    padded = xyz.to_padded()
+    if not xyz.is_uniform:
+        padded = torch.where(xyz.valid_mask()[..., None], padded, _packed_pad_point(xyz, center_xyz))
+    idx = Knn.apply(k, padded, center_xyz.to_padded(), False, use_grid)
+    batch = center_xyz.batch_index()
+    idx = idx.transpose(2, 1)[batch, center_xyz.local_index()]
+    # padding slots rank last, so they only show up in samples with fewer than k source points
+    invalid = idx >= xyz.counts[batch, None]
+    return (idx + xyz.ptr[batch, None]).masked_fill(invalid, -1).int()
+
+
+def knn(
+    k: int,
+    xyz: Union[torch.Tensor, PackedPointBatch],
+    center_xyz: Optional[Union[torch.Tensor, PackedPointBatch]] = None,
+    transposed: bool = False,
+    use_grid: bool = False,
+) -> torch.Tensor:
+    if isinstance(xyz, PackedPointBatch):
+        return knn_packed(k, xyz, xyz if center_xyz is None else center_xyz, use_grid)
+    return Knn.apply(k, xyz, center_xyz, transposed, use_grid)
@@ -9,11 +9,26 @@ import torch_npu
 import mx_driving._C
 
 
+def _check_pointsets(pointsets):
+    if pointsets.dim() != 2 or pointsets.shape[1] < 2 or pointsets.shape[1] % 2 != 0:
+        raise ValueError("Input pointsets shape should be (N, 2K)")
+
+
 class MinAreaPolygonsFunction(Function):
     @staticmethod
     def forward(ctx, pointsets):
-        if pointsets.shape[1] != 18:
-            raise 'Input pointsets shape should be (N, 18)'
+        _check_pointsets(pointsets)
         result = mx_driving._C.min_area_polygons(pointsets)
         return result
-min_area_polygons = MinAreaPolygonsFunction.apply
\ No newline at end of file
+
+
+class MinAreaRectsFunction(Function):
+    @staticmethod
+    def forward(ctx, pointsets):
+        _check_pointsets(pointsets)
+        result = mx_driving._C.min_area_rects(pointsets)
+        return result
+
+
+min_area_polygons = MinAreaPolygonsFunction.apply
+min_area_rects = MinAreaRectsFunction.apply
@@ -17,11 +17,14 @@ class AdsDeformableAggregation(Function):
         scale_start_index: torch.Tensor,
         sampling_location: torch.Tensor,
         weights: torch.Tensor,
+        use_softmax: bool = False,
     ):
         if (torch.numel(mc_ms_feat) == 0 or torch.numel(weights) == 0):
             raise Exception("Erorr! Input Tensor can not be a empty Tensor.\n")
 
-        mc_ms_feat = mc_ms_feat.contiguous().float()
+        if mc_ms_feat.dtype not in (torch.float16, torch.bfloat16):
+            mc_ms_feat = mc_ms_feat.float()
+        mc_ms_feat = mc_ms_feat.contiguous()
         spatial_shape = spatial_shape.contiguous().int()
         scale_start_index = scale_start_index.contiguous().int()
         sampling_location = sampling_location.contiguous().float()
@@ -33,7 +36,9 @@ class AdsDeformableAggregation(Function):
             scale_start_index,
             sampling_location,
             weights,
+            use_softmax,
         )
+        ctx.use_softmax = use_softmax
         ctx.save_for_backward(
             mc_ms_feat,
             spatial_shape,
@@ -55,16 +60,7 @@ class AdsDeformableAggregation(Function):
 
         if (torch.numel(mc_ms_feat) == 0 or torch.numel(spatial_shape) == 0 or torch.numel(sampling_location) == 0):
             raise Exception("Erorr! Input Tensor can not be a empty Tensor.\n")
-        npu_device = mc_ms_feat.device
-        mc_ms_feat = mc_ms_feat.contiguous().float()
-        spatial_shape = spatial_shape.contiguous().int()
-        scale_start_index = scale_start_index.contiguous().int()
-        sampling_location = sampling_location.contiguous().float()
-        weights = weights.contiguous().float()
 
-        grad_mc_ms_feat = torch.zeros_like(mc_ms_feat)
-        grad_sampling_location_padding = torch.zeros((sampling_location.shape[0], sampling_location.shape[1], sampling_location.shape[2], sampling_location.shape[3], 8), device=npu_device)
-        grad_weights = torch.zeros_like(weights)
         grad_mc_ms_feat, grad_sampling_location, grad_weights = mx_driving._C.npu_deformable_aggregation_backward(
             mc_ms_feat,
             spatial_shape,
@@ -72,19 +68,109 @@ class AdsDeformableAggregation(Function):
             sampling_location,
             weights,
             grad_output.contiguous(),
-            grad_mc_ms_feat,
-            grad_sampling_location_padding,
-            grad_weights,
+            None,
+            None,
+            None,
+            ctx.use_softmax,
         )
-        grad_sampling_location, _, _, _ = torch.chunk(grad_sampling_location_padding, 4, dim=-1)
         return (
             grad_mc_ms_feat,
             None,
             None,
             grad_sampling_location,
             grad_weights,
+            None,
         )
 
 
 npu_deformable_aggregation = AdsDeformableAggregation.apply
 deformable_aggregation = AdsDeformableAggregation.apply
+
+
+class DeformableAggregationFeatureCache:
+    """Ring buffer of flattened multi-camera multi-scale features for streaming inference.
+
+    Each slot holds one frame laid out as ``[bs, num_feat, c]``, the same layout ``deformable_aggregation``
+    consumes. ``update`` writes the per-level feature maps of the current frame directly into the next slot,
+    so history frames are never re-flattened or concatenated again.
+
+    ``scale_start_index`` is a ``[num_cams, num_scale]`` tensor or nested list. It is copied to the host once
+    here, so writing per-level feature maps in ``update`` never waits on the device.
+    """
+
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    def __init__(self, num_slots: int, batch_size: int, num_feat: int, num_embeds: int,
+                 dtype: torch.dtype = torch.float32, device="npu", scale_start_index=None):
+        if num_slots <= 0:
+            raise ValueError("num_slots must be positive.")
+        self.num_slots = num_slots
+        self.buffer = torch.zeros((num_slots, batch_size, num_feat, num_embeds), dtype=dtype, device=device)
+        self.current_slot = -1
+        if isinstance(scale_start_index, torch.Tensor):
+            scale_start_index = scale_start_index.cpu().tolist()
+        self.start_index = scale_start_index
+
+    def update(self, feature_maps, scale_start_index=None) -> int:
+        """Write the current frame into the next slot and return the slot index.
+
+        ``feature_maps`` is either a flattened ``[bs, num_feat, c]`` tensor or a list of per-level
+        ``[bs, num_cams, c, h, w]`` tensors, in which case level ``l`` of camera ``cam`` is written at
+        ``start_index[cam][l]``. The start indices come from the constructor; ``scale_start_index`` is only
+        kept for backward compatibility, and a tensor passed here is copied to the host the first time only.
+        """
+        if self.start_index is None and scale_start_index is not None:
+            if isinstance(scale_start_index, torch.Tensor):
+                scale_start_index = scale_start_index.cpu().tolist()
+            self.start_index = scale_start_index
+        self.current_slot = (self.current_slot + 1) % self.num_slots
+        slot = self.buffer[self.current_slot]
+        if isinstance(feature_maps, torch.Tensor):
+            slot.copy_(feature_maps)
+            return self.current_slot
+        if self.start_index is None:
+            raise ValueError("scale_start_index is required to write per-level feature maps.")
+        for level, feat in enumerate(feature_maps):
+            num_cams, num_embeds, h, w = feat.shape[1:]
+            for cam in range(num_cams):
+                start = self.start_index[cam][level]
+                slot[:, start:start + h * w].copy_(feat[:, cam].flatten(-2).transpose(-1, -2))
+        return self.current_slot
+
+    def slot_of(self, frame_offset: int) -> int:
+        """Slot index holding the frame ``frame_offset`` steps before the current one."""
+        if self.current_slot < 0:
+            raise RuntimeError("The feature cache is empty.")
+        if frame_offset < 0 or frame_offset >= self.num_slots:
+            raise ValueError("frame_offset must be in [0, num_slots).")
+        return (self.current_slot - frame_offset) % self.num_slots
+
+
+# pylint: disable=too-many-arguments,huawei-too-many-arguments
+def deformable_aggregation_temporal(
+    feat_cache: torch.Tensor,
+    spatial_shape: torch.Tensor,
+    scale_start_index: torch.Tensor,
+    sampling_location: torch.Tensor,
+    weights: torch.Tensor,
+    slot_index: torch.Tensor,
+    use_softmax: bool = False,
+):
+    """Inference-only deformable aggregation over a ``[num_slots, bs, num_feat, c]`` feature cache.
+
+    Anchor ``(b, a)`` samples the frame stored in ``feat_cache[slot_index[b, a], b]``.
+    """
+    if isinstance(feat_cache, DeformableAggregationFeatureCache):
+        feat_cache = feat_cache.buffer
+    if (torch.numel(feat_cache) == 0 or torch.numel(weights) == 0):
+        raise Exception("Erorr! Input Tensor can not be a empty Tensor.\n")
+    if feat_cache.dtype not in (torch.float16, torch.bfloat16):
+        feat_cache = feat_cache.float()
+    return mx_driving._C.deformable_aggregation_temporal(
+        feat_cache.contiguous(),
+        spatial_shape.contiguous().int(),
+        scale_start_index.contiguous().int(),
+        sampling_location.contiguous().float(),
+        weights.contiguous().float(),
+        slot_index.contiguous().int(),
+        use_softmax,
+    )
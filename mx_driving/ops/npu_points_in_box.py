@@ -36,4 +36,24 @@ def npu_points_in_box(boxes, pt):
         "`npu_points_in_box` will be deprecated in future. Please use `points_in_box` instead.",
         DeprecationWarning,
     )
-    return PointsInBoxFunction.apply(boxes, pt)
\ No newline at end of file
+    return PointsInBoxFunction.apply(boxes, pt)
+
+
+def points_in_boxes_first(boxes, pts, cell_size=0.0):
+    """
+    Batched points_in_box without the box count limit. Boxes are binned into a BEV grid so each point only
+    tests the boxes of its own cell.
+    Returns:
+        boxes_idx_of_points: [B, N] int32, index of the first box containing each point, -1 if none.
+    """
+    return mx_driving._C.points_in_boxes_grid(boxes, pts, False, cell_size)[0]
+
+
+def points_in_boxes_csr(boxes, pts, cell_size=0.0):
+    """
+    Returns every box containing each point as a CSR list over the B * N flattened points.
+    Returns:
+        ptr: [B * N + 1] int64, boxes of point b * N + n are box_idx[ptr[b * N + n]:ptr[b * N + n + 1]].
+        box_idx: [K] int64, box indices within the batch, ascending for each point.
+    """
+    return mx_driving._C.points_in_boxes_grid(boxes, pts, True, cell_size)
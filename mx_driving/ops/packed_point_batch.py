@@ -0,0 +1,97 @@
+# Copyright (c) OpenMMLab. All rights reserved.
+# Copyright (c) 2024 Huawei Technologies Co., Ltd
+# All rights reserved.
+#
+# Licensed under the BSD 3-Clause License  (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+from typing import Optional, Sequence, Union
+
+import torch
+
+import mx_driving._C
+
+
+class PackedPointBatch:
+    """A ragged point-cloud batch packed as ``[total, C]``: sample ``b`` owns ``points[ptr[b]:ptr[b + 1]]``.
+
+    Converts between the padded ``[B, N, C]``, ptr-offset ``[B + 1]`` and per-point batch-index layouts. A batch
+    built from a padded tensor without counts is a zero-copy view and converts back to the same storage. Passing
+    ``max_num_points`` / ``total`` up front avoids device to host syncs in the conversions.
+    """
+
+    def __init__(self, points: torch.Tensor, ptr: torch.Tensor, max_num_points: Optional[int] = None,
+                 uniform_num_points: Optional[int] = None):
+        self.points = points
+        self.ptr = ptr.to(device=points.device, dtype=torch.int64)
+        self._max_num_points = max_num_points
+        self._uniform_num_points = uniform_num_points
+        self._batch_index = None
+
+    @classmethod
+    def from_padded(cls, padded: torch.Tensor, counts: Optional[torch.Tensor] = None,
+                    total: Optional[int] = None) -> "PackedPointBatch":
+        """Pack ``[B, N, C]`` with ``counts[b]`` valid leading points per sample, all ``N`` when counts is None."""
+        if counts is not None:
+            counts = counts.to(device=padded.device, dtype=torch.int64)
+        points, ptr = mx_driving._C.packed_from_padded(padded, counts, -1 if total is None else total)
+        uniform = padded.size(1) if counts is None else None
+        return cls(points, ptr, padded.size(1), uniform)
+
+    @classmethod
+    def from_ptr(cls, points: torch.Tensor, ptr: Union[torch.Tensor, Sequence[int]],
+                 max_num_points: Optional[int] = None) -> "PackedPointBatch":
+        if not isinstance(ptr, torch.Tensor):
+            ptr = torch.tensor(ptr, dtype=torch.int64)
+        return cls(points, ptr, max_num_points)
+
+    @classmethod
+    def from_batch_index(cls, points: torch.Tensor, batch_idx: torch.Tensor, batch_size: int,
+                         max_num_points: Optional[int] = None) -> "PackedPointBatch":
+        """``batch_idx`` must be non-decreasing, i.e. the points of a sample are contiguous."""
+        ptr = mx_driving._C.packed_ptr_from_batch_index(batch_idx.to(points.device), batch_size)
+        batch = cls(points, ptr, max_num_points)
+        batch._batch_index = batch_idx.to(device=points.device, dtype=torch.int64)
+        return batch
+
+    @property
+    def batch_size(self) -> int:
+        return self.ptr.numel() - 1
+
+    @property
+    def counts(self) -> torch.Tensor:
+        return self.ptr[1:] - self.ptr[:-1]
+
+    @property
+    def max_num_points(self) -> int:
+        if self._max_num_points is None:
+            self._max_num_points = int(self.counts.max()) if self.batch_size > 0 else 0
+        return self._max_num_points
+
+    def batch_index(self) -> torch.Tensor:
+        if self._batch_index is None:
+            self._batch_index, _ = mx_driving._C.packed_batch_index(self.ptr, self.points.size(0))
+        return self._batch_index
+
+    @property
+    def is_uniform(self) -> bool:
+        """True when every sample has the same number of points, i.e. ``to_padded`` has no padding slots."""
+        return self._uniform_num_points is not None
+
+    def valid_mask(self) -> torch.Tensor:
+        """``[B, max_num_points]`` bool mask of ``to_padded``, False on the padding slots."""
+        return torch.arange(self.max_num_points, device=self.points.device) < self.counts[:, None]
+
+    def local_index(self) -> torch.Tensor:
+        return torch.arange(self.points.size(0), device=self.points.device) - self.ptr[self.batch_index()]
+
+    def to_padded(self, pad_value: float = 0.0) -> torch.Tensor:
+        if self._uniform_num_points is not None:
+            return self.points.view(self.batch_size, self._uniform_num_points, -1)
+        return mx_driving._C.packed_to_padded(self.points, self.ptr, self.max_num_points, pad_value)
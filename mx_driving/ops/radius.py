@@ -6,21 +6,35 @@ Modification Description:
 Modification 1. Add support for Ascend NPU
 """
 
-from typing import Tuple, Union
+from typing import Optional, Tuple, Union
 import torch
 from torch.autograd import Function
 from torch.nn import Module
 from torch import Tensor
 import torch_npu
 import mx_driving._C
+from .packed_point_batch import PackedPointBatch
 
 
 class Radius(Function):
     @staticmethod
     # pylint: disable=huawei-too-many-arguments
     def forward(ctx, x: torch.Tensor, y: torch.Tensor, ptr_x: torch.Tensor,
-                ptr_y: torch.Tensor, r: float, max_num_neighbors: int) -> Tensor:
-        output, actual_num_neighbors = mx_driving._C.radius(x, y, ptr_x, ptr_y, r, max_num_neighbors)
+                ptr_y: torch.Tensor, r: float, max_num_neighbors: int, padded: bool = False) -> Tensor:
+        output, actual_num_neighbors = mx_driving._C.radius(x, y, ptr_x, ptr_y, r, max_num_neighbors, padded)
+        if padded:
+            # no device->host sync: the pairs are padded with -1 after the first num_neighbors columns
+            return output, actual_num_neighbors[0:1]
         return output[:, 0:actual_num_neighbors[0]]
 
-radius = Radius.apply
\ No newline at end of file
+
+# pylint: disable=huawei-too-many-arguments
+def radius(x: Union[Tensor, PackedPointBatch], y: Union[Tensor, PackedPointBatch], ptr_x: Optional[Tensor],
+           ptr_y: Optional[Tensor], r: float, max_num_neighbors: int,
+           padded: bool = False) -> Union[Tensor, Tuple[Tensor, Tensor]]:
+    # a PackedPointBatch carries its own offsets, the matching ptr argument is ignored
+    if isinstance(x, PackedPointBatch):
+        x, ptr_x = x.points, x.ptr.int()
+    if isinstance(y, PackedPointBatch):
+        y, ptr_y = y.points, y.ptr.int()
+    return Radius.apply(x, y, ptr_x, ptr_y, r, max_num_neighbors, padded)
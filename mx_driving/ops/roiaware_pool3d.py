@@ -34,6 +34,7 @@ class RoIAwarePool3dFunction(Function):
         out_size: Union[int, tuple],
         max_pts_per_voxel: int,
         mode: int,
+        use_csr: bool = False,
     ):
         if (out_size == 0):
             raise Exception("Error! out_size can not be 0.\n")
@@ -51,6 +52,17 @@ class RoIAwarePool3dFunction(Function):
         num_rois = rois.shape[0]
         num_channels = pts_feature.shape[-1]
         num_pts = pts.shape[0]
+        ctx.use_csr = use_csr or pts.device.type == "cpu"
+        ctx.mode = mode
+        ctx.num_pts = num_pts
+
+        if ctx.use_csr:
+            # compact (roi, voxel) -> points CSR, pooled in the feature dtype without a dense index tensor
+            pooled_features, argmax, voxel_idx, voxel_ptr, pts_idx = mx_driving._C.roiaware_pool3d_csr(
+                rois, pts, pts_feature, out_x, out_y, out_z, max_pts_per_voxel, mode
+            )
+            ctx.save_for_backward(voxel_idx, voxel_ptr, pts_idx, argmax)
+            return pooled_features
 
         pooled_features = pts_feature.new_zeros((num_rois, out_x, out_y, out_z, num_channels))
         argmax = pts_feature.new_zeros((num_rois, out_x, out_y, out_z, num_channels), dtype=torch.int32)
@@ -60,7 +72,7 @@ class RoIAwarePool3dFunction(Function):
             rois, pts, pts_feature, argmax, pts_idx_of_voxels, pooled_features, mode
         )
 
-        ctx.save_for_backward(pts_idx_of_voxels, argmax, mode, num_pts, num_channels)
+        ctx.save_for_backward(pts_idx_of_voxels, argmax)
 
         return pooled_features
 
@@ -70,15 +82,18 @@ class RoIAwarePool3dFunction(Function):
         if (torch.numel(grad_out) == 0):
             raise Exception("Error! Input Tensor can not be a empty Tensor.\n")
         
-        ret = ctx.roiaware_pool3d_for_backward
-        pts_idx_of_voxels, argmax, mode, num_pts, num_channels = ret
-
-        # backward
-        grad_in = mx_driving._C.roiaware_pool3d_grad(
-            pts_idx_of_voxels, argmax, grad_out.contiguous(), num_pts, pool_method=mode
-        )
+        if ctx.use_csr:
+            voxel_idx, voxel_ptr, pts_idx, argmax = ctx.saved_tensors
+            grad_in = mx_driving._C.roiaware_pool3d_csr_grad(
+                voxel_idx, voxel_ptr, pts_idx, argmax, grad_out.contiguous(), ctx.num_pts, ctx.mode
+            )
+        else:
+            pts_idx_of_voxels, argmax = ctx.saved_tensors
+            grad_in = mx_driving._C.roiaware_pool3d_grad(
+                pts_idx_of_voxels, argmax, grad_out.contiguous(), ctx.num_pts, ctx.mode
+            )
 
-        return None, None, grad_in, None, None, None
+        return None, None, grad_in, None, None, None, None
 
 
 roiaware_pool3d = RoIAwarePool3dFunction.apply
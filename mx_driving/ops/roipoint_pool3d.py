@@ -48,3 +48,33 @@ class RoipointPool3dFunction(Function):
 
 
 roipoint_pool3d = RoipointPool3dFunction.apply
+
+
+def roipoint_pool3d_csr(
+    num_sampled_points, points, point_features, boxes3d, pts_ptr=None, box_idx=None, sample_mode="first", seed=0
+):
+    """
+    roipoint_pool3d on a precomputed points-in-boxes CSR instead of re-testing every point against every box.
+    Args:
+        pts_ptr, box_idx: point -> box CSR in the `points_in_boxes_csr` layout. Computed here from boxes3d when omitted.
+        sample_mode: "first" keeps the first num_sampled_points points and repeats them cyclically like
+            `roipoint_pool3d`; "random" draws them without replacement in a seeded order and fills short boxes by
+            seeded draws with replacement. The result only depends on seed, not on the device.
+    Returns:
+        pooled_features: [B, M, num_sampled_points, 3 + C] in the dtype of point_features.
+        pooled_empty_flag: [B, M] int32, 1 for boxes without points.
+    """
+    if num_sampled_points <= 0:
+        raise Exception("Input num_sampled_points be more than 0")
+    if sample_mode not in ("first", "random"):
+        raise ValueError("sample_mode must be 'first' or 'random'")
+    if (pts_ptr is None) != (box_idx is None):
+        raise ValueError("pts_ptr and box_idx must be given together")
+    if pts_ptr is None:
+        # boxes3d use the bottom center, points_in_boxes_csr expects the box center
+        boxes = boxes3d.float().clone()
+        boxes[..., 2] += boxes[..., 5] / 2
+        pts_ptr, box_idx = mx_driving._C.points_in_boxes_grid(boxes, points.float(), True, 0.0)
+    return mx_driving._C.roipoint_pool3d_csr(
+        num_sampled_points, points, point_features, boxes3d, pts_ptr, box_idx, int(sample_mode == "random"), seed
+    )
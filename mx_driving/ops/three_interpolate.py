@@ -48,4 +48,21 @@ class ThreeInterpolateFunction(Function):
         return grad_features, None, None
 
 
+class ThreeInterpolateWithDistFunction(Function):
+
+    @staticmethod
+    def forward(ctx: Any, features: torch.Tensor, indices: torch.Tensor, dist: torch.Tensor) -> torch.Tensor:
+        # the inverse-distance weights are computed per tile inside the op and never materialized
+        m = features.size(2)
+        ctx.three_interpolate_for_backward = (indices, dist, m)
+        return mx_driving._C.npu_three_interpolate_with_dist(features, indices, dist)
+
+    @staticmethod
+    def backward(ctx, grad_out: torch.Tensor) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+        idx, dist, m = ctx.three_interpolate_for_backward
+        grad_features = mx_driving._C.npu_three_interpolate_with_dist_backward(grad_out.contiguous(), idx, dist, m)
+        return grad_features, None, None
+
+
 three_interpolate = ThreeInterpolateFunction.apply
+three_interpolate_with_dist = ThreeInterpolateWithDistFunction.apply
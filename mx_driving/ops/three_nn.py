@@ -18,21 +18,19 @@ import mx_driving._C
 
 class ThreeNN(Function):
     @staticmethod
-    def forward(ctx: Any, target: torch.Tensor, source: torch.Tensor) -> Tuple[torch.Tensor, torch.Tensor]:
+    def forward(
+        ctx: Any, target: torch.Tensor, source: torch.Tensor, use_grid: bool = False
+    ) -> Tuple[torch.Tensor, torch.Tensor]:
         # target is center_xyz
         target = target.contiguous()
         source = source.transpose(2, 1).contiguous()
-        # strict to fp32
-        dtype_ = source.dtype
-        if dtype_ == torch.float16:
+        if source.dtype not in (torch.float16, torch.float32):
             target = target.float()
             source = source.float()
 
-        dist2, idx = mx_driving._C.knn(source, target, 3, False)
-        dist2 = torch.sqrt(dist2)
-        if dtype_ == torch.float16:
-            dist2 = dist2.half()
-        return dist2, idx.int()
+        # fp16 inputs are computed in fp32 inside the kernel, and the sqrt is fused into the output
+        dist, idx = mx_driving._C.knn(source, target, 3, False, True, use_grid)
+        return dist, idx.int()
 
 
 three_nn = ThreeNN.apply
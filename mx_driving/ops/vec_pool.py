@@ -0,0 +1,99 @@
+# Copyright (c) OpenMMLab. All rights reserved.
+# Copyright (c) 2024 Huawei Technologies Co., Ltd
+# All rights reserved.
+#
+# Licensed under the BSD 3-Clause License  (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+from typing import Tuple
+
+import torch
+from torch.autograd import Function
+
+import mx_driving._C
+
+
+class VecPoolFunction(Function):
+    """Vector-pool aggregation of PV-RCNN++ (VectorPoolWithVoxelQuery)."""
+
+    @staticmethod
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    def forward(
+        ctx,
+        support_xyz: torch.Tensor,
+        xyz_batch_cnt: torch.Tensor,
+        support_features: torch.Tensor,
+        new_xyz: torch.Tensor,
+        new_xyz_batch_cnt: torch.Tensor,
+        num_grid_x: int,
+        num_grid_y: int,
+        num_grid_z: int,
+        max_neighbour_distance: float,
+        num_c_out: int,
+        use_xyz: bool,
+        num_mean_points_per_grid: int = 100,
+        nsample: int = -1,
+        neighbor_type: int = 0,
+        pooling_type: int = 0,
+    ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]:
+        """
+        Args:
+            support_xyz (Tensor): (N1 + N2 ..., 3) xyz coordinates of the support points.
+            xyz_batch_cnt (Tensor): (B) number of support points in each batch.
+            support_features (Tensor): (N1 + N2 ..., C_in) features of the support points.
+            new_xyz (Tensor): (M1 + M2 ..., 3) centers of the local voxel grids.
+            new_xyz_batch_cnt (Tensor): (B) number of centers in each batch.
+            num_grid_x, num_grid_y, num_grid_z (int): number of local grids along each axis.
+            max_neighbour_distance (float): half size of the local neighbourhood.
+            num_c_out (int): output channels, total_grids * channels_per_grid.
+            use_xyz (bool): whether to output the mean local xyz of each grid.
+            num_mean_points_per_grid (int): kept for interface compatibility, the output buffer is sized exactly.
+            nsample (int): maximum number of neighbours of each center, <= 0 for no limit.
+            neighbor_type (int): 1 for ball neighbourhood, otherwise cube.
+            pooling_type (int): 0 for average pooling, 1 for the first point of each grid.
+
+        Returns:
+            Tensor: (M, num_c_out) pooled features.
+            Tensor: (M, total_grids * 3) mean local xyz of each grid.
+            Tensor: (1) int32 mean number of points per center.
+            Tensor: (M, total_grids) int32 number of points in each grid.
+        """
+        new_features, new_local_xyz, point_cnt_of_grid, grouped_idxs = mx_driving._C.vec_pool(
+            support_xyz.contiguous(),
+            xyz_batch_cnt,
+            support_features.contiguous(),
+            new_xyz.contiguous(),
+            new_xyz_batch_cnt,
+            num_grid_x,
+            num_grid_y,
+            num_grid_z,
+            max_neighbour_distance,
+            num_c_out,
+            use_xyz,
+            nsample,
+            neighbor_type,
+            pooling_type,
+        )
+        n, num_c_in = support_features.shape
+        ctx.vec_pool_for_backward = (point_cnt_of_grid, grouped_idxs, n, num_c_in)
+        num_mean_points = torch.tensor([grouped_idxs.size(0) // max(new_xyz.size(0), 1)], dtype=torch.int32)
+        ctx.mark_non_differentiable(new_local_xyz, num_mean_points, point_cnt_of_grid)
+        return new_features, new_local_xyz, num_mean_points, point_cnt_of_grid
+
+    @staticmethod
+    # pylint: disable=huawei-too-many-arguments
+    def backward(ctx, grad_new_features: torch.Tensor, grad_local_xyz=None, grad_num_mean=None, grad_cnt=None):
+        point_cnt_of_grid, grouped_idxs, n, num_c_in = ctx.vec_pool_for_backward
+        grad_support_features = mx_driving._C.vec_pool_backward(
+            grad_new_features.contiguous(), point_cnt_of_grid, grouped_idxs, n, num_c_in
+        )
+        return (None, None, grad_support_features) + (None,) * 12
+
+
+vec_pool = VecPoolFunction.apply
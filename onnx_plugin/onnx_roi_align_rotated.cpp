@@ -65,8 +65,8 @@ Status ParseParamsRoiAlignRotatedV2(const Message* op_src, ge::Operator &op_dest
 
     op_dest.SetAttr("spatial_scale", spatial_scale);
     op_dest.SetAttr("sampling_ratio", sampling_ratio);
-    op_dest.SetAttr("pooled_h", pooled_height);
-    op_dest.SetAttr("pooled_w", pooled_width);
+    op_dest.SetAttr("pooled_height", pooled_height);
+    op_dest.SetAttr("pooled_width", pooled_width);
     op_dest.SetAttr("aligned", aligned);
     op_dest.SetAttr("clockwise", clockwise);
 
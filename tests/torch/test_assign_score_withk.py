@@ -18,6 +18,20 @@ def gen_data(B, N, npoint, M, K, out_dim):
     return data
 
 
+def torch_golden_op(scores, points, centers, knn_idx, aggregate):
+    B, npoint, K = knn_idx.shape
+    batch_idx = torch.arange(B).view(B, 1, 1)
+    # [B, npoint, K, M, O]
+    value = scores.unsqueeze(-1) * (points[batch_idx, knn_idx] - centers[batch_idx, knn_idx[:, :, :1]])
+    if aggregate == "max":
+        output = value.max(dim=3)[0]
+    elif aggregate == "avg":
+        output = value.mean(dim=3)
+    else:
+        output = value.sum(dim=3)
+    return output.permute(0, 3, 1, 2)
+
+
 class TestAssignScoreWithk(TestCase):
     # 'pylint: disable=too-many-arguments,huawei-too-many-arguments
     def cpu_forward_op(self,
@@ -166,6 +180,22 @@ class TestAssignScoreWithk(TestCase):
         except Exception as e:
             assert "Error! Input shape can not contain zero!" in str(e)
 
+    def test_assign_score_withk_should_return_right_value_on_cpu(self):
+        B = 3
+        N = 40
+        npoint = 17
+        M = 12
+        K = 6
+        out_dim = 24
+        points, centers, scores, knn_idx, _ = gen_data(B, N, npoint, M, K, out_dim)
+        output = mx_driving.assign_score_withk(torch.from_numpy(scores),
+                                                torch.from_numpy(points),
+                                                torch.from_numpy(centers),
+                                                torch.from_numpy(knn_idx),
+                                                "sum")
+        expected_output = self.cpu_forward_op(scores, points, centers, knn_idx, "sum")
+        self.assertRtolEqual(expected_output, output.numpy())
+
 
 class TestAssignScoreWithkGrad(TestCase):
     # 'pylint: disable=too-many-arguments,huawei-too-many-arguments
@@ -291,7 +321,25 @@ class TestAssignScoreWithkGrad(TestCase):
         self.assertRtolEqual(expected_output[1], points_npu.grad.detach().cpu().numpy())
         self.assertRtolEqual(expected_output[2], centers_npu.grad.detach().cpu().numpy())
     
-    def test_assign_score_withk_should_raise_error_when_M_plus_out_dim_is_equals_5025(self):
+    def test_assign_score_withk_grad_should_return_right_value_on_cpu(self):
+        B = 3
+        N = 40
+        npoint = 17
+        M = 12
+        K = 6
+        out_dim = 24
+        points, centers, scores, knn_idx, grad_out = gen_data(B, N, npoint, M, K, out_dim)
+        points_cpu = torch.from_numpy(points).requires_grad_()
+        centers_cpu = torch.from_numpy(centers).requires_grad_()
+        scores_cpu = torch.from_numpy(scores).requires_grad_()
+        output = mx_driving.assign_score_withk(scores_cpu, points_cpu, centers_cpu, torch.from_numpy(knn_idx), "sum")
+        output.backward(torch.from_numpy(grad_out))
+        expected_grad = self.cpu_backward_op(grad_out, scores, points, centers, knn_idx, "sum")
+        self.assertRtolEqual(expected_grad[0], scores_cpu.grad.numpy())
+        self.assertRtolEqual(expected_grad[1], points_cpu.grad.numpy())
+        self.assertRtolEqual(expected_grad[2], centers_cpu.grad.numpy())
+
+    def test_assign_score_withk_grad_should_return_right_value_when_M_plus_out_dim_is_larger_than_5000(self):
         B = 21
         N = 43
         npoint = 31
@@ -308,12 +356,31 @@ class TestAssignScoreWithkGrad(TestCase):
         centers_npu.requires_grad = True
         scores_npu.requires_grad = True
         output = mx_driving.assign_score_withk(scores_npu, points_npu, centers_npu, knn_idx_npu, "sum")
-        try:
-            output.backward(grad_out_npu)
-            raise Exception("The value of M * out_dim is larger than 5000")
-        except Exception as e:
-            assert "The size of M or K is too large" in str(e)
+        output.backward(grad_out_npu)
+        expected_output = self.cpu_backward_op(grad_out, scores, points, centers, knn_idx, "sum")
+        self.assertRtolEqual(expected_output[0], scores_npu.grad.detach().cpu().numpy())
+        self.assertRtolEqual(expected_output[1], points_npu.grad.detach().cpu().numpy())
+        self.assertRtolEqual(expected_output[2], centers_npu.grad.detach().cpu().numpy())
 
+    def test_assign_score_withk_should_return_right_value_when_aggregate_is_avg_or_max(self):
+        B = 4
+        N = 50
+        npoint = 20
+        M = 16
+        K = 8
+        out_dim = 33
+        points, centers, scores, knn_idx, grad_out = gen_data(B, N, npoint, M, K, out_dim)
+        for aggregate in ["avg", "max"]:
+            inputs = [torch.from_numpy(x).requires_grad_() for x in (scores, points, centers)]
+            expected = torch_golden_op(*inputs, torch.from_numpy(knn_idx), aggregate)
+            expected.backward(torch.from_numpy(grad_out))
+            for device in ["cpu", "npu"]:
+                tensors = [torch.from_numpy(x).to(device).requires_grad_() for x in (scores, points, centers)]
+                output = mx_driving.assign_score_withk(*tensors, torch.from_numpy(knn_idx).to(device), aggregate)
+                output.backward(torch.from_numpy(grad_out).to(device))
+                self.assertRtolEqual(expected.detach().numpy(), output.detach().cpu().numpy())
+                for tensor, golden in zip(tensors, inputs):
+                    self.assertRtolEqual(golden.grad.numpy(), tensor.grad.cpu().numpy())
 
 if __name__ == "__main__":
     run_tests()
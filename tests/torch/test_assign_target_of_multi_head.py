@@ -0,0 +1,129 @@
+import numpy as np
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+from mx_driving import assign_target_of_multi_head
+
+
+def gaussian_radius(height, width, min_overlap=0.5):
+    b1 = height + width
+    c1 = width * height * (1 - min_overlap) / (1 + min_overlap)
+    r1 = (b1 + (b1 ** 2 - 4 * c1).sqrt()) / 2
+    b2 = 2 * (height + width)
+    c2 = (1 - min_overlap) * width * height
+    r2 = (b2 + (b2 ** 2 - 16 * c2).sqrt()) / 2
+    b3 = -2 * min_overlap * (height + width)
+    c3 = (min_overlap - 1) * width * height
+    r3 = (b3 + (b3 ** 2 - 16 * min_overlap * c3).sqrt()) / 2
+    return torch.min(torch.min(r1, r2), r3)
+
+
+def draw_gaussian_to_heatmap(heatmap, x, y, radius):
+    diameter = 2 * radius + 1
+    sigma = diameter / 6
+    m = (diameter - 1) / 2
+    gy, gx = np.ogrid[-m:m + 1, -m:m + 1]
+    gaussian = np.exp(-(gx * gx + gy * gy) / (2 * sigma * sigma))
+    height, width = heatmap.shape[0:2]
+    left, right = min(x, radius), min(width - x, radius + 1)
+    top, bottom = min(y, radius), min(height - y, radius + 1)
+    masked_heatmap = heatmap[y - top:y + bottom, x - left:x + right]
+    masked_gaussian = torch.from_numpy(gaussian[radius - top:radius + bottom, radius - left:radius + right]).float()
+    torch.max(masked_heatmap, masked_gaussian, out=masked_heatmap)
+
+
+# pylint: disable=too-many-arguments,huawei-too-many-arguments
+def golden_assign_target_of_multi_head(boxes, labels, head_num_classes, out_size_factor, gaussian_overlap,
+                                       min_radius, voxel_size, pc_range, feature_map_size, norm_bbox, flip_angle,
+                                       max_objs):
+    batch = boxes.shape[0]
+    width, height = feature_map_size
+    offsets = np.cumsum([0] + list(head_num_classes))
+    heatmaps = [boxes.new_zeros(batch, n, height, width) for n in head_num_classes]
+    anno_boxes = [boxes.new_zeros(batch, max_objs, boxes.shape[-1] + 1) for _ in head_num_classes]
+    inds = [boxes.new_zeros(batch, max_objs).long() for _ in head_num_classes]
+    masks = [boxes.new_zeros(batch, max_objs, dtype=torch.uint8) for _ in head_num_classes]
+    for b in range(batch):
+        for head, num_classes in enumerate(head_num_classes):
+            # objects of one head keep their order and are packed to the front, as in CenterHead
+            sel = (labels[b] >= offsets[head]) & (labels[b] < offsets[head] + num_classes)
+            head_boxes = boxes[b][sel]
+            head_labels = labels[b][sel] - offsets[head]
+            coord_x = ((head_boxes[:, 0] - pc_range[0]) / voxel_size[0] / out_size_factor).clamp(0, width - 0.5)
+            coord_y = ((head_boxes[:, 1] - pc_range[1]) / voxel_size[1] / out_size_factor).clamp(0, height - 0.5)
+            dx = head_boxes[:, 3] / voxel_size[0] / out_size_factor
+            dy = head_boxes[:, 4] / voxel_size[1] / out_size_factor
+            # the radius is capped at 64 cells
+            radius = torch.clamp_min(gaussian_radius(dx, dy, gaussian_overlap).int(), min_radius).clamp_max(64)
+            for k in range(min(max_objs, head_boxes.shape[0])):
+                if dx[k] <= 0 or dy[k] <= 0:
+                    continue
+                x, y = int(coord_x[k]), int(coord_y[k])
+                draw_gaussian_to_heatmap(heatmaps[head][b, head_labels[k]], x, y, radius[k].item())
+                inds[head][b, k] = y * width + x
+                masks[head][b, k] = 1
+                row = anno_boxes[head][b, k]
+                row[0] = coord_x[k] - x
+                row[1] = coord_y[k] - y
+                row[2] = head_boxes[k, 2]
+                row[3:6] = head_boxes[k, 3:6].log() if norm_bbox else head_boxes[k, 3:6]
+                sin_a, cos_a = torch.sin(head_boxes[k, 6]), torch.cos(head_boxes[k, 6])
+                row[6], row[7] = (cos_a, sin_a) if flip_angle else (sin_a, cos_a)
+                row[8:] = head_boxes[k, 7:]
+    return heatmaps, anno_boxes, inds, masks
+
+
+class TestAssignTargetOfMultiHead(TestCase):
+    seed = 1024
+    torch.manual_seed(seed)
+
+    out_size_factor = 8
+    gaussian_overlap = 0.1
+    min_radius = 2
+    voxel_size = [0.1, 0.1]
+    pc_range = [-51.2, -51.2]
+    feature_map_size = [128, 128]
+    head_num_classes = [1, 2, 2, 1, 2, 2]
+
+    def gen_data(self, batch, num_objs, box_dim):
+        boxes = -50 + 100 * torch.rand((batch, num_objs, box_dim), dtype=torch.float32)
+        boxes[..., 3:6] = 0.5 + 5 * torch.rand((batch, num_objs, 3))
+        # a few degenerate boxes consume their slot without being drawn
+        boxes[:, ::7, 3] = 0
+        labels = torch.randint(0, sum(self.head_num_classes), (batch, num_objs))
+        # trailing padding
+        labels[:, num_objs - num_objs // 5:] = -1
+        return boxes, labels
+
+    def check(self, device, shapes, max_objs, box_scale=1.0):
+        for batch, num_objs, box_dim in shapes:
+            for norm_bbox, flip_angle in [(True, False), (False, True)]:
+                boxes, labels = self.gen_data(batch, num_objs, box_dim)
+                boxes[..., 3:5] *= box_scale
+                args = (self.head_num_classes, self.out_size_factor, self.gaussian_overlap, self.min_radius,
+                        self.voxel_size, self.pc_range, self.feature_map_size, norm_bbox, flip_angle, max_objs)
+                expected = golden_assign_target_of_multi_head(boxes, labels, *args)
+                output = assign_target_of_multi_head(boxes.to(device), labels.to(device), *args)
+                for expected_list, output_list in zip(expected, output):
+                    self.assertEqual(len(expected_list), len(output_list))
+                    for exp, out in zip(expected_list, output_list):
+                        self.assertRtolEqual(exp.numpy(), out.cpu().numpy())
+
+    def test_assign_target_of_multi_head_cpu(self):
+        self.check("cpu", [[1, 31, 9], [2, 100, 9], [3, 251, 7]], 500)
+        # more objects of one head than slots
+        self.check("cpu", [[2, 200, 9]], 16)
+
+    def test_assign_target_of_multi_head(self):
+        self.check("npu", [[1, 31, 9], [2, 100, 9], [4, 500, 9], [3, 251, 7]], 500)
+        self.check("npu", [[2, 200, 9]], 16)
+
+    def test_assign_target_of_multi_head_large_radius(self):
+        # boxes of up to ~150 m reach radii above the 64-cell cap
+        for device in ["cpu", "npu"]:
+            self.check(device, [[2, 20, 9]], 500, 30.0)
+
+
+if __name__ == "__main__":
+    run_tests()
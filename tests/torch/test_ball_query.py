@@ -0,0 +1,85 @@
+import numpy as np
+import torch
+import torch_npu
+from data_cache import golden_data_cache
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+
+
+@golden_data_cache(__file__)
+def cpu_gen_inputs(B, N, M, C):
+    xyz = (np.random.rand(B, N, 3) * 4).astype(np.float32)
+    center_xyz = xyz[:, np.random.choice(N, M, replace=False)] + np.random.rand(B, M, 3).astype(np.float32) * 0.1
+    features = np.random.rand(B, C, N).astype(np.float32)
+    return xyz, center_xyz.astype(np.float32), features
+
+
+class TestBallQuery(TestCase):
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    @golden_data_cache(__file__)
+    def golden_ball_query(self, min_radius, max_radius, sample_num, xyz, center_xyz):
+        B, M, _ = center_xyz.shape
+        idx = np.zeros((B, M, sample_num), dtype=np.int32)
+        for b in range(B):
+            for m in range(M):
+                d2 = ((xyz[b] - center_xyz[b, m]) ** 2).sum(axis=1)
+                hit = np.nonzero((d2 == 0) | ((d2 >= min_radius ** 2) & (d2 < max_radius ** 2)))[0][:sample_num]
+                if hit.size > 0:
+                    idx[b, m] = hit[0]
+                    idx[b, m, :hit.size] = hit
+        return idx
+
+    def test_ball_query(self):
+        np.random.seed(0)
+        for B, N, M, sample_num, min_radius, max_radius in [
+            (2, 1024, 256, 16, 0.0, 0.4),
+            (1, 8192, 512, 32, 0.2, 0.8),
+            (4, 100, 30, 64, 0.0, 0.05),
+        ]:
+            xyz, center_xyz, _ = cpu_gen_inputs(B, N, M, 4)
+            expected_idx = self.golden_ball_query(min_radius, max_radius, sample_num, xyz, center_xyz)
+            idx = mx_driving.ball_query(
+                min_radius, max_radius, sample_num, torch.from_numpy(xyz).npu(), torch.from_numpy(center_xyz).npu())
+            self.assertRtolEqual(expected_idx, idx.cpu().numpy())
+            idx = mx_driving.ball_query(
+                min_radius, max_radius, sample_num, torch.from_numpy(xyz), torch.from_numpy(center_xyz))
+            self.assertRtolEqual(expected_idx, idx.numpy())
+
+    def test_ball_query_group(self):
+        np.random.seed(1)
+        B, N, M, C, sample_num = 2, 2048, 128, 35, 32
+        xyz, center_xyz, features = cpu_gen_inputs(B, N, M, C)
+        expected_idx = self.golden_ball_query(0.0, 0.3, sample_num, xyz, center_xyz)
+        grad_out = torch.rand(B, C, M, sample_num)
+        expected = torch.from_numpy(features).requires_grad_()
+        expected_grouped = mx_driving.group_points(expected.npu(), torch.from_numpy(expected_idx).npu())
+        expected_grouped.backward(grad_out.npu())
+
+        for device in ["npu", "cpu"]:
+            feats = torch.from_numpy(features).to(device).requires_grad_()
+            grouped, idx = mx_driving.ball_query_group(
+                0.0, 0.3, sample_num, torch.from_numpy(xyz).to(device), torch.from_numpy(center_xyz).to(device), feats)
+            grouped.backward(grad_out.to(device))
+            self.assertRtolEqual(expected_idx, idx.cpu().numpy())
+            self.assertRtolEqual(expected_grouped.detach().cpu().numpy(), grouped.detach().cpu().numpy())
+            self.assertRtolEqual(expected.grad.numpy(), feats.grad.cpu().numpy())
+
+    def test_ball_query_group_half(self):
+        np.random.seed(2)
+        B, N, M, C, sample_num = 1, 1024, 64, 16, 16
+        xyz, center_xyz, features = cpu_gen_inputs(B, N, M, C)
+        xyz_half = torch.from_numpy(xyz).half()
+        center_half = torch.from_numpy(center_xyz).half()
+        expected_idx = self.golden_ball_query(
+            0.0, 0.3, sample_num, xyz_half.float().numpy(), center_half.float().numpy())
+        feats = torch.from_numpy(features).half()
+        grouped, idx = mx_driving.ball_query_group(0.0, 0.3, sample_num, xyz_half.npu(), center_half.npu(), feats.npu())
+        self.assertRtolEqual(expected_idx, idx.cpu().numpy())
+        expected_grouped = feats.float().gather(
+            2, torch.from_numpy(expected_idx).long().view(B, 1, -1).expand(B, C, -1)).view(B, C, M, sample_num)
+        self.assertRtolEqual(expected_grouped.numpy(), grouped.cpu().float().numpy())
+
+
+if __name__ == "__main__":
+    run_tests()
@@ -80,6 +80,29 @@ class TestBEVPool(TestCase):
 
             self.assertRtolEqual(out_cpu, out_npu.cpu().numpy())
 
+    def test_bev_pool_cpu(self):
+        shapes = [
+            [1, 1, 1, 1, 1, 1],
+            [3, 3, 15, 15, 17, 33],
+            [2, 5, 32, 32, 31, 777],
+        ]
+        for shape in shapes:
+            (b, d, h, w, c, n) = shape
+            feat, geom_feat = generate_bev_pool_data(n, b, d, h, w, c)
+            grad_out = torch.rand([b, c, d, h, w])
+            feat_ref = torch.from_numpy(feat).requires_grad_()
+            feat_cpu = torch.from_numpy(feat).clone().requires_grad_()
+            geom = torch.from_numpy(geom_feat).long()
+            out_ref = torch.zeros([b, d, h, w, c]).index_put(
+                (geom[:, 3], geom[:, 2], geom[:, 0], geom[:, 1]), feat_ref, accumulate=True).permute(0, 4, 1, 2, 3)
+            out_ref.backward(grad_out)
+
+            out_cpu = bev_pool(feat_cpu, torch.from_numpy(geom_feat), b, d, h, w)
+            out_cpu.backward(grad_out)
+
+            self.assertRtolEqual(out_ref.detach().numpy(), out_cpu.detach().numpy())
+            self.assertRtolEqual(feat_ref.grad.numpy(), feat_cpu.grad.numpy())
+
 
 if __name__ == "__main__":
     run_tests()
@@ -149,6 +149,46 @@ class TestBEVPoolV2(TestCase):
             self.assertRtolEqual(bev_feat.detach().cpu().numpy(), bev_feat_cpu)
             self.assertRtolEqual(grad_feat_npu.cpu().numpy(), grad_feat)
 
+    def test_bev_pool_v2_cpu(self):
+        shapes = [
+            [1, 1, 1, 1, 1, 1],
+            [3, 3, 15, 15, 17, 33],
+            [2, 5, 32, 32, 31, 777],
+        ]
+        for shape in shapes:
+            B, D, H, W, C, N_RANKS = shape
+            feat = torch.rand([B, 1, H, W, C])
+            depth = torch.rand([B, 1, D, H, W])
+            grad_out = torch.rand([B, C, D, H, W])
+            # every depth rank is used once, as produced by voxel_pooling_prepare_v2
+            ranks_depth = torch.randperm(B * D * H * W)[:N_RANKS].int()
+            ranks_feat = torch.randint(0, B * H * W, (N_RANKS,), dtype=torch.int32)
+            ranks_bev = torch.randint(0, B * D * H * W, (N_RANKS,), dtype=torch.int32)
+            order = ranks_bev.argsort()
+            ranks_depth, ranks_feat, ranks_bev = ranks_depth[order], ranks_feat[order], ranks_bev[order]
+            kept = torch.ones(N_RANKS, dtype=torch.bool)
+            kept[1:] = ranks_bev[1:] != ranks_bev[:-1]
+            interval_starts = torch.where(kept)[0].int()
+            interval_lengths = torch.zeros_like(interval_starts)
+            interval_lengths[:-1] = interval_starts[1:] - interval_starts[:-1]
+            interval_lengths[-1] = N_RANKS - interval_starts[-1]
+
+            depth_ref, feat_ref = depth.clone().requires_grad_(), feat.clone().requires_grad_()
+            depth_cpu, feat_cpu = depth.clone().requires_grad_(), feat.clone().requires_grad_()
+            prob = depth_ref.reshape(-1, 1)[ranks_depth.long()]
+            out_ref = torch.zeros([B * D * H * W, C]).index_add(
+                0, ranks_bev.long(), prob * feat_ref.reshape(-1, C)[ranks_feat.long()])
+            out_ref = out_ref.view(B, D, H, W, C).permute(0, 4, 1, 2, 3)
+            out_ref.backward(grad_out)
+
+            out_cpu = bev_pool_v2(depth_cpu, feat_cpu, ranks_depth, ranks_feat, ranks_bev, (B, D, H, W, C),
+                                  interval_starts, interval_lengths)
+            out_cpu.backward(grad_out)
+
+            self.assertRtolEqual(out_ref.detach().numpy(), out_cpu.detach().numpy())
+            self.assertRtolEqual(feat_ref.grad.numpy(), feat_cpu.grad.numpy())
+            self.assertRtolEqual(depth_ref.grad.numpy(), depth_cpu.grad.numpy())
+
 
 if __name__ == "__main__":
     run_tests()
@@ -5,7 +5,7 @@ import torch_npu
 from data_cache import golden_data_cache
 from torch_npu.testing.testcase import TestCase, run_tests
 
-from mx_driving import bev_pool_v3
+from mx_driving import bev_pool_precompute, bev_pool_v3, clear_bev_pool_precompute_cache
 
 
 DEVICE_NAME = torch_npu.npu.get_device_name(0)[:10]
@@ -51,6 +51,23 @@ def generate_bev_pool_data(B, D, H, W, C, N_RANKS):
     return feat, depth, grad_out, ranks_depth, ranks_feat, ranks_bev, bev_feat_shape
 
 
+def golden_voxel_pooling_prepare(coor, grid_lower_bound, grid_interval, grid_size):
+    B, N, D, H, W, _ = coor.shape
+    num_points = B * N * D * H * W
+    ranks_depth = torch.arange(num_points, dtype=torch.int32)
+    ranks_feat = torch.arange(B * N * H * W, dtype=torch.int32).reshape(B, N, 1, H, W).expand(B, N, D, H, W).flatten()
+    coor = ((coor - torch.tensor(grid_lower_bound)) / torch.tensor(grid_interval)).long().view(num_points, 3)
+    batch_idx = torch.arange(B).reshape(B, 1).expand(B, num_points // B).reshape(num_points, 1)
+    coor = torch.cat((coor, batch_idx), 1)
+    kept = (coor[:, 0] >= 0) & (coor[:, 0] < grid_size[0]) & (coor[:, 1] >= 0) & (coor[:, 1] < grid_size[1]) & \
+           (coor[:, 2] >= 0) & (coor[:, 2] < grid_size[2])
+    coor, ranks_depth, ranks_feat = coor[kept], ranks_depth[kept], ranks_feat[kept]
+    ranks_bev = coor[:, 3] * (grid_size[2] * grid_size[1] * grid_size[0]) + \
+                coor[:, 2] * (grid_size[1] * grid_size[0]) + coor[:, 1] * grid_size[0] + coor[:, 0]
+    order = ranks_bev.argsort()
+    return ranks_bev[order].int(), ranks_depth[order], ranks_feat[order]
+
+
 class TestBEVPoolV2(TestCase):
     seed = 1024
     torch.manual_seed(seed)
@@ -92,6 +109,147 @@ class TestBEVPoolV2(TestCase):
             self.assertRtolEqual(feat_npu.grad.cpu().numpy(), bev_feat_grad_cpu.cpu().numpy())
             self.assertRtolEqual(depth_npu.grad.cpu().numpy(), bev_depth_grad_cpu.cpu().numpy())
 
+    def test_bev_pool_v3_unaligned_channel_half(self):
+        shapes = [
+            [1, 1, 1, 1, 3, 1],
+            [2, 3, 15, 15, 80, 33],
+            [1, 5, 17, 23, 100, 777],
+        ]
+        for dtype in [torch.float32, torch.float16, torch.bfloat16]:
+            for shape in shapes:
+                B, D, H, W, C, N_RANKS = shape
+                feat, depth, grad_out, ranks_depth, ranks_feat, ranks_bev, bev_feat_shape = generate_bev_pool_data(
+                    B, D, H, W, C, N_RANKS
+                )
+                feat, depth = feat.to(dtype), depth.to(dtype)
+                feat_npu = feat.clone().npu()
+                depth_npu = depth.clone().npu()
+                feat.requires_grad_()
+                depth.requires_grad_()
+                feat_npu.requires_grad_()
+                depth_npu.requires_grad_()
+
+                prob = depth.float().reshape(-1, 1)[ranks_depth.long()]
+                bev_feat_cpu = torch.zeros([B * D * H * W, C]).index_add(
+                    0, ranks_bev.long(), prob * feat.float().reshape(-1, C)[ranks_feat.long()])
+                bev_feat_cpu = bev_feat_cpu.view(bev_feat_shape).permute(0, 4, 1, 2, 3)
+                bev_feat_cpu.backward(grad_out)
+
+                bev_feat_npu = bev_pool_v3(depth_npu, feat_npu, ranks_depth.npu(), ranks_feat.npu(), ranks_bev.npu(),
+                                           bev_feat_shape)
+                bev_feat_npu.backward(grad_out.to(dtype).npu())
+
+                self.assertEqual(bev_feat_npu.dtype, dtype)
+                prec = 1.e-4 if dtype == torch.float32 else 1.e-2
+                self.assertRtolEqual(bev_feat_npu.detach().float().cpu().numpy(),
+                                     bev_feat_cpu.detach().numpy(), prec)
+                self.assertRtolEqual(feat_npu.grad.float().cpu().numpy(), feat.grad.float().numpy(), prec)
+                self.assertRtolEqual(depth_npu.grad.float().cpu().numpy(), depth.grad.float().numpy(), prec)
+
+    def test_bev_pool_v3_no_depth_unaligned_channel_half(self):
+        shapes = [
+            [1, 1, 4, 4, 3, 7],
+            [2, 2, 8, 9, 13, 300],
+            [2, 1, 16, 16, 77, 1000],
+        ]
+        for B, D, H, W, C, N_POINTS in shapes:
+            feat = torch.rand([N_POINTS, C]).half()
+            ranks_bev = torch.stack([
+                torch.randint(0, H, [N_POINTS]),
+                torch.randint(0, W, [N_POINTS]),
+                torch.randint(0, D, [N_POINTS]),
+                torch.randint(0, B, [N_POINTS]),
+            ], dim=1).int()
+            bev_feat_shape = [B, D, H, W, C]
+            grad_out = torch.rand([B, C, D, H, W])
+
+            feat_ref = feat.float().requires_grad_()
+            flat = ranks_bev[:, 3] * D * H * W + ranks_bev[:, 2] * H * W + ranks_bev[:, 0] * W + ranks_bev[:, 1]
+            bev_feat_ref = torch.zeros([B * D * H * W, C]).index_add(0, flat.long(), feat_ref)
+            bev_feat_ref = bev_feat_ref.view(bev_feat_shape).permute(0, 4, 1, 2, 3)
+            bev_feat_ref.backward(grad_out)
+
+            feat_npu = feat.clone().npu().requires_grad_()
+            bev_feat_npu = bev_pool_v3(None, feat_npu, None, None, ranks_bev.npu(), bev_feat_shape)
+            bev_feat_npu.backward(grad_out.half().npu())
+
+            self.assertEqual(bev_feat_npu.dtype, torch.float16)
+            self.assertRtolEqual(bev_feat_npu.detach().float().cpu().numpy(), bev_feat_ref.detach().numpy(), 1.e-2)
+            self.assertRtolEqual(feat_npu.grad.float().cpu().numpy(), feat_ref.grad.numpy(), 1.e-2)
+
+    def test_bev_pool_v3_precompute_depth_softmax(self):
+        B, N, D, H, W, C = 2, 3, 6, 4, 5, 16
+        grid_lower_bound, grid_interval, grid_size = [-4.0, -4.0, -1.0], [1.0, 1.0, 2.0], [8, 8, 1]
+        coor = torch.rand([B, N, D, H, W, 3]) * 10 - 5
+        calib = [torch.rand([B, N, 4, 4]).npu(), torch.rand([B, N, 3, 3]).npu()]
+
+        clear_bev_pool_precompute_cache()
+        tables = bev_pool_precompute(coor.npu(), calib, grid_lower_bound, grid_interval, grid_size)
+        cached = bev_pool_precompute(lambda: None, calib, grid_lower_bound, grid_interval, grid_size)
+        for table, cached_table in zip(tables, cached):
+            self.assertEqual(table.data_ptr(), cached_table.data_ptr())
+
+        ranks_bev, ranks_depth, ranks_feat = golden_voxel_pooling_prepare(
+            coor, grid_lower_bound, grid_interval, grid_size)
+        self.assertRtolEqual(tables[0].cpu().numpy(), ranks_bev.numpy())
+        # argsort对相同ranks_bev的顺序不确定，按ranks_depth重排后比较
+        order_npu, order_cpu = tables[1].cpu().argsort(), ranks_depth.argsort()
+        for table, golden in zip(tables[:3], (ranks_bev, ranks_depth, ranks_feat)):
+            self.assertRtolEqual(table.cpu()[order_npu].numpy(), golden[order_cpu].numpy())
+
+        bev_feat_shape = [B, grid_size[2], grid_size[1], grid_size[0], C]
+        depth = torch.randn([B, N, D, H, W]) * 3
+        feat = torch.rand([B, N, H, W, C])
+        grad_out = torch.rand([B, C] + bev_feat_shape[1:4])
+        depth_npu, feat_npu = depth.clone().npu(), feat.clone().npu()
+        depth.requires_grad_()
+        feat.requires_grad_()
+        depth_npu.requires_grad_()
+        feat_npu.requires_grad_()
+
+        prob = depth.softmax(2).reshape(-1, 1)[ranks_depth.long()]
+        bev_feat_cpu = torch.zeros([B * grid_size[2] * grid_size[1] * grid_size[0], C]).index_add(
+            0, ranks_bev.long(), prob * feat.reshape(-1, C)[ranks_feat.long()])
+        bev_feat_cpu = bev_feat_cpu.view(bev_feat_shape).permute(0, 4, 1, 2, 3)
+        bev_feat_cpu.backward(grad_out)
+        bev_feat_npu = bev_pool_v3(depth_npu, feat_npu, tables[1], tables[2], tables[0], bev_feat_shape,
+                                   depth_softmax=True)
+        bev_feat_npu.backward(grad_out.npu())
+
+        self.assertRtolEqual(bev_feat_npu.detach().cpu().numpy(), bev_feat_cpu.detach().numpy())
+        self.assertRtolEqual(feat_npu.grad.cpu().numpy(), feat.grad.numpy())
+        self.assertRtolEqual(depth_npu.grad.cpu().numpy(), depth.grad.numpy())
+
+    def test_bev_pool_v3_cpu(self):
+        B, N, D, H, W, C = 2, 3, 6, 4, 5, 37
+        grid_size = [8, 8, 1]
+        bev_feat_shape = [B, grid_size[2], grid_size[1], grid_size[0], C]
+        num_points = 500
+        ranks_depth = torch.randint(0, B * N * D * H * W, (num_points,), dtype=torch.int32)
+        ranks_feat = torch.randint(0, B * N * H * W, (num_points,), dtype=torch.int32)
+        ranks_bev = torch.randint(0, B * grid_size[2] * grid_size[1] * grid_size[0], (num_points,), dtype=torch.int32)
+        depth = torch.randn([B, N, D, H, W])
+        feat = torch.rand([B, N, H, W, C])
+        grad_out = torch.rand([B, C] + bev_feat_shape[1:4])
+
+        for depth_softmax in (False, True):
+            depth_ref, feat_ref = depth.clone().requires_grad_(), feat.clone().requires_grad_()
+            depth_cpu, feat_cpu = depth.clone().requires_grad_(), feat.clone().requires_grad_()
+            prob = depth_ref.softmax(2) if depth_softmax else depth_ref
+            prob = prob.reshape(-1, 1)[ranks_depth.long()]
+            bev_feat_ref = torch.zeros([B * grid_size[2] * grid_size[1] * grid_size[0], C]).index_add(
+                0, ranks_bev.long(), prob * feat_ref.reshape(-1, C)[ranks_feat.long()])
+            bev_feat_ref = bev_feat_ref.view(bev_feat_shape).permute(0, 4, 1, 2, 3)
+            bev_feat_ref.backward(grad_out)
+
+            bev_feat_cpu = bev_pool_v3(depth_cpu, feat_cpu, ranks_depth, ranks_feat, ranks_bev, bev_feat_shape,
+                                       depth_softmax=depth_softmax)
+            bev_feat_cpu.backward(grad_out)
+
+            self.assertRtolEqual(bev_feat_cpu.detach().numpy(), bev_feat_ref.detach().numpy())
+            self.assertRtolEqual(feat_cpu.grad.numpy(), feat_ref.grad.numpy())
+            self.assertRtolEqual(depth_cpu.grad.numpy(), depth_ref.grad.numpy())
+
 
 if __name__ == "__main__":
     run_tests()
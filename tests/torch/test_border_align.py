@@ -284,6 +284,56 @@ class TestBorderAlign(TestCase):
             self.assertRtolEqual(out_cpu, out_npu.cpu())
             self.assertRtolEqual(grad_cpu, grad_npu.cpu())
 
+    def test_border_align_cpu(self):
+        shape_format = [
+            [2, 16, 8, 8, 5],
+            [1, 36, 5, 13, 3],
+            [2, 12, 7, 9, 2],
+        ]
+        for item in shape_format:
+            batch_size, input_channels, input_height, input_width, pooled_size = item
+            features = generate_features([batch_size, input_channels, input_height, input_width])
+            rois = generate_rois(features)
+            grad_output = generate_grad_outputs([batch_size, input_channels // 4, input_height * input_width, 4])
+            out_cpu, grad_cpu = self.cpu_to_exec(features, rois, grad_output, pooled_size)
+
+            for dtype, prec in [(torch.float32, 1e-4), (torch.float16, 1e-2)]:
+                feats = features.clone().to(dtype).requires_grad_()
+                output = border_align(feats, rois, pooled_size)
+                output.backward(grad_output.to(dtype))
+                self.assertEqual(output.dtype, dtype)
+                self.assertRtolEqual(out_cpu.numpy(), output.detach().float().numpy(), prec)
+                if dtype == torch.float32:
+                    self.assertRtolEqual(grad_cpu.numpy(), feats.grad.numpy())
+
+    @unittest.skipIf(DEVICE_NAME not in ['Ascend910B'], "OP `BorderAlign` is not supported, skip this ut!")
+    def test_border_align_half(self):
+        features = generate_features([2, 20, 9, 11])
+        rois = generate_rois(features)
+        grad_output = generate_grad_outputs([2, 5, 9 * 11, 4])
+        out_cpu, _ = self.cpu_to_exec(features, rois, grad_output, 4)
+
+        feats = features.half().npu().requires_grad_()
+        output = border_align(feats, rois.npu(), 4)
+        output.backward(grad_output.half().npu())
+        self.assertEqual(output.dtype, torch.float16)
+        self.assertEqual(feats.grad.dtype, torch.float16)
+        self.assertRtolEqual(out_cpu.numpy(), output.detach().float().cpu().numpy(), 1e-2)
+
+    @unittest.skipIf(DEVICE_NAME not in ['Ascend910B'], "OP `BorderAlignMax` is not supported, skip this ut!")
+    def test_border_align_max_matches_full_output(self):
+        # the fused max/argmax must agree with the max over all border points written by BorderAlign
+        for batch_size, input_channels, input_height, input_width, pooled_size in [[2, 36, 7, 9, 5], [1, 520, 3, 4, 3]]:
+            features = generate_features([batch_size, input_channels, input_height, input_width])
+            rois = generate_rois(features)
+            _, expected_index = border_align_cpu_golden(features, rois, pooled_size)
+            full = torch.zeros(batch_size, input_height * input_width, pooled_size + 1, input_channels).npu()
+            mx_driving._C.border_align(features.npu(), rois.npu(), full, pooled_size)
+            expected = full.max(dim=-2)[0].reshape(batch_size, -1, 4, input_channels // 4).permute(0, 3, 1, 2)
+
+            output, index = mx_driving._C.border_align_max(features.npu(), rois.npu(), pooled_size)
+            self.assertRtolEqual(expected.cpu(), output.cpu())
+            self.assertEqual(expected_index, index.cpu())
 
 if __name__ == '__main__':
     run_tests()
\ No newline at end of file
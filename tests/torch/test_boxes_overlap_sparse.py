@@ -0,0 +1,95 @@
+import math
+
+import numpy as np
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+
+
+def gen_scene_boxes(num, scene_size, dim):
+    # boxes scattered over a BEV scene, so most pairs are far apart
+    center = torch.rand(num, 2) * scene_size
+    size = torch.rand(num, 2) * 4 + 1
+    angle = (torch.rand(num, 1) * 2 - 1) * math.pi
+    if dim == 5:
+        return torch.cat([center, size, angle], dim=1)
+    z = torch.rand(num, 1)
+    height = torch.rand(num, 1) + 1
+    return torch.cat([center, z, size, height, angle], dim=1)
+
+
+def rotated_to_quadri(boxes):
+    x, y, w, h, a = boxes.unbind(-1)
+    cos, sin = torch.cos(a), torch.sin(a)
+    local = torch.tensor([[-0.5, 0.5], [-0.5, -0.5], [0.5, -0.5], [0.5, 0.5]])
+    dx = local[:, 0] * w[:, None]
+    dy = local[:, 1] * h[:, None]
+    px = x[:, None] + dx * cos[:, None] - dy * sin[:, None]
+    py = y[:, None] + dx * sin[:, None] + dy * cos[:, None]
+    return torch.stack([px, py], dim=-1).reshape(-1, 8)
+
+
+def dense_to_coo(dense):
+    indices = (dense > 0).nonzero().t()
+    return indices, dense[indices[0], indices[1]]
+
+
+class TestBoxesOverlapSparse(TestCase):
+    def check_sparse(self, sparse_result, dense):
+        indices, values = sparse_result
+        expected_indices, expected_values = dense_to_coo(dense.cpu())
+        self.assertEqual(indices.cpu(), expected_indices)
+        self.assertRtolEqual(values.cpu(), expected_values, 1e-4)
+
+    def test_boxes_iou_bev_sparse(self):
+        boxes_a = gen_scene_boxes(2000, 100, 7)
+        boxes_b = gen_scene_boxes(200, 100, 7)
+        dense = mx_driving.boxes_iou_bev(boxes_a.npu(), boxes_b.npu())
+        self.check_sparse(mx_driving.boxes_iou_bev_sparse(boxes_a.npu(), boxes_b.npu()), dense)
+        self.check_sparse(mx_driving.boxes_iou_bev_sparse(boxes_a, boxes_b), dense)
+
+    def test_boxes_overlap_bev_sparse(self):
+        boxes_a = gen_scene_boxes(1000, 50, 7)
+        boxes_b = gen_scene_boxes(300, 50, 7)
+        dense = mx_driving.boxes_overlap_bev(boxes_a.npu(), boxes_b.npu())
+        self.check_sparse(mx_driving.boxes_overlap_bev_sparse(boxes_a.npu(), boxes_b.npu()), dense)
+        self.check_sparse(mx_driving.boxes_overlap_bev_sparse(boxes_a, boxes_b), dense)
+
+    def test_box_iou_rotated_sparse(self):
+        boxes_a = gen_scene_boxes(1000, 50, 5)
+        boxes_b = gen_scene_boxes(300, 50, 5)
+        for mode in ["iou", "iof"]:
+            dense = mx_driving.box_iou_rotated(boxes_a.npu(), boxes_b.npu(), mode)
+            self.check_sparse(mx_driving.box_iou_rotated_sparse(boxes_a.npu(), boxes_b.npu(), mode), dense)
+            self.check_sparse(mx_driving.box_iou_rotated_sparse(boxes_a, boxes_b, mode), dense)
+
+    def test_box_iou_quadri_sparse(self):
+        boxes_a = rotated_to_quadri(gen_scene_boxes(1000, 50, 5))
+        boxes_b = rotated_to_quadri(gen_scene_boxes(300, 50, 5))
+        dense = mx_driving.box_iou_quadri(boxes_a.npu(), boxes_b.npu())
+        self.check_sparse(mx_driving.box_iou_quadri_sparse(boxes_a.npu(), boxes_b.npu()), dense)
+        self.check_sparse(mx_driving.box_iou_quadri_sparse(boxes_a, boxes_b), dense)
+
+    def test_invalid_mode(self):
+        boxes = gen_scene_boxes(10, 50, 5)
+        with self.assertRaises(ValueError):
+            mx_driving.box_iou_rotated_sparse(boxes, boxes, "ioU")
+        with self.assertRaises(ValueError):
+            mx_driving.box_iou_quadri_sparse(rotated_to_quadri(boxes), rotated_to_quadri(boxes), "giou")
+        with self.assertRaises(ValueError):
+            mx_driving.boxes_overlap_bev_sparse(boxes, boxes, "overlaps")
+
+    def test_no_overlap(self):
+        boxes_a = torch.tensor([[0, 0, 1, 1, 0]], dtype=torch.float32)
+        boxes_b = torch.tensor([[10, 10, 1, 1, 0]], dtype=torch.float32)
+        indices, values = mx_driving.box_iou_rotated_sparse(boxes_a.npu(), boxes_b.npu())
+        self.assertEqual(indices.shape, (2, 0))
+        self.assertEqual(values.shape, (0,))
+
+
+if __name__ == "__main__":
+    torch.manual_seed(0)
+    np.random.seed(0)
+    run_tests()
@@ -180,6 +180,93 @@ class TestDeformableAggregation(TestCase):
 
                             self.assertRtolEqual(out_cpu, out_npu_new.cpu().numpy())
 
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `DeformableAggregation` is only supported on 910B, skip this ut!")
+    def test_deformable_aggregation_tail_groups_half_softmax(self):
+        np.random.seed(50051)
+
+        for B, C, anchor, pts, numGroups in [(1, 32, 10, 13, 4), (2, 48, 13, 10, 6), (1, 64, 18, 31, 8)]:
+            feature_maps, spatial_shape, scale_start_index, sample_location, weights = cpu_gen_inputs(B, C, anchor, pts, numGroups)
+
+            torch_feature_maps = torch.from_numpy(feature_maps).npu()
+            torch_spatial_shape = torch.from_numpy(spatial_shape).npu()
+            torch_scale_start_index = torch.from_numpy(scale_start_index).npu()
+            torch_sample_location = torch.from_numpy(sample_location).npu()
+            torch_weights = torch.from_numpy(weights).npu()
+
+            softmax_weights = torch.from_numpy(weights).reshape(B, anchor, -1, numGroups).softmax(dim=2)
+            softmax_weights = softmax_weights.reshape(weights.shape).numpy()
+
+            out_cpu = self.golden_deformable_aggregation(B, anchor, pts, 1, 1, C, numGroups, feature_maps.shape[1],
+                                                         feature_maps.flatten(), spatial_shape, scale_start_index,
+                                                         sample_location, weights.flatten())
+            out_npu = mx_driving.deformable_aggregation(torch_feature_maps, torch_spatial_shape,
+                                                        torch_scale_start_index, torch_sample_location, torch_weights)
+            self.assertRtolEqual(out_cpu, out_npu.cpu().numpy())
+
+            out_cpu_softmax = self.golden_deformable_aggregation(B, anchor, pts, 1, 1, C, numGroups,
+                                                                 feature_maps.shape[1], feature_maps.flatten(),
+                                                                 spatial_shape, scale_start_index, sample_location,
+                                                                 softmax_weights.flatten())
+            out_npu_softmax = mx_driving.deformable_aggregation(torch_feature_maps, torch_spatial_shape,
+                                                                torch_scale_start_index, torch_sample_location,
+                                                                torch_weights, True)
+            self.assertRtolEqual(out_cpu_softmax, out_npu_softmax.cpu().numpy())
+
+            out_npu_half = mx_driving.deformable_aggregation(torch_feature_maps.half(), torch_spatial_shape,
+                                                             torch_scale_start_index, torch_sample_location,
+                                                             torch_weights)
+            self.assertEqual(out_npu_half.dtype, torch.float16)
+            self.assertRtolEqual(out_cpu.astype(np.float16), out_npu_half.cpu().numpy())
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `DeformableAggregation` is only supported on 910B, skip this ut!")
+    def test_deformable_aggregation_temporal(self):
+        np.random.seed(50051)
+
+        B, C, anchor, pts, numGroups = 2, 64, 13, 10, 8
+        feature_maps, spatial_shape, scale_start_index, sample_location, weights = cpu_gen_inputs(B, C, anchor, pts, numGroups)
+        frames = [feature_maps * (i + 1) for i in range(3)]
+        # -1 and 2 are out of range and must produce zeros instead of reading outside the cache
+        slot_index = np.random.randint(-1, 3, size=(B, anchor)).astype(np.int32)
+
+        for device in ["cpu", "npu"]:
+            cache = mx_driving.DeformableAggregationFeatureCache(2, B, 2816, C, device=device)
+            torch_scale_start_index = torch.from_numpy(scale_start_index).to(device)
+            for frame in frames:
+                cache.update(torch.from_numpy(frame).to(device), torch_scale_start_index)
+
+            out = mx_driving.deformable_aggregation_temporal(cache.buffer,
+                                                             torch.from_numpy(spatial_shape).to(device),
+                                                             torch_scale_start_index,
+                                                             torch.from_numpy(sample_location).to(device),
+                                                             torch.from_numpy(weights).to(device),
+                                                             torch.from_numpy(slot_index).to(device))
+            out = out.cpu().numpy()
+
+            for slot in range(2):
+                out_slot = self.golden_deformable_aggregation(B, anchor, pts, 1, 1, C, numGroups, 2816,
+                                                              cache.buffer[slot].cpu().numpy().flatten(),
+                                                              spatial_shape, scale_start_index, sample_location,
+                                                              weights.flatten())
+                mask = slot_index == slot
+                self.assertRtolEqual(out_slot[mask], out[mask])
+            invalid = (slot_index < 0) | (slot_index >= 2)
+            self.assertRtolEqual(np.zeros_like(out[invalid]), out[invalid])
+
+    def test_deformable_aggregation_feature_cache_levels(self):
+        B, C, num_cams = 2, 16, 2
+        shapes = [(4, 6), (2, 3)]
+        # camera-major layout: cam0 level0, cam0 level1, cam1 level0, cam1 level1
+        scale_start_index = torch.tensor([[0, 24], [30, 54]], dtype=torch.int32)
+        levels = [torch.rand(B, num_cams, C, h, w) for h, w in shapes]
+        cache = mx_driving.DeformableAggregationFeatureCache(2, B, 60, C, device="cpu",
+                                                             scale_start_index=scale_start_index)
+        self.assertEqual(cache.start_index, [[0, 24], [30, 54]])
+
+        slot = cache.update(levels)
+        expected = torch.cat([levels[level][:, cam].flatten(-2).transpose(-1, -2)
+                              for cam in range(num_cams) for level in range(len(shapes))], dim=1)
+        self.assertRtolEqual(expected.numpy(), cache.buffer[slot].numpy())
+
 
 if __name__ == "__main__":
     run_tests()
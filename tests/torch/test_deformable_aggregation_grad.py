@@ -187,7 +187,7 @@ class TestDeformableAggregation(TestCase):
         cList = [8 * 8, 8 * 8 * 2]
         ptsList = [10, 21]
         anchorList = [10, 13]
-        numGroupsList = [8]
+        numGroupsList = [4, 8]
 
         for B in bList:
             for C in cList:
@@ -301,6 +301,113 @@ class TestDeformableAggregation(TestCase):
                             )
                             self.assertRtolEqual(grad_weights, torch_grad_weights_new, prec=0.00048828125)
 
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    def golden_grads(self, feature_maps, spatial_shape, scale_start_index, sample_location, weights, use_softmax):
+        kernel_weights = weights
+        if use_softmax:
+            logits = torch.from_numpy(weights).reshape(weights.shape[0], weights.shape[1], -1, weights.shape[5])
+            kernel_weights = torch.softmax(logits, dim=2).reshape(weights.shape).numpy()
+        grad_feat, grad_loc, grad_w = self.golden_deformable_aggregation_grad(
+            feature_maps.shape[0],
+            sample_location.shape[1],
+            sample_location.shape[2],
+            spatial_shape.shape[0],
+            spatial_shape.shape[1],
+            feature_maps.shape[2],
+            weights.shape[5],
+            feature_maps.shape[1],
+            feature_maps,
+            spatial_shape,
+            scale_start_index,
+            sample_location,
+            kernel_weights,
+        )
+        grad_w = grad_w.reshape(weights.shape)
+        if use_softmax:
+            flat_shape = (weights.shape[0], weights.shape[1], -1, weights.shape[5])
+            grad_w = torch._softmax_backward_data(
+                torch.from_numpy(grad_w).reshape(flat_shape),
+                torch.from_numpy(kernel_weights).reshape(flat_shape),
+                2,
+                torch.float32,
+            ).reshape(weights.shape).numpy()
+        return grad_feat.reshape(feature_maps.shape), grad_loc.reshape(sample_location.shape), grad_w
+
+    @unittest.skipIf(
+        DEVICE_NAME != 'Ascend910B',
+        "OP `DeformableAggregationGrad` is only supported on 910B, skip this ut!",
+    )
+    def test_deformable_aggregation_backward_half_softmax(self):
+        np.random.seed(50051)
+        B, C, input_h, input_w, anchor, pts, num_groups = 2, 64, 16, 22, 13, 10, 8
+        feature_maps, spatial_shape, scale_start_index, sample_location, weights = gen_inputs(
+            B, C, input_h, input_w, anchor, pts, num_groups)
+        feature_maps = feature_maps.astype(np.float16).astype(np.float32)
+        for use_softmax in [False, True]:
+            grad_feat, grad_loc, grad_w = self.golden_grads(
+                feature_maps, spatial_shape, scale_start_index, sample_location, weights, use_softmax)
+
+            torch_feature_maps = torch.from_numpy(feature_maps).half().npu().requires_grad_()
+            torch_sample_location = torch.from_numpy(sample_location).npu().requires_grad_()
+            torch_weights = torch.from_numpy(weights).npu().requires_grad_()
+            out_npu = mx_driving.deformable_aggregation(
+                torch_feature_maps,
+                torch.from_numpy(spatial_shape).npu(),
+                torch.from_numpy(scale_start_index).npu(),
+                torch_sample_location,
+                torch_weights,
+                use_softmax,
+            )
+            out_npu.backward(torch.ones_like(out_npu))
+
+            self.assertEqual(torch_feature_maps.grad.dtype, torch.float16)
+            self.assertRtolEqual(grad_feat.astype(np.float16), torch_feature_maps.grad.cpu().numpy(), prec=0.001)
+            self.assertRtolEqual(grad_loc, torch_sample_location.grad.cpu().numpy(), prec=0.001)
+            self.assertRtolEqual(grad_w, torch_weights.grad.cpu().numpy(), prec=0.001)
+
+    @unittest.skipIf(
+        DEVICE_NAME != 'Ascend910B',
+        "OP `DeformableAggregationGrad` is only supported on 910B, skip this ut!",
+    )
+    def test_deformable_aggregation_backward_given_grads(self):
+        np.random.seed(50052)
+        B, C, input_h, input_w, anchor, pts, num_groups = 1, 64, 16, 22, 10, 21, 4
+        feature_maps, spatial_shape, scale_start_index, sample_location, weights = gen_inputs(
+            B, C, input_h, input_w, anchor, pts, num_groups)
+        feature_maps = feature_maps.astype(np.float16).astype(np.float32)
+        for dtype in [torch.float32, torch.float16]:
+            for use_softmax in [False, True]:
+                grad_feat, grad_loc, grad_w = self.golden_grads(
+                    feature_maps, spatial_shape, scale_start_index, sample_location, weights, use_softmax)
+                inputs = (
+                    torch.from_numpy(feature_maps).to(dtype).npu(),
+                    torch.from_numpy(spatial_shape).npu(),
+                    torch.from_numpy(scale_start_index).npu(),
+                    torch.from_numpy(sample_location).npu(),
+                    torch.from_numpy(weights).npu(),
+                    torch.ones((B, anchor, C), dtype=dtype).npu(),
+                )
+                # the kernel writes grad_sampling_location with a stride of 8 floats per sampling point
+                given_grads = (
+                    torch.zeros(feature_maps.shape, dtype=dtype).npu(),
+                    torch.zeros((B, anchor, pts, 1, 8), dtype=dtype).npu(),
+                    torch.zeros(weights.shape, dtype=dtype).npu(),
+                )
+                outputs = mx_driving._C.npu_deformable_aggregation_backward(*inputs, *given_grads, use_softmax)
+                for output, given in zip(outputs, given_grads):
+                    self.assertEqual(output.data_ptr(), given.data_ptr())
+                allocated = mx_driving._C.npu_deformable_aggregation_backward(
+                    *inputs, None, None, None, use_softmax)
+                self.assertEqual(allocated[0].dtype, dtype)
+
+                prec = 0.00048828125 if dtype == torch.float32 else 0.001
+                self.assertRtolEqual(grad_feat.astype(np.float32), given_grads[0].float().cpu().numpy(), prec=prec)
+                self.assertRtolEqual(grad_loc, given_grads[1][..., :2].float().cpu().numpy(), prec=prec)
+                self.assertRtolEqual(grad_w, given_grads[2].float().cpu().numpy(), prec=prec)
+                self.assertRtolEqual(grad_feat.astype(np.float32), allocated[0].float().cpu().numpy(), prec=prec)
+                self.assertRtolEqual(grad_loc, allocated[1].cpu().numpy(), prec=prec)
+                self.assertRtolEqual(grad_w, allocated[2].cpu().numpy(), prec=prec)
+
 
 if __name__ == "__main__":
     run_tests()
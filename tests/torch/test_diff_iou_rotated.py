@@ -151,6 +151,26 @@ def diff_iou_rotated_2d_gloden(box1: Tensor, box2: Tensor) -> Tensor:
     return iou
 
 
+def diff_iou_rotated_2d_mode_gloden(box1: Tensor, box2: Tensor, mode: str) -> Tensor:
+    corners1 = box2corners(box1)
+    corners2 = box2corners(box2)
+    intersection, _ = oriented_box_intersection_2d(corners1, corners2)
+    union = box1[:, :, 2] * box1[:, :, 3] + box2[:, :, 2] * box2[:, :, 3] - intersection
+    iou = intersection / union
+    if mode == "iou":
+        return iou
+    corners = torch.cat([corners1, corners2], dim=2)
+    x_min, y_min = corners.min(dim=2)[0].unbind(-1)
+    x_max, y_max = corners.max(dim=2)[0].unbind(-1)
+    enclose_w = x_max - x_min
+    enclose_h = y_max - y_min
+    if mode == "giou":
+        enclose = enclose_w * enclose_h
+        return iou - (enclose - union) / enclose
+    center_dist = (box1[:, :, 0] - box2[:, :, 0]) ** 2 + (box1[:, :, 1] - box2[:, :, 1]) ** 2
+    return iou - center_dist / (enclose_w ** 2 + enclose_h ** 2)
+
+
 class TestDiffIouRoatated(TestCase):
 
     def gen_boxes_rotated(self, B, N,
@@ -207,6 +227,45 @@ class TestDiffIouRoatated(TestCase):
     def max_box_test_case(self):
         self.test_with_config(32, 32, -200, 200, 1000, 1000, 1000, 1000)
 
+    def test_diff_rotated_iou_2d_grad(self):
+        # overlapping boxes, so that most pairs have a non-empty intersection polygon
+        box1 = self.gen_boxes_rotated(4, 64, -1, 1, 2, 4, 2, 4)
+        box2 = self.gen_boxes_rotated(4, 64, -1, 1, 2, 4, 2, 4)
+        grad_out = torch.rand(4, 64)
+        for mode in ["iou", "giou", "diou"]:
+            box1_cpu = box1.clone().requires_grad_()
+            box2_cpu = box2.clone().requires_grad_()
+            expected = diff_iou_rotated_2d_mode_gloden(box1_cpu, box2_cpu, mode)
+            expected.backward(grad_out)
+
+            box1_npu = box1.npu().requires_grad_()
+            box2_npu = box2.npu().requires_grad_()
+            res = mx_driving.diff_iou_rotated_2d(box1_npu, box2_npu, mode)
+            res.backward(grad_out.npu())
+            self.assertRtolEqual(res.detach().cpu(), expected.detach(), 1e-3)
+            self.assertRtolEqual(box1_npu.grad.cpu(), box1_cpu.grad, 1e-3)
+            self.assertRtolEqual(box2_npu.grad.cpu(), box2_cpu.grad, 1e-3)
+
+            loss = mx_driving.diff_iou_rotated_loss(box1.npu(), box2.npu(), mode)
+            self.assertRtolEqual(loss.cpu(), 1 - expected.detach(), 1e-3)
+
+    def test_diff_rotated_iou_2d_cpu(self):
+        box1 = self.gen_boxes_rotated(4, 64, -1, 1, 2, 4, 2, 4)
+        box2 = self.gen_boxes_rotated(4, 64, -1, 1, 2, 4, 2, 4)
+        for mode in ["iou", "giou", "diou"]:
+            box1_cpu = box1.clone().requires_grad_()
+            box2_cpu = box2.clone().requires_grad_()
+            res = mx_driving.diff_iou_rotated_2d(box1_cpu, box2_cpu, mode)
+            res.sum().backward()
+
+            box1_npu = box1.npu().requires_grad_()
+            box2_npu = box2.npu().requires_grad_()
+            res_npu = mx_driving.diff_iou_rotated_2d(box1_npu, box2_npu, mode)
+            res_npu.sum().backward()
+            self.assertRtolEqual(res.detach(), res_npu.detach().cpu(), 1e-4)
+            self.assertRtolEqual(box1_cpu.grad, box1_npu.grad.cpu(), 1e-4)
+            self.assertRtolEqual(box2_cpu.grad, box2_npu.grad.cpu(), 1e-4)
+
     def test_diff_rotated_iou_2d(self):
         self.normal_test_case()
         self.min_border_shape_test_case()
@@ -94,5 +94,12 @@ class TestFurthestPointSampleWithDist(TestCase):
 
             self.assertRtolEqual(exoutput, output)
 
+    def test_FurthestPointSampleWithDist_cpu(self):
+        point_dist = self.create_input_data([5, 300])
+        exoutput = self.supported_op_exec(point_dist, 64)
+        output = mx_driving.furthest_point_sample_with_dist(torch.tensor(point_dist), 64)
+        self.assertRtolEqual(exoutput, output.numpy())
+
+
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
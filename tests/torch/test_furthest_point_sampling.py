@@ -166,6 +166,85 @@ class TestFurthestPointSample(TestCase):
         self.compare_res(test2)
         self.compare_res(test3)
 
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `FurthestPointSampling` is only for 910B, skip it.")
+    def test_furthest_point_sampling_ragged(self):
+        test2.createData()
+        point = test2.point.permute(0, 2, 1).contiguous()
+        cpuOutput = torch.from_numpy(self.cpu_op_exec(test2))
+        self.assertRtolEqual(cpuOutput, mx_driving.furthest_point_sampling(point, test2.numPoints))
+
+        counts = [4000, 17, 0, 2500, 1]
+        num_points = 64
+        points = torch.rand(sum(counts), 3) * 10
+        ptr = torch.tensor([0] + counts).cumsum(0)
+        golden = []
+        for b, count in enumerate(counts):
+            if count == 0:
+                # an empty sample has no index to return
+                golden.append(torch.full((num_points,), -1, dtype=torch.int32))
+                continue
+            golden_b = torch.zeros(num_points, dtype=torch.int32)
+            sampled = mx_driving.furthest_point_sampling(points[None, ptr[b]:ptr[b + 1]].npu(),
+                                                         min(num_points, count)).cpu()
+            golden_b[:sampled.size(1)] = sampled[0]
+            golden.append(golden_b + ptr[b].int())
+        golden = torch.stack(golden)
+        npuOutput = mx_driving.furthest_point_sampling_packed(points.npu(), ptr.npu(), num_points)
+        cpuOutput = mx_driving.furthest_point_sampling_packed(points, ptr, num_points)
+        self.assertRtolEqual(golden, npuOutput.cpu())
+        self.assertRtolEqual(golden, cpuOutput)
+
+    def test_furthest_point_sampling_packed_cpu(self):
+        counts = [300, 2, 0]
+        num_points = 8
+        points = torch.rand(sum(counts), 3) * 10
+        ptr = torch.tensor([0] + counts).cumsum(0)
+        batch = mx_driving.PackedPointBatch.from_ptr(points, ptr)
+        output = mx_driving.furthest_point_sampling_packed(batch, None, num_points)
+        for b, count in enumerate(counts):
+            if count == 0:
+                # the trailing empty sample starts at total and must not read past the buffer
+                self.assertTrue(bool((output[b] == -1).all()))
+                continue
+            golden = mx_driving.furthest_point_sampling(points[None, ptr[b]:ptr[b + 1]], num_points)[0]
+            self.assertRtolEqual(golden + ptr[b].int(), output[b])
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `FurthestPointSampling` is only for 910B, skip it.")
+    def test_furthest_point_sampling_approx_coverage(self):
+        def coverage_radius(points, idx):
+            sampled = torch.gather(points, 1, idx.long()[..., None].expand(-1, -1, 3))
+            return torch.cdist(points, sampled).amin(dim=2).amax(dim=1)
+
+        B, N, num_points = 2, 20000, 512
+        # LiDAR-like: dense near the origin on a ground plane plus a few objects
+        radius = torch.rand(B, N).pow(2) * 50
+        angle = torch.rand(B, N) * 2 * np.pi
+        points = torch.stack([radius * angle.cos(), radius * angle.sin(), torch.rand(B, N) * 2], dim=2)
+        points_npu = points.npu()
+
+        exact = mx_driving.furthest_point_sampling(points_npu, num_points)
+        exact_radius = coverage_radius(points_npu, exact).cpu()
+        tiny = mx_driving.furthest_point_sampling_approx(points_npu, num_points, 1e-4)
+        self.assertRtolEqual(exact.cpu(), tiny.cpu())
+        for voxel_size in (0.2, 0.5, 1.0):
+            approx = mx_driving.furthest_point_sampling_approx(points_npu, num_points, voxel_size)
+            approx_cpu = mx_driving.furthest_point_sampling_approx(points, num_points, voxel_size)
+            self.assertRtolEqual(approx.cpu(), approx_cpu)
+            approx_radius = coverage_radius(points_npu, approx).cpu()
+            self.assertTrue(bool((approx_radius <= 2 * exact_radius + voxel_size * 3 ** 0.5).all()))
+
+    def test_furthest_point_sampling_approx_empty_sample_cpu(self):
+        points = torch.rand(3, 500, 3) * 10
+        point_counts = torch.tensor([500, 0, 120])
+        output = mx_driving.furthest_point_sampling_approx(points, 16, 0.5, point_counts)
+        self.assertTrue(bool((output[1] == -1).all()))
+        for b in (0, 2):
+            expected = mx_driving.furthest_point_sampling_approx(points[b:b + 1, :point_counts[b]], 16, 0.5)
+            self.assertRtolEqual(expected[0], output[b])
+
+        empty = mx_driving.furthest_point_sampling_approx(points, 16, 0.5, torch.zeros(3, dtype=torch.int64))
+        self.assertTrue(bool((empty == -1).all()))
+
 
 if __name__ == "__main__":
     run_tests()
@@ -65,6 +65,23 @@ class TestGroupPoints(TestCase):
                 self.assertRtolEqual(cpu_out, npu_out.cpu())
                 self.assertRtolEqual(cpu_out, out.cpu())
 
+    def test_group_points_cpu(self):
+        torch.manual_seed(2)
+        B, C, N, npoints, nsample = 7, 35, 50, 16, 9
+        th_points, th_indices = cpu_gen_inputs(B, C, N, 0.0, 10.0, npoints, nsample, torch.float)
+        expected = self.cpu_group_points(th_points, th_indices)
+        points = th_points.clone().requires_grad_()
+        out = mx_driving.group_points(points, th_indices)
+        self.assertRtolEqual(expected, out.detach())
+
+        grad_out = torch.rand_like(out)
+        out.backward(grad_out)
+        expected_grad = torch.zeros(B, N, C)
+        expected_grad.index_put_(
+            (torch.arange(B).view(B, 1, 1).expand_as(th_indices), th_indices.long()),
+            grad_out.permute(0, 2, 3, 1), accumulate=True)
+        self.assertRtolEqual(expected_grad.transpose(1, 2).contiguous(), points.grad)
+
 
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
@@ -1,5 +1,8 @@
+import unittest
+
 import numpy as np
 import torch
+import torch_npu
 from data_cache import golden_data_cache
 from torch_npu.testing.testcase import TestCase, run_tests
 
@@ -7,6 +10,9 @@ import mx_driving
 import mx_driving.common
 
 
+DEVICE_NAME = torch_npu.npu.get_device_name(0)[:10]
+
+
 @golden_data_cache(__file__)
 def cpu_gen_inputs(attrs):
     batch, npoint, N, nsample, transposed = attrs
@@ -158,6 +164,38 @@ class TestKnn(TestCase):
         idx_verify = mx_driving.common.knn(k, torch.from_numpy(xyz).npu(), torch.from_numpy(center_xyz).npu(), False)
         self.assertRtolEqual(expected_idx, idx_verify.cpu().numpy())
 
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `Knn` is only supported on 910B, skip this ut!")
+    def test_knn_grid(self):
+        b, m, n, k = 2, 1024, 16384, 16
+        np.random.seed(0)
+        xyz = torch.from_numpy((np.random.rand(b, n, 3) * [80, 80, 3]).astype(np.float32))
+        center_xyz = torch.from_numpy((np.random.rand(b, m, 3) * [80, 80, 3]).astype(np.float32))
+        expected_idx = torch.cdist(center_xyz.double(), xyz.double()).topk(
+            k, dim=2, largest=False)[1].transpose(2, 1).int().numpy()
+        idx = mx_driving.knn(k, xyz.npu(), center_xyz.npu(), False, True)
+        self.assertRtolEqual(expected_idx, idx.cpu().numpy())
+
+        # fp16 coordinates are rounded before the search, so ties are compared by distance instead of index
+        xyz_half, center_half = xyz.half(), center_xyz.half()
+        dist = torch.cdist(center_half.double(), xyz_half.double())
+        expected_dist = dist.topk(k, dim=2, largest=False)[0]
+        idx = mx_driving.knn(k, xyz_half.npu(), center_half.npu(), False, True).cpu()
+        grid_dist = dist.gather(2, idx.transpose(2, 1).long()).sort(dim=2)[0]
+        self.assertRtolEqual(expected_dist.float().numpy(), grid_dist.float().numpy())
+
+    def test_knn_grid_cpu(self):
+        b, m, n, k = 2, 1024, 16384, 16
+        np.random.seed(0)
+        xyz = (np.random.rand(b, n, 3) * [80, 80, 3]).astype(np.float32)
+        center_xyz = (np.random.rand(b, m, 3) * [80, 80, 3]).astype(np.float32)
+        expected_idx = torch.cdist(torch.from_numpy(center_xyz).double(), torch.from_numpy(xyz).double()).topk(
+            k, dim=2, largest=False)[1].transpose(2, 1).int().numpy()
+
+        idx = mx_driving.knn(k, torch.from_numpy(xyz), torch.from_numpy(center_xyz), False, True)
+        self.assertRtolEqual(expected_idx, idx.numpy())
+        idx = mx_driving.knn(k, torch.from_numpy(xyz), torch.from_numpy(center_xyz), False)
+        self.assertRtolEqual(expected_idx, idx.numpy())
+
 
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
@@ -169,5 +169,68 @@ class TestMinAreaPolygons(TestCase):
             cpu_area.append(area)
         cpu_out = np.array(cpu_area)
         self.assertRtolEqual(cpu_out, npu_out)
+
+    def polygon_area(self, polygons):
+        polygons = polygons.reshape(-1, 4, 2)
+        ab = np.linalg.norm(polygons[:, 0] - polygons[:, 1], axis=1)
+        bc = np.linalg.norm(polygons[:, 1] - polygons[:, 2], axis=1)
+        return ab * bc
+
+    def golden_area(self, np_pointsets):
+        areas = []
+        for np_pointset in np_pointsets:
+            ps = np_pointset.reshape(-1, 2)
+            p = ps[ConvexHull(ps).vertices]
+            minbbox = minBoundingRect(p, p.shape[0], [0.0] * 5)
+            areas.append(float(minbbox[3] - minbbox[1]) * (minbbox[4] - minbbox[2]))
+        return np.array(areas)
+
+    def check_rects(self, pointsets, polygons, rboxes):
+        # the rbox is the same rectangle as the corner output and encloses every point
+        self.assertRtolEqual(self.polygon_area(polygons), rboxes[:, 2] * rboxes[:, 3], 1e-3)
+        cos, sin = np.cos(rboxes[:, 4:5]), np.sin(rboxes[:, 4:5])
+        pts = pointsets.reshape(pointsets.shape[0], -1, 2)
+        local_x = (pts[..., 0] - rboxes[:, 0:1]) * cos + (pts[..., 1] - rboxes[:, 1:2]) * sin
+        local_y = (pts[..., 1] - rboxes[:, 1:2]) * cos - (pts[..., 0] - rboxes[:, 0:1]) * sin
+        tol = 1e-3 * (1 + np.abs(pts).max())
+        self.assertTrue((np.abs(local_x) <= rboxes[:, 2:3] / 2 + tol).all())
+        self.assertTrue((np.abs(local_y) <= rboxes[:, 3:4] / 2 + tol).all())
+        self.assertTrue(((rboxes[:, 4] >= 0) & (rboxes[:, 4] < PI / 2 + 1e-6)).all())
+
+    def test_min_area_polygons_cpu(self):
+        for num_points in [9, 4, 16]:
+            np_pointsets = np.random.uniform(-100, 100, (3000, num_points * 2)).astype(np.float32)
+            pointsets = torch.from_numpy(np_pointsets)
+            polygons = mx_driving.min_area_polygons(pointsets).numpy()
+            rboxes = mx_driving.min_area_rects(pointsets).numpy()
+            self.assertRtolEqual(self.golden_area(np_pointsets), self.polygon_area(polygons), 1e-3)
+            self.check_rects(np_pointsets, polygons, rboxes)
+
+    def test_min_area_polygons_general_npu(self):
+        # more than 2048 sets or K != 9 take the general device path
+        for num_sets, num_points in [(5000, 9), (1000, 12)]:
+            np_pointsets = np.random.uniform(-100, 100, (num_sets, num_points * 2)).astype(np.float32)
+            pointsets = torch.from_numpy(np_pointsets).npu()
+            polygons = mx_driving.min_area_polygons(pointsets).cpu().numpy()
+            rboxes = mx_driving.min_area_rects(pointsets).cpu().numpy()
+            self.assertRtolEqual(self.golden_area(np_pointsets), self.polygon_area(polygons), 1e-3)
+            self.check_rects(np_pointsets, polygons, rboxes)
+
+    def test_min_area_rects_non_finite(self):
+        # inf/nan points are skipped on both paths, sets without a finite point give zeros
+        np_pointsets = np.random.uniform(-100, 100, (200, 24)).astype(np.float32)
+        np_pointsets[::3, 0] = np.inf
+        np_pointsets[1::5, 7] = np.nan
+        np_pointsets[2::7, 10:12] = -np.inf
+        np_pointsets[4] = np.nan
+        pointsets = torch.from_numpy(np_pointsets)
+        rboxes_cpu = mx_driving.min_area_rects(pointsets).numpy()
+        rboxes_npu = mx_driving.min_area_rects(pointsets.npu()).cpu().numpy()
+        self.assertTrue(np.isfinite(rboxes_cpu).all())
+        self.assertTrue(np.isfinite(rboxes_npu).all())
+        self.assertRtolEqual(np.zeros(5, dtype=np.float32), rboxes_npu[4])
+        self.assertRtolEqual(rboxes_cpu[:, 2] * rboxes_cpu[:, 3], rboxes_npu[:, 2] * rboxes_npu[:, 3], 1e-3)
+
+
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
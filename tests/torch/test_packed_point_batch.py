@@ -0,0 +1,97 @@
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+from mx_driving import PackedPointBatch
+
+
+class TestPackedPointBatch(TestCase):
+    def test_layout_roundtrip(self):
+        torch.manual_seed(0)
+        counts = torch.tensor([5, 0, 9, 3])
+        ptr = torch.cat([torch.zeros(1, dtype=torch.int64), counts.cumsum(0)])
+        points = torch.rand(int(ptr[-1]), 4)
+        batch_idx = torch.repeat_interleave(torch.arange(4), counts)
+        expected_padded = torch.full((4, 9, 4), -1.0)
+        for b in range(4):
+            expected_padded[b, :counts[b]] = points[ptr[b]:ptr[b + 1]]
+
+        for device in ["npu", "cpu"]:
+            batch = PackedPointBatch.from_ptr(points.to(device), ptr.to(device), max_num_points=9)
+            self.assertRtolEqual(expected_padded.numpy(), batch.to_padded(-1.0).cpu().numpy())
+            self.assertRtolEqual(batch_idx.numpy(), batch.batch_index().cpu().numpy())
+
+            repacked = PackedPointBatch.from_padded(expected_padded.to(device), counts.to(device), total=17)
+            self.assertRtolEqual(points.numpy(), repacked.points.cpu().numpy())
+            self.assertRtolEqual(ptr.numpy(), repacked.ptr.cpu().numpy())
+
+            from_index = PackedPointBatch.from_batch_index(points.to(device), batch_idx.to(device), 4)
+            self.assertRtolEqual(ptr.numpy(), from_index.ptr.cpu().numpy())
+            self.assertEqual(from_index.max_num_points, 9)
+
+    def test_padded_view(self):
+        padded = torch.rand(3, 8, 3).npu()
+        batch = PackedPointBatch.from_padded(padded)
+        self.assertEqual(batch.points.data_ptr(), padded.data_ptr())
+        self.assertEqual(batch.to_padded().data_ptr(), padded.data_ptr())
+        self.assertRtolEqual(torch.arange(4).mul(8).numpy(), batch.ptr.cpu().numpy())
+
+    def test_packed_point_ops(self):
+        torch.manual_seed(1)
+        ptr_x = torch.tensor([0, 300, 300 + 700])
+        ptr_y = torch.tensor([0, 20, 20 + 50])
+        x = torch.rand(1000, 3).npu()
+        y = torch.rand(70, 3).npu()
+        xb = PackedPointBatch.from_ptr(x, ptr_x, max_num_points=700)
+        yb = PackedPointBatch.from_ptr(y, ptr_y, max_num_points=50)
+
+        idx = mx_driving.knn(4, xb, yb)
+        for b in range(2):
+            expected = mx_driving.knn(4, x[None, ptr_x[b]:ptr_x[b + 1]], y[None, ptr_y[b]:ptr_y[b + 1]], False)
+            expected = expected[0].transpose(0, 1) + ptr_x[b]
+            self.assertRtolEqual(expected.cpu().numpy(), idx[ptr_y[b]:ptr_y[b + 1]].cpu().numpy())
+
+        x2, y2 = x[:, :2].contiguous(), y[:, :2].contiguous()
+        expected = mx_driving.radius(x2, y2, ptr_x.int().npu(), ptr_y.int().npu(), 0.2, 16)
+        out = mx_driving.radius(PackedPointBatch.from_ptr(x2, ptr_x), PackedPointBatch.from_ptr(y2, ptr_y), None, None,
+                                0.2, 16)
+        self.assertRtolEqual(expected.cpu().numpy(), out.cpu().numpy())
+
+        expected = mx_driving.furthest_point_sampling_packed(x, ptr_x.npu(), 16, max_num_points=700)
+        out = mx_driving.furthest_point_sampling_packed(xb, None, 16)
+        self.assertRtolEqual(expected.cpu().numpy(), out.cpu().numpy())
+
+    def test_knn_packed_short_sample(self):
+        torch.manual_seed(2)
+        k = 6
+        counts = torch.tensor([10, 3, 0, 7])
+        ptr_x = torch.cat([torch.zeros(1, dtype=torch.int64), counts.cumsum(0)])
+        ptr_y = torch.tensor([0, 4, 9, 11, 16])
+        x = torch.rand(int(ptr_x[-1]), 3) * 50
+        y = torch.rand(16, 3) * 50
+        expected = torch.full((16, k), -1, dtype=torch.int32)
+        for b in range(4):
+            n = int(counts[b])
+            if n == 0:
+                continue
+            dist = torch.cdist(y[ptr_y[b]:ptr_y[b + 1]].double(), x[ptr_x[b]:ptr_x[b + 1]].double())
+            nearest = dist.topk(min(k, n), dim=1, largest=False)[1] + ptr_x[b]
+            expected[ptr_y[b]:ptr_y[b + 1], :min(k, n)] = nearest.int()
+
+        for device in ["npu", "cpu"]:
+            for dtype in [torch.float32, torch.float16]:
+                if dtype == torch.float16 and device == "cpu":
+                    continue
+                xb = PackedPointBatch.from_ptr(x.to(device, dtype), ptr_x, max_num_points=10)
+                yb = PackedPointBatch.from_ptr(y.to(device, dtype), ptr_y, max_num_points=5)
+                for use_grid in [False, True]:
+                    idx = mx_driving.knn(k, xb, yb, use_grid=use_grid)
+                    self.assertRtolEqual(expected.numpy()[:, 0], idx[:, 0].cpu().numpy())
+                    self.assertRtolEqual((expected < 0).numpy(), (idx < 0).cpu().numpy())
+                    if dtype == torch.float32:
+                        self.assertRtolEqual(expected.numpy(), idx.cpu().numpy())
+
+
+if __name__ == "__main__":
+    run_tests()
@@ -0,0 +1,96 @@
+import unittest
+
+import numpy as np
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+
+
+DEVICE_NAME = torch_npu.npu.get_device_name(0)[:10]
+
+
+def gen_scene(batch_size, num_boxes, num_points, scene_size):
+    center = torch.rand(batch_size, num_boxes, 3) * torch.tensor([scene_size, scene_size, 2.0])
+    size = torch.rand(batch_size, num_boxes, 3) * 4 + 0.5
+    angle = (torch.rand(batch_size, num_boxes, 1) * 2 - 1) * np.pi
+    boxes = torch.cat([center, size, angle], dim=-1)
+    points = torch.rand(batch_size, num_points, 3) * torch.tensor([scene_size, scene_size, 2.0])
+    return boxes, points
+
+
+def points_in_boxes_mask_cpu(boxes, points):
+    # dense [B, N, M] mask, z of the boxes is the box center
+    shift = points[:, :, None, :] - boxes[:, None, :, :3]
+    cos = torch.cos(boxes[..., 6])[:, None, :]
+    sin = torch.sin(boxes[..., 6])[:, None, :]
+    local_x = shift[..., 0] * cos + shift[..., 1] * sin
+    local_y = -shift[..., 0] * sin + shift[..., 1] * cos
+    half = boxes[:, None, :, 3:6] / 2
+    return ((local_x.abs() <= half[..., 0]) & (local_y.abs() <= half[..., 1]) &
+            (shift[..., 2].abs() <= half[..., 2]))
+
+
+def first_hit_cpu(mask):
+    num_boxes = mask.shape[-1]
+    index = torch.arange(num_boxes).expand_as(mask)
+    first = torch.where(mask, index, torch.full_like(index, num_boxes)).amin(-1)
+    first[first == num_boxes] = -1
+    return first.int()
+
+
+def csr_cpu(mask):
+    flat = mask.reshape(-1, mask.shape[-1])
+    ptr = torch.zeros(flat.shape[0] + 1, dtype=torch.int64)
+    ptr[1:] = flat.sum(-1).cumsum(0)
+    return ptr, flat.nonzero()[:, 1]
+
+
+class TestPointsInBoxesGrid(TestCase):
+    def check(self, boxes, points, cell_size=0.0):
+        mask = points_in_boxes_mask_cpu(boxes, points)
+        expected_first = first_hit_cpu(mask)
+        expected_ptr, expected_idx = csr_cpu(mask)
+        for device in ["cpu", "npu"]:
+            first = mx_driving.points_in_boxes_first(boxes.to(device), points.to(device), cell_size)
+            self.assertEqual(first.cpu(), expected_first)
+            ptr, box_idx = mx_driving.points_in_boxes_csr(boxes.to(device), points.to(device), cell_size)
+            self.assertEqual(ptr.cpu(), expected_ptr)
+            self.assertEqual(box_idx.cpu(), expected_idx)
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `PointsInBoxesGrid` is only supported on 910B, skip this ut!")
+    def test_batched_many_boxes(self):
+        boxes, points = gen_scene(2, 500, 20000, 80)
+        self.check(boxes, points)
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `PointsInBoxesGrid` is only supported on 910B, skip this ut!")
+    def test_cell_size(self):
+        boxes, points = gen_scene(3, 100, 5000, 40)
+        self.check(boxes, points, 1.0)
+        self.check(boxes, points, 100.0)
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `PointsInBoxesGrid` is only supported on 910B, skip this ut!")
+    def test_overlapping_boxes(self):
+        boxes, points = gen_scene(1, 300, 5000, 5)
+        self.check(boxes, points)
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `PointsInBoxesGrid` is only supported on 910B, skip this ut!")
+    def test_empty(self):
+        boxes, points = gen_scene(2, 0, 100, 10)
+        self.check(boxes, points)
+        boxes, points = gen_scene(2, 10, 0, 10)
+        self.check(boxes, points)
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `PointsInBox` is only supported on 910B, skip this ut!")
+    def test_points_in_box_fallback(self):
+        boxes, points = gen_scene(2, 500, 2000, 40)
+        expected = first_hit_cpu(points_in_boxes_mask_cpu(boxes, points))
+        self.assertEqual(mx_driving.points_in_box(boxes.npu(), points.npu()).cpu(), expected)
+        self.assertEqual(mx_driving.points_in_box(boxes, points), expected)
+
+
+if __name__ == "__main__":
+    torch.manual_seed(0)
+    np.random.seed(0)
+    run_tests()
@@ -0,0 +1,109 @@
+import math
+
+import numpy as np
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+import mx_driving._C
+
+
+def gen_rotated_boxes(num, scene_size=10):
+    center = torch.rand(num, 2) * scene_size
+    size = torch.rand(num, 2) * 4 + 1
+    angle = (torch.rand(num, 1) * 2 - 1) * math.pi
+    return torch.cat([center, size, angle], dim=1)
+
+
+def rotated_to_quadri(boxes):
+    x, y, w, h, a = boxes.unbind(-1)
+    cos, sin = torch.cos(a), torch.sin(a)
+    local = torch.tensor([[-0.5, 0.5], [-0.5, -0.5], [0.5, -0.5], [0.5, 0.5]])
+    dx = local[:, 0] * w[:, None]
+    dy = local[:, 1] * h[:, None]
+    px = x[:, None] + dx * cos[:, None] - dy * sin[:, None]
+    py = y[:, None] + dx * sin[:, None] + dy * cos[:, None]
+    return torch.stack([px, py], dim=-1).reshape(-1, 8)
+
+
+def to_bev(boxes, format_flag):
+    x, y, w, h, a = boxes.unbind(-1)
+    z = torch.rand_like(x)
+    d = torch.rand_like(x) + 1
+    if format_flag == 0:
+        return torch.stack([x - w / 2, y - h / 2, x + w / 2, y + h / 2, a], dim=-1)
+    if format_flag == 1:
+        return boxes
+    if format_flag == 2:
+        return torch.stack([x - w / 2, y - h / 2, z, x + w / 2, y + h / 2, z + d, a], dim=-1)
+    return torch.stack([x, y, z, w, h, d, a], dim=-1)
+
+
+class TestPolygonOverlapCpu(TestCase):
+    def check(self, cpu_result, npu_result):
+        self.assertRtolEqual(cpu_result, npu_result.cpu(), 1e-3)
+
+    def test_box_iou_rotated(self):
+        boxes_a = gen_rotated_boxes(300)
+        boxes_b = gen_rotated_boxes(200)
+        for mode in ["iou", "iof"]:
+            for clockwise in [True, False]:
+                cpu = mx_driving.box_iou_rotated(boxes_a, boxes_b, mode, False, clockwise)
+                npu = mx_driving.box_iou_rotated(boxes_a.npu(), boxes_b.npu(), mode, False, clockwise)
+                self.check(cpu, npu)
+            cpu = mx_driving.box_iou_rotated(boxes_a, boxes_a.flip(0), mode, True)
+            npu = mx_driving.box_iou_rotated(boxes_a.npu(), boxes_a.flip(0).npu(), mode, True)
+            self.check(cpu, npu)
+
+    def test_box_iou_quadri(self):
+        boxes_a = rotated_to_quadri(gen_rotated_boxes(300))
+        boxes_b = rotated_to_quadri(gen_rotated_boxes(200))
+        for mode in ["iou", "iof"]:
+            for aligned, other in [(False, boxes_b), (True, boxes_a.flip(0))]:
+                cpu = mx_driving.box_iou_quadri(boxes_a, other, mode, aligned)
+                npu = mx_driving.box_iou_quadri(boxes_a.npu(), other.npu(), mode, aligned)
+                self.check(cpu, npu)
+
+    def test_boxes_overlap_bev(self):
+        boxes_a = gen_rotated_boxes(200)
+        boxes_b = gen_rotated_boxes(150)
+        for format_flag in range(4):
+            for unit_flag, scale in [(0, 1.0), (1, 180 / math.pi)]:
+                bev_a = to_bev(boxes_a, format_flag).clone()
+                bev_b = to_bev(boxes_b, format_flag).clone()
+                bev_a[:, -1] *= scale
+                bev_b[:, -1] *= scale
+                for clockwise in [True, False]:
+                    for mode_flag in range(3):
+                        cpu = mx_driving._C.npu_boxes_overlap_bev(
+                            bev_a, bev_b, format_flag, unit_flag, clockwise, mode_flag, False, 1e-5)
+                        npu = mx_driving._C.npu_boxes_overlap_bev(
+                            bev_a.npu(), bev_b.npu(), format_flag, unit_flag, clockwise, mode_flag, False, 1e-5)
+                        self.check(cpu, npu)
+
+    def test_rotated_iou_and_overlaps(self):
+        boxes_a = gen_rotated_boxes(60).view(2, 30, 5)
+        boxes_b = gen_rotated_boxes(40).view(2, 20, 5)
+        boxes_a[..., -1] = boxes_a[..., -1] * 180 / math.pi
+        boxes_b[..., -1] = boxes_b[..., -1] * 180 / math.pi
+        for mode in [0, 1]:
+            cpu = mx_driving.npu_rotated_iou(boxes_a, boxes_b, False, mode, True, 1e-5, 1e-5)
+            npu = mx_driving.npu_rotated_iou(boxes_a.npu(), boxes_b.npu(), False, mode, True, 1e-5, 1e-5)
+            self.check(cpu, npu)
+        cpu = mx_driving.npu_rotated_overlaps(boxes_a, boxes_b, False)
+        npu = mx_driving.npu_rotated_overlaps(boxes_a.npu(), boxes_b.npu(), False)
+        self.check(cpu, npu)
+
+    def test_shared_edges(self):
+        # identical, half-overlapping and edge-touching boxes share collinear edges
+        boxes_a = torch.tensor([[0, 0, 2, 2, 0.3], [0, 0, 2, 2, 0], [0, 0, 2, 2, 0]], dtype=torch.float32)
+        boxes_b = torch.tensor([[0, 0, 2, 2, 0.3], [1, 0, 2, 2, 0], [2, 0, 2, 2, 0]], dtype=torch.float32)
+        ious = mx_driving.box_iou_rotated(boxes_a, boxes_b, "iou", True)
+        self.assertRtolEqual(ious, torch.tensor([1.0, 1 / 3, 0.0]), 1e-5)
+
+
+if __name__ == "__main__":
+    torch.manual_seed(0)
+    np.random.seed(0)
+    run_tests()
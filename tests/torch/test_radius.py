@@ -118,6 +118,19 @@ class TestRadius(TestCase):
             out_cpu = radius_golden_python(x, y, ptr_x, ptr_y, r, max_num_neighbors).int()
             out_npu = mx_driving.radius(x.npu(), y.npu(), ptr_x.npu(), ptr_y.npu(), r, max_num_neighbors)
             self.assertRtolEqual(out_cpu, out_npu) 
-    
+
+    def test_radius_padded(self):
+        for data_range, batch_size, max_points_per_batch, r, max_num_neighbors in [
+            [100, 64, 512, 50, 300], [10, 2048, 64, 5, 16], [100, 2, 20000, 10, 64]]:
+            x, y, ptr_x, ptr_y = gen_inputs(data_range, batch_size, max_points_per_batch)
+            out_cpu = radius_golden_python(x, y, ptr_x, ptr_y, r, max_num_neighbors).int()
+            out_npu, num_neighbors = mx_driving.radius(
+                x.npu(), y.npu(), ptr_x.npu(), ptr_y.npu(), r, max_num_neighbors, True)
+            self.assertEqual(out_npu.shape[1], y.shape[0] * max_num_neighbors)
+            num = num_neighbors.item()
+            self.assertEqual(num, out_cpu.shape[1])
+            self.assertRtolEqual(out_cpu, out_npu[:, :num])
+            self.assertTrue(bool((out_npu[:, num:] == -1).all()))
+
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
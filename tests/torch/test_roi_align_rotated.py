@@ -402,6 +402,47 @@ class TestRoiAlignedRotated(TestCase):
             self.assertRtolEqual(grad_cpu, grad_1)
             self.assertRtolEqual(grad_cpu, grad_2)
 
+    def build_case(self, item):
+        features = self.generate_features(item[0])
+        rois = self.generate_rois(item[1], item[0], item[2])
+        grad_output = self.generate_grad(item[1], item[0], item[4], item[5])
+        args_dict = dict(spatial_scale=item[2],
+                         sampling_ratio=item[3],
+                         ph=item[4],
+                         pw=item[5],
+                         aligned=item[6],
+                         clockwise=item[7])
+        return features, rois, grad_output, args_dict
+
+    def test_roi_align_rotated_cpu(self):
+        shape_format = [
+            [[2, 16, 32, 32], [24, 6], 0.5, 2, 3, 3, True, False],
+            [[2, 19, 32, 32], [24, 6], 0.5, 0, 3, 3, False, True],
+        ]
+        for item in shape_format:
+            features, rois, grad_output, args_dict = self.build_case(item)
+            out_cpu, grad_cpu = self.cpu_to_exec(features, rois, grad_output, args_dict)
+            for dtype, prec in [(torch.float32, 1e-4), (torch.float16, 1e-2), (torch.bfloat16, 2e-2)]:
+                feats = features.to(dtype).requires_grad_()
+                output = mx_driving.roi_align_rotated(feats, rois, *args_dict.values())
+                output.backward(grad_output.to(dtype))
+                self.assertRtolEqual(out_cpu.numpy(), output.detach().float().numpy(), prec)
+                self.assertRtolEqual(grad_cpu.numpy(), feats.grad.float().numpy(), prec)
+
+    @unittest.skipIf(DEVICE_NAME not in ['Ascend910B'], "OP `RoiAlignedRotatedV2` is only supported on 910B, skip this ut!")
+    def test_roi_align_rotated_adaptive_half(self):
+        # adaptive sampling with enough rois takes the cost-balanced roi ordering path
+        item = [[2, 16, 48, 48], [40, 6], 0.5, 0, 5, 5, True, False]
+        features, rois, grad_output, args_dict = self.build_case(item)
+        out_cpu, grad_cpu = self.cpu_to_exec(features, rois, grad_output, args_dict)
+        for dtype, prec in [(torch.float32, 1e-4), (torch.float16, 1e-2), (torch.bfloat16, 2e-2)]:
+            feats = features.to(dtype).npu().requires_grad_()
+            output = mx_driving.roi_align_rotated(feats, rois.npu(), *args_dict.values())
+            output.backward(grad_output.to(dtype).npu())
+            self.assertEqual(output.dtype, dtype)
+            self.assertRtolEqual(out_cpu.numpy(), output.detach().float().cpu().numpy(), prec)
+            self.assertRtolEqual(grad_cpu.numpy(), feats.grad.float().cpu().numpy(), prec)
+
 
 if __name__ == '__main__':
     run_tests()
\ No newline at end of file
@@ -208,6 +208,27 @@ class TestRoIAwarePool3dGrad(TestCase):
         self.one_case(20, out_size, 512, 256, 128, 'max', np.float16)
         self.one_case(20, out_size, 512, 256, 128, 'avg', np.float16)
 
+    def csr_case(self, boxes_num, out_size, channels, npoints, max_pts_per_voxel, pool_method, dtype):
+        rois, pts, pts_feature = self.gen_input_data(boxes_num, out_size, channels, npoints, dtype)
+        pooled_features_cpu = self.roiaware_pool3d_cpu(rois, pts, pts_feature, out_size, max_pts_per_voxel, pool_method, dtype)
+        mode = {'max': 0, 'avg': 1}[pool_method]
+        grads = []
+        for device in ["npu", "cpu"]:
+            pts_feature_input = torch.tensor(pts_feature).to(device).requires_grad_()
+            pooled_features = mx_driving.roiaware_pool3d(torch.tensor(rois).to(device), torch.tensor(pts).to(device),
+                pts_feature_input, out_size, max_pts_per_voxel, mode, True)
+            self.assertRtolEqual(torch.tensor(pooled_features_cpu), pooled_features.detach().cpu())
+            pooled_features.backward(torch.ones_like(pooled_features))
+            grads.append(pts_feature_input.grad.cpu())
+        self.assertRtolEqual(grads[0], grads[1])
+
+    def test_roiaware_pool3d_csr(self):
+        out_size = (4, 4, 4)
+        self.csr_case(10, out_size, 256, 128, 128, 'max', np.float32)
+        self.csr_case(10, out_size, 256, 128, 128, 'avg', np.float32)
+        self.csr_case(20, out_size, 512, 256, 16, 'max', np.float16)
+        self.csr_case(20, out_size, 512, 256, 16, 'avg', np.float16)
+
 
 if __name__ == "__main__":
     torch.npu.conv.allow_hf32 = False
@@ -0,0 +1,100 @@
+import numpy as np
+import torch
+import torch_npu
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+
+
+def gen_inputs(batch_size, num_points, num_boxes, channels):
+    points = torch.rand(batch_size, num_points, 3) * torch.tensor([20.0, 20.0, 4.0])
+    point_features = torch.rand(batch_size, num_points, channels) * 2 - 1
+    center = torch.rand(batch_size, num_boxes, 3) * torch.tensor([20.0, 20.0, 1.0])
+    size = torch.rand(batch_size, num_boxes, 3) * 4 + 0.5
+    angle = torch.rand(batch_size, num_boxes, 1) * np.pi
+    return points, point_features, torch.cat([center, size, angle], dim=-1)
+
+
+def points_in_boxes_mask(points, boxes3d):
+    # [B, M, N], z of boxes3d is the bottom center, boundary points count as inside
+    shift = points[:, None, :, :] - boxes3d[:, :, None, :3]
+    cos = torch.cos(boxes3d[..., 6])[..., None]
+    sin = torch.sin(boxes3d[..., 6])[..., None]
+    local_x = shift[..., 0] * cos + shift[..., 1] * sin
+    local_y = -shift[..., 0] * sin + shift[..., 1] * cos
+    size = boxes3d[..., 3:6][:, :, None, :]
+    local_z = shift[..., 2] - size[..., 2] / 2
+    return ((local_x.abs() <= size[..., 0] / 2) & (local_y.abs() <= size[..., 1] / 2) &
+            (local_z.abs() <= size[..., 2] / 2))
+
+
+def roipoint_pool3d_first_cpu(num_sampled_points, points, point_features, mask):
+    batch_size, num_boxes, _ = mask.shape
+    pooled_features = torch.zeros(batch_size, num_boxes, num_sampled_points, 3 + point_features.shape[-1],
+                                  dtype=point_features.dtype)
+    pooled_empty_flag = torch.zeros(batch_size, num_boxes, dtype=torch.int32)
+    for b in range(batch_size):
+        for m in range(num_boxes):
+            idx = mask[b, m].nonzero().squeeze(1)
+            if idx.numel() == 0:
+                pooled_empty_flag[b, m] = 1
+                continue
+            idx = idx[torch.arange(num_sampled_points) % idx.numel()]
+            pooled_features[b, m] = torch.cat([points[b, idx].to(point_features.dtype), point_features[b, idx]], -1)
+    return pooled_features, pooled_empty_flag
+
+
+class TestRoipointPool3dCsr(TestCase):
+    def test_first(self):
+        points, point_features, boxes3d = gen_inputs(2, 3000, 40, 8)
+        mask = points_in_boxes_mask(points, boxes3d)
+        for dtype in [torch.float32, torch.float16]:
+            expected_features, expected_flag = roipoint_pool3d_first_cpu(16, points, point_features.to(dtype), mask)
+            for device in ["cpu", "npu"]:
+                pooled_features, pooled_empty_flag = mx_driving.roipoint_pool3d_csr(
+                    16, points.to(device), point_features.to(dtype).to(device), boxes3d.to(device))
+                self.assertEqual(pooled_features.dtype, dtype)
+                self.assertEqual(pooled_features.cpu(), expected_features)
+                self.assertEqual(pooled_empty_flag.cpu(), expected_flag)
+
+    def test_precomputed_csr(self):
+        points, point_features, boxes3d = gen_inputs(2, 2000, 20, 4)
+        center_boxes = boxes3d.clone()
+        center_boxes[..., 2] += center_boxes[..., 5] / 2
+        pts_ptr, box_idx = mx_driving.points_in_boxes_csr(center_boxes, points)
+        expected = mx_driving.roipoint_pool3d_csr(8, points, point_features, boxes3d)
+        result = mx_driving.roipoint_pool3d_csr(8, points, point_features, boxes3d, pts_ptr, box_idx)
+        self.assertEqual(result[0], expected[0])
+        self.assertEqual(result[1], expected[1])
+
+    def test_random(self):
+        points, point_features, boxes3d = gen_inputs(2, 3000, 40, 8)
+        point_features[..., 0] = torch.arange(3000, dtype=torch.float32)
+        mask = points_in_boxes_mask(points, boxes3d)
+        num_sampled_points = 16
+        results = [mx_driving.roipoint_pool3d_csr(num_sampled_points, points.to(device), point_features.to(device),
+                                                  boxes3d.to(device), sample_mode="random", seed=7)
+                   for device in ["cpu", "npu"]]
+        self.assertEqual(results[0][0], results[1][0].cpu())
+        self.assertEqual(results[0][1], results[1][1].cpu())
+        pooled_features = results[0][0]
+        for b in range(2):
+            for m in range(40):
+                members = set(mask[b, m].nonzero().squeeze(1).tolist())
+                sampled = pooled_features[b, m, :, 3].long().tolist()
+                if not members:
+                    continue
+                self.assertTrue(set(sampled) <= members)
+                if len(members) >= num_sampled_points:
+                    self.assertEqual(len(set(sampled)), num_sampled_points)
+                else:
+                    self.assertEqual(set(sampled), members)
+        other, _ = mx_driving.roipoint_pool3d_csr(num_sampled_points, points, point_features, boxes3d,
+                                                  sample_mode="random", seed=8)
+        self.assertNotEqual(other, pooled_features)
+
+
+if __name__ == "__main__":
+    torch.manual_seed(0)
+    np.random.seed(0)
+    run_tests()
@@ -62,6 +62,43 @@ class TestThreeinterpolate(TestCase):
             npu_output = self.npu_op_exec(npu_features, npu_indices, npu_weights)
             self.assertRtolEqual(cpu_output[0], npu_output[0])
             self.assertRtolEqual(cpu_output[1], npu_output[1])
+
+    def test_three_interpolate_cpu(self):
+        np.random.seed(3)
+        features = np.random.uniform(-1000, 1000, size=(6, 33, 57)).astype(np.float32)
+        indices = np.random.randint(0, 57, size=(6, 40, 3)).astype(np.int32)
+        weights = np.random.uniform(0, 1, size=(6, 40, 3)).astype(np.float32)
+        cpu_output = self.cpu_op_exec(features, indices, weights)
+        output = self.npu_op_exec(torch.from_numpy(features), torch.from_numpy(indices), torch.from_numpy(weights))
+        self.assertRtolEqual(cpu_output[0], output[0])
+        self.assertRtolEqual(cpu_output[1], output[1])
+
+    def test_three_interpolate_large_n_and_c(self):
+        np.random.seed(4)
+        features = np.random.uniform(-10, 10, size=(1, 10240, 64)).astype(np.float32)
+        indices = np.random.randint(0, 64, size=(1, 16400, 3)).astype(np.int32)
+        weights = np.random.uniform(0, 1, size=(1, 16400, 3)).astype(np.float32)
+        cpu_output = self.npu_op_exec(torch.from_numpy(features), torch.from_numpy(indices), torch.from_numpy(weights))
+        npu_output = self.npu_op_exec(torch.from_numpy(features).npu(), torch.from_numpy(indices).npu(),
+                                      torch.from_numpy(weights).npu())
+        self.assertRtolEqual(cpu_output[0], npu_output[0])
+        self.assertRtolEqual(cpu_output[1], npu_output[1])
+
+    def test_three_interpolate_with_dist(self):
+        np.random.seed(5)
+        features = np.random.uniform(-100, 100, size=(3, 24, 40)).astype(np.float32)
+        indices = np.random.randint(0, 40, size=(3, 70, 3)).astype(np.int32)
+        dist = np.random.uniform(0, 5, size=(3, 70, 3)).astype(np.float32)
+        dist_recip = 1.0 / (dist + 1e-8)
+        weights = (dist_recip / dist_recip.sum(axis=2, keepdims=True)).astype(np.float32)
+        cpu_output = self.cpu_op_exec(features, indices, weights)
+        for device in ["cpu", "npu"]:
+            feat = torch.from_numpy(features).to(device).requires_grad_()
+            out = mx_driving.three_interpolate_with_dist(feat, torch.from_numpy(indices).to(device),
+                                                         torch.from_numpy(dist).to(device))
+            out.backward(torch.ones_like(out))
+            self.assertRtolEqual(cpu_output[0], out.detach().cpu().numpy())
+            self.assertRtolEqual(cpu_output[1], feat.grad.cpu().numpy())
         
         
 if __name__ == "__main__":
@@ -1,5 +1,8 @@
+import unittest
+
 import numpy as np
 import torch
+import torch_npu
 from data_cache import golden_data_cache
 from torch_npu.testing.testcase import TestCase, run_tests
 
@@ -7,6 +10,9 @@ import mx_driving
 import mx_driving.common
 
 
+DEVICE_NAME = torch_npu.npu.get_device_name(0)[:10]
+
+
 @golden_data_cache(__file__)
 def cpu_gen_inputs(batch, N, npoint):
     source = np.ones((batch, N, 3)).astype(np.float32)
@@ -301,5 +307,48 @@ class TestThreeNN(TestCase):
         self.assertRtolEqual(expected_dist, dist_verify.cpu().numpy())
         self.assertRtolEqual(expected_idx, idx_verify.cpu().numpy())
 
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `Knn` is only supported on 910B, skip this ut!")
+    def test_three_nn_grid(self):
+        batch, N, npoint = 2, 20000, 512
+        torch.manual_seed(0)
+        source = torch.rand(batch, N, 3) * torch.tensor([100.0, 100.0, 4.0])
+        target = torch.rand(batch, npoint, 3) * torch.tensor([100.0, 100.0, 4.0])
+        expected_dist, expected_idx = torch.cdist(target.double(), source.double()).topk(3, dim=2, largest=False)
+        dist, idx = mx_driving.three_nn(target.npu(), source.npu(), True)
+        self.assertRtolEqual(expected_dist.float().numpy(), dist.cpu().numpy())
+        self.assertRtolEqual(expected_idx.int().numpy(), idx.cpu().numpy())
+
+    @unittest.skipIf(DEVICE_NAME != 'Ascend910B', "OP `Knn` is only supported on 910B, skip this ut!")
+    def test_three_nn_grid_half(self):
+        batch, N, npoint = 2, 20000, 512
+        torch.manual_seed(1)
+        source = (torch.rand(batch, N, 3) * torch.tensor([100.0, 100.0, 4.0])).half()
+        target = (torch.rand(batch, npoint, 3) * torch.tensor([100.0, 100.0, 4.0])).half()
+        all_dist = torch.cdist(target.double(), source.double())
+        expected_dist = all_dist.topk(3, dim=2, largest=False)[0]
+
+        for use_grid in (False, True):
+            dist, idx = mx_driving.three_nn(target.npu(), source.npu(), use_grid)
+            self.assertEqual(dist.dtype, torch.float16)
+            self.assertRtolEqual(expected_dist.half().numpy(), dist.cpu().numpy())
+            # fp16 coordinates collide more often, so the indices are checked through their distances
+            idx_dist = all_dist.gather(2, idx.cpu().long())
+            self.assertRtolEqual(expected_dist.float().numpy(), idx_dist.float().numpy())
+
+    def test_three_nn_grid_cpu(self):
+        batch, N, npoint = 2, 20000, 512
+        torch.manual_seed(0)
+        source = torch.rand(batch, N, 3) * torch.tensor([100.0, 100.0, 4.0])
+        target = torch.rand(batch, npoint, 3) * torch.tensor([100.0, 100.0, 4.0])
+        expected_dist, expected_idx = torch.cdist(target.double(), source.double()).topk(3, dim=2, largest=False)
+
+        dist, idx = mx_driving.three_nn(target, source, True)
+        self.assertRtolEqual(expected_dist.float().numpy(), dist.numpy())
+        self.assertRtolEqual(expected_idx.int().numpy(), idx.numpy())
+        dist, idx = mx_driving.three_nn(target, source)
+        self.assertRtolEqual(expected_dist.float().numpy(), dist.numpy())
+        self.assertRtolEqual(expected_idx.int().numpy(), idx.numpy())
+
+
 if __name__ == "__main__":
     run_tests()
\ No newline at end of file
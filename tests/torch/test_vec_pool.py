@@ -0,0 +1,127 @@
+import numpy as np
+import torch
+import torch_npu
+from data_cache import golden_data_cache
+from torch_npu.testing.testcase import TestCase, run_tests
+
+import mx_driving
+
+
+@golden_data_cache(__file__)
+def cpu_gen_inputs(batch_cnt, new_batch_cnt, c_in):
+    n, m = sum(batch_cnt), sum(new_batch_cnt)
+    support_xyz = (np.random.rand(n, 3) * 4).astype(np.float32)
+    support_features = np.random.rand(n, c_in).astype(np.float32)
+    new_xyz = (np.random.rand(m, 3) * 4).astype(np.float32)
+    return support_xyz, support_features, new_xyz
+
+
+class TestVecPool(TestCase):
+    # pylint: disable=too-many-arguments,huawei-too-many-arguments
+    @golden_data_cache(__file__)
+    def golden_vec_pool(self, support_xyz, batch_cnt, support_features, new_xyz, new_batch_cnt, num_grid, max_dist,
+                        num_c_out, neighbor_type):
+        num_grid = np.array(num_grid)
+        total_grids = int(num_grid.prod())
+        c_each = num_c_out // total_grids
+        grid_size = np.float32(max_dist * 2) / num_grid.astype(np.float32)
+        max_dist = np.float32(max_dist)
+        m, c_in = new_xyz.shape[0], support_features.shape[1]
+        features = np.zeros((m, total_grids, c_each), dtype=np.float32)
+        local_xyz = np.zeros((m, total_grids, 3), dtype=np.float32)
+        cnt = np.zeros((m, total_grids), dtype=np.int32)
+        grouped = []
+        xyz_start = np.concatenate([[0], np.cumsum(batch_cnt)])
+        new_start = np.concatenate([[0], np.cumsum(new_batch_cnt)])
+        for b in range(len(batch_cnt)):
+            points = support_xyz[xyz_start[b]:xyz_start[b + 1]]
+            for pt in range(new_start[b], new_start[b + 1]):
+                local = points - new_xyz[pt]
+                if neighbor_type == 1:
+                    hit = (local * local).sum(axis=1) <= max_dist * max_dist
+                else:
+                    hit = np.abs(local).max(axis=1) <= max_dist
+                idx = np.nonzero(hit)[0]
+                grid_xyz = ((local[idx] + max_dist) / grid_size).astype(np.int64)
+                grid = grid_xyz[:, 0] * num_grid[1] * num_grid[2] + grid_xyz[:, 1] * num_grid[2] + grid_xyz[:, 2]
+                grid = np.clip(grid, 0, total_grids - 1)
+                folded = support_features[xyz_start[b] + idx].reshape(idx.size, c_in // c_each, c_each).sum(axis=1)
+                np.add.at(features[pt], grid, folded)
+                np.add.at(local_xyz[pt], grid, local[idx])
+                np.add.at(cnt[pt], grid, 1)
+                grouped += [(xyz_start[b] + i, pt, g) for i, g in zip(idx, grid)]
+        normalizer = np.maximum(cnt, 1)[:, :, None].astype(np.float32)
+        features = (features / normalizer).reshape(m, -1)
+        local_xyz = (local_xyz / normalizer).reshape(m, -1)
+        return features, local_xyz, cnt, np.array(sorted(grouped), dtype=np.int32).reshape(-1, 3)
+
+    def test_vec_pool(self):
+        np.random.seed(0)
+        for batch_cnt, new_batch_cnt, c_in, num_grid, max_dist, num_c_out, neighbor_type in [
+            ([1024, 2048], [64, 128], 16, (3, 3, 3), 0.4, 27 * 16, 0),
+            ([4096], [256], 32, (2, 2, 2), 0.3, 8 * 8, 1),
+            ([500, 30, 900], [40, 10, 20], 3, (4, 4, 1), 0.8, 16 * 3, 0),
+        ]:
+            support_xyz, support_features, new_xyz = cpu_gen_inputs(batch_cnt, new_batch_cnt, c_in)
+            expected = self.golden_vec_pool(support_xyz, batch_cnt, support_features, new_xyz, new_batch_cnt,
+                                            num_grid, max_dist, num_c_out, neighbor_type)
+            for device in ["npu", "cpu"]:
+                features, local_xyz, num_mean_points, cnt = mx_driving.vec_pool(
+                    torch.from_numpy(support_xyz).to(device), torch.tensor(batch_cnt, dtype=torch.int32).to(device),
+                    torch.from_numpy(support_features).to(device), torch.from_numpy(new_xyz).to(device),
+                    torch.tensor(new_batch_cnt, dtype=torch.int32).to(device), *num_grid, max_dist, num_c_out, True,
+                    100, -1, neighbor_type, 0)
+                self.assertRtolEqual(expected[0], features.cpu().numpy())
+                self.assertRtolEqual(expected[1], local_xyz.cpu().numpy())
+                self.assertRtolEqual(expected[2], cnt.cpu().numpy())
+                self.assertEqual(num_mean_points.item(), expected[3].shape[0] // new_xyz.shape[0])
+
+    def test_vec_pool_grad(self):
+        np.random.seed(1)
+        batch_cnt, new_batch_cnt, c_in, num_grid, max_dist = [2048], [128], 32, (3, 3, 3), 0.4
+        num_c_out = 27 * 16
+        support_xyz, support_features, new_xyz = cpu_gen_inputs(batch_cnt, new_batch_cnt, c_in)
+        _, _, cnt, grouped = self.golden_vec_pool(support_xyz, batch_cnt, support_features, new_xyz, new_batch_cnt,
+                                                  num_grid, max_dist, num_c_out, 0)
+        grad_out = np.random.rand(new_xyz.shape[0], num_c_out).astype(np.float32)
+        expected_grad = np.zeros_like(support_features)
+        for idx, pt, grid in grouped:
+            c_each = num_c_out // 27
+            row = grad_out[pt, grid * c_each:(grid + 1) * c_each] / max(cnt[pt, grid], 1)
+            expected_grad[idx] += np.tile(row, c_in // c_each)
+
+        for device in ["npu", "cpu"]:
+            feats = torch.from_numpy(support_features).to(device).requires_grad_()
+            features, _, _, _ = mx_driving.vec_pool(
+                torch.from_numpy(support_xyz).to(device), torch.tensor(batch_cnt, dtype=torch.int32).to(device), feats,
+                torch.from_numpy(new_xyz).to(device), torch.tensor(new_batch_cnt, dtype=torch.int32).to(device),
+                *num_grid, max_dist, num_c_out, False, 100, -1, 0, 0)
+            features.backward(torch.from_numpy(grad_out).to(device))
+            self.assertRtolEqual(expected_grad, feats.grad.cpu().numpy())
+
+    def test_vec_pool_nsample(self):
+        np.random.seed(2)
+        batch_cnt, new_batch_cnt, c_in, num_grid, max_dist = [1024, 1024], [64, 64], 8, (2, 2, 2), 0.5
+        support_xyz, support_features, new_xyz = cpu_gen_inputs(batch_cnt, new_batch_cnt, c_in)
+        for nsample, pooling_type in [(16, 0), (-1, 1), (4, 1)]:
+            limit = nsample if nsample > 0 else 8
+            if pooling_type == 1:
+                limit = min(limit, 8)
+            results = []
+            for device in ["npu", "cpu"]:
+                features, _, _, cnt = mx_driving.vec_pool(
+                    torch.from_numpy(support_xyz).to(device), torch.tensor(batch_cnt, dtype=torch.int32).to(device),
+                    torch.from_numpy(support_features).to(device), torch.from_numpy(new_xyz).to(device),
+                    torch.tensor(new_batch_cnt, dtype=torch.int32).to(device), *num_grid, max_dist, 8 * c_in, True,
+                    100, nsample, 1, pooling_type)
+                self.assertTrue(bool((cnt.sum(dim=1) <= limit).all()))
+                if pooling_type == 1:
+                    self.assertTrue(bool((cnt <= 1).all()))
+                results.append((features.cpu().numpy(), cnt.cpu().numpy()))
+            # NPU and CPU visit neighbours in the same spatial-hash order, so truncated sampling matches
+            self.assertRtolEqual(results[0][0], results[1][0])
+            self.assertRtolEqual(results[0][1], results[1][1])
+
+
+if __name__ == "__main__":
+    run_tests()
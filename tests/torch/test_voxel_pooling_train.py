@@ -98,6 +98,32 @@ class TestVoxelPoolingTrain(TestCase):
         features_npu.requires_grad = True
         return geom_xyz_cpu, features_cpu, geom_xyz_npu, features_npu
 
+    def test_voxel_pooling_train_cpu(self):
+        voxel_num = [128, 128, 1]
+        for batch_size, num_points, num_channels in [[1, 20, 32], [2, 750, 80], [2, 1000, 13]]:
+            geom_xyz = torch.rand([batch_size, num_points, 3]) * 90
+            geom_xyz[:, :, 2] /= 100
+            geom_xyz = geom_xyz.int()
+            features = torch.rand([batch_size, num_points, num_channels]) - 0.5
+            _, result_ref = voxel_pooling_train_cpu_forward(batch_size, num_points, num_channels, voxel_num[0],
+                                                            voxel_num[1], voxel_num[2], geom_xyz, features)
+            features_cpu = features.clone().requires_grad_()
+            result_cpu = npu_voxel_pooling_train(geom_xyz, features_cpu, voxel_num)
+            grad_out = torch.rand_like(result_cpu)
+            result_cpu.backward(grad_out)
+
+            # every point inside the grid receives the gradient of its voxel
+            x, y = geom_xyz[..., 0].long(), geom_xyz[..., 1].long()
+            inside = (x >= 0) & (x < voxel_num[0]) & (y >= 0) & (y < voxel_num[1]) & \
+                     (geom_xyz[..., 2] >= 0) & (geom_xyz[..., 2] < voxel_num[2])
+            batch_idx = torch.arange(batch_size).view(-1, 1).expand(batch_size, num_points)
+            x, y = x.clamp(0, voxel_num[0] - 1), y.clamp(0, voxel_num[1] - 1)
+            grad_ref = grad_out.permute(0, 2, 3, 1)[batch_idx, y, x]
+            grad_ref = grad_ref * inside.unsqueeze(-1)
+
+            self.assertRtolEqual(result_ref.numpy(), result_cpu.detach().numpy())
+            self.assertRtolEqual(grad_ref.numpy(), features_cpu.grad.numpy())
+
     @unittest.skipIf(DEVICE_NAME != "Ascend910B", "OP `VoxelPoolingTrain` is only supported on 910B, skip this ut!")
     def test_voxel_pooling_train(self):
         torch.npu.set_device("npu:0")